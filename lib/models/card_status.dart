@@ -34,6 +34,16 @@ enum CardStatus {
   /// Thiết bị không hỗ trợ NFC hoặc NFC đang bị tắt.
   nfcUnavailable,
 
+  /// Hàng đợi truy cập reader đã đầy (desktop); thử lại sau.
+  busy,
+
+  /// Thao tác đã bị hủy bằng `cancel` hoặc hết thời gian `timeout` (desktop).
+  cancelled,
+
+  /// Chữ ký thẻ trả về không khớp khóa công khai của certificate, khi bật
+  /// `setSignatureSelfCheck` (desktop). Thường do sai `keyIndex`.
+  signatureMismatch,
+
   /// Một lỗi không xác định đã xảy ra.
   unknownError,
 }
@@ -60,6 +70,12 @@ extension CardStatusExtension on CardStatus {
         return 'Không tìm thấy thẻ';
       case CardStatus.nfcUnavailable:
         return 'NFC không có sẵn';
+      case CardStatus.busy:
+        return 'Thẻ đang bận, hàng đợi đã đầy';
+      case CardStatus.cancelled:
+        return 'Thao tác đã bị hủy hoặc hết thời gian';
+      case CardStatus.signatureMismatch:
+        return 'Chữ ký từ thẻ không khớp certificate';
       case CardStatus.unknownError:
         return 'Lỗi không xác định';
       }
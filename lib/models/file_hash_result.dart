@@ -0,0 +1,26 @@
+import 'dart:typed_data';
+
+/// Kết quả của một file trong [Nfcsigner.hashFiles].
+class FileHashResult {
+  final String path;
+
+  /// SHA-256 của file (32 byte).
+  final Uint8List? digest;
+  final String? error;
+
+  const FileHashResult({
+    required this.path,
+    this.digest,
+    this.error,
+  });
+
+  bool get isSuccess => error == null && digest != null;
+
+  static FileHashResult fromMap(Map<dynamic, dynamic> map) {
+    return FileHashResult(
+      path: map['path'] as String,
+      digest: map['digest'] as Uint8List?,
+      error: map['error'] as String?,
+    );
+  }
+}
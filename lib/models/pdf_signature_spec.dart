@@ -0,0 +1,33 @@
+import 'pdf_signature_config.dart';
+
+/// Một chữ ký trong [Nfcsigner.signPdfMulti].
+class PdfSignatureSpec {
+  /// Tên field chữ ký. Nếu tài liệu đã có field chữ ký trống cùng tên thì ký
+  /// vào field đó (vị trí lấy theo field); để null để tự đặt tên
+  /// `BMC-Signature`, `BMC-Signature-2`...
+  final String? fieldName;
+
+  /// Chỉ số khóa ký; mọi chữ ký trong cùng một lần gọi phải dùng cùng khóa.
+  final int keyIndex;
+  final String reason;
+  final String location;
+  final PdfSignatureConfig? signatureConfig;
+
+  const PdfSignatureSpec({
+    this.fieldName,
+    this.keyIndex = 0,
+    this.reason = "Ký duyệt!",
+    this.location = "Hanoi",
+    this.signatureConfig,
+  });
+
+  Map<String, dynamic> toMap() {
+    return {
+      'fieldName': fieldName,
+      'keyIndex': keyIndex,
+      'reason': reason,
+      'location': location,
+      'signatureConfig': signatureConfig?.toMap(),
+    };
+  }
+}
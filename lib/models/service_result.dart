@@ -68,6 +68,13 @@ class ServiceResult<T> {
         return CardStatus.invalidParameters;
       case 'OPERATION_NOT_SUPPORTED':
         return CardStatus.operationNotSupported;
+      case 'CARD_BUSY':
+        return CardStatus.busy;
+      case 'CANCELLED':
+      case 'DEADLINE_EXCEEDED':
+        return CardStatus.cancelled;
+      case 'SIGNATURE_MISMATCH':
+        return CardStatus.signatureMismatch;
       default:
         return CardStatus.unknownError;
     }
@@ -0,0 +1,100 @@
+import 'dart:typed_data';
+
+/// Kết quả kiểm tra một chữ ký CMS ([Nfcsigner.verifyPdf], [Nfcsigner.verifyCms]).
+///
+/// Chỉ đối chiếu với certificate nhúng trong chữ ký; không kiểm tra chuỗi tin
+/// cậy hay tình trạng thu hồi.
+class SignatureVerification {
+  /// Tên field chữ ký (chỉ với PDF đọc được cấu trúc).
+  final String? fieldName;
+  final String? subFilter;
+
+  /// Digest nội dung khớp và chữ ký đúng.
+  final bool valid;
+  final bool digestValid;
+  final bool signatureValid;
+
+  /// ByteRange phủ tới cuối file: không có gì được thêm sau chữ ký này.
+  final bool coversWholeDocument;
+  final String digestAlgorithm;
+
+  /// Subject của certificate người ký (RFC 2253).
+  final String signer;
+  final Uint8List certificate;
+
+  /// Thuộc tính signingTime trong CMS, null nếu không có.
+  final DateTime? signingTime;
+
+  /// /M của từ điển chữ ký PDF, dạng "D:YYYYMMDDHHmmSS...".
+  final String? pdfSigningTime;
+  final String? error;
+  final int hashUs;
+  final int verifyUs;
+
+  const SignatureVerification({
+    this.fieldName,
+    this.subFilter,
+    required this.valid,
+    required this.digestValid,
+    required this.signatureValid,
+    required this.coversWholeDocument,
+    required this.digestAlgorithm,
+    required this.signer,
+    required this.certificate,
+    this.signingTime,
+    this.pdfSigningTime,
+    this.error,
+    this.hashUs = 0,
+    this.verifyUs = 0,
+  });
+
+  static SignatureVerification fromMap(Map<dynamic, dynamic> map) {
+    final int signingTime = map['signingTime'] as int? ?? 0;
+    return SignatureVerification(
+      fieldName: map['fieldName'] as String?,
+      subFilter: map['subFilter'] as String?,
+      valid: map['valid'] as bool? ?? false,
+      digestValid: map['digestValid'] as bool? ?? false,
+      signatureValid: map['signatureValid'] as bool? ?? false,
+      coversWholeDocument: map['coversWholeDocument'] as bool? ?? false,
+      digestAlgorithm: map['digestAlgorithm'] as String? ?? '',
+      signer: map['signer'] as String? ?? '',
+      certificate: map['certificate'] as Uint8List? ?? Uint8List(0),
+      signingTime: signingTime == 0
+          ? null
+          : DateTime.fromMillisecondsSinceEpoch(signingTime * 1000, isUtc: true),
+      pdfSigningTime: map['pdfSigningTime'] as String?,
+      error: map['error'] as String?,
+      hashUs: map['hashUs'] as int? ?? 0,
+      verifyUs: map['verifyUs'] as int? ?? 0,
+    );
+  }
+}
+
+/// Kết quả của một tài liệu trong [Nfcsigner.verifyPdfBatch].
+class PdfVerification {
+  final List<SignatureVerification> signatures;
+
+  /// Tài liệu không đọc được.
+  final String? error;
+  final int parseUs;
+
+  const PdfVerification({
+    required this.signatures,
+    this.error,
+    this.parseUs = 0,
+  });
+
+  /// Có ít nhất một chữ ký và mọi chữ ký đều hợp lệ.
+  bool get isValid => error == null && signatures.isNotEmpty && signatures.every((s) => s.valid);
+
+  static PdfVerification fromMap(Map<dynamic, dynamic> map) {
+    return PdfVerification(
+      signatures: (map['signatures'] as List<dynamic>? ?? const [])
+          .map((item) => SignatureVerification.fromMap(item as Map<dynamic, dynamic>))
+          .toList(),
+      error: map['error'] as String?,
+      parseUs: map['parseUs'] as int? ?? 0,
+    );
+  }
+}
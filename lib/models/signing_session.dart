@@ -0,0 +1,12 @@
+/// Handle của một phiên ký mở bằng [Nfcsigner.openSigningSession].
+///
+/// Native giữ cấu hình đã đọc, kết nối thẻ đã xác thực PIN, certificate và
+/// appearance của phiên cho tới khi gọi [Nfcsigner.closeSigningSession].
+class SigningSession {
+  final int handle;
+
+  const SigningSession(this.handle);
+
+  @override
+  String toString() => 'SigningSession($handle)';
+}
@@ -0,0 +1,23 @@
+/// Kết quả của một tài liệu trong [Nfcsigner.signXmlBatch].
+class XmlBatchResult {
+  /// Vị trí của tài liệu trong danh sách đầu vào.
+  final int index;
+  final String? signedXml;
+  final String? error;
+
+  const XmlBatchResult({
+    required this.index,
+    this.signedXml,
+    this.error,
+  });
+
+  bool get isSuccess => error == null && signedXml != null;
+
+  static XmlBatchResult fromMap(Map<dynamic, dynamic> map) {
+    return XmlBatchResult(
+      index: map['index'] as int,
+      signedXml: map['signedXml'] as String?,
+      error: map['error'] as String?,
+    );
+  }
+}
@@ -6,13 +6,24 @@ import 'package:flutter/services.dart';
 import 'models/card_status.dart';
 import 'models/service_result.dart'; // Import ServiceResult
 import 'models/pdf_signature_config.dart';
+import 'models/pdf_signature_spec.dart';
+import 'models/file_hash_result.dart';
+import 'models/signature_verification.dart';
+import 'models/signing_session.dart';
+import 'models/xml_batch_result.dart';
 import 'models/xml_signature_config.dart';
+import 'src/nfcsigner_ffi.dart';
 import 'src/xml_signer.dart';
 
 // Xuất các model để người dùng plugin có thể truy cập dễ dàng
 export 'models/service_result.dart';
 export 'models/card_status.dart';
 export 'models/pdf_signature_config.dart';
+export 'models/pdf_signature_spec.dart';
+export 'models/file_hash_result.dart';
+export 'models/signature_verification.dart';
+export 'models/signing_session.dart';
+export 'models/xml_batch_result.dart';
 export 'models/xml_signature_config.dart';
 export 'src/crypto_utils.dart';
 export 'src/xml_signer.dart';
@@ -30,6 +41,58 @@ enum KeyRole {
 class Nfcsigner {
   static const MethodChannel _channel = MethodChannel('nfcsigner');
 
+  /// Kết quả từng tài liệu của [signXmlBatchStreaming]. Một stream dùng chung
+  /// cho mọi lô; mỗi sự kiện mang `streamId` của lô phát ra nó.
+  static final Stream<dynamic> _xmlBatchEvents =
+      const EventChannel('nfcsigner/xml_batch').receiveBroadcastStream();
+  static int _nextXmlBatchStreamId = 0;
+
+  /// Gọi [method] có dữ liệu lớn dưới khóa [payloadKey]. Trên Windows/Linux
+  /// đi qua dart:ffi ([NfcsignerFfi]) để bỏ qua StandardMethodCodec; nếu
+  /// không dùng được thì quay về MethodChannel.
+  static Future<dynamic> _invokeBulk(String method, Map<String, dynamic> arguments, String payloadKey) async {
+    final ffi = NfcsignerFfi.instance;
+    final payload = arguments[payloadKey];
+    if (ffi != null && payload is Uint8List) {
+      final rest = Map<String, Object?>.of(arguments)..remove(payloadKey);
+      final future = ffi.invokeMethod(method, rest, payloadKey: payloadKey, payload: payload);
+      if (future != null) return future;
+    }
+    return _channel.invokeMethod(method, arguments);
+  }
+
+  /// Tham số hủy chung cho các thao tác dài: [requestId] để [cancel], [timeout]
+  /// thành deadline phía native (hết hạn trả về [CardStatus.cancelled]).
+  static Map<String, dynamic> _cancellationArguments(String? requestId, Duration? timeout) => {
+        if (requestId != null) 'requestId': requestId,
+        if (timeout != null) 'deadlineMs': timeout.inMilliseconds,
+      };
+
+  /// Hủy thao tác đang chạy được gọi với [requestId] (Windows/Linux).
+  ///
+  /// Thao tác dừng ở điểm kiểm tra kế tiếp (trong hàng đợi reader, giữa các
+  /// APDU, giữa các bước PDF), giải phóng reader và trả về
+  /// [CardStatus.cancelled]. Trả về false nếu không còn thao tác nào với
+  /// [requestId], kể cả thao tác còn chờ trong hàng đợi native. Native trả lời
+  /// cancel ngay trên platform thread; thao tác cần hủy chạy trên worker.
+  static Future<ServiceResult<bool>> cancel(String requestId) async {
+    try {
+      final ffi = NfcsignerFfi.instance;
+      if (ffi != null) return ServiceResult.success(ffi.cancel(requestId));
+      final bool? cancelled = await _channel.invokeMethod<bool>('cancel', {
+        'requestId': requestId,
+      });
+      return ServiceResult.success(cancelled ?? false);
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
   /// Thực hiện chuỗi lệnh ký số hoàn chỉnh trên thẻ thông minh.
   ///
   /// Bao gồm các bước: Chọn Applet, Xác thực PIN, và Ký dữ liệu.
@@ -228,6 +291,8 @@ class Nfcsigner {
     String location = "Hanoi",
     PdfSignatureConfig? signatureConfig,
     required Uint8List pdfHashBytes,
+    String? requestId,
+    Duration? timeout,
   }) async {
     try {
       final Map<String, dynamic> arguments = {
@@ -239,9 +304,10 @@ class Nfcsigner {
         'location': location,
         'signatureConfig': signatureConfig?.toMap(),
         'pdfHashBytes': pdfHashBytes,
+        ..._cancellationArguments(requestId, timeout),
       };
 
-      final dynamic result = await _channel.invokeMethod('signPdf', arguments);
+      final dynamic result = await _invokeBulk('signPdf', arguments, 'pdfBytes');
 
       // Xử lý kết quả từ Windows (trả về Map) và Android/iOS (trả về Uint8List)
       if (result is Uint8List) {
@@ -268,6 +334,554 @@ class Nfcsigner {
       );
     }
   }
+
+  /// Ký nhiều chữ ký lên cùng một file PDF trong một lần gọi native (desktop).
+  ///
+  /// [signatures] được áp dụng theo thứ tự, mỗi chữ ký là một incremental
+  /// revision. Tài liệu chỉ được đọc một lần và PIN chỉ được xác thực một lần
+  /// cho cả lô. Trả về nội dung file PDF sau chữ ký cuối cùng.
+  static Future<ServiceResult<Uint8List>> signPdfMulti({
+    required Uint8List pdfBytes,
+    required String appletID,
+    required String pin,
+    required List<PdfSignatureSpec> signatures,
+    String? requestId,
+    Duration? timeout,
+  }) async {
+    try {
+      final Map<String, dynamic> arguments = {
+        'pdfBytes': pdfBytes,
+        'appletID': appletID,
+        'pin': pin,
+        'signatures': signatures.map((s) => s.toMap()).toList(),
+        ..._cancellationArguments(requestId, timeout),
+      };
+
+      final Uint8List? result = await _invokeBulk('signPdfMulti', arguments, 'pdfBytes');
+
+      return ServiceResult.success(result);
+
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Mở một phiên ký PDF trên thẻ (Windows/Linux).
+  ///
+  /// Cấu hình, kết nối thẻ, certificate và appearance được chuẩn bị một lần;
+  /// các lần [signPdfWithSession] sau đó chỉ gửi handle và tài liệu. PIN
+  /// được xác thực ngay khi mở phiên. Gọi [closeSigningSession] khi xong;
+  /// phiên không được dùng trong 10 phút sẽ tự đóng.
+  ///
+  /// Thẻ bị reset hoặc mất trạng thái đã xác thực giữa hai lần ký thì phiên
+  /// chỉ gửi lại PIN nếu thẻ vẫn trả về đúng certificate lúc mở phiên.
+  static Future<ServiceResult<SigningSession>> openSigningSession({
+    required String appletID,
+    required String pin,
+    int keyIndex = 0,
+    String reason = "Ký duyệt!",
+    String location = "Hanoi",
+    PdfSignatureConfig? signatureConfig,
+  }) async {
+    try {
+      final int? handle = await _channel.invokeMethod<int>('openSigningSession', {
+        'appletID': appletID,
+        'pin': pin,
+        'keyIndex': keyIndex,
+        'reason': reason,
+        'location': location,
+        'signatureConfig': signatureConfig?.toMap(),
+      });
+      return ServiceResult.success(SigningSession(handle!));
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Ký [pdfBytes] bằng [session] đã mở. [signDate] thay cho ngày ký trong
+  /// cấu hình của phiên nếu được truyền.
+  static Future<ServiceResult<Uint8List>> signPdfWithSession({
+    required SigningSession session,
+    required Uint8List pdfBytes,
+    String? signDate,
+    String? requestId,
+    Duration? timeout,
+  }) async {
+    try {
+      final Uint8List? result = await _invokeBulk('signPdfWithSession', {
+        'session': session.handle,
+        'pdfBytes': pdfBytes,
+        'signDate': signDate,
+        ..._cancellationArguments(requestId, timeout),
+      }, 'pdfBytes');
+      return ServiceResult.success(result);
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Đóng [session]: ngắt kết nối thẻ (thẻ được reset nên trạng thái đã xác
+  /// thực PIN không còn). Trả về false nếu phiên đã đóng trước đó.
+  static Future<ServiceResult<bool>> closeSigningSession(SigningSession session) async {
+    try {
+      final bool? closed = await _channel.invokeMethod<bool>('closeSigningSession', {
+        'session': session.handle,
+      });
+      return ServiceResult.success(closed ?? false);
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Bật/tắt tự kiểm tra chữ ký từ thẻ (Windows/Linux, mặc định tắt).
+  ///
+  /// Khi bật, chữ ký RSA thẻ trả về được đối chiếu với khóa công khai của
+  /// certificate trước khi dựng PDF/CMS/XML, nên sai `keyIndex` hay phản hồi
+  /// bị cắt được báo lỗi ngay thay vì sinh ra tài liệu có chữ ký hỏng. Áp dụng
+  /// cho mọi lần ký sau đó; [generateSignature] đọc thêm certificate để kiểm tra.
+  /// Chữ ký sai được báo bằng [CardStatus.signatureMismatch].
+  static Future<ServiceResult<bool>> setSignatureSelfCheck({
+    required bool enabled,
+  }) async {
+    try {
+      final bool? result = await _channel.invokeMethod<bool>('setSignatureSelfCheck', {
+        'enabled': enabled,
+      });
+      return ServiceResult.success(result ?? enabled);
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Chính sách tự kết nối lại thẻ (Windows/Linux).
+  ///
+  /// Khi thẻ bị reset, rút ra cắm lại hoặc reader lỗi truyền tạm thời giữa
+  /// một thao tác, plugin kết nối lại, chọn lại applet, gửi lại VERIFY PIN đã
+  /// thành công rồi thử lại APDU tối đa [maxAttempts] lần (0 = tắt). Với
+  /// [allowPinReplay] = false, PIN không bao giờ được gửi lại và thao tác cần
+  /// PIN báo lỗi khi thẻ bị reset. Tham số bỏ trống giữ nguyên giá trị hiện tại.
+  static Future<ServiceResult<bool>> setCardRecoveryPolicy({
+    int? maxAttempts,
+    bool? allowPinReplay,
+  }) async {
+    try {
+      final bool? result = await _channel.invokeMethod<bool>('setCardRecoveryPolicy', {
+        if (maxAttempts != null) 'maxAttempts': maxAttempts,
+        if (allowPinReplay != null) 'allowPinReplay': allowPinReplay,
+      });
+      return ServiceResult.success(result ?? true);
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Bật/tắt theo dõi bộ nhớ từng pha của [signPdf], [signPdfMulti] và
+  /// [signPdfWithSession] trên desktop (mặc định tắt, hoặc bật sẵn bằng biến môi
+  /// trường `NFCSIGNER_MEMORY_TRACKING=1`). Kết quả đọc qua [getSigningMetrics].
+  ///
+  /// Trả về `enabled` và `allocationHooks`: số lần/byte cấp phát chỉ có khi
+  /// plugin được build với `-DNFCSIGNER_ALLOCATION_HOOKS=ON`, nếu không chỉ đo
+  /// RSS ở ranh giới các pha.
+  static Future<ServiceResult<Map<String, dynamic>>> setMemoryTracking({
+    required bool enabled,
+  }) async {
+    try {
+      final Map<dynamic, dynamic>? result = await _channel.invokeMethod('setMemoryTracking', {
+        'enabled': enabled,
+      });
+      return ServiceResult.success(result?.cast<String, dynamic>());
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Khởi tạo trước để lần [signPdf] đầu tiên nhanh như các lần sau (Windows/Linux).
+  ///
+  /// Chạy nền trên worker riêng của plugin và trả về ngay: kết nối PC/SC,
+  /// OpenSSL, danh mục font và bộ giải mã ảnh. Truyền [appletID] để đọc sẵn
+  /// certificate và [signatureConfig] để render sẵn appearance của người ký.
+  /// Plugin chỉ tự chạy một lần lúc đăng ký khi có biến môi trường
+  /// `NFCSIGNER_WARM_UP=1`.
+  ///
+  /// Trả về `started` (false nếu lần trước chưa xong) và `last`, báo cáo của
+  /// lần đã xong gần nhất (không có nếu chưa lần nào xong): thời gian từng
+  /// bước (micro giây) `pcscUs`, `cryptoUs`, `fontsUs`, `imageUs`,
+  /// `certificateUs`, `appearanceUs`, `totalUs`, cùng `cardConnected`,
+  /// `certificateCached`, `appearanceCached` và `errors` (bước lỗi không chặn
+  /// các bước khác).
+  static Future<ServiceResult<Map<String, dynamic>>> warmUp({
+    String? appletID,
+    PdfSignatureConfig? signatureConfig,
+  }) async {
+    try {
+      final Map<dynamic, dynamic>? report = await _channel.invokeMethod('warmUp', {
+        if (appletID != null) 'appletID': appletID,
+        if (signatureConfig != null) 'signatureConfig': signatureConfig.toMap(),
+      });
+      return ServiceResult.success(report?.cast<String, dynamic>());
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Thời gian từng pha (micro giây) của lần [signPdf] gần nhất trên desktop.
+  ///
+  /// Gồm `cardPreambleUs`, `verifyPinUs`, `pdfParseUs`, `pdfPrepareUs`,
+  /// `joinWaitUs`, `parallelUs`, `signUs`, `totalUs`, `overlapSavedUs`,
+  /// `incremental`, cùng `count` và `totalOverlapSavedUs` cộng dồn.
+  ///
+  /// Mục `arena` cho biết cấp phát tạm của đường ký PDF, lấy từ arena riêng
+  /// của từng request thay vì heap: `requests`, `lastAllocations`,
+  /// `maxAllocations`, `lastPeakBytes`, `maxPeakBytes`, và `blocksAllocated`,
+  /// `blocksReused`, `pooledBytes` của pool khối dùng lại giữa các request.
+  ///
+  /// Mục `memory` (xem [setMemoryTracking]) chia bộ nhớ theo pha: `parse`
+  /// (đọc tài liệu, gồm object graph của PoDoFo), `prepare`, `copy` (bản chép
+  /// làm buffer ghi của PoDoFo), `sign` và `output` (trả kết quả). `lastPhases` là request gần nhất (`lastOperation`,
+  /// `lastPeakRssBytes`), `maxPhases` là mức cao nhất của mỗi pha; mỗi pha gồm
+  /// `allocations`, `allocatedBytes`, `freedBytes`, `peakLiveBytes`,
+  /// `rssBeforeBytes` và `rssAfterBytes`. Kèm `currentRssBytes`, `peakRssBytes`
+  /// của tiến trình.
+  static Future<ServiceResult<Map<String, dynamic>>> getSigningMetrics() async {
+    try {
+      final Map<dynamic, dynamic>? metrics = await _channel.invokeMethod('getSigningMetrics');
+
+      return ServiceResult.success(metrics?.cast<String, dynamic>());
+
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Số liệu hàng đợi truy cập reader trên desktop, theo lớp ưu tiên
+  /// (`interactive`, `bulk`, `background`).
+  ///
+  /// Mỗi lớp gồm `capacity`, `depth`, `maxDepth`, `granted`, `rejected`,
+  /// `lastWaitUs`, `maxWaitUs` và `totalWaitUs`. Request bị từ chối khi hàng
+  /// đợi đầy trả về [CardStatus.busy].
+  ///
+  /// Mục `transactions` cho biết tranh chấp thẻ với tiến trình khác: mỗi thao
+  /// tác chạy trong một transaction PC/SC trên kết nối dùng chung, gồm `count`,
+  /// `contended` (phải chờ tiến trình khác), `resets` (kết nối lại sau khi thẻ
+  /// bị reset), `lastWaitUs`, `maxWaitUs`, `totalWaitUs` và `lastHoldUs`,
+  /// `maxHoldUs`, `totalHoldUs` (thời gian giữ thẻ độc quyền).
+  ///
+  /// Mục `recovery` đếm lần phục hồi sau khi thẻ bị reset hoặc reader lỗi tạm
+  /// thời (xem [setCardRecoveryPolicy]): `errors`, `recovered`, `failed` và
+  /// `lastRecoveryUs`, `maxRecoveryUs`, `totalRecoveryUs`.
+  static Future<ServiceResult<Map<String, dynamic>>> getCardQueueMetrics() async {
+    try {
+      final Map<dynamic, dynamic>? metrics = await _channel.invokeMethod('getCardQueueMetrics');
+
+      return ServiceResult.success(metrics?.cast<String, dynamic>());
+
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Ký một lô tài liệu XML (hóa đơn điện tử) bằng một lần xác thực PIN.
+  ///
+  /// Chỉ hỗ trợ Windows/Linux. Các tài liệu được chuẩn hóa song song, chữ ký
+  /// được tạo liên tiếp trên thẻ. Kết quả theo thứ tự [xmlContents]; tài liệu
+  /// lỗi có [XmlBatchResult.error] mà không làm hỏng cả lô. Lô lớn nên dùng
+  /// [signXmlBatchStreaming].
+  static Future<ServiceResult<List<XmlBatchResult>>> signXmlBatch({
+    required List<String> xmlContents,
+    required String appletID,
+    required String pin,
+    int keyIndex = 0,
+    XmlSignatureConfig? signatureConfig,
+    String? requestId,
+    Duration? timeout,
+  }) async {
+    try {
+      final Map<String, dynamic> arguments = {
+        'xmlContents': xmlContents,
+        'appletID': appletID,
+        'pin': pin,
+        'keyIndex': keyIndex,
+        'signatureConfig': (signatureConfig ?? const XmlSignatureConfig()).toMap(),
+        ..._cancellationArguments(requestId, timeout),
+      };
+
+      final List<dynamic>? result = await _channel.invokeMethod('signXmlBatch', arguments);
+
+      return ServiceResult.success(
+        (result ?? const [])
+            .map((item) => XmlBatchResult.fromMap(item as Map<dynamic, dynamic>))
+            .toList(),
+      );
+
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Như [signXmlBatch] nhưng giao từng tài liệu cho [onResult] ngay khi ký
+  /// xong thay vì trả cả lô một lần, nên lô lớn không phải giữ mọi XML đã ký
+  /// trong bộ nhớ (native lẫn Dart). [onResult] được gọi theo thứ tự
+  /// [xmlContents] và xong hết trước khi Future hoàn tất.
+  ///
+  /// Thành công trả về số tài liệu lỗi; lỗi của cả lô (PIN sai, thẻ lỗi trước
+  /// khi ký...) trả về như [signXmlBatch].
+  static Future<ServiceResult<int>> signXmlBatchStreaming({
+    required List<String> xmlContents,
+    required String appletID,
+    required String pin,
+    required void Function(XmlBatchResult result) onResult,
+    int keyIndex = 0,
+    XmlSignatureConfig? signatureConfig,
+    String? requestId,
+    Duration? timeout,
+  }) async {
+    final int streamId = ++_nextXmlBatchStreamId;
+    // Đăng ký trước khi gọi method để không lỡ sự kiện đầu tiên.
+    final StreamSubscription<dynamic> subscription = _xmlBatchEvents.listen((event) {
+      final Map<dynamic, dynamic> map = event as Map<dynamic, dynamic>;
+      if (map['streamId'] == streamId) onResult(XmlBatchResult.fromMap(map));
+    });
+    try {
+      final Map<dynamic, dynamic>? summary = await _channel.invokeMethod('signXmlBatch', {
+        'xmlContents': xmlContents,
+        'appletID': appletID,
+        'pin': pin,
+        'keyIndex': keyIndex,
+        'signatureConfig': (signatureConfig ?? const XmlSignatureConfig()).toMap(),
+        'streamId': streamId,
+        ..._cancellationArguments(requestId, timeout),
+      });
+
+      return ServiceResult.success(summary?['failed'] as int? ?? 0);
+
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    } finally {
+      await subscription.cancel();
+    }
+  }
+
+  /// Ký một file bất kỳ, trả về chữ ký CMS/CAdES tách rời (nội dung file .p7s).
+  ///
+  /// Chỉ hỗ trợ Windows/Linux. File được băm ở native theo từng khối nên có
+  /// thể lớn nhiều GB; dữ liệu file không đi qua platform channel.
+  static Future<ServiceResult<Uint8List>> signFile({
+    required String filePath,
+    required String appletID,
+    required String pin,
+    int keyIndex = 0,
+    String? requestId,
+    Duration? timeout,
+  }) async {
+    try {
+      final Uint8List? signature = await _channel.invokeMethod<Uint8List>('signFile', {
+        'filePath': filePath,
+        'appletID': appletID,
+        'pin': pin,
+        'keyIndex': keyIndex,
+        ..._cancellationArguments(requestId, timeout),
+      });
+      return ServiceResult.success(signature!);
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// SHA-256 của nhiều file; thư mục được thay bằng các file bên trong
+  /// (đệ quy nếu [recursive]). Không cần thẻ, chỉ hỗ trợ Windows/Linux.
+  static Future<ServiceResult<List<FileHashResult>>> hashFiles({
+    required List<String> paths,
+    bool recursive = true,
+  }) async {
+    try {
+      final List<dynamic>? result = await _channel.invokeMethod('hashFiles', {
+        'paths': paths,
+        'recursive': recursive,
+      });
+      return ServiceResult.success(
+        (result ?? const [])
+            .map((item) => FileHashResult.fromMap(item as Map<dynamic, dynamic>))
+            .toList(),
+      );
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Kiểm tra mọi chữ ký của một PDF (không cần thẻ, chỉ Windows/Linux).
+  ///
+  /// ByteRange được băm ngay trên dữ liệu native và các chữ ký được kiểm tra
+  /// song song. Kết quả theo thứ tự field.
+  static Future<ServiceResult<List<SignatureVerification>>> verifyPdf({
+    required Uint8List pdfBytes,
+  }) async {
+    try {
+      final List<dynamic>? result = await _invokeBulk('verifyPdf', {
+        'pdfBytes': pdfBytes,
+      }, 'pdfBytes');
+      return ServiceResult.success(
+        (result ?? const [])
+            .map((item) => SignatureVerification.fromMap(item as Map<dynamic, dynamic>))
+            .toList(),
+      );
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Như [verifyPdf] cho nhiều tài liệu; chữ ký của cả lô dùng chung một nhóm luồng.
+  static Future<ServiceResult<List<PdfVerification>>> verifyPdfBatch({
+    required List<Uint8List> pdfList,
+  }) async {
+    try {
+      final List<dynamic>? result = await _channel.invokeMethod('verifyPdf', {
+        'pdfList': pdfList,
+      });
+      return ServiceResult.success(
+        (result ?? const [])
+            .map((item) => PdfVerification.fromMap(item as Map<dynamic, dynamic>))
+            .toList(),
+      );
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Kiểm tra chữ ký CMS/CAdES [cms] (ví dụ từ [signFile]).
+  ///
+  /// Nội dung được ký lấy từ [content] hoặc file [filePath] (đọc theo từng
+  /// khối ở native); không có cả hai thì dùng nội dung nhúng trong chữ ký.
+  static Future<ServiceResult<SignatureVerification>> verifyCms({
+    required Uint8List cms,
+    Uint8List? content,
+    String? filePath,
+  }) async {
+    try {
+      final Map<dynamic, dynamic>? result = await _invokeBulk('verifyCms', {
+        'cms': cms,
+        'content': content,
+        'filePath': filePath,
+      }, 'content');
+      return ServiceResult.success(SignatureVerification.fromMap(result!));
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
+  /// Kiểm tra chữ ký RSA thô [signature] bằng khóa công khai của [certificate].
+  ///
+  /// Để [digestAlgorithm] null khi [data] là đúng dữ liệu đã gửi cho thẻ (như
+  /// [generateSignature]); ngược lại [data] được băm bằng thuật toán đó
+  /// ("sha256"...).
+  static Future<ServiceResult<bool>> verifySignature({
+    required Uint8List certificate,
+    required Uint8List data,
+    required Uint8List signature,
+    String? digestAlgorithm,
+  }) async {
+    try {
+      final bool? valid = await _channel.invokeMethod<bool>('verifySignature', {
+        'certificate': certificate,
+        'data': data,
+        'signature': signature,
+        'digestAlgorithm': digestAlgorithm,
+      });
+      return ServiceResult.success(valid ?? false);
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
+    } catch (e) {
+      return ServiceResult.failure(
+        status: CardStatus.unknownError,
+        message: e.toString(),
+      );
+    }
+  }
+
   /// Ký số một tài liệu XML theo chuẩn XML-DSig (hoàn toàn trên Dart)
   ///
   /// [xmlContent] là nội dung XML cần ký
@@ -284,6 +898,17 @@ class Nfcsigner {
     XmlSignatureConfig? signatureConfig,
   }) async {
     try {
+      // Windows/Linux: chuẩn hóa, băm và dựng XML-DSig ở native trong một lượt đọc.
+      if (Platform.isWindows || Platform.isLinux) {
+        final String? signedXml = await _channel.invokeMethod<String>('signXml', {
+          'xmlContent': xmlContent,
+          'appletID': appletID,
+          'pin': pin,
+          'keyIndex': keyIndex,
+          'signatureConfig': (signatureConfig ?? const XmlSignatureConfig()).toMap(),
+        });
+        return ServiceResult.success(signedXml!);
+      }
 
       // Tạo DigestInfo cho XML
       final digestInfo = XmlSigner.createDigestInfoForXml(
@@ -356,6 +981,8 @@ class Nfcsigner {
 
       return ServiceResult.success(signedXml);
 
+    } on PlatformException catch (e) {
+      return ServiceResult.fromPlatformException(e);
     } catch (e) {
       return ServiceResult.failure(
         status: CardStatus.unknownError,
@@ -0,0 +1,211 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:ffi';
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// NfcsignerFfiBuffer trong nfcsigner_ffi.h: bộ đệm do native sở hữu.
+final class _NativeBuffer extends Struct {
+  external Pointer<Uint8> data;
+
+  @Int64()
+  external int length;
+}
+
+typedef _ResultCallbackNative = Void Function(Int64 requestId, Int32 status, Pointer<_NativeBuffer> result);
+
+typedef _InvokeNative = Int32 Function(
+    Int64 requestId,
+    Pointer<Uint8> method,
+    Pointer<Uint8> arguments,
+    Int64 argumentsLength,
+    Pointer<Uint8> payloadKey,
+    Pointer<_NativeBuffer> payload,
+    Pointer<NativeFunction<_ResultCallbackNative>> callback);
+typedef _InvokeDart = int Function(int requestId, Pointer<Uint8> method, Pointer<Uint8> arguments, int argumentsLength,
+    Pointer<Uint8> payloadKey, Pointer<_NativeBuffer> payload, Pointer<NativeFunction<_ResultCallbackNative>> callback);
+
+/// Đường dart:ffi tới plugin native trên Windows/Linux (nfcsigner_ffi.h).
+///
+/// Cùng các method như MethodChannel, nhưng tham số dữ liệu lớn được chép
+/// một lần vào bộ đệm native mà plugin dùng thẳng, và kết quả dạng bytes được
+/// trả về nguyên khối (Dart nhận luôn bộ đệm native, không chép lại), bỏ qua
+/// StandardMethodCodec và bước chuyển sang platform thread. [instance] là null nếu không nạp được thư
+/// viện; khi đó dùng MethodChannel.
+class NfcsignerFfi {
+  // Phải khớp NFCSIGNER_FFI_VERSION và các mã kết quả trong nfcsigner_ffi.h.
+  static const int _abiVersion = 3;
+  static const int _resultBytes = 0;
+  static const int _resultValue = 1;
+  static const int _resultError = 2;
+  static const int _resultNotImplemented = 3;
+
+  static const StandardMessageCodec _codec = StandardMessageCodec();
+
+  static final NfcsignerFfi? instance = _load();
+
+  final Pointer<Uint8> Function(int size) _allocate;
+  final void Function(Pointer<Void> data) _free;
+  final Pointer<_NativeBuffer> Function(int size) _createBuffer;
+  final void Function(Pointer<Void> buffer) _releaseBuffer;
+  final Pointer<NativeFinalizerFunction> _releaseFinalizer;
+  final _InvokeDart _invoke;
+  final int Function(Pointer<Uint8> requestId) _cancel;
+  late final NativeCallable<_ResultCallbackNative> _callback;
+  final Map<int, Completer<Object?>> _pending = {};
+  int _nextRequestId = 1;
+
+  NfcsignerFfi._(DynamicLibrary library)
+      : _allocate = library.lookupFunction<Pointer<Uint8> Function(Int64), Pointer<Uint8> Function(int)>(
+            'NfcsignerFfiAllocate'),
+        _free = library.lookupFunction<Void Function(Pointer<Void>), void Function(Pointer<Void>)>('NfcsignerFfiFree'),
+        _createBuffer = library.lookupFunction<Pointer<_NativeBuffer> Function(Int64),
+            Pointer<_NativeBuffer> Function(int)>('NfcsignerFfiBufferCreate'),
+        _releaseBuffer = library.lookupFunction<Void Function(Pointer<Void>), void Function(Pointer<Void>)>(
+            'NfcsignerFfiBufferRelease'),
+        _releaseFinalizer = library.lookup<NativeFinalizerFunction>('NfcsignerFfiBufferRelease'),
+        _invoke = library.lookupFunction<_InvokeNative, _InvokeDart>('NfcsignerFfiInvoke'),
+        _cancel = library.lookupFunction<Int32 Function(Pointer<Uint8>), int Function(Pointer<Uint8>)>(
+            'NfcsignerFfiCancel') {
+    _callback = NativeCallable<_ResultCallbackNative>.listener(_onResult);
+    // Không giữ isolate sống chỉ vì đường FFI.
+    _callback.keepIsolateAlive = false;
+  }
+
+  static NfcsignerFfi? _load() {
+    if (!(Platform.isWindows || Platform.isLinux)) return null;
+    try {
+      final library = DynamicLibrary.open(Platform.isWindows ? 'nfcsigner_plugin.dll' : 'libnfcsigner_plugin.so');
+      final getVersion = library.lookupFunction<Int32 Function(), int Function()>('NfcsignerFfiGetVersion');
+      if (getVersion() != _abiVersion) return null;
+      return NfcsignerFfi._(library);
+    } catch (_) {
+      return null;
+    }
+  }
+
+  /// Gọi [method] với [arguments] và [payload] đặt dưới khóa [payloadKey].
+  ///
+  /// Trả về null nếu native không nhận request (caller chuyển sang
+  /// MethodChannel). Lỗi từ native được ném ra dưới dạng [PlatformException]
+  /// như MethodChannel.
+  Future<Object?>? invokeMethod(
+    String method,
+    Map<String, Object?> arguments, {
+    String? payloadKey,
+    Uint8List? payload,
+  }) {
+    final ByteData? encoded = arguments.isEmpty ? null : _codec.encodeMessage(arguments);
+    final buffers = <Pointer<Uint8>>[];
+    Pointer<Uint8> copy(Uint8List bytes) {
+      if (bytes.isEmpty) return nullptr;
+      final pointer = _allocate(bytes.length);
+      if (pointer == nullptr) throw StateError('Out of native memory');
+      buffers.add(pointer);
+      pointer.asTypedList(bytes.length).setAll(0, bytes);
+      return pointer;
+    }
+
+    Pointer<Uint8> copyString(String value) => copy(Uint8List.fromList([...utf8.encode(value), 0]));
+
+    try {
+      final requestId = _nextRequestId++;
+      final argumentBytes = encoded?.buffer.asUint8List(encoded.offsetInBytes, encoded.lengthInBytes);
+      final completer = Completer<Object?>();
+      _pending[requestId] = completer;
+      final methodPointer = copyString(method);
+      final argumentPointer = argumentBytes == null ? nullptr : copy(argumentBytes);
+      final payloadKeyPointer = payloadKey == null ? nullptr : copyString(payloadKey);
+      // Payload tạo cuối cùng, ngay trước lời gọi: từ đó nó thuộc về native
+      // (kể cả khi bị từ chối) và được method dùng thẳng, không chép lại.
+      final payloadBuffer = payload == null ? nullptr : _copyToBuffer(payload);
+      // Native giải mã tham số trước khi trả về nên các bộ đệm còn lại được
+      // giải phóng ngay.
+      final accepted = _invoke(
+        requestId,
+        methodPointer,
+        argumentPointer,
+        argumentBytes?.length ?? 0,
+        payloadKeyPointer,
+        payloadBuffer,
+        _callback.nativeFunction,
+      );
+      if (accepted != 0) {
+        _pending.remove(requestId);
+        return null;
+      }
+      return completer.future;
+    } finally {
+      for (final pointer in buffers) {
+        _free(pointer.cast());
+      }
+    }
+  }
+
+  Pointer<_NativeBuffer> _copyToBuffer(Uint8List bytes) {
+    final buffer = _createBuffer(bytes.length);
+    if (buffer == nullptr) throw StateError('Out of native memory');
+    if (bytes.isNotEmpty) buffer.ref.data.asTypedList(bytes.length).setAll(0, bytes);
+    return buffer;
+  }
+
+  /// Hủy request có tham số `requestId` == [requestId], kể cả request đi qua
+  /// MethodChannel. Gọi đồng bộ, không chờ platform thread.
+  bool cancel(String requestId) {
+    final bytes = utf8.encode(requestId);
+    final pointer = _allocate(bytes.length + 1);
+    if (pointer == nullptr) throw StateError('Out of native memory');
+    try {
+      pointer.asTypedList(bytes.length + 1)
+        ..setAll(0, bytes)
+        ..[bytes.length] = 0;
+      return _cancel(pointer) == 1;
+    } finally {
+      _free(pointer.cast());
+    }
+  }
+
+  void _onResult(int requestId, int status, Pointer<_NativeBuffer> result) {
+    final completer = _pending.remove(requestId);
+    if (status == _resultBytes) {
+      // Dart nhận luôn vector của native; finalizer trả lại khi hết tham chiếu.
+      final bytes = result == nullptr
+          ? Uint8List(0)
+          : result.ref.data.asTypedList(result.ref.length, finalizer: _releaseFinalizer, token: result.cast());
+      completer?.complete(bytes);
+      return;
+    }
+
+    Uint8List? encoded;
+    if (result != nullptr) {
+      encoded = Uint8List.fromList(result.ref.data.asTypedList(result.ref.length));
+      _releaseBuffer(result.cast());
+    }
+    if (completer != null) completeResult(completer, status, encoded);
+  }
+
+  /// Hoàn tất [completer] theo mã [status] của callback native và [data] đã
+  /// chép ra khỏi bộ đệm native, giống kết quả của MethodChannel.
+  @visibleForTesting
+  static void completeResult(Completer<Object?> completer, int status, Uint8List? data) {
+    if (status == _resultBytes) {
+      completer.complete(data ?? Uint8List(0));
+      return;
+    }
+    final Object? decoded = data == null ? null : _codec.decodeMessage(ByteData.sublistView(data));
+    switch (status) {
+      case _resultValue:
+        completer.complete(decoded);
+      case _resultError:
+        final error = decoded as List<Object?>;
+        completer.completeError(PlatformException(code: error[0] as String, message: error[1] as String?));
+      case _resultNotImplemented:
+        completer.completeError(MissingPluginException('No implementation found for FFI method'));
+      default:
+        completer.completeError(StateError('Unknown FFI result status $status'));
+    }
+  }
+}
@@ -1,24 +1,22 @@
 #pragma once
 
-
-#ifdef _WIN32
-#include <windows.h>
-#include <winscard.h>
-#else
-#include <PCSC/winscard.h>
-#include <PCSC/wintypes.h>
-#endif
-
 //#include <flutter/method_channel.h>
 #include <flutter/plugin_registrar.h>
 #include <flutter/standard_method_codec.h>
 
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
 namespace nfcsigner {
 
+    class CancellationToken;
+    class WorkerPool;
+    struct WarmUpOptions;
+    struct XmlBatchEventSink;
+
     class NfcsignerPlugin : public flutter::Plugin {
     public:
         static void RegisterWithRegistrar(flutter::PluginRegistrar* registrar);
@@ -30,13 +28,34 @@ namespace nfcsigner {
         NfcsignerPlugin(const NfcsignerPlugin&) = delete;
         NfcsignerPlugin& operator=(const NfcsignerPlugin&) = delete;
 
-    private:
+        // Gọi từ MethodChannel trên platform thread. Thao tác thẻ/file chạy trên
+        // worker của plugin với bản sao tham số; kết quả được gửi lại platform thread.
         void HandleMethodCall(
                 const flutter::MethodCall<flutter::EncodableValue>& method_call,
                 std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
 
-        // Helper methods
-        std::vector<uint8_t> TransmitAndGetResponse(SCARDHANDLE hCard, const std::vector<uint8_t>& command);
+        // Nhận request: đăng ký token hủy ngay rồi đưa vào worker có giới hạn của
+        // plugin; [result] được trả từ worker (CARD_BUSY nếu hàng đợi đầy). Dùng
+        // trực tiếp cho đường dart:ffi (nfcsigner_ffi.h).
+        void SubmitMethodCall(
+                std::shared_ptr<const flutter::MethodCall<flutter::EncodableValue>> call,
+                std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+    private:
+        // Chạy method ngay trên luồng hiện tại (method nhanh, không chạm thẻ).
+        void RunMethodCall(
+                const flutter::MethodCall<flutter::EncodableValue>& method_call,
+                std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+        // Chạy method với token hủy đã đăng ký lúc nhận request.
+        void RunAcceptedCall(
+                const flutter::MethodCall<flutter::EncodableValue>& method_call,
+                std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result,
+                std::shared_ptr<CancellationToken> token);
+
+        // Warm-up trên worker riêng, không chiếm worker của thẻ.
+        bool StartWarmUp(const WarmUpOptions& options);
+
         void HandleSign(const flutter::EncodableMap* args,
                         std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
         void HandleGetPublicKey(const flutter::EncodableMap* args,
@@ -45,6 +64,55 @@ namespace nfcsigner {
                                   std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
         void HandleSignPdf(const flutter::EncodableMap* args,
                            std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleSignPdfMulti(const flutter::EncodableMap* args,
+                                std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleGetSigningMetrics(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleGenerateXmlSignature(const flutter::EncodableMap* args,
+                                        std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleSignXml(const flutter::EncodableMap* args,
+                           std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleSignXmlBatch(const flutter::EncodableMap* args,
+                                std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleSignFile(const flutter::EncodableMap* args,
+                            std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleHashFiles(const flutter::EncodableMap* args,
+                             std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleVerifyPdf(const flutter::EncodableMap* args,
+                             std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleVerifyCms(const flutter::EncodableMap* args,
+                             std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleVerifySignature(const flutter::EncodableMap* args,
+                                   std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleSetSignatureSelfCheck(const flutter::EncodableMap* args,
+                                         std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleWarmUp(const flutter::EncodableMap* args,
+                          std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleSetCardRecoveryPolicy(const flutter::EncodableMap* args,
+                                         std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleSetMemoryTracking(const flutter::EncodableMap* args,
+                                     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleOpenSigningSession(const flutter::EncodableMap* args,
+                                      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleSignPdfWithSession(const flutter::EncodableMap* args,
+                                      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleCloseSigningSession(const flutter::EncodableMap* args,
+                                       std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleGetCardQueueMetrics(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+        void HandleCancel(const flutter::EncodableMap* args,
+                          std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+        // Request đã nhận mà chưa xong; bị hủy khi plugin bị hủy.
+        std::mutex requests_mutex_;
+        std::set<std::shared_ptr<CancellationToken>> accepted_requests_;
+        std::unique_ptr<WorkerPool> workers_;
+        std::unique_ptr<WorkerPool> file_workers_;
+        // Một lần warm-up mỗi lúc; last_warm_up_ là báo cáo của lần đã xong gần nhất.
+        std::mutex warm_up_mutex_;
+        bool warm_up_running_ = false;
+        flutter::EncodableMap last_warm_up_;
+        std::unique_ptr<WorkerPool> warm_up_worker_;
+        // Sink dùng chung với stream handler của EventChannel "nfcsigner/xml_batch".
+        std::shared_ptr<XmlBatchEventSink> xml_batch_events_;
     };
 
 }  // namespace nfcsig
\ No newline at end of file
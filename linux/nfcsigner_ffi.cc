@@ -0,0 +1,204 @@
+#include "include/nfcsigner/nfcsigner_ffi.h"
+
+#include <flutter/standard_message_codec.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cancellation.h"
+#include "include/nfcsigner/nfcsigner_plugin.h"
+
+namespace nfcsigner {
+
+    namespace {
+
+        // NfcsignerFfiBuffer sở hữu vector của nó: tham số chuyển thẳng vào
+        // EncodableValue, kết quả chuyển thẳng từ handler sang Dart.
+        struct OwnedBuffer : NfcsignerFfiBuffer {
+            std::vector<uint8_t> bytes;
+
+            explicit OwnedBuffer(std::vector<uint8_t> value) : NfcsignerFfiBuffer(), bytes(std::move(value)) {
+                data = bytes.data();
+                length = static_cast<int64_t>(bytes.size());
+            }
+        };
+
+        OwnedBuffer* Owned(void* buffer) {
+            return static_cast<OwnedBuffer*>(static_cast<NfcsignerFfiBuffer*>(buffer));
+        }
+
+        NfcsignerFfiBuffer* HandOver(std::vector<uint8_t>&& bytes) {
+            if (bytes.empty()) return nullptr;
+            return new (std::nothrow) OwnedBuffer(std::move(bytes));
+        }
+
+        // Gửi kết quả của một request về Dart, đúng một lần.
+        class FfiCompletion {
+        public:
+            FfiCompletion(int64_t requestId, NfcsignerFfiCallback callback)
+                    : request_id_(requestId), callback_(callback) {}
+
+            bool IsDone() const { return done_; }
+
+            void Complete(int32_t status, std::vector<uint8_t>&& bytes) {
+                if (done_.exchange(true)) return;
+                callback_(request_id_, status, HandOver(std::move(bytes)));
+            }
+
+            void CompleteEncoded(int32_t status, const flutter::EncodableValue& value) {
+                auto encoded = flutter::StandardMessageCodec::GetInstance().EncodeMessage(value);
+                Complete(status, std::move(*encoded));
+            }
+
+            void CompleteError(const std::string& code, const std::string& message) {
+                CompleteEncoded(NFCSIGNER_FFI_RESULT_ERROR, flutter::EncodableValue(flutter::EncodableList{
+                        flutter::EncodableValue(code), flutter::EncodableValue(message) }));
+            }
+
+        private:
+            int64_t request_id_;
+            NfcsignerFfiCallback callback_;
+            std::atomic<bool> done_{false};
+        };
+
+        // MethodResult chuyển kết quả của handler sang callback. Bytes đi
+        // nguyên khối; giá trị khác (map, list...) mã hóa StandardMessageCodec.
+        class FfiMethodResult : public flutter::MethodResult<flutter::EncodableValue> {
+        public:
+            explicit FfiMethodResult(std::shared_ptr<FfiCompletion> completion)
+                    : completion_(std::move(completion)) {}
+
+            // Handler bỏ quên result: Dart vẫn nhận được lỗi thay vì chờ mãi.
+            ~FfiMethodResult() override {
+                if (!completion_->IsDone()) completion_->CompleteError("UNKNOWN_ERROR", "Method finished without a result.");
+            }
+
+        protected:
+            void SuccessInternal(const flutter::EncodableValue* result) override {
+                if (result) {
+                    if (const auto* bytes = std::get_if<std::vector<uint8_t>>(result)) {
+                        // Handler truyền giá trị tạm vào Success và không dùng
+                        // lại: lấy luôn vector thay vì chép kết quả.
+                        completion_->Complete(NFCSIGNER_FFI_RESULT_BYTES,
+                                              std::move(const_cast<std::vector<uint8_t>&>(*bytes)));
+                        return;
+                    }
+                    completion_->CompleteEncoded(NFCSIGNER_FFI_RESULT_VALUE, *result);
+                } else {
+                    completion_->CompleteEncoded(NFCSIGNER_FFI_RESULT_VALUE, flutter::EncodableValue());
+                }
+            }
+
+            void ErrorInternal(const std::string& errorCode, const std::string& errorMessage,
+                               const flutter::EncodableValue* /*errorDetails*/) override {
+                completion_->CompleteError(errorCode, errorMessage);
+            }
+
+            void NotImplementedInternal() override {
+                completion_->Complete(NFCSIGNER_FFI_RESULT_NOT_IMPLEMENTED, {});
+            }
+
+        private:
+            std::shared_ptr<FfiCompletion> completion_;
+        };
+
+        // Plugin riêng cho đường FFI; trạng thái dùng chung (cache certificate,
+        // appearance, số liệu) nằm trong các singleton nên không bị tách đôi.
+        // Request chạy trên worker có giới hạn của plugin; lúc thoát tiến trình
+        // plugin hủy các request còn lại và join worker. Registry được tạo trước
+        // nên bị hủy sau plugin, còn dùng được khi worker chạy nốt.
+        NfcsignerPlugin& FfiPlugin() {
+            CancellationRegistry::Instance();
+            static NfcsignerPlugin plugin;
+            return plugin;
+        }
+
+    }  // namespace
+
+}  // namespace nfcsigner
+
+int32_t NfcsignerFfiGetVersion(void) {
+    return NFCSIGNER_FFI_VERSION;
+}
+
+uint8_t* NfcsignerFfiAllocate(int64_t size) {
+    if (size <= 0) return nullptr;
+    return static_cast<uint8_t*>(std::malloc(static_cast<size_t>(size)));
+}
+
+void NfcsignerFfiFree(void* data) {
+    std::free(data);
+}
+
+NfcsignerFfiBuffer* NfcsignerFfiBufferCreate(int64_t size) {
+    if (size < 0) return nullptr;
+    try {
+        return new nfcsigner::OwnedBuffer(std::vector<uint8_t>(static_cast<size_t>(size)));
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void NfcsignerFfiBufferRelease(void* buffer) {
+    delete nfcsigner::Owned(buffer);
+}
+
+int32_t NfcsignerFfiInvoke(int64_t request_id, const char* method,
+                           const uint8_t* arguments, int64_t arguments_length,
+                           const char* payload_key, NfcsignerFfiBuffer* payload,
+                           NfcsignerFfiCallback callback) {
+    using nfcsigner::FfiCompletion;
+    using nfcsigner::FfiMethodResult;
+
+    // Payload thuộc về native từ đây, kể cả khi từ chối request.
+    std::unique_ptr<nfcsigner::OwnedBuffer> owned_payload(payload ? nfcsigner::Owned(payload) : nullptr);
+    if (!method || !callback || arguments_length < 0 || (arguments_length > 0 && !arguments)) {
+        return -1;
+    }
+
+    // Giải mã tham số nhỏ ngay trên luồng gọi, để caller giải phóng bộ đệm khi
+    // hàm trả về; payload chuyển nguyên vector vào map, không chép.
+    flutter::EncodableMap args;
+    try {
+        if (arguments_length > 0) {
+            auto decoded = flutter::StandardMessageCodec::GetInstance().DecodeMessage(
+                    arguments, static_cast<size_t>(arguments_length));
+            if (!decoded) return -1;
+            if (auto* map = std::get_if<flutter::EncodableMap>(decoded.get())) {
+                args = std::move(*map);
+            } else if (!decoded->IsNull()) {
+                return -1;
+            }
+        }
+        if (payload_key) {
+            args[flutter::EncodableValue(payload_key)] = flutter::EncodableValue(
+                    owned_payload ? std::move(owned_payload->bytes) : std::vector<uint8_t>());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "FFI arguments rejected: " << e.what() << std::endl;
+        return -1;
+    }
+
+    auto completion = std::make_shared<FfiCompletion>(request_id, callback);
+    try {
+        nfcsigner::FfiPlugin().SubmitMethodCall(
+                std::make_shared<flutter::MethodCall<flutter::EncodableValue>>(
+                        method, std::make_unique<flutter::EncodableValue>(std::move(args))),
+                std::make_unique<FfiMethodResult>(completion));
+    } catch (const std::exception& e) {
+        completion->CompleteError("STD_EXCEPTION", std::string("Standard Exception: ") + e.what());
+    }
+    return 0;
+}
+
+int32_t NfcsignerFfiCancel(const char* request_id) {
+    if (!request_id) return -1;
+    return nfcsigner::CancellationRegistry::Instance().Cancel(request_id) ? 1 : 0;
+}
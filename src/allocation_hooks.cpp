@@ -0,0 +1,123 @@
+// Thay operator new/delete của module link nfcsigner_core (plugin, nfcsignerd,
+// nfcsign) để MemoryTracker đếm cấp phát theo pha. Chỉ build khi bật
+// NFCSIGNER_ALLOCATION_HOOKS; khi tắt theo dõi mỗi cấp phát chỉ tốn thêm việc
+// hỏi kích thước khối, một bộ đếm chung và đọc một biến thread_local.
+
+#include "memory_accounting.h"
+
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+namespace {
+
+    size_t BlockSize(void* p) {
+#ifdef _WIN32
+        return _msize(p);
+#else
+        return malloc_usable_size(p);
+#endif
+    }
+
+    size_t AlignedBlockSize(void* p, size_t alignment) {
+#ifdef _WIN32
+        return _aligned_msize(p, alignment, 0);
+#else
+        (void)alignment;
+        return malloc_usable_size(p);
+#endif
+    }
+
+    void* Allocate(size_t size) {
+        void* p = std::malloc(size ? size : 1);
+        if (!p) throw std::bad_alloc();
+        nfcsigner::RecordAllocation(BlockSize(p));
+        return p;
+    }
+
+    void* AllocateAligned(size_t size, std::align_val_t alignment) {
+        size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+        void* p = _aligned_malloc(size ? size : 1, align);
+#else
+        // aligned_alloc cần kích thước là bội của căn lề.
+        size_t rounded = size ? (size + align - 1) / align * align : align;
+        void* p = std::aligned_alloc(align, rounded);
+#endif
+        if (!p) throw std::bad_alloc();
+        nfcsigner::RecordAllocation(AlignedBlockSize(p, align));
+        return p;
+    }
+
+    void Free(void* p) {
+        if (!p) return;
+        nfcsigner::RecordDeallocation(BlockSize(p));
+        std::free(p);
+    }
+
+    void FreeAligned(void* p, std::align_val_t alignment) {
+        if (!p) return;
+        nfcsigner::RecordDeallocation(AlignedBlockSize(p, static_cast<size_t>(alignment)));
+#ifdef _WIN32
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+
+    const bool hooks_registered = (nfcsigner::SetAllocationHooksInstalled(), true);
+
+}  // namespace
+
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new[](std::size_t size) { return Allocate(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return Allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return Allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept { Free(p); }
+void operator delete[](void* p) noexcept { Free(p); }
+void operator delete(void* p, std::size_t) noexcept { Free(p); }
+void operator delete[](void* p, std::size_t) noexcept { Free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { Free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { Free(p); }
+
+void* operator new(std::size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return AllocateAligned(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return AllocateAligned(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p, std::align_val_t alignment) noexcept { FreeAligned(p, alignment); }
+void operator delete[](void* p, std::align_val_t alignment) noexcept { FreeAligned(p, alignment); }
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept { FreeAligned(p, alignment); }
+void operator delete[](void* p, std::size_t, std::align_val_t alignment) noexcept { FreeAligned(p, alignment); }
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { FreeAligned(p, alignment); }
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept { FreeAligned(p, alignment); }
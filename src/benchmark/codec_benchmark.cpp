@@ -0,0 +1,133 @@
+// Benchmark mã hóa hex/base64 (byte_codec.h) so với các hàm cũ của engine:
+// HexToBytes bằng substr + strtol, ToHexString nối từng ký tự, EncodeBase64
+// bằng EVP_EncodeBlock (giải mã so với EVP_DecodeBlock). Mode "scalar" là
+// byte_codec chỉ dùng bảng tra, "simd" là kernel theo CPU. Kích thước theo
+// dữ liệu thật: AID, digest/chữ ký RSA, certificate, CMS trong /Contents.
+//
+//   cmake -DNFCSIGNER_BUILD_BENCHMARKS=ON ... && ./codec_benchmark [iterations]
+
+#include "byte_codec.h"
+
+#include <openssl/evp.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace nfcsigner;
+
+namespace {
+
+    // === Các hàm trước khi có byte_codec ===
+
+    std::vector<uint8_t> LegacyHexToBytes(const std::string& hex) {
+        std::vector<uint8_t> bytes;
+        if (hex.length() % 2 != 0) {
+            throw std::runtime_error("Hex string must have even length");
+        }
+        for (size_t i = 0; i < hex.length(); i += 2) {
+            std::string byteString = hex.substr(i, 2);
+            char* end;
+            uint8_t byte = static_cast<uint8_t>(strtol(byteString.c_str(), &end, 16));
+            if (*end != '\0') {
+                throw std::runtime_error("Invalid hex character");
+            }
+            bytes.push_back(byte);
+        }
+        return bytes;
+    }
+
+    std::string LegacyToHexString(const std::vector<uint8_t>& data) {
+        const char hex_chars[] = "0123456789abcdef";
+        std::string hex_str;
+        hex_str.reserve(data.size() * 2);
+        for (unsigned char byte : data) {
+            hex_str += hex_chars[(byte >> 4) & 0x0F];
+            hex_str += hex_chars[byte & 0x0F];
+        }
+        return hex_str;
+    }
+
+    std::string LegacyEncodeBase64(const std::vector<uint8_t>& data) {
+        std::string out(4 * ((data.size() + 2) / 3), '\0');
+        if (data.empty()) return out;
+        int length = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(&out[0]), data.data(), static_cast<int>(data.size()));
+        out.resize(static_cast<size_t>(length));
+        return out;
+    }
+
+    std::vector<uint8_t> LegacyDecodeBase64(const std::string& text) {
+        std::vector<uint8_t> out(text.size() / 4 * 3);
+        int length = EVP_DecodeBlock(out.data(), reinterpret_cast<const unsigned char*>(text.data()),
+                                     static_cast<int>(text.size()));
+        if (length < 0) throw std::runtime_error("Invalid base64 string");
+        // EVP_DecodeBlock giữ cả byte của phần padding.
+        size_t padding = 0;
+        if (!text.empty() && text.back() == '=') padding = text[text.size() - 2] == '=' ? 2 : 1;
+        out.resize(static_cast<size_t>(length) - padding);
+        return out;
+    }
+
+    // Chặn compiler bỏ vòng lặp đo.
+    volatile size_t sink = 0;
+
+    template<typename Func>
+    double MeasureNs(int iterations, Func&& run) {
+        run();  // làm nóng
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) sink = sink + run();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+    }
+
+    void Report(const char* operation, const char* mode, size_t size, double ns) {
+        std::printf("%-10s %-7s %7zu %12.1f %10.1f\n", operation, mode, size, ns, size / ns * 1000.0);
+    }
+
+    void Check(bool ok, const char* operation, size_t size) {
+        if (ok) return;
+        std::fprintf(stderr, "%s: output differs at %zu bytes\n", operation, size);
+        std::exit(1);
+    }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 20000;
+    if (iterations <= 0) iterations = 20000;
+
+    std::printf("kernels: %s\n", GetByteCodecKernels().c_str());
+    std::printf("%-10s %-7s %7s %12s %10s\n", "op", "mode", "bytes", "ns/op", "MB/s");
+    std::mt19937 random(7);
+    for (size_t size : { size_t(16), size_t(256), size_t(1500), size_t(16384) }) {
+        std::vector<uint8_t> data(size);
+        for (auto& b : data) b = static_cast<uint8_t>(random());
+        int rounds = static_cast<int>(iterations * 256 / (size + 256)) + 1;
+
+        const std::string hex = LegacyToHexString(data);
+        const std::string base64 = LegacyEncodeBase64(data);
+        Check(LegacyHexToBytes(hex) == data && LegacyDecodeBase64(base64) == data, "legacy", size);
+
+        Report("hex-enc", "legacy", size, MeasureNs(rounds, [&]() { return LegacyToHexString(data).size(); }));
+        Report("hex-dec", "legacy", size, MeasureNs(rounds, [&]() { return LegacyHexToBytes(hex).size(); }));
+        Report("b64-enc", "legacy", size, MeasureNs(rounds, [&]() { return LegacyEncodeBase64(data).size(); }));
+        Report("b64-dec", "legacy", size, MeasureNs(rounds, [&]() { return LegacyDecodeBase64(base64).size(); }));
+
+        for (bool scalar : { true, false }) {
+            SetByteCodecScalarOnly(scalar);
+            const char* mode = scalar ? "scalar" : "simd";
+            Check(EncodeHex(data.data(), data.size()) == hex && DecodeHex(hex) == data &&
+                  EncodeBase64(data) == base64 && DecodeBase64(base64) == data, mode, size);
+
+            Report("hex-enc", mode, size, MeasureNs(rounds, [&]() { return EncodeHex(data.data(), data.size()).size(); }));
+            Report("hex-dec", mode, size, MeasureNs(rounds, [&]() { return DecodeHex(hex).size(); }));
+            Report("b64-enc", mode, size, MeasureNs(rounds, [&]() { return EncodeBase64(data).size(); }));
+            Report("b64-dec", mode, size, MeasureNs(rounds, [&]() { return DecodeBase64(base64).size(); }));
+        }
+        SetByteCodecScalarOnly(false);
+    }
+    return 0;
+}
@@ -0,0 +1,309 @@
+// Benchmark đường ký từng phần (lazy_pdf) so với nạp toàn bộ bằng PoDoFo,
+// theo số trang của tài liệu. Ký bằng khóa RSA phần mềm, không cần thẻ.
+// Mode "arena" là đường lazy chạy trong RequestArena như plugin; cột heap
+// đếm số lần operator new của một lượt ký để so trước/sau (qua hook của
+// allocation_hooks.cpp, build cùng benchmark). Bảng thứ hai chia bộ nhớ của
+// một lượt ký theo pha (MemoryTracker).
+//
+//   cmake -DNFCSIGNER_BUILD_BENCHMARKS=ON ... && ./lazy_pdf_benchmark [iterations]
+
+#include "cms_template.h"
+#include "lazy_pdf.h"
+#include "memory_accounting.h"
+#include "request_arena.h"
+
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_PODOFO
+#include <podofo/podofo.h>
+#endif
+
+using namespace nfcsigner;
+
+namespace {
+
+    // Mỗi trang có một ảnh quét giả lập cỡ này.
+    constexpr size_t kImageBytes = 96 * 1024;
+
+    // Tài liệu [pages] trang, cây trang hai tầng, xref cổ điển.
+    std::vector<uint8_t> MakeDocument(int pages) {
+        std::mt19937 random(static_cast<unsigned>(pages));
+        std::string image(kImageBytes, '\0');
+        for (auto& c : image) c = static_cast<char>(random());
+
+        std::vector<std::string> objects(3);
+        objects[1] = "<< /Type /Catalog /Pages 2 0 R >>";
+        std::string rootKids;
+        int groups = 0;
+        for (int first = 0; first < pages; first += 20) {
+            int groupNumber = static_cast<int>(objects.size());
+            objects.emplace_back();
+            std::string kids;
+            int count = 0;
+            for (int i = first; i < pages && i < first + 20; ++i, ++count) {
+                int pageNumber = static_cast<int>(objects.size());
+                std::string content = "q 612 0 0 792 0 0 cm /Im0 Do Q BT /F1 12 Tf 72 72 Td (Page " +
+                                      std::to_string(i + 1) + ") Tj ET";
+                objects.push_back("<< /Type /Page /Parent " + std::to_string(groupNumber) +
+                                  " 0 R /MediaBox [0 0 612 792] /Contents " + std::to_string(pageNumber + 1) +
+                                  " 0 R /Resources << /XObject << /Im0 " + std::to_string(pageNumber + 2) + " 0 R >> >> >>");
+                objects.push_back("<< /Length " + std::to_string(content.size()) + " >>\nstream\n" + content + "\nendstream");
+                objects.push_back("<< /Type /XObject /Subtype /Image /Width 256 /Height 384 /ColorSpace /DeviceGray"
+                                  " /BitsPerComponent 8 /Length " + std::to_string(image.size()) + " >>\nstream\n" +
+                                  image + "\nendstream");
+                kids += std::to_string(pageNumber) + " 0 R ";
+            }
+            objects[groupNumber] = "<< /Type /Pages /Parent 2 0 R /Kids [" + kids + "] /Count " + std::to_string(count) + " >>";
+            rootKids += std::to_string(groupNumber) + " 0 R ";
+            ++groups;
+        }
+        objects[2] = "<< /Type /Pages /Kids [" + rootKids + "] /Count " + std::to_string(pages) + " >>";
+
+        std::string pdf = "%PDF-1.4\n%\xE2\xE3\xCF\xD3\n";
+        std::vector<size_t> offsets(objects.size(), 0);
+        for (size_t i = 1; i < objects.size(); ++i) {
+            offsets[i] = pdf.size();
+            pdf += std::to_string(i) + " 0 obj\n" + objects[i] + "\nendobj\n";
+        }
+        size_t xref = pdf.size();
+        pdf += "xref\n0 " + std::to_string(objects.size()) + "\n0000000000 65535 f\r\n";
+        for (size_t i = 1; i < objects.size(); ++i) {
+            char line[32];
+            std::snprintf(line, sizeof(line), "%010zu 00000 n\r\n", offsets[i]);
+            pdf += line;
+        }
+        pdf += "trailer\n<< /Size " + std::to_string(objects.size()) + " /Root 1 0 R >>\nstartxref\n" +
+               std::to_string(xref) + "\n%%EOF\n";
+        return std::vector<uint8_t>(pdf.begin(), pdf.end());
+    }
+
+    struct SoftwareKey {
+        EVP_PKEY* key = nullptr;
+        std::vector<uint8_t> certificate;
+
+        SoftwareKey() {
+            key = EVP_RSA_gen(2048);
+            X509* cert = X509_new();
+            ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+            X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+            X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+            X509_set_pubkey(cert, key);
+            X509_NAME* name = X509_get_subject_name(cert);
+            X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                       reinterpret_cast<const unsigned char*>("Benchmark"), -1, -1, 0);
+            X509_set_issuer_name(cert, name);
+            X509_sign(cert, key, EVP_sha256());
+            int length = i2d_X509(cert, nullptr);
+            certificate.resize(static_cast<size_t>(length));
+            unsigned char* out = certificate.data();
+            i2d_X509(cert, &out);
+            X509_free(cert);
+        }
+
+        ~SoftwareKey() { EVP_PKEY_free(key); }
+
+        std::vector<uint8_t> Sign(const std::vector<uint8_t>& digestInfo) const {
+            EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new(key, nullptr);
+            EVP_PKEY_sign_init(ctx);
+            EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING);
+            size_t length = 0;
+            EVP_PKEY_sign(ctx, nullptr, &length, digestInfo.data(), digestInfo.size());
+            std::vector<uint8_t> signature(length);
+            EVP_PKEY_sign(ctx, signature.data(), &length, digestInfo.data(), digestInfo.size());
+            EVP_PKEY_CTX_free(ctx);
+            signature.resize(length);
+            return signature;
+        }
+    };
+
+    long ReadStatusKb(const char* field) {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        size_t fieldLength = std::char_traits<char>::length(field);
+        while (std::getline(status, line)) {
+            if (line.compare(0, fieldLength, field) == 0) return std::atol(line.c_str() + fieldLength);
+        }
+        return -1;
+    }
+
+    // Đỉnh RSS tăng thêm khi chạy [run] một lần, đo trong tiến trình con để
+    // không lẫn với các lượt trước.
+    template<typename Func>
+    double MeasurePeakRssMb(Func&& run) {
+        int fds[2];
+        if (pipe(fds) != 0) return -1;
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            // Trả lại heap đã giải phóng để lượt đo phải cấp phát thật, rồi đặt
+            // lại VmHWM (kế thừa từ cha) về RSS hiện tại.
+            malloc_trim(0);
+            std::ofstream("/proc/self/clear_refs") << "5";
+            long baseline = ReadStatusKb("VmRSS:");
+            run();
+            long delta = ReadStatusKb("VmHWM:") - baseline;
+            ssize_t written = write(fds[1], &delta, sizeof(delta));
+            _exit(written == sizeof(delta) ? 0 : 1);
+        }
+        close(fds[1]);
+        long delta = -1;
+        if (read(fds[0], &delta, sizeof(delta)) != sizeof(delta)) delta = -1;
+        close(fds[0]);
+        waitpid(pid, nullptr, 0);
+        return delta / 1024.0;
+    }
+
+    template<typename Func>
+    void Measure(const char* mode, int pages, size_t bytes, int iterations, Func&& run) {
+        run();  // làm nóng
+        auto start = std::chrono::steady_clock::now();
+        size_t outputSize = 0;
+        for (int i = 0; i < iterations; ++i) outputSize = run();
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        uint64_t allocationsBefore = GetHookedAllocationCount();
+        run();
+        uint64_t allocations = GetHookedAllocationCount() - allocationsBefore;
+        std::printf("%-6s %6d %9.1f %10.2f %12.1f %10zu %8llu\n", mode, pages, bytes / 1048576.0,
+                    elapsed / iterations, MeasurePeakRssMb(run), outputSize - bytes,
+                    static_cast<unsigned long long>(allocations));
+    }
+
+    // Một lượt ký trong MemoryTracker; [run] tự chia pha bằng MemoryPhase.
+    template<typename Func>
+    void MeasurePhases(const char* mode, int pages, Func&& run) {
+        malloc_trim(0);     // để cột dRSS thấy phần pha cấp phát thêm
+        SetMemoryTrackingEnabled(true);
+        RequestMemoryReport report;
+        {
+            MemoryTracker tracker(mode);
+            run();
+            report = tracker.GetReport();
+        }
+        SetMemoryTrackingEnabled(false);
+        for (const auto& phase : report.phases) {
+            std::printf("%-6s %6d %-8s %8llu %12.2f %12.2f %12.2f\n", mode, pages, phase.name.c_str(),
+                        static_cast<unsigned long long>(phase.allocations), phase.allocatedBytes / 1048576.0,
+                        phase.peakLiveBytes / 1048576.0, (phase.rssAfterBytes - phase.rssBeforeBytes) / 1048576.0);
+        }
+    }
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+    if (iterations <= 0) iterations = 5;
+
+    SoftwareKey key;
+    auto cmsTemplate = CmsTemplate::Create(key.certificate);
+    CardSignFunction sign = [&](const std::vector<uint8_t>& digestInfo) { return key.Sign(digestInfo); };
+
+    std::printf("%-6s %6s %9s %10s %12s %10s %8s\n", "mode", "pages", "size(MB)", "ms/sign", "peakRSS(MB)", "update(B)",
+                "heap");
+    for (int pages : { 10, 50, 100, 300, 1000 }) {
+        auto pdf = MakeDocument(pages);
+
+        // Chỉ phần đọc: xref + catalog + nhánh cây trang tới trang cuối.
+        size_t touched = 0;
+        Measure("parse", pages, pdf.size(), iterations, [&]() {
+            LazyPdfReader reader(pdf.data(), pdf.size());
+            reader.GetPageReference(pages - 1);
+            touched = reader.GetParsedObjectCount();
+            return pdf.size();
+        });
+        std::printf("%-6s %6s %zu/%u objects parsed\n", "", "", touched,
+                    LazyPdfReader(pdf.data(), pdf.size()).GetSize() - 1);
+
+        Measure("lazy", pages, pdf.size(), iterations, [&]() {
+            LazyPdfSignParams params;
+            params.pageNumber = pages;
+            params.signingTime = std::time(nullptr);
+            auto signedPdf = SignPdfIncremental(pdf, params, LazyPdfAppearance(), *cmsTemplate, sign);
+            return signedPdf.size();
+        });
+
+        Measure("arena", pages, pdf.size(), iterations, [&]() {
+            RequestArena arena;
+            RequestArena::Scope arenaScope(&arena);
+            LazyPdfSignParams params;
+            params.pageNumber = pages;
+            params.signingTime = std::time(nullptr);
+            auto signedPdf = SignPdfIncremental(pdf, params, LazyPdfAppearance(), *cmsTemplate, sign);
+            return signedPdf.size();
+        });
+
+#ifdef HAVE_PODOFO
+        Measure("full", pages, pdf.size(), iterations, [&]() {
+            PoDoFo::PdfMemDocument document;
+            document.LoadFromBuffer(PoDoFo::bufferview(reinterpret_cast<const char*>(pdf.data()), pdf.size()));
+            auto& page = document.GetPages().GetPageAt(static_cast<unsigned>(pages - 1));
+            auto& field = page.CreateField<PoDoFo::PdfSignature>("BMC-Signature", PoDoFo::Rect(50, 700, 200, 50));
+            CardCmsSigner signer(cmsTemplate, sign);
+            std::vector<char> buffer(pdf.begin(), pdf.end());
+            PoDoFo::VectorStreamDevice device(buffer);
+            PoDoFo::SignDocument(document, device, signer, field);
+            return buffer.size();
+        });
+#endif
+    }
+
+    std::printf("\n%-6s %6s %-8s %8s %12s %12s %12s\n", "mode", "pages", "phase", "allocs", "alloc(MB)",
+                "peakLive(MB)", "dRSS(MB)");
+    for (int pages : { 100, 1000 }) {
+        auto pdf = MakeDocument(pages);
+        LazyPdfSignParams params;
+        params.pageNumber = pages;
+        params.signingTime = std::time(nullptr);
+
+        MeasurePhases("lazy", pages, [&]() {
+            std::unique_ptr<LazyPdfDocument> document;
+            {
+                MemoryPhase phase("parse");
+                document.reset(new LazyPdfDocument(pdf, pages));
+            }
+            MemoryPhase phase("sign");
+            SignPdfIncremental(*document, params, LazyPdfAppearance(), *cmsTemplate, sign);
+        });
+
+#ifdef HAVE_PODOFO
+        // Cùng các bước với SignFullDocument.
+        MeasurePhases("full", pages, [&]() {
+            PoDoFo::PdfMemDocument document;
+            PoDoFo::PdfSignature* field = nullptr;
+            {
+                MemoryPhase phase("parse");
+                document.LoadFromBuffer(PoDoFo::bufferview(reinterpret_cast<const char*>(pdf.data()), pdf.size()));
+                auto& page = document.GetPages().GetPageAt(static_cast<unsigned>(pages - 1));
+                field = &page.CreateField<PoDoFo::PdfSignature>("BMC-Signature", PoDoFo::Rect(50, 700, 200, 50));
+            }
+            std::vector<char> buffer;
+            {
+                MemoryPhase phase("copy");
+                buffer.assign(pdf.begin(), pdf.end());
+            }
+            {
+                MemoryPhase phase("sign");
+                CardCmsSigner signer(cmsTemplate, sign);
+                PoDoFo::VectorStreamDevice device(buffer);
+                PoDoFo::SignDocument(document, device, signer, *field);
+            }
+            MemoryPhase phase("output");
+            std::vector<uint8_t> output(buffer.data(), buffer.data() + buffer.size());
+        });
+#endif
+    }
+    return 0;
+}
@@ -0,0 +1,464 @@
+#include "byte_codec.h"
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define NFCSIGNER_CODEC_X86 1
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+#define NFCSIGNER_TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#define NFCSIGNER_TARGET_SSSE3
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define NFCSIGNER_CODEC_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace nfcsigner {
+
+    namespace {
+
+        const char kHexLower[] = "0123456789abcdef";
+        const char kHexUpper[] = "0123456789ABCDEF";
+        const char kBase64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        // Giá trị của từng ký tự, 0xFF nếu không hợp lệ.
+        struct DecodeTables {
+            uint8_t hex[256];
+            uint8_t base64[256];
+
+            DecodeTables() {
+                std::memset(hex, 0xFF, sizeof(hex));
+                std::memset(base64, 0xFF, sizeof(base64));
+                for (uint8_t i = 0; i < 16; ++i) {
+                    hex[static_cast<uint8_t>(kHexLower[i])] = i;
+                    hex[static_cast<uint8_t>(kHexUpper[i])] = i;
+                }
+                for (uint8_t i = 0; i < 64; ++i) base64[static_cast<uint8_t>(kBase64Alphabet[i])] = i;
+            }
+        };
+
+        const DecodeTables& Tables() {
+            static const DecodeTables tables;
+            return tables;
+        }
+
+        std::atomic<bool> scalar_only{ false };
+
+        // === Bảng tra ===
+
+        void EncodeHexScalar(const uint8_t* data, size_t size, char* out, const char* digits) {
+            for (size_t i = 0; i < size; ++i) {
+                out[i * 2] = digits[data[i] >> 4];
+                out[i * 2 + 1] = digits[data[i] & 0x0F];
+            }
+        }
+
+        bool DecodeHexScalar(const char* hex, size_t bytes, uint8_t* out) {
+            const uint8_t* table = Tables().hex;
+            uint8_t invalid = 0;
+            for (size_t i = 0; i < bytes; ++i) {
+                uint8_t high = table[static_cast<uint8_t>(hex[i * 2])];
+                uint8_t low = table[static_cast<uint8_t>(hex[i * 2 + 1])];
+                invalid |= high | low;
+                out[i] = static_cast<uint8_t>((high << 4) | (low & 0x0F));
+            }
+            return (invalid & 0x80) == 0;
+        }
+
+        void EncodeBase64Scalar(const uint8_t* data, size_t size, char* out) {
+            size_t i = 0;
+            for (; i + 3 <= size; i += 3, out += 4) {
+                uint32_t group = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8) | data[i + 2];
+                out[0] = kBase64Alphabet[group >> 18];
+                out[1] = kBase64Alphabet[(group >> 12) & 0x3F];
+                out[2] = kBase64Alphabet[(group >> 6) & 0x3F];
+                out[3] = kBase64Alphabet[group & 0x3F];
+            }
+            if (i < size) {
+                uint32_t group = uint32_t(data[i]) << 16;
+                if (i + 1 < size) group |= uint32_t(data[i + 1]) << 8;
+                out[0] = kBase64Alphabet[group >> 18];
+                out[1] = kBase64Alphabet[(group >> 12) & 0x3F];
+                out[2] = i + 1 < size ? kBase64Alphabet[(group >> 6) & 0x3F] : '=';
+                out[3] = '=';
+            }
+        }
+
+        // Các nhóm 4 ký tự đầy đủ (không có '=').
+        bool DecodeBase64Groups(const char* text, size_t groups, uint8_t* out) {
+            const uint8_t* table = Tables().base64;
+            uint8_t invalid = 0;
+            for (size_t i = 0; i < groups; ++i, text += 4, out += 3) {
+                uint8_t a = table[static_cast<uint8_t>(text[0])];
+                uint8_t b = table[static_cast<uint8_t>(text[1])];
+                uint8_t c = table[static_cast<uint8_t>(text[2])];
+                uint8_t d = table[static_cast<uint8_t>(text[3])];
+                invalid |= a | b | c | d;
+                uint32_t group = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | d;
+                out[0] = static_cast<uint8_t>(group >> 16);
+                out[1] = static_cast<uint8_t>(group >> 8);
+                out[2] = static_cast<uint8_t>(group);
+            }
+            return (invalid & 0x80) == 0;
+        }
+
+#ifdef NFCSIGNER_CODEC_X86
+        // === SSE2 / SSSE3 ===
+
+        bool CpuHasSsse3() {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 9)) != 0;
+#else
+            return __builtin_cpu_supports("ssse3");
+#endif
+        }
+
+        bool UseSsse3() {
+            static const bool supported = CpuHasSsse3();
+            return supported && !scalar_only.load(std::memory_order_relaxed);
+        }
+
+        // Nibble 0-15 sang ký tự: '0' + n, cộng thêm [letterOffset] nếu n > 9.
+        inline __m128i NibblesToHex(__m128i nibbles, __m128i letterOffset) {
+            __m128i letters = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+            return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), _mm_and_si128(letters, letterOffset));
+        }
+
+        // 16 byte mỗi vòng; trả về số byte đã mã hóa.
+        size_t EncodeHexSse2(const uint8_t* data, size_t size, char* out, HexCase hexCase) {
+            const __m128i mask = _mm_set1_epi8(0x0F);
+            const __m128i letterOffset = _mm_set1_epi8(hexCase == HexCase::Upper ? 'A' - '0' - 10 : 'a' - '0' - 10);
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16) {
+                __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                __m128i high = NibblesToHex(_mm_and_si128(_mm_srli_epi16(in, 4), mask), letterOffset);
+                __m128i low = NibblesToHex(_mm_and_si128(in, mask), letterOffset);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2), _mm_unpacklo_epi8(high, low));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i * 2 + 16), _mm_unpackhi_epi8(high, low));
+            }
+            return i;
+        }
+
+        // Ký tự hex sang giá trị; [valid] giữ 0xFF ở các làn hợp lệ.
+        inline __m128i HexToNibbles(__m128i chars, __m128i& valid) {
+            __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+            __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+            // So sánh không dấu: x <= k khi min(x, k) == x.
+            __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+            __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+            valid = _mm_and_si128(valid, _mm_or_si128(isDigit, isLetter));
+            return _mm_or_si128(_mm_and_si128(isDigit, digit),
+                                _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+        }
+
+        // Cặp (cao, thấp) trong mỗi làn 16 bit sang một byte.
+        inline __m128i PackNibblePairs(__m128i nibbles) {
+            __m128i high = _mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00FF)), 4);
+            return _mm_or_si128(high, _mm_srli_epi16(nibbles, 8));
+        }
+
+        // 16 byte (32 ký tự) mỗi vòng; trả về số byte đã giải mã, hoặc
+        // SIZE_MAX nếu gặp ký tự sai.
+        size_t DecodeHexSse2(const char* hex, size_t bytes, uint8_t* out) {
+            __m128i valid = _mm_set1_epi8(-1);
+            size_t i = 0;
+            for (; i + 16 <= bytes; i += 16) {
+                __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + i * 2));
+                __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hex + i * 2 + 16));
+                __m128i packed = _mm_packus_epi16(PackNibblePairs(HexToNibbles(first, valid)),
+                                                  PackNibblePairs(HexToNibbles(second, valid)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+            }
+            return _mm_movemask_epi8(valid) == 0xFFFF ? i : SIZE_MAX;
+        }
+
+        // Thuật toán của W. Muła: 12 byte sang 16 chỉ số 6 bit rồi sang ký tự
+        // bằng pshufb. Đọc 16 byte mỗi vòng; trả về số byte đã mã hóa.
+        NFCSIGNER_TARGET_SSSE3
+        size_t EncodeBase64Ssse3(const uint8_t* data, size_t size, char* out) {
+            const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+            const __m128i shiftLut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                   '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                                   '/' - 63, 'A', 0, 0);
+            size_t i = 0;
+            for (; i + 16 <= size; i += 12, out += 16) {
+                __m128i in = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), shuffle);
+                __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+                __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+                __m128i indices = _mm_or_si128(t0, t1);
+                // Nhóm của chỉ số: 0 cho A-Z, 1 cho a-z, 2-11 cho 0-9, 12/13 cho '+'/'/'.
+                __m128i group = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+                __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+                group = _mm_or_si128(group, _mm_and_si128(upper, _mm_set1_epi8(13)));
+                __m128i chars = _mm_add_epi8(_mm_shuffle_epi8(shiftLut, group), indices);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), chars);
+            }
+            return i;
+        }
+
+        // Kiểm tra và đổi 16 ký tự bằng bảng theo nibble (W. Muła), rồi gộp
+        // 4 giá trị 6 bit thành 3 byte. Trả về số nhóm đã giải mã, hoặc
+        // SIZE_MAX nếu gặp ký tự sai.
+        NFCSIGNER_TARGET_SSSE3
+        size_t DecodeBase64Ssse3(const char* text, size_t groups, uint8_t* out) {
+            const __m128i shiftLut = _mm_setr_epi8(0, 0, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+            // Bit h của maskLut[l] bật khi ký tự 0xhl hợp lệ.
+            const __m128i maskLut = _mm_setr_epi8(static_cast<char>(0xA8), static_cast<char>(0xF8),
+                                                  static_cast<char>(0xF8), static_cast<char>(0xF8),
+                                                  static_cast<char>(0xF8), static_cast<char>(0xF8),
+                                                  static_cast<char>(0xF8), static_cast<char>(0xF8),
+                                                  static_cast<char>(0xF8), static_cast<char>(0xF8),
+                                                  static_cast<char>(0xF0), 0x54, 0x50, 0x50, 0x50, 0x54);
+            const __m128i bitLut = _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, static_cast<char>(0x80),
+                                                 0, 0, 0, 0, 0, 0, 0, 0);
+            const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+            size_t done = 0;
+            for (; done + 4 <= groups; done += 4, text += 16, out += 12) {
+                __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+                __m128i high = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0F));
+                __m128i low = _mm_and_si128(in, _mm_set1_epi8(0x0F));
+                __m128i bits = _mm_and_si128(_mm_shuffle_epi8(maskLut, low), _mm_shuffle_epi8(bitLut, high));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(bits, _mm_setzero_si128())) != 0) return SIZE_MAX;
+                // '/' cùng nibble cao với '+' nhưng lệch khác.
+                __m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+                __m128i shift = _mm_or_si128(_mm_andnot_si128(slash, _mm_shuffle_epi8(shiftLut, high)),
+                                             _mm_and_si128(slash, _mm_set1_epi8(16)));
+                __m128i values = _mm_add_epi8(in, shift);
+                __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+                merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+                alignas(16) uint8_t bytes[16];
+                _mm_store_si128(reinterpret_cast<__m128i*>(bytes), _mm_shuffle_epi8(merged, pack));
+                std::memcpy(out, bytes, 12);
+            }
+            return done;
+        }
+#endif  // NFCSIGNER_CODEC_X86
+
+#ifdef NFCSIGNER_CODEC_NEON
+        // === NEON (ARM64) ===
+
+        bool UseNeon() {
+            return !scalar_only.load(std::memory_order_relaxed);
+        }
+
+        size_t EncodeHexNeon(const uint8_t* data, size_t size, char* out, HexCase hexCase) {
+            const uint8x16_t digits = vld1q_u8(reinterpret_cast<const uint8_t*>(
+                    hexCase == HexCase::Upper ? kHexUpper : kHexLower));
+            size_t i = 0;
+            for (; i + 16 <= size; i += 16) {
+                uint8x16_t in = vld1q_u8(data + i);
+                uint8x16x2_t chars;
+                chars.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(in, 4));
+                chars.val[1] = vqtbl1q_u8(digits, vandq_u8(in, vdupq_n_u8(0x0F)));
+                vst2q_u8(reinterpret_cast<uint8_t*>(out + i * 2), chars);
+            }
+            return i;
+        }
+
+        inline uint8x16_t HexToNibblesNeon(uint8x16_t chars, uint8x16_t& valid) {
+            uint8x16_t digit = vsubq_u8(chars, vdupq_n_u8('0'));
+            uint8x16_t letter = vsubq_u8(vorrq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+            uint8x16_t isDigit = vcleq_u8(digit, vdupq_n_u8(9));
+            uint8x16_t isLetter = vcleq_u8(letter, vdupq_n_u8(5));
+            valid = vandq_u8(valid, vorrq_u8(isDigit, isLetter));
+            return vorrq_u8(vandq_u8(isDigit, digit), vandq_u8(isLetter, vaddq_u8(letter, vdupq_n_u8(10))));
+        }
+
+        size_t DecodeHexNeon(const char* hex, size_t bytes, uint8_t* out) {
+            uint8x16_t valid = vdupq_n_u8(0xFF);
+            size_t i = 0;
+            for (; i + 16 <= bytes; i += 16) {
+                uint8x16x2_t chars = vld2q_u8(reinterpret_cast<const uint8_t*>(hex + i * 2));
+                uint8x16_t high = HexToNibblesNeon(chars.val[0], valid);
+                uint8x16_t low = HexToNibblesNeon(chars.val[1], valid);
+                vst1q_u8(out + i, vorrq_u8(vshlq_n_u8(high, 4), low));
+            }
+            return vminvq_u8(valid) == 0xFF ? i : SIZE_MAX;
+        }
+
+        uint8x16x4_t LoadTable64(const uint8_t* table) {
+            uint8x16x4_t result;
+            for (int i = 0; i < 4; ++i) result.val[i] = vld1q_u8(table + i * 16);
+            return result;
+        }
+
+        // 48 byte sang 64 ký tự mỗi vòng.
+        size_t EncodeBase64Neon(const uint8_t* data, size_t size, char* out) {
+            const uint8x16x4_t alphabet = LoadTable64(reinterpret_cast<const uint8_t*>(kBase64Alphabet));
+            size_t i = 0;
+            for (; i + 48 <= size; i += 48, out += 64) {
+                uint8x16x3_t in = vld3q_u8(data + i);
+                uint8x16x4_t chars;
+                chars.val[0] = vqtbl4q_u8(alphabet, vshrq_n_u8(in.val[0], 2));
+                chars.val[1] = vqtbl4q_u8(alphabet, vorrq_u8(vshlq_n_u8(vandq_u8(in.val[0], vdupq_n_u8(0x03)), 4),
+                                                             vshrq_n_u8(in.val[1], 4)));
+                chars.val[2] = vqtbl4q_u8(alphabet, vorrq_u8(vshlq_n_u8(vandq_u8(in.val[1], vdupq_n_u8(0x0F)), 2),
+                                                             vshrq_n_u8(in.val[2], 6)));
+                chars.val[3] = vqtbl4q_u8(alphabet, vandq_u8(in.val[2], vdupq_n_u8(0x3F)));
+                vst4q_u8(reinterpret_cast<uint8_t*>(out), chars);
+            }
+            return i;
+        }
+
+        // 64 ký tự sang 48 byte mỗi vòng; SIZE_MAX nếu gặp ký tự sai.
+        size_t DecodeBase64Neon(const char* text, size_t groups, uint8_t* out) {
+            const uint8_t* table = Tables().base64;
+            const uint8x16x4_t lower = LoadTable64(table);
+            const uint8x16x4_t upper = LoadTable64(table + 64);
+            uint8x16_t invalid = vdupq_n_u8(0);
+            size_t done = 0;
+            for (; done + 16 <= groups; done += 16, text += 64, out += 48) {
+                uint8x16x4_t chars = vld4q_u8(reinterpret_cast<const uint8_t*>(text));
+                uint8x16_t values[4];
+                for (int k = 0; k < 4; ++k) {
+                    // Ký tự 0-63 tra bảng dưới, 64-127 tra bảng trên, từ 128 là sai.
+                    uint8x16_t c = chars.val[k];
+                    uint8x16_t v = vqtbx4q_u8(vqtbl4q_u8(lower, c), upper, vsubq_u8(c, vdupq_n_u8(64)));
+                    values[k] = vorrq_u8(v, vcgeq_u8(c, vdupq_n_u8(0x80)));
+                    invalid = vorrq_u8(invalid, values[k]);
+                }
+                uint8x16x3_t bytes;
+                bytes.val[0] = vorrq_u8(vshlq_n_u8(values[0], 2), vshrq_n_u8(values[1], 4));
+                bytes.val[1] = vorrq_u8(vshlq_n_u8(values[1], 4), vshrq_n_u8(values[2], 2));
+                bytes.val[2] = vorrq_u8(vshlq_n_u8(values[2], 6), values[3]);
+                vst3q_u8(out, bytes);
+            }
+            return (vmaxvq_u8(invalid) & 0x80) == 0 ? done : SIZE_MAX;
+        }
+#endif  // NFCSIGNER_CODEC_NEON
+
+    }  // namespace
+
+    void EncodeHex(const uint8_t* data, size_t size, char* out, HexCase hexCase) {
+        size_t done = 0;
+#if defined(NFCSIGNER_CODEC_X86)
+        if (!scalar_only.load(std::memory_order_relaxed)) done = EncodeHexSse2(data, size, out, hexCase);
+#elif defined(NFCSIGNER_CODEC_NEON)
+        if (UseNeon()) done = EncodeHexNeon(data, size, out, hexCase);
+#endif
+        EncodeHexScalar(data + done, size - done, out + done * 2, hexCase == HexCase::Upper ? kHexUpper : kHexLower);
+    }
+
+    std::string EncodeHex(const uint8_t* data, size_t size, HexCase hexCase) {
+        std::string out(size * 2, '\0');
+        if (size) EncodeHex(data, size, &out[0], hexCase);
+        return out;
+    }
+
+    bool DecodeHex(const char* hex, size_t length, uint8_t* out) {
+        if (length % 2 != 0) return false;
+        size_t bytes = length / 2;
+        size_t done = 0;
+#if defined(NFCSIGNER_CODEC_X86)
+        if (!scalar_only.load(std::memory_order_relaxed)) done = DecodeHexSse2(hex, bytes, out);
+#elif defined(NFCSIGNER_CODEC_NEON)
+        if (UseNeon()) done = DecodeHexNeon(hex, bytes, out);
+#endif
+        if (done == SIZE_MAX) return false;
+        return DecodeHexScalar(hex + done * 2, bytes - done, out + done);
+    }
+
+    std::vector<uint8_t> DecodeHex(const std::string& hex) {
+        if (hex.length() % 2 != 0) {
+            throw std::runtime_error("Hex string must have even length");
+        }
+        std::vector<uint8_t> bytes(hex.length() / 2);
+        if (!DecodeHex(hex.data(), hex.length(), bytes.data())) {
+            throw std::runtime_error("Invalid hex character");
+        }
+        return bytes;
+    }
+
+    void EncodeBase64(const uint8_t* data, size_t size, char* out) {
+        size_t done = 0;
+#if defined(NFCSIGNER_CODEC_X86)
+        if (UseSsse3()) done = EncodeBase64Ssse3(data, size, out);
+#elif defined(NFCSIGNER_CODEC_NEON)
+        if (UseNeon()) done = EncodeBase64Neon(data, size, out);
+#endif
+        EncodeBase64Scalar(data + done, size - done, out + done / 3 * 4);
+    }
+
+    std::string EncodeBase64(const std::vector<uint8_t>& data) {
+        std::string out(Base64EncodedLength(data.size()), '\0');
+        if (!data.empty()) EncodeBase64(data.data(), data.size(), &out[0]);
+        return out;
+    }
+
+    bool DecodeBase64(const char* text, size_t length, std::vector<uint8_t>& out) {
+        out.clear();
+        if (length % 4 != 0) return false;
+        if (length == 0) return true;
+
+        // Nhóm cuối có thể có '='; các nhóm trước phải đầy đủ.
+        const char* last = text + length - 4;
+        size_t padding = last[3] == '=' ? (last[2] == '=' ? 2 : 1) : 0;
+        size_t groups = length / 4 - 1;
+        out.resize(groups * 3 + 3 - padding);
+
+        size_t done = 0;
+#if defined(NFCSIGNER_CODEC_X86)
+        if (UseSsse3()) done = DecodeBase64Ssse3(text, groups, out.data());
+#elif defined(NFCSIGNER_CODEC_NEON)
+        if (UseNeon()) done = DecodeBase64Neon(text, groups, out.data());
+#endif
+        if (done == SIZE_MAX || !DecodeBase64Groups(text + done * 4, groups - done, out.data() + done * 3)) {
+            out.clear();
+            return false;
+        }
+
+        const uint8_t* table = Tables().base64;
+        uint8_t a = table[static_cast<uint8_t>(last[0])];
+        uint8_t b = table[static_cast<uint8_t>(last[1])];
+        uint8_t c = padding < 2 ? table[static_cast<uint8_t>(last[2])] : 0;
+        uint8_t d = padding < 1 ? table[static_cast<uint8_t>(last[3])] : 0;
+        // Bit thừa phải bằng 0 để mỗi dữ liệu chỉ có một cách viết.
+        bool valid = ((a | b | c | d) & 0x80) == 0 &&
+                     (padding != 2 || (b & 0x0F) == 0) &&
+                     (padding != 1 || (c & 0x03) == 0);
+        if (!valid) {
+            out.clear();
+            return false;
+        }
+        uint8_t* tail = out.data() + groups * 3;
+        tail[0] = static_cast<uint8_t>((a << 2) | (b >> 4));
+        if (padding < 2) tail[1] = static_cast<uint8_t>((b << 4) | (c >> 2));
+        if (padding < 1) tail[2] = static_cast<uint8_t>((c << 6) | d);
+        return true;
+    }
+
+    std::vector<uint8_t> DecodeBase64(const std::string& text) {
+        std::vector<uint8_t> out;
+        if (!DecodeBase64(text.data(), text.length(), out)) {
+            throw std::runtime_error("Invalid base64 string");
+        }
+        return out;
+    }
+
+    std::string GetByteCodecKernels() {
+        bool scalar = scalar_only.load(std::memory_order_relaxed);
+#if defined(NFCSIGNER_CODEC_X86)
+        return std::string("hex=") + (scalar ? "scalar" : "sse2") + " base64=" + (UseSsse3() ? "ssse3" : "scalar");
+#elif defined(NFCSIGNER_CODEC_NEON)
+        return scalar ? "hex=scalar base64=scalar" : "hex=neon base64=neon";
+#else
+        (void)scalar;
+        return "hex=scalar base64=scalar";
+#endif
+    }
+
+    void SetByteCodecScalarOnly(bool scalarOnly) {
+        scalar_only.store(scalarOnly);
+    }
+
+}  // namespace nfcsigner
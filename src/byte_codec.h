@@ -0,0 +1,49 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_BYTE_CODEC_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_BYTE_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nfcsigner {
+
+    // Mã hóa hex và base64 dùng chung cho engine: AID, /Contents của PDF,
+    // certificate và chữ ký trong XML. Dùng SIMD khi CPU hỗ trợ (SSE2 cho hex,
+    // SSSE3 cho base64 trên x86; NEON trên ARM64), còn lại dùng bảng tra. Mọi
+    // bản cho cùng kết quả.
+
+    enum class HexCase { Lower, Upper };
+
+    // Ghi đúng 2 * [size] ký tự vào [out], không thêm '\0'.
+    void EncodeHex(const uint8_t* data, size_t size, char* out, HexCase hexCase = HexCase::Lower);
+    std::string EncodeHex(const uint8_t* data, size_t size, HexCase hexCase = HexCase::Lower);
+
+    // Giải mã chặt: độ dài chẵn, chỉ 0-9, a-f, A-F, không dấu cách. Ghi
+    // [length] / 2 byte vào [out]; trả về false nếu chuỗi sai.
+    bool DecodeHex(const char* hex, size_t length, uint8_t* out);
+    // Như trên, ném std::runtime_error nếu chuỗi sai.
+    std::vector<uint8_t> DecodeHex(const std::string& hex);
+
+    inline size_t Base64EncodedLength(size_t size) { return (size + 2) / 3 * 4; }
+
+    // Base64 chuẩn (RFC 4648, có padding). Ghi đúng Base64EncodedLength(size)
+    // ký tự vào [out], không thêm '\0'.
+    void EncodeBase64(const uint8_t* data, size_t size, char* out);
+    std::string EncodeBase64(const std::vector<uint8_t>& data);
+
+    // Giải mã chặt: độ dài là bội của 4, '=' chỉ ở cuối, bit thừa của nhóm
+    // cuối bằng 0, không dấu cách. Trả về false nếu chuỗi sai.
+    bool DecodeBase64(const char* text, size_t length, std::vector<uint8_t>& out);
+    // Như trên, ném std::runtime_error nếu chuỗi sai.
+    std::vector<uint8_t> DecodeBase64(const std::string& text);
+
+    // Kernel đang dùng, ví dụ "hex=sse2 base64=ssse3".
+    std::string GetByteCodecKernels();
+
+    // Chỉ dùng bảng tra, bỏ qua SIMD (để benchmark so sánh).
+    void SetByteCodecScalarOnly(bool scalarOnly);
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_BYTE_CODEC_H_
@@ -0,0 +1,166 @@
+#include "cancellation.h"
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace nfcsigner {
+
+    namespace {
+        thread_local CancellationToken* current_token = nullptr;
+    }
+
+    void CancellationToken::Cancel(bool deadlineExceeded) {
+        std::map<uint64_t, std::function<void()>> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (cancelled_.load(std::memory_order_relaxed)) return;
+            deadline_exceeded_.store(deadlineExceeded, std::memory_order_release);
+            cancelled_.store(true, std::memory_order_release);
+            callbacks.swap(callbacks_);
+        }
+        // Ngoài khóa: callback có thể gọi PC/SC hoặc khóa của nơi khác.
+        for (auto& entry : callbacks) entry.second();
+    }
+
+    void CancellationToken::SetDeadline(Clock::time_point deadline) {
+        deadline_ = deadline;
+        has_deadline_ = true;
+    }
+
+    void CancellationToken::ThrowIfCancelled() {
+        if (!IsCancelled() && has_deadline_ && Clock::now() >= deadline_) Cancel(true);
+        if (!IsCancelled()) return;
+        std::string name = request_id_.empty() ? "Request" : "Request " + request_id_;
+        if (IsDeadlineExceeded()) throw OperationCancelled(name + " exceeded its deadline.", true);
+        throw OperationCancelled(name + " was cancelled.", false);
+    }
+
+    uint64_t CancellationToken::OnCancel(std::function<void()> callback) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!cancelled_.load(std::memory_order_relaxed)) {
+                uint64_t id = next_callback_id_++;
+                callbacks_.emplace(id, std::move(callback));
+                return id;
+            }
+        }
+        callback();
+        return 0;
+    }
+
+    void CancellationToken::RemoveCallback(uint64_t id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callbacks_.erase(id);
+    }
+
+    CancellationToken* CurrentCancellation() {
+        return current_token;
+    }
+
+    void ThrowIfCancelled() {
+        if (current_token) current_token->ThrowIfCancelled();
+    }
+
+    CancellationScope::CancellationScope(std::shared_ptr<CancellationToken> token)
+            : token_(std::move(token)), previous_(current_token) {
+        current_token = token_.get();
+    }
+
+    CancellationScope::~CancellationScope() {
+        current_token = previous_;
+    }
+
+    RequestCancellation::RequestCancellation(const std::string& requestId, int64_t deadlineMs)
+            : token_(CancellationRegistry::Instance().Register(requestId, deadlineMs)), scope_(token_) {}
+
+    RequestCancellation::RequestCancellation(std::shared_ptr<CancellationToken> token)
+            : token_(std::move(token)), scope_(token_) {}
+
+    RequestCancellation::~RequestCancellation() {
+        CancellationRegistry::Instance().Unregister(token_);
+    }
+
+    bool RequestCancellation::IsCancellable() const {
+        return !token_->GetRequestId().empty() || token_->HasDeadline();
+    }
+
+    CancellationRegistry& CancellationRegistry::Instance() {
+        // Không hủy khi thoát tiến trình: luồng canh deadline có thể vẫn đang chờ.
+        static CancellationRegistry* instance = new CancellationRegistry();
+        return *instance;
+    }
+
+    std::shared_ptr<CancellationToken> CancellationRegistry::Register(const std::string& requestId, int64_t deadlineMs) {
+        auto token = std::make_shared<CancellationToken>(requestId);
+        if (requestId.empty() && deadlineMs <= 0) return token;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!requestId.empty()) by_id_[requestId] = token;
+        if (deadlineMs > 0) {
+            token->SetDeadline(CancellationToken::Clock::now() + std::chrono::milliseconds(deadlineMs));
+            deadlines_.emplace(token->GetDeadline(), token);
+            if (!watching_) {
+                watching_ = true;
+                std::thread([this]() { WatchDeadlines(); }).detach();
+            }
+            changed_.notify_all();
+        }
+        return token;
+    }
+
+    void CancellationRegistry::Unregister(const std::shared_ptr<CancellationToken>& token) {
+        if (!token || (token->GetRequestId().empty() && !token->HasDeadline())) return;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = by_id_.find(token->GetRequestId());
+        if (it != by_id_.end() && it->second.lock() == token) by_id_.erase(it);
+        if (token->HasDeadline()) {
+            auto range = deadlines_.equal_range(token->GetDeadline());
+            for (auto entry = range.first; entry != range.second; ++entry) {
+                if (entry->second.lock() == token) {
+                    deadlines_.erase(entry);
+                    break;
+                }
+            }
+        }
+    }
+
+    bool CancellationRegistry::Cancel(const std::string& requestId) {
+        std::shared_ptr<CancellationToken> token;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = by_id_.find(requestId);
+            if (it != by_id_.end()) token = it->second.lock();
+        }
+        if (!token) return false;
+        token->Cancel();
+        return true;
+    }
+
+    void CancellationRegistry::WatchDeadlines() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            if (deadlines_.empty()) {
+                changed_.wait(lock);
+                continue;
+            }
+            auto next = deadlines_.begin()->first;
+            if (CancellationToken::Clock::now() < next) {
+                changed_.wait_until(lock, next);
+                continue;
+            }
+
+            std::vector<std::shared_ptr<CancellationToken>> expired;
+            auto now = CancellationToken::Clock::now();
+            while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+                if (auto token = deadlines_.begin()->second.lock()) expired.push_back(std::move(token));
+                deadlines_.erase(deadlines_.begin());
+            }
+            lock.unlock();
+            for (auto& token : expired) token->Cancel(true);
+            lock.lock();
+        }
+    }
+
+}  // namespace nfcsigner
@@ -0,0 +1,158 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_CANCELLATION_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_CANCELLATION_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace nfcsigner {
+
+    // Request bị hủy (cancel) hoặc hết hạn (deadline).
+    class OperationCancelled : public std::runtime_error {
+    public:
+        OperationCancelled(const std::string& message, bool deadlineExceeded)
+                : std::runtime_error(message), deadline_exceeded_(deadlineExceeded) {}
+
+        bool IsDeadlineExceeded() const { return deadline_exceeded_; }
+
+    private:
+        bool deadline_exceeded_;
+    };
+
+    // Trạng thái hủy của một request. Các thao tác dài kiểm tra token giữa
+    // các APDU và giữa các bước PDF; thao tác đang chờ (hàng đợi reader, lệnh
+    // PC/SC chờ thẻ) được đánh thức qua callback đăng ký bằng OnCancel.
+    class CancellationToken {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit CancellationToken(std::string requestId = std::string()) : request_id_(std::move(requestId)) {}
+
+        CancellationToken(const CancellationToken&) = delete;
+        CancellationToken& operator=(const CancellationToken&) = delete;
+
+        const std::string& GetRequestId() const { return request_id_; }
+
+        // Gọi được nhiều lần, từ luồng bất kỳ; chỉ lần đầu có tác dụng.
+        void Cancel(bool deadlineExceeded = false);
+        bool IsCancelled() const { return cancelled_.load(std::memory_order_acquire); }
+        bool IsDeadlineExceeded() const { return deadline_exceeded_.load(std::memory_order_acquire); }
+
+        void SetDeadline(Clock::time_point deadline);
+        bool HasDeadline() const { return has_deadline_; }
+        Clock::time_point GetDeadline() const { return deadline_; }
+
+        // Ném OperationCancelled nếu đã hủy hoặc đã quá deadline.
+        void ThrowIfCancelled();
+
+        // [callback] chạy khi hủy (ngay lập tức nếu đã hủy). Trả về id để gỡ.
+        uint64_t OnCancel(std::function<void()> callback);
+        void RemoveCallback(uint64_t id);
+
+    private:
+        std::string request_id_;
+        std::atomic<bool> cancelled_{false};
+        std::atomic<bool> deadline_exceeded_{false};
+        bool has_deadline_ = false;
+        Clock::time_point deadline_;
+
+        std::mutex mutex_;
+        std::map<uint64_t, std::function<void()>> callbacks_;
+        uint64_t next_callback_id_ = 1;
+    };
+
+    // Token của request đang chạy trên luồng hiện tại (nullptr nếu không có).
+    CancellationToken* CurrentCancellation();
+
+    // Kiểm tra token của luồng hiện tại; không có token thì không làm gì.
+    void ThrowIfCancelled();
+
+    // Đặt token hiện tại cho luồng trong phạm vi của đối tượng.
+    class CancellationScope {
+    public:
+        explicit CancellationScope(std::shared_ptr<CancellationToken> token);
+        ~CancellationScope();
+
+        CancellationScope(const CancellationScope&) = delete;
+        CancellationScope& operator=(const CancellationScope&) = delete;
+
+    private:
+        std::shared_ptr<CancellationToken> token_;
+        CancellationToken* previous_;
+    };
+
+    // Gỡ callback khi ra khỏi phạm vi.
+    class CancelCallbackGuard {
+    public:
+        CancelCallbackGuard(CancellationToken* token, std::function<void()> callback)
+                : token_(token), id_(token ? token->OnCancel(std::move(callback)) : 0) {}
+        ~CancelCallbackGuard() {
+            if (token_) token_->RemoveCallback(id_);
+        }
+
+        CancelCallbackGuard(const CancelCallbackGuard&) = delete;
+        CancelCallbackGuard& operator=(const CancelCallbackGuard&) = delete;
+
+    private:
+        CancellationToken* token_;
+        uint64_t id_;
+    };
+
+    // Token của một request từ Flutter: đăng ký theo requestId/deadline, đặt
+    // làm token hiện tại của luồng và gỡ đăng ký khi ra khỏi phạm vi.
+    class RequestCancellation {
+    public:
+        RequestCancellation(const std::string& requestId, int64_t deadlineMs);
+        // Nhận token đã đăng ký lúc request được nhận (CancellationRegistry::Register)
+        // trên luồng khác, để cancel() có tác dụng cả khi request còn chờ worker.
+        explicit RequestCancellation(std::shared_ptr<CancellationToken> token);
+        ~RequestCancellation();
+
+        RequestCancellation(const RequestCancellation&) = delete;
+        RequestCancellation& operator=(const RequestCancellation&) = delete;
+
+        // Request có requestId hoặc deadline (hủy được).
+        bool IsCancellable() const;
+        const std::shared_ptr<CancellationToken>& GetToken() const { return token_; }
+
+    private:
+        std::shared_ptr<CancellationToken> token_;
+        CancellationScope scope_;
+    };
+
+    // Token theo requestId cho cancel(requestId), và luồng canh deadline hủy
+    // token khi hết hạn để các lệnh đang chờ được đánh thức.
+    class CancellationRegistry {
+    public:
+        static CancellationRegistry& Instance();
+
+        // [requestId] rỗng: chỉ áp dụng deadline. [deadlineMs] <= 0: không có deadline.
+        std::shared_ptr<CancellationToken> Register(const std::string& requestId, int64_t deadlineMs);
+        void Unregister(const std::shared_ptr<CancellationToken>& token);
+
+        // Trả về false nếu không có request nào đang chạy với [requestId].
+        bool Cancel(const std::string& requestId);
+
+    private:
+        CancellationRegistry() = default;
+
+        void WatchDeadlines();
+
+        std::mutex mutex_;
+        std::condition_variable changed_;
+        std::unordered_map<std::string, std::weak_ptr<CancellationToken>> by_id_;
+        std::multimap<CancellationToken::Clock::time_point, std::weak_ptr<CancellationToken>> deadlines_;
+        bool watching_ = false;
+    };
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_CANCELLATION_H_
@@ -0,0 +1,64 @@
+#include "card_apdu.h"
+
+#include <stdexcept>
+
+namespace nfcsigner {
+
+    std::vector<uint8_t> HexToBytes(const std::string& hex) {
+        return DecodeHex(hex);
+    }
+
+    std::vector<uint8_t> CreateSelectAppletCommand(const std::string& appletID) {
+        auto appletID_bytes = HexToBytes(appletID);
+        std::vector<uint8_t> cmd = { 0x00, 0xA4, 0x04, 0x00, (uint8_t)appletID_bytes.size() };
+        cmd.insert(cmd.end(), appletID_bytes.begin(), appletID_bytes.end());
+        cmd.push_back(0x00);
+        return cmd;
+    }
+
+    std::vector<uint8_t> CreateVerifyPinCommand(const std::string& pin) {
+        std::vector<uint8_t> pin_bytes(pin.begin(), pin.end());
+        std::vector<uint8_t> cmd = { 0x00, 0x20, 0x00, 0x81, (uint8_t)pin_bytes.size() };
+        cmd.insert(cmd.end(), pin_bytes.begin(), pin_bytes.end());
+        return cmd;
+    }
+
+    std::vector<uint8_t> CreateComputeSignatureCommand(const std::vector<uint8_t>& data, int keyIndex) {
+        uint8_t p1 = 0x9E;
+        uint8_t p2;
+        switch (keyIndex) {
+            case 1: p2 = 0x9B; break;
+            case 2: p2 = 0x9C; break;
+            default: p2 = 0x9A; break;
+        }
+        std::vector<uint8_t> cmd = { 0x00, 0x2A, p1, p2, (uint8_t)data.size() };
+        cmd.insert(cmd.end(), data.begin(), data.end());
+        cmd.push_back(0x00);
+        return cmd;
+    }
+
+    std::vector<uint8_t> CreateSelectCertificateCommand() {
+        std::vector<uint8_t> data = { 0x60, 0x04, 0x5C, 0x02, 0x7F, 0x21 };
+        std::vector<uint8_t> cmd = { 0x00, 0xA5, 0x02, 0x04, (uint8_t)data.size() };
+        cmd.insert(cmd.end(), data.begin(), data.end());
+        cmd.push_back(0x00);
+        return cmd;
+    }
+    std::vector<uint8_t> CreateGetRsaPublicKeyCommand(const std::string& keyRole) {
+        std::vector<uint8_t> data;
+        if (keyRole == "sig") data = { 0xB6, 0x00 };
+        else if (keyRole == "dec") data = { 0xB8, 0x00 };
+        else if (keyRole == "aut") data = { 0xA4, 0x00 };
+        else if (keyRole == "sm") data = { 0xA6, 0x00 };
+        else throw std::runtime_error("Invalid key role.");
+
+        std::vector<uint8_t> cmd = { 0x00, 0x47, 0x81, 0x00, (uint8_t)data.size() };
+        cmd.insert(cmd.end(), data.begin(), data.end());
+        cmd.push_back(0x00);
+        return cmd;
+    }
+    std::vector<uint8_t> CreateGetCertificateCommand() {
+        return { 0x00, 0xCA, 0x7F, 0x21, 0x00 };
+    }
+
+}  // namespace nfcsigner
@@ -0,0 +1,31 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_CARD_APDU_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_CARD_APDU_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "byte_codec.h"
+
+namespace nfcsigner {
+
+    // Chuỗi hex (không dấu cách, độ dài chẵn) sang bytes.
+    std::vector<uint8_t> HexToBytes(const std::string& hex);
+
+    // Bytes liên tục (vector, string, array) sang hex chữ thường.
+    template<typename T>
+    std::string ToHexString(const T& data) {
+        return EncodeHex(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    }
+
+    // Các lệnh APDU của applet OpenPGP trên thẻ.
+    std::vector<uint8_t> CreateSelectAppletCommand(const std::string& appletID);
+    std::vector<uint8_t> CreateVerifyPinCommand(const std::string& pin);
+    std::vector<uint8_t> CreateComputeSignatureCommand(const std::vector<uint8_t>& data, int keyIndex);
+    std::vector<uint8_t> CreateSelectCertificateCommand();
+    std::vector<uint8_t> CreateGetRsaPublicKeyCommand(const std::string& keyRole);
+    std::vector<uint8_t> CreateGetCertificateCommand();
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_CARD_APDU_H_
@@ -0,0 +1,346 @@
+#include "card_coroutine.h"
+
+#ifdef NFCSIGNER_HAVE_COROUTINES
+
+#include "card_apdu.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nfcsigner {
+
+    namespace {
+
+        // SW1/SW2 = 90 00
+        bool IsSuccess(const std::vector<uint8_t>& response) {
+            return response.size() >= 2 && response[response.size() - 2] == 0x90 && response.back() == 0x00;
+        }
+
+        std::vector<uint8_t> WithoutStatusWord(const std::vector<uint8_t>& response) {
+            return std::vector<uint8_t>(response.begin(), response.end() - 2);
+        }
+
+        CardTask<void> SelectApplet(AsyncCardReader& reader, const std::string& appletID) {
+            auto select_resp = co_await reader.Transmit(CreateSelectAppletCommand(appletID));
+            if (!IsSuccess(select_resp)) throw std::runtime_error("Select Applet failed.");
+        }
+
+        SCARDCONTEXT EstablishContext() {
+            SCARDCONTEXT hContext = 0;
+            LONG lReturn = SCardEstablishContext(SCARD_SCOPE_USER, NULL, NULL, &hContext);
+            if (lReturn != SCARD_S_SUCCESS) {
+                throw std::runtime_error("SCardEstablishContext failed: " + std::to_string(lReturn));
+            }
+            return hContext;
+        }
+
+        // Chạy [body] giữa BeginTransaction và EndTransaction([disposition]);
+        // body lỗi thì vẫn nhả thẻ (và lượt của CardScheduler) rồi ném lại lỗi.
+        template<typename T>
+        CardTask<T> InTransaction(AsyncCardReader& reader, AsyncCardRequest request, DWORD disposition,
+                                  CardTask<T> body) {
+            co_await reader.BeginTransaction(std::move(request));
+            std::optional<T> result;
+            std::exception_ptr error;
+            try {
+                result.emplace(co_await std::move(body));
+            } catch (...) {
+                error = std::current_exception();
+            }
+            co_await reader.EndTransaction(disposition);
+            if (error) std::rethrow_exception(error);
+            co_return std::move(*result);
+        }
+
+        CardTask<std::vector<uint8_t>> ReadCertificate(AsyncCardReader& reader, std::string appletID) {
+            co_await SelectApplet(reader, appletID);
+
+            auto select_cert_resp = co_await reader.Transmit(CreateSelectCertificateCommand());
+            if (!IsSuccess(select_cert_resp)) throw std::runtime_error("Select Certificate data object failed.");
+            auto cert_resp = co_await reader.Transmit(CreateGetCertificateCommand());
+            if (!IsSuccess(cert_resp) || cert_resp.size() < 3) throw std::runtime_error("Get Certificate failed.");
+            co_return WithoutStatusWord(cert_resp);
+        }
+
+        CardTask<std::vector<uint8_t>> ReadRsaPublicKey(AsyncCardReader& reader, std::string appletID,
+                                                        std::string keyRole) {
+            co_await SelectApplet(reader, appletID);
+
+            auto key_resp = co_await reader.Transmit(CreateGetRsaPublicKeyCommand(keyRole));
+            if (!IsSuccess(key_resp)) throw std::runtime_error("Get Public Key failed.");
+            co_return WithoutStatusWord(key_resp);
+        }
+
+        CardTask<std::vector<uint8_t>> Sign(AsyncCardReader& reader, std::string appletID, std::string pin,
+                                            std::vector<uint8_t> data, int keyIndex) {
+            co_await SelectApplet(reader, appletID);
+
+            auto verify_resp = co_await reader.Transmit(CreateVerifyPinCommand(pin));
+            if (!IsSuccess(verify_resp)) throw std::runtime_error("Verify PIN failed.");
+            auto sign_resp = co_await reader.Transmit(CreateComputeSignatureCommand(data, keyIndex));
+            if (!IsSuccess(sign_resp)) throw std::runtime_error("Compute signature failed on card.");
+            co_return WithoutStatusWord(sign_resp);
+        }
+
+        CardTask<std::vector<std::vector<uint8_t>>> RunApduScript(AsyncCardReader& reader,
+                                                                  std::vector<std::vector<uint8_t>> script) {
+            std::vector<std::vector<uint8_t>> responses;
+            responses.reserve(script.size());
+            for (const auto& command : script) {
+                responses.push_back(co_await reader.Transmit(command));
+                if (!IsSuccess(responses.back())) break;
+            }
+            co_return responses;
+        }
+
+    }  // namespace
+
+    // === CardEventLoop ===
+
+    CardEventLoop::CardEventLoop(size_t ioThreads) {
+        if (ioThreads == 0) ioThreads = 1;
+        loop_thread_ = std::thread([this]() { RunLoop(); });
+        for (size_t i = 0; i < ioThreads; ++i) io_threads_.emplace_back([this]() { RunIo(); });
+    }
+
+    CardEventLoop::~CardEventLoop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        loop_cv_.notify_all();
+        io_cv_.notify_all();
+        for (auto& thread : io_threads_) thread.join();
+        loop_thread_.join();
+    }
+
+    void CardEventLoop::Post(std::coroutine_handle<> handle) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_.push_back(handle);
+        }
+        loop_cv_.notify_one();
+    }
+
+    void CardEventLoop::AddTimer(Clock::time_point deadline, std::coroutine_handle<> handle) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            timers_.push(Timer{ deadline, next_timer_sequence_++, handle });
+        }
+        loop_cv_.notify_one();
+    }
+
+    void CardEventLoop::PostIo(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            io_jobs_.push_back(std::move(job));
+        }
+        io_cv_.notify_one();
+    }
+
+    void CardEventLoop::RunLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            // Hẹn giờ đã tới hạn vào hàng đợi resume theo thứ tự deadline.
+            Clock::time_point now = Clock::now();
+            while (!timers_.empty() && timers_.top().deadline <= now) {
+                ready_.push_back(timers_.top().handle);
+                timers_.pop();
+            }
+
+            if (!ready_.empty()) {
+                std::coroutine_handle<> handle = ready_.front();
+                ready_.pop_front();
+                lock.unlock();
+                handle.resume();
+                lock.lock();
+                continue;
+            }
+
+            if (stopping_) return;
+            if (timers_.empty()) {
+                loop_cv_.wait(lock);
+            } else {
+                loop_cv_.wait_until(lock, timers_.top().deadline);
+            }
+        }
+    }
+
+    void CardEventLoop::RunIo() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            io_cv_.wait(lock, [this]() { return stopping_ || !io_jobs_.empty(); });
+            if (io_jobs_.empty()) return;
+            std::function<void()> job = std::move(io_jobs_.front());
+            io_jobs_.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+    // === AsyncCardReader ===
+
+    AsyncCardReader::AsyncCardReader(CardEventLoop& loop, std::string readerName)
+        : loop_(loop), reader_name_(std::move(readerName)) {}
+
+    AsyncCardReader::~AsyncCardReader() {
+        // Transaction đã kết thúc (SignAsync reset thẻ khi nhả): chỉ đóng kết nối.
+        transaction_.reset();
+        cancel_waits_.reset();
+        DisconnectCard(hContext_, hCard_, SCARD_LEAVE_CARD);
+    }
+
+    std::string AsyncCardReader::ReaderName() const {
+        std::lock_guard<std::mutex> lock(name_mutex_);
+        return reader_name_;
+    }
+
+    std::string AsyncCardReader::ResolveReaderName(SCARDCONTEXT hContext) {
+        {
+            std::lock_guard<std::mutex> lock(name_mutex_);
+            if (!reader_name_.empty()) return reader_name_;
+        }
+        // Liệt kê ngoài khóa; WaitForCard và transaction có thể cùng chọn,
+        // lần ghi đầu tiên thắng.
+        std::vector<std::string> readers = ListReaderNames(hContext);
+        if (readers.empty()) throw std::runtime_error("No card reader found.");
+        std::lock_guard<std::mutex> lock(name_mutex_);
+        if (reader_name_.empty()) reader_name_ = readers.front();
+        return reader_name_;
+    }
+
+    void AsyncCardReader::ReleaseTicket() {
+        cancel_waits_.reset();
+        cancellation_.reset();
+        ticket_ = CardScheduler::Ticket();
+    }
+
+    CardTask<void> AsyncCardReader::BeginTransaction(AsyncCardRequest request) {
+        // Lượt của CardScheduler là độc quyền: khi được cấp, transaction
+        // trước trên reader này đã trả lượt.
+        ticket_ = co_await loop_.AcquireCard(request.priority, request.cancellation);
+        cancellation_ = std::move(request.cancellation);
+        try {
+            co_await loop_.RunBlocking([this]() {
+                CancellationScope scope(cancellation_);
+                ThrowIfCancelled();
+                try {
+                    if (!hContext_) hContext_ = EstablishContext();
+                    if (!hCard_) ConnectReader(hContext_, ResolveReaderName(hContext_), hCard_);
+                    transaction_ = std::make_unique<CardTransaction>(hCard_);
+                } catch (...) {
+                    DisconnectCard(hContext_, hCard_, SCARD_LEAVE_CARD);
+                    throw;
+                }
+                // Hủy request đánh thức lệnh PC/SC đang chờ trên context này.
+                SCARDCONTEXT hContext = hContext_;
+                cancel_waits_ = std::make_unique<CancelCallbackGuard>(cancellation_.get(),
+                                                                      [hContext]() { SCardCancel(hContext); });
+            });
+        } catch (...) {
+            ReleaseTicket();
+            throw;
+        }
+    }
+
+    CardTask<std::vector<uint8_t>> AsyncCardReader::Transmit(std::vector<uint8_t> command) {
+        co_return co_await loop_.RunBlocking([this, &command]() {
+            if (!transaction_) throw std::logic_error("AsyncCardReader::Transmit needs an active transaction.");
+            CancellationScope scope(cancellation_);
+            try {
+                return TransmitAndGetResponse(hCard_, command);
+            } catch (const OperationCancelled&) {
+                throw;
+            } catch (...) {
+                // Không phục hồi được (CardRecoveryPolicy): thẻ có thể đã bị
+                // rút, transaction sau kết nối lại từ đầu.
+                transaction_.reset();
+                DisconnectCard(hContext_, hCard_, SCARD_RESET_CARD);
+                throw;
+            }
+        });
+    }
+
+    CardTask<void> AsyncCardReader::EndTransaction(DWORD disposition) {
+        std::exception_ptr error;
+        // Transmit lỗi đã ngắt kết nối (và bỏ transaction): chỉ còn trả lượt.
+        if (transaction_) {
+            try {
+                co_await loop_.RunBlocking([this, disposition]() {
+                    transaction_->End(disposition);
+                    transaction_.reset();
+                });
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }
+        ReleaseTicket();
+        if (error) std::rethrow_exception(error);
+    }
+
+    CardTask<bool> AsyncCardReader::WaitForCard(std::chrono::milliseconds timeout,
+                                                std::shared_ptr<CancellationToken> cancellation) {
+        if (cancellation && cancellation->HasDeadline()) {
+            // Làm tròn lên: hết thời gian chờ thì deadline chắc chắn đã qua.
+            auto left = std::chrono::ceil<std::chrono::milliseconds>(cancellation->GetDeadline() -
+                                                                     CancellationToken::Clock::now());
+            timeout = std::max(std::chrono::milliseconds(0), std::min(timeout, left));
+        }
+        auto wait = [this, timeout, cancellation]() {
+            // Context riêng cho mỗi lần chờ: không đụng kết nối của transaction
+            // đang chạy, và SCardCancel chỉ đánh thức lần chờ này.
+            SCARDCONTEXT hContext = EstablishContext();
+            SCARDHANDLE noCard = 0;
+            bool present = false;
+            try {
+                std::string readerName = ResolveReaderName(hContext);
+                CancelCallbackGuard cancelWait(cancellation.get(), [hContext]() { SCardCancel(hContext); });
+                if (cancellation) cancellation->ThrowIfCancelled();
+                present = WaitForCardPresent(hContext, readerName, (DWORD)timeout.count());
+                if (!present && cancellation) cancellation->ThrowIfCancelled();
+            } catch (...) {
+                DisconnectCard(hContext, noCard, SCARD_LEAVE_CARD);
+                throw;
+            }
+            DisconnectCard(hContext, noCard, SCARD_LEAVE_CARD);
+            return present;
+        };
+        co_return co_await loop_.RunBlocking(std::move(wait));
+    }
+
+    CardTask<void> AsyncCardReader::Disconnect(AsyncCardRequest request) {
+        CardScheduler::Ticket ticket = co_await loop_.AcquireCard(request.priority, request.cancellation);
+        co_await loop_.RunBlocking([this]() { DisconnectCard(hContext_, hCard_, SCARD_RESET_CARD); });
+    }
+
+    // === Hội thoại APDU ===
+
+    CardTask<std::vector<uint8_t>> ReadCertificateAsync(AsyncCardReader& reader, std::string appletID,
+                                                        AsyncCardRequest request) {
+        return InTransaction(reader, std::move(request), SCARD_LEAVE_CARD,
+                             ReadCertificate(reader, std::move(appletID)));
+    }
+
+    CardTask<std::vector<uint8_t>> ReadRsaPublicKeyAsync(AsyncCardReader& reader, std::string appletID,
+                                                         std::string keyRole, AsyncCardRequest request) {
+        return InTransaction(reader, std::move(request), SCARD_LEAVE_CARD,
+                             ReadRsaPublicKey(reader, std::move(appletID), std::move(keyRole)));
+    }
+
+    CardTask<std::vector<uint8_t>> SignAsync(AsyncCardReader& reader, std::string appletID, std::string pin,
+                                             std::vector<uint8_t> data, int keyIndex, AsyncCardRequest request) {
+        // Reader dùng chung giữa các request: không để lại trạng thái đã VERIFY.
+        return InTransaction(reader, std::move(request), SCARD_RESET_CARD,
+                             Sign(reader, std::move(appletID), std::move(pin), std::move(data), keyIndex));
+    }
+
+    CardTask<std::vector<std::vector<uint8_t>>> RunApduScriptAsync(AsyncCardReader& reader,
+                                                                   std::vector<std::vector<uint8_t>> script,
+                                                                   AsyncCardRequest request) {
+        return InTransaction(reader, std::move(request), SCARD_LEAVE_CARD, RunApduScript(reader, std::move(script)));
+    }
+
+}  // namespace nfcsigner
+
+#endif  // NFCSIGNER_HAVE_COROUTINES
@@ -0,0 +1,408 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_CARD_COROUTINE_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_CARD_COROUTINE_H_
+
+// API coroutine (C++20) cho hội thoại APDU: SELECT -> VERIFY -> SIGN, đọc
+// chứng thư, script APDU viết thành coroutine trên transport awaitable thay
+// vì lambda chặn giữ một luồng suốt cả hội thoại. Một CardEventLoop chạy mọi
+// coroutine trên một luồng; lệnh PC/SC chặn (SCardTransmit,
+// SCardGetStatusChange) chạy trên vài luồng I/O dùng chung cho mọi reader.
+// Lượt dùng reader lấy từ CardScheduler như các thao tác chặn của plugin, và
+// lệnh PC/SC của một hội thoại chạy với token hủy của request.
+//
+// Lõi vẫn build với C++17 (plugin Flutter): phần này chỉ có khi trình biên
+// dịch hỗ trợ coroutine, bật bằng -DNFCSIGNER_ENABLE_COROUTINES=ON.
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+#define NFCSIGNER_HAVE_COROUTINES 1
+#endif
+
+#ifdef NFCSIGNER_HAVE_COROUTINES
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "cancellation.h"
+#include "card_scheduler.h"
+#include "pcsc_card.h"
+
+namespace nfcsigner {
+
+    template<typename T = void>
+    class CardTask;
+
+    namespace detail {
+
+        // Kết thúc coroutine con thì chuyển thẳng sang coroutine đang chờ nó
+        // (symmetric transfer): chuỗi co_await dài không làm tràn stack.
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            template<typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                std::coroutine_handle<> continuation = handle.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        struct PromiseBase {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr exception;
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+            void unhandled_exception() { exception = std::current_exception(); }
+        };
+
+        template<typename T>
+        struct Promise : PromiseBase {
+            std::optional<T> value;
+
+            CardTask<T> get_return_object();
+            template<typename U>
+            void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+            T TakeResult() {
+                if (exception) std::rethrow_exception(exception);
+                return std::move(*value);
+            }
+        };
+
+        template<>
+        struct Promise<void> : PromiseBase {
+            CardTask<void> get_return_object();
+            void return_void() const noexcept {}
+
+            void TakeResult() {
+                if (exception) std::rethrow_exception(exception);
+            }
+        };
+
+        // Coroutine gốc do CardEventLoop::Spawn tạo: tự hủy khi chạy xong.
+        struct DetachedTask {
+            struct promise_type {
+                DetachedTask get_return_object() { return { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+                std::suspend_always initial_suspend() const noexcept { return {}; }
+                std::suspend_never final_suspend() const noexcept { return {}; }
+                void return_void() const noexcept {}
+                void unhandled_exception() { std::terminate(); }
+            };
+            std::coroutine_handle<promise_type> handle;
+        };
+
+    }  // namespace detail
+
+    // Coroutine lười: chỉ chạy khi được co_await (hoặc CardEventLoop::Spawn).
+    // Ngoại lệ trong coroutine được ném lại ở nơi co_await.
+    template<typename T>
+    class [[nodiscard]] CardTask {
+    public:
+        using promise_type = detail::Promise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        explicit CardTask(Handle handle) : handle_(handle) {}
+        CardTask(CardTask&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+        CardTask& operator=(CardTask&& other) noexcept {
+            if (this != &other) {
+                if (handle_) handle_.destroy();
+                handle_ = std::exchange(other.handle_, {});
+            }
+            return *this;
+        }
+        ~CardTask() {
+            if (handle_) handle_.destroy();
+        }
+
+        CardTask(const CardTask&) = delete;
+        CardTask& operator=(const CardTask&) = delete;
+
+        auto operator co_await() && noexcept {
+            struct Awaiter {
+                Handle handle;
+                bool await_ready() const noexcept { return !handle || handle.done(); }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                    handle.promise().continuation = awaiting;
+                    return handle;
+                }
+                T await_resume() { return handle.promise().TakeResult(); }
+            };
+            return Awaiter{ handle_ };
+        }
+
+    private:
+        Handle handle_;
+    };
+
+    namespace detail {
+
+        template<typename T>
+        CardTask<T> Promise<T>::get_return_object() {
+            return CardTask<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+        }
+
+        inline CardTask<void> Promise<void>::get_return_object() {
+            return CardTask<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+        }
+
+    }  // namespace detail
+
+    // Vòng lặp sự kiện: một luồng resume coroutine và xử lý hẹn giờ, [ioThreads]
+    // luồng chạy lệnh PC/SC chặn. Số luồng không tăng theo số reader hay số
+    // request đang chờ. Chờ các future của Spawn xong trước khi hủy loop:
+    // coroutine còn treo lúc hủy không được resume nữa.
+    class CardEventLoop {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit CardEventLoop(size_t ioThreads = 2);
+        ~CardEventLoop();
+
+        CardEventLoop(const CardEventLoop&) = delete;
+        CardEventLoop& operator=(const CardEventLoop&) = delete;
+
+        // Chạy [task] trên loop; kết quả (hoặc ngoại lệ) trả qua future.
+        template<typename T>
+        std::future<T> Spawn(CardTask<T> task) {
+            auto result = std::make_shared<std::promise<T>>();
+            std::future<T> future = result->get_future();
+            Post(RunDetached(std::move(task), std::move(result)).handle);
+            return future;
+        }
+
+        // Đưa [handle] vào hàng đợi resume của luồng loop.
+        void Post(std::coroutine_handle<> handle);
+
+        // co_await loop.Sleep(d): tiếp tục trên luồng loop sau [duration].
+        auto Sleep(std::chrono::milliseconds duration) {
+            struct Awaiter {
+                CardEventLoop* loop;
+                Clock::time_point deadline;
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle) { loop->AddTimer(deadline, handle); }
+                void await_resume() const noexcept {}
+            };
+            return Awaiter{ this, Clock::now() + duration };
+        }
+
+        // co_await loop.RunBlocking(f): chạy f() trên luồng I/O rồi tiếp tục
+        // trên luồng loop với kết quả của f (ngoại lệ được ném lại).
+        // Lambda bắt biến có hàm hủy (shared_ptr, string...) phải đặt tên rồi
+        // std::move vào đây: GCC 12 hủy hai lần lambda tạm trong biểu thức
+        // co_await.
+        template<typename Func>
+        auto RunBlocking(Func work) {
+            using Result = std::invoke_result_t<Func&>;
+            using Stored = std::conditional_t<std::is_void_v<Result>, std::monostate, Result>;
+            struct Awaiter {
+                CardEventLoop* loop;
+                Func work;
+                std::optional<Stored> result;
+                std::exception_ptr exception;
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle) {
+                    loop->PostIo([this, handle, loop = loop]() {
+                        try {
+                            if constexpr (std::is_void_v<Result>) {
+                                work();
+                                result.emplace();
+                            } else {
+                                result.emplace(work());
+                            }
+                        } catch (...) {
+                            exception = std::current_exception();
+                        }
+                        // Sau Post, coroutine có thể đã chạy tiếp và hủy awaiter này.
+                        loop->Post(handle);
+                    });
+                }
+                Result await_resume() {
+                    if (exception) std::rethrow_exception(exception);
+                    if constexpr (!std::is_void_v<Result>) return std::move(*result);
+                }
+            };
+            return Awaiter{ this, std::move(work), std::nullopt, nullptr };
+        }
+
+        // co_await loop.AcquireCard(priority, token): chờ lượt dùng reader của
+        // CardScheduler mà không giữ luồng nào, rồi tiếp tục trên luồng loop
+        // với Ticket. Ném CardBusyError nếu hàng đợi của [priority] đầy,
+        // OperationCancelled nếu [cancellation] bị hủy trong lúc chờ.
+        auto AcquireCard(CardPriority priority, const std::shared_ptr<CancellationToken>& cancellation) {
+            struct Awaiter {
+                CardEventLoop* loop;
+                CardPriority priority;
+                std::shared_ptr<CancellationToken> cancellation;
+                CardScheduler::Ticket ticket;
+                std::exception_ptr error;
+
+                bool await_ready() const noexcept { return false; }
+                void await_suspend(std::coroutine_handle<> handle) {
+                    CardScheduler::Instance().AcquireAsync(
+                            priority, cancellation,
+                            [this, handle](CardScheduler::Ticket granted, std::exception_ptr failure) {
+                                ticket = std::move(granted);
+                                error = failure;
+                                // Sau Post, coroutine có thể đã chạy tiếp và hủy awaiter này.
+                                loop->Post(handle);
+                            });
+                }
+                CardScheduler::Ticket await_resume() {
+                    if (error) std::rethrow_exception(error);
+                    if (!ticket) throw CardBusyError(priority);
+                    return std::move(ticket);
+                }
+            };
+            return Awaiter{ this, priority, cancellation, CardScheduler::Ticket(), nullptr };
+        }
+
+    private:
+        struct Timer {
+            Clock::time_point deadline;
+            uint64_t sequence;
+            std::coroutine_handle<> handle;
+            bool operator>(const Timer& other) const {
+                return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+            }
+        };
+
+        template<typename T>
+        static detail::DetachedTask RunDetached(CardTask<T> task, std::shared_ptr<std::promise<T>> result) {
+            try {
+                if constexpr (std::is_void_v<T>) {
+                    co_await std::move(task);
+                    result->set_value();
+                } else {
+                    result->set_value(co_await std::move(task));
+                }
+            } catch (...) {
+                result->set_exception(std::current_exception());
+            }
+        }
+
+        void AddTimer(Clock::time_point deadline, std::coroutine_handle<> handle);
+        void PostIo(std::function<void()> job);
+        void RunLoop();
+        void RunIo();
+
+        std::mutex mutex_;
+        std::condition_variable loop_cv_;
+        std::condition_variable io_cv_;
+        std::deque<std::coroutine_handle<>> ready_;
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+        std::deque<std::function<void()>> io_jobs_;
+        uint64_t next_timer_sequence_ = 0;
+        bool stopping_ = false;
+        std::thread loop_thread_;
+        std::vector<std::thread> io_threads_;
+    };
+
+    // Lớp ưu tiên trong CardScheduler và token hủy (nullptr: không hủy
+    // được) của một hội thoại APDU.
+    struct AsyncCardRequest {
+        CardPriority priority = CardPriority::Interactive;
+        std::shared_ptr<CancellationToken> cancellation;
+    };
+
+    // Transport awaitable của một reader. Mỗi lệnh PC/SC chạy trên luồng I/O
+    // của loop. Hội thoại nhiều APDU nằm giữa BeginTransaction và
+    // EndTransaction: giữ lượt của CardScheduler (chung với thao tác chặn của
+    // plugin, nên không xen với coroutine hay request khác) và một
+    // CardTransaction. Mọi phương thức gọi từ coroutine trên [loop]; hủy
+    // reader sau khi các coroutine dùng nó đã xong.
+    class AsyncCardReader {
+    public:
+        // [readerName] rỗng: reader đầu tiên lúc kết nối.
+        AsyncCardReader(CardEventLoop& loop, std::string readerName = std::string());
+        ~AsyncCardReader();
+
+        AsyncCardReader(const AsyncCardReader&) = delete;
+        AsyncCardReader& operator=(const AsyncCardReader&) = delete;
+
+        // Rỗng cho tới khi reader đầu tiên được chọn. Gọi được từ luồng bất kỳ.
+        std::string ReaderName() const;
+
+        // Chờ lượt của CardScheduler, kết nối nếu chưa kết nối rồi giữ thẻ
+        // độc quyền tới EndTransaction. Lệnh PC/SC trong transaction chạy với
+        // token của [request]: hủy thì dừng trước APDU kế tiếp.
+        CardTask<void> BeginTransaction(AsyncCardRequest request);
+
+        // Gửi APDU (kèm GET RESPONSE) trong transaction hiện tại, trả về dữ
+        // liệu và SW1/SW2. Lỗi PC/SC không phục hồi được thì ngắt kết nối.
+        CardTask<std::vector<uint8_t>> Transmit(std::vector<uint8_t> command);
+
+        // Nhả thẻ với [disposition] và trả lượt cho CardScheduler.
+        CardTask<void> EndTransaction(DWORD disposition);
+
+        // Chờ thẻ được đặt lên reader, tối đa [timeout] (và deadline của
+        // [cancellation]). Không cần lượt của CardScheduler nhưng chiếm một
+        // luồng I/O trong lúc chờ. Ném OperationCancelled nếu bị hủy.
+        CardTask<bool> WaitForCard(std::chrono::milliseconds timeout,
+                                   std::shared_ptr<CancellationToken> cancellation = nullptr);
+
+        // Reset thẻ (xóa trạng thái VERIFY PIN) rồi ngắt kết nối, theo lượt
+        // của CardScheduler. Không gọi giữa BeginTransaction và EndTransaction.
+        CardTask<void> Disconnect(AsyncCardRequest request = {});
+
+    private:
+        // Tên reader đã chọn, hoặc reader đầu tiên của [hContext].
+        std::string ResolveReaderName(SCARDCONTEXT hContext);
+        void ReleaseTicket();
+
+        CardEventLoop& loop_;
+        mutable std::mutex name_mutex_;
+        std::string reader_name_;
+
+        // Chỉ truy cập khi đang giữ ticket_: một lệnh một lúc, luồng loop và
+        // luồng I/O nối tiếp nhau qua hàng đợi của loop.
+        SCARDCONTEXT hContext_ = 0;
+        SCARDHANDLE hCard_ = 0;
+        CardScheduler::Ticket ticket_;
+        std::shared_ptr<CancellationToken> cancellation_;
+        std::unique_ptr<CancelCallbackGuard> cancel_waits_;
+        std::unique_ptr<CardTransaction> transaction_;
+    };
+
+    // Các hội thoại APDU thường dùng, mỗi hội thoại là một transaction của
+    // AsyncCardReader theo [request]. Tham số truyền theo giá trị: coroutine
+    // có thể sống lâu hơn biểu thức gọi nó.
+
+    // SELECT applet rồi đọc chứng thư.
+    CardTask<std::vector<uint8_t>> ReadCertificateAsync(AsyncCardReader& reader, std::string appletID,
+                                                        AsyncCardRequest request = {});
+
+    // SELECT applet rồi đọc khóa công khai RSA (TLV 7F49) của [keyRole].
+    CardTask<std::vector<uint8_t>> ReadRsaPublicKeyAsync(AsyncCardReader& reader, std::string appletID,
+                                                         std::string keyRole, AsyncCardRequest request = {});
+
+    // SELECT -> VERIFY -> COMPUTE SIGNATURE; reset thẻ sau khi ký để trạng
+    // thái đã VERIFY không còn cho lượt sau.
+    CardTask<std::vector<uint8_t>> SignAsync(AsyncCardReader& reader, std::string appletID, std::string pin,
+                                             std::vector<uint8_t> data, int keyIndex,
+                                             AsyncCardRequest request = {});
+
+    // Gửi lần lượt các APDU của [script], dừng ở lệnh đầu tiên không trả về
+    // 90 00. Trả về các phản hồi đã nhận (kể cả phản hồi lỗi cuối cùng).
+    CardTask<std::vector<std::vector<uint8_t>>> RunApduScriptAsync(AsyncCardReader& reader,
+                                                                   std::vector<std::vector<uint8_t>> script,
+                                                                   AsyncCardRequest request = {});
+
+}  // namespace nfcsigner
+
+#endif  // NFCSIGNER_HAVE_COROUTINES
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_CARD_COROUTINE_H_
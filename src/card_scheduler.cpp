@@ -0,0 +1,241 @@
+#include "card_scheduler.h"
+
+#include "cancellation.h"
+#include "signing_metrics.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+namespace nfcsigner {
+
+    const char* CardPriorityName(CardPriority priority) {
+        switch (priority) {
+            case CardPriority::Interactive: return "interactive";
+            case CardPriority::Bulk: return "bulk";
+            case CardPriority::Background: return "background";
+        }
+        return "unknown";
+    }
+
+    CardBusyError::CardBusyError(CardPriority priority)
+            : std::runtime_error(std::string("Hàng đợi thẻ (") + CardPriorityName(priority) + ") đã đầy, thử lại sau.") {}
+
+    CardScheduler::Ticket::Ticket(Ticket&& other) noexcept
+            : scheduler_(std::exchange(other.scheduler_, nullptr)), wait_us_(other.wait_us_) {}
+
+    CardScheduler::Ticket& CardScheduler::Ticket::operator=(Ticket&& other) noexcept {
+        if (this != &other) {
+            if (scheduler_) scheduler_->Release();
+            scheduler_ = std::exchange(other.scheduler_, nullptr);
+            wait_us_ = other.wait_us_;
+        }
+        return *this;
+    }
+
+    CardScheduler::Ticket::~Ticket() {
+        if (scheduler_) scheduler_->Release();
+    }
+
+    CardScheduler& CardScheduler::Instance() {
+        static CardScheduler instance;
+        return instance;
+    }
+
+    CardScheduler::CardScheduler() : credits_(kWeights) {
+        // Lô nền giữ nhiều dữ liệu nhất nên hàng đợi ngắn nhất.
+        metrics_[static_cast<size_t>(CardPriority::Interactive)].capacity = 16;
+        metrics_[static_cast<size_t>(CardPriority::Bulk)].capacity = 8;
+        metrics_[static_cast<size_t>(CardPriority::Background)].capacity = 4;
+    }
+
+    CardScheduler::Ticket CardScheduler::Acquire(CardPriority priority) {
+        const size_t index = static_cast<size_t>(priority);
+        // Request bị hủy (hoặc hết hạn) trong lúc chờ thì rời hàng đợi ngay.
+        CancellationToken* token = CurrentCancellation();
+        if (token) token->ThrowIfCancelled();
+        CancelCallbackGuard wakeOnCancel(token, [this]() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            granted_.notify_all();
+        });
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        CardQueueMetrics& metrics = metrics_[index];
+
+        if (!busy_) {
+            busy_ = true;
+            ++metrics.granted;
+            metrics.lastWaitUs = 0;
+            return Ticket(this, 0);
+        }
+        if (queues_[index].size() >= metrics.capacity) {
+            ++metrics.rejected;
+            return Ticket();
+        }
+
+        PhaseTimer waitTimer;
+        Waiter waiter;
+        queues_[index].push_back(&waiter);
+        metrics.depth = queues_[index].size();
+        metrics.maxDepth = std::max(metrics.maxDepth, metrics.depth);
+        granted_.wait(lock, [&waiter, token]() { return waiter.granted || (token && token->IsCancelled()); });
+        if (!waiter.granted) {
+            auto& queue = queues_[index];
+            queue.erase(std::find(queue.begin(), queue.end(), &waiter));
+            metrics.depth = queue.size();
+            lock.unlock();
+            token->ThrowIfCancelled();
+        }
+
+        int64_t waitUs = waitTimer.ElapsedUs();
+        ++metrics.granted;
+        metrics.lastWaitUs = waitUs;
+        metrics.maxWaitUs = std::max(metrics.maxWaitUs, waitUs);
+        metrics.totalWaitUs += waitUs;
+        return Ticket(this, waitUs);
+    }
+
+    void CardScheduler::Release() {
+        std::function<void()> notify;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_ = false;
+            Waiter* next = GrantNext();
+            if (next) notify = std::move(next->notify);
+        }
+        granted_.notify_all();
+        if (notify) notify();
+    }
+
+    CardScheduler::Waiter* CardScheduler::GrantNext() {
+        // Hai vòng: vòng đầu theo số lượt còn lại của từng lớp, hết lượt thì
+        // nạp lại theo trọng số rồi chọn lần nữa.
+        for (int pass = 0; pass < 2; ++pass) {
+            for (size_t i = 0; i < kCardPriorityCount; ++i) {
+                if (!queues_[i].empty() && credits_[i] > 0) {
+                    --credits_[i];
+                    Waiter* waiter = queues_[i].front();
+                    queues_[i].pop_front();
+                    metrics_[i].depth = queues_[i].size();
+                    waiter->granted = true;
+                    busy_ = true;
+                    return waiter;
+                }
+            }
+            credits_ = kWeights;
+        }
+        return nullptr;
+    }
+
+    // Request chờ bằng AcquireAsync. Giữ sống bởi Waiter::notify (khi đang
+    // trong hàng đợi) và callback hủy của token.
+    struct CardScheduler::AsyncWaiter {
+        Waiter waiter;
+        CardPriority priority = CardPriority::Interactive;
+        PhaseTimer timer;
+        AcquireCallback done;
+        std::shared_ptr<CancellationToken> cancellation;
+        uint64_t cancelCallback = 0;
+        bool finished = false;      // done đã (hoặc sắp) được gọi; đọc/ghi khi giữ mutex_
+    };
+
+    void CardScheduler::AcquireAsync(CardPriority priority, std::shared_ptr<CancellationToken> cancellation,
+                                     AcquireCallback done) {
+        const size_t index = static_cast<size_t>(priority);
+        if (cancellation) {
+            try {
+                cancellation->ThrowIfCancelled();
+            } catch (...) {
+                done(Ticket(), std::current_exception());
+                return;
+            }
+        }
+
+        auto pending = std::make_shared<AsyncWaiter>();
+        pending->priority = priority;
+        pending->done = std::move(done);
+        pending->cancellation = std::move(cancellation);
+
+        // Đăng ký trước khi vào hàng đợi: hủy lúc nào cũng gỡ được request.
+        // Token đã bị hủy thì callback chạy ngay và trả lỗi.
+        if (pending->cancellation) {
+            uint64_t id = pending->cancellation->OnCancel([this, pending]() { CancelAsync(pending); });
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending->cancelCallback = id;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (pending->finished) return;
+        CardQueueMetrics& metrics = metrics_[index];
+        if (!busy_ || queues_[index].size() >= metrics.capacity) {
+            Ticket ticket;
+            if (!busy_) {
+                busy_ = true;
+                ++metrics.granted;
+                metrics.lastWaitUs = 0;
+                ticket = Ticket(this, 0);
+            } else {
+                ++metrics.rejected;
+            }
+            pending->finished = true;
+            lock.unlock();
+            if (pending->cancellation) pending->cancellation->RemoveCallback(pending->cancelCallback);
+            pending->done(std::move(ticket), nullptr);
+            return;
+        }
+
+        pending->waiter.notify = [this, pending]() { CompleteAsync(pending); };
+        queues_[index].push_back(&pending->waiter);
+        metrics.depth = queues_[index].size();
+        metrics.maxDepth = std::max(metrics.maxDepth, metrics.depth);
+    }
+
+    void CardScheduler::CompleteAsync(const std::shared_ptr<AsyncWaiter>& pending) {
+        int64_t waitUs = pending->timer.ElapsedUs();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            CardQueueMetrics& metrics = metrics_[static_cast<size_t>(pending->priority)];
+            ++metrics.granted;
+            metrics.lastWaitUs = waitUs;
+            metrics.maxWaitUs = std::max(metrics.maxWaitUs, waitUs);
+            metrics.totalWaitUs += waitUs;
+            pending->finished = true;
+        }
+        if (pending->cancellation) pending->cancellation->RemoveCallback(pending->cancelCallback);
+        pending->done(Ticket(this, waitUs), nullptr);
+    }
+
+    void CardScheduler::CancelAsync(const std::shared_ptr<AsyncWaiter>& pending) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // Đã được cấp lượt: Release sẽ gọi CompleteAsync, Ticket trả lại reader.
+            if (pending->finished || pending->waiter.granted) return;
+            pending->finished = true;
+            auto& queue = queues_[static_cast<size_t>(pending->priority)];
+            auto it = std::find(queue.begin(), queue.end(), &pending->waiter);
+            if (it != queue.end()) {
+                queue.erase(it);
+                metrics_[static_cast<size_t>(pending->priority)].depth = queue.size();
+            }
+            pending->waiter.notify = nullptr;
+        }
+        std::exception_ptr error;
+        try {
+            pending->cancellation->ThrowIfCancelled();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        pending->done(Ticket(), error);
+    }
+
+    void CardScheduler::SetCapacity(CardPriority priority, size_t capacity) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        metrics_[static_cast<size_t>(priority)].capacity = capacity;
+    }
+
+    std::array<CardQueueMetrics, kCardPriorityCount> CardScheduler::GetMetrics() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return metrics_;
+    }
+
+}  // namespace nfcsigner
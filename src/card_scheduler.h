@@ -0,0 +1,125 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_CARD_SCHEDULER_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_CARD_SCHEDULER_H_
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace nfcsigner {
+
+    class CancellationToken;
+
+    // Lớp ưu tiên của một thao tác dùng reader.
+    enum class CardPriority {
+        Interactive = 0,    // đọc nhanh cho UI: certificate, khóa công khai, ký thô
+        Bulk = 1,           // ký một tài liệu
+        Background = 2,     // lô dài: nhiều chữ ký, nhiều XML
+    };
+
+    constexpr size_t kCardPriorityCount = 3;
+
+    const char* CardPriorityName(CardPriority priority);
+
+    // Hàng đợi của lớp ưu tiên đã đầy (mã lỗi CARD_BUSY phía Dart).
+    class CardBusyError : public std::runtime_error {
+    public:
+        explicit CardBusyError(CardPriority priority);
+    };
+
+    // Số liệu hàng đợi của một lớp ưu tiên.
+    struct CardQueueMetrics {
+        size_t capacity = 0;
+        size_t depth = 0;               // đang chờ
+        size_t maxDepth = 0;
+        uint64_t granted = 0;
+        uint64_t rejected = 0;          // hàng đợi đầy
+        int64_t lastWaitUs = 0;
+        int64_t maxWaitUs = 0;
+        int64_t totalWaitUs = 0;
+    };
+
+    // Cấp reader cho từng thao tác một. Mỗi lớp ưu tiên có hàng đợi giới hạn;
+    // đầy thì từ chối ngay thay vì giữ request (và dữ liệu của nó) trong bộ
+    // nhớ. Khi reader rảnh, lượt tiếp theo được chọn theo weighted round-robin
+    // (Interactive 4, Bulk 2, Background 1) nên thao tác ngắn chen được giữa
+    // các tài liệu dài mà lô nền vẫn không bị bỏ đói.
+    class CardScheduler {
+    public:
+        // Quyền dùng reader; trả lại khi hủy. Rỗng nếu bị từ chối.
+        class Ticket {
+        public:
+            Ticket() = default;
+            Ticket(Ticket&& other) noexcept;
+            Ticket& operator=(Ticket&& other) noexcept;
+            ~Ticket();
+
+            Ticket(const Ticket&) = delete;
+            Ticket& operator=(const Ticket&) = delete;
+
+            explicit operator bool() const { return scheduler_ != nullptr; }
+            int64_t GetWaitUs() const { return wait_us_; }
+
+        private:
+            friend class CardScheduler;
+            Ticket(CardScheduler* scheduler, int64_t waitUs) : scheduler_(scheduler), wait_us_(waitUs) {}
+
+            CardScheduler* scheduler_ = nullptr;
+            int64_t wait_us_ = 0;
+        };
+
+        static CardScheduler& Instance();
+
+        // Chờ tới lượt của [priority]. Trả về Ticket rỗng ngay nếu hàng đợi
+        // của lớp đó đã đầy; ném OperationCancelled nếu request của luồng hiện
+        // tại bị hủy trong lúc chờ.
+        Ticket Acquire(CardPriority priority);
+
+        // Như Acquire nhưng không chặn luồng gọi (API coroutine): [done] nhận
+        // Ticket khi tới lượt, Ticket rỗng nếu hàng đợi đầy, hoặc lỗi
+        // OperationCancelled nếu [cancellation] bị hủy trong lúc chờ. [done]
+        // chạy đúng một lần, trên luồng gọi (cấp hoặc từ chối ngay), luồng nhả
+        // reader hoặc luồng hủy request.
+        using AcquireCallback = std::function<void(Ticket, std::exception_ptr)>;
+        void AcquireAsync(CardPriority priority, std::shared_ptr<CancellationToken> cancellation,
+                          AcquireCallback done);
+
+        void SetCapacity(CardPriority priority, size_t capacity);
+        std::array<CardQueueMetrics, kCardPriorityCount> GetMetrics() const;
+
+    private:
+        CardScheduler();
+
+        struct Waiter {
+            bool granted = false;
+            // Waiter của AcquireAsync: chạy ngoài mutex_ sau khi được cấp lượt.
+            std::function<void()> notify;
+        };
+
+        struct AsyncWaiter;
+
+        void Release();
+        // Gọi khi đang giữ mutex_ và reader rảnh. Trả về waiter vừa được cấp.
+        Waiter* GrantNext();
+        void CompleteAsync(const std::shared_ptr<AsyncWaiter>& pending);
+        void CancelAsync(const std::shared_ptr<AsyncWaiter>& pending);
+
+        static constexpr std::array<int, kCardPriorityCount> kWeights = { 4, 2, 1 };
+
+        mutable std::mutex mutex_;
+        std::condition_variable granted_;
+        std::array<std::deque<Waiter*>, kCardPriorityCount> queues_;
+        std::array<CardQueueMetrics, kCardPriorityCount> metrics_;
+        std::array<int, kCardPriorityCount> credits_;
+        bool busy_ = false;
+    };
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_CARD_SCHEDULER_H_
@@ -0,0 +1,589 @@
+// nfcsign: ký hàng loạt PDF/XML từ shell, không cần ứng dụng Flutter.
+//
+//   nfcsign [options] <file|dir|glob>...
+//   nfcsign [options] --manifest list.txt
+//
+// Cả lô dùng một lượt giữ thẻ với một lần VERIFY PIN (lớp Background của
+// CardScheduler). Đọc, chuẩn bị tài liệu, dựng CMS và ghi file chạy song song
+// trên --jobs luồng; chỉ lệnh COMPUTE SIGNATURE đi lần lượt qua thẻ. File đầu
+// ra được ghi vào file tạm cùng thư mục rồi đổi tên, nên không bao giờ có
+// file ký dở. Kết thúc in số file/giây, MB/giây và độ trễ p50/p95/max.
+//
+// Mọi tùy chọn (trừ --config, --software-card) cũng viết được trong file --config
+// dạng "key=value" (tên key là tên tùy chọn bỏ "--"), ví dụ:
+//   applet=D2760001240102000000000000010000
+//   reason=Phê duyệt
+//   page=1
+//   x=400
+//   image=/etc/nfcsign/stamp.png
+// Tùy chọn trên dòng lệnh ghi đè file cấu hình. PIN lấy từ --pin hoặc biến
+// môi trường NFCSIGNER_PIN (không hiện trong danh sách tiến trình).
+
+#include "cms_template.h"
+#include "pdf_signer.h"
+#include "request_arena.h"
+#include "signing_card.h"
+#include "signing_metrics.h"
+#include "software_card.h"
+#include "xml_dsig.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef HAVE_PODOFO
+#include <podofo/podofo.h>
+#endif
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace nfcsigner {
+namespace {
+
+    const char* kUsage =
+            "Usage: nfcsign [options] <file|dir|glob>...\n"
+            "       nfcsign [options] --manifest FILE\n"
+            "\n"
+            "Card:\n"
+            "  --applet HEX            applet ID\n"
+            "  --pin PIN               PIN (default: $NFCSIGNER_PIN)\n"
+            "  --key-index N           0 sig, 1 dec, 2 aut (default 0)\n"
+            "  --software-card KEY CERT  sign with a file-backed test key\n"
+            "  --self-check            verify every card signature against the certificate\n"
+            "  --retries N             reconnect attempts after a card reset or reader glitch (default 3, 0 off)\n"
+            "  --no-pin-replay         do not re-send the PIN after the card was reset\n"
+            "Input/output:\n"
+            "  --manifest FILE         one \"input[<TAB>output]\" per line\n"
+            "  --recursive             descend into directories\n"
+            "  --out-dir DIR           write outputs here, keeping paths below each input\n"
+            "                          directory (default: next to the input)\n"
+            "  --suffix S              output name suffix (default .signed)\n"
+            "  --jobs N                worker threads (default: hardware threads)\n"
+            "PDF (same fields as signPdf):\n"
+            "  --reason S  --location S  --page N  --sign-date S\n"
+            "  --x PT  --y PT  --width PT  --height PT\n"
+            "  --signer-name S  --contact S\n"
+            "  --image FILE  --image-width PT  --image-height PT\n"
+            "XML:\n"
+            "  --reference-uri URI  --xpath /A/B  --signature-id ID\n"
+            "Other:\n"
+            "  --config FILE           key=value defaults for any option above\n";
+
+    // Tùy chọn dạng cờ (không có giá trị).
+    bool IsFlag(const std::string& key) {
+        return key == "recursive" || key == "self-check" || key == "no-pin-replay";
+    }
+
+    class UsageError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    struct Options {
+        std::map<std::string, std::string> values;
+        std::vector<std::string> inputs;
+        std::string softwareKey;
+        std::string softwareCertificate;
+
+        bool Has(const std::string& key) const { return values.count(key) != 0; }
+
+        std::string Get(const std::string& key, const std::string& defaultValue = "") const {
+            auto it = values.find(key);
+            return it != values.end() ? it->second : defaultValue;
+        }
+
+        double GetDouble(const std::string& key, double defaultValue) const {
+            auto it = values.find(key);
+            if (it == values.end()) return defaultValue;
+            try {
+                return std::stod(it->second);
+            } catch (const std::exception&) {
+                throw UsageError("--" + key + " expects a number");
+            }
+        }
+
+        int GetInt(const std::string& key, int defaultValue) const {
+            return static_cast<int>(GetDouble(key, defaultValue));
+        }
+    };
+
+    std::vector<uint8_t> ReadFileBytes(const fs::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) throw std::runtime_error("Cannot open " + path.string());
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // Ghi vào file tạm cùng thư mục, fsync rồi đổi tên: đầu ra hoặc là bản ký
+    // đầy đủ hoặc không có, kể cả khi tiến trình bị dừng hay máy mất điện
+    // giữa chừng.
+    void WriteFileAtomically(const fs::path& path, const uint8_t* data, size_t size) {
+        static std::atomic<uint64_t> counter{ 0 };
+        fs::path temp = path;
+        temp += ".tmp" + std::to_string(counter.fetch_add(1));
+#ifdef _WIN32
+        HANDLE file = CreateFileW(temp.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot create " + temp.string());
+        bool written = true;
+        while (written && size > 0) {
+            DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1 << 30));
+            DWORD count = 0;
+            written = WriteFile(file, data, chunk, &count, NULL) && count == chunk;
+            data += count;
+            size -= count;
+        }
+        written = written && FlushFileBuffers(file);
+        CloseHandle(file);
+        if (!written) {
+            DeleteFileW(temp.c_str());
+            throw std::runtime_error("Cannot write " + temp.string());
+        }
+        if (!MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            DWORD error = GetLastError();
+            DeleteFileW(temp.c_str());
+            throw std::runtime_error("Cannot rename to " + path.string() + ": " + std::to_string(error));
+        }
+#else
+        int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) throw std::runtime_error("Cannot create " + temp.string() + ": " + std::strerror(errno));
+        int error = 0;
+        while (!error && size > 0) {
+            ssize_t n = write(fd, data, size);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                error = n < 0 ? errno : EIO;
+                break;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        if (!error && fsync(fd) != 0) error = errno;
+        if (close(fd) != 0 && !error) error = errno;
+        if (error) {
+            unlink(temp.c_str());
+            throw std::runtime_error("Cannot write " + temp.string() + ": " + std::strerror(error));
+        }
+        if (rename(temp.c_str(), path.c_str()) != 0) {
+            error = errno;
+            unlink(temp.c_str());
+            throw std::runtime_error("Cannot rename to " + path.string() + ": " + std::strerror(error));
+        }
+        // Ghi mục thư mục mới xuống đĩa để lần đổi tên không bị mất.
+        fs::path directory = path.has_parent_path() ? path.parent_path() : fs::path(".");
+        int directoryFd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (directoryFd >= 0) {
+            fsync(directoryFd);
+            close(directoryFd);
+        }
+#endif
+    }
+
+    void ParseConfigFile(const std::string& path, Options& options) {
+        std::ifstream file(path);
+        if (!file) throw UsageError("Cannot open config " + path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            auto start = line.find_first_not_of(" \t");
+            if (start == std::string::npos || line[start] == '#') continue;
+            auto eq = line.find('=');
+            if (eq == std::string::npos) throw UsageError("Bad config line: " + line);
+            std::string key = line.substr(start, eq - start);
+            key.erase(key.find_last_not_of(" \t") + 1);
+            std::string value = line.substr(eq + 1);
+            value.erase(0, value.find_first_not_of(" \t"));
+            // Dòng lệnh ghi đè file cấu hình.
+            options.values.emplace(key, value);
+        }
+    }
+
+    Options ParseArguments(int argc, char** argv) {
+        Options options;
+        std::vector<std::string> configs;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg.size() < 3 || arg.compare(0, 2, "--") != 0) {
+                options.inputs.push_back(arg);
+                continue;
+            }
+            std::string key = arg.substr(2);
+            if (key == "help") {
+                std::cout << kUsage;
+                std::exit(0);
+            }
+            if (key == "software-card") {
+                if (i + 2 >= argc) throw UsageError("--software-card expects KEY CERT");
+                options.softwareKey = argv[++i];
+                options.softwareCertificate = argv[++i];
+            } else if (IsFlag(key)) {
+                options.values[key] = "1";
+            } else {
+                if (i + 1 >= argc) throw UsageError(arg + " expects a value");
+                if (key == "config") {
+                    configs.push_back(argv[++i]);
+                } else {
+                    options.values[key] = argv[++i];
+                }
+            }
+        }
+        for (const auto& config : configs) ParseConfigFile(config, options);
+        return options;
+    }
+
+    // Khớp tên file với mẫu có '*' và '?'.
+    bool MatchWildcard(const char* pattern, const char* name) {
+        for (; *pattern; ++pattern, ++name) {
+            if (*pattern == '*') {
+                for (const char* rest = name;; ++rest) {
+                    if (MatchWildcard(pattern + 1, rest)) return true;
+                    if (!*rest) return false;
+                }
+            }
+            if (!*name || (*pattern != '?' && *pattern != *name)) return false;
+        }
+        return !*name;
+    }
+
+    bool IsSignable(const fs::path& path) {
+        std::string extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension == ".pdf" || extension == ".xml";
+    }
+
+    struct Job {
+        fs::path input;
+        fs::path output;
+    };
+
+    // Đầu ra của [input]. Với --out-dir, file tìm thấy dưới thư mục [root] giữ
+    // nguyên đường dẫn con so với [root] để hai file cùng tên ở hai thư mục
+    // con không ghi đè nhau.
+    fs::path OutputFor(const fs::path& input, const Options& options, const fs::path& root = fs::path()) {
+        fs::path directory = input.parent_path();
+        if (options.Has("out-dir")) {
+            directory = fs::path(options.Get("out-dir"));
+            if (!root.empty()) directory /= input.parent_path().lexically_relative(root);
+        }
+        return (directory / (input.stem().string() + options.Get("suffix", ".signed") + input.extension().string()))
+                .lexically_normal();
+    }
+
+    void AddDirectory(const fs::path& directory, const std::string& pattern, bool recursive,
+                      const Options& options, std::vector<Job>& jobs) {
+        auto add = [&](const fs::directory_entry& entry) {
+            if (!entry.is_regular_file() || !IsSignable(entry.path())) return;
+            std::string name = entry.path().filename().string();
+            if (!MatchWildcard(pattern.c_str(), name.c_str())) return;
+            // Không ký lại đầu ra của lần chạy trước nằm cùng thư mục.
+            if (name.find(options.Get("suffix", ".signed") + ".") != std::string::npos) return;
+            jobs.push_back({ entry.path(), OutputFor(entry.path(), options, directory) });
+        };
+        if (recursive) {
+            for (const auto& entry : fs::recursive_directory_iterator(directory)) add(entry);
+        } else {
+            for (const auto& entry : fs::directory_iterator(directory)) add(entry);
+        }
+    }
+
+    std::vector<Job> CollectJobs(const Options& options) {
+        std::vector<Job> jobs;
+        bool recursive = options.Has("recursive");
+        if (options.Has("manifest")) {
+            std::ifstream manifest(options.Get("manifest"));
+            if (!manifest) throw UsageError("Cannot open manifest " + options.Get("manifest"));
+            std::string line;
+            while (std::getline(manifest, line)) {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (line.empty() || line[0] == '#') continue;
+                auto tab = line.find('\t');
+                fs::path input = line.substr(0, tab);
+                jobs.push_back({ input, tab == std::string::npos ? OutputFor(input, options)
+                                                                 : fs::path(line.substr(tab + 1)) });
+            }
+        }
+        for (const auto& arg : options.inputs) {
+            fs::path path(arg);
+            if (fs::is_directory(path)) {
+                AddDirectory(path, "*", recursive, options, jobs);
+            } else if (arg.find_first_of("*?") != std::string::npos) {
+                // Ký tự đại diện chỉ ở tên file: "in/*.pdf", "2024-??.xml".
+                fs::path directory = path.has_parent_path() ? path.parent_path() : fs::path(".");
+                AddDirectory(directory, path.filename().string(), recursive, options, jobs);
+            } else {
+                jobs.push_back({ path, OutputFor(path, options) });
+            }
+        }
+        // Hai đầu vào trùng đầu ra (cùng tên từ hai đối số, manifest...): dừng
+        // trước khi ký thay vì để file sau ghi đè file trước.
+        std::map<fs::path, fs::path> outputs;
+        for (const auto& job : jobs) {
+            auto inserted = outputs.emplace(job.output.lexically_normal(), job.input);
+            if (!inserted.second) {
+                throw UsageError("Both " + inserted.first->second.string() + " and " + job.input.string() +
+                                 " would be written to " + job.output.string());
+            }
+        }
+        return jobs;
+    }
+
+    struct JobResult {
+        bool ok = false;
+        std::string error;
+        int64_t latencyUs = 0;
+        size_t inputBytes = 0;
+    };
+
+    class BulkSigner {
+    public:
+        BulkSigner(const Options& options, std::vector<uint8_t> certificate, CardSignFunction cardSign)
+                : options_(options), certificate_(std::move(certificate)), card_sign_(std::move(cardSign)) {
+            cms_template_ = CmsTemplateCache::Instance().GetOrCreate(certificate_);
+
+            appearance_.x = options.GetDouble("x", appearance_.x);
+            appearance_.y = options.GetDouble("y", appearance_.y);
+            appearance_.width = options.GetDouble("width", appearance_.width);
+            appearance_.height = options.GetDouble("height", appearance_.height);
+            appearance_.signerName = options.Get("signer-name", appearance_.signerName);
+            appearance_.contact = options.Get("contact", appearance_.contact);
+            if (options.Has("image")) appearance_.signatureImage = ReadFileBytes(options.Get("image"));
+            appearance_.signatureImageWidth = options.GetDouble("image-width", appearance_.signatureImageWidth);
+            appearance_.signatureImageHeight = options.GetDouble("image-height", appearance_.signatureImageHeight);
+            page_number_ = options.GetInt("page", 1);
+
+            xml_config_.referenceUri = options.Get("reference-uri");
+            xml_config_.xpath = options.Get("xpath");
+            xml_config_.signatureId = options.Get("signature-id");
+        }
+
+        JobResult Run(const Job& job) {
+            JobResult result;
+            PhaseTimer timer;
+            try {
+                auto input = ReadFileBytes(job.input);
+                result.inputBytes = input.size();
+                std::string extension = job.input.extension().string();
+                std::transform(extension.begin(), extension.end(), extension.begin(),
+                               [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                if (extension == ".xml") {
+                    std::string xml = SignXml(std::string(input.begin(), input.end()));
+                    WriteFileAtomically(job.output, reinterpret_cast<const uint8_t*>(xml.data()), xml.size());
+                } else {
+                    auto pdf = SignPdf(input);
+                    WriteFileAtomically(job.output, pdf.data(), pdf.size());
+                }
+                result.ok = true;
+#ifdef HAVE_PODOFO
+            } catch (const PoDoFo::PdfError& e) {
+                result.error = std::string("PoDoFo Error: ") + e.what();
+#endif
+            } catch (const std::exception& e) {
+                result.error = e.what();
+            }
+            result.latencyUs = timer.ElapsedUs();
+            return result;
+        }
+
+    private:
+        std::vector<uint8_t> SignPdf(const std::vector<uint8_t>& pdfBytes) {
+#ifdef HAVE_PODOFO
+            std::string reason = options_.Get("reason");
+            std::string location = options_.Get("location");
+            std::string signDate = options_.Get("sign-date");
+            RequestArena arena;
+            RequestArena::Scope arenaScope(&arena);
+            SignPdfMetrics metrics;
+            PhaseTimer totalTimer;
+            std::promise<void> parsed;
+            PreparedPdf prepared = PreparePdf(pdfBytes, page_number_, appearance_, signDate, reason, location,
+                                              parsed, metrics);
+
+            PhaseTimer signTimer;
+            LazyPdfSignParams params;
+            params.pageNumber = page_number_ > 0 ? page_number_ : 1;
+            params.x = appearance_.x;
+            params.y = appearance_.y;
+            params.width = appearance_.width;
+            params.height = appearance_.height;
+            params.reason = reason;
+            params.location = location;
+            params.signerName = appearance_.signerName;
+            params.signingTime = std::time(nullptr);
+            auto signedPdf = SignPreparedPdf(prepared, pdfBytes, params, signDate, appearance_, cms_template_,
+                                             card_sign_);
+            metrics.signUs = signTimer.ElapsedUs();
+            metrics.totalUs = totalTimer.ElapsedUs();
+            metrics.incremental = prepared.lazyDocument != nullptr;
+            SigningMetrics::Instance().Record(metrics);
+            return signedPdf;
+#else
+            (void)pdfBytes;
+            throw std::runtime_error("PoDoFo not available in this build");
+#endif
+        }
+
+        std::string SignXml(std::string xml) {
+            XmlDsigDocument document(std::move(xml), xml_config_);
+            return document.Sign(certificate_, card_sign_);
+        }
+
+        const Options& options_;
+        std::vector<uint8_t> certificate_;
+        CardSignFunction card_sign_;
+        std::shared_ptr<const CmsTemplate> cms_template_;
+        SignatureAppearanceConfig appearance_;
+        int page_number_ = 1;
+        XmlDsigConfig xml_config_;
+    };
+
+    int64_t Percentile(std::vector<int64_t> values, double percentile) {
+        if (values.empty()) return 0;
+        std::sort(values.begin(), values.end());
+        size_t index = static_cast<size_t>(percentile * (values.size() - 1) + 0.5);
+        return values[std::min(index, values.size() - 1)];
+    }
+
+    void PrintSummary(const std::vector<JobResult>& results, int64_t wallUs) {
+        std::vector<int64_t> latencies;
+        size_t failed = 0;
+        size_t bytes = 0;
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (!results[i].ok) {
+                ++failed;
+                continue;
+            }
+            latencies.push_back(results[i].latencyUs);
+            bytes += results[i].inputBytes;
+        }
+        double seconds = wallUs / 1e6;
+        std::cout << "Signed " << latencies.size() << "/" << results.size() << " files in " << seconds << " s";
+        if (seconds > 0) {
+            std::cout << " (" << latencies.size() / seconds << " files/s, "
+                      << bytes / seconds / (1024.0 * 1024.0) << " MB/s)";
+        }
+        std::cout << std::endl;
+        if (!latencies.empty()) {
+            std::cout << "Latency (ms): p50 " << Percentile(latencies, 0.50) / 1000.0
+                      << ", p95 " << Percentile(latencies, 0.95) / 1000.0
+                      << ", max " << Percentile(latencies, 1.0) / 1000.0 << std::endl;
+        }
+        if (failed) std::cout << failed << " file(s) failed" << std::endl;
+    }
+
+    int Run(int argc, char** argv) {
+        Options options = ParseArguments(argc, argv);
+        std::vector<Job> jobs = CollectJobs(options);
+        if (jobs.empty()) throw UsageError("No input files");
+
+        std::string pin = options.Get("pin");
+        if (pin.empty()) {
+            const char* envPin = std::getenv("NFCSIGNER_PIN");
+            if (envPin) pin = envPin;
+        }
+        if (pin.empty()) throw UsageError("PIN required (--pin or NFCSIGNER_PIN)");
+        std::string appletID = options.Get("applet");
+        if (appletID.empty() && options.softwareKey.empty()) throw UsageError("--applet required");
+        int keyIndex = options.GetInt("key-index", 0);
+        if (options.Has("self-check")) SetCardSignatureSelfCheck(true);
+        // Thẻ bị reset hoặc reader chập chờn giữa lô: ký tiếp từ file đang dở.
+        CardRecoveryPolicy recovery = GetCardRecoveryPolicy();
+        recovery.maxAttempts = std::max(0, options.GetInt("retries", recovery.maxAttempts));
+        if (options.Has("no-pin-replay")) recovery.allowPinReplay = false;
+        SetCardRecoveryPolicy(recovery);
+        if (options.Has("out-dir")) {
+            for (const auto& job : jobs) {
+                if (job.output.has_parent_path()) fs::create_directories(job.output.parent_path());
+            }
+        }
+
+        std::unique_ptr<SigningCard> card;
+        if (!options.softwareKey.empty()) {
+            card = SoftwareSigningCard::FromFiles(options.softwareKey, options.softwareCertificate, pin);
+        } else {
+            card = std::make_unique<PcscSigningCard>();
+        }
+
+        size_t threads = options.Has("jobs") ? static_cast<size_t>(std::max(1, options.GetInt("jobs", 1)))
+                                             : std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min(threads, jobs.size());
+
+        std::vector<JobResult> results(jobs.size());
+        PhaseTimer wallTimer;
+        // Một lượt giữ thẻ cho cả lô: một lần đọc certificate và VERIFY PIN.
+        card->WithChannel(appletID, CardPriority::Background, [&](CardChannel& channel) {
+            auto certificate = channel.ReadCertificate();
+            channel.VerifyPin(pin);
+
+            // Các luồng dùng chung kênh thẻ: mỗi lúc một lệnh COMPUTE SIGNATURE.
+            std::mutex cardMutex;
+            CardSignFunction cardSign = [&](const std::vector<uint8_t>& digestInfo) {
+                std::lock_guard<std::mutex> lock(cardMutex);
+                return channel.ComputeSignature(digestInfo, keyIndex);
+            };
+            if (IsCardSignatureSelfCheckEnabled()) {
+                cardSign = WithCardSignatureSelfCheck(CmsTemplateCache::Instance().GetOrCreate(certificate), cardSign);
+            }
+            BulkSigner signer(options, certificate, cardSign);
+
+            std::atomic<size_t> next{ 0 };
+            std::mutex outputMutex;
+            auto work = [&]() {
+                for (size_t i = next.fetch_add(1); i < jobs.size(); i = next.fetch_add(1)) {
+                    results[i] = signer.Run(jobs[i]);
+                    std::lock_guard<std::mutex> lock(outputMutex);
+                    std::cout << (results[i].ok ? "ok     " : "FAILED ") << jobs[i].input.string()
+                              << (results[i].ok ? " -> " + jobs[i].output.string() : ": " + results[i].error)
+                              << " (" << results[i].latencyUs / 1000 << " ms)" << std::endl;
+                }
+            };
+            std::vector<std::thread> workers;
+            for (size_t t = 1; t < threads; ++t) workers.emplace_back(work);
+            work();
+            for (auto& worker : workers) worker.join();
+        });
+
+        PrintSummary(results, wallTimer.ElapsedUs());
+        return std::all_of(results.begin(), results.end(), [](const JobResult& r) { return r.ok; }) ? 0 : 1;
+    }
+
+}  // namespace
+}  // namespace nfcsigner
+
+int main(int argc, char** argv) {
+    try {
+        return nfcsigner::Run(argc, argv);
+    } catch (const nfcsigner::UsageError& e) {
+        std::cerr << "nfcsign: " << e.what() << "\n\n";
+        std::cerr << nfcsigner::kUsage;
+        return 2;
+    } catch (const std::exception& e) {
+        std::cerr << "nfcsign: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,394 @@
+#include "cms_template.h"
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+namespace nfcsigner {
+
+    namespace {
+
+        // Các vị trí cần vá trong template.
+        enum class DerMark { SignedAttrs, SigningTime, MessageDigest, Signature };
+
+        // Một đoạn DER kèm vị trí (tương đối) của các điểm đánh dấu bên trong.
+        struct DerPiece {
+            std::vector<uint8_t> der;
+            std::map<DerMark, size_t> marks;
+        };
+
+        void AppendLength(std::vector<uint8_t>& out, size_t length) {
+            if (length < 0x80) {
+                out.push_back(static_cast<uint8_t>(length));
+                return;
+            }
+            uint8_t bytes[sizeof(size_t)];
+            size_t count = 0;
+            while (length > 0) {
+                bytes[count++] = static_cast<uint8_t>(length & 0xFF);
+                length >>= 8;
+            }
+            out.push_back(static_cast<uint8_t>(0x80 | count));
+            while (count > 0) out.push_back(bytes[--count]);
+        }
+
+        DerPiece Raw(std::vector<uint8_t> der) {
+            return DerPiece{ std::move(der), {} };
+        }
+
+        // Phần tử nguyên thủy; nếu có [mark] thì đánh dấu ở đầu phần nội dung.
+        DerPiece Primitive(uint8_t tag, const std::vector<uint8_t>& content) {
+            DerPiece piece;
+            piece.der.push_back(tag);
+            AppendLength(piece.der, content.size());
+            piece.der.insert(piece.der.end(), content.begin(), content.end());
+            return piece;
+        }
+
+        DerPiece Primitive(uint8_t tag, const std::vector<uint8_t>& content, DerMark mark) {
+            DerPiece piece = Primitive(tag, content);
+            piece.marks[mark] = piece.der.size() - content.size();
+            return piece;
+        }
+
+        // Bọc các phần tử con trong một phần tử có cấu trúc (SEQUENCE, SET, [n]...).
+        DerPiece Wrap(uint8_t tag, std::initializer_list<DerPiece> children) {
+            size_t contentLength = 0;
+            for (const auto& child : children) contentLength += child.der.size();
+
+            DerPiece piece;
+            piece.der.push_back(tag);
+            AppendLength(piece.der, contentLength);
+            piece.der.reserve(piece.der.size() + contentLength);
+            for (const auto& child : children) {
+                for (const auto& mark : child.marks) {
+                    piece.marks[mark.first] = piece.der.size() + mark.second;
+                }
+                piece.der.insert(piece.der.end(), child.der.begin(), child.der.end());
+            }
+            return piece;
+        }
+
+        DerPiece Marked(DerPiece piece, DerMark mark) {
+            piece.marks[mark] = 0;
+            return piece;
+        }
+
+        // OID đã mã hóa sẵn (bao gồm tag 06 và độ dài).
+        const std::vector<uint8_t> kOidSignedData = { 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x07, 0x02 };
+        const std::vector<uint8_t> kOidData = { 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x07, 0x01 };
+        const std::vector<uint8_t> kOidContentType = { 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x09, 0x03 };
+        const std::vector<uint8_t> kOidMessageDigest = { 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x09, 0x04 };
+        const std::vector<uint8_t> kOidSigningTime = { 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x09, 0x05 };
+        // id-aa-signingCertificateV2 (RFC 5035) - thuộc tính bắt buộc của CAdES-BES.
+        const std::vector<uint8_t> kOidSigningCertificateV2 = {
+                0x06, 0x0B, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x09, 0x10, 0x02, 0x2F
+        };
+        const std::vector<uint8_t> kAlgSha256 = {
+                0x30, 0x0D, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00
+        };
+        const std::vector<uint8_t> kAlgRsaEncryption = {
+                0x30, 0x0D, 0x06, 0x09, 0x2A, 0x86, 0x48, 0x86, 0xF7, 0x0D, 0x01, 0x01, 0x01, 0x05, 0x00
+        };
+        const std::vector<uint8_t> kSha256DigestInfoPrefix = {
+                0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+                0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
+        };
+
+        // UTCTime luôn có đúng 13 ký tự "YYMMDDHHMMSSZ".
+        constexpr size_t kUtcTimeLength = 13;
+
+        void FormatUtcTime(std::time_t t, char* out) {
+            std::tm tm_utc{};
+#ifdef _WIN32
+            gmtime_s(&tm_utc, &t);
+#else
+            gmtime_r(&t, &tm_utc);
+#endif
+            int year = tm_utc.tm_year + 1900;
+            if (year < 1950 || year >= 2050) {
+                throw std::runtime_error("Signing time is out of UTCTime range.");
+            }
+            char buffer[kUtcTimeLength + 1];
+            if (std::strftime(buffer, sizeof(buffer), "%y%m%d%H%M%SZ", &tm_utc) != kUtcTimeLength) {
+                throw std::runtime_error("Cannot format signing time.");
+            }
+            std::memcpy(out, buffer, kUtcTimeLength);
+        }
+
+        std::vector<uint8_t> Sha256(const uint8_t* data, size_t length) {
+            std::vector<uint8_t> digest(kSha256Length);
+            unsigned int digestLength = 0;
+            if (EVP_Digest(data, length, digest.data(), &digestLength, EVP_sha256(), nullptr) != 1 ||
+                digestLength != kSha256Length) {
+                throw std::runtime_error("SHA-256 digest failed.");
+            }
+            return digest;
+        }
+
+        std::vector<uint8_t> EncodeToDer(int length, const std::function<int(unsigned char**)>& encode) {
+            if (length <= 0) throw std::runtime_error("DER encoding failed.");
+            std::vector<uint8_t> der(static_cast<size_t>(length));
+            unsigned char* p = der.data();
+            encode(&p);
+            return der;
+        }
+
+        std::atomic<bool> g_card_signature_self_check{false};
+
+    }  // namespace
+
+    void SetCardSignatureSelfCheck(bool enabled) {
+        g_card_signature_self_check = enabled;
+    }
+
+    bool IsCardSignatureSelfCheckEnabled() {
+        return g_card_signature_self_check;
+    }
+
+    std::vector<uint8_t> CreateSha256DigestInfo(const uint8_t* digest) {
+        std::vector<uint8_t> digestInfo = kSha256DigestInfoPrefix;
+        digestInfo.insert(digestInfo.end(), digest, digest + kSha256Length);
+        return digestInfo;
+    }
+
+    std::shared_ptr<const CmsTemplate> CmsTemplate::Create(const std::vector<uint8_t>& certificate) {
+        const unsigned char* p = certificate.data();
+        std::unique_ptr<X509, decltype(&X509_free)> x509(
+                d2i_X509(nullptr, &p, static_cast<long>(certificate.size())), &X509_free);
+        if (!x509) {
+            throw std::runtime_error("Cannot parse certificate from card.");
+        }
+        // Một số thẻ trả về certificate kèm byte đệm phía sau - chỉ giữ phần DER thật.
+        size_t certLength = static_cast<size_t>(p - certificate.data());
+
+        EVP_PKEY* publicKey = X509_get0_pubkey(x509.get());
+        if (!publicKey || EVP_PKEY_base_id(publicKey) != EVP_PKEY_RSA) {
+            throw std::runtime_error("Only RSA certificates are supported.");
+        }
+
+        X509_NAME* issuer = X509_get_issuer_name(x509.get());
+        const ASN1_INTEGER* serial = X509_get0_serialNumber(x509.get());
+        auto issuerDer = EncodeToDer(i2d_X509_NAME(issuer, nullptr),
+                                     [issuer](unsigned char** out) { return i2d_X509_NAME(issuer, out); });
+        auto serialDer = EncodeToDer(i2d_ASN1_INTEGER(serial, nullptr),
+                                     [serial](unsigned char** out) { return i2d_ASN1_INTEGER(serial, out); });
+
+        std::shared_ptr<CmsTemplate> tpl(new CmsTemplate());
+        tpl->certificate_.assign(certificate.begin(), certificate.begin() + certLength);
+        tpl->signature_size_ = static_cast<size_t>(EVP_PKEY_size(publicKey));
+        EVP_PKEY_up_ref(publicKey);
+        tpl->public_key_.reset(publicKey, &EVP_PKEY_free);
+
+        const std::vector<uint8_t> version1 = { 0x02, 0x01, 0x01 };
+
+        // ESSCertIDv2 chỉ gồm certHash (SHA-256 là thuật toán mặc định nên bỏ qua).
+        auto certHash = Sha256(tpl->certificate_.data(), tpl->certificate_.size());
+
+        // signedAttrs phải được sắp xếp theo DER (SET OF): contentType, signingTime,
+        // messageDigest, signingCertificateV2 (đều là SEQUENCE nên xếp theo độ dài).
+        DerPiece signedAttrs = Marked(Wrap(0xA0, {
+                Wrap(0x30, { Raw(kOidContentType), Wrap(0x31, { Raw(kOidData) }) }),
+                Wrap(0x30, { Raw(kOidSigningTime),
+                             Wrap(0x31, { Primitive(0x17, std::vector<uint8_t>(kUtcTimeLength, '0'),
+                                                    DerMark::SigningTime) }) }),
+                Wrap(0x30, { Raw(kOidMessageDigest),
+                             Wrap(0x31, { Primitive(0x04, std::vector<uint8_t>(kSha256Length, 0),
+                                                    DerMark::MessageDigest) }) }),
+                Wrap(0x30, { Raw(kOidSigningCertificateV2),
+                             Wrap(0x31, { Wrap(0x30, { Wrap(0x30, { Wrap(0x30, { Primitive(0x04, certHash) }) }) }) }) }),
+        }), DerMark::SignedAttrs);
+
+        DerPiece signerInfo = Wrap(0x30, {
+                Raw(version1),
+                Wrap(0x30, { Raw(issuerDer), Raw(serialDer) }),
+                Raw(kAlgSha256),
+                signedAttrs,
+                Raw(kAlgRsaEncryption),
+                Primitive(0x04, std::vector<uint8_t>(tpl->signature_size_, 0), DerMark::Signature),
+        });
+
+        DerPiece contentInfo = Wrap(0x30, {
+                Raw(kOidSignedData),
+                Wrap(0xA0, {
+                        Wrap(0x30, {
+                                Raw(version1),
+                                Wrap(0x31, { Raw(kAlgSha256) }),
+                                Wrap(0x30, { Raw(kOidData) }),
+                                Wrap(0xA0, { Raw(tpl->certificate_) }),
+                                Wrap(0x31, { signerInfo }),
+                        }),
+                }),
+        });
+
+        tpl->der_ = std::move(contentInfo.der);
+        tpl->signed_attrs_offset_ = contentInfo.marks.at(DerMark::SignedAttrs);
+        tpl->signed_attrs_length_ = signedAttrs.der.size();
+        tpl->signing_time_offset_ = contentInfo.marks.at(DerMark::SigningTime);
+        tpl->message_digest_offset_ = contentInfo.marks.at(DerMark::MessageDigest);
+        tpl->signature_offset_ = contentInfo.marks.at(DerMark::Signature);
+        return tpl;
+    }
+
+    std::vector<uint8_t> CmsTemplate::BuildSignedData(const uint8_t* contentDigest, std::time_t signingTime,
+                                                      const CardSignFunction& sign) const {
+        std::vector<uint8_t> der = der_;
+        FormatUtcTime(signingTime, reinterpret_cast<char*>(der.data() + signing_time_offset_));
+        std::memcpy(der.data() + message_digest_offset_, contentDigest, kSha256Length);
+
+        // Chữ ký được tính trên signedAttrs với tag SET (0x31) thay cho [0] IMPLICIT.
+        std::vector<uint8_t> signedAttrs(der.begin() + signed_attrs_offset_,
+                                         der.begin() + signed_attrs_offset_ + signed_attrs_length_);
+        signedAttrs[0] = 0x31;
+        auto attrsDigest = Sha256(signedAttrs.data(), signedAttrs.size());
+
+        std::vector<uint8_t> digestInfo = CreateSha256DigestInfo(attrsDigest.data());
+        std::vector<uint8_t> signature = sign(digestInfo);
+        if (signature.empty() || signature.size() > signature_size_) {
+            throw std::runtime_error("Card returned a signature of unexpected length: " +
+                                     std::to_string(signature.size()));
+        }
+        if (IsCardSignatureSelfCheckEnabled() && !CheckCardSignature(digestInfo, signature)) {
+            throw CardSignatureMismatch("Card signature does not match the certificate public key (wrong keyIndex?).");
+        }
+        // Chữ ký RSA có độ dài cố định; bổ sung byte 0 phía trước nếu thẻ cắt bớt.
+        size_t padding = signature_size_ - signature.size();
+        std::fill_n(der.begin() + signature_offset_, padding, 0);
+        std::copy(signature.begin(), signature.end(), der.begin() + signature_offset_ + padding);
+        return der;
+    }
+
+    bool CmsTemplate::CheckCardSignature(const std::vector<uint8_t>& digestInfo,
+                                         const std::vector<uint8_t>& signature) const {
+        if (signature.empty() || signature.size() > signature_size_) return false;
+        std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> ctx(EVP_PKEY_CTX_new(public_key_.get(), nullptr),
+                                                                        &EVP_PKEY_CTX_free);
+        if (!ctx || EVP_PKEY_verify_recover_init(ctx.get()) != 1 ||
+            EVP_PKEY_CTX_set_rsa_padding(ctx.get(), RSA_PKCS1_PADDING) != 1) {
+            throw std::runtime_error("EVP_PKEY_verify_recover_init failed.");
+        }
+        // Thẻ chỉ thêm padding PKCS#1 vào DigestInfo: khôi phục và so sánh.
+        std::vector<uint8_t> recovered(signature_size_);
+        size_t recoveredLength = recovered.size();
+        if (EVP_PKEY_verify_recover(ctx.get(), recovered.data(), &recoveredLength,
+                                    signature.data(), signature.size()) != 1) {
+            ERR_clear_error();
+            return false;
+        }
+        return recoveredLength == digestInfo.size() &&
+               std::equal(digestInfo.begin(), digestInfo.end(), recovered.begin());
+    }
+
+    CardSignFunction WithCardSignatureSelfCheck(std::shared_ptr<const CmsTemplate> cmsTemplate, CardSignFunction sign) {
+        return [cmsTemplate = std::move(cmsTemplate), sign = std::move(sign)](const std::vector<uint8_t>& digestInfo) {
+            std::vector<uint8_t> signature = sign(digestInfo);
+            if (IsCardSignatureSelfCheckEnabled() && !cmsTemplate->CheckCardSignature(digestInfo, signature)) {
+                throw CardSignatureMismatch("Card signature does not match the certificate public key (wrong keyIndex?).");
+            }
+            return signature;
+        };
+    }
+
+    CmsTemplateCache& CmsTemplateCache::Instance() {
+        static CmsTemplateCache instance;
+        return instance;
+    }
+
+    std::shared_ptr<const CmsTemplate> CmsTemplateCache::GetOrCreate(const std::vector<uint8_t>& certificate) {
+        auto digest = Sha256(certificate.data(), certificate.size());
+        std::string key(digest.begin(), digest.end());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it != entries_.end()) {
+                ++hits_;
+                return it->second;
+            }
+            ++misses_;
+        }
+
+        // Dựng template ngoài khóa; hai luồng cùng miss chỉ tốn thêm một lần parse.
+        auto tpl = CmsTemplate::Create(certificate);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (entries_.size() >= kMaxEntries) entries_.clear();
+        entries_.emplace(key, tpl);
+        return tpl;
+    }
+
+    void CmsTemplateCache::Clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+    }
+
+    size_t CmsTemplateCache::GetHitCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return hits_;
+    }
+
+    size_t CmsTemplateCache::GetMissCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return misses_;
+    }
+
+#ifdef HAVE_PODOFO
+    CardCmsSigner::CardCmsSigner(std::shared_ptr<const CmsTemplate> cmsTemplate, CardSignFunction sign)
+            : template_(std::move(cmsTemplate)), sign_(std::move(sign)), digest_ctx_(EVP_MD_CTX_new()) {
+        if (!digest_ctx_) throw std::runtime_error("EVP_MD_CTX_new failed.");
+        Reset();
+    }
+
+    CardCmsSigner::~CardCmsSigner() {
+        EVP_MD_CTX_free(digest_ctx_);
+    }
+
+    void CardCmsSigner::Reset() {
+        if (EVP_DigestInit_ex(digest_ctx_, EVP_sha256(), nullptr) != 1) {
+            throw std::runtime_error("EVP_DigestInit_ex failed.");
+        }
+    }
+
+    void CardCmsSigner::AppendData(const PoDoFo::bufferview& data) {
+        if (EVP_DigestUpdate(digest_ctx_, data.data(), data.size()) != 1) {
+            throw std::runtime_error("EVP_DigestUpdate failed.");
+        }
+    }
+
+    void CardCmsSigner::ComputeSignature(PoDoFo::charbuff& contents, bool dryrun) {
+        if (dryrun) {
+            // Kích thước đã biết chính xác từ template, không cần gọi thẻ.
+            contents.resize(template_->GetSignedDataSize());
+            return;
+        }
+
+        uint8_t digest[kSha256Length];
+        unsigned int digestLength = 0;
+        if (EVP_DigestFinal_ex(digest_ctx_, digest, &digestLength) != 1 || digestLength != kSha256Length) {
+            throw std::runtime_error("EVP_DigestFinal_ex failed.");
+        }
+
+        auto signedData = template_->BuildSignedData(digest, std::time(nullptr), sign_);
+        contents.assign(signedData.begin(), signedData.end());
+    }
+
+    std::string CardCmsSigner::GetSignatureFilter() const {
+        return "Adobe.PPKLite";
+    }
+
+    std::string CardCmsSigner::GetSignatureSubFilter() const {
+        return "adbe.pkcs7.detached";
+    }
+
+    std::string CardCmsSigner::GetSignatureType() const {
+        return "Sig";
+    }
+#endif
+
+}  // namespace nfcsigner
@@ -0,0 +1,149 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_CMS_TEMPLATE_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_CMS_TEMPLATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef HAVE_PODOFO
+#include <podofo/podofo.h>
+#endif
+
+typedef struct evp_md_ctx_st EVP_MD_CTX;
+typedef struct evp_pkey_st EVP_PKEY;
+
+namespace nfcsigner {
+
+    // Hàm ký trên thẻ: nhận DigestInfo SHA-256, trả về chữ ký RSA thô (không kèm SW1/SW2).
+    using CardSignFunction = std::function<std::vector<uint8_t>(const std::vector<uint8_t>& digestInfo)>;
+
+    // Độ dài digest SHA-256.
+    constexpr size_t kSha256Length = 32;
+
+    // Đóng gói một digest SHA-256 vào cấu trúc DigestInfo (PKCS#1) để gửi cho thẻ.
+    std::vector<uint8_t> CreateSha256DigestInfo(const uint8_t* digest);
+
+    // Tự kiểm tra chữ ký thẻ trả về bằng khóa công khai của certificate trước
+    // khi dựng tài liệu (mặc định tắt, áp dụng cho cả tiến trình). Sai keyIndex
+    // hay chuỗi GET RESPONSE bị cắt được phát hiện ngay, không phải sau khi
+    // đã ghi xong tài liệu.
+    void SetCardSignatureSelfCheck(bool enabled);
+    bool IsCardSignatureSelfCheckEnabled();
+
+    // Chữ ký từ thẻ không khớp khóa công khai của certificate. Plugin và
+    // nfcsignerd báo bằng mã lỗi SIGNATURE_MISMATCH.
+    class CardSignatureMismatch : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // SignedData (CMS, detached, RSA + SHA-256) dựng sẵn cho một certificate.
+    // signedAttrs có signingCertificateV2 nên đạt mức CAdES-BES.
+    //
+    // Toàn bộ DER bất biến (certificate, issuer/serial, định danh thuật toán,
+    // khung signedAttrs) được tạo một lần. Mỗi lần ký chỉ vá signingTime,
+    // messageDigest và giá trị chữ ký, nên kích thước đầu ra luôn cố định và
+    // biết trước từ độ dài khóa - không cần dry run.
+    class CmsTemplate {
+    public:
+        // Phân tích certificate và dựng template. Ném std::runtime_error nếu
+        // certificate không hợp lệ hoặc không phải khóa RSA.
+        static std::shared_ptr<const CmsTemplate> Create(const std::vector<uint8_t>& certificate);
+
+        // Kích thước chính xác của SignedData (dùng cho placeholder /Contents).
+        size_t GetSignedDataSize() const { return der_.size(); }
+
+        // Độ dài chữ ký RSA (bằng độ dài modulus).
+        size_t GetSignatureSize() const { return signature_size_; }
+
+        const std::vector<uint8_t>& GetCertificate() const { return certificate_; }
+
+        // [signature] (RSA thô từ thẻ) có đúng là chữ ký PKCS#1 v1.5 của
+        // [digestInfo] theo khóa công khai của certificate không. Khóa được đọc
+        // một lần khi dựng template.
+        bool CheckCardSignature(const std::vector<uint8_t>& digestInfo, const std::vector<uint8_t>& signature) const;
+
+        // Dựng SignedData cho digest nội dung [contentDigest] (SHA-256).
+        // [sign] được gọi đúng một lần với DigestInfo của signedAttrs. Nếu tự
+        // kiểm tra được bật, ném CardSignatureMismatch khi chữ ký sai.
+        std::vector<uint8_t> BuildSignedData(const uint8_t* contentDigest, std::time_t signingTime,
+                                             const CardSignFunction& sign) const;
+
+    private:
+        CmsTemplate() = default;
+
+        std::vector<uint8_t> certificate_;
+        std::shared_ptr<EVP_PKEY> public_key_;
+        std::vector<uint8_t> der_;
+        size_t signed_attrs_offset_ = 0;
+        size_t signed_attrs_length_ = 0;
+        size_t signing_time_offset_ = 0;
+        size_t message_digest_offset_ = 0;
+        size_t signature_offset_ = 0;
+        size_t signature_size_ = 0;
+    };
+
+    // Cache CmsTemplate theo SHA-256 của certificate. Dùng chung cho cả tiến trình.
+    class CmsTemplateCache {
+    public:
+        static CmsTemplateCache& Instance();
+
+        std::shared_ptr<const CmsTemplate> GetOrCreate(const std::vector<uint8_t>& certificate);
+
+        void Clear();
+        size_t GetHitCount() const;
+        size_t GetMissCount() const;
+
+    private:
+        CmsTemplateCache() = default;
+
+        // Giới hạn số certificate được giữ (mỗi thẻ thường chỉ có một).
+        static constexpr size_t kMaxEntries = 16;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, std::shared_ptr<const CmsTemplate>> entries_;
+        size_t hits_ = 0;
+        size_t misses_ = 0;
+    };
+
+    // Bọc [sign] cho các đường ký không đi qua BuildSignedData (XML, chữ ký
+    // thô): khi tự kiểm tra được bật, chữ ký từ thẻ được đối chiếu với
+    // [cmsTemplate] và ném CardSignatureMismatch nếu sai.
+    CardSignFunction WithCardSignatureSelfCheck(std::shared_ptr<const CmsTemplate> cmsTemplate, CardSignFunction sign);
+
+#ifdef HAVE_PODOFO
+    // PdfSigner dùng CmsTemplate: băm ByteRange bằng EVP theo từng đoạn PoDoFo
+    // đưa vào và trả về kích thước /Contents chính xác ở lượt dry run mà không
+    // chạm tới thẻ.
+    class CardCmsSigner : public PoDoFo::PdfSigner {
+    public:
+        CardCmsSigner(std::shared_ptr<const CmsTemplate> cmsTemplate, CardSignFunction sign);
+        ~CardCmsSigner() override;
+
+        CardCmsSigner(const CardCmsSigner&) = delete;
+        CardCmsSigner& operator=(const CardCmsSigner&) = delete;
+
+        void Reset() override;
+        void AppendData(const PoDoFo::bufferview& data) override;
+        void ComputeSignature(PoDoFo::charbuff& contents, bool dryrun) override;
+        std::string GetSignatureFilter() const override;
+        std::string GetSignatureSubFilter() const override;
+        std::string GetSignatureType() const override;
+
+    private:
+        std::shared_ptr<const CmsTemplate> template_;
+        CardSignFunction sign_;
+        EVP_MD_CTX* digest_ctx_ = nullptr;
+    };
+#endif
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_CMS_TEMPLATE_H_
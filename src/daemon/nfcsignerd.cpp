@@ -0,0 +1,460 @@
+// nfcsignerd: dịch vụ ký headless giữ toàn bộ reader cho mọi tiến trình trên
+// máy (ERP, mail gateway, ứng dụng desktop). Client gửi request theo giao
+// thức nhị phân trong daemon_protocol.h qua Unix domain socket (Linux) hoặc
+// named pipe (Windows).
+//
+// Mỗi kết nối chiếm một luồng của nhóm cố định (tối đa kMaxClients kết nối
+// cùng lúc, thêm ngần ấy chờ lượt; quá nữa thì trả CARD_BUSY và đóng). Mỗi
+// kết nối xử lý lần lượt từng request; các client đồng thời được xếp
+// lượt trên reader bằng CardScheduler (certificate/khóa công khai/ký thô:
+// Interactive, PDF/XML: Bulk). Kết nối thẻ, certificate đã đọc, CMS template
+// và appearance được giữ giữa các request nên chỉ request đầu tiên phải trả
+// giá khởi động. Hủy request đang chạy bằng op Cancel từ một kết nối khác.
+//
+//   nfcsignerd [--socket PATH] [--socket-group GROUP] [--socket-mode MODE]
+//              [--self-check] [--software-card KEY.pem CERT.pem [--pin PIN]]
+//
+// Socket mặc định chỉ mở cho người dùng hiện tại (0600); --socket-group cho
+// một nhóm dùng chung (quyền mặc định 0660, đổi bằng --socket-mode, bát phân).
+// --software-card chạy với thẻ mềm (software_card.h) để thử cục bộ, không
+// cần reader.
+
+#include "cancellation.h"
+#include "card_scheduler.h"
+#include "cms_template.h"
+#include "daemon_protocol.h"
+#include "local_socket.h"
+#include "pdf_signer.h"
+#include "request_arena.h"
+#include "signing_card.h"
+#include "signing_metrics.h"
+#include "single_flight.h"
+#include "software_card.h"
+#include "worker_pool.h"
+#include "xml_dsig.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_PODOFO
+#include <podofo/podofo.h>
+#endif
+
+namespace nfcsigner {
+namespace {
+
+    LocalListener* g_listener = nullptr;
+
+#ifdef _WIN32
+    BOOL WINAPI OnConsoleControl(DWORD) {
+        if (g_listener) g_listener->Shutdown();
+        return TRUE;
+    }
+#else
+    void OnSignal(int) {
+        if (g_listener) g_listener->Shutdown();
+    }
+#endif
+
+    // Tham số request sai hoặc thiếu (mã INVALID_PARAMETERS).
+    class InvalidParameters : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    DaemonMessage MakeResult(std::vector<uint8_t> result) {
+        DaemonMessage response;
+        response.code = static_cast<uint8_t>(DaemonStatus::Ok);
+        response.SetBytes(DaemonField::Result, std::move(result));
+        return response;
+    }
+
+    DaemonMessage MakeResult(const std::string& result) {
+        return MakeResult(std::vector<uint8_t>(result.begin(), result.end()));
+    }
+
+    class SigningDaemon {
+    public:
+        static constexpr size_t kMaxClients = 16;
+
+        explicit SigningDaemon(std::shared_ptr<SigningCard> card)
+                : card_(std::move(card)), clients_(kMaxClients, kMaxClients) {}
+
+        // Luồng client không được dùng daemon sau khi nó bị hủy.
+        ~SigningDaemon() { Stop(); }
+
+        // Chạy tới khi [listener] bị Shutdown(), rồi đóng mọi kết nối và chờ
+        // các request đang chạy xong.
+        void Serve(LocalListener& listener) {
+            while (auto connection = listener.Accept()) {
+                std::shared_ptr<LocalConnection> client(std::move(connection));
+                if (!Track(client)) break;
+                if (!clients_.Submit([this, client]() {
+                    ServeClient(*client);
+                    Untrack(client);
+                })) {
+                    Untrack(client);
+                    try {
+                        client->WriteFrame(EncodeDaemonMessage(MakeDaemonError("CARD_BUSY", "Too many clients")));
+                    } catch (const std::exception&) {
+                    }
+                }
+            }
+            Stop();
+        }
+
+        void Stop() {
+            {
+                std::lock_guard<std::mutex> lock(clients_mutex_);
+                stopping_ = true;
+                for (const auto& client : connections_) client->Shutdown();
+            }
+            // Kết nối còn chờ trong hàng đợi đã bị đóng nên chạy xong ngay.
+            clients_.Shutdown();
+        }
+
+    private:
+        bool Track(const std::shared_ptr<LocalConnection>& client) {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            if (stopping_) return false;
+            connections_.insert(client);
+            return true;
+        }
+
+        void Untrack(const std::shared_ptr<LocalConnection>& client) {
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            connections_.erase(client);
+        }
+
+        void ServeClient(LocalConnection& connection) {
+            try {
+                std::vector<uint8_t> frame;
+                while (connection.ReadFrame(frame)) {
+                    DaemonMessage response;
+                    try {
+                        response = Handle(DecodeDaemonMessage(frame.data(), frame.size()));
+                    } catch (const std::exception& e) {
+                        response = MakeDaemonError("INVALID_REQUEST", e.what());
+                    }
+                    connection.WriteFrame(EncodeDaemonMessage(response));
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "nfcsignerd: client dropped: " << e.what() << std::endl;
+            }
+        }
+
+        DaemonMessage Handle(const DaemonMessage& request) {
+            auto op = static_cast<DaemonOp>(request.code);
+            if (op == DaemonOp::Ping) return MakeResult(std::string("nfcsignerd"));
+            // Cancel chạy ngay, không tạo token cho chính nó.
+            if (op == DaemonOp::Cancel) {
+                bool cancelled = CancellationRegistry::Instance().Cancel(request.GetString(DaemonField::RequestId, ""));
+                DaemonMessage response;
+                response.code = static_cast<uint8_t>(DaemonStatus::Ok);
+                response.SetInt(DaemonField::Result, cancelled ? 1 : 0);
+                return response;
+            }
+
+            RequestCancellation cancellation(request.GetString(DaemonField::RequestId, ""),
+                                             request.GetInt(DaemonField::DeadlineMs, 0));
+            try {
+                switch (op) {
+                    case DaemonOp::GetCertificate: return HandleGetCertificate(request);
+                    case DaemonOp::GetRsaPublicKey: return HandleGetRsaPublicKey(request);
+                    case DaemonOp::Sign: return HandleSign(request);
+                    case DaemonOp::SignPdf: return HandleSignPdf(request);
+                    case DaemonOp::SignXml: return HandleSignXml(request);
+                    default:
+                        return MakeDaemonError("NOT_IMPLEMENTED", "Unknown op " + std::to_string(request.code));
+                }
+            } catch (const InvalidParameters& e) {
+                return MakeDaemonError("INVALID_PARAMETERS", e.what());
+            } catch (const CardBusyError& e) {
+                return MakeDaemonError("CARD_BUSY", e.what());
+            } catch (const CardSignatureMismatch& e) {
+                return MakeDaemonError("SIGNATURE_MISMATCH", e.what());
+            } catch (const OperationCancelled& e) {
+                return MakeDaemonError(e.IsDeadlineExceeded() ? "DEADLINE_EXCEEDED" : "CANCELLED", e.what());
+#ifdef HAVE_PODOFO
+            } catch (const PoDoFo::PdfError& e) {
+                return MakeCancellableError(cancellation, "PODOFO_ERROR", std::string("PoDoFo Error: ") + e.what());
+#endif
+            } catch (const std::exception& e) {
+                return MakeCancellableError(cancellation, "STD_EXCEPTION", e.what());
+            }
+        }
+
+        // Request đã bị hủy/hết hạn: lỗi của bước đang chạy dở (SCardCancel...)
+        // được báo bằng mã CANCELLED/DEADLINE_EXCEEDED như phía MethodChannel.
+        static DaemonMessage MakeCancellableError(const RequestCancellation& cancellation, const std::string& code,
+                                                  const std::string& message) {
+            const auto& token = cancellation.GetToken();
+            if (token && token->IsCancelled()) {
+                return MakeDaemonError(token->IsDeadlineExceeded() ? "DEADLINE_EXCEEDED" : "CANCELLED", message);
+            }
+            return MakeDaemonError(code, message);
+        }
+
+        template<typename T, typename Read>
+        static T Param(Read&& read) {
+            try {
+                return read();
+            } catch (const std::runtime_error& e) {
+                throw InvalidParameters(e.what());
+            }
+        }
+
+        DaemonMessage HandleGetCertificate(const DaemonMessage& request) {
+            auto appletID = Param<std::string>([&]() { return request.GetString(DaemonField::AppletId); });
+            // Nhiều tiến trình thường đọc certificate cùng lúc: dùng chung một lượt đọc.
+            return MakeResult(reads_.Do("getCertificate|" + appletID, [&]() {
+                std::vector<uint8_t> certificate;
+                card_->WithChannel(appletID, CardPriority::Interactive, [&](CardChannel& channel) {
+                    certificate = channel.ReadCertificate();
+                });
+                return certificate;
+            }));
+        }
+
+        DaemonMessage HandleGetRsaPublicKey(const DaemonMessage& request) {
+            auto appletID = Param<std::string>([&]() { return request.GetString(DaemonField::AppletId); });
+            auto keyRole = Param<std::string>([&]() { return request.GetString(DaemonField::KeyRole); });
+            return MakeResult(reads_.Do("getRsaPublicKey|" + appletID + "|" + keyRole, [&]() {
+                std::vector<uint8_t> key;
+                card_->WithChannel(appletID, CardPriority::Interactive, [&](CardChannel& channel) {
+                    key = channel.ReadRsaPublicKey(keyRole);
+                });
+                return key;
+            }));
+        }
+
+        DaemonMessage HandleSign(const DaemonMessage& request) {
+            auto appletID = Param<std::string>([&]() { return request.GetString(DaemonField::AppletId); });
+            auto pin = Param<std::string>([&]() { return request.GetString(DaemonField::Pin); });
+            auto keyIndex = Param<int64_t>([&]() { return request.GetInt(DaemonField::KeyIndex, 0); });
+            const auto& data = Param<std::vector<uint8_t>>([&]() { return request.GetBytes(DaemonField::Data); });
+
+            std::vector<uint8_t> signature;
+            card_->WithChannel(appletID, CardPriority::Interactive, [&](CardChannel& channel) {
+                CardSignFunction cardSign = [&](const std::vector<uint8_t>& digestInfo) {
+                    return channel.ComputeSignature(digestInfo, static_cast<int>(keyIndex));
+                };
+                if (IsCardSignatureSelfCheckEnabled()) {
+                    cardSign = WithCardSignatureSelfCheck(CmsTemplateCache::Instance().GetOrCreate(channel.ReadCertificate()),
+                                                          cardSign);
+                }
+                channel.VerifyPin(pin);
+                signature = cardSign(data);
+            });
+            return MakeResult(std::move(signature));
+        }
+
+        DaemonMessage HandleSignPdf(const DaemonMessage& request) {
+#ifdef HAVE_PODOFO
+            auto appletID = Param<std::string>([&]() { return request.GetString(DaemonField::AppletId); });
+            auto pin = Param<std::string>([&]() { return request.GetString(DaemonField::Pin); });
+            auto keyIndex = Param<int64_t>([&]() { return request.GetInt(DaemonField::KeyIndex, 0); });
+            const auto pdfBytes = Param<std::vector<uint8_t>>([&]() { return request.GetBytes(DaemonField::Data); });
+            auto reason = Param<std::string>([&]() { return request.GetString(DaemonField::Reason, ""); });
+            auto location = Param<std::string>([&]() { return request.GetString(DaemonField::Location, ""); });
+            auto signDate = Param<std::string>([&]() { return request.GetString(DaemonField::SignDate, ""); });
+            auto pageNumber = static_cast<int>(Param<int64_t>([&]() { return request.GetInt(DaemonField::PageNumber, 1); }));
+            SignatureAppearanceConfig appearance;
+            Param<int>([&]() {
+                // Vị trí/kích thước gửi theo 1/1000 pt.
+                if (request.Has(DaemonField::X)) appearance.x = request.GetInt(DaemonField::X) / 1000.0;
+                if (request.Has(DaemonField::Y)) appearance.y = request.GetInt(DaemonField::Y) / 1000.0;
+                if (request.Has(DaemonField::Width)) appearance.width = request.GetInt(DaemonField::Width) / 1000.0;
+                if (request.Has(DaemonField::Height)) appearance.height = request.GetInt(DaemonField::Height) / 1000.0;
+                appearance.signerName = request.GetString(DaemonField::SignerName, appearance.signerName);
+                appearance.contact = request.GetString(DaemonField::Contact, appearance.contact);
+                return 0;
+            });
+
+            // Nhánh PDF bắt đầu ngay, kể cả trong lúc chờ lượt dùng reader. Xref và
+            // object mà đường ký từng phần đọc nằm trong arena của request; tài liệu
+            // PoDoFo của đường dự phòng vẫn dùng heap.
+            RequestArena arena;
+            RequestArena::Scope arenaScope(&arena);
+            SignPdfMetrics metrics;
+            PhaseTimer totalTimer;
+            std::promise<void> parsed;
+            auto parsedFuture = parsed.get_future();
+            auto preparedFuture = std::async(std::launch::async, [&]() {
+                RequestArena::Scope scope(&arena);
+                return PreparePdf(pdfBytes, pageNumber, appearance, signDate, reason, location, parsed, metrics);
+            });
+
+            std::vector<uint8_t> signedPdf;
+            card_->WithChannel(appletID, CardPriority::Bulk, [&](CardChannel& channel) {
+                PhaseTimer cardTimer;
+                auto certificate = channel.ReadCertificate();
+                metrics.cardPreambleUs = cardTimer.ElapsedUs();
+
+                // PDF hỏng thì dừng trước VERIFY để không tốn một lần thử PIN.
+                try {
+                    parsedFuture.get();
+                } catch (const std::exception& e) {
+                    throw InvalidParameters(std::string("PDF không hợp lệ: ") + e.what());
+                }
+
+                PhaseTimer verifyTimer;
+                channel.VerifyPin(pin);
+                metrics.verifyPinUs = verifyTimer.ElapsedUs();
+
+                PhaseTimer joinTimer;
+                PreparedPdf prepared = preparedFuture.get();
+                metrics.joinWaitUs = joinTimer.ElapsedUs();
+                metrics.parallelUs = totalTimer.ElapsedUs();
+                ThrowIfCancelled();
+
+                PhaseTimer signTimer;
+                auto cmsTemplate = CmsTemplateCache::Instance().GetOrCreate(certificate);
+                CardSignFunction cardSign = [&](const std::vector<uint8_t>& digestInfo) {
+                    return channel.ComputeSignature(digestInfo, static_cast<int>(keyIndex));
+                };
+
+                LazyPdfSignParams params;
+                params.pageNumber = pageNumber > 0 ? pageNumber : 1;
+                params.x = appearance.x;
+                params.y = appearance.y;
+                params.width = appearance.width;
+                params.height = appearance.height;
+                params.reason = reason;
+                params.location = location;
+                params.signerName = appearance.signerName;
+                params.signingTime = std::time(nullptr);
+                signedPdf = SignPreparedPdf(prepared, pdfBytes, params, signDate, appearance, cmsTemplate, cardSign);
+                metrics.signUs = signTimer.ElapsedUs();
+                metrics.totalUs = totalTimer.ElapsedUs();
+                metrics.incremental = prepared.lazyDocument != nullptr;
+            });
+            SigningMetrics::Instance().Record(metrics);
+            std::cout << "signPdf: " << signedPdf.size() << " bytes, total " << metrics.totalUs << " us" << std::endl;
+            return MakeResult(std::move(signedPdf));
+#else
+            (void)request;
+            return MakeDaemonError("PDF_SIGN_ERROR", "PoDoFo not available in this build");
+#endif
+        }
+
+        DaemonMessage HandleSignXml(const DaemonMessage& request) {
+            auto appletID = Param<std::string>([&]() { return request.GetString(DaemonField::AppletId); });
+            auto pin = Param<std::string>([&]() { return request.GetString(DaemonField::Pin); });
+            auto keyIndex = Param<int64_t>([&]() { return request.GetInt(DaemonField::KeyIndex, 0); });
+            auto xmlContent = Param<std::string>([&]() { return request.GetString(DaemonField::Data); });
+            XmlDsigConfig config;
+            config.referenceUri = Param<std::string>([&]() { return request.GetString(DaemonField::ReferenceUri, ""); });
+            config.xpath = Param<std::string>([&]() { return request.GetString(DaemonField::XPath, ""); });
+
+            // Chuẩn hóa và băm reference trước khi chờ reader: không giữ thẻ
+            // của các client khác trong lúc xử lý XML.
+            std::unique_ptr<XmlDsigDocument> document;
+            try {
+                document = std::make_unique<XmlDsigDocument>(std::move(xmlContent), config);
+            } catch (const std::exception& e) {
+                throw InvalidParameters(std::string("XML không hợp lệ: ") + e.what());
+            }
+
+            std::string signedXml;
+            card_->WithChannel(appletID, CardPriority::Bulk, [&](CardChannel& channel) {
+                auto certificate = channel.ReadCertificate();
+                channel.VerifyPin(pin);
+                CardSignFunction cardSign = [&](const std::vector<uint8_t>& digestInfo) {
+                    return channel.ComputeSignature(digestInfo, static_cast<int>(keyIndex));
+                };
+                if (IsCardSignatureSelfCheckEnabled()) {
+                    cardSign = WithCardSignatureSelfCheck(CmsTemplateCache::Instance().GetOrCreate(certificate), cardSign);
+                }
+                signedXml = document->Sign(certificate, cardSign);
+            });
+            return MakeResult(signedXml);
+        }
+
+        std::shared_ptr<SigningCard> card_;
+        SingleFlight reads_;
+        std::mutex clients_mutex_;
+        std::set<std::shared_ptr<LocalConnection>> connections_;
+        bool stopping_ = false;
+        // Khai báo cuối: bị hủy (join) trước các thành viên mà luồng client dùng.
+        WorkerPool clients_;
+    };
+
+    void PrintUsage() {
+        std::cerr << "Usage: nfcsignerd [--socket PATH] [--socket-group GROUP] [--socket-mode MODE]\n"
+                     "                  [--self-check] [--software-card KEY.pem CERT.pem [--pin PIN]]\n";
+    }
+
+}  // namespace
+}  // namespace nfcsigner
+
+int main(int argc, char** argv) {
+    using namespace nfcsigner;
+
+    std::string endpoint = DefaultDaemonEndpoint();
+    std::string softwareKey;
+    std::string softwareCertificate;
+    std::string softwarePin = "123456";
+    LocalListenerOptions listenerOptions;
+    bool socketModeSet = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            endpoint = argv[++i];
+        } else if (arg == "--socket-group" && i + 1 < argc) {
+            listenerOptions.group = argv[++i];
+            if (!socketModeSet) listenerOptions.mode = 0660;
+        } else if (arg == "--socket-mode" && i + 1 < argc) {
+            listenerOptions.mode = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 8));
+            socketModeSet = true;
+        } else if (arg == "--software-card" && i + 2 < argc) {
+            softwareKey = argv[++i];
+            softwareCertificate = argv[++i];
+        } else if (arg == "--pin" && i + 1 < argc) {
+            softwarePin = argv[++i];
+        } else if (arg == "--self-check") {
+            SetCardSignatureSelfCheck(true);
+        } else {
+            PrintUsage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    try {
+        std::shared_ptr<SigningCard> card;
+        if (!softwareKey.empty()) {
+            card = SoftwareSigningCard::FromFiles(softwareKey, softwareCertificate, softwarePin);
+            std::cout << "nfcsignerd: using software card " << softwareCertificate << std::endl;
+        } else {
+            card = std::make_shared<PcscSigningCard>();
+        }
+
+        auto listener = LocalListener::Listen(endpoint, listenerOptions);
+        g_listener = listener.get();
+#ifdef _WIN32
+        SetConsoleCtrlHandler(OnConsoleControl, TRUE);
+#else
+        std::signal(SIGINT, OnSignal);
+        std::signal(SIGTERM, OnSignal);
+#endif
+        std::cout << "nfcsignerd: listening on " << endpoint << std::endl;
+
+        SigningDaemon daemon(card);
+        daemon.Serve(*listener);
+        g_listener = nullptr;
+        std::cout << "nfcsignerd: stopped" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "nfcsignerd: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
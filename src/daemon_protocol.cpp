@@ -0,0 +1,119 @@
+#include "daemon_protocol.h"
+
+#include <stdexcept>
+
+namespace nfcsigner {
+
+    namespace {
+
+        void AppendUint32(std::vector<uint8_t>& out, uint32_t value) {
+            out.push_back(static_cast<uint8_t>(value >> 24));
+            out.push_back(static_cast<uint8_t>(value >> 16));
+            out.push_back(static_cast<uint8_t>(value >> 8));
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        uint32_t ReadUint32(const uint8_t* p) {
+            return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                   (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+        }
+
+        std::runtime_error MissingField(DaemonField field) {
+            return std::runtime_error("Missing field " + std::to_string(static_cast<int>(field)));
+        }
+
+    }  // namespace
+
+    void DaemonMessage::SetBytes(DaemonField field, std::vector<uint8_t> value) {
+        fields[field] = std::move(value);
+    }
+
+    void DaemonMessage::SetString(DaemonField field, const std::string& value) {
+        fields[field] = std::vector<uint8_t>(value.begin(), value.end());
+    }
+
+    void DaemonMessage::SetInt(DaemonField field, int64_t value) {
+        std::vector<uint8_t> bytes(8);
+        for (int i = 7; i >= 0; --i) {
+            bytes[i] = static_cast<uint8_t>(value);
+            value = static_cast<int64_t>(static_cast<uint64_t>(value) >> 8);
+        }
+        fields[field] = std::move(bytes);
+    }
+
+    const std::vector<uint8_t>& DaemonMessage::GetBytes(DaemonField field) const {
+        auto it = fields.find(field);
+        if (it == fields.end()) throw MissingField(field);
+        return it->second;
+    }
+
+    std::string DaemonMessage::GetString(DaemonField field) const {
+        const auto& bytes = GetBytes(field);
+        return std::string(bytes.begin(), bytes.end());
+    }
+
+    int64_t DaemonMessage::GetInt(DaemonField field) const {
+        const auto& bytes = GetBytes(field);
+        if (bytes.size() != 8) {
+            throw std::runtime_error("Field " + std::to_string(static_cast<int>(field)) + " is not an int64");
+        }
+        uint64_t value = 0;
+        for (uint8_t byte : bytes) value = (value << 8) | byte;
+        return static_cast<int64_t>(value);
+    }
+
+    std::string DaemonMessage::GetString(DaemonField field, const std::string& defaultValue) const {
+        return Has(field) ? GetString(field) : defaultValue;
+    }
+
+    int64_t DaemonMessage::GetInt(DaemonField field, int64_t defaultValue) const {
+        return Has(field) ? GetInt(field) : defaultValue;
+    }
+
+    std::vector<uint8_t> EncodeDaemonMessage(const DaemonMessage& message) {
+        size_t size = 2;
+        for (const auto& field : message.fields) size += 5 + field.second.size();
+        if (size > kDaemonMaxFrameSize) throw std::runtime_error("Daemon message too large");
+
+        std::vector<uint8_t> out;
+        out.reserve(size);
+        out.push_back(kDaemonProtocolVersion);
+        out.push_back(message.code);
+        for (const auto& field : message.fields) {
+            out.push_back(static_cast<uint8_t>(field.first));
+            AppendUint32(out, static_cast<uint32_t>(field.second.size()));
+            out.insert(out.end(), field.second.begin(), field.second.end());
+        }
+        return out;
+    }
+
+    DaemonMessage DecodeDaemonMessage(const uint8_t* data, size_t size) {
+        if (size < 2) throw std::runtime_error("Daemon message truncated");
+        if (data[0] != kDaemonProtocolVersion) {
+            throw std::runtime_error("Unsupported daemon protocol version " + std::to_string(data[0]));
+        }
+
+        DaemonMessage message;
+        message.code = data[1];
+        size_t offset = 2;
+        while (offset < size) {
+            if (size - offset < 5) throw std::runtime_error("Daemon message truncated");
+            auto tag = static_cast<DaemonField>(data[offset]);
+            uint32_t length = ReadUint32(data + offset + 1);
+            offset += 5;
+            if (length > size - offset) throw std::runtime_error("Daemon message truncated");
+            message.fields[tag].assign(data + offset, data + offset + length);
+            offset += length;
+        }
+        return message;
+    }
+
+    DaemonMessage MakeDaemonError(const std::string& code, const std::string& message) {
+        DaemonMessage error;
+        error.code = static_cast<uint8_t>(DaemonStatus::Error);
+        error.SetString(DaemonField::ErrorCode, code);
+        error.SetString(DaemonField::ErrorMessage, message);
+        return error;
+    }
+
+}  // namespace nfcsigner
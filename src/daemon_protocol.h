@@ -0,0 +1,99 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_DAEMON_PROTOCOL_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_DAEMON_PROTOCOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace nfcsigner {
+
+    // Giao thức nhị phân của nfcsignerd trên Unix domain socket / named pipe.
+    //
+    // Mỗi frame: độ dài thân (uint32 big-endian) rồi thân:
+    //   version (1 byte) | code (1 byte) | các field
+    // Mỗi field: tag (1 byte) | độ dài (uint32 big-endian) | giá trị.
+    // Request: code là DaemonOp. Response: code là DaemonStatus, kết quả nằm
+    // trong field Result, lỗi trong ErrorCode/ErrorMessage (cùng mã lỗi với
+    // MethodChannel: CARD_BUSY, CANCELLED, DEADLINE_EXCEEDED, ...). Số nguyên
+    // là int64 big-endian, chuỗi là UTF-8, dữ liệu nhị phân giữ nguyên - không
+    // cần base64 như JSON.
+    constexpr uint8_t kDaemonProtocolVersion = 1;
+
+    // Giới hạn thân frame: PDF lớn nhất được nhận.
+    constexpr uint32_t kDaemonMaxFrameSize = 256u * 1024 * 1024;
+
+    enum class DaemonOp : uint8_t {
+        Ping = 0,
+        GetCertificate = 1,
+        GetRsaPublicKey = 2,
+        Sign = 3,
+        SignPdf = 4,
+        SignXml = 5,
+        Cancel = 6,
+    };
+
+    enum class DaemonStatus : uint8_t {
+        Ok = 0,
+        Error = 1,
+    };
+
+    enum class DaemonField : uint8_t {
+        // Tham số
+        AppletId = 1,
+        Pin = 2,
+        KeyIndex = 3,
+        KeyRole = 4,
+        Data = 5,               // dữ liệu ký thô, PDF hoặc XML
+        Reason = 6,
+        Location = 7,
+        PageNumber = 8,
+        SignDate = 9,
+        X = 10,                 // vị trí/kích thước appearance, đơn vị 1/1000 pt
+        Y = 11,
+        Width = 12,
+        Height = 13,
+        SignerName = 14,
+        Contact = 15,
+        RequestId = 16,
+        DeadlineMs = 17,
+        ReferenceUri = 18,      // XmlDsigConfig
+        XPath = 19,
+        // Kết quả
+        Result = 64,
+        ErrorCode = 65,
+        ErrorMessage = 66,
+    };
+
+    // Một request hoặc response đã giải mã.
+    struct DaemonMessage {
+        uint8_t code = 0;
+        std::map<DaemonField, std::vector<uint8_t>> fields;
+
+        bool Has(DaemonField field) const { return fields.count(field) != 0; }
+
+        void SetBytes(DaemonField field, std::vector<uint8_t> value);
+        void SetString(DaemonField field, const std::string& value);
+        void SetInt(DaemonField field, int64_t value);
+
+        // Ném std::runtime_error nếu thiếu field bắt buộc hoặc sai kiểu.
+        const std::vector<uint8_t>& GetBytes(DaemonField field) const;
+        std::string GetString(DaemonField field) const;
+        int64_t GetInt(DaemonField field) const;
+
+        std::string GetString(DaemonField field, const std::string& defaultValue) const;
+        int64_t GetInt(DaemonField field, int64_t defaultValue) const;
+    };
+
+    // Thân frame (không gồm 4 byte độ dài).
+    std::vector<uint8_t> EncodeDaemonMessage(const DaemonMessage& message);
+
+    // Ném std::runtime_error nếu thân frame hỏng hoặc khác version.
+    DaemonMessage DecodeDaemonMessage(const uint8_t* data, size_t size);
+
+    DaemonMessage MakeDaemonError(const std::string& code, const std::string& message);
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_DAEMON_PROTOCOL_H_
@@ -0,0 +1,199 @@
+#include "file_digest.h"
+
+#include <openssl/evp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "cancellation.h"
+
+namespace nfcsigner {
+
+    namespace {
+
+        namespace fs = std::filesystem;
+
+        // Khối đọc: đủ lớn để SHA-256 của OpenSSL chạy hết tốc độ và ít lời gọi hệ thống.
+        constexpr size_t kChunkSize = 4 * 1024 * 1024;
+
+        fs::path FromUtf8(const std::string& path) {
+            // fs::u8path bị deprecated từ C++20; lõi build ở C++17 (chưa có
+            // char8_t) cùng plugin, hoặc C++20 khi ứng dụng nâng chuẩn hay bật
+            // NFCSIGNER_ENABLE_COROUTINES.
+#if defined(__cpp_char8_t)
+            return fs::path(std::u8string(path.begin(), path.end()));
+#else
+            return fs::u8path(path);
+#endif
+        }
+
+        std::string ToUtf8(const fs::path& path) {
+            auto text = path.u8string();
+            return std::string(text.begin(), text.end());
+        }
+
+    }  // namespace
+
+    void UpdateDigestFromFile(EVP_MD_CTX* ctx, const std::string& path, CancellationToken* cancellation) {
+        std::ifstream in(FromUtf8(path), std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("Không mở được file: " + path);
+        }
+
+        // Hai bộ đệm luân phiên giữa một luồng đọc cho cả file và luồng băm:
+        // đọc khối sau song song với băm khối trước. ready[i]: khối i đã đọc,
+        // chờ băm; stop: bên băm dừng (xong, lỗi hoặc bị hủy).
+        std::vector<char> buffers[2] = { std::vector<char>(kChunkSize), std::vector<char>(kChunkSize) };
+        size_t lengths[2] = { 0, 0 };
+        bool ready[2] = { false, false };
+        bool stop = false;
+        std::exception_ptr readError;
+        std::mutex mutex;
+        std::condition_variable changed;
+
+        std::thread reader([&]() {
+            for (size_t index = 0;; index ^= 1) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() { return stop || !ready[index]; });
+                    if (stop) return;
+                }
+                in.read(buffers[index].data(), static_cast<std::streamsize>(kChunkSize));
+                bool failed = in.bad();
+                size_t length = static_cast<size_t>(in.gcount());
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (failed) readError = std::make_exception_ptr(std::runtime_error("Lỗi đọc file."));
+                    lengths[index] = length;
+                    ready[index] = true;
+                }
+                changed.notify_all();
+                if (failed || length < kChunkSize) return;
+            }
+        });
+
+        auto finish = [&]() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+            }
+            changed.notify_all();
+            reader.join();
+        };
+
+        try {
+            for (size_t index = 0;; index ^= 1) {
+                size_t length = 0;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&]() { return ready[index]; });
+                    if (readError) std::rethrow_exception(readError);
+                    length = lengths[index];
+                }
+                if (cancellation) cancellation->ThrowIfCancelled();
+                if (length > 0 && EVP_DigestUpdate(ctx, buffers[index].data(), length) != 1) {
+                    throw std::runtime_error("EVP_DigestUpdate failed.");
+                }
+                if (length < kChunkSize) break;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ready[index] = false;
+                }
+                changed.notify_all();
+            }
+        } catch (...) {
+            // Luồng đọc dừng sau khối đang đọc dở, không đọc tiếp hết file.
+            finish();
+            throw;
+        }
+        finish();
+    }
+
+    std::vector<uint8_t> Sha256File(const std::string& path, CancellationToken* cancellation) {
+        std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+        if (!ctx || EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr) != 1) {
+            throw std::runtime_error("EVP_DigestInit_ex failed.");
+        }
+        UpdateDigestFromFile(ctx.get(), path, cancellation);
+
+        std::vector<uint8_t> digest(EVP_MAX_MD_SIZE);
+        unsigned int digestLength = 0;
+        if (EVP_DigestFinal_ex(ctx.get(), digest.data(), &digestLength) != 1) {
+            throw std::runtime_error("EVP_DigestFinal_ex failed.");
+        }
+        digest.resize(digestLength);
+        return digest;
+    }
+
+    std::vector<std::string> ExpandFilePaths(const std::vector<std::string>& paths, bool recursive) {
+        std::vector<std::string> files;
+        for (const auto& path : paths) {
+            std::error_code error;
+            fs::path root = FromUtf8(path);
+            if (!fs::is_directory(root, error)) {
+                files.push_back(path);
+                continue;
+            }
+
+            std::vector<std::string> found;
+            auto collect = [&found](const fs::directory_entry& entry) {
+                std::error_code entryError;
+                if (entry.is_regular_file(entryError)) found.push_back(ToUtf8(entry.path()));
+            };
+            if (recursive) {
+                for (fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, error), end;
+                     !error && it != end; it.increment(error)) {
+                    collect(*it);
+                }
+            } else {
+                for (fs::directory_iterator it(root, fs::directory_options::skip_permission_denied, error), end;
+                     !error && it != end; it.increment(error)) {
+                    collect(*it);
+                }
+            }
+            if (error) {
+                throw std::runtime_error("Không đọc được thư mục " + path + ": " + error.message());
+            }
+            std::sort(found.begin(), found.end());
+            files.insert(files.end(), found.begin(), found.end());
+        }
+        return files;
+    }
+
+    std::vector<FileDigest> Sha256Files(const std::vector<std::string>& paths, size_t threads) {
+        std::vector<FileDigest> results(paths.size());
+        if (paths.empty()) return results;
+
+        if (threads == 0) threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        threads = std::min(threads, paths.size());
+
+        std::atomic<size_t> next{0};
+        auto work = [&]() {
+            for (size_t index = next++; index < paths.size(); index = next++) {
+                FileDigest& result = results[index];
+                result.path = paths[index];
+                try {
+                    result.digest = Sha256File(paths[index]);
+                } catch (const std::exception& e) {
+                    result.error = e.what();
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        for (size_t i = 1; i < threads; ++i) workers.emplace_back(work);
+        work();
+        for (auto& worker : workers) worker.join();
+        return results;
+    }
+
+}  // namespace nfcsigner
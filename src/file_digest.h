@@ -0,0 +1,45 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_FILE_DIGEST_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_FILE_DIGEST_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+typedef struct evp_md_ctx_st EVP_MD_CTX;
+
+namespace nfcsigner {
+
+    class CancellationToken;
+
+    // Đưa toàn bộ nội dung file vào [ctx] (đã khởi tạo với thuật toán bất kỳ).
+    // Ném std::runtime_error nếu không đọc được file, OperationCancelled nếu
+    // [cancellation] (có thể nullptr) bị hủy; token được kiểm tra mỗi khối.
+    void UpdateDigestFromFile(EVP_MD_CTX* ctx, const std::string& path,
+                              CancellationToken* cancellation = nullptr);
+
+    // SHA-256 của một file (đường dẫn UTF-8). Đọc tuần tự theo khối lớn trên
+    // một luồng đọc riêng, khối kế tiếp được đọc trong lúc khối hiện tại đang
+    // băm, nên file nhiều GB không bao giờ nằm trọn trong bộ nhớ. Ném
+    // std::runtime_error nếu không đọc được file, OperationCancelled nếu
+    // [cancellation] bị hủy giữa chừng.
+    std::vector<uint8_t> Sha256File(const std::string& path, CancellationToken* cancellation = nullptr);
+
+    struct FileDigest {
+        std::string path;
+        std::vector<uint8_t> digest;
+        std::string error;          // rỗng nếu băm thành công
+    };
+
+    // Thay thư mục bằng các file bên trong (đệ quy nếu [recursive]), sắp xếp
+    // theo đường dẫn. File giữ nguyên; đường dẫn không tồn tại được giữ lại để
+    // báo lỗi ở bước băm.
+    std::vector<std::string> ExpandFilePaths(const std::vector<std::string>& paths, bool recursive);
+
+    // Băm song song [paths] trên [threads] luồng (0: theo số lõi CPU). Kết quả
+    // theo thứ tự đầu vào; file lỗi chỉ làm hỏng kết quả của nó.
+    std::vector<FileDigest> Sha256Files(const std::vector<std::string>& paths, size_t threads = 0);
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_FILE_DIGEST_H_
@@ -0,0 +1,1550 @@
+#include "lazy_pdf.h"
+
+#include <openssl/evp.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <locale>
+#include <map>
+#include <set>
+#include <sstream>
+
+#include "byte_codec.h"
+
+namespace nfcsigner {
+
+    namespace {
+
+        // Giới hạn để file hỏng không làm cạn bộ nhớ hoặc đệ quy vô hạn.
+        constexpr uint32_t kMaxObjectNumber = 8u * 1024 * 1024;
+        constexpr size_t kMaxDecodedStream = 256u * 1024 * 1024;
+        constexpr int kMaxNesting = 256;
+        constexpr int kMaxPageTreeDepth = 64;
+        // startxref nằm trong phần cuối file.
+        constexpr size_t kTailSearch = 2048;
+        // "[0 " + 3 trường 10 ký tự + "]".
+        constexpr int kByteRangeFieldWidth = 10;
+
+        bool IsWhitespace(char c) {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\0';
+        }
+
+        bool IsDelimiter(char c) {
+            return c == '(' || c == ')' || c == '<' || c == '>' || c == '[' || c == ']' ||
+                   c == '{' || c == '}' || c == '/' || c == '%';
+        }
+
+        bool IsRegular(char c) {
+            return !IsWhitespace(c) && !IsDelimiter(c);
+        }
+
+        bool IsIntegerToken(std::string_view token) {
+            if (token.empty()) return false;
+            size_t i = (token[0] == '+' || token[0] == '-') ? 1 : 0;
+            if (i == token.size()) return false;
+            for (; i < token.size(); ++i) {
+                if (token[i] < '0' || token[i] > '9') return false;
+            }
+            return true;
+        }
+
+        // [token] đã qua IsIntegerToken; from_chars không nhận dấu '+'.
+        long long ParseInteger(std::string_view token) {
+            if (token[0] == '+') token.remove_prefix(1);
+            long long value = 0;
+            auto parsed = std::from_chars(token.data(), token.data() + token.size(), value);
+            if (parsed.ec != std::errc() || parsed.ptr != token.data() + token.size()) {
+                throw LazyPdfUnsupported("Integer is out of range.");
+            }
+            return value;
+        }
+
+        // Tách token PDF trên một buffer (file gốc hoặc object stream đã giải nén).
+        class Lexer {
+        public:
+            Lexer(const char* data, size_t size, size_t position) : data_(data), size_(size), pos_(position) {
+                if (pos_ > size_) throw LazyPdfUnsupported("Offset is outside of the PDF.");
+            }
+
+            size_t Position() const { return pos_; }
+            void Seek(size_t position) { pos_ = std::min(position, size_); }
+            bool AtEnd() const { return pos_ >= size_; }
+
+            void SkipWhitespace() {
+                while (pos_ < size_) {
+                    char c = data_[pos_];
+                    if (IsWhitespace(c)) {
+                        ++pos_;
+                    } else if (c == '%') {
+                        while (pos_ < size_ && data_[pos_] != '\n' && data_[pos_] != '\r') ++pos_;
+                    } else {
+                        break;
+                    }
+                }
+            }
+
+            // Trỏ vào buffer, không cấp phát.
+            std::string_view ReadKeyword() {
+                SkipWhitespace();
+                size_t start = pos_;
+                while (pos_ < size_ && IsRegular(data_[pos_])) ++pos_;
+                return std::string_view(data_ + start, pos_ - start);
+            }
+
+            void ExpectKeyword(const char* keyword) {
+                if (ReadKeyword() != keyword) {
+                    throw LazyPdfUnsupported(std::string("Expected '") + keyword + "'.");
+                }
+            }
+
+            long long ReadInteger() {
+                std::string_view token = ReadKeyword();
+                if (!IsIntegerToken(token)) throw LazyPdfUnsupported("Expected an integer.");
+                return ParseInteger(token);
+            }
+
+            // Xem trước keyword mà không di chuyển.
+            bool PeekKeyword(const char* keyword) {
+                size_t saved = pos_;
+                bool match = ReadKeyword() == keyword;
+                pos_ = saved;
+                return match;
+            }
+
+            LazyPdfValue ReadValue(int depth = 0) {
+                if (depth > kMaxNesting) throw LazyPdfUnsupported("PDF objects are nested too deeply.");
+                SkipWhitespace();
+                if (AtEnd()) throw LazyPdfUnsupported("Unexpected end of PDF data.");
+
+                char c = data_[pos_];
+                if (c == '<' && pos_ + 1 < size_ && data_[pos_ + 1] == '<') {
+                    pos_ += 2;
+                    LazyPdfValue dictionary = LazyPdfValue::Dictionary();
+                    while (true) {
+                        SkipWhitespace();
+                        if (pos_ + 1 < size_ && data_[pos_] == '>' && data_[pos_ + 1] == '>') {
+                            pos_ += 2;
+                            return dictionary;
+                        }
+                        LazyPdfValue key = ReadValue(depth + 1);
+                        if (key.kind != LazyPdfValue::Kind::Name) {
+                            throw LazyPdfUnsupported("Dictionary key is not a name.");
+                        }
+                        LazyPdfValue value = ReadValue(depth + 1);
+                        dictionary.entries.emplace_back(std::move(key.token), std::move(value));
+                    }
+                }
+                if (c == '<') {
+                    size_t start = pos_;
+                    while (pos_ < size_ && data_[pos_] != '>') ++pos_;
+                    if (AtEnd()) throw LazyPdfUnsupported("Unterminated hex string.");
+                    ++pos_;
+                    return LazyPdfValue::Token(LazyPdfValue::Kind::String, std::string_view(data_ + start, pos_ - start));
+                }
+                if (c == '[') {
+                    ++pos_;
+                    LazyPdfValue array = LazyPdfValue::Array();
+                    while (true) {
+                        SkipWhitespace();
+                        if (AtEnd()) throw LazyPdfUnsupported("Unterminated array.");
+                        if (data_[pos_] == ']') {
+                            ++pos_;
+                            return array;
+                        }
+                        array.items.push_back(ReadValue(depth + 1));
+                    }
+                }
+                if (c == '(') {
+                    size_t start = pos_++;
+                    int nesting = 1;
+                    while (pos_ < size_ && nesting > 0) {
+                        char s = data_[pos_++];
+                        if (s == '\\') ++pos_;
+                        else if (s == '(') ++nesting;
+                        else if (s == ')') --nesting;
+                    }
+                    if (nesting > 0 || pos_ > size_) throw LazyPdfUnsupported("Unterminated literal string.");
+                    return LazyPdfValue::Token(LazyPdfValue::Kind::String, std::string_view(data_ + start, pos_ - start));
+                }
+                if (c == '/') {
+                    size_t start = pos_++;
+                    while (pos_ < size_ && IsRegular(data_[pos_])) ++pos_;
+                    return LazyPdfValue::Token(LazyPdfValue::Kind::Name, std::string_view(data_ + start, pos_ - start));
+                }
+
+                std::string_view token = ReadKeyword();
+                if (token.empty()) throw LazyPdfUnsupported("Unexpected delimiter in PDF data.");
+                if (token == "true" || token == "false") {
+                    return LazyPdfValue::Token(LazyPdfValue::Kind::Boolean, token);
+                }
+                if (token == "null") return LazyPdfValue();
+                if (IsIntegerToken(token) && token[0] != '-' && token[0] != '+') {
+                    // "n g R" là tham chiếu gián tiếp.
+                    size_t saved = pos_;
+                    std::string_view generation = ReadKeyword();
+                    if (IsIntegerToken(generation) && ReadKeyword() == "R") {
+                        return LazyPdfValue::Reference(static_cast<uint32_t>(ParseInteger(token)),
+                                                       static_cast<uint16_t>(ParseInteger(generation)));
+                    }
+                    pos_ = saved;
+                    return LazyPdfValue::Token(LazyPdfValue::Kind::Number, token);
+                }
+                if ((c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.') {
+                    return LazyPdfValue::Token(LazyPdfValue::Kind::Number, token);
+                }
+                throw LazyPdfUnsupported("Unexpected keyword '" + std::string(token) + "' in PDF data.");
+            }
+
+        private:
+            const char* data_;
+            size_t size_;
+            size_t pos_;
+        };
+
+        std::vector<char> Inflate(const char* data, size_t size) {
+            z_stream stream{};
+            if (inflateInit(&stream) != Z_OK) throw LazyPdfUnsupported("inflateInit failed.");
+
+            std::vector<char> output;
+            char chunk[16384];
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            stream.avail_in = static_cast<uInt>(size);
+            int status = Z_OK;
+            while (status != Z_STREAM_END) {
+                stream.next_out = reinterpret_cast<Bytef*>(chunk);
+                stream.avail_out = sizeof(chunk);
+                status = inflate(&stream, Z_NO_FLUSH);
+                if (status != Z_OK && status != Z_STREAM_END) {
+                    // Nhiều trình tạo PDF bỏ checksum cuối; dữ liệu đã giải nén vẫn dùng được.
+                    if (status == Z_DATA_ERROR || status == Z_BUF_ERROR) {
+                        output.insert(output.end(), chunk, chunk + (sizeof(chunk) - stream.avail_out));
+                        break;
+                    }
+                    inflateEnd(&stream);
+                    throw LazyPdfUnsupported("Cannot inflate PDF stream.");
+                }
+                output.insert(output.end(), chunk, chunk + (sizeof(chunk) - stream.avail_out));
+                if (output.size() > kMaxDecodedStream) {
+                    inflateEnd(&stream);
+                    throw LazyPdfUnsupported("Decoded PDF stream is too large.");
+                }
+                if (stream.avail_in == 0 && status != Z_STREAM_END && stream.avail_out != 0) break;
+            }
+            inflateEnd(&stream);
+            return output;
+        }
+
+        // Bỏ PNG predictor (Predictor >= 10) với 1 byte/điểm ảnh như xref stream dùng.
+        std::vector<char> RemovePngPredictor(const std::vector<char>& data, size_t columns) {
+            if (columns == 0) throw LazyPdfUnsupported("Invalid /Columns.");
+            size_t rowSize = columns + 1;
+            std::vector<char> output;
+            output.reserve(data.size() / rowSize * columns);
+            std::vector<unsigned char> previous(columns, 0);
+            std::vector<unsigned char> row(columns);
+            for (size_t offset = 0; offset + rowSize <= data.size(); offset += rowSize) {
+                unsigned char filter = static_cast<unsigned char>(data[offset]);
+                const auto* in = reinterpret_cast<const unsigned char*>(data.data() + offset + 1);
+                for (size_t i = 0; i < columns; ++i) {
+                    unsigned left = i > 0 ? row[i - 1] : 0;
+                    unsigned up = previous[i];
+                    unsigned upLeft = i > 0 ? previous[i - 1] : 0;
+                    unsigned value = in[i];
+                    switch (filter) {
+                        case 0: break;
+                        case 1: value += left; break;
+                        case 2: value += up; break;
+                        case 3: value += (left + up) / 2; break;
+                        case 4: {
+                            int p = static_cast<int>(left + up) - static_cast<int>(upLeft);
+                            int pa = std::abs(p - static_cast<int>(left));
+                            int pb = std::abs(p - static_cast<int>(up));
+                            int pc = std::abs(p - static_cast<int>(upLeft));
+                            value += (pa <= pb && pa <= pc) ? left : (pb <= pc ? up : upLeft);
+                            break;
+                        }
+                        default:
+                            throw LazyPdfUnsupported("Unknown PNG predictor.");
+                    }
+                    row[i] = static_cast<unsigned char>(value & 0xFF);
+                }
+                output.insert(output.end(), row.begin(), row.end());
+                previous = row;
+            }
+            return output;
+        }
+
+        std::string FormatNumber(double value) {
+            char buffer[64];
+            std::snprintf(buffer, sizeof(buffer), "%.4f", value);
+            std::string text(buffer);
+            // Dấu thập phân của locale "C" luôn là '.'; bỏ số 0 thừa.
+            size_t dot = text.find('.');
+            if (dot != std::string::npos) {
+                while (text.back() == '0') text.pop_back();
+                if (text.back() == '.') text.pop_back();
+            }
+            return text == "-0" ? "0" : text;
+        }
+
+        LazyPdfValue Number(double value) {
+            return LazyPdfValue::Token(LazyPdfValue::Kind::Number, FormatNumber(value));
+        }
+
+        LazyPdfValue Integer(long long value) {
+            return LazyPdfValue::Token(LazyPdfValue::Kind::Number, std::to_string(value));
+        }
+
+        LazyPdfValue Name(const char* name) {
+            return LazyPdfValue::Token(LazyPdfValue::Kind::Name, name);
+        }
+
+        // Chuỗi văn bản PDF từ UTF-8: ASCII giữ dạng literal, còn lại dùng UTF-16BE có BOM.
+        LazyPdfValue TextString(const std::string& utf8) {
+            bool ascii = std::all_of(utf8.begin(), utf8.end(), [](char c) {
+                return static_cast<unsigned char>(c) >= 0x20 && static_cast<unsigned char>(c) < 0x7F;
+            });
+            if (ascii) {
+                std::string literal = "(";
+                for (char c : utf8) {
+                    if (c == '(' || c == ')' || c == '\\') literal += '\\';
+                    literal += c;
+                }
+                literal += ')';
+                return LazyPdfValue::Token(LazyPdfValue::Kind::String, literal);
+            }
+
+            static const char hex_chars[] = "0123456789ABCDEF";
+            std::string hex = "<FEFF";
+            auto appendUnit = [&](unsigned unit) {
+                for (int shift = 12; shift >= 0; shift -= 4) hex += hex_chars[(unit >> shift) & 0x0F];
+            };
+            for (size_t i = 0; i < utf8.size();) {
+                unsigned char c = static_cast<unsigned char>(utf8[i]);
+                char32_t cp;
+                size_t extra;
+                if (c < 0x80) { cp = c; extra = 0; }
+                else if ((c & 0xE0) == 0xC0) { cp = c & 0x1F; extra = 1; }
+                else if ((c & 0xF0) == 0xE0) { cp = c & 0x0F; extra = 2; }
+                else if ((c & 0xF8) == 0xF0) { cp = c & 0x07; extra = 3; }
+                else { cp = 0xFFFD; extra = 0; }
+                if (extra > 0 && i + extra >= utf8.size()) {
+                    cp = 0xFFFD;
+                    extra = utf8.size() - i - 1;
+                } else {
+                    for (size_t k = 1; k <= extra; ++k) {
+                        cp = (cp << 6) | (static_cast<unsigned char>(utf8[i + k]) & 0x3F);
+                    }
+                }
+                if (cp >= 0x10000) {
+                    cp -= 0x10000;
+                    appendUnit(0xD800 | static_cast<unsigned>(cp >> 10));
+                    appendUnit(0xDC00 | static_cast<unsigned>(cp & 0x3FF));
+                } else {
+                    appendUnit(static_cast<unsigned>(cp));
+                }
+                i += extra + 1;
+            }
+            hex += '>';
+            return LazyPdfValue::Token(LazyPdfValue::Kind::String, hex);
+        }
+
+        LazyPdfValue PdfDateString(std::time_t t) {
+            std::tm tm_utc{};
+#ifdef _WIN32
+            gmtime_s(&tm_utc, &t);
+#else
+            gmtime_r(&t, &tm_utc);
+#endif
+            char buffer[32];
+            if (std::strftime(buffer, sizeof(buffer), "(D:%Y%m%d%H%M%SZ)", &tm_utc) == 0) {
+                throw std::runtime_error("Cannot format signature date.");
+            }
+            return LazyPdfValue::Token(LazyPdfValue::Kind::String, buffer);
+        }
+
+        // Ghi phần incremental update, nối sau file gốc dài [base] byte.
+        class UpdateWriter {
+        public:
+            explicit UpdateWriter(size_t base) : base_(base) {}
+
+            std::string& Buffer() { return out_; }
+            size_t FileOffset() const { return base_ + out_.size(); }
+
+            void BeginObject(uint32_t objectNumber, uint16_t generation) {
+                offsets_[objectNumber] = std::make_pair(FileOffset(), generation);
+                out_ += std::to_string(objectNumber) + ' ' + std::to_string(generation) + " obj\n";
+            }
+
+            void WriteObject(uint32_t objectNumber, uint16_t generation, const LazyPdfValue& value) {
+                BeginObject(objectNumber, generation);
+                value.Serialize(out_);
+                out_ += "\nendobj\n";
+            }
+
+            void WriteStreamObject(uint32_t objectNumber, LazyPdfValue dictionary, const char* data, size_t length) {
+                dictionary.Set("/Length", Integer(static_cast<long long>(length)));
+                BeginObject(objectNumber, 0);
+                dictionary.Serialize(out_);
+                out_ += "\nstream\n";
+                out_.append(data, length);
+                out_ += "\nendstream\nendobj\n";
+            }
+
+            // Bảng xref cổ điển cho các object đã ghi, kèm trailer.
+            void WriteXrefTable(LazyPdfValue trailer) {
+                size_t xrefOffset = FileOffset();
+                // Luôn mở đầu bằng mục 0 (free) như các trình ghi khác, để reader không đoán sai số hiệu.
+                out_ += "xref\n0 1\n0000000000 65535 f\r\n";
+                for (auto it = offsets_.begin(); it != offsets_.end();) {
+                    auto end = it;
+                    uint32_t expected = it->first;
+                    size_t count = 0;
+                    while (end != offsets_.end() && end->first == expected) {
+                        ++end;
+                        ++expected;
+                        ++count;
+                    }
+                    out_ += std::to_string(it->first) + ' ' + std::to_string(count) + '\n';
+                    for (; it != end; ++it) {
+                        char line[32];
+                        std::snprintf(line, sizeof(line), "%010llu %05u n\r\n",
+                                      static_cast<unsigned long long>(it->second.first),
+                                      static_cast<unsigned>(it->second.second));
+                        out_ += line;
+                    }
+                }
+                out_ += "trailer\n";
+                trailer.Serialize(out_);
+                out_ += "\nstartxref\n" + std::to_string(xrefOffset) + "\n%%EOF\n";
+            }
+
+            // Xref stream (không nén) cho tài liệu gốc dùng xref stream; [trailer] là phần khóa chung.
+            void WriteXrefStream(uint32_t objectNumber, LazyPdfValue trailer) {
+                size_t xrefOffset = FileOffset();
+                offsets_[objectNumber] = std::make_pair(xrefOffset, static_cast<uint16_t>(0));
+                if (xrefOffset > 0xFFFFFFFFull) throw LazyPdfUnsupported("PDF is too large for the xref stream.");
+
+                LazyPdfValue index = LazyPdfValue::Array();
+                std::string rows;
+                for (auto it = offsets_.begin(); it != offsets_.end();) {
+                    auto end = it;
+                    uint32_t expected = it->first;
+                    long long count = 0;
+                    while (end != offsets_.end() && end->first == expected) {
+                        ++end;
+                        ++expected;
+                        ++count;
+                    }
+                    index.items.push_back(Integer(it->first));
+                    index.items.push_back(Integer(count));
+                    for (; it != end; ++it) {
+                        uint64_t offset = it->second.first;
+                        rows += static_cast<char>(1);
+                        for (int shift = 24; shift >= 0; shift -= 8) rows += static_cast<char>((offset >> shift) & 0xFF);
+                        rows += static_cast<char>((it->second.second >> 8) & 0xFF);
+                        rows += static_cast<char>(it->second.second & 0xFF);
+                    }
+                }
+
+                trailer.Set("/Type", Name("/XRef"));
+                LazyPdfValue widths = LazyPdfValue::Array();
+                widths.items = { Integer(1), Integer(4), Integer(2) };
+                trailer.Set("/W", widths);
+                trailer.Set("/Index", index);
+                trailer.Set("/Length", Integer(static_cast<long long>(rows.size())));
+
+                out_ += std::to_string(objectNumber) + " 0 obj\n";
+                trailer.Serialize(out_);
+                out_ += "\nstream\n";
+                out_ += rows;
+                out_ += "\nendstream\nendobj\n";
+                out_ += "startxref\n" + std::to_string(xrefOffset) + "\n%%EOF\n";
+            }
+
+        private:
+            size_t base_;
+            std::string out_;
+            std::map<uint32_t, std::pair<size_t, uint16_t>> offsets_;
+        };
+
+        // Chép đồ thị object từ PDF nguồn (template appearance) vào bản cập nhật, đánh số lại.
+        class GraphCopier {
+        public:
+            GraphCopier(LazyPdfReader& source, UpdateWriter& writer, uint32_t& nextObject)
+                    : source_(source), writer_(writer), next_object_(nextObject) {}
+
+            uint32_t Copy(uint32_t sourceNumber) {
+                auto it = copied_.find(sourceNumber);
+                if (it != copied_.end()) return it->second;
+
+                uint32_t target = next_object_++;
+                copied_[sourceNumber] = target;
+                const LazyPdfObject& object = source_.GetObject(sourceNumber);
+                LazyPdfValue value = CopyValue(object.value);
+                if (object.streamData) {
+                    writer_.WriteStreamObject(target, std::move(value), object.streamData, object.streamLength);
+                } else {
+                    writer_.WriteObject(target, 0, value);
+                }
+                return target;
+            }
+
+        private:
+            LazyPdfValue CopyValue(const LazyPdfValue& value) {
+                switch (value.kind) {
+                    case LazyPdfValue::Kind::Reference:
+                        return LazyPdfValue::Reference(Copy(value.objectNumber));
+                    case LazyPdfValue::Kind::Array: {
+                        LazyPdfValue array = LazyPdfValue::Array();
+                        for (const auto& item : value.items) array.items.push_back(CopyValue(item));
+                        return array;
+                    }
+                    case LazyPdfValue::Kind::Dictionary: {
+                        LazyPdfValue dictionary = LazyPdfValue::Dictionary();
+                        for (const auto& entry : value.entries) {
+                            dictionary.entries.emplace_back(entry.first, CopyValue(entry.second));
+                        }
+                        return dictionary;
+                    }
+                    default:
+                        return value;
+                }
+            }
+
+            LazyPdfReader& source_;
+            UpdateWriter& writer_;
+            uint32_t& next_object_;
+            std::map<uint32_t, uint32_t> copied_;
+        };
+
+        // Thêm [item] vào mảng [key] của [owner]. Nếu mảng là object gián tiếp
+        // thì ghi lại object đó; trả về true nếu [owner] bị thay đổi.
+        bool AppendToArray(LazyPdfReader& reader, UpdateWriter& writer, LazyPdfValue& owner,
+                           const char* key, const LazyPdfValue& item) {
+            const LazyPdfValue* current = owner.Find(key);
+            if (current && current->kind == LazyPdfValue::Kind::Reference) {
+                LazyPdfValue array = reader.Resolve(*current);
+                if (array.kind != LazyPdfValue::Kind::Array) array = LazyPdfValue::Array();
+                array.items.push_back(item);
+                writer.WriteObject(current->objectNumber, reader.GetGeneration(current->objectNumber), array);
+                return false;
+            }
+            LazyPdfValue array = (current && current->kind == LazyPdfValue::Kind::Array) ? *current : LazyPdfValue::Array();
+            array.items.push_back(item);
+            owner.Set(key, array);
+            return true;
+        }
+
+        double ToDouble(const LazyPdfValue& value) {
+            if (value.kind != LazyPdfValue::Kind::Number) throw LazyPdfUnsupported("Expected a number.");
+            std::istringstream in(std::string(value.token));
+            in.imbue(std::locale::classic());
+            double result = 0.0;
+            in >> result;
+            return result;
+        }
+
+        void AppendUtf8(std::string& out, char32_t cp) {
+            if (cp < 0x80) {
+                out += static_cast<char>(cp);
+            } else if (cp < 0x800) {
+                out += static_cast<char>(0xC0 | (cp >> 6));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            } else if (cp < 0x10000) {
+                out += static_cast<char>(0xE0 | (cp >> 12));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (cp >> 18));
+                out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+        }
+
+        // Ngược lại của TextString: chuỗi literal/hex sang UTF-8. Chuỗi không có
+        // BOM coi như Latin-1 (trùng PDFDocEncoding với các ký tự thường gặp).
+        std::string DecodeTextString(const LazyPdfValue& value) {
+            if (value.kind != LazyPdfValue::Kind::String || value.token.size() < 2) return std::string();
+            std::string_view token = value.token;
+            std::string bytes;
+            if (token[0] == '<') {
+                int high = -1;
+                for (size_t i = 1; i + 1 < token.size(); ++i) {
+                    char c = token[i];
+                    int digit;
+                    if (c >= '0' && c <= '9') digit = c - '0';
+                    else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+                    else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+                    else continue;
+                    if (high < 0) {
+                        high = digit;
+                    } else {
+                        bytes += static_cast<char>((high << 4) | digit);
+                        high = -1;
+                    }
+                }
+                if (high >= 0) bytes += static_cast<char>(high << 4);
+            } else {
+                for (size_t i = 1; i + 1 < token.size(); ++i) {
+                    char c = token[i];
+                    if (c != '\\') {
+                        bytes += c;
+                        continue;
+                    }
+                    if (++i + 1 >= token.size()) break;
+                    char e = token[i];
+                    switch (e) {
+                        case 'n': bytes += '\n'; break;
+                        case 'r': bytes += '\r'; break;
+                        case 't': bytes += '\t'; break;
+                        case 'b': bytes += '\b'; break;
+                        case 'f': bytes += '\f'; break;
+                        case '\r':
+                            if (i + 2 < token.size() && token[i + 1] == '\n') ++i;
+                            break;
+                        case '\n':
+                            break;
+                        default:
+                            if (e >= '0' && e <= '7') {
+                                int octal = e - '0';
+                                for (int k = 0; k < 2 && i + 2 < token.size() && token[i + 1] >= '0' && token[i + 1] <= '7'; ++k) {
+                                    octal = octal * 8 + (token[++i] - '0');
+                                }
+                                bytes += static_cast<char>(octal & 0xFF);
+                            } else {
+                                bytes += e;
+                            }
+                    }
+                }
+            }
+
+            std::string utf8;
+            if (bytes.size() >= 2 && static_cast<unsigned char>(bytes[0]) == 0xFE &&
+                static_cast<unsigned char>(bytes[1]) == 0xFF) {
+                for (size_t i = 2; i + 1 < bytes.size(); i += 2) {
+                    char32_t unit = (static_cast<unsigned char>(bytes[i]) << 8) | static_cast<unsigned char>(bytes[i + 1]);
+                    if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < bytes.size()) {
+                        char32_t low = (static_cast<unsigned char>(bytes[i + 2]) << 8) | static_cast<unsigned char>(bytes[i + 3]);
+                        if (low >= 0xDC00 && low < 0xE000) {
+                            unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                            i += 2;
+                        }
+                    }
+                    AppendUtf8(utf8, unit);
+                }
+                return utf8;
+            }
+            for (char c : bytes) AppendUtf8(utf8, static_cast<unsigned char>(c));
+            return utf8;
+        }
+
+        // Tìm field tên [name] trong mảng [fields] (AcroForm /Fields hoặc /Kids).
+        bool FindFieldIn(LazyPdfReader& reader, const LazyPdfValue& fields, const std::string& prefix,
+                         const std::string& name, LazyPdfField& result, int depth) {
+            if (fields.kind != LazyPdfValue::Kind::Array || depth > kMaxPageTreeDepth) return false;
+            for (const auto& item : fields.items) {
+                if (item.kind != LazyPdfValue::Kind::Reference) continue;
+                const LazyPdfValue& field = reader.Resolve(item);
+                if (field.kind != LazyPdfValue::Kind::Dictionary) continue;
+                const LazyPdfValue* title = field.Find("/T");
+                if (!title) continue;  // widget con, không phải field
+                std::string qualified = prefix.empty() ? DecodeTextString(reader.Resolve(*title))
+                                                       : prefix + "." + DecodeTextString(reader.Resolve(*title));
+                const LazyPdfValue* kids = field.Find("/Kids");
+                if (qualified != name) {
+                    if (kids && name.compare(0, qualified.size() + 1, qualified + ".") == 0 &&
+                        FindFieldIn(reader, reader.Resolve(*kids), qualified, name, result, depth + 1)) {
+                        return true;
+                    }
+                    continue;
+                }
+
+                result = LazyPdfField();
+                result.field = item;
+                const LazyPdfValue* type = field.Find("/FT");
+                result.isSignature = type && reader.Resolve(*type).IsName("/Sig");
+                const LazyPdfValue* value = field.Find("/V");
+                result.isSigned = value && reader.Resolve(*value).kind != LazyPdfValue::Kind::Null;
+
+                const LazyPdfValue* subtype = field.Find("/Subtype");
+                if (subtype && subtype->IsName("/Widget")) {
+                    result.widget = item;
+                } else if (kids) {
+                    const LazyPdfValue& kidArray = reader.Resolve(*kids);
+                    if (kidArray.kind == LazyPdfValue::Kind::Array && kidArray.items.size() == 1 &&
+                        kidArray.items[0].kind == LazyPdfValue::Kind::Reference) {
+                        result.widget = kidArray.items[0];
+                    }
+                }
+                if (result.widget.kind == LazyPdfValue::Kind::Reference) {
+                    const LazyPdfValue* rect = reader.Resolve(result.widget).Find("/Rect");
+                    if (rect) {
+                        const LazyPdfValue& corners = reader.Resolve(*rect);
+                        if (corners.kind == LazyPdfValue::Kind::Array && corners.items.size() == 4) {
+                            double x1 = ToDouble(reader.Resolve(corners.items[0]));
+                            double y1 = ToDouble(reader.Resolve(corners.items[1]));
+                            double x2 = ToDouble(reader.Resolve(corners.items[2]));
+                            double y2 = ToDouble(reader.Resolve(corners.items[3]));
+                            result.x = std::min(x1, x2);
+                            result.y = std::min(y1, y2);
+                            result.width = std::abs(x2 - x1);
+                            result.height = std::abs(y2 - y1);
+                        }
+                    }
+                }
+                return true;
+            }
+            return false;
+        }
+
+        // Thu thập các field chữ ký đã ký trong [fields] (đệ quy theo /Kids).
+        void CollectSignatures(LazyPdfReader& reader, const LazyPdfValue& fields, const std::string& prefix,
+                               std::vector<LazyPdfSignature>& result, int depth) {
+            if (fields.kind != LazyPdfValue::Kind::Array || depth > kMaxPageTreeDepth) return;
+            for (const auto& item : fields.items) {
+                if (item.kind != LazyPdfValue::Kind::Reference) continue;
+                const LazyPdfValue& field = reader.Resolve(item);
+                if (field.kind != LazyPdfValue::Kind::Dictionary) continue;
+                const LazyPdfValue* title = field.Find("/T");
+                if (!title) continue;
+                std::string qualified = prefix.empty() ? DecodeTextString(reader.Resolve(*title))
+                                                       : prefix + "." + DecodeTextString(reader.Resolve(*title));
+                if (const LazyPdfValue* kids = field.Find("/Kids")) {
+                    CollectSignatures(reader, reader.Resolve(*kids), qualified, result, depth + 1);
+                }
+
+                const LazyPdfValue* type = field.Find("/FT");
+                const LazyPdfValue* value = field.Find("/V");
+                if (!type || !reader.Resolve(*type).IsName("/Sig") || !value) continue;
+                const LazyPdfValue& signature = reader.Resolve(*value);
+                const LazyPdfValue* byteRange = signature.kind == LazyPdfValue::Kind::Dictionary
+                                                ? signature.Find("/ByteRange") : nullptr;
+                if (!byteRange) continue;
+
+                LazyPdfSignature entry;
+                entry.fieldName = qualified;
+                const LazyPdfValue& ranges = reader.Resolve(*byteRange);
+                if (ranges.kind == LazyPdfValue::Kind::Array) {
+                    for (const auto& number : ranges.items) entry.byteRange.push_back(reader.Resolve(number).AsInteger());
+                }
+                if (const LazyPdfValue* subFilter = signature.Find("/SubFilter")) {
+                    const LazyPdfValue& name = reader.Resolve(*subFilter);
+                    if (name.kind == LazyPdfValue::Kind::Name) entry.subFilter = std::string(std::string_view(name.token).substr(1));
+                }
+                if (const LazyPdfValue* time = signature.Find("/M")) entry.signingTime = DecodeTextString(reader.Resolve(*time));
+                result.push_back(std::move(entry));
+            }
+        }
+
+    }  // namespace
+
+    // Bản sao cũng lấy arena của thread hiện tại thay vì heap mặc định.
+    LazyPdfValue::LazyPdfValue(const LazyPdfValue& other)
+            : kind(other.kind), token(other.token, CurrentRequestArena()), items(other.items, CurrentRequestArena()),
+              entries(other.entries, CurrentRequestArena()), objectNumber(other.objectNumber),
+              generation(other.generation) {}
+
+    // Cùng arena thì lấy luôn bộ nhớ của [other]; khác arena thì chuỗi và
+    // vector với allocator đích move từng phần tử sang.
+    LazyPdfValue::LazyPdfValue(LazyPdfValue&& other) noexcept
+            : kind(other.kind), token(std::move(other.token), CurrentRequestArena()),
+              items(std::move(other.items), CurrentRequestArena()),
+              entries(std::move(other.entries), CurrentRequestArena()), objectNumber(other.objectNumber),
+              generation(other.generation) {}
+
+    LazyPdfValue LazyPdfValue::Token(Kind kind, std::string_view token) {
+        LazyPdfValue value;
+        value.kind = kind;
+        value.token.assign(token);
+        return value;
+    }
+
+    LazyPdfValue LazyPdfValue::Reference(uint32_t objectNumber, uint16_t generation) {
+        LazyPdfValue value;
+        value.kind = Kind::Reference;
+        value.objectNumber = objectNumber;
+        value.generation = generation;
+        return value;
+    }
+
+    LazyPdfValue LazyPdfValue::Array() {
+        LazyPdfValue value;
+        value.kind = Kind::Array;
+        return value;
+    }
+
+    LazyPdfValue LazyPdfValue::Dictionary() {
+        LazyPdfValue value;
+        value.kind = Kind::Dictionary;
+        return value;
+    }
+
+    const LazyPdfValue* LazyPdfValue::Find(std::string_view key) const {
+        for (const auto& entry : entries) {
+            if (entry.first == key) return &entry.second;
+        }
+        return nullptr;
+    }
+
+    void LazyPdfValue::Set(std::string_view key, LazyPdfValue value) {
+        for (auto& entry : entries) {
+            if (entry.first == key) {
+                entry.second = std::move(value);
+                return;
+            }
+        }
+        entries.emplace_back(key, std::move(value));
+    }
+
+    bool LazyPdfValue::IsName(const char* name) const {
+        return kind == Kind::Name && token == name;
+    }
+
+    long long LazyPdfValue::AsInteger() const {
+        if (kind != Kind::Number || !IsIntegerToken(token)) {
+            throw LazyPdfUnsupported("Expected an integer value.");
+        }
+        return ParseInteger(token);
+    }
+
+    void LazyPdfValue::Serialize(std::string& out) const {
+        switch (kind) {
+            case Kind::Null:
+                out += "null";
+                break;
+            case Kind::Reference:
+                out += std::to_string(objectNumber) + ' ' + std::to_string(generation) + " R";
+                break;
+            case Kind::Array:
+                out += '[';
+                for (size_t i = 0; i < items.size(); ++i) {
+                    if (i > 0) out += ' ';
+                    items[i].Serialize(out);
+                }
+                out += ']';
+                break;
+            case Kind::Dictionary:
+                out += "<<";
+                for (const auto& entry : entries) {
+                    out += entry.first;
+                    out += ' ';
+                    entry.second.Serialize(out);
+                    out += ' ';
+                }
+                out += ">>";
+                break;
+            default:
+                out += token;
+                break;
+        }
+    }
+
+    LazyPdfReader::LazyPdfReader(const uint8_t* data, size_t size)
+            : data_(reinterpret_cast<const char*>(data)), size_bytes_(size) {
+        LoadXref();
+    }
+
+    LazyPdfReader::~LazyPdfReader() = default;
+
+    size_t LazyPdfReader::FindStartXref() const {
+        size_t tail = size_bytes_ > kTailSearch ? size_bytes_ - kTailSearch : 0;
+        const char* keyword = "startxref";
+        size_t found = std::string::npos;
+        for (size_t i = size_bytes_ >= 9 ? size_bytes_ - 8 : 0; i-- > tail;) {
+            if (std::memcmp(data_ + i, keyword, 9) == 0) {
+                found = i;
+                break;
+            }
+        }
+        if (found == std::string::npos) throw LazyPdfUnsupported("startxref not found.");
+
+        Lexer lexer(data_, size_bytes_, found + 9);
+        long long start = lexer.ReadInteger();
+        if (start <= 0 || static_cast<size_t>(start) >= size_bytes_) {
+            throw LazyPdfUnsupported("Invalid startxref offset.");
+        }
+        return static_cast<size_t>(start);
+    }
+
+    void LazyPdfReader::LoadXref() {
+        start_xref_ = FindStartXref();
+
+        std::set<size_t> visited;
+        size_t offset = start_xref_;
+        bool newest = true;
+        while (true) {
+            if (!visited.insert(offset).second) throw LazyPdfUnsupported("Cyclic /Prev chain.");
+
+            Lexer probe(data_, size_bytes_, offset);
+            bool table = probe.PeekKeyword("xref");
+            LazyPdfValue trailer = table ? LoadXrefTable(offset) : LoadXrefStream(offset);
+            if (newest) {
+                trailer_ = trailer;
+                uses_xref_stream_ = !table;
+                newest = false;
+            }
+
+            const LazyPdfValue* prev = trailer.Find("/Prev");
+            if (!prev) break;
+            long long prevOffset = prev->AsInteger();
+            if (prevOffset <= 0 || static_cast<size_t>(prevOffset) >= size_bytes_) {
+                throw LazyPdfUnsupported("Invalid /Prev offset.");
+            }
+            offset = static_cast<size_t>(prevOffset);
+        }
+        ReadSize();
+    }
+
+    void LazyPdfReader::ReadSize() {
+        const LazyPdfValue* size = trailer_.Find("/Size");
+        if (!size) throw LazyPdfUnsupported("Trailer has no /Size.");
+        long long sizeValue = size->AsInteger();
+        if (sizeValue <= 0 || sizeValue > kMaxObjectNumber) throw LazyPdfUnsupported("Invalid trailer /Size.");
+        size_ = static_cast<uint32_t>(sizeValue);
+        size_ = std::max<uint32_t>(size_, static_cast<uint32_t>(entries_.size()));
+    }
+
+    void LazyPdfReader::AppendUpdate(const uint8_t* data, size_t size) {
+        const char* previous = data_;
+        data_ = reinterpret_cast<const char*>(data);
+        size_bytes_ = size;
+        // Phần đầu không đổi, chỉ có thể đã được chép sang buffer khác.
+        if (data_ != previous) {
+            for (auto& entry : objects_) {
+                if (entry.second.streamData) entry.second.streamData = data_ + (entry.second.streamData - previous);
+            }
+        }
+
+        size_t start = FindStartXref();
+        if (start == start_xref_) return;
+
+        // Đọc riêng phần xref mới rồi đè lên các mục cũ.
+        // swap chỉ hợp lệ giữa hai vector cùng arena.
+        std::pmr::vector<XrefEntry> older(entries_.get_allocator());
+        older.swap(entries_);
+        Lexer probe(data_, size_bytes_, start);
+        bool table = probe.PeekKeyword("xref");
+        LazyPdfValue trailer;
+        try {
+            trailer = table ? LoadXrefTable(start) : LoadXrefStream(start);
+        } catch (...) {
+            entries_.swap(older);
+            throw;
+        }
+        std::pmr::vector<XrefEntry> updated(entries_.get_allocator());
+        updated.swap(entries_);
+        entries_.swap(older);
+
+        const LazyPdfValue* prev = trailer.Find("/Prev");
+        if (!prev || prev->AsInteger() != static_cast<long long>(start_xref_)) {
+            throw LazyPdfUnsupported("Update does not extend the current revision.");
+        }
+        if (updated.size() > entries_.size()) entries_.resize(updated.size());
+        for (uint32_t i = 0; i < updated.size(); ++i) {
+            if (!updated[i].set) continue;
+            entries_[i] = updated[i];
+            objects_.erase(i);
+        }
+        trailer_ = trailer;
+        start_xref_ = start;
+        uses_xref_stream_ = !table;
+        ReadSize();
+    }
+
+    bool LazyPdfReader::SetEntry(uint32_t objectNumber, const XrefEntry& entry) {
+        if (objectNumber >= kMaxObjectNumber) throw LazyPdfUnsupported("Object number is too large.");
+        if (objectNumber >= entries_.size()) entries_.resize(objectNumber + 1);
+        // Phần xref mới hơn được đọc trước và có ưu tiên.
+        if (entries_[objectNumber].set) return false;
+        entries_[objectNumber] = entry;
+        entries_[objectNumber].set = true;
+        return true;
+    }
+
+    LazyPdfValue LazyPdfReader::LoadXrefTable(size_t offset) {
+        Lexer lexer(data_, size_bytes_, offset);
+        lexer.ExpectKeyword("xref");
+        // Mục 'f' mà phần bảng này vừa ghi, để /XRefStm cùng revision ghi đè.
+        std::vector<std::pair<uint32_t, XrefEntry>> freeEntries;
+        while (!lexer.PeekKeyword("trailer")) {
+            long long first = lexer.ReadInteger();
+            long long count = lexer.ReadInteger();
+            if (first < 0 || count < 0 || first + count > kMaxObjectNumber) {
+                throw LazyPdfUnsupported("Invalid xref subsection.");
+            }
+            for (long long i = 0; i < count; ++i) {
+                long long field2 = lexer.ReadInteger();
+                long long field3 = lexer.ReadInteger();
+                std::string_view type = lexer.ReadKeyword();
+                if (type != "n" && type != "f") throw LazyPdfUnsupported("Invalid xref entry.");
+                XrefEntry entry;
+                entry.type = type == "n" ? 1 : 0;
+                entry.field2 = static_cast<uint64_t>(field2);
+                entry.field3 = static_cast<uint32_t>(field3);
+                uint32_t number = static_cast<uint32_t>(first + i);
+                if (SetEntry(number, entry) && entry.type == 0) freeEntries.emplace_back(number, entries_[number]);
+            }
+        }
+        lexer.ExpectKeyword("trailer");
+        LazyPdfValue trailer = lexer.ReadValue();
+        if (trailer.kind != LazyPdfValue::Kind::Dictionary) throw LazyPdfUnsupported("Invalid trailer.");
+
+        // File lai (hybrid): xref stream bổ sung cho các object nén. Bảng ghi các
+        // object đó là 'f' để reader cũ bỏ qua; mục của /XRefStm được ưu tiên
+        // hơn các mục trống đó, nhưng không hơn mục 'n' hay revision mới hơn.
+        if (const LazyPdfValue* xrefStm = trailer.Find("/XRefStm")) {
+            long long streamOffset = xrefStm->AsInteger();
+            if (streamOffset > 0 && static_cast<size_t>(streamOffset) < size_bytes_) {
+                for (const auto& free : freeEntries) entries_[free.first].set = false;
+                try {
+                    LoadXrefStream(static_cast<size_t>(streamOffset));
+                } catch (...) {
+                    for (const auto& free : freeEntries) entries_[free.first] = free.second;
+                    throw;
+                }
+                for (const auto& free : freeEntries) {
+                    if (!entries_[free.first].set) entries_[free.first] = free.second;
+                }
+            }
+        }
+        return trailer;
+    }
+
+    LazyPdfValue LazyPdfReader::LoadXrefStream(size_t offset) {
+        Lexer lexer(data_, size_bytes_, offset);
+        long long objectNumber = lexer.ReadInteger();
+        if (objectNumber <= 0) throw LazyPdfUnsupported("Invalid xref stream object.");
+        LazyPdfObject object = ParseIndirect(static_cast<uint32_t>(objectNumber), offset);
+        const LazyPdfValue& dictionary = object.value;
+        const LazyPdfValue* type = dictionary.Find("/Type");
+        if (!type || !type->IsName("/XRef") || !object.streamData) {
+            throw LazyPdfUnsupported("startxref does not point to an xref.");
+        }
+
+        const LazyPdfValue* w = dictionary.Find("/W");
+        if (!w || w->kind != LazyPdfValue::Kind::Array || w->items.size() != 3) {
+            throw LazyPdfUnsupported("Invalid xref stream /W.");
+        }
+        size_t widths[3];
+        size_t rowSize = 0;
+        for (int i = 0; i < 3; ++i) {
+            long long width = w->items[i].AsInteger();
+            if (width < 0 || width > 8) throw LazyPdfUnsupported("Invalid xref stream /W.");
+            widths[i] = static_cast<size_t>(width);
+            rowSize += widths[i];
+        }
+        if (rowSize == 0) throw LazyPdfUnsupported("Invalid xref stream /W.");
+
+        std::vector<std::pair<long long, long long>> sections;
+        if (const LazyPdfValue* index = dictionary.Find("/Index")) {
+            if (index->kind != LazyPdfValue::Kind::Array || index->items.size() % 2 != 0) {
+                throw LazyPdfUnsupported("Invalid xref stream /Index.");
+            }
+            for (size_t i = 0; i < index->items.size(); i += 2) {
+                sections.emplace_back(index->items[i].AsInteger(), index->items[i + 1].AsInteger());
+            }
+        } else {
+            const LazyPdfValue* size = dictionary.Find("/Size");
+            if (!size) throw LazyPdfUnsupported("Xref stream has no /Size.");
+            sections.emplace_back(0, size->AsInteger());
+        }
+
+        std::vector<char> rows = DecodeStream(object);
+        size_t position = 0;
+        auto readField = [&](size_t width, uint64_t fallback) {
+            if (width == 0) return fallback;
+            uint64_t value = 0;
+            for (size_t i = 0; i < width; ++i) {
+                value = (value << 8) | static_cast<unsigned char>(rows[position++]);
+            }
+            return value;
+        };
+        for (const auto& section : sections) {
+            if (section.first < 0 || section.second < 0 || section.first + section.second > kMaxObjectNumber) {
+                throw LazyPdfUnsupported("Invalid xref stream section.");
+            }
+            for (long long i = 0; i < section.second; ++i) {
+                if (position + rowSize > rows.size()) throw LazyPdfUnsupported("Truncated xref stream.");
+                XrefEntry entry;
+                entry.type = static_cast<uint8_t>(readField(widths[0], 1));
+                entry.field2 = readField(widths[1], 0);
+                entry.field3 = static_cast<uint32_t>(readField(widths[2], 0));
+                if (entry.type > 2) entry.type = 0;
+                SetEntry(static_cast<uint32_t>(section.first + i), entry);
+            }
+        }
+        return dictionary;
+    }
+
+    uint16_t LazyPdfReader::GetGeneration(uint32_t objectNumber) const {
+        if (objectNumber < entries_.size() && entries_[objectNumber].type == 1) {
+            return static_cast<uint16_t>(entries_[objectNumber].field3);
+        }
+        return 0;
+    }
+
+    const LazyPdfObject& LazyPdfReader::GetObject(uint32_t objectNumber) {
+        static const LazyPdfObject kNullObject;
+        auto it = objects_.find(objectNumber);
+        if (it != objects_.end()) return it->second;
+        if (objectNumber >= entries_.size() || entries_[objectNumber].type == 0) return kNullObject;
+
+        const XrefEntry& entry = entries_[objectNumber];
+        LazyPdfObject object = entry.type == 1
+                ? ParseIndirect(objectNumber, static_cast<size_t>(entry.field2))
+                : ParseCompressed(objectNumber, static_cast<uint32_t>(entry.field2), entry.field3);
+        return objects_.emplace(objectNumber, std::move(object)).first->second;
+    }
+
+    const LazyPdfValue& LazyPdfReader::Resolve(const LazyPdfValue& value) {
+        const LazyPdfValue* current = &value;
+        // Chuỗi tham chiếu lồng nhau hiếm gặp; giới hạn để tránh vòng lặp.
+        for (int i = 0; i < 32 && current->kind == LazyPdfValue::Kind::Reference; ++i) {
+            current = &GetObject(current->objectNumber).value;
+        }
+        return *current;
+    }
+
+    LazyPdfObject LazyPdfReader::ParseIndirect(uint32_t objectNumber, size_t offset) {
+        if (offset >= size_bytes_) throw LazyPdfUnsupported("Object offset is outside of the PDF.");
+        Lexer lexer(data_, size_bytes_, offset);
+        long long number = lexer.ReadInteger();
+        lexer.ReadInteger();
+        lexer.ExpectKeyword("obj");
+        if (number != objectNumber) throw LazyPdfUnsupported("Xref offset points to a different object.");
+
+        LazyPdfObject object;
+        object.value = lexer.ReadValue();
+        if (object.value.kind != LazyPdfValue::Kind::Dictionary || !lexer.PeekKeyword("stream")) {
+            return object;
+        }
+
+        lexer.ExpectKeyword("stream");
+        size_t start = lexer.Position();
+        if (start < size_bytes_ && data_[start] == '\r') ++start;
+        if (start < size_bytes_ && data_[start] == '\n') ++start;
+
+        size_t length = std::string::npos;
+        if (const LazyPdfValue* lengthValue = object.value.Find("/Length")) {
+            const LazyPdfValue& resolved = Resolve(*lengthValue);
+            if (resolved.kind == LazyPdfValue::Kind::Number) {
+                long long declared = resolved.AsInteger();
+                if (declared >= 0 && start + static_cast<size_t>(declared) <= size_bytes_) {
+                    length = static_cast<size_t>(declared);
+                }
+            }
+        }
+        if (length == std::string::npos) {
+            // /Length sai: tìm "endstream".
+            static const char kEndStream[] = "endstream";
+            const char* end = std::search(data_ + start, data_ + size_bytes_, kEndStream, kEndStream + 9);
+            if (end == data_ + size_bytes_) throw LazyPdfUnsupported("Unterminated stream.");
+            length = static_cast<size_t>(end - (data_ + start));
+            while (length > 0 && (data_[start + length - 1] == '\n' || data_[start + length - 1] == '\r')) --length;
+        }
+        object.streamData = data_ + start;
+        object.streamLength = length;
+        return object;
+    }
+
+    LazyPdfObject LazyPdfReader::ParseCompressed(uint32_t objectNumber, uint32_t streamNumber, uint32_t index) {
+        auto it = object_streams_.find(streamNumber);
+        if (it == object_streams_.end()) {
+            if (streamNumber >= entries_.size() || entries_[streamNumber].type != 1) {
+                throw LazyPdfUnsupported("Invalid object stream reference.");
+            }
+            LazyPdfObject container = ParseIndirect(streamNumber, static_cast<size_t>(entries_[streamNumber].field2));
+            const LazyPdfValue* n = container.value.Find("/N");
+            const LazyPdfValue* first = container.value.Find("/First");
+            if (!n || !first || !container.streamData) throw LazyPdfUnsupported("Invalid object stream.");
+
+            ObjectStream objectStream;
+            objectStream.data = DecodeStream(container);
+            long long count = n->AsInteger();
+            long long firstOffset = first->AsInteger();
+            if (count < 0 || firstOffset < 0 || static_cast<size_t>(firstOffset) > objectStream.data.size()) {
+                throw LazyPdfUnsupported("Invalid object stream header.");
+            }
+            Lexer header(objectStream.data.data(), static_cast<size_t>(firstOffset), 0);
+            for (long long i = 0; i < count; ++i) {
+                long long number = header.ReadInteger();
+                long long relative = header.ReadInteger();
+                if (number < 0 || relative < 0) throw LazyPdfUnsupported("Invalid object stream header.");
+                objectStream.offsets.emplace_back(static_cast<uint32_t>(number),
+                                                  static_cast<size_t>(firstOffset + relative));
+            }
+            it = object_streams_.emplace(streamNumber, std::move(objectStream)).first;
+        }
+
+        const ObjectStream& objectStream = it->second;
+        if (index >= objectStream.offsets.size() || objectStream.offsets[index].first != objectNumber) {
+            throw LazyPdfUnsupported("Object not found in object stream.");
+        }
+        Lexer lexer(objectStream.data.data(), objectStream.data.size(), objectStream.offsets[index].second);
+        LazyPdfObject object;
+        object.value = lexer.ReadValue();
+        return object;
+    }
+
+    std::vector<char> LazyPdfReader::DecodeStream(const LazyPdfObject& object) {
+        const LazyPdfValue* filter = object.value.Find("/Filter");
+        const LazyPdfValue* parms = object.value.Find("/DecodeParms");
+        if (filter) {
+            const LazyPdfValue& resolved = Resolve(*filter);
+            if (resolved.kind == LazyPdfValue::Kind::Array && resolved.items.size() == 1) filter = &resolved.items[0];
+            else filter = &resolved;
+        }
+        if (parms) {
+            const LazyPdfValue& resolved = Resolve(*parms);
+            if (resolved.kind == LazyPdfValue::Kind::Array && resolved.items.size() == 1) parms = &Resolve(resolved.items[0]);
+            else parms = &resolved;
+        }
+
+        if (!filter || filter->kind == LazyPdfValue::Kind::Null) {
+            return std::vector<char>(object.streamData, object.streamData + object.streamLength);
+        }
+        if (!filter->IsName("/FlateDecode")) throw LazyPdfUnsupported("Unsupported stream filter.");
+
+        std::vector<char> data = Inflate(object.streamData, object.streamLength);
+        if (parms && parms->kind == LazyPdfValue::Kind::Dictionary) {
+            const LazyPdfValue* predictor = parms->Find("/Predictor");
+            if (predictor && predictor->AsInteger() >= 10) {
+                const LazyPdfValue* columns = parms->Find("/Columns");
+                const LazyPdfValue* colors = parms->Find("/Colors");
+                const LazyPdfValue* bits = parms->Find("/BitsPerComponent");
+                if ((colors && colors->AsInteger() != 1) || (bits && bits->AsInteger() != 8)) {
+                    throw LazyPdfUnsupported("Unsupported predictor parameters.");
+                }
+                data = RemovePngPredictor(data, columns ? static_cast<size_t>(columns->AsInteger()) : 1);
+            } else if (predictor && predictor->AsInteger() > 1) {
+                throw LazyPdfUnsupported("Unsupported TIFF predictor.");
+            }
+        }
+        return data;
+    }
+
+    LazyPdfValue LazyPdfReader::GetPageReference(int pageIndex) {
+        const LazyPdfValue* root = trailer_.Find("/Root");
+        if (!root || root->kind != LazyPdfValue::Kind::Reference) throw LazyPdfUnsupported("Trailer has no /Root.");
+        const LazyPdfValue* pages = Resolve(*root).Find("/Pages");
+        if (!pages || pages->kind != LazyPdfValue::Kind::Reference) throw LazyPdfUnsupported("Catalog has no /Pages.");
+        if (pageIndex < 0) throw std::runtime_error("Số trang không hợp lệ.");
+
+        LazyPdfValue node = *pages;
+        long long remaining = pageIndex;
+        for (int depth = 0; depth < kMaxPageTreeDepth; ++depth) {
+            const LazyPdfValue* kids = Resolve(node).Find("/Kids");
+            if (!kids) throw LazyPdfUnsupported("Page tree node has no /Kids.");
+            const LazyPdfValue& kidArray = Resolve(*kids);
+            if (kidArray.kind != LazyPdfValue::Kind::Array) throw LazyPdfUnsupported("Invalid /Kids.");
+
+            bool descended = false;
+            for (const auto& kid : kidArray.items) {
+                if (kid.kind != LazyPdfValue::Kind::Reference) throw LazyPdfUnsupported("Invalid /Kids entry.");
+                const LazyPdfValue& kidDictionary = Resolve(kid);
+                const LazyPdfValue* type = kidDictionary.Find("/Type");
+                bool isNode = (type && type->IsName("/Pages")) || (!type && kidDictionary.Find("/Kids"));
+                if (!isNode) {
+                    if (remaining == 0) return kid;
+                    --remaining;
+                    continue;
+                }
+                const LazyPdfValue* count = kidDictionary.Find("/Count");
+                if (!count) throw LazyPdfUnsupported("Page tree node has no /Count.");
+                long long kidCount = Resolve(*count).AsInteger();
+                if (remaining < kidCount) {
+                    node = kid;
+                    descended = true;
+                    break;
+                }
+                remaining -= kidCount;
+            }
+            if (!descended) throw std::runtime_error("Số trang không hợp lệ.");
+        }
+        throw LazyPdfUnsupported("Page tree is too deep.");
+    }
+
+    struct LazyPdfDocument::HashState {
+        EVP_MD_CTX* ctx = nullptr;
+
+        ~HashState() {
+            if (ctx) EVP_MD_CTX_free(ctx);
+        }
+    };
+
+    LazyPdfDocument::LazyPdfDocument(const std::vector<uint8_t>& pdf, int pageNumber)
+            : bytes_(&pdf), reader_(new LazyPdfReader(pdf.data(), pdf.size())) {
+        const LazyPdfValue& trailer = reader_->GetTrailer();
+        if (trailer.Find("/Encrypt")) throw LazyPdfUnsupported("Encrypted PDF.");
+        const LazyPdfValue* root = trailer.Find("/Root");
+        if (!root || root->kind != LazyPdfValue::Kind::Reference) throw LazyPdfUnsupported("Trailer has no /Root.");
+
+        LazyPdfValue pageRef = reader_->GetPageReference(pageNumber - 1);
+
+        // Đọc trước các object sẽ bị ghi lại để tài liệu hỏng lộ ra ngay ở bước này.
+        const LazyPdfValue& catalog = reader_->Resolve(*root);
+        if (catalog.kind != LazyPdfValue::Kind::Dictionary) throw LazyPdfUnsupported("Invalid catalog.");
+        if (const LazyPdfValue* acroForm = catalog.Find("/AcroForm")) {
+            if (const LazyPdfValue* fields = reader_->Resolve(*acroForm).Find("/Fields")) reader_->Resolve(*fields);
+        }
+        if (const LazyPdfValue* annots = reader_->Resolve(pageRef).Find("/Annots")) reader_->Resolve(*annots);
+    }
+
+    LazyPdfDocument::~LazyPdfDocument() = default;
+
+    bool LazyPdfDocument::FindField(const std::string& name, LazyPdfField& field) {
+        const LazyPdfValue* root = reader_->GetTrailer().Find("/Root");
+        if (!root) return false;
+        const LazyPdfValue* acroForm = reader_->Resolve(*root).Find("/AcroForm");
+        if (!acroForm) return false;
+        const LazyPdfValue* fields = reader_->Resolve(*acroForm).Find("/Fields");
+        if (!fields) return false;
+        return FindFieldIn(*reader_, reader_->Resolve(*fields), std::string(), name, field, 0);
+    }
+
+    bool LazyPdfDocument::HasField(const std::string& name) {
+        LazyPdfField field;
+        return FindField(name, field);
+    }
+
+    std::vector<uint8_t> LazyPdfDocument::TakeBytes() {
+        if (bytes_ != &owned_) return *bytes_;
+        return std::move(owned_);
+    }
+
+    void LazyPdfDocument::AppendSignature(const LazyPdfSignParams& params, const LazyPdfAppearance& appearance,
+                                          const CmsTemplate& cmsTemplate, const CardSignFunction& sign) {
+        const std::vector<uint8_t>& pdf = *bytes_;
+        LazyPdfReader& reader = *reader_;
+        const LazyPdfValue trailer = reader.GetTrailer();
+        const LazyPdfValue* root = trailer.Find("/Root");
+
+        LazyPdfField existing;
+        bool useExisting = FindField(params.fieldName, existing);
+        if (useExisting) {
+            if (!existing.isSignature) throw std::runtime_error("Field '" + params.fieldName + "' không phải field chữ ký.");
+            if (existing.isSigned) throw std::runtime_error("Field '" + params.fieldName + "' đã được ký.");
+            if (existing.widget.kind != LazyPdfValue::Kind::Reference) {
+                throw LazyPdfUnsupported("Signature field does not have a single widget.");
+            }
+        }
+        LazyPdfValue pageRef = useExisting ? LazyPdfValue() : reader.GetPageReference(params.pageNumber - 1);
+
+        bool needsNewline = !pdf.empty() && pdf.back() != '\n' && pdf.back() != '\r';
+        UpdateWriter writer(pdf.size());
+        if (needsNewline) writer.Buffer() += '\n';
+
+        uint32_t nextObject = reader.GetSize();
+        uint32_t signatureNumber = nextObject++;
+        uint32_t widgetNumber = useExisting ? existing.widget.objectNumber : nextObject++;
+        uint32_t formNumber = nextObject++;
+
+        // Appearance: form ngoài cùng, tài nguyên chép từ template.
+        LazyPdfValue resources = LazyPdfValue::Dictionary();
+        if (appearance.source && !appearance.source->empty()) {
+            LazyPdfReader source(reinterpret_cast<const uint8_t*>(appearance.source->data()), appearance.source->size());
+            GraphCopier copier(source, writer, nextObject);
+            LazyPdfValue xobjects = LazyPdfValue::Dictionary();
+            for (const auto& entry : appearance.xobjects) {
+                xobjects.Set("/" + entry.first, LazyPdfValue::Reference(copier.Copy(entry.second)));
+            }
+            LazyPdfValue fonts = LazyPdfValue::Dictionary();
+            for (const auto& entry : appearance.fonts) {
+                fonts.Set("/" + entry.first, LazyPdfValue::Reference(copier.Copy(entry.second)));
+            }
+            if (!xobjects.entries.empty()) resources.Set("/XObject", xobjects);
+            if (!fonts.entries.empty()) resources.Set("/Font", fonts);
+        }
+
+        LazyPdfValue rect = LazyPdfValue::Array();
+        rect.items = { Number(params.x), Number(params.y), Number(params.x + params.width), Number(params.y + params.height) };
+
+        LazyPdfValue form = LazyPdfValue::Dictionary();
+        form.Set("/Type", Name("/XObject"));
+        form.Set("/Subtype", Name("/Form"));
+        form.Set("/BBox", rect);
+        form.Set("/Resources", resources);
+        writer.WriteStreamObject(formNumber, form, appearance.content.data(), appearance.content.size());
+
+        // Từ điển chữ ký: ghi tay để biết vị trí /ByteRange và /Contents.
+        size_t contentsLength = cmsTemplate.GetSignedDataSize() * 2;
+        writer.BeginObject(signatureNumber, 0);
+        std::string& out = writer.Buffer();
+        LazyPdfValue signatureInfo = LazyPdfValue::Dictionary();
+        signatureInfo.Set("/Type", Name("/Sig"));
+        signatureInfo.Set("/Filter", Name("/Adobe.PPKLite"));
+        signatureInfo.Set("/SubFilter", Name("/adbe.pkcs7.detached"));
+        signatureInfo.Set("/M", PdfDateString(params.signingTime));
+        if (!params.reason.empty()) signatureInfo.Set("/Reason", TextString(params.reason));
+        if (!params.location.empty()) signatureInfo.Set("/Location", TextString(params.location));
+        if (!params.signerName.empty()) signatureInfo.Set("/Name", TextString(params.signerName));
+        signatureInfo.Serialize(out);
+        out.resize(out.size() - 2);  // bỏ ">>" để nối tiếp
+        out += "/ByteRange ";
+        size_t byteRangePosition = out.size();
+        out += "[0 " + std::string(kByteRangeFieldWidth * 3 + 2, ' ') + "]";
+        out += " /Contents ";
+        size_t contentsPosition = out.size();
+        out += '<';
+        out.append(contentsLength, '0');
+        out += '>';
+        size_t contentsEnd = out.size();
+        out += " >>\nendobj\n";
+
+        LazyPdfValue appearanceDictionary = LazyPdfValue::Dictionary();
+        appearanceDictionary.Set("/N", LazyPdfValue::Reference(formNumber));
+        LazyPdfValue signatureRef = LazyPdfValue::Reference(signatureNumber);
+        if (useExisting) {
+            // Field có sẵn: gắn chữ ký và appearance, trang và /Fields giữ nguyên.
+            LazyPdfValue widget = reader.Resolve(existing.widget);
+            widget.Set("/AP", appearanceDictionary);
+            if (existing.field.objectNumber == widgetNumber) {
+                widget.Set("/V", signatureRef);
+            } else {
+                LazyPdfValue field = reader.Resolve(existing.field);
+                field.Set("/V", signatureRef);
+                writer.WriteObject(existing.field.objectNumber, reader.GetGeneration(existing.field.objectNumber), field);
+            }
+            writer.WriteObject(widgetNumber, reader.GetGeneration(widgetNumber), widget);
+        } else {
+            LazyPdfValue widget = LazyPdfValue::Dictionary();
+            widget.Set("/Type", Name("/Annot"));
+            widget.Set("/Subtype", Name("/Widget"));
+            widget.Set("/FT", Name("/Sig"));
+            widget.Set("/T", TextString(params.fieldName));
+            widget.Set("/V", signatureRef);
+            widget.Set("/F", Integer(132));
+            widget.Set("/Rect", rect);
+            widget.Set("/P", pageRef);
+            widget.Set("/AP", appearanceDictionary);
+            writer.WriteObject(widgetNumber, 0, widget);
+        }
+        LazyPdfValue widgetRef = LazyPdfValue::Reference(widgetNumber);
+
+        // Trang đích: thêm widget vào /Annots.
+        if (!useExisting) {
+            LazyPdfValue page = reader.Resolve(pageRef);
+            if (AppendToArray(reader, writer, page, "/Annots", widgetRef)) {
+                writer.WriteObject(pageRef.objectNumber, reader.GetGeneration(pageRef.objectNumber), page);
+            }
+        }
+
+        // AcroForm: thêm field và bật SigFlags (SignaturesExist | AppendOnly).
+        LazyPdfValue catalog = reader.Resolve(*root);
+        const LazyPdfValue* acroFormValue = catalog.Find("/AcroForm");
+        if (acroFormValue && acroFormValue->kind == LazyPdfValue::Kind::Reference) {
+            LazyPdfValue acroForm = reader.Resolve(*acroFormValue);
+            if (acroForm.kind != LazyPdfValue::Kind::Dictionary) acroForm = LazyPdfValue::Dictionary();
+            if (!useExisting) AppendToArray(reader, writer, acroForm, "/Fields", widgetRef);
+            acroForm.Set("/SigFlags", Integer(3));
+            writer.WriteObject(acroFormValue->objectNumber, reader.GetGeneration(acroFormValue->objectNumber), acroForm);
+        } else {
+            LazyPdfValue acroForm = (acroFormValue && acroFormValue->kind == LazyPdfValue::Kind::Dictionary)
+                    ? *acroFormValue : LazyPdfValue::Dictionary();
+            if (!useExisting) AppendToArray(reader, writer, acroForm, "/Fields", widgetRef);
+            acroForm.Set("/SigFlags", Integer(3));
+            catalog.Set("/AcroForm", acroForm);
+            writer.WriteObject(root->objectNumber, reader.GetGeneration(root->objectNumber), catalog);
+        }
+
+        LazyPdfValue newTrailer = LazyPdfValue::Dictionary();
+        newTrailer.Set("/Root", *root);
+        if (const LazyPdfValue* info = trailer.Find("/Info")) newTrailer.Set("/Info", *info);
+        if (const LazyPdfValue* id = trailer.Find("/ID")) newTrailer.Set("/ID", *id);
+        newTrailer.Set("/Prev", Integer(static_cast<long long>(reader.GetStartXref())));
+        if (reader.UsesXrefStream()) {
+            uint32_t xrefNumber = nextObject++;
+            newTrailer.Set("/Size", Integer(nextObject));
+            writer.WriteXrefStream(xrefNumber, newTrailer);
+        } else {
+            newTrailer.Set("/Size", Integer(nextObject));
+            writer.WriteXrefTable(newTrailer);
+        }
+
+        // ByteRange phủ mọi thứ trừ giá trị /Contents.
+        size_t base = pdf.size();
+        size_t total = base + out.size();
+        size_t gapStart = base + contentsPosition;
+        size_t gapEnd = base + contentsEnd;
+        char byteRange[64];
+        int written = std::snprintf(byteRange, sizeof(byteRange), "[0 %-*zu %-*zu %-*zu]",
+                                    kByteRangeFieldWidth, gapStart, kByteRangeFieldWidth, gapEnd,
+                                    kByteRangeFieldWidth, total - gapEnd);
+        if (written != kByteRangeFieldWidth * 3 + 6) throw LazyPdfUnsupported("PDF is too large for /ByteRange.");
+        std::memcpy(&out[byteRangePosition], byteRange, static_cast<size_t>(written));
+
+        // Phần đã có chỉ được hash một lần; mỗi revision chỉ hash thêm phần mới.
+        if (!hash_) {
+            std::unique_ptr<HashState> state(new HashState());
+            state->ctx = EVP_MD_CTX_new();
+            if (!state->ctx || EVP_DigestInit_ex(state->ctx, EVP_sha256(), nullptr) != 1 ||
+                EVP_DigestUpdate(state->ctx, pdf.data(), pdf.size()) != 1) {
+                throw std::runtime_error("Cannot hash PDF byte range.");
+            }
+            hash_ = std::move(state);
+        }
+        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+        if (!ctx) throw std::runtime_error("EVP_MD_CTX_new failed.");
+        uint8_t digest[kSha256Length];
+        unsigned int digestLength = 0;
+        bool ok = EVP_MD_CTX_copy_ex(ctx, hash_->ctx) == 1 &&
+                  EVP_DigestUpdate(ctx, out.data(), contentsPosition) == 1 &&
+                  EVP_DigestUpdate(ctx, out.data() + contentsEnd, out.size() - contentsEnd) == 1 &&
+                  EVP_DigestFinal_ex(ctx, digest, &digestLength) == 1;
+        EVP_MD_CTX_free(ctx);
+        if (!ok || digestLength != kSha256Length) throw std::runtime_error("Cannot hash PDF byte range.");
+
+        auto signedData = cmsTemplate.BuildSignedData(digest, params.signingTime, sign);
+        if (signedData.size() * 2 > contentsLength) throw std::runtime_error("Signature does not fit in /Contents.");
+        EncodeHex(signedData.data(), signedData.size(), reinterpret_cast<char*>(&out[contentsPosition + 1]),
+                  HexCase::Upper);
+
+        // Ghi nhận revision: nối vào buffer riêng và cập nhật reader, hash.
+        if (EVP_DigestUpdate(hash_->ctx, out.data(), out.size()) != 1) {
+            hash_.reset();
+            throw std::runtime_error("Cannot hash PDF byte range.");
+        }
+        if (bytes_ != &owned_) {
+            owned_.reserve(total);
+            owned_.assign(pdf.begin(), pdf.end());
+            bytes_ = &owned_;
+        }
+        owned_.insert(owned_.end(), out.begin(), out.end());
+        reader.AppendUpdate(owned_.data(), owned_.size());
+        ++revisions_;
+    }
+
+    std::vector<LazyPdfSignature> FindPdfSignatures(LazyPdfReader& reader) {
+        std::vector<LazyPdfSignature> signatures;
+        const LazyPdfValue* root = reader.GetTrailer().Find("/Root");
+        if (!root) throw LazyPdfUnsupported("Trailer has no /Root.");
+        const LazyPdfValue* acroForm = reader.Resolve(*root).Find("/AcroForm");
+        if (!acroForm) return signatures;
+        const LazyPdfValue* fields = reader.Resolve(*acroForm).Find("/Fields");
+        if (!fields) return signatures;
+        CollectSignatures(reader, reader.Resolve(*fields), std::string(), signatures, 0);
+        return signatures;
+    }
+
+    std::vector<uint8_t> SignPdfIncremental(const std::vector<uint8_t>& pdf, const LazyPdfSignParams& params,
+                                            const LazyPdfAppearance& appearance, const CmsTemplate& cmsTemplate,
+                                            const CardSignFunction& sign) {
+        LazyPdfDocument document(pdf, params.pageNumber);
+        return SignPdfIncremental(document, params, appearance, cmsTemplate, sign);
+    }
+
+    std::vector<uint8_t> SignPdfIncremental(LazyPdfDocument& document, const LazyPdfSignParams& params,
+                                            const LazyPdfAppearance& appearance, const CmsTemplate& cmsTemplate,
+                                            const CardSignFunction& sign) {
+        document.AppendSignature(params, appearance, cmsTemplate, sign);
+        return document.TakeBytes();
+    }
+
+}  // namespace nfcsigner
@@ -0,0 +1,252 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_LAZY_PDF_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_LAZY_PDF_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "cms_template.h"
+#include "request_arena.h"
+
+namespace nfcsigner {
+
+    // Tài liệu nằm ngoài phạm vi của đường ký từng phần (mã hóa, xref hỏng,
+    // cú pháp lạ...). Caller chuyển sang nạp toàn bộ bằng PoDoFo.
+    class LazyPdfUnsupported : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Giá trị PDF đã phân tích. Số, tên và chuỗi giữ nguyên token gốc để khi
+    // ghi lại vào bản cập nhật không làm thay đổi nội dung.
+    //
+    // Token, mảng và từ điển (kể cả bản sao) cấp phát từ arena của request
+    // đang chạy trên thread tạo ra chúng (CurrentRequestArena), nên arena phải
+    // sống lâu hơn giá trị. Move constructor cũng cấp phát theo thread đích:
+    // giá trị move ra ngoài Scope của arena nguồn được chép sang heap thay vì
+    // mang theo allocator của arena có thể đã bị hủy. Cùng arena thì move chỉ
+    // lấy bộ nhớ nên được khai báo noexcept, để vector dời phần tử bằng move
+    // thay vì chép sâu cả cây khi tăng dung lượng; chép sang arena khác chỉ
+    // lỗi khi hết bộ nhớ.
+    struct LazyPdfValue {
+        enum class Kind { Null, Boolean, Number, Name, String, Array, Dictionary, Reference };
+
+        Kind kind = Kind::Null;
+        std::pmr::string token{ CurrentRequestArena() };
+        std::pmr::vector<LazyPdfValue> items{ CurrentRequestArena() };
+        // Khóa gồm cả dấu '/' (ví dụ "/Type"), cấp phát cùng arena với vector.
+        std::pmr::vector<std::pair<std::pmr::string, LazyPdfValue>> entries{ CurrentRequestArena() };
+        uint32_t objectNumber = 0;
+        uint16_t generation = 0;
+
+        LazyPdfValue() = default;
+        LazyPdfValue(const LazyPdfValue& other);
+        LazyPdfValue(LazyPdfValue&& other) noexcept;
+        LazyPdfValue& operator=(const LazyPdfValue& other) = default;
+        LazyPdfValue& operator=(LazyPdfValue&& other) = default;
+
+        static LazyPdfValue Token(Kind kind, std::string_view token);
+        static LazyPdfValue Reference(uint32_t objectNumber, uint16_t generation = 0);
+        static LazyPdfValue Array();
+        static LazyPdfValue Dictionary();
+
+        const LazyPdfValue* Find(std::string_view key) const;
+        void Set(std::string_view key, LazyPdfValue value);
+        bool IsName(const char* name) const;
+        // Ném LazyPdfUnsupported nếu không phải số nguyên.
+        long long AsInteger() const;
+
+        void Serialize(std::string& out) const;
+    };
+
+    // Object gián tiếp: giá trị và vùng dữ liệu stream thô (nếu có).
+    struct LazyPdfObject {
+        LazyPdfValue value;
+        const char* streamData = nullptr;
+        size_t streamLength = 0;
+    };
+
+    // Đọc PDF theo nhu cầu. Lúc mở chỉ đọc startxref, các bảng/stream xref và
+    // trailer; object chỉ được phân tích khi được hỏi tới và được giữ lại.
+    // Buffer [data] phải sống lâu hơn reader.
+    class LazyPdfReader {
+    public:
+        LazyPdfReader(const uint8_t* data, size_t size);
+        ~LazyPdfReader();
+
+        LazyPdfReader(const LazyPdfReader&) = delete;
+        LazyPdfReader& operator=(const LazyPdfReader&) = delete;
+
+        const LazyPdfValue& GetTrailer() const { return trailer_; }
+        size_t GetStartXref() const { return start_xref_; }
+        // Phần xref mới nhất là xref stream (PDF 1.5+) thay vì bảng cổ điển.
+        bool UsesXrefStream() const { return uses_xref_stream_; }
+        // Giá trị /Size của trailer: số object đầu tiên còn trống.
+        uint32_t GetSize() const { return size_; }
+        uint16_t GetGeneration(uint32_t objectNumber) const;
+
+        const LazyPdfObject& GetObject(uint32_t objectNumber);
+        // Theo tham chiếu (nếu có) tới giá trị thật.
+        const LazyPdfValue& Resolve(const LazyPdfValue& value);
+        // Tham chiếu tới trang [pageIndex] (tính từ 0). Chỉ đi theo nhánh cây
+        // trang chứa trang đó, dùng /Count để bỏ qua các nhánh khác.
+        LazyPdfValue GetPageReference(int pageIndex);
+        // Dữ liệu stream sau khi giải nén (chỉ hỗ trợ FlateDecode).
+        std::vector<char> DecodeStream(const LazyPdfObject& object);
+
+        size_t GetParsedObjectCount() const { return objects_.size(); }
+
+        // Chuyển sang [data]: nội dung cũ nối thêm một incremental update (do
+        // LazyPdfDocument ghi). Object đã đọc được giữ lại, trừ những object bị
+        // update ghi đè.
+        void AppendUpdate(const uint8_t* data, size_t size);
+
+    private:
+        struct XrefEntry {
+            uint8_t type = 0;       // 0: trống, 1: offset trong file, 2: nằm trong object stream
+            uint64_t field2 = 0;    // offset hoặc số hiệu object stream
+            uint32_t field3 = 0;    // generation hoặc vị trí trong object stream
+            bool set = false;
+        };
+
+        struct ObjectStream {
+            std::vector<char> data;
+            std::vector<std::pair<uint32_t, size_t>> offsets;
+        };
+
+        void LoadXref();
+        size_t FindStartXref() const;
+        void ReadSize();
+        LazyPdfValue LoadXrefTable(size_t offset);
+        LazyPdfValue LoadXrefStream(size_t offset);
+        // false nếu phần xref mới hơn đã có mục cho [objectNumber].
+        bool SetEntry(uint32_t objectNumber, const XrefEntry& entry);
+        LazyPdfObject ParseIndirect(uint32_t objectNumber, size_t offset);
+        LazyPdfObject ParseCompressed(uint32_t objectNumber, uint32_t streamNumber, uint32_t index);
+
+        const char* data_;
+        size_t size_bytes_;
+        size_t start_xref_ = 0;
+        bool uses_xref_stream_ = false;
+        uint32_t size_ = 0;
+        LazyPdfValue trailer_;
+        // Cấp phát từ arena của request tạo reader.
+        std::pmr::vector<XrefEntry> entries_{ CurrentRequestArena() };
+        std::pmr::unordered_map<uint32_t, LazyPdfObject> objects_{ CurrentRequestArena() };
+        std::pmr::unordered_map<uint32_t, ObjectStream> object_streams_{ CurrentRequestArena() };
+    };
+
+    // Appearance được chép vào bản cập nhật: content stream của form cùng các
+    // tài nguyên lấy từ một PDF nguồn đã serialize (template appearance).
+    struct LazyPdfAppearance {
+        std::string content;
+        std::shared_ptr<const std::vector<char>> source;
+        // Tên tài nguyên -> số hiệu object trong [source].
+        std::vector<std::pair<std::string, uint32_t>> xobjects;
+        std::vector<std::pair<std::string, uint32_t>> fonts;
+    };
+
+    struct LazyPdfSignParams {
+        int pageNumber = 1;
+        double x = 50.0;
+        double y = 700.0;
+        double width = 200.0;
+        double height = 50.0;
+        std::string fieldName = "BMC-Signature";
+        std::string reason;
+        std::string location;
+        std::string signerName;
+        std::time_t signingTime = 0;
+    };
+
+    // Field trong AcroForm, tìm theo tên đầy đủ (các /T nối bằng dấu chấm).
+    struct LazyPdfField {
+        LazyPdfValue field;     // tham chiếu tới field
+        LazyPdfValue widget;    // tham chiếu tới widget (trùng [field] nếu gộp), Null nếu không xác định được
+        bool isSignature = false;
+        bool isSigned = false;
+        double x = 0.0;
+        double y = 0.0;
+        double width = 0.0;
+        double height = 0.0;
+    };
+
+    // Tài liệu mở bằng LazyPdfReader để ký một hoặc nhiều chữ ký liên tiếp.
+    // Mỗi chữ ký là một revision nối vào cuối; reader, các object đã đọc và
+    // hash SHA-256 của phần đã có được giữ lại giữa các revision.
+    //
+    // Constructor chỉ đọc (xref, trailer, catalog, AcroForm, trang đích), không
+    // cần certificate nên chạy được song song với thao tác trên thẻ. Ném
+    // LazyPdfUnsupported nếu tài liệu cần đường nạp toàn bộ. [pdf] phải sống
+    // lâu hơn đối tượng này.
+    class LazyPdfDocument {
+    public:
+        LazyPdfDocument(const std::vector<uint8_t>& pdf, int pageNumber);
+        ~LazyPdfDocument();
+
+        LazyPdfDocument(const LazyPdfDocument&) = delete;
+        LazyPdfDocument& operator=(const LazyPdfDocument&) = delete;
+
+        // Bản gốc cộng các revision đã ký.
+        const std::vector<uint8_t>& GetBytes() const { return *bytes_; }
+        LazyPdfReader& GetReader() { return *reader_; }
+        size_t GetRevisionCount() const { return revisions_; }
+
+        bool FindField(const std::string& name, LazyPdfField& field);
+        bool HasField(const std::string& name);
+
+        // Ký thêm một revision. Nếu [params].fieldName là field chữ ký trống có
+        // sẵn thì ký vào field đó (vị trí lấy theo [params], caller đọc từ
+        // FindField), ngược lại tạo field mới trên [params].pageNumber.
+        void AppendSignature(const LazyPdfSignParams& params, const LazyPdfAppearance& appearance,
+                             const CmsTemplate& cmsTemplate, const CardSignFunction& sign);
+
+        // Lấy kết quả; sau đó không dùng đối tượng này nữa.
+        std::vector<uint8_t> TakeBytes();
+
+    private:
+        struct HashState;
+
+        const std::vector<uint8_t>* bytes_;
+        std::vector<uint8_t> owned_;
+        std::unique_ptr<LazyPdfReader> reader_;
+        std::unique_ptr<HashState> hash_;
+        size_t revisions_ = 0;
+    };
+
+    // Field chữ ký đã ký: tên đầy đủ và các mục của từ điển /Sig cần để kiểm
+    // tra. /Contents chính là khoảng trống giữa hai đoạn của [byteRange].
+    struct LazyPdfSignature {
+        std::string fieldName;
+        std::vector<long long> byteRange;
+        std::string subFilter;      // không có dấu '/', ví dụ "adbe.pkcs7.detached"
+        std::string signingTime;    // /M, dạng "D:YYYYMMDDHHmmSS..."
+    };
+
+    // Mọi chữ ký trong AcroForm của revision mới nhất, theo thứ tự field.
+    std::vector<LazyPdfSignature> FindPdfSignatures(LazyPdfReader& reader);
+
+    // Ký [pdf] bằng một incremental update chỉ chứa các object bị chạm tới:
+    // chữ ký, widget, appearance, trang đích, AcroForm/catalog và xref mới.
+    // Chi phí tỉ lệ với số object này chứ không với kích thước tài liệu.
+    // Ném LazyPdfUnsupported nếu tài liệu cần đường nạp toàn bộ.
+    std::vector<uint8_t> SignPdfIncremental(const std::vector<uint8_t>& pdf, const LazyPdfSignParams& params,
+                                            const LazyPdfAppearance& appearance, const CmsTemplate& cmsTemplate,
+                                            const CardSignFunction& sign);
+
+    // Như trên, với tài liệu đã đọc sẵn.
+    std::vector<uint8_t> SignPdfIncremental(LazyPdfDocument& document, const LazyPdfSignParams& params,
+                                            const LazyPdfAppearance& appearance, const CmsTemplate& cmsTemplate,
+                                            const CardSignFunction& sign);
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_LAZY_PDF_H_
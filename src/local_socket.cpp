@@ -0,0 +1,314 @@
+#include "local_socket.h"
+
+#include "daemon_protocol.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <grp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace nfcsigner {
+
+    namespace {
+
+        void EncodeLength(uint8_t* out, uint32_t value) {
+            out[0] = static_cast<uint8_t>(value >> 24);
+            out[1] = static_cast<uint8_t>(value >> 16);
+            out[2] = static_cast<uint8_t>(value >> 8);
+            out[3] = static_cast<uint8_t>(value);
+        }
+
+        uint32_t DecodeLength(const uint8_t* p) {
+            return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                   (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+        }
+
+#ifdef _WIN32
+        // Handle pipe mở với FILE_FLAG_OVERLAPPED ở cả hai phía: chờ từng lệnh
+        // đọc/ghi xong bằng event riêng của lệnh đó.
+        bool TransferOverlapped(HANDLE handle, uint8_t* data, DWORD size, bool write, DWORD& transferred) {
+            OVERLAPPED overlapped = {};
+            overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+            if (!overlapped.hEvent) return false;
+            BOOL ok = write ? WriteFile(handle, data, size, NULL, &overlapped)
+                            : ReadFile(handle, data, size, NULL, &overlapped);
+            if (!ok && GetLastError() != ERROR_IO_PENDING) {
+                CloseHandle(overlapped.hEvent);
+                return false;
+            }
+            ok = GetOverlappedResult(handle, &overlapped, &transferred, TRUE);
+            CloseHandle(overlapped.hEvent);
+            return ok != FALSE;
+        }
+
+        HANDLE CreatePipeInstance(const std::string& endpoint, DWORD extraFlags) {
+            return CreateNamedPipeA(endpoint.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | extraFlags,
+                                    PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+                                    PIPE_UNLIMITED_INSTANCES, 64 * 1024, 64 * 1024, 0, NULL);
+        }
+#else
+        sockaddr_un MakeAddress(const std::string& endpoint) {
+            sockaddr_un address = {};
+            address.sun_family = AF_UNIX;
+            if (endpoint.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error("Socket path too long: " + endpoint);
+            }
+            std::memcpy(address.sun_path, endpoint.c_str(), endpoint.size() + 1);
+            return address;
+        }
+#endif
+
+    }  // namespace
+
+    std::string DefaultDaemonEndpoint() {
+#ifdef _WIN32
+        return "\\\\.\\pipe\\nfcsigner";
+#else
+        const char* runtimeDir = std::getenv("XDG_RUNTIME_DIR");
+        if (runtimeDir && runtimeDir[0] != '\0') return std::string(runtimeDir) + "/nfcsigner.sock";
+        return "/tmp/nfcsigner-" + std::to_string(getuid()) + ".sock";
+#endif
+    }
+
+    bool LocalConnection::ReadFrame(std::vector<uint8_t>& body) {
+        uint8_t header[4];
+        if (!ReadExact(header, 1)) return false;
+        if (!ReadExact(header + 1, 3)) throw std::runtime_error("Connection closed inside a frame");
+        uint32_t size = DecodeLength(header);
+        if (size > kDaemonMaxFrameSize) throw std::runtime_error("Frame too large: " + std::to_string(size));
+        body.resize(size);
+        if (size > 0 && !ReadExact(body.data(), size)) throw std::runtime_error("Connection closed inside a frame");
+        return true;
+    }
+
+    void LocalConnection::WriteFrame(const std::vector<uint8_t>& body) {
+        if (body.size() > kDaemonMaxFrameSize) throw std::runtime_error("Frame too large");
+        uint8_t header[4];
+        EncodeLength(header, static_cast<uint32_t>(body.size()));
+        WriteExact(header, sizeof(header));
+        if (!body.empty()) WriteExact(body.data(), body.size());
+    }
+
+#ifdef _WIN32
+    LocalConnection::~LocalConnection() {
+        if (handle_ != INVALID_HANDLE_VALUE) CloseHandle(handle_);
+    }
+
+    std::unique_ptr<LocalConnection> LocalConnection::Connect(const std::string& endpoint) {
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            HANDLE pipe = CreateFileA(endpoint.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING,
+                                      FILE_FLAG_OVERLAPPED, NULL);
+            if (pipe != INVALID_HANDLE_VALUE) return std::make_unique<LocalConnection>(pipe);
+            // Mọi instance đang bận: chờ dịch vụ tạo instance mới cho client kế tiếp.
+            if (GetLastError() != ERROR_PIPE_BUSY || !WaitNamedPipeA(endpoint.c_str(), 5000)) break;
+        }
+        throw std::runtime_error("Cannot connect to " + endpoint + " (is nfcsignerd running?)");
+    }
+
+    void LocalConnection::Shutdown() {
+        shutdown_ = true;
+        // Hủy lệnh đọc/ghi đang chờ; ReadExact/WriteExact kiểm tra cờ ở lệnh sau.
+        CancelIoEx(handle_, NULL);
+    }
+
+    bool LocalConnection::ReadExact(uint8_t* data, size_t size) {
+        while (size > 0) {
+            if (shutdown_) return false;
+            DWORD read = 0;
+            if (!TransferOverlapped(handle_, data, static_cast<DWORD>(size), false, read) || read == 0) return false;
+            data += read;
+            size -= read;
+        }
+        return true;
+    }
+
+    void LocalConnection::WriteExact(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            if (shutdown_) throw std::runtime_error("Connection shut down");
+            DWORD written = 0;
+            if (!TransferOverlapped(handle_, const_cast<uint8_t*>(data), static_cast<DWORD>(size), true, written)) {
+                throw std::runtime_error("WriteFile failed: " + std::to_string(GetLastError()));
+            }
+            data += written;
+            size -= written;
+        }
+    }
+
+    LocalListener::~LocalListener() {
+        if (pending_pipe_ != INVALID_HANDLE_VALUE) CloseHandle(pending_pipe_);
+        if (stop_event_) CloseHandle(stop_event_);
+    }
+
+    std::unique_ptr<LocalListener> LocalListener::Listen(const std::string& endpoint,
+                                                         const LocalListenerOptions&) {
+        std::unique_ptr<LocalListener> listener(new LocalListener(endpoint));
+        listener->stop_event_ = CreateEventA(NULL, TRUE, FALSE, NULL);
+        if (!listener->stop_event_) throw std::runtime_error("CreateEvent failed.");
+        // Instance đầu tiên tạo ngay: pipe đã có dịch vụ khác giữ thì báo lỗi.
+        listener->pending_pipe_ = CreatePipeInstance(endpoint, FILE_FLAG_FIRST_PIPE_INSTANCE);
+        if (listener->pending_pipe_ == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Cannot create " + endpoint + " (is nfcsignerd already running?)");
+        }
+        return listener;
+    }
+
+    std::unique_ptr<LocalConnection> LocalListener::Accept() {
+        while (!stopped_) {
+            HANDLE pipe = pending_pipe_;
+            pending_pipe_ = INVALID_HANDLE_VALUE;
+            if (pipe == INVALID_HANDLE_VALUE) pipe = CreatePipeInstance(endpoint_, 0);
+            if (pipe == INVALID_HANDLE_VALUE) {
+                throw std::runtime_error("CreateNamedPipe failed: " + std::to_string(GetLastError()));
+            }
+
+            OVERLAPPED overlapped = {};
+            overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+            BOOL connected = ConnectNamedPipe(pipe, &overlapped);
+            DWORD error = connected ? ERROR_PIPE_CONNECTED : GetLastError();
+            if (error == ERROR_IO_PENDING) {
+                HANDLE events[2] = { overlapped.hEvent, stop_event_ };
+                DWORD signaled = WaitForMultipleObjects(2, events, FALSE, INFINITE);
+                DWORD ignored = 0;
+                if (signaled == WAIT_OBJECT_0 && GetOverlappedResult(pipe, &overlapped, &ignored, FALSE)) {
+                    error = ERROR_PIPE_CONNECTED;
+                } else {
+                    // Chờ lệnh bị hủy kết thúc trước khi overlapped ra khỏi phạm vi.
+                    CancelIo(pipe);
+                    GetOverlappedResult(pipe, &overlapped, &ignored, TRUE);
+                }
+            }
+            CloseHandle(overlapped.hEvent);
+            if (error == ERROR_PIPE_CONNECTED) return std::make_unique<LocalConnection>(pipe);
+            CloseHandle(pipe);
+        }
+        return nullptr;
+    }
+
+    void LocalListener::Shutdown() {
+        stopped_ = true;
+        SetEvent(stop_event_);
+    }
+#else
+    LocalConnection::~LocalConnection() {
+        if (handle_ >= 0) close(handle_);
+    }
+
+    std::unique_ptr<LocalConnection> LocalConnection::Connect(const std::string& endpoint) {
+        sockaddr_un address = MakeAddress(endpoint);
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw std::runtime_error("socket failed: " + std::string(std::strerror(errno)));
+        if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            int error = errno;
+            close(fd);
+            throw std::runtime_error("Cannot connect to " + endpoint + " (is nfcsignerd running?): " +
+                                     std::strerror(error));
+        }
+        return std::make_unique<LocalConnection>(fd);
+    }
+
+    void LocalConnection::Shutdown() {
+        shutdown_ = true;
+        // shutdown() đánh thức recv() đang chờ; fd vẫn giữ tới destructor.
+        ::shutdown(handle_, SHUT_RDWR);
+    }
+
+    bool LocalConnection::ReadExact(uint8_t* data, size_t size) {
+        while (size > 0) {
+            ssize_t n = recv(handle_, data, size, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    void LocalConnection::WriteExact(const uint8_t* data, size_t size) {
+        while (size > 0) {
+            // MSG_NOSIGNAL: client đóng giữa chừng không làm dịch vụ nhận SIGPIPE.
+            ssize_t n = send(handle_, data, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw std::runtime_error("send failed: " + std::string(std::strerror(errno)));
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+    LocalListener::~LocalListener() {
+        if (fd_ >= 0) {
+            close(fd_);
+            unlink(endpoint_.c_str());
+        }
+    }
+
+    std::unique_ptr<LocalListener> LocalListener::Listen(const std::string& endpoint,
+                                                         const LocalListenerOptions& options) {
+        sockaddr_un address = MakeAddress(endpoint);
+
+        // Socket còn sót lại từ lần chạy trước bị dừng đột ngột: gỡ nếu không
+        // còn ai nghe; còn dịch vụ đang chạy thì báo lỗi thay vì chiếm chỗ.
+        bool inUse = false;
+        try {
+            LocalConnection::Connect(endpoint);
+            inUse = true;
+        } catch (const std::runtime_error&) {
+        }
+        if (inUse) throw std::runtime_error(endpoint + " is in use (is nfcsignerd already running?)");
+        unlink(endpoint.c_str());
+
+        std::unique_ptr<LocalListener> listener(new LocalListener(endpoint));
+        listener->fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listener->fd_ < 0) throw std::runtime_error("socket failed: " + std::string(std::strerror(errno)));
+        if (bind(listener->fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            int error = errno;
+            close(listener->fd_);
+            listener->fd_ = -1;
+            throw std::runtime_error("Cannot bind " + endpoint + ": " + std::strerror(error));
+        }
+        // Đặt nhóm/quyền trước listen(): tới lúc đó connect() đều bị từ chối nên
+        // không có khoảng hở, và không phải đổi umask của cả tiến trình.
+        std::string error;
+        if (!options.group.empty()) {
+            group* entry = getgrnam(options.group.c_str());
+            if (!entry) {
+                error = "unknown group " + options.group;
+            } else if (chown(endpoint.c_str(), static_cast<uid_t>(-1), entry->gr_gid) != 0) {
+                error = std::string("chown failed: ") + std::strerror(errno);
+            }
+        }
+        if (error.empty() && chmod(endpoint.c_str(), static_cast<mode_t>(options.mode & 0777)) != 0) {
+            error = std::string("chmod failed: ") + std::strerror(errno);
+        }
+        if (error.empty() && listen(listener->fd_, 16) != 0) error = std::strerror(errno);
+        if (!error.empty()) {
+            // Destructor đóng fd và gỡ file socket.
+            throw std::runtime_error("Cannot listen on " + endpoint + ": " + error);
+        }
+        return listener;
+    }
+
+    std::unique_ptr<LocalConnection> LocalListener::Accept() {
+        while (!stopped_) {
+            int fd = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) return std::make_unique<LocalConnection>(fd);
+            if (errno != EINTR && errno != ECONNABORTED) break;
+        }
+        return nullptr;
+    }
+
+    void LocalListener::Shutdown() {
+        stopped_ = true;
+        // shutdown() an toàn trong signal handler và đánh thức accept() đang chờ.
+        shutdown(fd_, SHUT_RDWR);
+    }
+#endif
+
+}  // namespace nfcsigner
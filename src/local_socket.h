@@ -0,0 +1,100 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_LOCAL_SOCKET_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_LOCAL_SOCKET_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace nfcsigner {
+
+    // Đường kết nối mặc định của nfcsignerd: \\.\pipe\nfcsigner trên Windows,
+    // $XDG_RUNTIME_DIR/nfcsigner.sock (hoặc /tmp/nfcsigner-<uid>.sock) trên Linux.
+    std::string DefaultDaemonEndpoint();
+
+    // Quyền của file socket trên Linux (bỏ qua trên Windows). Mặc định chỉ
+    // người dùng hiện tại; đặt [group] cùng [mode] = 0660 để mở cho một nhóm.
+    struct LocalListenerOptions {
+        unsigned mode = 0600;
+        std::string group;
+    };
+
+    // Một kết nối cục bộ (Unix domain socket hoặc named pipe) trao đổi frame
+    // có tiền tố độ dài (daemon_protocol.h).
+    class LocalConnection {
+    public:
+#ifdef _WIN32
+        using Handle = HANDLE;
+#else
+        using Handle = int;
+#endif
+
+        explicit LocalConnection(Handle handle) : handle_(handle) {}
+        ~LocalConnection();
+
+        LocalConnection(const LocalConnection&) = delete;
+        LocalConnection& operator=(const LocalConnection&) = delete;
+
+        // Kết nối tới [endpoint]. Ném std::runtime_error nếu dịch vụ không chạy.
+        static std::unique_ptr<LocalConnection> Connect(const std::string& endpoint);
+
+        // Trả về false khi phía bên kia đóng kết nối giữa hai frame. Ném
+        // std::runtime_error nếu frame bị cắt hoặc vượt kDaemonMaxFrameSize.
+        bool ReadFrame(std::vector<uint8_t>& body);
+        void WriteFrame(const std::vector<uint8_t>& body);
+
+        // Đóng kết nối từ luồng khác: ReadFrame đang chờ trả về false, lần
+        // ghi sau ném lỗi.
+        void Shutdown();
+
+    private:
+        bool ReadExact(uint8_t* data, size_t size);
+        void WriteExact(const uint8_t* data, size_t size);
+
+        Handle handle_;
+        std::atomic<bool> shutdown_{ false };
+    };
+
+    // Điểm nghe của dịch vụ. Trên Linux quyền socket theo LocalListenerOptions
+    // (mặc định 0600); trên Windows pipe từ chối client từ máy khác.
+    class LocalListener {
+    public:
+        ~LocalListener();
+
+        LocalListener(const LocalListener&) = delete;
+        LocalListener& operator=(const LocalListener&) = delete;
+
+        // Ném std::runtime_error nếu [endpoint] đang được dịch vụ khác dùng.
+        static std::unique_ptr<LocalListener> Listen(const std::string& endpoint,
+                                                     const LocalListenerOptions& options = LocalListenerOptions());
+
+        // Chờ client tiếp theo. Trả về nullptr sau Shutdown().
+        std::unique_ptr<LocalConnection> Accept();
+
+        // Dừng nhận client; gọi được từ signal handler (Linux) hoặc luồng khác.
+        void Shutdown();
+
+    private:
+        explicit LocalListener(std::string endpoint) : endpoint_(std::move(endpoint)) {}
+
+        std::string endpoint_;
+#ifdef _WIN32
+        HANDLE stop_event_ = NULL;
+        HANDLE pending_pipe_ = INVALID_HANDLE_VALUE;
+#else
+        int fd_ = -1;
+#endif
+        std::atomic<bool> stopped_{ false };
+    };
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_LOCAL_SOCKET_H_
@@ -0,0 +1,228 @@
+#include "memory_accounting.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace nfcsigner {
+
+    namespace {
+
+        bool ReadEnabledFromEnvironment() {
+            const char* value = std::getenv("NFCSIGNER_MEMORY_TRACKING");
+            return value && std::strcmp(value, "1") == 0;
+        }
+
+        std::atomic<bool> tracking_enabled{ ReadEnabledFromEnvironment() };
+        std::atomic<bool> hooks_installed{ false };
+        std::atomic<uint64_t> hooked_allocations{ 0 };
+
+        // Con trỏ thuần để hook cấp phát đọc được mà không khởi tạo TLS.
+        thread_local MemoryTracker* current_tracker = nullptr;
+        thread_local MemoryPhase* current_phase = nullptr;
+
+        void MergePhase(PhaseMemory& into, const PhaseMemory& phase) {
+            into.allocations += phase.allocations;
+            into.allocatedBytes += phase.allocatedBytes;
+            into.freedBytes += phase.freedBytes;
+            into.peakLiveBytes = std::max(into.peakLiveBytes, phase.peakLiveBytes);
+            into.rssAfterBytes = phase.rssAfterBytes;
+        }
+
+        void MaxPhase(PhaseMemory& into, const PhaseMemory& phase) {
+            into.allocations = std::max(into.allocations, phase.allocations);
+            into.allocatedBytes = std::max(into.allocatedBytes, phase.allocatedBytes);
+            into.freedBytes = std::max(into.freedBytes, phase.freedBytes);
+            into.peakLiveBytes = std::max(into.peakLiveBytes, phase.peakLiveBytes);
+            into.rssBeforeBytes = std::max(into.rssBeforeBytes, phase.rssBeforeBytes);
+            into.rssAfterBytes = std::max(into.rssAfterBytes, phase.rssAfterBytes);
+        }
+
+    }  // namespace
+
+    void SetMemoryTrackingEnabled(bool enabled) {
+        tracking_enabled.store(enabled);
+    }
+
+    bool IsMemoryTrackingEnabled() {
+        return tracking_enabled.load(std::memory_order_relaxed);
+    }
+
+    void SetAllocationHooksInstalled() {
+        hooks_installed.store(true);
+    }
+
+    bool HasAllocationHooks() {
+        return hooks_installed.load();
+    }
+
+    uint64_t GetHookedAllocationCount() {
+        return hooked_allocations.load(std::memory_order_relaxed);
+    }
+
+    // Đọc thẳng từ hệ điều hành, không cấp phát: được gọi ở ranh giới pha.
+    int64_t GetCurrentRssBytes() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+        return static_cast<int64_t>(counters.WorkingSetSize);
+#else
+        int fd = open("/proc/self/statm", O_RDONLY);
+        if (fd < 0) return -1;
+        char buffer[128];
+        ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+        if (length <= 0) return -1;
+        buffer[length] = '\0';
+        // "size resident shared ...", tính bằng trang.
+        char* end = nullptr;
+        std::strtoll(buffer, &end, 10);
+        long long residentPages = std::strtoll(end, nullptr, 10);
+        return static_cast<int64_t>(residentPages) * sysconf(_SC_PAGESIZE);
+#endif
+    }
+
+    int64_t GetPeakRssBytes() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+        return static_cast<int64_t>(counters.PeakWorkingSetSize);
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+        return static_cast<int64_t>(usage.ru_maxrss) * 1024;    // KiB trên Linux
+#endif
+    }
+
+    // === MemoryTracker ===
+
+    MemoryTracker::MemoryTracker(std::string operation)
+            : active_(IsMemoryTrackingEnabled()), scope_(active_ ? this : nullptr) {
+        report_.operation = std::move(operation);
+    }
+
+    MemoryTracker::~MemoryTracker() {
+        if (!active_) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        report_.peakRssBytes = GetPeakRssBytes();
+        MemoryMetrics::Instance().Record(report_);
+    }
+
+    MemoryTracker::Scope::Scope(MemoryTracker* tracker) : previous_(current_tracker) {
+        current_tracker = tracker;
+    }
+
+    MemoryTracker::Scope::~Scope() {
+        current_tracker = previous_;
+    }
+
+    RequestMemoryReport MemoryTracker::GetReport() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return report_;
+    }
+
+    void MemoryTracker::AddPhase(const PhaseMemory& phase) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& existing : report_.phases) {
+            if (existing.name == phase.name) {
+                MergePhase(existing, phase);
+                return;
+            }
+        }
+        report_.phases.push_back(phase);
+    }
+
+    MemoryTracker* CurrentMemoryTracker() {
+        return current_tracker;
+    }
+
+    // === MemoryPhase ===
+
+    MemoryPhase::MemoryPhase(const char* name)
+            : tracker_(current_tracker && current_tracker->IsActive() ? current_tracker : nullptr), name_(name) {
+        if (!tracker_) return;
+        rss_before_bytes_ = GetCurrentRssBytes();
+        previous_ = current_phase;
+        current_phase = this;
+    }
+
+    MemoryPhase::~MemoryPhase() {
+        if (!tracker_) return;
+        // Không để phần ghi báo cáo bị tính vào pha ngoài.
+        current_phase = nullptr;
+        try {
+            PhaseMemory phase;
+            phase.name = name_;
+            phase.allocations = allocations_;
+            phase.allocatedBytes = allocated_bytes_;
+            phase.freedBytes = freed_bytes_;
+            phase.peakLiveBytes = peak_live_bytes_;
+            phase.rssBeforeBytes = rss_before_bytes_;
+            phase.rssAfterBytes = GetCurrentRssBytes();
+            tracker_->AddPhase(phase);
+        } catch (...) {
+            // Mất số liệu của pha, không ảnh hưởng request.
+        }
+        current_phase = previous_;
+    }
+
+    void RecordAllocation(size_t bytes) {
+        hooked_allocations.fetch_add(1, std::memory_order_relaxed);
+        MemoryPhase* phase = current_phase;
+        if (!phase || !IsMemoryTrackingEnabled()) return;
+        phase->allocations_++;
+        phase->allocated_bytes_ += bytes;
+        phase->live_bytes_ += static_cast<int64_t>(bytes);
+        phase->peak_live_bytes_ = std::max(phase->peak_live_bytes_, phase->live_bytes_);
+    }
+
+    void RecordDeallocation(size_t bytes) {
+        MemoryPhase* phase = current_phase;
+        if (!phase || !IsMemoryTrackingEnabled()) return;
+        phase->freed_bytes_ += bytes;
+        phase->live_bytes_ -= static_cast<int64_t>(bytes);
+    }
+
+    // === MemoryMetrics ===
+
+    MemoryMetrics& MemoryMetrics::Instance() {
+        static MemoryMetrics instance;
+        return instance;
+    }
+
+    void MemoryMetrics::Record(const RequestMemoryReport& report) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_ = report;
+        ++count_;
+        for (const auto& phase : report.phases) {
+            auto inserted = max_by_phase_.emplace(phase.name, phase);
+            if (!inserted.second) MaxPhase(inserted.first->second, phase);
+        }
+    }
+
+    RequestMemoryReport MemoryMetrics::GetLast() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_;
+    }
+
+    std::map<std::string, PhaseMemory> MemoryMetrics::GetMaxByPhase() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return max_by_phase_;
+    }
+
+    size_t MemoryMetrics::GetCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+}  // namespace nfcsigner
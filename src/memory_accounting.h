@@ -0,0 +1,143 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_MEMORY_ACCOUNTING_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_MEMORY_ACCOUNTING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace nfcsigner {
+
+    // Bộ nhớ của một pha trong request. Số cấp phát chỉ có khi build với hook
+    // cấp phát (NFCSIGNER_ALLOCATION_HOOKS) và chỉ tính phần thread đang chạy
+    // pha, trong module của plugin (cấp phát bên trong thư viện PoDoFo không
+    // được đếm); pha lồng nhau không cộng vào pha ngoài. RSS đo cho cả tiến
+    // trình (gồm PoDoFo và các thread khác) ở đầu và cuối pha.
+    struct PhaseMemory {
+        std::string name;
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+        uint64_t freedBytes = 0;
+        int64_t peakLiveBytes = 0;    // đỉnh (cấp phát − giải phóng) trong pha
+        int64_t rssBeforeBytes = 0;
+        int64_t rssAfterBytes = 0;
+    };
+
+    struct RequestMemoryReport {
+        std::string operation;
+        std::vector<PhaseMemory> phases;    // theo thứ tự kết thúc; pha trùng tên được gộp
+        int64_t peakRssBytes = 0;           // đỉnh RSS của tiến trình lúc request xong
+    };
+
+    // Bật/tắt theo dõi lúc chạy. Mặc định tắt, trừ khi NFCSIGNER_MEMORY_TRACKING=1.
+    void SetMemoryTrackingEnabled(bool enabled);
+    bool IsMemoryTrackingEnabled();
+
+    // Module có thay operator new/delete để đếm cấp phát hay không.
+    bool HasAllocationHooks();
+
+    // RSS hiện tại và đỉnh RSS của tiến trình, -1 nếu không đọc được.
+    int64_t GetCurrentRssBytes();
+    int64_t GetPeakRssBytes();
+
+    // Theo dõi bộ nhớ của một request (signPdf...). Không làm gì khi tắt theo
+    // dõi. Tạo tracker gắn nó vào thread hiện tại; nhánh chạy trên thread
+    // khác dùng Scope. Khi hủy, báo cáo được ghi vào MemoryMetrics.
+    class MemoryTracker {
+    public:
+        explicit MemoryTracker(std::string operation);
+        ~MemoryTracker();
+
+        MemoryTracker(const MemoryTracker&) = delete;
+        MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+        // Gắn [tracker] (có thể nullptr) vào thread hiện tại cho tới khi Scope bị hủy.
+        class Scope {
+        public:
+            explicit Scope(MemoryTracker* tracker);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            MemoryTracker* previous_;
+        };
+
+        bool IsActive() const { return active_; }
+        RequestMemoryReport GetReport() const;
+
+    private:
+        friend class MemoryPhase;
+
+        void AddPhase(const PhaseMemory& phase);
+
+        bool active_;
+        mutable std::mutex mutex_;
+        RequestMemoryReport report_;
+        Scope scope_;
+    };
+
+    // Tracker của request đang chạy trên thread này, nullptr nếu không có.
+    MemoryTracker* CurrentMemoryTracker();
+
+    // Một pha của request trên thread hiện tại ("parse", "sign"...). Không
+    // làm gì nếu thread không có tracker đang theo dõi.
+    class MemoryPhase {
+    public:
+        explicit MemoryPhase(const char* name);
+        ~MemoryPhase();
+
+        MemoryPhase(const MemoryPhase&) = delete;
+        MemoryPhase& operator=(const MemoryPhase&) = delete;
+
+    private:
+        friend void RecordAllocation(size_t bytes);
+        friend void RecordDeallocation(size_t bytes);
+
+        MemoryTracker* tracker_;
+        MemoryPhase* previous_ = nullptr;
+        const char* name_;
+        uint64_t allocations_ = 0;
+        uint64_t allocated_bytes_ = 0;
+        uint64_t freed_bytes_ = 0;
+        int64_t live_bytes_ = 0;
+        int64_t peak_live_bytes_ = 0;
+        int64_t rss_before_bytes_ = 0;
+    };
+
+    // Gọi từ operator new/delete đã thay thế (allocation_hooks.cpp, benchmark)
+    // với kích thước khối thật sau khi cấp phát và trước khi giải phóng.
+    // Không được cấp phát.
+    void RecordAllocation(size_t bytes);
+    void RecordDeallocation(size_t bytes);
+    // Nơi thay operator new/delete gọi một lần lúc khởi động.
+    void SetAllocationHooksInstalled();
+    // Tổng số lần cấp phát qua hook của mọi thread, kể cả khi tắt theo dõi.
+    uint64_t GetHookedAllocationCount();
+
+    // Báo cáo của request gần nhất và mức cao nhất của từng pha qua mọi request.
+    class MemoryMetrics {
+    public:
+        static MemoryMetrics& Instance();
+
+        void Record(const RequestMemoryReport& report);
+
+        RequestMemoryReport GetLast() const;
+        std::map<std::string, PhaseMemory> GetMaxByPhase() const;
+        size_t GetCount() const;
+
+    private:
+        MemoryMetrics() = default;
+
+        mutable std::mutex mutex_;
+        RequestMemoryReport last_;
+        std::map<std::string, PhaseMemory> max_by_phase_;
+        size_t count_ = 0;
+    };
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_MEMORY_ACCOUNTING_H_
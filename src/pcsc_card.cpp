@@ -0,0 +1,561 @@
+#include "pcsc_card.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace nfcsigner {
+
+    namespace {
+
+        // Chờ SCardBeginTransaction lâu hơn mức này: thẻ đang bị tiến trình khác giữ.
+        constexpr int64_t kContendedWaitUs = 1000;
+
+        std::mutex transaction_metrics_mutex;
+        CardTransactionMetrics transaction_metrics;
+
+        // Kết nối dùng chung của WithCardConnection; chỉ truy cập khi đang
+        // giữ Ticket của CardScheduler.
+        SCARDCONTEXT shared_context = 0;
+        SCARDHANDLE shared_card = 0;
+
+        int64_t MicrosecondsSince(std::chrono::steady_clock::time_point start) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        std::mutex recovery_mutex;
+        CardRecoveryPolicy recovery_policy;
+        CardRecoveryMetrics recovery_metrics;
+
+        // Trạng thái thẻ đã thiết lập trong transaction hiện tại của một kết
+        // nối: đủ để dựng lại sau khi thẻ bị reset.
+        struct LinkState {
+            std::vector<uint8_t> selectApplet;
+            std::vector<uint8_t> selectData;    // SELECT DATA (DO đang chọn, vd. certificate)
+            std::vector<uint8_t> verify;        // VERIFY đã thành công, chứa PIN
+        };
+
+        // Chỉ kết nối đang trong CardTransaction mới có trạng thái (và được phục hồi).
+        std::map<SCARDHANDLE, LinkState> links;
+
+        void Wipe(std::vector<uint8_t>& data) {
+            std::fill(data.begin(), data.end(), 0);
+            data.clear();
+        }
+
+        void BeginLink(SCARDHANDLE hCard) {
+            std::lock_guard<std::mutex> lock(recovery_mutex);
+            Wipe(links[hCard].verify);
+            links[hCard] = LinkState();
+        }
+
+        void ClearLinkState(SCARDHANDLE hCard) {
+            std::lock_guard<std::mutex> lock(recovery_mutex);
+            auto it = links.find(hCard);
+            if (it == links.end()) return;
+            Wipe(it->second.verify);
+            it->second = LinkState();
+        }
+
+        void ForgetLink(SCARDHANDLE hCard) {
+            std::lock_guard<std::mutex> lock(recovery_mutex);
+            auto it = links.find(hCard);
+            if (it == links.end()) return;
+            Wipe(it->second.verify);
+            links.erase(it);
+        }
+
+        bool LinkHasPin(SCARDHANDLE hCard) {
+            std::lock_guard<std::mutex> lock(recovery_mutex);
+            auto it = links.find(hCard);
+            return it != links.end() && !it->second.verify.empty();
+        }
+
+        bool IsSuccess(const std::vector<uint8_t>& response) {
+            return response.size() >= 2 && response[response.size() - 2] == 0x90 && response.back() == 0x00;
+        }
+
+        bool IsSelectApplet(const std::vector<uint8_t>& command) {
+            return command.size() >= 4 && command[1] == 0xA4 && command[2] == 0x04;
+        }
+
+        bool IsSelectData(const std::vector<uint8_t>& command) {
+            return command.size() >= 4 && command[1] == 0xA5;
+        }
+
+        bool IsVerify(const std::vector<uint8_t>& command) {
+            return command.size() > 5 && command[1] == 0x20;
+        }
+
+        // Cập nhật trạng thái của kết nối sau một APDU thành công.
+        void RememberLinkState(SCARDHANDLE hCard, const std::vector<uint8_t>& command,
+                               const std::vector<uint8_t>& response) {
+            if (!IsSelectApplet(command) && !IsSelectData(command) && !IsVerify(command)) return;
+            std::lock_guard<std::mutex> lock(recovery_mutex);
+            auto it = links.find(hCard);
+            if (it == links.end()) return;
+            LinkState& state = it->second;
+            if (IsSelectApplet(command)) {
+                // Applet mới: DO đã chọn và trạng thái PIN không còn.
+                Wipe(state.verify);
+                state.selectData.clear();
+                if (IsSuccess(response)) state.selectApplet = command;
+            } else if (IsSelectData(command)) {
+                if (IsSuccess(response)) state.selectData = command;
+            } else {
+                Wipe(state.verify);
+                if (IsSuccess(response)) state.verify = command;
+            }
+        }
+
+        // Lệnh gửi lại được sau khi không biết thẻ đã nhận hay chưa.
+        bool IsRetriable(SCARDHANDLE hCard, const std::vector<uint8_t>& command) {
+            if (command.size() < 4) return false;
+            // Command chaining: phần trước của chuỗi đã mất cùng trạng thái thẻ.
+            if (command[0] & 0x10) return false;
+            switch (command[1]) {
+                case 0x24:  // CHANGE REFERENCE DATA
+                case 0x2C:  // RESET RETRY COUNTER
+                case 0xDA:  // PUT DATA
+                case 0xDB:
+                case 0xE6:  // TERMINATE DF
+                case 0x44:  // ACTIVATE FILE
+                    return false;
+                case 0x47:  // GENERATE ASYMMETRIC KEY PAIR: chỉ đọc khóa công khai (P1 = 81)
+                    return command[2] == 0x81;
+                default:
+                    break;
+            }
+            std::lock_guard<std::mutex> lock(recovery_mutex);
+            auto it = links.find(hCard);
+            if (it == links.end()) return false;
+            // PIN sai mà gửi lại thì mất thêm một lần thử: chỉ gửi lại PIN đã đúng.
+            if (IsVerify(command)) return command == it->second.verify;
+            return true;
+        }
+
+        bool IsRecoverable(PcscErrorKind kind) {
+            return kind == PcscErrorKind::CardReset || kind == PcscErrorKind::CardRemoved ||
+                   kind == PcscErrorKind::Transient;
+        }
+
+        void RecordRecovery(bool recovered, int64_t elapsedUs) {
+            std::lock_guard<std::mutex> lock(recovery_mutex);
+            if (recovered) {
+                recovery_metrics.recovered++;
+            } else {
+                recovery_metrics.failed++;
+            }
+            recovery_metrics.lastRecoveryUs = elapsedUs;
+            recovery_metrics.maxRecoveryUs = std::max(recovery_metrics.maxRecoveryUs, elapsedUs);
+            recovery_metrics.totalRecoveryUs += elapsedUs;
+        }
+
+    }  // namespace
+
+    PcscErrorKind ClassifyPcscError(LONG code) {
+        switch (code) {
+            case SCARD_W_RESET_CARD:
+                return PcscErrorKind::CardReset;
+            case SCARD_W_REMOVED_CARD:
+            case SCARD_E_NO_SMARTCARD:
+                return PcscErrorKind::CardRemoved;
+            case SCARD_E_COMM_DATA_LOST:
+            case SCARD_F_COMM_ERROR:
+            case SCARD_E_NOT_TRANSACTED:
+            case SCARD_W_UNRESPONSIVE_CARD:
+                return PcscErrorKind::Transient;
+            case SCARD_E_READER_UNAVAILABLE:
+            case SCARD_E_UNKNOWN_READER:
+            case SCARD_E_NO_SERVICE:
+            case SCARD_E_SERVICE_STOPPED:
+            case SCARD_E_INVALID_HANDLE:
+                return PcscErrorKind::ConnectionLost;
+            default:
+                return PcscErrorKind::Fatal;
+        }
+    }
+
+    PcscError::PcscError(const std::string& message, LONG code)
+            : std::runtime_error(message), code_(code), kind_(ClassifyPcscError(code)) {}
+
+    void SetCardRecoveryPolicy(const CardRecoveryPolicy& policy) {
+        std::lock_guard<std::mutex> lock(recovery_mutex);
+        recovery_policy = policy;
+    }
+
+    CardRecoveryPolicy GetCardRecoveryPolicy() {
+        std::lock_guard<std::mutex> lock(recovery_mutex);
+        return recovery_policy;
+    }
+
+    CardRecoveryMetrics GetCardRecoveryMetrics() {
+        std::lock_guard<std::mutex> lock(recovery_mutex);
+        return recovery_metrics;
+    }
+
+    namespace {
+
+        // 256 byte dữ liệu + 2 byte SW.
+        constexpr DWORD kMaxResponseLength = 260;
+
+        // Một lần trao đổi APDU (kèm GET RESPONSE), không phục hồi. Phản hồi
+        // nhận vào buffer trên stack; chỉ vector kết quả được cấp phát.
+        std::vector<uint8_t> TransmitExchange(SCARDHANDLE hCard, const std::vector<uint8_t>& command) {
+            uint8_t response_buffer[kMaxResponseLength];
+            DWORD response_len = kMaxResponseLength;
+
+            // Giống SCARD_PCI_T1 của Windows; pcsc-lite cần khai báo tường minh.
+            SCARD_IO_REQUEST pioSendPci;
+            pioSendPci.dwProtocol = SCARD_PROTOCOL_T1;
+            pioSendPci.cbPciLength = sizeof(SCARD_IO_REQUEST);
+
+            // Điểm dừng của request bị hủy: giữa các APDU.
+            ThrowIfCancelled();
+            LONG lReturn = SCardTransmit(hCard, &pioSendPci, command.data(),
+                                         (DWORD)command.size(), NULL,
+                                         response_buffer, &response_len);
+            if (lReturn != SCARD_S_SUCCESS) {
+                throw PcscError("SCardTransmit error: " + std::to_string(lReturn), lReturn);
+            }
+
+            if (response_len < 2 || response_buffer[response_len - 2] != 0x61) {
+                return std::vector<uint8_t>(response_buffer, response_buffer + response_len);
+            }
+
+            std::vector<uint8_t> full_response_data;
+            full_response_data.reserve(2 * kMaxResponseLength);
+            full_response_data.insert(full_response_data.end(), response_buffer, response_buffer + response_len - 2);
+            while (response_buffer[response_len - 2] == 0x61) {
+                uint8_t get_response_cmd[] = { 0x00, 0xC0, 0x00, 0x00, response_buffer[response_len - 1] };
+
+                response_len = kMaxResponseLength;
+                ThrowIfCancelled();
+                lReturn = SCardTransmit(hCard, &pioSendPci, get_response_cmd,
+                                        (DWORD)sizeof(get_response_cmd), NULL,
+                                        response_buffer, &response_len);
+                if (lReturn != SCARD_S_SUCCESS) {
+                    throw PcscError("GET RESPONSE transmit error: " + std::to_string(lReturn), lReturn);
+                }
+                if (response_len < 2) throw PcscError("GET RESPONSE returned no status word.", SCARD_E_COMM_DATA_LOST);
+                full_response_data.insert(full_response_data.end(), response_buffer, response_buffer + response_len - 2);
+            }
+            full_response_data.push_back(response_buffer[response_len - 2]);
+            full_response_data.push_back(response_buffer[response_len - 1]);
+            return full_response_data;
+        }
+
+        // Dựng lại kết nối sau lỗi: SCardReconnect, mở lại transaction, gửi lại
+        // SELECT và VERIFY đã thành công trước đó.
+        void RestoreLink(SCARDHANDLE hCard, bool cardWasReset) {
+            LinkState state;
+            {
+                std::lock_guard<std::mutex> lock(recovery_mutex);
+                auto it = links.find(hCard);
+                if (it == links.end()) throw std::runtime_error("Card connection is no longer in a transaction.");
+                state = it->second;
+            }
+            CardRecoveryPolicy policy = GetCardRecoveryPolicy();
+            struct WipeOnExit {
+                std::vector<uint8_t>& pin;
+                ~WipeOnExit() { Wipe(pin); }
+            } wipePin{ state.verify };
+
+            ReconnectCard(hCard);
+            // Transaction cũ có thể đã mất cùng thẻ; kết thúc (nếu còn) rồi mở lại.
+            SCardEndTransaction(hCard, SCARD_LEAVE_CARD);
+            LONG lReturn = SCardBeginTransaction(hCard);
+            if (lReturn != SCARD_S_SUCCESS) {
+                throw PcscError("SCardBeginTransaction failed: " + std::to_string(lReturn), lReturn);
+            }
+
+            bool replayPin = !state.verify.empty();
+            if (replayPin && !policy.allowPinReplay) {
+                // Lỗi truyền thường không làm mất trạng thái: thử lại nguyên trạng.
+                if (!cardWasReset) return;
+                throw std::runtime_error("Card was reset after VERIFY PIN and PIN replay is disabled.");
+            }
+
+            if (!state.selectApplet.empty() && !IsSuccess(TransmitExchange(hCard, state.selectApplet))) {
+                throw std::runtime_error("Select Applet failed after reconnect.");
+            }
+            if (replayPin && !IsSuccess(TransmitExchange(hCard, state.verify))) {
+                ForgetLink(hCard);
+                throw std::runtime_error("Verify PIN failed after reconnect.");
+            }
+            if (!state.selectData.empty() && !IsSuccess(TransmitExchange(hCard, state.selectData))) {
+                throw std::runtime_error("Select data object failed after reconnect.");
+            }
+        }
+
+    }  // namespace
+
+    std::vector<uint8_t> TransmitAndGetResponse(SCARDHANDLE hCard, const std::vector<uint8_t>& command) {
+        bool cardMayHaveChanged = false;
+        bool cardWasReset = false;
+        try {
+            std::vector<uint8_t> response = TransmitExchange(hCard, command);
+            RememberLinkState(hCard, command, response);
+            return response;
+        } catch (const PcscError& e) {
+            CardRecoveryPolicy policy = GetCardRecoveryPolicy();
+            if (policy.maxAttempts <= 0 || !IsRecoverable(e.Kind()) || !IsRetriable(hCard, command)) throw;
+            cardMayHaveChanged = e.Kind() == PcscErrorKind::CardRemoved;
+            cardWasReset = e.Kind() != PcscErrorKind::Transient;
+            std::lock_guard<std::mutex> lock(recovery_mutex);
+            recovery_metrics.errors++;
+        }
+
+        auto recoveryStart = std::chrono::steady_clock::now();
+        CardRecoveryPolicy policy = GetCardRecoveryPolicy();
+        int backoffMs = std::max(0, policy.initialBackoffMs);
+        for (int attempt = 1;; ++attempt) {
+            // Thẻ cắm lại có thể là thẻ khác: không gửi PIN cho nó. Lớp trên
+            // (PcscSigningCard) đối chiếu certificate trước khi xác thực lại.
+            if (cardMayHaveChanged && LinkHasPin(hCard)) {
+                RecordRecovery(false, MicrosecondsSince(recoveryStart));
+                throw PcscError("Card was removed after VERIFY PIN; not re-sending the PIN to a possibly different card.",
+                                SCARD_W_REMOVED_CARD);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(backoffMs));
+            backoffMs *= 2;
+            try {
+                ThrowIfCancelled();
+                RestoreLink(hCard, cardWasReset);
+                std::vector<uint8_t> response = TransmitExchange(hCard, command);
+                RememberLinkState(hCard, command, response);
+                RecordRecovery(true, MicrosecondsSince(recoveryStart));
+                return response;
+            } catch (const PcscError& e) {
+                cardMayHaveChanged = cardMayHaveChanged || e.Kind() == PcscErrorKind::CardRemoved;
+                cardWasReset = cardWasReset || e.Kind() != PcscErrorKind::Transient;
+                if (attempt >= policy.maxAttempts || !IsRecoverable(e.Kind())) {
+                    RecordRecovery(false, MicrosecondsSince(recoveryStart));
+                    throw;
+                }
+            } catch (...) {
+                RecordRecovery(false, MicrosecondsSince(recoveryStart));
+                throw;
+            }
+        }
+    }
+
+#ifdef _WIN32
+    void ConnectFirstReader(SCARDCONTEXT& hContext, SCARDHANDLE& hCard) {
+        LONG lReturn = SCardEstablishContext(SCARD_SCOPE_USER, NULL, NULL, &hContext);
+        if (lReturn != SCARD_S_SUCCESS) throw std::runtime_error("SCardEstablishContext failed.");
+
+        DWORD dwReaders = SCARD_AUTOALLOCATE;
+        LPTSTR mszReaders = NULL;
+        lReturn = SCardListReaders(hContext, NULL, (LPTSTR)&mszReaders, &dwReaders);
+        if (lReturn != SCARD_S_SUCCESS || mszReaders == NULL || mszReaders[0] == '\0') {
+            if (mszReaders) SCardFreeMemory(hContext, mszReaders);
+            throw std::runtime_error("No card reader found.");
+        }
+
+        DWORD dwActiveProtocol = 0;
+        lReturn = SCardConnect(hContext, mszReaders, SCARD_SHARE_SHARED, SCARD_PROTOCOL_T0 | SCARD_PROTOCOL_T1,
+                               &hCard, &dwActiveProtocol);
+        SCardFreeMemory(hContext, mszReaders);
+        if (lReturn != SCARD_S_SUCCESS) throw std::runtime_error("SCardConnect failed. Is a card inserted?");
+    }
+#else
+    void ConnectFirstReader(SCARDCONTEXT& hContext, SCARDHANDLE& hCard) {
+        LONG lReturn = SCardEstablishContext(SCARD_SCOPE_USER, NULL, NULL, &hContext);
+        if (lReturn != SCARD_S_SUCCESS) {
+            throw std::runtime_error("SCardEstablishContext failed: " + std::to_string(lReturn));
+        }
+
+        DWORD dwReaders = 0;
+        lReturn = SCardListReaders(hContext, NULL, NULL, &dwReaders);
+        if (lReturn != SCARD_S_SUCCESS || dwReaders == 0) {
+            throw std::runtime_error("No card readers found or SCardListReaders failed");
+        }
+
+        std::vector<char> readersBuffer(dwReaders);
+        lReturn = SCardListReaders(hContext, NULL, readersBuffer.data(), &dwReaders);
+        if (lReturn != SCARD_S_SUCCESS) {
+            throw std::runtime_error("SCardListReaders failed to get reader names");
+        }
+
+        // Lấy reader đầu tiên
+        std::string readerName = readersBuffer.data();
+        if (readerName.empty()) {
+            throw std::runtime_error("No valid reader found");
+        }
+
+        DWORD dwActiveProtocol = 0;
+        lReturn = SCardConnect(hContext, readerName.c_str(), SCARD_SHARE_SHARED,
+                               SCARD_PROTOCOL_T0 | SCARD_PROTOCOL_T1, &hCard, &dwActiveProtocol);
+        if (lReturn != SCARD_S_SUCCESS) {
+            throw std::runtime_error("SCardConnect failed. Is a card inserted? Error: " + std::to_string(lReturn));
+        }
+    }
+#endif
+
+    std::vector<std::string> ListReaderNames(SCARDCONTEXT hContext) {
+        // Tên reader là chuỗi hẹp: trên Windows dùng bản ANSI bất kể UNICODE.
+#ifdef _WIN32
+        auto listReaders = [hContext](char* buffer, DWORD* size) { return SCardListReadersA(hContext, NULL, buffer, size); };
+#else
+        auto listReaders = [hContext](char* buffer, DWORD* size) { return SCardListReaders(hContext, NULL, buffer, size); };
+#endif
+        DWORD dwReaders = 0;
+        LONG lReturn = listReaders(NULL, &dwReaders);
+        if (lReturn == SCARD_E_NO_READERS_AVAILABLE || dwReaders == 0) return {};
+        if (lReturn != SCARD_S_SUCCESS) throw std::runtime_error("SCardListReaders failed: " + std::to_string(lReturn));
+
+        std::vector<char> readersBuffer(dwReaders);
+        lReturn = listReaders(readersBuffer.data(), &dwReaders);
+        if (lReturn != SCARD_S_SUCCESS) throw std::runtime_error("SCardListReaders failed: " + std::to_string(lReturn));
+
+        // Multi-string: các tên ngăn bởi '\0', kết thúc bằng chuỗi rỗng.
+        std::vector<std::string> names;
+        for (const char* name = readersBuffer.data(); *name != '\0'; name += names.back().size() + 1) {
+            names.emplace_back(name);
+        }
+        return names;
+    }
+
+    void ConnectReader(SCARDCONTEXT hContext, const std::string& readerName, SCARDHANDLE& hCard) {
+        DWORD dwActiveProtocol = 0;
+#ifdef _WIN32
+        LONG lReturn = SCardConnectA(hContext, readerName.c_str(), SCARD_SHARE_SHARED,
+                                     SCARD_PROTOCOL_T0 | SCARD_PROTOCOL_T1, &hCard, &dwActiveProtocol);
+#else
+        LONG lReturn = SCardConnect(hContext, readerName.c_str(), SCARD_SHARE_SHARED,
+                                    SCARD_PROTOCOL_T0 | SCARD_PROTOCOL_T1, &hCard, &dwActiveProtocol);
+#endif
+        if (lReturn != SCARD_S_SUCCESS) {
+            throw std::runtime_error("SCardConnect failed on " + readerName + ". Is a card inserted? Error: " +
+                                     std::to_string(lReturn));
+        }
+    }
+
+    bool WaitForCardPresent(SCARDCONTEXT hContext, const std::string& readerName, DWORD timeoutMs) {
+#ifdef _WIN32
+        SCARD_READERSTATEA state = {};
+#else
+        SCARD_READERSTATE state = {};
+#endif
+        state.szReader = readerName.c_str();
+        state.dwCurrentState = SCARD_STATE_UNAWARE;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        for (;;) {
+            DWORD wait = timeoutMs;
+            if (timeoutMs != INFINITE) {
+                auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                wait = left.count() > 0 ? (DWORD)left.count() : 0;
+            }
+#ifdef _WIN32
+            LONG lReturn = SCardGetStatusChangeA(hContext, wait, &state, 1);
+#else
+            LONG lReturn = SCardGetStatusChange(hContext, wait, &state, 1);
+#endif
+            if (lReturn == SCARD_E_TIMEOUT || lReturn == SCARD_E_CANCELLED) return false;
+            if (lReturn != SCARD_S_SUCCESS) {
+                throw std::runtime_error("SCardGetStatusChange failed: " + std::to_string(lReturn));
+            }
+            if (state.dwEventState & SCARD_STATE_PRESENT) return true;
+            // Lần đầu (UNAWARE) chỉ lấy trạng thái hiện tại; sau đó chờ thay đổi.
+            state.dwCurrentState = state.dwEventState & ~SCARD_STATE_CHANGED;
+        }
+    }
+
+    void ReconnectCard(SCARDHANDLE hCard, DWORD initialization) {
+        DWORD dwActiveProtocol = 0;
+        LONG lReturn = SCardReconnect(hCard, SCARD_SHARE_SHARED, SCARD_PROTOCOL_T0 | SCARD_PROTOCOL_T1,
+                                      initialization, &dwActiveProtocol);
+        if (lReturn != SCARD_S_SUCCESS) {
+            throw PcscError("SCardReconnect failed. Is a card inserted? Error: " + std::to_string(lReturn), lReturn);
+        }
+        // Reset chủ ý: không dựng lại SELECT/VERIFY trước đó.
+        if (initialization != SCARD_LEAVE_CARD) ClearLinkState(hCard);
+    }
+
+    CardTransactionMetrics GetCardTransactionMetrics() {
+        std::lock_guard<std::mutex> lock(transaction_metrics_mutex);
+        return transaction_metrics;
+    }
+
+    CardTransaction::CardTransaction(SCARDHANDLE hCard) : hCard_(hCard) {
+        auto waitStart = std::chrono::steady_clock::now();
+        bool reconnected = false;
+        for (;;) {
+            LONG lReturn = SCardBeginTransaction(hCard_);
+            if (lReturn == SCARD_S_SUCCESS) break;
+            // Tiến trình khác đã reset thẻ, hoặc thẻ được rút ra cắm lại.
+            if (!reconnected && (lReturn == SCARD_W_RESET_CARD || lReturn == SCARD_W_REMOVED_CARD)) {
+                ReconnectCard(hCard_);
+                reconnected = true;
+                reinserted_ = lReturn == SCARD_W_REMOVED_CARD;
+                continue;
+            }
+            throw PcscError("SCardBeginTransaction failed: " + std::to_string(lReturn), lReturn);
+        }
+        begin_ = std::chrono::steady_clock::now();
+        active_ = true;
+        BeginLink(hCard_);
+
+        int64_t waitUs = MicrosecondsSince(waitStart);
+        std::lock_guard<std::mutex> lock(transaction_metrics_mutex);
+        transaction_metrics.transactions++;
+        if (waitUs >= kContendedWaitUs) transaction_metrics.contended++;
+        if (reconnected) transaction_metrics.resets++;
+        transaction_metrics.lastWaitUs = waitUs;
+        transaction_metrics.maxWaitUs = std::max(transaction_metrics.maxWaitUs, waitUs);
+        transaction_metrics.totalWaitUs += waitUs;
+    }
+
+    CardTransaction::~CardTransaction() {
+        if (active_) End(SCARD_LEAVE_CARD);
+    }
+
+    void CardTransaction::End(DWORD disposition) {
+        if (!active_) return;
+        active_ = false;
+        ForgetLink(hCard_);
+        // Lỗi ở đây (thẻ đã bị rút) không cần xử lý: PC/SC tự nhả khóa.
+        SCardEndTransaction(hCard_, disposition);
+
+        int64_t holdUs = MicrosecondsSince(begin_);
+        std::lock_guard<std::mutex> lock(transaction_metrics_mutex);
+        transaction_metrics.lastHoldUs = holdUs;
+        transaction_metrics.maxHoldUs = std::max(transaction_metrics.maxHoldUs, holdUs);
+        transaction_metrics.totalHoldUs += holdUs;
+    }
+
+    void WithCardConnection(const std::function<void(SCARDHANDLE)>& operation, CardPriority priority) {
+        // Chờ tới lượt dùng reader theo lớp ưu tiên; hàng đợi đầy thì từ chối ngay.
+        CardScheduler::Ticket ticket = CardScheduler::Instance().Acquire(priority);
+        if (!ticket) throw CardBusyError(priority);
+
+        try {
+            if (!shared_card) ConnectFirstReader(shared_context, shared_card);
+            // Hủy request đánh thức các lệnh PC/SC đang chờ trên context này.
+            SCARDCONTEXT hContext = shared_context;
+            CancelCallbackGuard cancelWaits(CurrentCancellation(), [hContext]() { SCardCancel(hContext); });
+            ThrowIfCancelled();
+
+            CardTransaction transaction(shared_card);
+            operation(shared_card);
+            transaction.End(SCARD_LEAVE_CARD);
+        } catch (...) {
+            DisconnectCard(shared_context, shared_card, SCARD_LEAVE_CARD);
+            throw;
+        }
+    }
+
+    void DisconnectCard(SCARDCONTEXT& hContext, SCARDHANDLE& hCard, DWORD disposition) {
+        if (hCard) ForgetLink(hCard);
+        if (hCard) SCardDisconnect(hCard, disposition);
+        if (hContext) SCardReleaseContext(hContext);
+        hCard = 0;
+        hContext = 0;
+    }
+
+}  // namespace nfcsigner
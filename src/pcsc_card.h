@@ -0,0 +1,160 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_PCSC_CARD_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_PCSC_CARD_H_
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <winscard.h>
+#else
+#include <PCSC/winscard.h>
+#include <PCSC/wintypes.h>
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "cancellation.h"
+#include "card_scheduler.h"
+
+namespace nfcsigner {
+
+    // Nhóm lỗi PC/SC theo cách phục hồi.
+    enum class PcscErrorKind {
+        CardReset,          // tiến trình khác reset thẻ: trạng thái SELECT/VERIFY đã mất
+        CardRemoved,        // thẻ được rút ra, có thể đã cắm lại - có thể là thẻ khác
+        Transient,          // lỗi truyền tạm thời (USB chập chờn): thử lại trên cùng kết nối
+        ConnectionLost,     // reader biến mất hoặc dịch vụ PC/SC khởi động lại: cần kết nối mới
+        Fatal,
+    };
+
+    PcscErrorKind ClassifyPcscError(LONG code);
+
+    // Lỗi PC/SC kèm mã lỗi. Là std::runtime_error nên mã lỗi phía Dart
+    // (PC/SC_ERROR, STD_EXCEPTION) không đổi.
+    class PcscError : public std::runtime_error {
+    public:
+        PcscError(const std::string& message, LONG code);
+
+        LONG Code() const { return code_; }
+        PcscErrorKind Kind() const { return kind_; }
+
+    private:
+        LONG code_;
+        PcscErrorKind kind_;
+    };
+
+    // Chính sách phục hồi của TransmitAndGetResponse, dùng chung cho cả tiến trình.
+    struct CardRecoveryPolicy {
+        int maxAttempts = 3;            // số lần thử lại một APDU; 0 = tắt phục hồi
+        int initialBackoffMs = 50;      // nhân đôi sau mỗi lần thử
+        bool allowPinReplay = true;     // gửi lại VERIFY đã thành công sau khi thẻ bị reset
+    };
+
+    void SetCardRecoveryPolicy(const CardRecoveryPolicy& policy);
+    CardRecoveryPolicy GetCardRecoveryPolicy();
+
+    struct CardRecoveryMetrics {
+        uint64_t errors = 0;            // lỗi PC/SC phục hồi được đã gặp
+        uint64_t recovered = 0;         // APDU thử lại thành công
+        uint64_t failed = 0;            // hết lượt thử hoặc không khôi phục được trạng thái
+        int64_t lastRecoveryUs = 0;
+        int64_t maxRecoveryUs = 0;
+        int64_t totalRecoveryUs = 0;
+    };
+
+    CardRecoveryMetrics GetCardRecoveryMetrics();
+
+    // Gửi APDU, tự gửi GET RESPONSE khi thẻ trả về SW 61xx. Trả về dữ liệu
+    // kèm SW1/SW2. Kiểm tra hủy request trước mỗi APDU.
+    //
+    // Trong một CardTransaction, lỗi thẻ bị reset, rút ra cắm lại hoặc lỗi
+    // truyền tạm thời được phục hồi tại chỗ theo CardRecoveryPolicy:
+    // SCardReconnect, giữ lại transaction, gửi lại SELECT (applet, DO) và
+    // VERIFY đã thành công trong transaction rồi thử lại APDU với backoff.
+    // Lệnh đổi trạng thái bền của thẻ (đổi PIN, PUT DATA, sinh khóa) và
+    // VERIFY chưa từng thành công không được gửi lại. Sau khi thẻ bị rút ra,
+    // PIN không được gửi lại (có thể là thẻ khác). Ném PcscError nếu không
+    // phục hồi được.
+    std::vector<uint8_t> TransmitAndGetResponse(SCARDHANDLE hCard, const std::vector<uint8_t>& command);
+
+    // Mở context PC/SC và kết nối reader đầu tiên. Ném std::runtime_error nếu
+    // lỗi; caller giải phóng các handle đã mở bằng DisconnectCard.
+    void ConnectFirstReader(SCARDCONTEXT& hContext, SCARDHANDLE& hCard);
+
+    // Tên các reader đang cắm (rỗng nếu không có reader nào).
+    std::vector<std::string> ListReaderNames(SCARDCONTEXT hContext);
+
+    // Kết nối thẻ trên reader [readerName]. Ném std::runtime_error nếu lỗi.
+    void ConnectReader(SCARDCONTEXT hContext, const std::string& readerName, SCARDHANDLE& hCard);
+
+    // Chờ tới khi reader có thẻ, tối đa [timeoutMs] (INFINITE: không giới hạn).
+    // Trả về false khi hết thời gian hoặc bị SCardCancel.
+    bool WaitForCardPresent(SCARDCONTEXT hContext, const std::string& readerName, DWORD timeoutMs);
+
+    // Thẻ bị reset hoặc rút ra cắm lại: xác nhận lại kết nối trên cùng reader.
+    // [initialization] = SCARD_RESET_CARD để xóa trạng thái đã VERIFY PIN.
+    // Ném PcscError nếu lỗi.
+    void ReconnectCard(SCARDHANDLE hCard, DWORD initialization = SCARD_LEAVE_CARD);
+
+    // Ngắt kết nối và giải phóng context (handle bằng 0 thì bỏ qua).
+    void DisconnectCard(SCARDCONTEXT& hContext, SCARDHANDLE& hCard, DWORD disposition);
+
+    // Số liệu SCardBeginTransaction của cả tiến trình: thời gian chờ tiến
+    // trình khác nhả thẻ và thời gian giữ thẻ độc quyền.
+    struct CardTransactionMetrics {
+        uint64_t transactions = 0;
+        uint64_t contended = 0;         // phải chờ tiến trình khác (>= 1 ms)
+        uint64_t resets = 0;            // kết nối lại vì thẻ bị reset hoặc cắm lại
+        int64_t lastWaitUs = 0;
+        int64_t maxWaitUs = 0;
+        int64_t totalWaitUs = 0;
+        int64_t lastHoldUs = 0;
+        int64_t maxHoldUs = 0;
+        int64_t totalHoldUs = 0;
+    };
+
+    CardTransactionMetrics GetCardTransactionMetrics();
+
+    // Giữ thẻ độc quyền trong một thao tác logic trên kết nối SCARD_SHARE_SHARED:
+    // tiến trình khác không chen APDU vào giữa VERIFY và COMPUTE SIGNATURE nhưng
+    // vẫn dùng được thẻ giữa các thao tác. Thẻ đã bị reset (hoặc rút ra cắm
+    // lại) thì kết nối lại rồi thử lại một lần; trạng thái SELECT/VERIFY khi
+    // đó đã mất. Ném std::runtime_error nếu không giữ được thẻ.
+    class CardTransaction {
+    public:
+        explicit CardTransaction(SCARDHANDLE hCard);
+        // Chưa End thì kết thúc với SCARD_LEAVE_CARD.
+        ~CardTransaction();
+
+        CardTransaction(const CardTransaction&) = delete;
+        CardTransaction& operator=(const CardTransaction&) = delete;
+
+        // [disposition] = SCARD_RESET_CARD để xóa trạng thái đã VERIFY PIN.
+        void End(DWORD disposition);
+
+        // Thẻ đã được rút ra cắm lại trước lượt này: có thể là thẻ khác.
+        bool CardReinserted() const { return reinserted_; }
+
+    private:
+        SCARDHANDLE hCard_;
+        bool active_ = false;
+        bool reinserted_ = false;
+        std::chrono::steady_clock::time_point begin_;
+    };
+
+    // Giữ reader theo lượt của CardScheduler rồi chạy [operation] trong một
+    // CardTransaction trên kết nối dùng chung của tiến trình (mở ở lần đầu,
+    // giữ giữa các thao tác). Ném CardBusyError nếu hàng đợi đầy; lỗi PC/SC
+    // và lỗi của [operation] được ném lại sau khi đã ngắt kết nối - thao tác
+    // sau kết nối lại từ đầu.
+    void WithCardConnection(const std::function<void(SCARDHANDLE)>& operation, CardPriority priority);
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_PCSC_CARD_H_
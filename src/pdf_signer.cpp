@@ -0,0 +1,312 @@
+#include "pdf_signer.h"
+
+#ifdef HAVE_PODOFO
+
+#include "cancellation.h"
+#include "memory_accounting.h"
+
+#include <ctime>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+namespace nfcsigner {
+
+    void LoadFullDocument(PreparedPdf& prepared, const std::vector<uint8_t>& pdfBytes, int pageNumber,
+                          const SignatureAppearanceConfig& appearance, const std::string& fieldName,
+                          const std::string& reason, const std::string& location) {
+        // Object graph của PoDoFo là phần tốn bộ nhớ nhất với tài liệu lớn.
+        MemoryPhase phase("parse");
+        std::cout << "Loading PDF document..." << std::endl;
+        prepared.document.reset(new PoDoFo::PdfMemDocument());
+        prepared.document->LoadFromBuffer(PoDoFo::bufferview(
+                reinterpret_cast<const char*>(pdfBytes.data()), pdfBytes.size()
+        ));
+        std::cout << "PDF loaded successfully. Page count: " << prepared.document->GetPages().GetCount() << std::endl;
+
+        PoDoFo::PdfPage& page = prepared.document->GetPages().GetPageAt(pageNumber > 0 ? pageNumber - 1 : 0);
+
+        PoDoFo::Rect annot_rect = PoDoFo::Rect(appearance.x, appearance.y, appearance.width, appearance.height);
+        auto& signatureField = page.CreateField<PoDoFo::PdfSignature>(
+                fieldName, annot_rect
+        );
+        PoDoFo::PdfDate dateString = PoDoFo::PdfDate::LocalNow();
+        signatureField.SetSignatureReason(PoDoFo::PdfString(reason));
+        signatureField.SetSignatureLocation(PoDoFo::PdfString(location));
+        signatureField.SetSignerName(PoDoFo::PdfString(appearance.signerName));
+        signatureField.SetSignatureDate(dateString);
+        prepared.signatureField = &signatureField;
+    }
+
+    PreparedPdf PreparePdf(const std::vector<uint8_t>& pdfBytes, int pageNumber,
+                           const SignatureAppearanceConfig& appearance, const std::string& signDate,
+                           const std::string& reason, const std::string& location,
+                           std::promise<void>& parsed, SignPdfMetrics& metrics,
+                           std::shared_ptr<const SignatureAppearanceTemplate> appearanceTemplate) {
+        PhaseTimer timer;
+        PreparedPdf prepared;
+        bool parsedSignaled = false;
+        try {
+            try {
+                MemoryPhase parsePhase("parse");
+                prepared.lazyDocument.reset(new LazyPdfDocument(pdfBytes, pageNumber > 0 ? pageNumber : 1));
+            } catch (const LazyPdfUnsupported& e) {
+                std::cout << "Incremental signing unsupported (" << e.what() << "), loading full document." << std::endl;
+                LoadFullDocument(prepared, pdfBytes, pageNumber, appearance, "BMC-Signature", reason, location);
+            }
+            metrics.pdfParseUs = timer.ElapsedUs();
+            parsedSignaled = true;
+            parsed.set_value();
+
+            MemoryPhase preparePhase("prepare");
+            // Appearance lấy từ cache theo cấu hình người ký; chỉ dòng ngày ký được vẽ lại.
+            prepared.appearanceTemplate = appearanceTemplate ? std::move(appearanceTemplate)
+                                                             : SignatureAppearanceCache::Instance().GetOrCreate(appearance);
+            if (prepared.lazyDocument && !prepared.appearanceTemplate->BuildLazyAppearance(signDate, prepared.lazyAppearance)) {
+                std::cout << "Sign date has glyphs outside of the font subset, loading full document." << std::endl;
+                prepared.lazyDocument.reset();
+                LoadFullDocument(prepared, pdfBytes, pageNumber, appearance, "BMC-Signature", reason, location);
+            }
+            if (prepared.document) {
+                prepared.appearanceTemplate->Apply(*prepared.document, *prepared.signatureField, signDate);
+            }
+        } catch (...) {
+            if (!parsedSignaled) parsed.set_exception(std::current_exception());
+            throw;
+        }
+        metrics.pdfPrepareUs = timer.ElapsedUs();
+        return prepared;
+    }
+
+    std::vector<uint8_t> SignFullDocument(PreparedPdf& prepared, const std::vector<uint8_t>& pdfBytes,
+                                          std::shared_ptr<const CmsTemplate> cmsTemplate,
+                                          const CardSignFunction& cardSign) {
+        CardCmsSigner signer(std::move(cmsTemplate), cardSign);
+        std::vector<char> buffer;
+        {
+            MemoryPhase copyPhase("copy");
+            buffer.assign(pdfBytes.begin(), pdfBytes.end());
+        }
+        PoDoFo::VectorStreamDevice outputDevice(buffer);
+        PoDoFo::SignDocument(*prepared.document, outputDevice, signer, *prepared.signatureField);
+        MemoryPhase outputPhase("output");
+        return std::vector<uint8_t>(buffer.data(), buffer.data() + buffer.size());
+    }
+
+    std::vector<uint8_t> SignPreparedPdf(PreparedPdf& prepared, const std::vector<uint8_t>& pdfBytes,
+                                         const LazyPdfSignParams& params, const std::string& signDate,
+                                         const SignatureAppearanceConfig& appearance,
+                                         std::shared_ptr<const CmsTemplate> cmsTemplate,
+                                         const CardSignFunction& cardSign) {
+        if (prepared.lazyDocument) {
+            try {
+                auto signed_pdf_bytes = SignPdfIncremental(*prepared.lazyDocument, params, prepared.lazyAppearance,
+                                                           *cmsTemplate, cardSign);
+                std::cout << "=== Signed with incremental update ===" << std::endl;
+                return signed_pdf_bytes;
+            } catch (const LazyPdfUnsupported& e) {
+                // Chỉ xảy ra trước khi gửi COMPUTE SIGNATURE nên vẫn ký lại được.
+                std::cout << "Incremental signing unsupported (" << e.what() << "), loading full document." << std::endl;
+                prepared.lazyDocument.reset();
+                LoadFullDocument(prepared, pdfBytes, params.pageNumber, appearance, params.fieldName,
+                                 params.reason, params.location);
+                prepared.appearanceTemplate->Apply(*prepared.document, *prepared.signatureField, signDate);
+            }
+        }
+
+        return SignFullDocument(prepared, pdfBytes, std::move(cmsTemplate), cardSign);
+    }
+
+    namespace {
+
+        std::unique_ptr<PoDoFo::PdfMemDocument> LoadMemDocument(const std::vector<uint8_t>& pdfBytes) {
+            std::unique_ptr<PoDoFo::PdfMemDocument> document(new PoDoFo::PdfMemDocument());
+            document->LoadFromBuffer(PoDoFo::bufferview(
+                    reinterpret_cast<const char*>(pdfBytes.data()), pdfBytes.size()
+            ));
+            return document;
+        }
+
+        // Field chữ ký tên [fieldName] có sẵn trong tài liệu; nullptr nếu không có.
+        // Ném nếu field cùng tên không phải field chữ ký trống.
+        PoDoFo::PdfSignature* FindEmptySignatureField(PoDoFo::PdfMemDocument& document, const std::string& fieldName) {
+            for (PoDoFo::PdfField* field : document.GetFieldsIterator()) {
+                if (field->GetFullName() != fieldName) continue;
+                auto* signature = field->GetType() == PoDoFo::PdfFieldType::Signature
+                                  ? dynamic_cast<PoDoFo::PdfSignature*>(field) : nullptr;
+                if (!signature || signature->GetValueObject() != nullptr) {
+                    throw std::runtime_error("Field '" + fieldName + "' không phải field chữ ký trống.");
+                }
+                return signature;
+            }
+            return nullptr;
+        }
+
+        // Dùng lại field chữ ký trống cùng tên, không có thì tạo mới trên trang
+        // của [spec].
+        PoDoFo::PdfSignature& AcquireSignatureField(PoDoFo::PdfMemDocument& document, const PdfSignatureSpec& spec) {
+            PoDoFo::PdfSignature* field = FindEmptySignatureField(document, spec.fieldName);
+            if (!field) {
+                PoDoFo::PdfPage& page = document.GetPages().GetPageAt(spec.pageNumber > 0 ? spec.pageNumber - 1 : 0);
+                field = &page.CreateField<PoDoFo::PdfSignature>(
+                        spec.fieldName,
+                        PoDoFo::Rect(spec.appearance.x, spec.appearance.y, spec.appearance.width, spec.appearance.height));
+            }
+            field->SetSignatureReason(PoDoFo::PdfString(spec.reason));
+            field->SetSignatureLocation(PoDoFo::PdfString(spec.location));
+            field->SetSignerName(PoDoFo::PdfString(spec.appearance.signerName));
+            field->SetSignatureDate(PoDoFo::PdfDate::LocalNow());
+            return *field;
+        }
+
+        bool HasPodofoField(PoDoFo::PdfMemDocument& document, const std::string& fieldName) {
+            for (PoDoFo::PdfField* field : document.GetFieldsIterator()) {
+                if (field->GetFullName() == fieldName) return true;
+            }
+            return false;
+        }
+
+    }  // namespace
+
+    PreparedMultiPdf PrepareMultiPdf(const std::vector<uint8_t>& pdfBytes,
+                                     std::vector<PdfSignatureSpec>& specs,
+                                     std::promise<void>& parsed, SignPdfMetrics& metrics) {
+        PhaseTimer timer;
+        PreparedMultiPdf prepared;
+        bool parsedSignaled = false;
+        try {
+            // CMS của mọi chữ ký dùng certificate đọc một lần từ thẻ.
+            for (const auto& spec : specs) {
+                if (spec.keyIndex != specs.front().keyIndex) {
+                    throw std::invalid_argument("Mọi chữ ký trong signPdfMulti phải dùng cùng keyIndex.");
+                }
+            }
+            try {
+                MemoryPhase parsePhase("parse");
+                prepared.lazyDocument.reset(new LazyPdfDocument(pdfBytes, specs.front().pageNumber));
+            } catch (const LazyPdfUnsupported& e) {
+                std::cout << "Incremental signing unsupported (" << e.what() << "), loading full document." << std::endl;
+                MemoryPhase parsePhase("parse");
+                prepared.document = LoadMemDocument(pdfBytes);
+            }
+            metrics.pdfParseUs = timer.ElapsedUs();
+            parsedSignaled = true;
+            parsed.set_value();
+
+            MemoryPhase preparePhase("prepare");
+            auto hasField = [&](const std::string& name) {
+                return prepared.lazyDocument ? prepared.lazyDocument->HasField(name) : HasPodofoField(*prepared.document, name);
+            };
+            std::set<std::string> usedNames;
+            for (auto& spec : specs) {
+                if (!spec.fieldName.empty()) {
+                    // Ký vào field có sẵn: appearance theo đúng vị trí của field.
+                    LazyPdfField field;
+                    if (prepared.lazyDocument && prepared.lazyDocument->FindField(spec.fieldName, field)) {
+                        if (!field.isSignature || field.isSigned) {
+                            throw std::runtime_error("Field '" + spec.fieldName + "' không phải field chữ ký trống.");
+                        }
+                        spec.appearance.x = field.x;
+                        spec.appearance.y = field.y;
+                        spec.appearance.width = field.width;
+                        spec.appearance.height = field.height;
+                    } else if (prepared.document) {
+                        if (PoDoFo::PdfSignature* existing = FindEmptySignatureField(*prepared.document, spec.fieldName)) {
+                            if (auto* widget = existing->GetWidget()) {
+                                PoDoFo::Rect rect = widget->GetRect();
+                                spec.appearance.x = rect.X;
+                                spec.appearance.y = rect.Y;
+                                spec.appearance.width = rect.Width;
+                                spec.appearance.height = rect.Height;
+                            }
+                        }
+                    }
+                } else {
+                    spec.fieldName = "BMC-Signature";
+                    for (int n = 2; usedNames.count(spec.fieldName) || hasField(spec.fieldName); ++n) {
+                        spec.fieldName = "BMC-Signature-" + std::to_string(n);
+                    }
+                }
+                if (!usedNames.insert(spec.fieldName).second) {
+                    throw std::runtime_error("Tên field '" + spec.fieldName + "' bị trùng.");
+                }
+
+                spec.appearanceTemplate = SignatureAppearanceCache::Instance().GetOrCreate(spec.appearance);
+                if (prepared.lazyDocument && !spec.appearanceTemplate->BuildLazyAppearance(spec.signDate, spec.lazyAppearance)) {
+                    // Field đã tìm ở trên cũng có trong tài liệu PoDoFo.
+                    std::cout << "Sign date has glyphs outside of the font subset, loading full document." << std::endl;
+                    prepared.lazyDocument.reset();
+                    MemoryPhase parsePhase("parse");
+                    prepared.document = LoadMemDocument(pdfBytes);
+                }
+            }
+        } catch (...) {
+            if (!parsedSignaled) parsed.set_exception(std::current_exception());
+            throw;
+        }
+        metrics.pdfPrepareUs = timer.ElapsedUs();
+        return prepared;
+    }
+
+    std::vector<uint8_t> SignMultiPdf(PreparedMultiPdf& prepared, const std::vector<uint8_t>& pdfBytes,
+                                      const std::vector<PdfSignatureSpec>& specs,
+                                      std::shared_ptr<const CmsTemplate> cmsTemplate,
+                                      const CardSignFunction& cardSign) {
+        size_t next = 0;
+        std::vector<char> buffer;
+        if (prepared.lazyDocument) {
+            try {
+                for (; next < specs.size(); ++next) {
+                    // Giữa hai chữ ký: các revision đã ký bị bỏ cùng request.
+                    ThrowIfCancelled();
+                    const PdfSignatureSpec& spec = specs[next];
+                    LazyPdfSignParams params;
+                    params.pageNumber = spec.pageNumber > 0 ? spec.pageNumber : 1;
+                    params.x = spec.appearance.x;
+                    params.y = spec.appearance.y;
+                    params.width = spec.appearance.width;
+                    params.height = spec.appearance.height;
+                    params.fieldName = spec.fieldName;
+                    params.reason = spec.reason;
+                    params.location = spec.location;
+                    params.signerName = spec.appearance.signerName;
+                    params.signingTime = std::time(nullptr);
+                    prepared.lazyDocument->AppendSignature(params, spec.lazyAppearance, *cmsTemplate, cardSign);
+                    std::cout << "Signed '" << spec.fieldName << "' (revision " << prepared.lazyDocument->GetRevisionCount() << ")" << std::endl;
+                }
+                return prepared.lazyDocument->TakeBytes();
+            } catch (const LazyPdfUnsupported& e) {
+                // Các revision đã ký được giữ lại; phần còn lại ký bằng PoDoFo
+                // trên tài liệu gồm cả các revision đó.
+                std::cout << "Incremental signing unsupported (" << e.what() << "), loading full document." << std::endl;
+                auto current = prepared.lazyDocument->TakeBytes();
+                prepared.lazyDocument.reset();
+                MemoryPhase parsePhase("parse");
+                prepared.document = LoadMemDocument(current);
+                buffer.assign(current.begin(), current.end());
+            }
+        } else {
+            MemoryPhase copyPhase("copy");
+            buffer.assign(pdfBytes.begin(), pdfBytes.end());
+        }
+
+        // Một tài liệu PoDoFo cho mọi chữ ký còn lại: mỗi SignDocument ghi thêm
+        // một incremental update vào cuối buffer.
+        for (; next < specs.size(); ++next) {
+            ThrowIfCancelled();
+            const PdfSignatureSpec& spec = specs[next];
+            PoDoFo::PdfSignature& field = AcquireSignatureField(*prepared.document, spec);
+            spec.appearanceTemplate->Apply(*prepared.document, field, spec.signDate);
+            CardCmsSigner signer(cmsTemplate, cardSign);
+            PoDoFo::VectorStreamDevice outputDevice(buffer);
+            PoDoFo::SignDocument(*prepared.document, outputDevice, signer, field);
+            std::cout << "Signed '" << spec.fieldName << "' with PoDoFo" << std::endl;
+        }
+        MemoryPhase outputPhase("output");
+        return std::vector<uint8_t>(buffer.data(), buffer.data() + buffer.size());
+    }
+
+}  // namespace nfcsigner
+
+#endif  // HAVE_PODOFO
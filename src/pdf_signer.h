@@ -0,0 +1,97 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_PDF_SIGNER_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_PDF_SIGNER_H_
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cms_template.h"
+#include "lazy_pdf.h"
+#include "signature_appearance.h"
+#include "signing_metrics.h"
+
+#ifdef HAVE_PODOFO
+namespace nfcsigner {
+
+    // Tài liệu PDF đã chuẩn bị xong phần không cần certificate.
+    struct PreparedPdf {
+        std::shared_ptr<const SignatureAppearanceTemplate> appearanceTemplate;
+        // Đường ký từng phần
+        std::unique_ptr<LazyPdfDocument> lazyDocument;
+        LazyPdfAppearance lazyAppearance;
+        // Đường cũ: nạp toàn bộ tài liệu bằng PoDoFo. Dùng khi đường ký từng
+        // phần không xử lý được tài liệu (mã hóa, xref hỏng...).
+        std::unique_ptr<PoDoFo::PdfMemDocument> document;
+        PoDoFo::PdfSignature* signatureField = nullptr;
+    };
+
+    // Nạp toàn bộ tài liệu bằng PoDoFo và tạo field chữ ký [fieldName].
+    void LoadFullDocument(PreparedPdf& prepared, const std::vector<uint8_t>& pdfBytes, int pageNumber,
+                          const SignatureAppearanceConfig& appearance, const std::string& fieldName,
+                          const std::string& reason, const std::string& location);
+
+    // Nhánh PDF của signPdf, chạy song song với nhánh thẻ. [parsed] được báo
+    // ngay khi đọc xong cấu trúc tài liệu (hoặc mang lỗi nếu PDF hỏng) để nhánh
+    // thẻ quyết định có VERIFY PIN hay không. [appearanceTemplate] dựng sẵn
+    // (phiên ký) thì không tra cache appearance.
+    PreparedPdf PreparePdf(const std::vector<uint8_t>& pdfBytes, int pageNumber,
+                           const SignatureAppearanceConfig& appearance, const std::string& signDate,
+                           const std::string& reason, const std::string& location,
+                           std::promise<void>& parsed, SignPdfMetrics& metrics,
+                           std::shared_ptr<const SignatureAppearanceTemplate> appearanceTemplate = nullptr);
+
+    // Ký tài liệu đã nạp toàn bộ bằng PoDoFo::SignDocument.
+    std::vector<uint8_t> SignFullDocument(PreparedPdf& prepared, const std::vector<uint8_t>& pdfBytes,
+                                          std::shared_ptr<const CmsTemplate> cmsTemplate,
+                                          const CardSignFunction& cardSign);
+
+    // Ký bằng đường từng phần nếu được, không thì nạp toàn bộ tài liệu.
+    std::vector<uint8_t> SignPreparedPdf(PreparedPdf& prepared, const std::vector<uint8_t>& pdfBytes,
+                                         const LazyPdfSignParams& params, const std::string& signDate,
+                                         const SignatureAppearanceConfig& appearance,
+                                         std::shared_ptr<const CmsTemplate> cmsTemplate,
+                                         const CardSignFunction& cardSign);
+
+    // Một chữ ký trong signPdfMulti.
+    struct PdfSignatureSpec {
+        std::string fieldName;
+        int keyIndex = 0;
+        std::string reason;
+        std::string location;
+        int pageNumber = 1;
+        std::string signDate;
+        SignatureAppearanceConfig appearance;
+        // Điền ở nhánh chuẩn bị PDF
+        std::shared_ptr<const SignatureAppearanceTemplate> appearanceTemplate;
+        LazyPdfAppearance lazyAppearance;
+    };
+
+    // Tài liệu của signPdfMulti sau bước chuẩn bị: đường ký từng phần, hoặc
+    // tài liệu PoDoFo đọc một lần rồi dùng cho mọi chữ ký.
+    struct PreparedMultiPdf {
+        std::unique_ptr<LazyPdfDocument> lazyDocument;
+        std::unique_ptr<PoDoFo::PdfMemDocument> document;
+    };
+
+    // Nhánh PDF của signPdfMulti: đọc tài liệu một lần, đặt tên field, lấy vị
+    // trí của field chữ ký trống có sẵn và dựng appearance cho từng chữ ký.
+    // Mọi chữ ký phải cùng keyIndex (một certificate cho cả lô).
+    PreparedMultiPdf PrepareMultiPdf(const std::vector<uint8_t>& pdfBytes,
+                                     std::vector<PdfSignatureSpec>& specs,
+                                     std::promise<void>& parsed, SignPdfMetrics& metrics);
+
+    // Ký lần lượt [specs], mỗi chữ ký là một revision, trên tài liệu đã đọc ở
+    // PrepareMultiPdf. Field chữ ký trống cùng tên được dùng lại. Request bị
+    // hủy thì dừng giữa hai chữ ký.
+    std::vector<uint8_t> SignMultiPdf(PreparedMultiPdf& prepared, const std::vector<uint8_t>& pdfBytes,
+                                      const std::vector<PdfSignatureSpec>& specs,
+                                      std::shared_ptr<const CmsTemplate> cmsTemplate,
+                                      const CardSignFunction& cardSign);
+
+}  // namespace nfcsigner
+#endif  // HAVE_PODOFO
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_PDF_SIGNER_H_
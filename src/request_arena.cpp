@@ -0,0 +1,177 @@
+#include "request_arena.h"
+
+#include <algorithm>
+#include <new>
+
+namespace nfcsigner {
+
+    namespace {
+
+        thread_local std::pmr::memory_resource* current_arena = nullptr;
+
+        std::mutex metrics_mutex;
+        RequestArenaMetrics metrics;
+
+        // Arena mới bắt đầu với một khối nhỏ nhất của pool.
+        constexpr size_t kInitialArenaSize = size_t(1) << 16;
+
+        // Lớp kích thước nhỏ nhất chứa được [bytes], hoặc [classCount] nếu quá lớn.
+        size_t SizeClass(size_t bytes, size_t minShift, size_t classCount) {
+            size_t index = 0;
+            while (index < classCount && (size_t(1) << (minShift + index)) < bytes) ++index;
+            return index;
+        }
+
+    }  // namespace
+
+    // === ArenaBlockPool ===
+
+    ArenaBlockPool& ArenaBlockPool::Instance() {
+        static ArenaBlockPool instance;
+        return instance;
+    }
+
+    ArenaBlockPool::~ArenaBlockPool() {
+        for (size_t index = 0; index < kClassCount; ++index) {
+            for (void* block : free_[index]) ::operator delete(block);
+        }
+    }
+
+    void* ArenaBlockPool::do_allocate(size_t bytes, size_t alignment) {
+        size_t index = SizeClass(bytes, kMinBlockShift, kClassCount);
+        // Khối quá lớn hoặc căn lề đặc biệt: lấy thẳng từ heap, không giữ lại.
+        if (index == kClassCount || alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_[index].empty()) {
+                void* block = free_[index].back();
+                free_[index].pop_back();
+                pooled_bytes_ -= size_t(1) << (kMinBlockShift + index);
+                ++reused_;
+                return block;
+            }
+            ++allocated_;
+        }
+        return ::operator new(size_t(1) << (kMinBlockShift + index));
+    }
+
+    void ArenaBlockPool::do_deallocate(void* p, size_t bytes, size_t alignment) {
+        size_t index = SizeClass(bytes, kMinBlockShift, kClassCount);
+        if (index == kClassCount || alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+            return;
+        }
+        size_t blockSize = size_t(1) << (kMinBlockShift + index);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pooled_bytes_ + blockSize <= kMaxPooledBytes) {
+                free_[index].push_back(p);
+                pooled_bytes_ += blockSize;
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+    bool ArenaBlockPool::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+        return this == &other;
+    }
+
+    uint64_t ArenaBlockPool::GetAllocatedCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return allocated_;
+    }
+
+    uint64_t ArenaBlockPool::GetReusedCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return reused_;
+    }
+
+    size_t ArenaBlockPool::GetPooledBytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pooled_bytes_;
+    }
+
+    // === RequestArena ===
+
+    void* RequestArena::BlockSource::do_allocate(size_t bytes, size_t alignment) {
+        void* block = ArenaBlockPool::Instance().allocate(bytes, alignment);
+        this->bytes += bytes;
+        return block;
+    }
+
+    void RequestArena::BlockSource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+        ArenaBlockPool::Instance().deallocate(p, bytes, alignment);
+    }
+
+    bool RequestArena::BlockSource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+        return this == &other;
+    }
+
+    RequestArena::RequestArena() : monotonic_(kInitialArenaSize, &blocks_) {}
+
+    // monotonic_ trả khối về pool sau thân hàm.
+    RequestArena::~RequestArena() {
+        std::lock_guard<std::mutex> lock(metrics_mutex);
+        metrics.requests++;
+        metrics.lastAllocations = allocations_;
+        metrics.maxAllocations = std::max(metrics.maxAllocations, allocations_);
+        metrics.lastPeakBytes = allocated_bytes_;
+        metrics.maxPeakBytes = std::max<uint64_t>(metrics.maxPeakBytes, allocated_bytes_);
+    }
+
+    RequestArena::Scope::Scope(std::pmr::memory_resource* arena) : previous_(current_arena) {
+        current_arena = arena;
+    }
+
+    RequestArena::Scope::~Scope() {
+        current_arena = previous_;
+    }
+
+    void* RequestArena::do_allocate(size_t bytes, size_t alignment) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++allocations_;
+        allocated_bytes_ += bytes;
+        return monotonic_.allocate(bytes, alignment);
+    }
+
+    void RequestArena::do_deallocate(void*, size_t, size_t) {
+        // Giải phóng cả arena khi request kết thúc.
+    }
+
+    bool RequestArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+        return this == &other;
+    }
+
+    uint64_t RequestArena::GetAllocationCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return allocations_;
+    }
+
+    size_t RequestArena::GetAllocatedBytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return allocated_bytes_;
+    }
+
+    size_t RequestArena::GetBlockBytes() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return blocks_.bytes;
+    }
+
+    std::pmr::memory_resource* CurrentRequestArena() {
+        return current_arena ? current_arena : std::pmr::new_delete_resource();
+    }
+
+    RequestArenaMetrics GetRequestArenaMetrics() {
+        ArenaBlockPool& pool = ArenaBlockPool::Instance();
+        std::lock_guard<std::mutex> lock(metrics_mutex);
+        RequestArenaMetrics result = metrics;
+        result.blocksAllocated = pool.GetAllocatedCount();
+        result.blocksReused = pool.GetReusedCount();
+        result.pooledBytes = pool.GetPooledBytes();
+        return result;
+    }
+
+}  // namespace nfcsigner
@@ -0,0 +1,123 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_REQUEST_ARENA_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_REQUEST_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+namespace nfcsigner {
+
+    // Khối nền cho arena của các request, theo lớp kích thước lũy thừa 2 (64 KiB
+    // tới 4 MiB). Khối được trả về giữ lại cho request sau thay vì trả cho heap,
+    // nên buffer sống ngắn của từng request không làm phân mảnh heap của tiến
+    // trình chạy lâu. Dùng chung cho cả tiến trình.
+    class ArenaBlockPool : public std::pmr::memory_resource {
+    public:
+        static ArenaBlockPool& Instance();
+
+        uint64_t GetAllocatedCount() const;
+        uint64_t GetReusedCount() const;
+        size_t GetPooledBytes() const;
+
+    private:
+        ArenaBlockPool() = default;
+        ~ArenaBlockPool() override;
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        static constexpr size_t kMinBlockShift = 16;                    // 64 KiB
+        static constexpr size_t kClassCount = 7;                        // tới 4 MiB
+        static constexpr size_t kMaxPooledBytes = 16u * 1024 * 1024;    // giữ lại tối đa
+
+        mutable std::mutex mutex_;
+        std::vector<void*> free_[kClassCount];
+        size_t pooled_bytes_ = 0;
+        uint64_t allocated_ = 0;
+        uint64_t reused_ = 0;
+    };
+
+    // Arena của một request (signPdf, signPdfMulti...). Cấp phát tạm trong
+    // request lấy từ một monotonic_buffer_resource trên ArenaBlockPool và được
+    // trả lại một lượt khi request kết thúc; deallocate không làm gì. Hiện chỉ
+    // xref, object và token của đường ký lazy PDF dùng arena; APDU, CMS và bản
+    // PDF kết quả vẫn là std::vector trên heap vì được trả ra khỏi request.
+    //
+    // Tạo arena không gắn nó vào thread nào: mỗi thread của request (kể cả
+    // thread tạo arena) tự mở một Scope để CurrentRequestArena trả về nó. Cấp
+    // phát được khóa nên các nhánh dùng chung được. Arena phải sống lâu hơn
+    // mọi object cấp phát từ nó và mọi Scope gắn nó.
+    class RequestArena : public std::pmr::memory_resource {
+    public:
+        RequestArena();
+        ~RequestArena() override;
+
+        RequestArena(const RequestArena&) = delete;
+        RequestArena& operator=(const RequestArena&) = delete;
+
+        // Gắn [arena] vào thread hiện tại cho tới khi Scope bị hủy.
+        class Scope {
+        public:
+            explicit Scope(std::pmr::memory_resource* arena);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            std::pmr::memory_resource* previous_;
+        };
+
+        uint64_t GetAllocationCount() const;
+        // Tổng byte đã cấp: arena không giải phóng giữa chừng nên đây cũng là đỉnh.
+        size_t GetAllocatedBytes() const;
+        // Byte khối nền lấy từ ArenaBlockPool.
+        size_t GetBlockBytes() const;
+
+    private:
+        // Đếm khối nền monotonic lấy từ pool.
+        class BlockSource : public std::pmr::memory_resource {
+        public:
+            size_t bytes = 0;
+
+        private:
+            void* do_allocate(size_t bytes, size_t alignment) override;
+            void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+        };
+
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+        mutable std::mutex mutex_;
+        BlockSource blocks_;
+        std::pmr::monotonic_buffer_resource monotonic_;
+        uint64_t allocations_ = 0;
+        size_t allocated_bytes_ = 0;
+    };
+
+    // Arena của request đang chạy trên thread này, hoặc heap
+    // (std::pmr::new_delete_resource) nếu không có.
+    std::pmr::memory_resource* CurrentRequestArena();
+
+    // Số liệu arena theo request, cộng dồn cho cả tiến trình.
+    struct RequestArenaMetrics {
+        uint64_t requests = 0;
+        uint64_t lastAllocations = 0;
+        uint64_t maxAllocations = 0;
+        uint64_t lastPeakBytes = 0;
+        uint64_t maxPeakBytes = 0;
+        uint64_t blocksAllocated = 0;   // khối pool phải xin từ heap
+        uint64_t blocksReused = 0;      // khối pool dùng lại từ request trước
+        uint64_t pooledBytes = 0;       // đang giữ trong pool
+    };
+
+    RequestArenaMetrics GetRequestArenaMetrics();
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_REQUEST_ARENA_H_
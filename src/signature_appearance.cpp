@@ -0,0 +1,511 @@
+#include "signature_appearance.h"
+
+#include <openssl/evp.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <locale>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include "byte_codec.h"
+
+#ifdef HAVE_PODOFO
+using namespace PoDoFo;
+#endif
+
+namespace nfcsigner {
+
+    namespace {
+
+        void AppendField(std::string& out, const std::string& value) {
+            out += std::to_string(value.size());
+            out += ':';
+            out += value;
+        }
+
+        void AppendField(std::string& out, double value) {
+            std::ostringstream stream;
+            stream.imbue(std::locale::classic());
+            stream << value;
+            AppendField(out, stream.str());
+        }
+
+    }  // namespace
+
+    std::string SignatureAppearanceConfig::CacheKey() const {
+        std::string serialized;
+        AppendField(serialized, x);
+        AppendField(serialized, y);
+        AppendField(serialized, width);
+        AppendField(serialized, height);
+        AppendField(serialized, signerName);
+        AppendField(serialized, contact);
+        AppendField(serialized, signatureImageWidth);
+        AppendField(serialized, signatureImageHeight);
+        AppendField(serialized, std::string(signatureImage.begin(), signatureImage.end()));
+
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int digestLength = 0;
+        if (EVP_Digest(serialized.data(), serialized.size(), digest, &digestLength, EVP_sha256(), nullptr) != 1) {
+            throw std::runtime_error("Cannot hash signature appearance config.");
+        }
+        return std::string(reinterpret_cast<const char*>(digest), digestLength);
+    }
+
+#ifdef HAVE_PODOFO
+    namespace {
+
+        constexpr double kFontSize = 11.0;
+        // Độ phân giải tối đa của ảnh chữ ký sau khi thu nhỏ (~144 dpi).
+        constexpr double kImagePixelsPerPoint = 2.0;
+
+        const char* const kFontCandidates[] = { "Helvetica", "Arial", "Liberation Sans", "DejaVu Sans", "Tahoma" };
+
+        // Các ký tự có thể xuất hiện trong ngày ký; được đưa sẵn vào subset font.
+        const char kDateCharset[] =
+                "0123456789 -/:.,+"
+                "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                "abcdefghijklmnopqrstuvwxyz";
+
+        // PNG RGBA 1x1 trong suốt cho WarmUpImageCodecs.
+        const unsigned char kWarmUpPng[] = {
+                0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+                0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x08, 0x06, 0x00, 0x00, 0x00, 0x1F, 0x15, 0xC4,
+                0x89, 0x00, 0x00, 0x00, 0x0B, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x63, 0x60, 0x00, 0x02, 0x00,
+                0x00, 0x05, 0x00, 0x01, 0xE9, 0xFA, 0xDC, 0xD8, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44,
+                0xAE, 0x42, 0x60, 0x82,
+        };
+
+        const char kSignerLabel[] = "Người ký: ";
+        const char kContactLabel[] = "Email: ";
+        const char kDateLabel[] = "Ngày ký: ";
+
+        std::u32string DecodeUtf8(const std::string& text) {
+            std::u32string result;
+            for (size_t i = 0; i < text.size();) {
+                unsigned char c = static_cast<unsigned char>(text[i]);
+                char32_t cp;
+                size_t extra;
+                if (c < 0x80) { cp = c; extra = 0; }
+                else if ((c & 0xE0) == 0xC0) { cp = c & 0x1F; extra = 1; }
+                else if ((c & 0xF0) == 0xE0) { cp = c & 0x0F; extra = 2; }
+                else if ((c & 0xF8) == 0xF0) { cp = c & 0x07; extra = 3; }
+                else throw std::runtime_error("Invalid UTF-8 text.");
+                if (i + extra >= text.size()) {
+                    throw std::runtime_error("Truncated UTF-8 text.");
+                }
+                for (size_t k = 1; k <= extra; ++k) {
+                    cp = (cp << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+                }
+                result.push_back(cp);
+                i += extra + 1;
+            }
+            return result;
+        }
+
+        std::string EncodeUtf8(char32_t cp) {
+            std::string out;
+            if (cp < 0x80) {
+                out += static_cast<char>(cp);
+            } else if (cp < 0x800) {
+                out += static_cast<char>(0xC0 | (cp >> 6));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            } else if (cp < 0x10000) {
+                out += static_cast<char>(0xE0 | (cp >> 12));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (cp >> 18));
+                out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (cp & 0x3F));
+            }
+            return out;
+        }
+
+        bool FontCovers(const PdfFont& font, const std::string& text) {
+            unsigned gid;
+            for (char32_t cp : DecodeUtf8(text)) {
+                if (!font.GetMetrics().TryGetGID(cp, gid)) return false;
+            }
+            return true;
+        }
+
+        // Chọn font hệ thống đầu tiên có đủ glyph tiếng Việt cho [sample].
+        PdfFont* FindFont(PdfDocument& document, const std::string& sample) {
+            PdfFont* fallback = nullptr;
+            for (const char* name : kFontCandidates) {
+                auto* font = document.GetFonts().SearchFont(name);
+                if (!font) continue;
+                if (FontCovers(*font, sample)) return font;
+                if (!fallback) fallback = font;
+            }
+            return fallback;
+        }
+
+        // Vị trí các dòng chữ, giữ vùng chữ như trước: Rect(x + 80, y - 5, width - 80, height), căn trên.
+        struct TextLayout {
+            double x;
+            double baselines[3];
+        };
+
+        TextLayout LayoutText(const PdfFont& font, const SignatureAppearanceConfig& config) {
+            PdfTextState state;
+            state.Font = &font;
+            state.FontSize = kFontSize;
+            double top = config.y - 5 + config.height;
+            double first = top - font.GetAscent(state);
+            double spacing = font.GetLineSpacing(state);
+            return { config.x + 80, { first, first - spacing, first - 2 * spacing } };
+        }
+
+        // Thu nhỏ ảnh RGBA bằng box filter.
+        charbuff DownscaleRgba(const charbuff& source, unsigned sourceWidth, unsigned sourceHeight,
+                               unsigned targetWidth, unsigned targetHeight) {
+            charbuff target(static_cast<size_t>(targetWidth) * targetHeight * 4, '\0');
+            for (unsigned ty = 0; ty < targetHeight; ++ty) {
+                unsigned y0 = ty * sourceHeight / targetHeight;
+                unsigned y1 = std::max(y0 + 1, (ty + 1) * sourceHeight / targetHeight);
+                for (unsigned tx = 0; tx < targetWidth; ++tx) {
+                    unsigned x0 = tx * sourceWidth / targetWidth;
+                    unsigned x1 = std::max(x0 + 1, (tx + 1) * sourceWidth / targetWidth);
+                    unsigned sum[4] = { 0, 0, 0, 0 };
+                    for (unsigned sy = y0; sy < y1; ++sy) {
+                        const auto* row = reinterpret_cast<const unsigned char*>(source.data()) +
+                                          static_cast<size_t>(sy) * sourceWidth * 4;
+                        for (unsigned sx = x0; sx < x1; ++sx) {
+                            for (int c = 0; c < 4; ++c) sum[c] += row[sx * 4 + c];
+                        }
+                    }
+                    unsigned count = (y1 - y0) * (x1 - x0);
+                    char* out = target.data() + (static_cast<size_t>(ty) * targetWidth + tx) * 4;
+                    for (int c = 0; c < 4; ++c) out[c] = static_cast<char>(sum[c] / count);
+                }
+            }
+            return target;
+        }
+
+        // Tải ảnh chữ ký; nếu [downscale] thì giải mã và thu nhỏ về kích thước hiển thị.
+        std::unique_ptr<PdfImage> LoadSignatureImage(PdfDocument& document, const SignatureAppearanceConfig& config,
+                                                     bool downscale) {
+            if (config.signatureImage.empty()) return nullptr;
+            try {
+                auto image = document.CreateImage();
+                image->LoadFromBuffer(bufferview(reinterpret_cast<const char*>(config.signatureImage.data()),
+                                                 config.signatureImage.size()));
+                if (image->GetWidth() == 0 || image->GetHeight() == 0) return nullptr;
+
+                unsigned targetWidth = static_cast<unsigned>(std::ceil(config.signatureImageWidth * kImagePixelsPerPoint));
+                unsigned targetHeight = static_cast<unsigned>(std::ceil(config.signatureImageHeight * kImagePixelsPerPoint));
+                if (downscale && targetWidth > 0 && targetHeight > 0 &&
+                    (image->GetWidth() > targetWidth || image->GetHeight() > targetHeight)) {
+                    charbuff pixels;
+                    image->DecodeTo(pixels, PdfPixelFormat::RGBA);
+                    auto scaled = DownscaleRgba(pixels, image->GetWidth(), image->GetHeight(), targetWidth, targetHeight);
+                    auto small = document.CreateImage();
+                    small->SetData(scaled, targetWidth, targetHeight, PdfPixelFormat::RGBA);
+                    return small;
+                }
+                return image;
+            } catch (const PdfError& e) {
+                std::cerr << "Warning: Không thể load ảnh chữ ký: " << e.what() << std::endl;
+                return nullptr;
+            }
+        }
+
+        // Vẽ viền và ảnh chữ ký.
+        void DrawFrameAndImage(PdfPainter& painter, const SignatureAppearanceConfig& config, PdfImage* image) {
+            PdfColor black(0.0, 0.0, 0.0);
+            painter.GraphicsState.SetStrokingColor(black);
+            painter.GraphicsState.SetNonStrokingColor(black);
+            painter.DrawRectangle(0, 0, config.width, config.height);
+
+            if (image) {
+                double img_h = config.signatureImageHeight;
+                double img_w = config.signatureImageWidth;
+                double scale_y = img_h / image->GetHeight();
+                double scale_x = img_w / image->GetWidth();
+                painter.DrawImage(*image, config.x + 2, config.y + (config.height - img_h) / 2, scale_x, scale_y);
+            }
+        }
+
+        // Sao chép đồ thị object (kèm stream đã mã hóa) từ tài liệu nháp sang tài liệu đích.
+        class ObjectCopier {
+        public:
+            ObjectCopier(const PdfDocument& source, PdfDocument& target) : source_(source), target_(target) {}
+
+            PdfObject& CopyIndirect(const PdfObject& object) {
+                auto reference = object.GetIndirectReference();
+                auto it = copied_.find(reference);
+                if (it != copied_.end()) return *it->second;
+                if (!in_progress_.insert(reference).second) {
+                    throw std::runtime_error("Cyclic object graph in appearance template.");
+                }
+
+                PdfObject& copy = target_.GetObjects().CreateObject(CopyValue(object));
+                if (object.HasStream()) {
+                    charbuff raw = object.MustGetStream().GetCopy(true);
+                    copy.GetOrCreateStream().SetData(raw, true);
+                }
+                in_progress_.erase(reference);
+                copied_[reference] = &copy;
+                return copy;
+            }
+
+        private:
+            PdfObject CopyValue(const PdfObject& value) {
+                switch (value.GetDataType()) {
+                    case PdfDataType::Reference: {
+                        const PdfObject* referenced = source_.GetObjects().GetObject(value.GetReference());
+                        if (!referenced) return PdfObject();
+                        return PdfObject(CopyIndirect(*referenced).GetIndirectReference());
+                    }
+                    case PdfDataType::Dictionary: {
+                        PdfDictionary dictionary;
+                        for (const auto& pair : value.GetDictionary()) {
+                            dictionary.AddKey(pair.first, CopyValue(pair.second));
+                        }
+                        return PdfObject(dictionary);
+                    }
+                    case PdfDataType::Array: {
+                        PdfArray array;
+                        for (const auto& item : value.GetArray()) array.Add(CopyValue(item));
+                        return PdfObject(array);
+                    }
+                    default:
+                        return value;
+                }
+            }
+
+            const PdfDocument& source_;
+            PdfDocument& target_;
+            std::map<PdfReference, PdfObject*> copied_;
+            std::set<PdfReference> in_progress_;
+        };
+
+        std::string ToHex(const charbuff& data) {
+            return EncodeHex(reinterpret_cast<const uint8_t*>(data.data()), data.size(), HexCase::Upper);
+        }
+
+    }  // namespace
+
+    void DrawSignatureAppearance(PdfMemDocument& document, PdfSignature& field,
+                                 const SignatureAppearanceConfig& config, const std::string& signDate) {
+        Rect annot_rect(config.x, config.y, config.width, config.height);
+        auto sigXObject = document.CreateXObjectForm(annot_rect);
+        if (!sigXObject) return;
+
+        PdfPainter painter;
+        painter.SetCanvas(*sigXObject);
+        auto image = LoadSignatureImage(document, config, false);
+        DrawFrameAndImage(painter, config, image.get());
+
+        std::string lines[3] = {
+                kSignerLabel + config.signerName,
+                kContactLabel + config.contact,
+                kDateLabel + signDate,
+        };
+        auto* font = FindFont(document, lines[0] + lines[1] + lines[2]);
+        if (font) {
+            painter.TextState.SetFont(*font, kFontSize);
+            auto layout = LayoutText(*font, config);
+            for (int i = 0; i < 3; ++i) painter.DrawText(lines[i], layout.x, layout.baselines[i]);
+        }
+        painter.FinishDrawing();
+
+        field.MustGetWidget().SetAppearanceStream(*sigXObject);
+    }
+
+    std::shared_ptr<const SignatureAppearanceTemplate> SignatureAppearanceTemplate::Create(
+            const SignatureAppearanceConfig& config) {
+        std::shared_ptr<SignatureAppearanceTemplate> tpl(new SignatureAppearanceTemplate());
+        tpl->config_ = config;
+        tpl->scratch_ = std::make_unique<PdfMemDocument>();
+        tpl->font_size_ = kFontSize;
+        PdfMemDocument& scratch = *tpl->scratch_;
+
+        std::string line1 = kSignerLabel + config.signerName;
+        std::string line2 = kContactLabel + config.contact;
+        tpl->font_ = FindFont(scratch, line1 + line2 + kDateLabel + kDateCharset);
+        if (!tpl->font_) {
+            throw std::runtime_error("No font available for signature appearance.");
+        }
+        PdfFont& font = *tpl->font_;
+
+        Rect annot_rect(config.x, config.y, config.width, config.height);
+        tpl->static_form_ = scratch.CreateXObjectForm(annot_rect);
+
+        PdfPainter painter;
+        painter.SetCanvas(*tpl->static_form_);
+        auto image = LoadSignatureImage(scratch, config, true);
+        DrawFrameAndImage(painter, config, image.get());
+
+        painter.TextState.SetFont(font, kFontSize);
+        auto layout = LayoutText(font, config);
+        painter.DrawText(line1, layout.x, layout.baselines[0]);
+        painter.DrawText(line2, layout.x, layout.baselines[1]);
+        painter.DrawText(kDateLabel, layout.x, layout.baselines[2]);
+        painter.FinishDrawing();
+
+        PdfTextState state;
+        state.Font = &font;
+        state.FontSize = kFontSize;
+        tpl->date_x_ = layout.x + font.GetStringLength(kDateLabel, state);
+        tpl->date_y_ = layout.baselines[2];
+
+        // Vẽ bộ ký tự ngày ký lên một form không dùng tới để các glyph này có trong subset.
+        auto primeForm = scratch.CreateXObjectForm(Rect(0, 0, 1, 1));
+        PdfPainter primePainter;
+        primePainter.SetCanvas(*primeForm);
+        primePainter.TextState.SetFont(font, kFontSize);
+        primePainter.DrawText(kDateCharset, 0, 0);
+        primePainter.FinishDrawing();
+
+        for (char32_t cp : DecodeUtf8(kDateCharset)) {
+            charbuff encoded;
+            if (font.GetEncoding().TryConvertToEncoded(EncodeUtf8(cp), encoded)) {
+                tpl->date_codes_[cp] = ToHex(encoded);
+            }
+        }
+
+        // Lưu nháp một lần để PoDoFo nhúng subset font vào các object của template.
+        // Không thu gom object: form tĩnh không được trang nào tham chiếu.
+        auto serialized = std::make_shared<std::vector<char>>();
+        VectorStreamDevice device(*serialized);
+        scratch.Save(device, PdfSaveOptions::NoCollectGarbage);
+        tpl->serialized_ = std::move(serialized);
+        return tpl;
+    }
+
+    SignatureAppearanceTemplate::~SignatureAppearanceTemplate() = default;
+
+    bool SignatureAppearanceTemplate::TryEncodeDate(const std::string& signDate, std::string& hexCodes) const {
+        hexCodes.clear();
+        std::u32string codePoints;
+        try {
+            codePoints = DecodeUtf8(signDate);
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+        for (char32_t cp : codePoints) {
+            auto it = date_codes_.find(cp);
+            if (it == date_codes_.end()) return false;
+            hexCodes += it->second;
+        }
+        return true;
+    }
+
+    std::string SignatureAppearanceTemplate::BuildContent(const std::string& dateHex) const {
+        std::ostringstream content;
+        content.imbue(std::locale::classic());
+        content << "q /Tpl Do Q\n"
+                << "BT /FDate " << font_size_ << " Tf 1 0 0 1 " << date_x_ << ' ' << date_y_ << " Tm <"
+                << dateHex << "> Tj ET\n";
+        return content.str();
+    }
+
+    void SignatureAppearanceTemplate::Apply(PdfMemDocument& document, PdfSignature& field,
+                                            const std::string& signDate) const {
+        std::string dateHex;
+        if (!TryEncodeDate(signDate, dateHex)) {
+            std::cout << "Appearance template: ngày ký có ký tự ngoài subset, vẽ trực tiếp." << std::endl;
+            DrawSignatureAppearance(document, field, config_, signDate);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ObjectCopier copier(*scratch_, document);
+        PdfObject& staticForm = copier.CopyIndirect(static_form_->GetObject());
+        PdfObject& font = copier.CopyIndirect(font_->GetObject());
+
+        Rect annot_rect(config_.x, config_.y, config_.width, config_.height);
+        auto sigXObject = document.CreateXObjectForm(annot_rect);
+        if (!sigXObject) return;
+
+        PdfDictionary xobjects;
+        xobjects.AddKey(PdfName("Tpl"), PdfObject(staticForm.GetIndirectReference()));
+        PdfDictionary fonts;
+        fonts.AddKey(PdfName("FDate"), PdfObject(font.GetIndirectReference()));
+        PdfDictionary resources;
+        resources.AddKey(PdfName("XObject"), PdfObject(xobjects));
+        resources.AddKey(PdfName("Font"), PdfObject(fonts));
+        sigXObject->GetObject().GetDictionary().AddKey(PdfName("Resources"), PdfObject(resources));
+
+        std::string contentData = BuildContent(dateHex);
+        sigXObject->GetObject().GetOrCreateStream().SetData(bufferview(contentData.data(), contentData.size()));
+
+        field.MustGetWidget().SetAppearanceStream(*sigXObject);
+    }
+
+    bool SignatureAppearanceTemplate::BuildLazyAppearance(const std::string& signDate,
+                                                          LazyPdfAppearance& appearance) const {
+        std::string dateHex;
+        if (!TryEncodeDate(signDate, dateHex)) return false;
+
+        appearance.content = BuildContent(dateHex);
+        appearance.source = serialized_;
+        appearance.xobjects = { { "Tpl", static_form_->GetObject().GetIndirectReference().ObjectNumber() } };
+        appearance.fonts = { { "FDate", font_->GetObject().GetIndirectReference().ObjectNumber() } };
+        return true;
+    }
+
+    bool WarmUpAppearanceFonts() {
+        PdfMemDocument scratch;
+        return FindFont(scratch, std::string(kSignerLabel) + kContactLabel + kDateLabel + kDateCharset) != nullptr;
+    }
+
+    void WarmUpImageCodecs() {
+        PdfMemDocument scratch;
+        auto image = scratch.CreateImage();
+        image->LoadFromBuffer(bufferview(reinterpret_cast<const char*>(kWarmUpPng), sizeof(kWarmUpPng)));
+        charbuff pixels;
+        image->DecodeTo(pixels, PdfPixelFormat::RGBA);
+    }
+
+    SignatureAppearanceCache& SignatureAppearanceCache::Instance() {
+        static SignatureAppearanceCache instance;
+        return instance;
+    }
+
+    std::shared_ptr<const SignatureAppearanceTemplate> SignatureAppearanceCache::GetOrCreate(
+            const SignatureAppearanceConfig& config) {
+        std::string key = config.CacheKey();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it != entries_.end()) {
+                ++hits_;
+                return it->second;
+            }
+            ++misses_;
+        }
+
+        auto tpl = SignatureAppearanceTemplate::Create(config);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (entries_.size() >= kMaxEntries) entries_.clear();
+        entries_.emplace(key, tpl);
+        return tpl;
+    }
+
+    void SignatureAppearanceCache::Clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+    }
+
+    size_t SignatureAppearanceCache::GetHitCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return hits_;
+    }
+
+    size_t SignatureAppearanceCache::GetMissCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return misses_;
+    }
+#endif
+
+}  // namespace nfcsigner
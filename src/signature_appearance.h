@@ -0,0 +1,114 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_SIGNATURE_APPEARANCE_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_SIGNATURE_APPEARANCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef HAVE_PODOFO
+#include <podofo/podofo.h>
+#endif
+
+#include "lazy_pdf.h"
+
+namespace nfcsigner {
+
+    // Cấu hình hiển thị chữ ký (phần không đổi giữa các tài liệu).
+    struct SignatureAppearanceConfig {
+        double x = 50.0;
+        double y = 700.0;
+        double width = 200.0;
+        double height = 50.0;
+        std::string signerName = "BMC T&S JSC";
+        std::string contact = "info@bmctech.vn";
+        std::vector<uint8_t> signatureImage;
+        double signatureImageWidth = 50.0;
+        double signatureImageHeight = 50.0;
+
+        // Khóa cache: SHA-256 của toàn bộ cấu hình (kể cả ảnh chữ ký).
+        std::string CacheKey() const;
+    };
+
+#ifdef HAVE_PODOFO
+    // Vẽ appearance trực tiếp vào tài liệu (không qua cache).
+    void DrawSignatureAppearance(PoDoFo::PdfMemDocument& document, PoDoFo::PdfSignature& field,
+                                 const SignatureAppearanceConfig& config, const std::string& signDate);
+
+    // Khởi tạo trước phần lần vẽ appearance đầu tiên phải trả: lần SearchFont
+    // đầu tiên của PoDoFo quét toàn bộ font hệ thống. Trả về false nếu không
+    // tìm được font nào.
+    bool WarmUpAppearanceFonts();
+
+    // Giải mã thử một ảnh PNG 1x1 để nạp bộ giải mã ảnh của PoDoFo.
+    void WarmUpImageCodecs();
+
+    // Appearance đã render sẵn cho một cấu hình người ký.
+    //
+    // Phần tĩnh (viền, ảnh chữ ký đã giải mã và thu nhỏ, hai dòng đầu và nhãn
+    // "Ngày ký") được vẽ một lần vào một tài liệu nháp, font được nhúng subset
+    // ở đó. Mỗi tài liệu chỉ sao chép các object đã mã hóa sẵn và ghi lại dòng
+    // ngày ký bằng bảng mã glyph đã chuẩn bị trước.
+    class SignatureAppearanceTemplate {
+    public:
+        static std::shared_ptr<const SignatureAppearanceTemplate> Create(const SignatureAppearanceConfig& config);
+
+        ~SignatureAppearanceTemplate();
+
+        // Gắn appearance vào [field]. Nếu ngày ký chứa ký tự chưa có trong
+        // subset, chuyển sang vẽ trực tiếp.
+        void Apply(PoDoFo::PdfMemDocument& document, PoDoFo::PdfSignature& field,
+                   const std::string& signDate) const;
+
+        // Appearance cho đường ký từng phần: content stream cùng các object của
+        // template đã serialize. Trả về false nếu ngày ký có ký tự ngoài subset.
+        bool BuildLazyAppearance(const std::string& signDate, LazyPdfAppearance& appearance) const;
+
+    private:
+        SignatureAppearanceTemplate() = default;
+
+        bool TryEncodeDate(const std::string& signDate, std::string& hexCodes) const;
+        std::string BuildContent(const std::string& dateHex) const;
+
+        SignatureAppearanceConfig config_;
+        std::unique_ptr<PoDoFo::PdfMemDocument> scratch_;
+        std::unique_ptr<PoDoFo::PdfXObjectForm> static_form_;
+        PoDoFo::PdfFont* font_ = nullptr;
+        double font_size_ = 11.0;
+        double date_x_ = 0.0;
+        double date_y_ = 0.0;
+        std::unordered_map<char32_t, std::string> date_codes_;
+        // Tài liệu nháp sau khi lưu (đã nhúng subset font).
+        std::shared_ptr<const std::vector<char>> serialized_;
+        mutable std::mutex mutex_;
+    };
+
+    // Cache appearance theo CacheKey() của cấu hình người ký.
+    class SignatureAppearanceCache {
+    public:
+        static SignatureAppearanceCache& Instance();
+
+        std::shared_ptr<const SignatureAppearanceTemplate> GetOrCreate(const SignatureAppearanceConfig& config);
+
+        void Clear();
+        size_t GetHitCount() const;
+        size_t GetMissCount() const;
+
+    private:
+        SignatureAppearanceCache() = default;
+
+        static constexpr size_t kMaxEntries = 8;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, std::shared_ptr<const SignatureAppearanceTemplate>> entries_;
+        size_t hits_ = 0;
+        size_t misses_ = 0;
+    };
+#endif
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_SIGNATURE_APPEARANCE_H_
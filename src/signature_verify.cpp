@@ -0,0 +1,490 @@
+#include "signature_verify.h"
+
+#include <openssl/bio.h>
+#include <openssl/cms.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#include "byte_codec.h"
+#include "file_digest.h"
+#include "lazy_pdf.h"
+#include "signing_metrics.h"
+
+namespace nfcsigner {
+
+    namespace {
+
+        using CmsPtr = std::unique_ptr<CMS_ContentInfo, decltype(&CMS_ContentInfo_free)>;
+        using MdCtxPtr = std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>;
+
+        // Lỗi OpenSSL gần nhất của luồng hiện tại (hàng đợi lỗi là theo luồng).
+        std::string OpenSslError(const char* what) {
+            unsigned long code = ERR_get_error();
+            ERR_clear_error();
+            if (code == 0) return what;
+            char buffer[256];
+            ERR_error_string_n(code, buffer, sizeof(buffer));
+            return std::string(what) + " (" + buffer + ")";
+        }
+
+        // Chạy [work](i) cho i trong [0, count) trên [threads] luồng (0: theo số lõi CPU).
+        template <typename Work>
+        void ParallelFor(size_t count, size_t threads, const Work& work) {
+            if (count == 0) return;
+            if (threads == 0) threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+            threads = std::min(threads, count);
+
+            std::atomic<size_t> next{0};
+            auto run = [&]() {
+                for (size_t index = next++; index < count; index = next++) work(index);
+            };
+            std::vector<std::thread> workers;
+            workers.reserve(threads - 1);
+            for (size_t i = 1; i < threads; ++i) workers.emplace_back(run);
+            run();
+            for (auto& worker : workers) worker.join();
+        }
+
+        // SignedData đã phân tích, mọi signer đã được gắn certificate và dùng
+        // chung thuật toán digest [md].
+        struct ParsedCms {
+            CmsPtr cms{nullptr, &CMS_ContentInfo_free};
+            std::vector<CMS_SignerInfo*> signerInfos;
+            const EVP_MD* md = nullptr;
+        };
+
+        // Ném std::runtime_error nếu [der] không phải SignedData kiểm tra được.
+        ParsedCms ParseCms(const uint8_t* der, size_t size, SignatureVerification& result) {
+            ParsedCms parsed;
+            const unsigned char* cursor = der;
+            parsed.cms.reset(d2i_CMS_ContentInfo(nullptr, &cursor, static_cast<long>(size)));
+            if (!parsed.cms) throw std::runtime_error(OpenSslError("CMS không hợp lệ."));
+            if (OBJ_obj2nid(CMS_get0_type(parsed.cms.get())) != NID_pkcs7_signed) {
+                throw std::runtime_error("CMS không phải SignedData.");
+            }
+
+            STACK_OF(CMS_SignerInfo)* signerInfos = CMS_get0_SignerInfos(parsed.cms.get());
+            if (!signerInfos || sk_CMS_SignerInfo_num(signerInfos) == 0) {
+                throw std::runtime_error("CMS không có SignerInfo.");
+            }
+
+            // Gắn certificate nhúng trong CMS cho từng signer.
+            if (CMS_set1_signers_certs(parsed.cms.get(), nullptr, 0) < 0) {
+                throw std::runtime_error(OpenSslError("CMS_set1_signers_certs failed."));
+            }
+            // Mọi signer đều được kiểm tra trên cùng một digest nội dung; thông
+            // tin người ký trong kết quả lấy từ signer đầu tiên.
+            X509* signer = nullptr;
+            for (int i = 0; i < sk_CMS_SignerInfo_num(signerInfos); ++i) {
+                CMS_SignerInfo* signerInfo = sk_CMS_SignerInfo_value(signerInfos, i);
+                X509* certificate = nullptr;
+                X509_ALGOR* digestAlgorithm = nullptr;
+                CMS_SignerInfo_get0_algs(signerInfo, nullptr, &certificate, &digestAlgorithm, nullptr);
+                if (!certificate) throw std::runtime_error("CMS không kèm certificate của người ký.");
+                const EVP_MD* md = digestAlgorithm ? EVP_get_digestbyobj(digestAlgorithm->algorithm) : nullptr;
+                if (!md) throw std::runtime_error("Thuật toán digest không được hỗ trợ.");
+                if (parsed.md && EVP_MD_type(md) != EVP_MD_type(parsed.md)) {
+                    throw std::runtime_error("Các SignerInfo dùng thuật toán digest khác nhau.");
+                }
+                if (!signer) signer = certificate;
+                parsed.md = md;
+                parsed.signerInfos.push_back(signerInfo);
+            }
+            std::string name = OBJ_nid2sn(EVP_MD_type(parsed.md));
+            std::transform(name.begin(), name.end(), name.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            result.digestAlgorithm = name;
+
+            int length = i2d_X509(signer, nullptr);
+            if (length > 0) {
+                result.certificate.resize(static_cast<size_t>(length));
+                unsigned char* out = result.certificate.data();
+                i2d_X509(signer, &out);
+            }
+            std::unique_ptr<BIO, decltype(&BIO_free)> bio(BIO_new(BIO_s_mem()), &BIO_free);
+            if (bio && X509_NAME_print_ex(bio.get(), X509_get_subject_name(signer), 0, XN_FLAG_RFC2253) >= 0) {
+                char* text = nullptr;
+                long textLength = BIO_get_mem_data(bio.get(), &text);
+                if (text && textLength > 0) result.signer.assign(text, static_cast<size_t>(textLength));
+            }
+
+            CMS_SignerInfo* first = parsed.signerInfos.front();
+            int index = CMS_signed_get_attr_by_NID(first, NID_pkcs9_signingTime, -1);
+            if (index >= 0) {
+                ASN1_TYPE* value = X509_ATTRIBUTE_get0_type(CMS_signed_get_attr(first, index), 0);
+                if (value && (value->type == V_ASN1_UTCTIME || value->type == V_ASN1_GENERALIZEDTIME)) {
+                    std::unique_ptr<ASN1_TIME, decltype(&ASN1_TIME_free)> epoch(ASN1_TIME_set(nullptr, 0), &ASN1_TIME_free);
+                    int days = 0;
+                    int seconds = 0;
+                    if (epoch && ASN1_TIME_diff(&days, &seconds, epoch.get(), value->value.asn1_string)) {
+                        result.signingTime = static_cast<std::time_t>(days) * 86400 + seconds;
+                    }
+                }
+            }
+            return parsed;
+        }
+
+        // Nội dung nhúng trong SignedData, nullptr nếu chữ ký tách rời.
+        const ASN1_OCTET_STRING* EncapsulatedContent(const ParsedCms& parsed) {
+            ASN1_OCTET_STRING** content = CMS_get0_content(parsed.cms.get());
+            return content ? *content : nullptr;
+        }
+
+        MdCtxPtr NewDigest(const EVP_MD* md) {
+            MdCtxPtr ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+            if (!ctx || EVP_DigestInit_ex(ctx.get(), md, nullptr) != 1) {
+                throw std::runtime_error("EVP_DigestInit_ex failed.");
+            }
+            return ctx;
+        }
+
+        // So [digest] của nội dung với messageDigest của một signer và kiểm tra
+        // chữ ký của nó; [result] chỉ nhận digestValid/signatureValid/error.
+        void CheckSignerInfo(CMS_SignerInfo* signerInfo, const EVP_MD* md, const uint8_t* digest,
+                             unsigned int digestLength, SignatureVerification& result) {
+            if (CMS_signed_get_attr_count(signerInfo) > 0) {
+                auto* messageDigest = static_cast<ASN1_OCTET_STRING*>(CMS_signed_get0_data_by_OBJ(
+                        signerInfo, OBJ_nid2obj(NID_pkcs9_messageDigest), -3, V_ASN1_OCTET_STRING));
+                result.digestValid = messageDigest &&
+                                     static_cast<unsigned int>(ASN1_STRING_length(messageDigest)) == digestLength &&
+                                     std::memcmp(ASN1_STRING_get0_data(messageDigest), digest, digestLength) == 0;
+                if (!result.digestValid) result.error = "Digest nội dung không khớp messageDigest.";
+                result.signatureValid = CMS_SignerInfo_verify(signerInfo) == 1;
+                if (!result.signatureValid && result.error.empty()) {
+                    result.error = OpenSslError("Chữ ký không đúng.");
+                }
+            } else {
+                // Không có signedAttrs: chữ ký nằm trực tiếp trên digest nội dung.
+                EVP_PKEY* key = nullptr;
+                CMS_SignerInfo_get0_algs(signerInfo, &key, nullptr, nullptr, nullptr);
+                ASN1_OCTET_STRING* signature = CMS_SignerInfo_get0_signature(signerInfo);
+                std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> ctx(
+                        key ? EVP_PKEY_CTX_new(key, nullptr) : nullptr, &EVP_PKEY_CTX_free);
+                bool ok = ctx && signature && EVP_PKEY_verify_init(ctx.get()) == 1 &&
+                          EVP_PKEY_CTX_set_signature_md(ctx.get(), md) == 1 &&
+                          EVP_PKEY_verify(ctx.get(), ASN1_STRING_get0_data(signature),
+                                          static_cast<size_t>(ASN1_STRING_length(signature)), digest, digestLength) == 1;
+                result.digestValid = ok;
+                result.signatureValid = ok;
+                if (!ok) result.error = OpenSslError("Chữ ký không đúng.");
+            }
+            ERR_clear_error();
+        }
+
+        // Kiểm tra mọi signer trên digest nội dung (đã đưa vào [contentDigest]).
+        // Hợp lệ khi tất cả đều đúng; lỗi báo signer sai đầu tiên.
+        void CheckSigners(const ParsedCms& parsed, EVP_MD_CTX* contentDigest, SignatureVerification& result) {
+            uint8_t digest[EVP_MAX_MD_SIZE];
+            unsigned int digestLength = 0;
+            if (EVP_DigestFinal_ex(contentDigest, digest, &digestLength) != 1) {
+                throw std::runtime_error("EVP_DigestFinal_ex failed.");
+            }
+
+            result.digestValid = true;
+            result.signatureValid = true;
+            for (size_t i = 0; i < parsed.signerInfos.size(); ++i) {
+                SignatureVerification signer;
+                CheckSignerInfo(parsed.signerInfos[i], parsed.md, digest, digestLength, signer);
+                result.digestValid = result.digestValid && signer.digestValid;
+                result.signatureValid = result.signatureValid && signer.signatureValid;
+                if (result.error.empty() && !signer.error.empty()) {
+                    result.error = parsed.signerInfos.size() > 1
+                                           ? "SignerInfo " + std::to_string(i + 1) + ": " + signer.error
+                                           : signer.error;
+                }
+            }
+            result.valid = result.digestValid && result.signatureValid;
+        }
+
+        int HexValue(char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        // Chuỗi hex "<...>" trong khoảng trống của ByteRange sang byte.
+        std::vector<uint8_t> DecodeContents(const uint8_t* data, size_t size) {
+            if (size < 2 || data[0] != '<' || data[size - 1] != '>') {
+                throw std::runtime_error("Khoảng trống của ByteRange không phải /Contents.");
+            }
+            // Chữ ký do engine ghi là hex liền, độ dài chẵn: giải mã một lượt.
+            std::vector<uint8_t> bytes((size - 2) / 2);
+            if ((size - 2) % 2 == 0 &&
+                DecodeHex(reinterpret_cast<const char*>(data + 1), size - 2, bytes.data())) {
+                return bytes;
+            }
+            // Còn lại theo PDF: bỏ qua khoảng trắng, nibble lẻ cuối cùng coi như có 0 theo sau.
+            bytes.clear();
+            int high = -1;
+            for (size_t i = 1; i + 1 < size; ++i) {
+                char c = static_cast<char>(data[i]);
+                if (std::isspace(static_cast<unsigned char>(c))) continue;
+                int value = HexValue(c);
+                if (value < 0) throw std::runtime_error("/Contents không phải chuỗi hex.");
+                if (high < 0) {
+                    high = value;
+                } else {
+                    bytes.push_back(static_cast<uint8_t>((high << 4) | value));
+                    high = -1;
+                }
+            }
+            if (high >= 0) bytes.push_back(static_cast<uint8_t>(high << 4));
+            return bytes;
+        }
+
+        // Dự phòng khi không đọc được cấu trúc tài liệu (xref hỏng, mã hóa...):
+        // /Contents của chữ ký không bao giờ bị nén hay mã hóa, nên tìm thẳng
+        // các mảng /ByteRange trong file.
+        std::vector<LazyPdfSignature> ScanSignatures(const std::vector<uint8_t>& pdf) {
+            static const char kKey[] = "/ByteRange";
+            const size_t keyLength = sizeof(kKey) - 1;
+            std::vector<LazyPdfSignature> signatures;
+            std::set<std::vector<long long>> seen;
+
+            auto it = pdf.begin();
+            while ((it = std::search(it, pdf.end(), kKey, kKey + keyLength)) != pdf.end()) {
+                size_t pos = static_cast<size_t>(it - pdf.begin()) + keyLength;
+                it += keyLength;
+                while (pos < pdf.size() && std::isspace(pdf[pos])) ++pos;
+                if (pos >= pdf.size() || pdf[pos] != '[') continue;
+                ++pos;
+
+                std::vector<long long> ranges;
+                while (ranges.size() < 4) {
+                    while (pos < pdf.size() && std::isspace(pdf[pos])) ++pos;
+                    if (pos >= pdf.size() || !std::isdigit(pdf[pos])) break;
+                    long long value = 0;
+                    while (pos < pdf.size() && std::isdigit(pdf[pos]) && value < (1LL << 50)) {
+                        value = value * 10 + (pdf[pos++] - '0');
+                    }
+                    ranges.push_back(value);
+                }
+                while (pos < pdf.size() && std::isspace(pdf[pos])) ++pos;
+                if (ranges.size() != 4 || pos >= pdf.size() || pdf[pos] != ']') continue;
+                if (!seen.insert(ranges).second) continue;
+
+                LazyPdfSignature signature;
+                signature.byteRange = std::move(ranges);
+                signatures.push_back(std::move(signature));
+            }
+            return signatures;
+        }
+
+        std::vector<LazyPdfSignature> FindSignatures(const std::vector<uint8_t>& pdf) {
+            try {
+                LazyPdfReader reader(pdf.data(), pdf.size());
+                return FindPdfSignatures(reader);
+            } catch (const LazyPdfUnsupported&) {
+                return ScanSignatures(pdf);
+            }
+        }
+
+        SignatureVerification VerifyPdfSignature(const std::vector<uint8_t>& pdf, const LazyPdfSignature& signature) {
+            SignatureVerification result;
+            result.fieldName = signature.fieldName;
+            result.subFilter = signature.subFilter;
+            result.pdfSigningTime = signature.signingTime;
+            try {
+                const auto& ranges = signature.byteRange;
+                if (ranges.size() != 4 || ranges[0] != 0 || ranges[1] < 0 || ranges[2] < ranges[1] || ranges[3] < 0 ||
+                    static_cast<unsigned long long>(ranges[2]) + static_cast<unsigned long long>(ranges[3]) > pdf.size()) {
+                    throw std::runtime_error("ByteRange không hợp lệ.");
+                }
+                const size_t gapStart = static_cast<size_t>(ranges[1]);
+                const size_t gapEnd = static_cast<size_t>(ranges[2]);
+                const size_t tailLength = static_cast<size_t>(ranges[3]);
+                result.coversWholeDocument = gapEnd + tailLength == pdf.size();
+
+                PhaseTimer verifyTimer;
+                std::vector<uint8_t> der = DecodeContents(pdf.data() + gapStart, gapEnd - gapStart);
+                ParsedCms parsed = ParseCms(der.data(), der.size(), result);
+                const ASN1_OCTET_STRING* encapsulated = EncapsulatedContent(parsed);
+                if (encapsulated && OBJ_obj2nid(CMS_get0_eContentType(parsed.cms.get())) == NID_id_smime_ct_TSTInfo) {
+                    throw std::runtime_error("Chưa hỗ trợ kiểm tra dấu thời gian tài liệu (ETSI.RFC3161).");
+                }
+                int64_t parseUs = verifyTimer.ElapsedUs();
+
+                // Băm hai đoạn của ByteRange ngay trên buffer, không chép.
+                PhaseTimer hashTimer;
+                MdCtxPtr contentDigest{nullptr, &EVP_MD_CTX_free};
+                if (encapsulated) {
+                    // adbe.pkcs7.sha1: nội dung được ký là SHA-1 của ByteRange.
+                    MdCtxPtr sha1 = NewDigest(EVP_sha1());
+                    uint8_t rangeDigest[EVP_MAX_MD_SIZE];
+                    unsigned int rangeDigestLength = 0;
+                    if (EVP_DigestUpdate(sha1.get(), pdf.data(), gapStart) != 1 ||
+                        EVP_DigestUpdate(sha1.get(), pdf.data() + gapEnd, tailLength) != 1 ||
+                        EVP_DigestFinal_ex(sha1.get(), rangeDigest, &rangeDigestLength) != 1) {
+                        throw std::runtime_error("EVP_DigestUpdate failed.");
+                    }
+                    if (static_cast<unsigned int>(ASN1_STRING_length(encapsulated)) != rangeDigestLength ||
+                        std::memcmp(ASN1_STRING_get0_data(encapsulated), rangeDigest, rangeDigestLength) != 0) {
+                        result.hashUs = hashTimer.ElapsedUs();
+                        throw std::runtime_error("Digest ByteRange không khớp nội dung nhúng trong CMS.");
+                    }
+                    contentDigest = NewDigest(parsed.md);
+                    if (EVP_DigestUpdate(contentDigest.get(), ASN1_STRING_get0_data(encapsulated),
+                                         static_cast<size_t>(ASN1_STRING_length(encapsulated))) != 1) {
+                        throw std::runtime_error("EVP_DigestUpdate failed.");
+                    }
+                } else {
+                    contentDigest = NewDigest(parsed.md);
+                    if (EVP_DigestUpdate(contentDigest.get(), pdf.data(), gapStart) != 1 ||
+                        EVP_DigestUpdate(contentDigest.get(), pdf.data() + gapEnd, tailLength) != 1) {
+                        throw std::runtime_error("EVP_DigestUpdate failed.");
+                    }
+                }
+                result.hashUs = hashTimer.ElapsedUs();
+
+                PhaseTimer checkTimer;
+                CheckSigners(parsed, contentDigest.get(), result);
+                result.verifyUs = parseUs + checkTimer.ElapsedUs();
+            } catch (const std::exception& e) {
+                result.valid = false;
+                result.error = e.what();
+                ERR_clear_error();
+            }
+            return result;
+        }
+
+        // Phân tích CMS rồi để [feed] đưa nội dung vào digest.
+        template <typename Feed>
+        SignatureVerification VerifyCmsWith(const std::vector<uint8_t>& cms, const Feed& feed) {
+            SignatureVerification result;
+            try {
+                PhaseTimer parseTimer;
+                ParsedCms parsed = ParseCms(cms.data(), cms.size(), result);
+                int64_t parseUs = parseTimer.ElapsedUs();
+
+                PhaseTimer hashTimer;
+                MdCtxPtr contentDigest = NewDigest(parsed.md);
+                feed(parsed, contentDigest.get());
+                result.hashUs = hashTimer.ElapsedUs();
+
+                PhaseTimer checkTimer;
+                CheckSigners(parsed, contentDigest.get(), result);
+                result.verifyUs = parseUs + checkTimer.ElapsedUs();
+            } catch (const std::exception& e) {
+                result.valid = false;
+                result.error = e.what();
+                ERR_clear_error();
+            }
+            return result;
+        }
+
+    }  // namespace
+
+    std::vector<SignatureVerification> VerifyPdf(const std::vector<uint8_t>& pdf, size_t threads) {
+        std::vector<LazyPdfSignature> signatures = FindSignatures(pdf);
+        std::vector<SignatureVerification> results(signatures.size());
+        ParallelFor(signatures.size(), threads, [&](size_t index) {
+            results[index] = VerifyPdfSignature(pdf, signatures[index]);
+        });
+        return results;
+    }
+
+    std::vector<PdfVerification> VerifyPdfBatch(const std::vector<std::vector<uint8_t>>& pdfs, size_t threads) {
+        std::vector<PdfVerification> results(pdfs.size());
+        std::vector<std::vector<LazyPdfSignature>> signatures(pdfs.size());
+
+        // Lượt 1: đọc cấu trúc từng tài liệu. Lượt 2: mọi chữ ký của cả lô vào
+        // chung một hàng đợi, để tài liệu nhiều chữ ký không giữ một luồng.
+        ParallelFor(pdfs.size(), threads, [&](size_t index) {
+            PhaseTimer parseTimer;
+            try {
+                signatures[index] = FindSignatures(pdfs[index]);
+                results[index].signatures.resize(signatures[index].size());
+            } catch (const std::exception& e) {
+                results[index].error = e.what();
+            }
+            results[index].parseUs = parseTimer.ElapsedUs();
+        });
+
+        std::vector<std::pair<size_t, size_t>> jobs;
+        for (size_t document = 0; document < pdfs.size(); ++document) {
+            for (size_t signature = 0; signature < signatures[document].size(); ++signature) {
+                jobs.emplace_back(document, signature);
+            }
+        }
+        ParallelFor(jobs.size(), threads, [&](size_t index) {
+            size_t document = jobs[index].first;
+            size_t signature = jobs[index].second;
+            results[document].signatures[signature] = VerifyPdfSignature(pdfs[document], signatures[document][signature]);
+        });
+        return results;
+    }
+
+    SignatureVerification VerifyCms(const std::vector<uint8_t>& cms, const uint8_t* content, size_t contentSize) {
+        return VerifyCmsWith(cms, [content, contentSize](const ParsedCms& parsed, EVP_MD_CTX* ctx) {
+            const uint8_t* data = content;
+            size_t size = contentSize;
+            if (!data) {
+                const ASN1_OCTET_STRING* encapsulated = EncapsulatedContent(parsed);
+                if (!encapsulated) throw std::runtime_error("Chữ ký tách rời cần nội dung được ký.");
+                data = ASN1_STRING_get0_data(encapsulated);
+                size = static_cast<size_t>(ASN1_STRING_length(encapsulated));
+            }
+            if (EVP_DigestUpdate(ctx, data, size) != 1) throw std::runtime_error("EVP_DigestUpdate failed.");
+        });
+    }
+
+    SignatureVerification VerifyCmsFile(const std::vector<uint8_t>& cms, const std::string& path) {
+        return VerifyCmsWith(cms, [&path](const ParsedCms&, EVP_MD_CTX* ctx) {
+            UpdateDigestFromFile(ctx, path);
+        });
+    }
+
+    bool VerifySignature(const std::vector<uint8_t>& certificate, const std::vector<uint8_t>& data,
+                         const std::vector<uint8_t>& signature, const std::string& digestAlgorithm) {
+        const unsigned char* cursor = certificate.data();
+        std::unique_ptr<X509, decltype(&X509_free)> x509(
+                d2i_X509(nullptr, &cursor, static_cast<long>(certificate.size())), &X509_free);
+        if (!x509) throw std::runtime_error(OpenSslError("Certificate không hợp lệ."));
+        std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(X509_get_pubkey(x509.get()), &EVP_PKEY_free);
+        if (!key || EVP_PKEY_base_id(key.get()) != EVP_PKEY_RSA) {
+            throw std::runtime_error("Chỉ hỗ trợ khóa RSA.");
+        }
+
+        bool valid = false;
+        if (digestAlgorithm.empty()) {
+            // Thẻ chỉ thêm padding PKCS#1 vào dữ liệu nhận được: khôi phục và so sánh.
+            std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> ctx(EVP_PKEY_CTX_new(key.get(), nullptr),
+                                                                            &EVP_PKEY_CTX_free);
+            if (!ctx || EVP_PKEY_verify_recover_init(ctx.get()) != 1 ||
+                EVP_PKEY_CTX_set_rsa_padding(ctx.get(), RSA_PKCS1_PADDING) != 1) {
+                throw std::runtime_error(OpenSslError("EVP_PKEY_verify_recover_init failed."));
+            }
+            std::vector<uint8_t> recovered(static_cast<size_t>(EVP_PKEY_size(key.get())));
+            size_t recoveredLength = recovered.size();
+            if (EVP_PKEY_verify_recover(ctx.get(), recovered.data(), &recoveredLength,
+                                        signature.data(), signature.size()) == 1) {
+                valid = recoveredLength == data.size() && std::equal(data.begin(), data.end(), recovered.begin());
+            }
+        } else {
+            const EVP_MD* md = EVP_get_digestbyname(digestAlgorithm.c_str());
+            if (!md) throw std::runtime_error("Thuật toán digest không được hỗ trợ: " + digestAlgorithm);
+            MdCtxPtr ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+            if (!ctx || EVP_DigestVerifyInit(ctx.get(), nullptr, md, nullptr, key.get()) != 1 ||
+                EVP_DigestVerifyUpdate(ctx.get(), data.data(), data.size()) != 1) {
+                throw std::runtime_error(OpenSslError("EVP_DigestVerifyInit failed."));
+            }
+            valid = EVP_DigestVerifyFinal(ctx.get(), signature.data(), signature.size()) == 1;
+        }
+        ERR_clear_error();
+        return valid;
+    }
+
+}  // namespace nfcsigner
@@ -0,0 +1,65 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_SIGNATURE_VERIFY_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_SIGNATURE_VERIFY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace nfcsigner {
+
+    // Kết quả kiểm tra một chữ ký CMS. Chỉ đối chiếu với certificate nhúng
+    // trong chữ ký; không dựng chuỗi tin cậy hay kiểm tra thu hồi. CMS có
+    // nhiều SignerInfo chỉ hợp lệ khi mọi signer đều đúng; signer,
+    // certificate và signingTime lấy từ signer đầu tiên.
+    struct SignatureVerification {
+        std::string fieldName;          // field chữ ký (chỉ với PDF)
+        std::string subFilter;          // /SubFilter (chỉ với PDF)
+        bool valid = false;             // digestValid && signatureValid
+        bool digestValid = false;       // digest nội dung khớp messageDigest
+        bool signatureValid = false;    // chữ ký RSA trên signedAttrs đúng
+        // ByteRange phủ tới cuối file: không có gì được thêm sau chữ ký này.
+        bool coversWholeDocument = false;
+        std::string digestAlgorithm;    // "sha256"...
+        std::string signer;             // subject của certificate (RFC 2253)
+        std::vector<uint8_t> certificate;
+        std::time_t signingTime = 0;    // thuộc tính signingTime, 0 nếu không có
+        std::string pdfSigningTime;     // /M của từ điển chữ ký (chỉ với PDF)
+        std::string error;              // lý do nếu !valid
+        int64_t hashUs = 0;             // băm nội dung được ký
+        int64_t verifyUs = 0;           // phân tích CMS và kiểm tra chữ ký
+    };
+
+    struct PdfVerification {
+        std::vector<SignatureVerification> signatures;
+        std::string error;              // tài liệu không đọc được
+        int64_t parseUs = 0;            // đọc cấu trúc và tìm chữ ký
+    };
+
+    // Kiểm tra mọi chữ ký của [pdf]. Các chữ ký được băm và kiểm tra song song
+    // trên [threads] luồng (0: theo số lõi CPU), kết quả theo thứ tự field.
+    // Ném std::runtime_error nếu không đọc được cấu trúc tài liệu.
+    std::vector<SignatureVerification> VerifyPdf(const std::vector<uint8_t>& pdf, size_t threads = 0);
+
+    // Như trên cho nhiều tài liệu; chữ ký của mọi tài liệu dùng chung một nhóm
+    // luồng. Tài liệu hỏng chỉ làm hỏng kết quả của nó.
+    std::vector<PdfVerification> VerifyPdfBatch(const std::vector<std::vector<uint8_t>>& pdfs, size_t threads = 0);
+
+    // Kiểm tra SignedData [cms] trên nội dung [content] (chữ ký tách rời). Nếu
+    // [content] là nullptr thì dùng nội dung nhúng trong chữ ký.
+    SignatureVerification VerifyCms(const std::vector<uint8_t>& cms, const uint8_t* content, size_t contentSize);
+
+    // Như trên với nội dung là file (đường dẫn UTF-8), đọc theo từng khối.
+    SignatureVerification VerifyCmsFile(const std::vector<uint8_t>& cms, const std::string& path);
+
+    // Kiểm tra chữ ký RSA PKCS#1 v1.5 thô bằng khóa công khai của [certificate].
+    // [digestAlgorithm] rỗng: [data] là đúng dữ liệu đã gửi cho thẻ (thường là
+    // DigestInfo, như generateSignature); ngược lại [data] được băm bằng thuật
+    // toán đó ("sha256"...). Ném std::runtime_error nếu đầu vào không hợp lệ.
+    bool VerifySignature(const std::vector<uint8_t>& certificate, const std::vector<uint8_t>& data,
+                         const std::vector<uint8_t>& signature, const std::string& digestAlgorithm);
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_SIGNATURE_VERIFY_H_
@@ -0,0 +1,179 @@
+#include "signing_card.h"
+
+#include "card_apdu.h"
+#include "cancellation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace nfcsigner {
+
+    namespace {
+
+        // SW1/SW2 = 90 00
+        bool IsSuccess(const std::vector<uint8_t>& response) {
+            return response.size() >= 2 && response[response.size() - 2] == 0x90 && response.back() == 0x00;
+        }
+
+    }  // namespace
+
+    class PcscSigningCard::Channel : public CardChannel {
+    public:
+        Channel(PcscSigningCard& card, const std::string& appletID) : card_(card), appletID_(appletID) {}
+
+        ~Channel() override {
+            std::fill(pin_.begin(), pin_.end(), '\0');
+        }
+
+        // Giữ thẻ cho cả lượt rồi SELECT applet.
+        void Open() {
+            // Tiến trình khác dùng thẻ giữa các lượt, không chen vào trong lượt.
+            transaction_ = std::make_unique<CardTransaction>(card_.hCard_);
+            if (transaction_->CardReinserted()) card_.certificates_.clear();
+            // Mỗi lượt SELECT lại: request trước có thể đã chọn applet khác.
+            auto select_resp = TransmitAndGetResponse(card_.hCard_, CreateSelectAppletCommand(appletID_));
+            if (!IsSuccess(select_resp)) throw std::runtime_error("Select Applet failed.");
+        }
+
+        // Kết nối dùng chung cho mọi client: reset thẻ sau lượt có VERIFY để
+        // lượt sau (có thể của tiến trình khác) phải xác thực PIN lại.
+        void Close() {
+            transaction_->End(pin_verified_ ? SCARD_RESET_CARD : SCARD_LEAVE_CARD);
+        }
+
+        std::vector<uint8_t> ReadCertificate() override {
+            const auto& cached = card_.certificates_[appletID_];
+            if (!cached.empty()) return cached;
+            return Resumable([this]() {
+                auto certificate = ReadCertificateFromCard();
+                card_.certificates_[appletID_] = certificate;
+                return certificate;
+            });
+        }
+
+        std::vector<uint8_t> ReadRsaPublicKey(const std::string& keyRole) override {
+            return Resumable([&]() {
+                auto key_resp = TransmitAndGetResponse(card_.hCard_, CreateGetRsaPublicKeyCommand(keyRole));
+                if (!IsSuccess(key_resp)) throw std::runtime_error("Get Public Key failed.");
+                return std::vector<uint8_t>(key_resp.begin(), key_resp.end() - 2);
+            });
+        }
+
+        void VerifyPin(const std::string& pin) override {
+            // Dừng trước VERIFY nếu request đã bị hủy: không tốn một lần thử PIN.
+            ThrowIfCancelled();
+            pin_verified_ = true;
+            auto verify_resp = TransmitAndGetResponse(card_.hCard_, CreateVerifyPinCommand(pin));
+            if (!IsSuccess(verify_resp)) throw std::runtime_error("Verify PIN failed.");
+            pin_ = pin;
+        }
+
+        std::vector<uint8_t> ComputeSignature(const std::vector<uint8_t>& data, int keyIndex) override {
+            return Resumable([&]() {
+                auto sign_resp = TransmitAndGetResponse(card_.hCard_, CreateComputeSignatureCommand(data, keyIndex));
+                if (!IsSuccess(sign_resp)) throw std::runtime_error("Compute signature failed on card.");
+                return std::vector<uint8_t>(sign_resp.begin(), sign_resp.end() - 2);
+            });
+        }
+
+    private:
+        std::vector<uint8_t> ReadCertificateFromCard() {
+            auto select_cert_resp = TransmitAndGetResponse(card_.hCard_, CreateSelectCertificateCommand());
+            if (!IsSuccess(select_cert_resp)) throw std::runtime_error("Select Certificate data object failed.");
+            auto cert_resp = TransmitAndGetResponse(card_.hCard_, CreateGetCertificateCommand());
+            if (!IsSuccess(cert_resp) || cert_resp.size() < 3) throw std::runtime_error("Get Certificate failed.");
+            return std::vector<uint8_t>(cert_resp.begin(), cert_resp.end() - 2);
+        }
+
+        // TransmitAndGetResponse tự phục hồi khi thẻ bị reset. Reader biến mất
+        // hoặc thẻ được rút ra sau VERIFY thì cần kết nối mới: mở lại rồi chạy
+        // lại [apdus] một lần, nên lô ký tiếp tục từ tài liệu đang dở.
+        template<typename Func>
+        std::vector<uint8_t> Resumable(Func&& apdus) {
+            try {
+                return apdus();
+            } catch (const PcscError& e) {
+                bool reconnectable = e.Kind() == PcscErrorKind::ConnectionLost || e.Kind() == PcscErrorKind::CardRemoved;
+                if (!reconnectable || GetCardRecoveryPolicy().maxAttempts <= 0) throw;
+            }
+            Reopen();
+            return apdus();
+        }
+
+        void Reopen() {
+            CardRecoveryPolicy policy = GetCardRecoveryPolicy();
+            std::vector<uint8_t> certificate = card_.certificates_[appletID_];
+            transaction_.reset();
+            card_.certificates_.clear();
+            DisconnectCard(card_.hContext_, card_.hCard_, SCARD_LEAVE_CARD);
+
+            // Reader USB cắm lại hoặc dịch vụ PC/SC khởi động lại cần một lúc.
+            int backoffMs = std::max(0, policy.initialBackoffMs);
+            for (int attempt = 1;; ++attempt) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(backoffMs));
+                backoffMs *= 2;
+                ThrowIfCancelled();
+                try {
+                    ConnectFirstReader(card_.hContext_, card_.hCard_);
+                    break;
+                } catch (const std::runtime_error&) {
+                    DisconnectCard(card_.hContext_, card_.hCard_, SCARD_LEAVE_CARD);
+                    if (attempt >= policy.maxAttempts) throw;
+                }
+            }
+            Open();
+            if (!pin_verified_) return;
+
+            // Chỉ gửi lại PIN cho đúng thẻ đã xác thực: đối chiếu certificate.
+            if (pin_.empty()) throw std::runtime_error("Verify PIN failed.");
+            if (!policy.allowPinReplay) throw std::runtime_error("Card connection was lost after VERIFY PIN and PIN replay is disabled.");
+            if (certificate.empty()) throw std::runtime_error("Card connection was lost after VERIFY PIN; cannot confirm it is the same card.");
+            if (ReadCertificateFromCard() != certificate) throw std::runtime_error("A different card was inserted; not re-sending the PIN.");
+            card_.certificates_[appletID_] = certificate;
+            auto verify_resp = TransmitAndGetResponse(card_.hCard_, CreateVerifyPinCommand(pin_));
+            if (!IsSuccess(verify_resp)) throw std::runtime_error("Verify PIN failed after reconnect.");
+        }
+
+        PcscSigningCard& card_;
+        std::string appletID_;
+        std::unique_ptr<CardTransaction> transaction_;
+        std::string pin_;
+        bool pin_verified_ = false;
+    };
+
+    PcscSigningCard::~PcscSigningCard() {
+        // Reset thẻ để trạng thái đã VERIFY PIN không còn sau khi dịch vụ dừng.
+        DisconnectCard(hContext_, hCard_, SCARD_RESET_CARD);
+    }
+
+    void PcscSigningCard::WithChannel(const std::string& appletID, CardPriority priority,
+                                      const std::function<void(CardChannel&)>& operation) {
+        CardScheduler::Ticket ticket = CardScheduler::Instance().Acquire(priority);
+        if (!ticket) throw CardBusyError(priority);
+
+        try {
+            if (!hCard_) {
+                certificates_.clear();
+                ConnectFirstReader(hContext_, hCard_);
+            }
+            // Hủy request đánh thức các lệnh PC/SC đang chờ trên context này.
+            SCARDCONTEXT hContext = hContext_;
+            CancelCallbackGuard cancelWaits(CurrentCancellation(), [hContext]() { SCardCancel(hContext); });
+            ThrowIfCancelled();
+
+            Channel channel(*this, appletID);
+            channel.Open();
+            operation(channel);
+            channel.Close();
+        } catch (...) {
+            // Thẻ có thể đã bị rút hoặc thay: lượt sau kết nối và đọc lại từ đầu.
+            certificates_.clear();
+            DisconnectCard(hContext_, hCard_, SCARD_RESET_CARD);
+            throw;
+        }
+    }
+
+}  // namespace nfcsigner
@@ -0,0 +1,68 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_SIGNING_CARD_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_SIGNING_CARD_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "card_scheduler.h"
+#include "pcsc_card.h"
+
+namespace nfcsigner {
+
+    // Các thao tác trên thẻ trong một lượt giữ reader, sau khi đã SELECT applet.
+    class CardChannel {
+    public:
+        virtual ~CardChannel() = default;
+
+        virtual std::vector<uint8_t> ReadCertificate() = 0;
+        // Template 7F49 (81 modulus, 82 exponent) như thẻ trả về.
+        virtual std::vector<uint8_t> ReadRsaPublicKey(const std::string& keyRole) = 0;
+        virtual void VerifyPin(const std::string& pin) = 0;
+        // COMPUTE SIGNATURE trên [data] (DigestInfo), trả về chữ ký RSA thô.
+        virtual std::vector<uint8_t> ComputeSignature(const std::vector<uint8_t>& data, int keyIndex) = 0;
+    };
+
+    // Thẻ ký dùng cho dịch vụ headless: thẻ thật qua PC/SC hoặc thẻ mềm
+    // (software_card.h) để chạy thử cục bộ.
+    class SigningCard {
+    public:
+        virtual ~SigningCard() = default;
+
+        // Chờ lượt của [priority] trên CardScheduler, SELECT [appletID] rồi chạy
+        // [operation]. Ném CardBusyError nếu hàng đợi đầy.
+        virtual void WithChannel(const std::string& appletID, CardPriority priority,
+                                 const std::function<void(CardChannel&)>& operation) = 0;
+    };
+
+    // Thẻ trên reader PC/SC đầu tiên. Kết nối được giữ giữa các request (không
+    // SCardConnect lại mỗi lần), mỗi lượt là một CardTransaction và certificate
+    // đã đọc được nhớ theo applet. Reader mất kết nối hoặc thẻ được cắm lại
+    // giữa lượt thì kết nối lại, xác thực lại nếu vẫn đúng certificate và chạy
+    // tiếp (CardRecoveryPolicy). Lỗi khác trong một lượt thì đóng kết nối và
+    // bỏ cache: thẻ có thể đã bị rút hoặc thay.
+    class PcscSigningCard : public SigningCard {
+    public:
+        PcscSigningCard() = default;
+        ~PcscSigningCard() override;
+
+        PcscSigningCard(const PcscSigningCard&) = delete;
+        PcscSigningCard& operator=(const PcscSigningCard&) = delete;
+
+        void WithChannel(const std::string& appletID, CardPriority priority,
+                         const std::function<void(CardChannel&)>& operation) override;
+
+    private:
+        class Channel;
+
+        // Chỉ truy cập khi đang giữ Ticket của CardScheduler.
+        SCARDCONTEXT hContext_ = 0;
+        SCARDHANDLE hCard_ = 0;
+        std::map<std::string, std::vector<uint8_t>> certificates_;
+    };
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_SIGNING_CARD_H_
@@ -0,0 +1,32 @@
+#include "signing_metrics.h"
+
+namespace nfcsigner {
+
+    SigningMetrics& SigningMetrics::Instance() {
+        static SigningMetrics instance;
+        return instance;
+    }
+
+    void SigningMetrics::Record(const SignPdfMetrics& metrics) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_ = metrics;
+        ++count_;
+        total_overlap_saved_us_ += metrics.OverlapSavedUs();
+    }
+
+    SignPdfMetrics SigningMetrics::GetLast() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_;
+    }
+
+    size_t SigningMetrics::GetCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return count_;
+    }
+
+    int64_t SigningMetrics::GetTotalOverlapSavedUs() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return total_overlap_saved_us_;
+    }
+
+}  // namespace nfcsigner
@@ -0,0 +1,69 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_SIGNING_METRICS_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_SIGNING_METRICS_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace nfcsigner {
+
+    // Thời gian từng pha của một lần signPdf, tính bằng micro giây.
+    //
+    // Phần trên thẻ (SELECT, đọc certificate, VERIFY) chạy song song với phần
+    // chuẩn bị PDF (đọc cấu trúc, appearance); hai nhánh gặp nhau trước khi
+    // dựng CMS.
+    struct SignPdfMetrics {
+        int64_t cardPreambleUs = 0;   // SELECT applet + SELECT DATA + GET certificate
+        int64_t verifyPinUs = 0;
+        int64_t pdfParseUs = 0;       // đọc xref/trang đích (hoặc nạp toàn bộ bằng PoDoFo)
+        int64_t pdfPrepareUs = 0;     // toàn bộ nhánh PDF, gồm cả pdfParseUs
+        int64_t joinWaitUs = 0;       // nhánh thẻ chờ nhánh PDF
+        int64_t parallelUs = 0;       // từ lúc tách nhánh tới lúc gặp nhau
+        int64_t signUs = 0;           // CMS + COMPUTE SIGNATURE + ghi PDF
+        int64_t totalUs = 0;
+        bool incremental = false;
+
+        // Thời gian tiết kiệm so với chạy tuần tự hai nhánh.
+        int64_t OverlapSavedUs() const {
+            return cardPreambleUs + verifyPinUs + pdfPrepareUs - parallelUs;
+        }
+    };
+
+    // Đo thời gian trôi qua kể từ lúc tạo.
+    class PhaseTimer {
+    public:
+        PhaseTimer() : start_(std::chrono::steady_clock::now()) {}
+
+        int64_t ElapsedUs() const {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start_).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    // Lưu số liệu của lần ký gần nhất và cộng dồn cho cả tiến trình.
+    class SigningMetrics {
+    public:
+        static SigningMetrics& Instance();
+
+        void Record(const SignPdfMetrics& metrics);
+
+        SignPdfMetrics GetLast() const;
+        size_t GetCount() const;
+        int64_t GetTotalOverlapSavedUs() const;
+
+    private:
+        SigningMetrics() = default;
+
+        mutable std::mutex mutex_;
+        SignPdfMetrics last_;
+        size_t count_ = 0;
+        int64_t total_overlap_saved_us_ = 0;
+    };
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_SIGNING_METRICS_H_
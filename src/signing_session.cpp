@@ -0,0 +1,192 @@
+#include "signing_session.h"
+
+#ifdef HAVE_PODOFO
+
+#include "card_apdu.h"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace nfcsigner {
+
+    namespace {
+
+        bool IsSuccess(const std::vector<uint8_t>& response) {
+            return response.size() >= 2 && response[response.size() - 2] == 0x90 && response.back() == 0x00;
+        }
+
+        // SW 6982: security status not satisfied - thẻ không còn trạng thái đã VERIFY PIN.
+        bool IsSecurityStatusNotSatisfied(const std::vector<uint8_t>& response) {
+            return response.size() >= 2 && response[response.size() - 2] == 0x69 && response.back() == 0x82;
+        }
+
+        // Gửi COMPUTE SIGNATURE trong một transaction. [reset] = true nếu thẻ đã
+        // bị reset mà không phục hồi được tại chỗ; lỗi PC/SC khác được ném lại.
+        std::vector<uint8_t> TransmitSignature(SigningSession& session, const std::vector<uint8_t>& command, bool& reset) {
+            reset = false;
+            try {
+                CardTransaction transaction(session.hCard);
+                return TransmitAndGetResponse(session.hCard, command);
+            } catch (const PcscError& e) {
+                if (e.Code() != SCARD_W_RESET_CARD) throw;
+                reset = true;
+                return {};
+            }
+        }
+
+        // Kết nối lại, xác nhận vẫn là thẻ của phiên, VERIFY PIN lại rồi ký,
+        // trong cùng một transaction để tiến trình khác không chen vào giữa.
+        std::vector<uint8_t> ReauthenticateAndSign(SigningSession& session, const std::vector<uint8_t>& command) {
+            ReconnectSession(session);
+            CardTransaction transaction(session.hCard);
+            if (ReadSessionCertificate(session) != session.certificate) {
+                throw std::runtime_error("Card certificate changed since the signing session was opened.");
+            }
+            auto verify_resp = TransmitAndGetResponse(session.hCard, CreateVerifyPinCommand(session.pin));
+            if (!IsSuccess(verify_resp)) throw std::runtime_error("Verify PIN failed.");
+            return TransmitAndGetResponse(session.hCard, command);
+        }
+
+    }  // namespace
+
+    SigningSessionRegistry& SigningSessionRegistry::Instance() {
+        static SigningSessionRegistry instance;
+        return instance;
+    }
+
+    SigningSessionRegistry::~SigningSessionRegistry() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        changed_.notify_all();
+        if (sweeper_.joinable()) sweeper_.join();
+    }
+
+    int64_t SigningSessionRegistry::Add(std::shared_ptr<SigningSession> session) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t handle = next_handle_++;
+        sessions_[handle] = Entry{ std::move(session), std::chrono::steady_clock::now() };
+        // Luồng quét chỉ tạo khi có phiên đầu tiên.
+        if (!sweeper_.joinable()) sweeper_ = std::thread([this]() { RunSweeper(); });
+        changed_.notify_all();
+        return handle;
+    }
+
+    std::shared_ptr<SigningSession> SigningSessionRegistry::Get(int64_t handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sessions_.find(handle);
+        if (it == sessions_.end()) return nullptr;
+        it->second.lastUsed = std::chrono::steady_clock::now();
+        return it->second.session;
+    }
+
+    bool SigningSessionRegistry::Remove(int64_t handle) {
+        // Khai báo trước khóa: phiên (và kết nối thẻ) được giải phóng sau khi nhả khóa.
+        std::shared_ptr<SigningSession> removed;
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sessions_.find(handle);
+        if (it == sessions_.end()) return false;
+        removed = std::move(it->second.session);
+        sessions_.erase(it);
+        return true;
+    }
+
+    void SigningSessionRegistry::SetIdleTimeout(std::chrono::milliseconds timeout) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            idle_timeout_ = timeout.count() > 0 ? timeout : std::chrono::milliseconds(0);
+        }
+        changed_.notify_all();
+    }
+
+    std::chrono::milliseconds SigningSessionRegistry::GetIdleTimeout() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return idle_timeout_;
+    }
+
+    size_t SigningSessionRegistry::SweepIdle(std::chrono::steady_clock::time_point now) {
+        std::vector<std::shared_ptr<SigningSession>> expired;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            expired = TakeIdle(now);
+        }
+        return expired.size();
+    }
+
+    size_t SigningSessionRegistry::GetCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sessions_.size();
+    }
+
+    std::vector<std::shared_ptr<SigningSession>> SigningSessionRegistry::TakeIdle(
+            std::chrono::steady_clock::time_point now) {
+        std::vector<std::shared_ptr<SigningSession>> expired;
+        if (idle_timeout_.count() == 0) return expired;
+        for (auto it = sessions_.begin(); it != sessions_.end();) {
+            if (now - it->second.lastUsed >= idle_timeout_) {
+                std::cout << "Signing session " << it->first << " closed after being idle." << std::endl;
+                expired.push_back(std::move(it->second.session));
+                it = sessions_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return expired;
+    }
+
+    void SigningSessionRegistry::RunSweeper() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            if (sessions_.empty() || idle_timeout_.count() == 0) {
+                changed_.wait(lock);
+                continue;
+            }
+            auto oldest = std::chrono::steady_clock::time_point::max();
+            for (const auto& entry : sessions_) oldest = std::min(oldest, entry.second.lastUsed);
+            // Thức dậy cả khi có thay đổi (phiên mới, đổi timeout, dừng) để tính lại hạn.
+            changed_.wait_until(lock, oldest + idle_timeout_);
+            if (stopping_) break;
+            auto expired = TakeIdle(std::chrono::steady_clock::now());
+            if (expired.empty()) continue;
+            lock.unlock();
+            expired.clear();
+            lock.lock();
+        }
+    }
+
+    void ConnectSession(SigningSession& session) {
+        ConnectFirstReader(session.hContext, session.hCard);
+    }
+
+    void ReconnectSession(SigningSession& session) {
+        ReconnectCard(session.hCard);
+    }
+
+    std::vector<uint8_t> ReadSessionCertificate(SigningSession& session) {
+        auto select_resp = TransmitAndGetResponse(session.hCard, session.selectAppletCommand);
+        if (!IsSuccess(select_resp)) throw std::runtime_error("Select Applet failed.");
+        auto select_cert_resp = TransmitAndGetResponse(session.hCard, CreateSelectCertificateCommand());
+        if (!IsSuccess(select_cert_resp)) throw std::runtime_error("Select Certificate data object failed.");
+        auto cert_resp = TransmitAndGetResponse(session.hCard, CreateGetCertificateCommand());
+        if (!IsSuccess(cert_resp)) throw std::runtime_error("Get Certificate failed.");
+        std::vector<uint8_t> certificate(cert_resp.begin(), cert_resp.end() - 2);
+        if (certificate.empty()) throw std::runtime_error("Certificate from card is empty.");
+        return certificate;
+    }
+
+    std::vector<uint8_t> SignWithSession(SigningSession& session, const std::vector<uint8_t>& digestInfo) {
+        auto command = CreateComputeSignatureCommand(digestInfo, session.keyIndex);
+        bool reset = false;
+        auto sign_resp = TransmitSignature(session, command, reset);
+        if (reset || IsSecurityStatusNotSatisfied(sign_resp)) {
+            std::cout << "Re-authenticating signing session..." << std::endl;
+            sign_resp = ReauthenticateAndSign(session, command);
+        }
+        if (!IsSuccess(sign_resp)) throw std::runtime_error("Compute signature failed on card inside callback.");
+        return std::vector<uint8_t>(sign_resp.begin(), sign_resp.end() - 2);
+    }
+
+}  // namespace nfcsigner
+
+#endif  // HAVE_PODOFO
@@ -0,0 +1,129 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_SIGNING_SESSION_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_SIGNING_SESSION_H_
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cms_template.h"
+#include "pcsc_card.h"
+#include "signature_appearance.h"
+
+#ifdef HAVE_PODOFO
+namespace nfcsigner {
+
+    // Phiên ký PDF: cấu hình của người ký, kết nối thẻ đã VERIFY PIN,
+    // certificate, CMS template và appearance dựng sẵn. Các lần ký sau đó chỉ
+    // cần handle và tài liệu.
+    struct SigningSession {
+        std::vector<uint8_t> selectAppletCommand;
+        std::string pin;                // để xác thực lại nếu thẻ bị reset
+        int keyIndex = 0;
+        std::string reason;
+        std::string location;
+        int pageNumber = 1;
+        std::string signDate;
+        SignatureAppearanceConfig appearance;
+        std::shared_ptr<const SignatureAppearanceTemplate> appearanceTemplate;
+        std::shared_ptr<const CmsTemplate> cmsTemplate;
+        // Certificate (DER) đọc lúc mở phiên: thẻ sau khi bị reset phải trả
+        // đúng certificate này thì mới được gửi lại PIN.
+        std::vector<uint8_t> certificate;
+
+        SCARDCONTEXT hContext = 0;
+        SCARDHANDLE hCard = 0;
+        // Mỗi lúc chỉ một lần ký dùng kết nối thẻ của phiên.
+        std::mutex cardMutex;
+
+        SigningSession() = default;
+        SigningSession(const SigningSession&) = delete;
+        SigningSession& operator=(const SigningSession&) = delete;
+
+        ~SigningSession() {
+            std::fill(pin.begin(), pin.end(), '\0');
+            // Reset thẻ để trạng thái đã VERIFY PIN không còn sau khi đóng phiên.
+            DisconnectCard(hContext, hCard, SCARD_RESET_CARD);
+        }
+    };
+
+    // Các phiên đang mở, theo handle trả về cho caller. Dùng chung cho cả tiến
+    // trình (MethodChannel và dart:ffi). Phiên được giải phóng khi đã đóng và
+    // lần ký cuối cùng đang chạy trên nó kết thúc. Phiên không được dùng quá
+    // idle timeout thì bị một luồng nền đóng như closeSigningSession, để PIN
+    // và kết nối đã VERIFY không nằm lại khi ứng dụng quên đóng phiên.
+    class SigningSessionRegistry {
+    public:
+        static constexpr std::chrono::milliseconds kDefaultIdleTimeout = std::chrono::minutes(10);
+
+        static SigningSessionRegistry& Instance();
+
+        ~SigningSessionRegistry();
+
+        int64_t Add(std::shared_ptr<SigningSession> session);
+
+        // nullptr nếu không có; gia hạn thời gian nhàn rỗi của phiên.
+        std::shared_ptr<SigningSession> Get(int64_t handle);
+
+        bool Remove(int64_t handle);
+
+        // 0: không tự đóng phiên.
+        void SetIdleTimeout(std::chrono::milliseconds timeout);
+        std::chrono::milliseconds GetIdleTimeout() const;
+
+        // Đóng các phiên không dùng quá idle timeout tính tới [now]. Trả về số
+        // phiên đã đóng. Luồng nền gọi hàm này khi phiên cũ nhất hết hạn.
+        size_t SweepIdle(std::chrono::steady_clock::time_point now);
+
+        size_t GetCount() const;
+
+    private:
+        struct Entry {
+            std::shared_ptr<SigningSession> session;
+            std::chrono::steady_clock::time_point lastUsed;
+        };
+
+        SigningSessionRegistry() = default;
+
+        // Gỡ các phiên hết hạn khỏi danh sách; caller giữ mutex_ và giải phóng
+        // chúng sau khi nhả khóa (đóng phiên reset thẻ).
+        std::vector<std::shared_ptr<SigningSession>> TakeIdle(std::chrono::steady_clock::time_point now);
+        void RunSweeper();
+
+        mutable std::mutex mutex_;
+        std::condition_variable changed_;
+        std::map<int64_t, Entry> sessions_;
+        int64_t next_handle_ = 1;
+        std::chrono::milliseconds idle_timeout_ = kDefaultIdleTimeout;
+        bool stopping_ = false;
+        std::thread sweeper_;
+    };
+
+    // Kết nối reader đầu tiên cho phiên; kết nối được giữ tới khi đóng phiên.
+    void ConnectSession(SigningSession& session);
+
+    // Thẻ bị reset hoặc rút ra cắm lại: xác nhận lại kết nối trên cùng reader.
+    void ReconnectSession(SigningSession& session);
+
+    // SELECT applet rồi đọc certificate (DER) trên kết nối của phiên. Caller
+    // giữ CardTransaction.
+    std::vector<uint8_t> ReadSessionCertificate(SigningSession& session);
+
+    // COMPUTE SIGNATURE [digestInfo] bằng khóa của phiên; caller giữ
+    // session.cardMutex và lượt của CardScheduler. Chỉ khi thẻ báo chưa xác
+    // thực (SW 6982) hoặc đã bị reset (SCARD_W_RESET_CARD) mới kết nối lại,
+    // đọc lại certificate, so với certificate của phiên rồi gửi lại PIN và ký
+    // lại một lần; lỗi khác được ném lại nguyên vẹn.
+    std::vector<uint8_t> SignWithSession(SigningSession& session, const std::vector<uint8_t>& digestInfo);
+
+}  // namespace nfcsigner
+#endif  // HAVE_PODOFO
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_SIGNING_SESSION_H_
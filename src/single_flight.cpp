@@ -0,0 +1,47 @@
+#include "single_flight.h"
+
+#include <exception>
+#include <utility>
+
+namespace nfcsigner {
+
+    SingleFlight::Result SingleFlight::Do(const std::string& key, const std::function<Result()>& load, bool* shared) {
+        std::promise<Result> promise;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            auto it = in_flight_.find(key);
+            if (it != in_flight_.end()) {
+                std::shared_future<Result> pending = it->second;
+                ++shared_count_;
+                lock.unlock();
+                if (shared) *shared = true;
+                return pending.get();
+            }
+            in_flight_.emplace(key, promise.get_future().share());
+        }
+        if (shared) *shared = false;
+
+        // Gỡ khóa khỏi bảng trước khi báo kết quả: người đến sau lúc này bắt
+        // đầu một lần đọc mới thay vì nhận kết quả đã cũ.
+        auto finish = [this, &key]() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            in_flight_.erase(key);
+        };
+        try {
+            Result result = load();
+            finish();
+            promise.set_value(result);
+            return result;
+        } catch (...) {
+            finish();
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    size_t SingleFlight::GetSharedCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return shared_count_;
+    }
+
+}  // namespace nfcsigner
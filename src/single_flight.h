@@ -0,0 +1,36 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_SINGLE_FLIGHT_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_SINGLE_FLIGHT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nfcsigner {
+
+    // Gộp các lần đọc giống nhau đang chạy đồng thời: lần đầu tiên với một
+    // khóa chạy [load], các lần đến sau trong lúc đó chờ và nhận cùng kết quả
+    // (hoặc cùng ngoại lệ). Không giữ khóa trong lúc [load] chạy; kết quả
+    // không được cache sau khi lần đọc kết thúc.
+    class SingleFlight {
+    public:
+        using Result = std::vector<uint8_t>;
+
+        // [shared] (nếu khác nullptr) cho biết kết quả lấy từ lần đọc của người khác.
+        Result Do(const std::string& key, const std::function<Result()>& load, bool* shared = nullptr);
+
+        size_t GetSharedCount() const;
+
+    private:
+        mutable std::mutex mutex_;
+        std::unordered_map<std::string, std::shared_future<Result>> in_flight_;
+        size_t shared_count_ = 0;
+    };
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_SINGLE_FLIGHT_H_
@@ -0,0 +1,196 @@
+#include "software_card.h"
+
+#include "cancellation.h"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include <openssl/bio.h>
+#include <openssl/bn.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#endif
+
+namespace nfcsigner {
+
+    namespace {
+
+        std::vector<uint8_t> ReadFile(const std::string& path) {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) throw std::runtime_error("Cannot open " + path);
+            return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        // Độ dài BER của TLV.
+        void AppendLength(std::vector<uint8_t>& out, size_t length) {
+            if (length < 0x80) {
+                out.push_back(static_cast<uint8_t>(length));
+            } else if (length <= 0xFF) {
+                out.push_back(0x81);
+                out.push_back(static_cast<uint8_t>(length));
+            } else {
+                out.push_back(0x82);
+                out.push_back(static_cast<uint8_t>(length >> 8));
+                out.push_back(static_cast<uint8_t>(length));
+            }
+        }
+
+        void AppendTlv(std::vector<uint8_t>& out, uint8_t tag, const std::vector<uint8_t>& value) {
+            out.push_back(tag);
+            AppendLength(out, value.size());
+            out.insert(out.end(), value.begin(), value.end());
+        }
+
+        std::vector<uint8_t> BigNumBytes(const BIGNUM* bn) {
+            std::vector<uint8_t> bytes(BN_num_bytes(bn));
+            BN_bn2bin(bn, bytes.data());
+            return bytes;
+        }
+
+        // Modulus và exponent của khóa RSA.
+        void GetRsaComponents(EVP_PKEY* key, std::vector<uint8_t>& modulus, std::vector<uint8_t>& exponent) {
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+            BIGNUM* n = nullptr;
+            BIGNUM* e = nullptr;
+            if (EVP_PKEY_get_bn_param(key, OSSL_PKEY_PARAM_RSA_N, &n) != 1 ||
+                EVP_PKEY_get_bn_param(key, OSSL_PKEY_PARAM_RSA_E, &e) != 1) {
+                BN_free(n);
+                BN_free(e);
+                throw std::runtime_error("Cannot read RSA key components.");
+            }
+            modulus = BigNumBytes(n);
+            exponent = BigNumBytes(e);
+            BN_free(n);
+            BN_free(e);
+#else
+            const RSA* rsa = EVP_PKEY_get0_RSA(key);
+            if (!rsa) throw std::runtime_error("Cannot read RSA key components.");
+            const BIGNUM* n = nullptr;
+            const BIGNUM* e = nullptr;
+            RSA_get0_key(rsa, &n, &e, nullptr);
+            modulus = BigNumBytes(n);
+            exponent = BigNumBytes(e);
+#endif
+        }
+
+    }  // namespace
+
+    class SoftwareSigningCard::Channel : public CardChannel {
+    public:
+        explicit Channel(const SoftwareSigningCard& card) : card_(card) {}
+
+        std::vector<uint8_t> ReadCertificate() override {
+            return card_.certificate_;
+        }
+
+        std::vector<uint8_t> ReadRsaPublicKey(const std::string& keyRole) override {
+            if (keyRole != "sig" && keyRole != "dec" && keyRole != "aut") {
+                throw std::runtime_error("Get Public Key failed.");
+            }
+            std::vector<uint8_t> modulus;
+            std::vector<uint8_t> exponent;
+            GetRsaComponents(card_.key_.get(), modulus, exponent);
+
+            std::vector<uint8_t> content;
+            AppendTlv(content, 0x81, modulus);
+            AppendTlv(content, 0x82, exponent);
+            std::vector<uint8_t> key = { 0x7F, 0x49 };
+            AppendLength(key, content.size());
+            key.insert(key.end(), content.begin(), content.end());
+            return key;
+        }
+
+        void VerifyPin(const std::string& pin) override {
+            ThrowIfCancelled();
+            pin_verified_ = pin == card_.pin_;
+            if (!pin_verified_) throw std::runtime_error("Verify PIN failed.");
+        }
+
+        std::vector<uint8_t> ComputeSignature(const std::vector<uint8_t>& data, int keyIndex) override {
+            (void)keyIndex;  // thẻ mềm chỉ có một khóa
+            ThrowIfCancelled();
+            // SW 6982 trên thẻ thật: chưa VERIFY PIN trong lượt này.
+            if (!pin_verified_) throw std::runtime_error("Compute signature failed on card.");
+
+            std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> ctx(
+                    EVP_PKEY_CTX_new(card_.key_.get(), nullptr), &EVP_PKEY_CTX_free);
+            if (!ctx || EVP_PKEY_sign_init(ctx.get()) != 1 ||
+                EVP_PKEY_CTX_set_rsa_padding(ctx.get(), RSA_PKCS1_PADDING) != 1) {
+                throw std::runtime_error("EVP_PKEY_sign_init failed.");
+            }
+            size_t signatureLength = 0;
+            if (EVP_PKEY_sign(ctx.get(), nullptr, &signatureLength, data.data(), data.size()) != 1) {
+                throw std::runtime_error("Compute signature failed on card.");
+            }
+            std::vector<uint8_t> signature(signatureLength);
+            if (EVP_PKEY_sign(ctx.get(), signature.data(), &signatureLength, data.data(), data.size()) != 1) {
+                throw std::runtime_error("Compute signature failed on card.");
+            }
+            signature.resize(signatureLength);
+            return signature;
+        }
+
+    private:
+        const SoftwareSigningCard& card_;
+        bool pin_verified_ = false;
+    };
+
+    std::unique_ptr<SoftwareSigningCard> SoftwareSigningCard::FromFiles(const std::string& keyPath,
+                                                                        const std::string& certificatePath,
+                                                                        std::string pin) {
+        std::unique_ptr<SoftwareSigningCard> card(new SoftwareSigningCard());
+
+        auto keyFile = ReadFile(keyPath);
+        std::unique_ptr<BIO, decltype(&BIO_free)> keyBio(
+                BIO_new_mem_buf(keyFile.data(), static_cast<int>(keyFile.size())), &BIO_free);
+        EVP_PKEY* key = keyBio ? PEM_read_bio_PrivateKey(keyBio.get(), nullptr, nullptr, nullptr) : nullptr;
+        if (!key) throw std::runtime_error("Cannot read private key from " + keyPath);
+        card->key_.reset(key, &EVP_PKEY_free);
+        if (EVP_PKEY_base_id(key) != EVP_PKEY_RSA) throw std::runtime_error("Software card key must be RSA.");
+
+        // Certificate PEM thì đổi sang DER như thẻ trả về; không thì coi là DER.
+        auto certificateFile = ReadFile(certificatePath);
+        std::unique_ptr<BIO, decltype(&BIO_free)> certificateBio(
+                BIO_new_mem_buf(certificateFile.data(), static_cast<int>(certificateFile.size())), &BIO_free);
+        std::unique_ptr<X509, decltype(&X509_free)> x509(
+                certificateBio ? PEM_read_bio_X509(certificateBio.get(), nullptr, nullptr, nullptr) : nullptr,
+                &X509_free);
+        if (x509) {
+            int length = i2d_X509(x509.get(), nullptr);
+            if (length <= 0) throw std::runtime_error("Cannot encode certificate from " + certificatePath);
+            card->certificate_.resize(length);
+            unsigned char* p = card->certificate_.data();
+            i2d_X509(x509.get(), &p);
+        } else {
+            ERR_clear_error();
+            const unsigned char* p = certificateFile.data();
+            x509.reset(d2i_X509(nullptr, &p, static_cast<long>(certificateFile.size())));
+            if (!x509) throw std::runtime_error("Cannot read certificate from " + certificatePath);
+            card->certificate_ = std::move(certificateFile);
+        }
+        if (X509_check_private_key(x509.get(), key) != 1) {
+            throw std::runtime_error("Certificate does not match the software card key.");
+        }
+
+        card->pin_ = std::move(pin);
+        return card;
+    }
+
+    void SoftwareSigningCard::WithChannel(const std::string& appletID, CardPriority priority,
+                                          const std::function<void(CardChannel&)>& operation) {
+        (void)appletID;  // thẻ mềm có một applet duy nhất
+        CardScheduler::Ticket ticket = CardScheduler::Instance().Acquire(priority);
+        if (!ticket) throw CardBusyError(priority);
+        ThrowIfCancelled();
+
+        Channel channel(*this);
+        operation(channel);
+    }
+
+}  // namespace nfcsigner
@@ -0,0 +1,45 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_SOFTWARE_CARD_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_SOFTWARE_CARD_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "signing_card.h"
+
+typedef struct evp_pkey_st EVP_PKEY;
+
+namespace nfcsigner {
+
+    // Thẻ mềm cho chế độ chạy thử cục bộ: khóa RSA và certificate đọc từ file,
+    // trả lời như applet trên thẻ (PKCS#1 v1.5 trên DigestInfo, VERIFY PIN
+    // trước khi ký, khóa công khai dạng 7F49). Vẫn đi qua CardScheduler nên
+    // thứ tự và giới hạn hàng đợi giống thẻ thật. Không dùng cho môi trường
+    // thật: khóa nằm trên đĩa.
+    class SoftwareSigningCard : public SigningCard {
+    public:
+        // [keyPath]: khóa riêng RSA PEM (không mật khẩu). [certificatePath]:
+        // certificate PEM hoặc DER khớp khóa. Ném std::runtime_error nếu
+        // không đọc được hoặc không phải khóa RSA.
+        static std::unique_ptr<SoftwareSigningCard> FromFiles(const std::string& keyPath,
+                                                              const std::string& certificatePath,
+                                                              std::string pin);
+
+        void WithChannel(const std::string& appletID, CardPriority priority,
+                         const std::function<void(CardChannel&)>& operation) override;
+
+    private:
+        class Channel;
+
+        SoftwareSigningCard() = default;
+
+        std::shared_ptr<EVP_PKEY> key_;
+        std::vector<uint8_t> certificate_;
+        std::string pin_;
+    };
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_SOFTWARE_CARD_H_
@@ -0,0 +1,79 @@
+#include "byte_codec.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nfcsigner {
+namespace {
+
+    std::vector<uint8_t> Bytes(const std::string& text) {
+        return std::vector<uint8_t>(text.begin(), text.end());
+    }
+
+    // Chạy mỗi test hai lần: kernel SIMD của CPU và bảng tra.
+    class ByteCodecTest : public ::testing::TestWithParam<bool> {
+    protected:
+        void SetUp() override { SetByteCodecScalarOnly(GetParam()); }
+        void TearDown() override { SetByteCodecScalarOnly(false); }
+    };
+
+    // RFC 4648 mục 10.
+    TEST_P(ByteCodecTest, Base64MatchesRfc4648Vectors) {
+        const std::pair<const char*, const char*> vectors[] = {
+                { "", "" }, { "f", "Zg==" }, { "fo", "Zm8=" }, { "foo", "Zm9v" },
+                { "foob", "Zm9vYg==" }, { "fooba", "Zm9vYmE=" }, { "foobar", "Zm9vYmFy" },
+        };
+        for (const auto& vector : vectors) {
+            EXPECT_EQ(EncodeBase64(Bytes(vector.first)), vector.second);
+            EXPECT_EQ(DecodeBase64(std::string(vector.second)), Bytes(vector.first));
+        }
+    }
+
+    TEST_P(ByteCodecTest, HexMatchesKnownVectors) {
+        std::vector<uint8_t> aid = { 0xA0, 0x00, 0x00, 0x00, 0x03, 0x10, 0x10, 0x7F, 0xFF };
+        EXPECT_EQ(EncodeHex(aid.data(), aid.size()), "a00000000310107fff");
+        EXPECT_EQ(EncodeHex(aid.data(), aid.size(), HexCase::Upper), "A00000000310107FFF");
+        EXPECT_EQ(DecodeHex("A00000000310107fFf"), aid);
+        EXPECT_EQ(EncodeHex(nullptr, 0), "");
+    }
+
+    TEST_P(ByteCodecTest, LongInputsRoundTripAtEveryLength) {
+        std::mt19937 random(42);
+        std::vector<uint8_t> data(300);
+        for (auto& byte : data) byte = static_cast<uint8_t>(random());
+        for (size_t size = 0; size <= data.size(); ++size) {
+            std::vector<uint8_t> slice(data.begin(), data.begin() + static_cast<long>(size));
+            std::string base64 = EncodeBase64(slice);
+            ASSERT_EQ(base64.size(), Base64EncodedLength(size));
+            ASSERT_EQ(DecodeBase64(base64), slice) << "size " << size;
+            std::string hex = EncodeHex(slice.data(), slice.size());
+            ASSERT_EQ(hex.size(), 2 * size);
+            ASSERT_EQ(DecodeHex(hex), slice) << "size " << size;
+        }
+    }
+
+    TEST_P(ByteCodecTest, DecodersRejectMalformedInput) {
+        std::vector<uint8_t> out;
+        for (const char* text : { "Zg=", "Zh==", "Zm9=", "Z===", "Zg==Zg==", "Zm9v Yg==", "Zm9v\nYmFy", "Zm9*" }) {
+            EXPECT_FALSE(DecodeBase64(text, std::char_traits<char>::length(text), out)) << text;
+        }
+        EXPECT_THROW(DecodeBase64(std::string("Zg=")), std::runtime_error);
+
+        uint8_t buffer[8];
+        for (const char* hex : { "a", "0g", "a 0", "0x10" }) {
+            EXPECT_FALSE(DecodeHex(hex, std::char_traits<char>::length(hex), buffer)) << hex;
+        }
+        EXPECT_THROW(DecodeHex(std::string("abc")), std::runtime_error);
+    }
+
+    INSTANTIATE_TEST_SUITE_P(Kernels, ByteCodecTest, ::testing::Values(false, true),
+                             [](const ::testing::TestParamInfo<bool>& info) {
+                                 return info.param ? "Scalar" : "Simd";
+                             });
+
+}  // namespace
+}  // namespace nfcsigner
@@ -0,0 +1,93 @@
+#include "cancellation.h"
+#include "card_scheduler.h"
+#include "worker_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace nfcsigner {
+namespace {
+
+    // Chạy [operation] như plugin chạy một request trên worker: token đăng ký
+    // lúc nhận, đặt làm token hiện tại khi worker bắt đầu.
+    template<typename Operation>
+    std::future<std::string> RunRequest(WorkerPool& pool, std::shared_ptr<CancellationToken> token, Operation operation) {
+        auto outcome = std::make_shared<std::promise<std::string>>();
+        auto future = outcome->get_future();
+        bool accepted = pool.Submit([token, outcome, operation]() {
+            RequestCancellation cancellation(token);
+            if (token->IsCancelled()) {
+                outcome->set_value("cancelled before start");
+                return;
+            }
+            try {
+                operation();
+                outcome->set_value("done");
+            } catch (const OperationCancelled& e) {
+                outcome->set_value(e.IsDeadlineExceeded() ? "deadline" : "cancelled");
+            }
+        });
+        EXPECT_TRUE(accepted);
+        return future;
+    }
+
+    TEST(CancellationTest, CancelStopsInFlightRequestWaitingForReader) {
+        WorkerPool pool(2, 0);
+        auto held = CardScheduler::Instance().Acquire(CardPriority::Interactive);
+        ASSERT_TRUE(held);
+
+        auto token = CancellationRegistry::Instance().Register("in-flight", 0);
+        auto outcome = RunRequest(pool, token, []() { CardScheduler::Instance().Acquire(CardPriority::Bulk); });
+
+        // Chờ request thật sự nằm trong hàng đợi reader.
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (CardScheduler::Instance().GetMetrics()[static_cast<size_t>(CardPriority::Bulk)].depth == 0) {
+            ASSERT_LT(std::chrono::steady_clock::now(), deadline);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_TRUE(CancellationRegistry::Instance().Cancel("in-flight"));
+
+        ASSERT_EQ(outcome.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_EQ(outcome.get(), "cancelled");
+        pool.Shutdown();
+        EXPECT_FALSE(CancellationRegistry::Instance().Cancel("in-flight"));
+    }
+
+    TEST(CancellationTest, CancelReachesRequestStillQueuedForWorker) {
+        WorkerPool pool(1, 0);
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        ASSERT_TRUE(pool.Submit([released]() { released.wait(); }));
+
+        auto token = CancellationRegistry::Instance().Register("queued", 0);
+        auto outcome = RunRequest(pool, token, []() {});
+        EXPECT_TRUE(CancellationRegistry::Instance().Cancel("queued"));
+        release.set_value();
+
+        ASSERT_EQ(outcome.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_EQ(outcome.get(), "cancelled before start");
+    }
+
+    TEST(CancellationTest, DeadlineWakesRequestWaitingForReader) {
+        WorkerPool pool(1, 0);
+        auto held = CardScheduler::Instance().Acquire(CardPriority::Interactive);
+        ASSERT_TRUE(held);
+
+        auto token = CancellationRegistry::Instance().Register(std::string(), 20);
+        auto outcome = RunRequest(pool, token, []() { CardScheduler::Instance().Acquire(CardPriority::Bulk); });
+
+        ASSERT_EQ(outcome.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_EQ(outcome.get(), "deadline");
+    }
+
+    TEST(CancellationTest, CancelUnknownRequestReturnsFalse) {
+        EXPECT_FALSE(CancellationRegistry::Instance().Cancel("never-registered"));
+    }
+
+}  // namespace
+}  // namespace nfcsigner
@@ -0,0 +1,79 @@
+#include "card_coroutine.h"
+
+#include <gtest/gtest.h>
+
+#ifdef NFCSIGNER_HAVE_COROUTINES
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+namespace nfcsigner {
+namespace {
+
+    CardQueueMetrics MetricsFor(CardPriority priority) {
+        return CardScheduler::Instance().GetMetrics()[static_cast<size_t>(priority)];
+    }
+
+    CardTask<int> Add(CardEventLoop& loop, int a, int b) {
+        co_await loop.Sleep(std::chrono::milliseconds(1));
+        co_return co_await loop.RunBlocking([a, b]() { return a + b; });
+    }
+
+    CardTask<void> FailOnIoThread(CardEventLoop& loop) {
+        co_await loop.RunBlocking([]() { throw std::runtime_error("io failed"); });
+    }
+
+    // Chờ lượt của CardScheduler, trả lại ngay và báo thời gian đã chờ.
+    CardTask<int64_t> UseReader(CardEventLoop& loop, CardPriority priority,
+                                std::shared_ptr<CancellationToken> cancellation) {
+        CardScheduler::Ticket ticket = co_await loop.AcquireCard(priority, std::move(cancellation));
+        co_return ticket.GetWaitUs();
+    }
+
+    TEST(CardCoroutineTest, SpawnReturnsResultsAndRethrows) {
+        CardEventLoop loop(1);
+        EXPECT_EQ(loop.Spawn(Add(loop, 2, 3)).get(), 5);
+        EXPECT_THROW(loop.Spawn(FailOnIoThread(loop)).get(), std::runtime_error);
+    }
+
+    TEST(CardCoroutineTest, AcquireCardWaitsForBlockingHolderWithoutThreads) {
+        CardEventLoop loop(1);
+        auto held = CardScheduler::Instance().Acquire(CardPriority::Bulk);
+        ASSERT_TRUE(held);
+
+        auto first = loop.Spawn(UseReader(loop, CardPriority::Interactive, nullptr));
+        auto second = loop.Spawn(UseReader(loop, CardPriority::Interactive, nullptr));
+        // Hai coroutine chờ lượt mà luồng I/O duy nhất vẫn rảnh.
+        EXPECT_EQ(loop.Spawn(Add(loop, 1, 1)).get(), 2);
+        EXPECT_EQ(first.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+
+        held = CardScheduler::Ticket();
+        EXPECT_GT(first.get(), 0);
+        EXPECT_GT(second.get(), 0);
+        EXPECT_EQ(MetricsFor(CardPriority::Interactive).depth, 0u);
+    }
+
+    TEST(CardCoroutineTest, AcquireCardHonoursCancellationAndCapacity) {
+        CardEventLoop loop(1);
+        auto held = CardScheduler::Instance().Acquire(CardPriority::Interactive);
+        ASSERT_TRUE(held);
+
+        auto token = std::make_shared<CancellationToken>("coroutine");
+        auto cancelled = loop.Spawn(UseReader(loop, CardPriority::Bulk, token));
+        token->Cancel();
+        EXPECT_THROW(cancelled.get(), OperationCancelled);
+        EXPECT_EQ(MetricsFor(CardPriority::Bulk).depth, 0u);
+
+        CardScheduler::Instance().SetCapacity(CardPriority::Background, 0);
+        auto rejected = loop.Spawn(UseReader(loop, CardPriority::Background, nullptr));
+        EXPECT_THROW(rejected.get(), CardBusyError);
+        CardScheduler::Instance().SetCapacity(CardPriority::Background, 4);
+    }
+
+}  // namespace
+}  // namespace nfcsigner
+
+#endif  // NFCSIGNER_HAVE_COROUTINES
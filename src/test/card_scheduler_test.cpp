@@ -0,0 +1,161 @@
+#include "card_scheduler.h"
+#include "cancellation.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nfcsigner {
+namespace {
+
+    CardQueueMetrics MetricsFor(CardPriority priority) {
+        return CardScheduler::Instance().GetMetrics()[static_cast<size_t>(priority)];
+    }
+
+    // Chờ tới khi hàng đợi của [priority] có [depth] request.
+    void WaitForDepth(CardPriority priority, size_t depth) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (MetricsFor(priority).depth != depth) {
+            ASSERT_LT(std::chrono::steady_clock::now(), deadline) << "queue never reached depth " << depth;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    TEST(CardSchedulerTest, GrantsImmediatelyWhenReaderIsIdle) {
+        auto ticket = CardScheduler::Instance().Acquire(CardPriority::Bulk);
+        ASSERT_TRUE(ticket);
+        EXPECT_EQ(ticket.GetWaitUs(), 0);
+    }
+
+    TEST(CardSchedulerTest, RejectsWhenPriorityQueueIsFull) {
+        auto& scheduler = CardScheduler::Instance();
+        auto held = scheduler.Acquire(CardPriority::Interactive);
+        ASSERT_TRUE(held);
+
+        uint64_t rejected = MetricsFor(CardPriority::Background).rejected;
+        scheduler.SetCapacity(CardPriority::Background, 0);
+        auto ticket = scheduler.Acquire(CardPriority::Background);
+        scheduler.SetCapacity(CardPriority::Background, 4);
+
+        EXPECT_FALSE(ticket);
+        EXPECT_EQ(MetricsFor(CardPriority::Background).rejected, rejected + 1);
+    }
+
+    TEST(CardSchedulerTest, InteractiveOvertakesQueuedBackgroundWork) {
+        auto& scheduler = CardScheduler::Instance();
+        auto held = scheduler.Acquire(CardPriority::Bulk);
+        ASSERT_TRUE(held);
+
+        std::mutex mutex;
+        std::vector<CardPriority> order;
+        auto waiter = [&](CardPriority priority) {
+            auto ticket = CardScheduler::Instance().Acquire(priority);
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(priority);
+        };
+        std::thread background(waiter, CardPriority::Background);
+        WaitForDepth(CardPriority::Background, 1);
+        std::thread interactive(waiter, CardPriority::Interactive);
+        WaitForDepth(CardPriority::Interactive, 1);
+
+        held = CardScheduler::Ticket();
+        background.join();
+        interactive.join();
+
+        ASSERT_EQ(order.size(), 2u);
+        EXPECT_EQ(order[0], CardPriority::Interactive);
+        EXPECT_EQ(order[1], CardPriority::Background);
+    }
+
+    TEST(CardSchedulerTest, CancelWakesQueuedRequest) {
+        auto& scheduler = CardScheduler::Instance();
+        auto held = scheduler.Acquire(CardPriority::Interactive);
+        ASSERT_TRUE(held);
+
+        auto token = std::make_shared<CancellationToken>("queued");
+        auto outcome = std::async(std::launch::async, [token]() {
+            CancellationScope scope(token);
+            try {
+                CardScheduler::Instance().Acquire(CardPriority::Bulk);
+                return false;
+            } catch (const OperationCancelled&) {
+                return true;
+            }
+        });
+        WaitForDepth(CardPriority::Bulk, 1);
+        token->Cancel();
+
+        ASSERT_EQ(outcome.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_TRUE(outcome.get());
+        EXPECT_EQ(MetricsFor(CardPriority::Bulk).depth, 0u);
+    }
+
+    // Kết quả của AcquireAsync, đợi được từ luồng test.
+    struct AsyncGrant {
+        std::promise<CardScheduler::Ticket> ticket;
+
+        CardScheduler::AcquireCallback Callback() {
+            return [this](CardScheduler::Ticket granted, std::exception_ptr error) {
+                if (error) {
+                    ticket.set_exception(error);
+                } else {
+                    ticket.set_value(std::move(granted));
+                }
+            };
+        }
+    };
+
+    TEST(CardSchedulerTest, AsyncAcquireIsGrantedWhenReaderIsReleased) {
+        auto& scheduler = CardScheduler::Instance();
+        auto held = scheduler.Acquire(CardPriority::Bulk);
+        ASSERT_TRUE(held);
+
+        AsyncGrant grant;
+        auto future = grant.ticket.get_future();
+        scheduler.AcquireAsync(CardPriority::Interactive, nullptr, grant.Callback());
+        EXPECT_EQ(MetricsFor(CardPriority::Interactive).depth, 1u);
+        EXPECT_EQ(future.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+
+        held = CardScheduler::Ticket();
+        ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        auto ticket = future.get();
+        EXPECT_TRUE(ticket);
+        // Reader vẫn bận tới khi ticket của AcquireAsync được trả.
+        AsyncGrant next;
+        auto nextFuture = next.ticket.get_future();
+        scheduler.AcquireAsync(CardPriority::Bulk, nullptr, next.Callback());
+        EXPECT_EQ(nextFuture.wait_for(std::chrono::milliseconds(20)), std::future_status::timeout);
+        ticket = CardScheduler::Ticket();
+        EXPECT_TRUE(nextFuture.get());
+    }
+
+    TEST(CardSchedulerTest, AsyncAcquireLeavesQueueWhenCancelled) {
+        auto& scheduler = CardScheduler::Instance();
+        auto held = scheduler.Acquire(CardPriority::Interactive);
+        ASSERT_TRUE(held);
+
+        auto token = std::make_shared<CancellationToken>("queued");
+        AsyncGrant grant;
+        auto future = grant.ticket.get_future();
+        scheduler.AcquireAsync(CardPriority::Background, token, grant.Callback());
+        EXPECT_EQ(MetricsFor(CardPriority::Background).depth, 1u);
+        token->Cancel();
+
+        EXPECT_THROW(future.get(), OperationCancelled);
+        EXPECT_EQ(MetricsFor(CardPriority::Background).depth, 0u);
+
+        // Token đã hủy: trả lỗi ngay, không vào hàng đợi.
+        AsyncGrant late;
+        auto lateFuture = late.ticket.get_future();
+        scheduler.AcquireAsync(CardPriority::Background, token, late.Callback());
+        EXPECT_THROW(lateFuture.get(), OperationCancelled);
+        EXPECT_EQ(MetricsFor(CardPriority::Background).depth, 0u);
+    }
+
+}  // namespace
+}  // namespace nfcsigner
@@ -0,0 +1,78 @@
+#include "cms_template.h"
+#include "test_support.h"
+
+#include <gtest/gtest.h>
+
+#include <openssl/sha.h>
+
+#include <vector>
+
+namespace nfcsigner {
+namespace {
+
+    using test::TestKey;
+
+    // Chữ ký của thẻ và certificate đọc từ thẻ: khớp khi cùng khóa, lệch khi
+    // gửi sai keyIndex (thẻ ký bằng khóa khác).
+    const TestKey& CardKey() {
+        static const TestKey key("card");
+        return key;
+    }
+
+    const TestKey& OtherKey() {
+        static const TestKey key("other key slot");
+        return key;
+    }
+
+    CardSignFunction SignWith(const TestKey& key) {
+        return [&key](const std::vector<uint8_t>& digestInfo) { return key.Sign(digestInfo); };
+    }
+
+    std::vector<uint8_t> DigestInfoOf(const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> digest(SHA256_DIGEST_LENGTH);
+        SHA256(data.data(), data.size(), digest.data());
+        return CreateSha256DigestInfo(digest.data());
+    }
+
+    class CardSelfCheckTest : public ::testing::Test {
+    protected:
+        void TearDown() override { SetCardSignatureSelfCheck(false); }
+
+        std::shared_ptr<const CmsTemplate> cmsTemplate = CmsTemplate::Create(CardKey().GetCertificate());
+        std::vector<uint8_t> digestInfo = DigestInfoOf({ 'a', 'b', 'c' });
+        std::vector<uint8_t> contentDigest = std::vector<uint8_t>(SHA256_DIGEST_LENGTH, 0x42);
+    };
+
+    TEST_F(CardSelfCheckTest, DisabledPassesSignaturesThrough) {
+        SetCardSignatureSelfCheck(false);
+        auto sign = WithCardSignatureSelfCheck(cmsTemplate, SignWith(OtherKey()));
+        EXPECT_EQ(sign(digestInfo), OtherKey().Sign(digestInfo));
+        EXPECT_NO_THROW(cmsTemplate->BuildSignedData(contentDigest.data(), 1700000000, SignWith(OtherKey())));
+    }
+
+    TEST_F(CardSelfCheckTest, RawSignatureFromWrongKeyIsMismatch) {
+        SetCardSignatureSelfCheck(true);
+        EXPECT_EQ(WithCardSignatureSelfCheck(cmsTemplate, SignWith(CardKey()))(digestInfo), CardKey().Sign(digestInfo));
+        EXPECT_THROW(WithCardSignatureSelfCheck(cmsTemplate, SignWith(OtherKey()))(digestInfo), CardSignatureMismatch);
+    }
+
+    TEST_F(CardSelfCheckTest, TruncatedSignatureIsMismatch) {
+        SetCardSignatureSelfCheck(true);
+        auto truncated = [](const std::vector<uint8_t>& data) {
+            auto signature = CardKey().Sign(data);
+            signature.resize(signature.size() / 2);
+            return signature;
+        };
+        EXPECT_THROW(WithCardSignatureSelfCheck(cmsTemplate, truncated)(digestInfo), CardSignatureMismatch);
+    }
+
+    // signFile/signPdf: CMS dựng bằng BuildSignedData tự kiểm tra theo cùng cài đặt.
+    TEST_F(CardSelfCheckTest, SignedDataHonorsTheSetting) {
+        SetCardSignatureSelfCheck(true);
+        EXPECT_NO_THROW(cmsTemplate->BuildSignedData(contentDigest.data(), 1700000000, SignWith(CardKey())));
+        EXPECT_THROW(cmsTemplate->BuildSignedData(contentDigest.data(), 1700000000, SignWith(OtherKey())),
+                     CardSignatureMismatch);
+    }
+
+}  // namespace
+}  // namespace nfcsigner
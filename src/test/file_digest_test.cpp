@@ -0,0 +1,107 @@
+#include "file_digest.h"
+#include "byte_codec.h"
+#include "cancellation.h"
+
+#include <gtest/gtest.h>
+#include <openssl/sha.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace nfcsigner {
+namespace {
+
+    namespace fs = std::filesystem;
+
+    // Thư mục tạm có tên không phải ASCII: đường dẫn đi qua API là UTF-8.
+    class FileDigestTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            root_ = fs::temp_directory_path() / fs::path(u8"nfcsigner_tài_liệu_test");
+            fs::remove_all(root_);
+            fs::create_directories(root_ / "nested");
+        }
+
+        void TearDown() override {
+            fs::remove_all(root_);
+        }
+
+        std::string Write(const std::string& relative, const std::string& content) {
+            fs::path path = root_ / fs::path(relative);
+            std::ofstream(path, std::ios::binary) << content;
+            auto text = path.u8string();
+            return std::string(text.begin(), text.end());
+        }
+
+        static std::string Hex(const std::vector<uint8_t>& digest) {
+            return EncodeHex(digest.data(), digest.size());
+        }
+
+        std::string Root() const {
+            auto text = root_.u8string();
+            return std::string(text.begin(), text.end());
+        }
+
+        fs::path root_;
+    };
+
+    TEST_F(FileDigestTest, Sha256FileMatchesKnownAnswer) {
+        // FIPS 180-2, ví dụ "abc".
+        std::string path = Write("abc.txt", "abc");
+        EXPECT_EQ(Hex(Sha256File(path)), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    }
+
+    TEST_F(FileDigestTest, Sha256FileOfEmptyFile) {
+        std::string path = Write("empty.bin", "");
+        EXPECT_EQ(Hex(Sha256File(path)), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    }
+
+    TEST_F(FileDigestTest, Sha256FileThrowsForMissingFile) {
+        EXPECT_THROW(Sha256File(Root() + "/missing.bin"), std::runtime_error);
+    }
+
+    TEST_F(FileDigestTest, Sha256FileSpanningSeveralChunks) {
+        // Hơn hai khối đọc 4 MiB, khối cuối lẻ.
+        std::string content(9 * 1024 * 1024 + 17, '\0');
+        for (size_t i = 0; i < content.size(); ++i) content[i] = static_cast<char>(i * 31 + (i >> 12));
+        std::string path = Write("large.bin", content);
+
+        std::vector<uint8_t> expected(SHA256_DIGEST_LENGTH);
+        SHA256(reinterpret_cast<const unsigned char*>(content.data()), content.size(), expected.data());
+        EXPECT_EQ(Sha256File(path), expected);
+    }
+
+    TEST_F(FileDigestTest, Sha256FileStopsWhenCancelled) {
+        std::string path = Write("large.bin", std::string(9 * 1024 * 1024, 'x'));
+        CancellationToken token;
+        token.Cancel();
+        EXPECT_THROW(Sha256File(path, &token), OperationCancelled);
+    }
+
+    TEST_F(FileDigestTest, ExpandsDirectoriesInPathOrder) {
+        std::string b = Write("b.txt", "b");
+        std::string a = Write("a.txt", "a");
+        std::string nested = Write("nested/c.txt", "c");
+
+        EXPECT_EQ(ExpandFilePaths({ Root() }, true), (std::vector<std::string>{ a, b, nested }));
+        EXPECT_EQ(ExpandFilePaths({ Root() }, false), (std::vector<std::string>{ a, b }));
+    }
+
+    TEST_F(FileDigestTest, Sha256FilesReportsErrorsPerFile) {
+        std::string good = Write("abc.txt", "abc");
+        std::string missing = Root() + "/missing.bin";
+
+        auto digests = Sha256Files({ good, missing, good }, 2);
+        ASSERT_EQ(digests.size(), 3u);
+        EXPECT_EQ(digests[0].path, good);
+        EXPECT_TRUE(digests[0].error.empty());
+        EXPECT_EQ(digests[0].digest, digests[2].digest);
+        EXPECT_EQ(digests[1].path, missing);
+        EXPECT_FALSE(digests[1].error.empty());
+        EXPECT_TRUE(digests[1].digest.empty());
+    }
+
+}  // namespace
+}  // namespace nfcsigner
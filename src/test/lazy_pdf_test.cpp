@@ -0,0 +1,112 @@
+#include "lazy_pdf.h"
+#include "test_support.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace nfcsigner {
+namespace {
+
+    using test::MakeBlankPdf;
+    using test::MakePdf;
+
+    const char* kCatalog = "<< /Type /Catalog /Pages 2 0 R >>";
+    const char* kPages = "<< /Type /Pages /Kids [3 0 R] /Count 1 >>";
+    const char* kPage = "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 595 842] >>";
+
+    // Object stream chứa đúng một object [number] với nội dung [body].
+    std::string ObjectStream(uint32_t number, const std::string& body) {
+        std::string header = std::to_string(number) + " 0 ";
+        std::string data = header + body;
+        return "<< /Type /ObjStm /N 1 /First " + std::to_string(header.size()) + " /Length " +
+               std::to_string(data.size()) + " >>\nstream\n" + data + "\nendstream";
+    }
+
+    // Một dòng xref stream với /W [1 2 1].
+    std::string XrefRow(uint8_t type, uint16_t field2, uint8_t field3) {
+        return std::string{ static_cast<char>(type), static_cast<char>(field2 >> 8),
+                            static_cast<char>(field2 & 0xFF), static_cast<char>(field3) };
+    }
+
+    std::string XrefLine(size_t field2, int generation, char type) {
+        char line[32];
+        std::snprintf(line, sizeof(line), "%010zu %05d %c\r\n", field2, generation, type);
+        return line;
+    }
+
+    std::string StartXrefOf(const std::string& pdf) {
+        size_t start = pdf.rfind("startxref\n") + 10;
+        return pdf.substr(start, pdf.find('\n', start) - start);
+    }
+
+    std::vector<uint8_t> Bytes(const std::string& pdf) {
+        return std::vector<uint8_t>(pdf.begin(), pdf.end());
+    }
+
+    TEST(LazyPdfReaderTest, ReadsClassicXrefTable) {
+        auto pdf = MakeBlankPdf(2);
+        LazyPdfReader reader(pdf.data(), pdf.size());
+
+        EXPECT_FALSE(reader.UsesXrefStream());
+        EXPECT_EQ(reader.GetSize(), 5u);
+        EXPECT_EQ(reader.GetPageReference(1).objectNumber, 4u);
+        const LazyPdfValue& root = reader.Resolve(*reader.GetTrailer().Find("/Root"));
+        EXPECT_TRUE(root.Find("/Type")->IsName("/Catalog"));
+    }
+
+    TEST(LazyPdfReaderTest, ReadsXrefStream) {
+        auto classic = MakePdf({ "", kCatalog, kPages, kPage });
+        std::string pdf(classic.begin(), classic.end());
+        pdf.erase(pdf.find("xref\n"));
+
+        std::string rows = XrefRow(0, 0, 255);
+        for (uint32_t number = 1; number <= 3; ++number) {
+            size_t offset = pdf.find("\n" + std::to_string(number) + " 0 obj") + 1;
+            rows += XrefRow(1, static_cast<uint16_t>(offset), 0);
+        }
+        size_t xref = pdf.size();
+        rows += XrefRow(1, static_cast<uint16_t>(xref), 0);
+        pdf += "4 0 obj\n<< /Type /XRef /W [1 2 1] /Size 5 /Root 1 0 R /Length " + std::to_string(rows.size()) +
+               " >>\nstream\n" + rows + "\nendstream\nendobj\nstartxref\n" + std::to_string(xref) + "\n%%EOF\n";
+
+        auto bytes = Bytes(pdf);
+        LazyPdfReader reader(bytes.data(), bytes.size());
+        EXPECT_TRUE(reader.UsesXrefStream());
+        EXPECT_EQ(reader.GetSize(), 5u);
+        EXPECT_EQ(reader.GetPageReference(0).objectNumber, 3u);
+    }
+
+    // Revision lai: bảng ghi object 5 là 'f' cho reader cũ, /XRefStm cho biết
+    // nó nằm trong object stream 4.
+    TEST(LazyPdfReaderTest, HybridXrefStreamOverridesFreeTableEntries) {
+        auto base = MakePdf({ "", kCatalog, kPages, kPage, ObjectStream(5, "<< /Producer (hybrid) >>") });
+        std::string pdf(base.begin(), base.end());
+        std::string previous = StartXrefOf(pdf);
+
+        // Mục của object 6 trong stream trỏ sai chỗ: mục 'n' của bảng phải thắng.
+        std::string rows = XrefRow(2, 4, 0) + XrefRow(2, 4, 9);
+        size_t stream = pdf.size();
+        pdf += "6 0 obj\n<< /Type /XRef /W [1 2 1] /Index [5 2] /Size 7 /Length " + std::to_string(rows.size()) +
+               " >>\nstream\n" + rows + "\nendstream\nendobj\n";
+        size_t xref = pdf.size();
+        pdf += "xref\n0 1\n" + XrefLine(0, 65535, 'f') + "5 2\n" + XrefLine(0, 1, 'f') + XrefLine(stream, 0, 'n');
+        pdf += "trailer\n<< /Size 7 /Root 1 0 R /Info 5 0 R /Prev " + previous + " /XRefStm " +
+               std::to_string(stream) + " >>\nstartxref\n" + std::to_string(xref) + "\n%%EOF\n";
+
+        auto bytes = Bytes(pdf);
+        LazyPdfReader reader(bytes.data(), bytes.size());
+        EXPECT_FALSE(reader.UsesXrefStream());
+        EXPECT_EQ(reader.GetSize(), 7u);
+
+        const LazyPdfValue& info = reader.Resolve(*reader.GetTrailer().Find("/Info"));
+        ASSERT_EQ(info.kind, LazyPdfValue::Kind::Dictionary);
+        EXPECT_EQ(info.Find("/Producer")->token, "(hybrid)");
+        EXPECT_TRUE(reader.GetObject(6).value.Find("/Type")->IsName("/XRef"));
+        EXPECT_EQ(reader.GetPageReference(0).objectNumber, 3u);
+    }
+
+}  // namespace
+}  // namespace nfcsigner
@@ -0,0 +1,68 @@
+// Unix domain socket chỉ có trên Linux; named pipe không có quyền kiểu file.
+#ifndef _WIN32
+
+#include "local_socket.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nfcsigner {
+namespace {
+
+    std::string TestEndpoint(const char* name) {
+        return ::testing::TempDir() + "nfcsigner-" + name + "-" + std::to_string(getpid()) + ".sock";
+    }
+
+    unsigned SocketMode(const std::string& path) {
+        struct stat info = {};
+        EXPECT_EQ(stat(path.c_str(), &info), 0);
+        return info.st_mode & 0777;
+    }
+
+    TEST(LocalSocketTest, SocketIsPrivateByDefault) {
+        auto endpoint = TestEndpoint("private");
+        auto listener = LocalListener::Listen(endpoint);
+        EXPECT_EQ(SocketMode(endpoint), 0600u);
+    }
+
+    TEST(LocalSocketTest, ModeIsConfigurable) {
+        auto endpoint = TestEndpoint("shared");
+        LocalListenerOptions options;
+        options.mode = 0660;
+        auto listener = LocalListener::Listen(endpoint, options);
+        EXPECT_EQ(SocketMode(endpoint), 0660u);
+    }
+
+    TEST(LocalSocketTest, UnknownGroupFailsWithoutLeavingSocket) {
+        auto endpoint = TestEndpoint("group");
+        LocalListenerOptions options;
+        options.group = "nfcsigner-no-such-group";
+        EXPECT_THROW(LocalListener::Listen(endpoint, options), std::runtime_error);
+        EXPECT_NE(access(endpoint.c_str(), F_OK), 0);
+    }
+
+    TEST(LocalSocketTest, ShutdownWakesPendingRead) {
+        auto endpoint = TestEndpoint("shutdown");
+        auto listener = LocalListener::Listen(endpoint);
+        auto client = LocalConnection::Connect(endpoint);
+        auto server = listener->Accept();
+        ASSERT_NE(server, nullptr);
+
+        auto read = std::async(std::launch::async, [&]() {
+            std::vector<uint8_t> frame;
+            return server->ReadFrame(frame);
+        });
+        server->Shutdown();
+        ASSERT_EQ(read.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_FALSE(read.get());
+    }
+
+}  // namespace
+}  // namespace nfcsigner
+
+#endif  // _WIN32
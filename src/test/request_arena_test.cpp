@@ -0,0 +1,89 @@
+#include "lazy_pdf.h"
+#include "request_arena.h"
+
+#include <gtest/gtest.h>
+
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+namespace nfcsigner {
+namespace {
+
+    LazyPdfValue MakeKids() {
+        LazyPdfValue kids = LazyPdfValue::Array();
+        kids.items.push_back(LazyPdfValue::Reference(3));
+        kids.items.push_back(LazyPdfValue::Reference(4));
+        LazyPdfValue pages = LazyPdfValue::Dictionary();
+        pages.Set("/Kids", std::move(kids));
+        return pages;
+    }
+
+    TEST(RequestArenaTest, BindsOnlyInsideScope) {
+        RequestArena arena;
+        EXPECT_EQ(CurrentRequestArena(), std::pmr::new_delete_resource());
+        {
+            RequestArena::Scope scope(&arena);
+            EXPECT_EQ(CurrentRequestArena(), &arena);
+            // Thread khác của request phải tự gắn arena.
+            std::pmr::memory_resource* other = nullptr;
+            std::thread([&]() { other = CurrentRequestArena(); }).join();
+            EXPECT_EQ(other, std::pmr::new_delete_resource());
+        }
+        EXPECT_EQ(CurrentRequestArena(), std::pmr::new_delete_resource());
+    }
+
+    TEST(RequestArenaTest, MoveWithinArenaKeepsStorage) {
+        RequestArena arena;
+        RequestArena::Scope scope(&arena);
+        LazyPdfValue pages = MakeKids();
+        const auto* storage = pages.entries.data();
+
+        LazyPdfValue moved(std::move(pages));
+        EXPECT_EQ(moved.entries.data(), storage);
+        EXPECT_EQ(moved.entries.get_allocator().resource(), &arena);
+    }
+
+    TEST(RequestArenaTest, GrowingArraysMoveNestedValues) {
+        static_assert(std::is_nothrow_move_constructible_v<LazyPdfValue>);
+        RequestArena arena;
+        RequestArena::Scope scope(&arena);
+        LazyPdfValue array = LazyPdfValue::Array();
+        array.items.push_back(MakeKids());
+        const auto* storage = array.items[0].entries.data();
+        const char* key = array.items[0].entries[0].first.data();
+
+        // Tăng dung lượng dời phần tử bằng move: cây con giữ nguyên bộ nhớ.
+        for (uint32_t i = 0; i < 64; ++i) array.items.push_back(LazyPdfValue::Reference(i));
+        EXPECT_EQ(array.items[0].entries.data(), storage);
+        EXPECT_EQ(array.items[0].entries[0].first.data(), key);
+        EXPECT_EQ(array.items[0].entries[0].first.get_allocator().resource(), &arena);
+    }
+
+    TEST(RequestArenaTest, MoveOutOfArenaCopiesToHeap) {
+        std::optional<LazyPdfValue> outlived;
+        {
+            RequestArena arena;
+            std::optional<LazyPdfValue> pages;
+            {
+                RequestArena::Scope scope(&arena);
+                pages.emplace(MakeKids());
+            }
+            ASSERT_EQ(pages->entries.get_allocator().resource(), &arena);
+            outlived.emplace(std::move(*pages));
+        }
+
+        std::pmr::memory_resource* heap = std::pmr::new_delete_resource();
+        EXPECT_EQ(outlived->entries.get_allocator().resource(), heap);
+        const LazyPdfValue* kids = outlived->Find("/Kids");
+        ASSERT_NE(kids, nullptr);
+        EXPECT_EQ(kids->items.get_allocator().resource(), heap);
+        std::string out;
+        outlived->Serialize(out);
+        EXPECT_EQ(out, "<</Kids [3 0 R 4 0 R] >>");
+    }
+
+}  // namespace
+}  // namespace nfcsigner
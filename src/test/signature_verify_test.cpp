@@ -0,0 +1,217 @@
+#include "signature_verify.h"
+#include "cms_template.h"
+#include "lazy_pdf.h"
+#include "test_support.h"
+
+#include <gtest/gtest.h>
+
+#include <openssl/cms.h>
+#include <openssl/sha.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace nfcsigner {
+namespace {
+
+    using test::TestKey;
+
+    const TestKey& Key() {
+        static const TestKey key("Nguyễn Văn A");
+        return key;
+    }
+
+    CardSignFunction SignWith(const TestKey& key) {
+        return [&key](const std::vector<uint8_t>& digestInfo) { return key.Sign(digestInfo); };
+    }
+
+    std::vector<uint8_t> Sha256(const std::vector<uint8_t>& data) {
+        std::vector<uint8_t> digest(SHA256_DIGEST_LENGTH);
+        SHA256(data.data(), data.size(), digest.data());
+        return digest;
+    }
+
+    // SignedData tách rời do CmsTemplate dựng, như signFile.
+    std::vector<uint8_t> DetachedCms(const std::vector<uint8_t>& content, std::time_t signingTime = 1700000000) {
+        auto cmsTemplate = CmsTemplate::Create(Key().GetCertificate());
+        return cmsTemplate->BuildSignedData(Sha256(content).data(), signingTime, SignWith(Key()));
+    }
+
+    // SignedData tách rời có hai SignerInfo (Key() rồi [second]); chữ ký của
+    // signer thứ hai bị lật một bit nếu [corruptSecond].
+    std::vector<uint8_t> CoSignedCms(const std::vector<uint8_t>& content, const TestKey& second, bool corruptSecond) {
+        auto toX509 = [](const std::vector<uint8_t>& der) {
+            const unsigned char* in = der.data();
+            return std::unique_ptr<X509, decltype(&X509_free)>(d2i_X509(nullptr, &in, static_cast<long>(der.size())),
+                                                               &X509_free);
+        };
+        auto firstCert = toX509(Key().GetCertificate());
+        auto secondCert = toX509(second.GetCertificate());
+        std::unique_ptr<BIO, decltype(&BIO_free)> data(BIO_new_mem_buf(content.data(), static_cast<int>(content.size())),
+                                                       &BIO_free);
+        const unsigned int flags = CMS_DETACHED | CMS_BINARY;
+        std::unique_ptr<CMS_ContentInfo, decltype(&CMS_ContentInfo_free)> cms(
+                CMS_sign(firstCert.get(), Key().GetKey(), nullptr, nullptr, flags | CMS_PARTIAL),
+                &CMS_ContentInfo_free);
+        CMS_add1_signer(cms.get(), secondCert.get(), second.GetKey(), EVP_sha256(), flags);
+        CMS_final(cms.get(), data.get(), nullptr, flags);
+        if (corruptSecond) {
+            ASN1_OCTET_STRING* signature = CMS_SignerInfo_get0_signature(sk_CMS_SignerInfo_value(
+                    CMS_get0_SignerInfos(cms.get()), 1));
+            signature->data[signature->length - 1] ^= 0x01;
+        }
+        std::vector<uint8_t> der(static_cast<size_t>(i2d_CMS_ContentInfo(cms.get(), nullptr)));
+        unsigned char* out = der.data();
+        i2d_CMS_ContentInfo(cms.get(), &out);
+        return der;
+    }
+
+    TEST(SignatureVerifyTest, DetachedCmsVerifiesAgainstItsContent) {
+        std::vector<uint8_t> content = { 'h', 'e', 'l', 'l', 'o' };
+        auto verification = VerifyCms(DetachedCms(content), content.data(), content.size());
+
+        EXPECT_TRUE(verification.valid) << verification.error;
+        EXPECT_TRUE(verification.digestValid);
+        EXPECT_TRUE(verification.signatureValid);
+        EXPECT_EQ(verification.digestAlgorithm, "sha256");
+        EXPECT_EQ(verification.certificate, Key().GetCertificate());
+        EXPECT_NE(verification.signer.find("CN=Nguy"), std::string::npos);
+        EXPECT_EQ(verification.signingTime, 1700000000);
+    }
+
+    TEST(SignatureVerifyTest, DetachedCmsRejectsModifiedContent) {
+        std::vector<uint8_t> content = { 'h', 'e', 'l', 'l', 'o' };
+        auto cms = DetachedCms(content);
+        content[0] = 'H';
+        auto verification = VerifyCms(cms, content.data(), content.size());
+
+        EXPECT_FALSE(verification.valid);
+        EXPECT_FALSE(verification.digestValid);
+        EXPECT_TRUE(verification.signatureValid);
+        EXPECT_FALSE(verification.error.empty());
+    }
+
+    TEST(SignatureVerifyTest, CmsWithCorruptedSignatureIsInvalid) {
+        std::vector<uint8_t> content = { 1, 2, 3 };
+        auto cms = DetachedCms(content);
+        cms[cms.size() - 1] ^= 0x01;  // byte cuối thuộc giá trị chữ ký
+        auto verification = VerifyCms(cms, content.data(), content.size());
+
+        EXPECT_FALSE(verification.valid);
+        EXPECT_TRUE(verification.digestValid);
+        EXPECT_FALSE(verification.signatureValid);
+    }
+
+    TEST(SignatureVerifyTest, CmsWithSeveralSignersChecksEverySigner) {
+        std::vector<uint8_t> content = { 'h', 'e', 'l', 'l', 'o' };
+        TestKey other("Trần Thị B");
+
+        auto both = VerifyCms(CoSignedCms(content, other, false), content.data(), content.size());
+        EXPECT_TRUE(both.valid) << both.error;
+        EXPECT_TRUE(both.certificate == Key().GetCertificate() || both.certificate == other.GetCertificate());
+
+        auto secondBroken = VerifyCms(CoSignedCms(content, other, true), content.data(), content.size());
+        EXPECT_FALSE(secondBroken.valid);
+        EXPECT_TRUE(secondBroken.digestValid);
+        EXPECT_FALSE(secondBroken.signatureValid);
+        // SignerInfos là SET OF nên DER có thể đổi thứ tự hai signer.
+        EXPECT_EQ(secondBroken.error.rfind("SignerInfo ", 0), 0u) << secondBroken.error;
+    }
+
+    TEST(SignatureVerifyTest, MalformedCmsReportsError) {
+        std::vector<uint8_t> garbage = { 0x30, 0x03, 0x02, 0x01, 0x00 };
+        auto verification = VerifyCms(garbage, nullptr, 0);
+        EXPECT_FALSE(verification.valid);
+        EXPECT_FALSE(verification.error.empty());
+    }
+
+    TEST(SignatureVerifyTest, CmsFileIsHashedFromDisk) {
+        std::string path = testing::TempDir() + "nfcsigner_cms_content.bin";
+        std::vector<uint8_t> content(300000);
+        for (size_t i = 0; i < content.size(); ++i) content[i] = static_cast<uint8_t>(i * 31);
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(content.data()),
+                                                    static_cast<std::streamsize>(content.size()));
+
+        auto verification = VerifyCmsFile(DetachedCms(content), path);
+        std::remove(path.c_str());
+        EXPECT_TRUE(verification.valid) << verification.error;
+    }
+
+    TEST(SignatureVerifyTest, RawSignatureOverDigestInfo) {
+        std::vector<uint8_t> data = { 'a', 'b', 'c' };
+        auto digestInfo = CreateSha256DigestInfo(Sha256(data).data());
+        auto signature = Key().Sign(digestInfo);
+
+        EXPECT_TRUE(VerifySignature(Key().GetCertificate(), digestInfo, signature, ""));
+        EXPECT_TRUE(VerifySignature(Key().GetCertificate(), data, signature, "sha256"));
+        EXPECT_FALSE(VerifySignature(Key().GetCertificate(), { 'a', 'b', 'd' }, signature, "sha256"));
+
+        TestKey other("other");
+        EXPECT_FALSE(VerifySignature(other.GetCertificate(), digestInfo, signature, ""));
+    }
+
+    TEST(SignatureVerifyTest, DigestInfoKnownAnswer) {
+        // DigestInfo SHA-256 của "abc" theo RFC 8017 (tiền tố cố định + digest).
+        auto digestInfo = CreateSha256DigestInfo(Sha256({ 'a', 'b', 'c' }).data());
+        const std::vector<uint8_t> expected = {
+                0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00,
+                0x04, 0x20, 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22,
+                0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+        };
+        EXPECT_EQ(digestInfo, expected);
+    }
+
+    std::vector<uint8_t> SignedPdf(const std::vector<uint8_t>& pdf, const std::string& fieldName) {
+        LazyPdfSignParams params;
+        params.fieldName = fieldName;
+        params.signingTime = 1700000000;
+        auto cmsTemplate = CmsTemplate::Create(Key().GetCertificate());
+        return SignPdfIncremental(pdf, params, LazyPdfAppearance(), *cmsTemplate, SignWith(Key()));
+    }
+
+    TEST(SignatureVerifyTest, PdfSignaturesVerifyInFieldOrder) {
+        auto once = SignedPdf(test::MakeBlankPdf(), "First");
+        auto twice = SignedPdf(once, "Second");
+
+        auto verifications = VerifyPdf(twice, 2);
+        ASSERT_EQ(verifications.size(), 2u);
+        EXPECT_EQ(verifications[0].fieldName, "First");
+        EXPECT_EQ(verifications[1].fieldName, "Second");
+        for (const auto& verification : verifications) {
+            EXPECT_TRUE(verification.valid) << verification.fieldName << ": " << verification.error;
+        }
+        // Chỉ chữ ký cuối phủ tới cuối file.
+        EXPECT_FALSE(verifications[0].coversWholeDocument);
+        EXPECT_TRUE(verifications[1].coversWholeDocument);
+    }
+
+    TEST(SignatureVerifyTest, PdfModifiedInsideByteRangeIsInvalid) {
+        auto signedPdf = SignedPdf(test::MakeBlankPdf(), "Signature1");
+        // Đổi một byte của phần đầu tài liệu (MediaBox), vẫn đọc được cấu trúc.
+        std::string text(signedPdf.begin(), signedPdf.end());
+        size_t pos = text.find("595 842");
+        ASSERT_NE(pos, std::string::npos);
+        signedPdf[pos] = '6';
+
+        auto verifications = VerifyPdf(signedPdf);
+        ASSERT_EQ(verifications.size(), 1u);
+        EXPECT_FALSE(verifications[0].valid);
+        EXPECT_FALSE(verifications[0].digestValid);
+    }
+
+    TEST(SignatureVerifyTest, PdfBatchKeepsBrokenDocumentsSeparate) {
+        auto signedPdf = SignedPdf(test::MakeBlankPdf(), "Signature1");
+        std::vector<uint8_t> broken = { '%', 'P', 'D', 'F' };
+
+        auto results = VerifyPdfBatch({ signedPdf, broken, test::MakeBlankPdf() });
+        ASSERT_EQ(results.size(), 3u);
+        ASSERT_EQ(results[0].signatures.size(), 1u);
+        EXPECT_TRUE(results[0].signatures[0].valid) << results[0].signatures[0].error;
+        EXPECT_TRUE(results[2].error.empty());
+        EXPECT_TRUE(results[2].signatures.empty());
+    }
+
+}  // namespace
+}  // namespace nfcsigner
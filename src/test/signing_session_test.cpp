@@ -0,0 +1,84 @@
+// Phiên ký chỉ có khi build với PoDoFo.
+#ifdef HAVE_PODOFO
+
+#include "signing_session.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace nfcsigner {
+namespace {
+
+    class SigningSessionRegistryTest : public ::testing::Test {
+    protected:
+        SigningSessionRegistry& registry = SigningSessionRegistry::Instance();
+
+        void TearDown() override {
+            registry.SetIdleTimeout(SigningSessionRegistry::kDefaultIdleTimeout);
+        }
+    };
+
+    TEST_F(SigningSessionRegistryTest, ClosedSessionOutlivesItsLastUse) {
+        auto session = std::make_shared<SigningSession>();
+        std::weak_ptr<SigningSession> weak = session;
+        int64_t handle = registry.Add(std::move(session));
+
+        auto inUse = registry.Get(handle);
+        ASSERT_NE(inUse, nullptr);
+        EXPECT_TRUE(registry.Remove(handle));
+        EXPECT_EQ(registry.Get(handle), nullptr);
+        EXPECT_FALSE(registry.Remove(handle));
+        // Lần ký đang chạy vẫn giữ phiên tới khi xong.
+        EXPECT_FALSE(weak.expired());
+        inUse.reset();
+        EXPECT_TRUE(weak.expired());
+    }
+
+    TEST_F(SigningSessionRegistryTest, SweepClosesOnlyIdleSessions) {
+        registry.SetIdleTimeout(std::chrono::minutes(5));
+        int64_t idle = registry.Add(std::make_shared<SigningSession>());
+        int64_t busy = registry.Add(std::make_shared<SigningSession>());
+        auto now = std::chrono::steady_clock::now();
+
+        EXPECT_EQ(registry.SweepIdle(now + std::chrono::minutes(1)), 0u);
+        EXPECT_NE(registry.Get(idle), nullptr);
+        EXPECT_NE(registry.Get(busy), nullptr);
+
+        // Get gia hạn phiên; sweep tính từ lần dùng cuối.
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        auto lastUse = std::chrono::steady_clock::now();
+        ASSERT_NE(registry.Get(busy), nullptr);
+        EXPECT_EQ(registry.SweepIdle(lastUse + std::chrono::minutes(5) - std::chrono::milliseconds(10)), 1u);
+        EXPECT_EQ(registry.Get(idle), nullptr);
+        EXPECT_TRUE(registry.Remove(busy));
+    }
+
+    TEST_F(SigningSessionRegistryTest, ZeroTimeoutKeepsSessionsOpen) {
+        registry.SetIdleTimeout(std::chrono::milliseconds(0));
+        int64_t handle = registry.Add(std::make_shared<SigningSession>());
+
+        EXPECT_EQ(registry.SweepIdle(std::chrono::steady_clock::now() + std::chrono::hours(24)), 0u);
+        EXPECT_TRUE(registry.Remove(handle));
+    }
+
+    TEST_F(SigningSessionRegistryTest, BackgroundSweeperClosesForgottenSession) {
+        registry.SetIdleTimeout(std::chrono::milliseconds(50));
+        auto session = std::make_shared<SigningSession>();
+        std::weak_ptr<SigningSession> weak = session;
+        int64_t handle = registry.Add(std::move(session));
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!weak.expired() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        EXPECT_TRUE(weak.expired());
+        EXPECT_EQ(registry.Get(handle), nullptr);
+    }
+
+}  // namespace
+}  // namespace nfcsigner
+
+#endif  // HAVE_PODOFO
@@ -0,0 +1,113 @@
+#include "single_flight.h"
+#include "card_scheduler.h"
+#include "worker_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+namespace nfcsigner {
+namespace {
+
+    using Bytes = SingleFlight::Result;
+
+    // Chờ tới khi [flight] đã ghép được [count] lần đọc.
+    void WaitForShared(const SingleFlight& flight, size_t count) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (flight.GetSharedCount() < count) {
+            ASSERT_LT(std::chrono::steady_clock::now(), deadline) << "callers never joined the read";
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    TEST(SingleFlightTest, ConcurrentCallersShareOneCardRead) {
+        SingleFlight flight;
+        WorkerPool pool(2, 0);
+        std::atomic<int> reads{0};
+        std::promise<void> readStarted;
+        std::promise<void> cardAnswers;
+        std::shared_future<void> answered = cardAnswers.get_future().share();
+
+        // Như HandleGetCertificate: lần đọc giữ reader qua CardScheduler.
+        auto load = [&]() {
+            auto ticket = CardScheduler::Instance().Acquire(CardPriority::Interactive);
+            if (!ticket) throw std::runtime_error("reader busy");
+            if (++reads == 1) readStarted.set_value();
+            answered.wait();
+            return Bytes{ 0x30, 0x82 };
+        };
+        auto call = [&]() {
+            auto outcome = std::make_shared<std::promise<std::pair<Bytes, bool>>>();
+            auto future = outcome->get_future();
+            EXPECT_TRUE(pool.Submit([&, outcome]() {
+                bool shared = false;
+                Bytes certificate = flight.Do("getCertificate|A000000001", load, &shared);
+                outcome->set_value({ certificate, shared });
+            }));
+            return future;
+        };
+
+        auto first = call();
+        readStarted.get_future().wait();
+        auto second = call();
+        WaitForShared(flight, 1);
+        cardAnswers.set_value();
+
+        auto firstResult = first.get();
+        auto secondResult = second.get();
+        EXPECT_EQ(reads.load(), 1);
+        EXPECT_EQ(firstResult.first, (Bytes{ 0x30, 0x82 }));
+        EXPECT_EQ(secondResult.first, firstResult.first);
+        EXPECT_FALSE(firstResult.second);
+        EXPECT_TRUE(secondResult.second);
+    }
+
+    TEST(SingleFlightTest, SharedCallerReceivesTheSameError) {
+        SingleFlight flight;
+        std::promise<void> readStarted;
+        std::promise<void> fail;
+        std::shared_future<void> failed = fail.get_future().share();
+
+        auto first = std::async(std::launch::async, [&]() {
+            return flight.Do("key", [&]() -> Bytes {
+                readStarted.set_value();
+                failed.wait();
+                throw std::runtime_error("card removed");
+            });
+        });
+        readStarted.get_future().wait();
+        auto second = std::async(std::launch::async, [&]() { return flight.Do("key", []() { return Bytes{ 1 }; }); });
+        WaitForShared(flight, 1);
+        fail.set_value();
+
+        EXPECT_THROW(first.get(), std::runtime_error);
+        EXPECT_THROW(second.get(), std::runtime_error);
+    }
+
+    TEST(SingleFlightTest, ReadAfterCompletionStartsFresh) {
+        SingleFlight flight;
+        int reads = 0;
+        auto load = [&]() { ++reads; return Bytes{ static_cast<uint8_t>(reads) }; };
+        bool shared = true;
+        EXPECT_EQ(flight.Do("key", load, &shared), Bytes{ 1 });
+        EXPECT_FALSE(shared);
+        EXPECT_EQ(flight.Do("key", load, &shared), Bytes{ 2 });
+        EXPECT_FALSE(shared);
+        EXPECT_EQ(flight.GetSharedCount(), 0u);
+    }
+
+    TEST(SingleFlightTest, DifferentKeysDoNotShare) {
+        SingleFlight flight;
+        std::atomic<int> reads{0};
+        auto load = [&]() { ++reads; return Bytes{}; };
+        flight.Do("getCertificate|A1", load);
+        flight.Do("getRsaPublicKey|A1|sig", load);
+        EXPECT_EQ(reads.load(), 2);
+    }
+
+}  // namespace
+}  // namespace nfcsigner
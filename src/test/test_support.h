@@ -0,0 +1,98 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_TEST_SUPPORT_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_TEST_SUPPORT_H_
+
+// Khóa RSA tạm, certificate tự ký và PDF tối giản cho unit test của lõi.
+
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nfcsigner {
+namespace test {
+
+    // Khóa RSA 2048 bit cùng certificate tự ký, ký như applet trên thẻ
+    // (PKCS#1 v1.5 trên DigestInfo đã dựng sẵn).
+    class TestKey {
+    public:
+        explicit TestKey(const char* commonName = "nfcsigner test") : key_(EVP_RSA_gen(2048), &EVP_PKEY_free) {
+            std::unique_ptr<X509, decltype(&X509_free)> cert(X509_new(), &X509_free);
+            ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 1);
+            X509_gmtime_adj(X509_getm_notBefore(cert.get()), 0);
+            X509_gmtime_adj(X509_getm_notAfter(cert.get()), 3600);
+            X509_set_pubkey(cert.get(), key_.get());
+            X509_NAME* name = X509_get_subject_name(cert.get());
+            X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_UTF8,
+                                       reinterpret_cast<const unsigned char*>(commonName), -1, -1, 0);
+            X509_set_issuer_name(cert.get(), name);
+            X509_sign(cert.get(), key_.get(), EVP_sha256());
+            int length = i2d_X509(cert.get(), nullptr);
+            certificate_.resize(static_cast<size_t>(length));
+            unsigned char* out = certificate_.data();
+            i2d_X509(cert.get(), &out);
+        }
+
+        EVP_PKEY* GetKey() const { return key_.get(); }
+        const std::vector<uint8_t>& GetCertificate() const { return certificate_; }
+
+        std::vector<uint8_t> Sign(const std::vector<uint8_t>& digestInfo) const {
+            std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> ctx(EVP_PKEY_CTX_new(key_.get(), nullptr),
+                                                                            &EVP_PKEY_CTX_free);
+            EVP_PKEY_sign_init(ctx.get());
+            EVP_PKEY_CTX_set_rsa_padding(ctx.get(), RSA_PKCS1_PADDING);
+            size_t length = 0;
+            EVP_PKEY_sign(ctx.get(), nullptr, &length, digestInfo.data(), digestInfo.size());
+            std::vector<uint8_t> signature(length);
+            EVP_PKEY_sign(ctx.get(), signature.data(), &length, digestInfo.data(), digestInfo.size());
+            signature.resize(length);
+            return signature;
+        }
+
+    private:
+        std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key_;
+        std::vector<uint8_t> certificate_;
+    };
+
+    // Ghép [objects] (object i ở vị trí i, vị trí 0 bỏ trống) thành PDF có bảng
+    // xref cổ điển và trailer trỏ /Root tới object 1.
+    inline std::vector<uint8_t> MakePdf(const std::vector<std::string>& objects) {
+        std::string pdf = "%PDF-1.4\n%\xE2\xE3\xCF\xD3\n";
+        std::vector<size_t> offsets(objects.size(), 0);
+        for (size_t i = 1; i < objects.size(); ++i) {
+            offsets[i] = pdf.size();
+            pdf += std::to_string(i) + " 0 obj\n" + objects[i] + "\nendobj\n";
+        }
+        size_t xref = pdf.size();
+        pdf += "xref\n0 " + std::to_string(objects.size()) + "\n0000000000 65535 f\r\n";
+        for (size_t i = 1; i < objects.size(); ++i) {
+            char line[32];
+            std::snprintf(line, sizeof(line), "%010zu 00000 n\r\n", offsets[i]);
+            pdf += line;
+        }
+        pdf += "trailer\n<< /Size " + std::to_string(objects.size()) + " /Root 1 0 R >>\nstartxref\n" +
+               std::to_string(xref) + "\n%%EOF\n";
+        return std::vector<uint8_t>(pdf.begin(), pdf.end());
+    }
+
+    // Tài liệu [pages] trang trống khổ A4.
+    inline std::vector<uint8_t> MakeBlankPdf(int pages = 1) {
+        std::vector<std::string> objects(3);
+        objects[1] = "<< /Type /Catalog /Pages 2 0 R >>";
+        std::string kids;
+        for (int i = 0; i < pages; ++i) {
+            kids += std::to_string(objects.size()) + " 0 R ";
+            objects.push_back("<< /Type /Page /Parent 2 0 R /MediaBox [0 0 595 842] >>");
+        }
+        objects[2] = "<< /Type /Pages /Kids [" + kids + "] /Count " + std::to_string(pages) + " >>";
+        return MakePdf(objects);
+    }
+
+}  // namespace test
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_TEST_SUPPORT_H_
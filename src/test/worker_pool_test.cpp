@@ -0,0 +1,82 @@
+#include "worker_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+
+namespace nfcsigner {
+namespace {
+
+    TEST(WorkerPoolTest, RunsEverySubmittedTaskBeforeShutdownReturns) {
+        WorkerPool pool(4, 0);
+        std::atomic<int> count{0};
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_TRUE(pool.Submit([&count]() { ++count; }));
+        }
+        pool.Shutdown();
+        EXPECT_EQ(count.load(), 100);
+    }
+
+    TEST(WorkerPoolTest, RejectsWhenQueueIsFull) {
+        WorkerPool pool(1, 1);
+        std::promise<void> started;
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        ASSERT_TRUE(pool.Submit([&started, released]() {
+            started.set_value();
+            released.wait();
+        }));
+        started.get_future().wait();
+
+        EXPECT_TRUE(pool.Submit([]() {}));
+        EXPECT_EQ(pool.GetPendingCount(), 1u);
+        EXPECT_FALSE(pool.Submit([]() {}));
+
+        release.set_value();
+        pool.Shutdown();
+        EXPECT_EQ(pool.GetPendingCount(), 0u);
+    }
+
+    TEST(WorkerPoolTest, RejectsAfterShutdown) {
+        WorkerPool pool(2, 0);
+        pool.Shutdown();
+        EXPECT_FALSE(pool.Submit([]() {}));
+        pool.Shutdown();
+    }
+
+    TEST(WorkerPoolTest, FailingTaskDoesNotStopTheWorker) {
+        WorkerPool pool(1, 0);
+        std::atomic<bool> ran{false};
+        ASSERT_TRUE(pool.Submit([]() { throw std::runtime_error("boom"); }));
+        ASSERT_TRUE(pool.Submit([&ran]() { ran = true; }));
+        pool.Shutdown();
+        EXPECT_TRUE(ran.load());
+    }
+
+    TEST(WorkerPoolTest, RunsTasksConcurrently) {
+        WorkerPool pool(2, 0);
+        std::promise<void> first;
+        std::promise<void> second;
+        auto firstDone = first.get_future();
+        auto secondDone = second.get_future();
+        // Mỗi việc chờ việc kia: chỉ xong được khi hai luồng chạy cùng lúc.
+        std::shared_future<void> firstShared = firstDone.share();
+        std::shared_future<void> secondShared = secondDone.share();
+        ASSERT_TRUE(pool.Submit([&first, secondShared]() {
+            first.set_value();
+            secondShared.wait();
+        }));
+        ASSERT_TRUE(pool.Submit([&second, firstShared]() {
+            second.set_value();
+            firstShared.wait();
+        }));
+        EXPECT_EQ(firstShared.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_EQ(secondShared.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        pool.Shutdown();
+    }
+
+}  // namespace
+}  // namespace nfcsigner
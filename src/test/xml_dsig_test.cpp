@@ -0,0 +1,153 @@
+#include "xml_dsig.h"
+#include "byte_codec.h"
+#include "cms_template.h"
+#include "test_support.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nfcsigner {
+namespace {
+
+    using test::TestKey;
+
+    const TestKey& CardKey() {
+        static const TestKey key("xml signer");
+        return key;
+    }
+
+    CardSignFunction SignWithCardKey() {
+        return [](const std::vector<uint8_t>& digestInfo) { return CardKey().Sign(digestInfo); };
+    }
+
+    // Kết quả mong đợi tính độc lập bằng libxml2 (xmlC14NDocDumpMemory trên
+    // node-set của tài liệu / phần tử được tham chiếu / SignedInfo đã chèn).
+    const char* kInvoice =
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!-- c -->\n"
+            "<HDon xmlns=\"urn:a\" xmlns:x=\"urn:x\" b=\"2\"  a=\"1\">\r\n"
+            "  <DLHDon Id=\"data\"><x:T   z=\"a&#9;b\" y=\"&lt;&quot;\"/>A &amp; B<![CDATA[<c>]]></DLHDon>\n"
+            "<DSCKS><NBan/></DSCKS></HDon>\n";
+    const char* kLangDocument =
+            "<r:Root xmlns:r=\"urn:r\" xmlns:u=\"urn:unused\" xml:lang=\"vi\">"
+            "<r:Item  Id=\"i1\" r:k=\"v\" xmlns=\"urn:d\">\xC4\x90\xC6\xA1n gi\xC3\xA1 &#x20AC; 10&gt;9</r:Item>"
+            "<Empty></Empty><?pi data?></r:Root>";
+
+    struct C14nVector {
+        const char* name;
+        const char* xml;
+        const char* canonicalizationMethod;
+        const char* referenceUri;
+        const char* xpath;
+        const char* referenceDigest;
+        const char* signedInfoDigest;
+    };
+
+    const C14nVector kC14nVectors[] = {
+            { "InclusiveWholeDocument", kInvoice, kXmlC14n, "", "",
+              "GTqyYAByC2tRelfCIu+Iw6xVI+DVb0C+7HKkRk3sSUE=", "uVrMyIjmsPXxqb1XVasj6BD8ML+OKPFepbvdmntsrj0=" },
+            { "InclusiveIdReference", kInvoice, kXmlC14n, "#data", "",
+              "N3TDKoquC3ipa1fgo5IZjPxx5zPm7vOQwrQ7oHeCCP4=", "nPR9L+8eZDwLCLFD0as1VusGLNsUxPWHLUg+mDDMJbw=" },
+            { "ExclusiveIdReferenceAtXPath", kInvoice, kXmlExcC14n, "#data", "/HDon/DSCKS/NBan",
+              "La/4FQPpmSlySSUpzjAm4ZhOdzNo20MI2nIwD3pPxtQ=", "fIzgUT5Cwyte4B9R4DRbMpvsoIf4w68cjNweDDqkEyU=" },
+            { "ExclusiveDropsUnusedNamespaces", kLangDocument, kXmlExcC14n, "#i1", "",
+              "znLAE+YLYCtLEla7YOvjUZmbJ94Ow4LP1X2UA3vBNOc=", "sXjZ1OU7jP8u3pQR60y4m7x3XUkLPPoSeS8QKrvK05c=" },
+            // SignedInfo thừa hưởng xml:lang của phần tử gốc (C14N 1.0 mục 2.4).
+            { "InclusiveInheritsXmlAttributes", kLangDocument, kXmlC14n, "", "",
+              "+MavaA8t+Jvp+NhmxrXh1zd/pcRjHYp4x5genb1pw08=", "obAXKkmoEl0nhFU7xasP1cHb+Y5X1QTcHL2wXv97L4Y=" },
+    };
+
+    class XmlDsigC14nTest : public ::testing::TestWithParam<C14nVector> {};
+
+    TEST_P(XmlDsigC14nTest, DigestsMatchKnownAnswers) {
+        const C14nVector& vector = GetParam();
+        XmlDsigConfig config;
+        config.signatureId = "sig-1";
+        config.canonicalizationMethod = vector.canonicalizationMethod;
+        config.referenceUri = vector.referenceUri;
+        config.xpath = vector.xpath;
+        XmlDsigDocument document(vector.xml, config);
+
+        EXPECT_EQ(EncodeBase64(document.GetReferenceDigest()), vector.referenceDigest);
+        EXPECT_EQ(document.CreateSignedInfoDigestInfo(),
+                  CreateSha256DigestInfo(DecodeBase64(std::string(vector.signedInfoDigest)).data()));
+    }
+
+    INSTANTIATE_TEST_SUITE_P(Vectors, XmlDsigC14nTest, ::testing::ValuesIn(kC14nVectors),
+                             [](const ::testing::TestParamInfo<C14nVector>& info) { return info.param.name; });
+
+    TEST(XmlDsigDocumentTest, EmbedsSignatureBeforeContainerEnd) {
+        XmlDsigConfig config;
+        config.signatureId = "sig-1";
+        XmlDsigDocument document(kInvoice, config);
+        XmlDsigKeyInfo keyInfo;
+        keyInfo.signatureSize = 4;
+        std::string signedXml = document.Embed({ 1, 2, 3, 4 }, keyInfo);
+
+        // Phần trước vị trí chèn giữ nguyên từng byte.
+        std::string original(kInvoice);
+        size_t insertion = original.rfind("</HDon>");
+        EXPECT_EQ(signedXml.substr(0, insertion), original.substr(0, insertion));
+        std::string signatureStart =
+                "<ds:Signature xmlns:ds=\"http://www.w3.org/2000/09/xmldsig#\" Id=\"sig-1\"><ds:SignedInfo>";
+        EXPECT_EQ(signedXml.substr(insertion, signatureStart.size()), signatureStart);
+        EXPECT_NE(signedXml.find("<ds:DigestValue>GTqyYAByC2tRelfCIu+Iw6xVI+DVb0C+7HKkRk3sSUE=</ds:DigestValue>"),
+                  std::string::npos);
+        EXPECT_NE(signedXml.find("<ds:SignatureValue>AQIDBA==</ds:SignatureValue></ds:Signature></HDon>"),
+                  std::string::npos);
+    }
+
+    TEST(XmlDsigDocumentTest, RejectsCharacterReferencesOutsideXmlChar) {
+        EXPECT_NO_THROW(XmlDsigDocument("<a>&#x41;&#65;&#x10FFFF;&#9;</a>", XmlDsigConfig()));
+        EXPECT_NO_THROW(XmlDsigDocument("<a>&#000000065;</a>", XmlDsigConfig()));
+        EXPECT_THROW(XmlDsigDocument("<a>&#0;</a>", XmlDsigConfig()), std::runtime_error);
+        EXPECT_THROW(XmlDsigDocument("<a>&#x1;</a>", XmlDsigConfig()), std::runtime_error);
+        EXPECT_THROW(XmlDsigDocument("<a>&#xD800;</a>", XmlDsigConfig()), std::runtime_error);
+        EXPECT_THROW(XmlDsigDocument("<a>&#57343;</a>", XmlDsigConfig()), std::runtime_error);
+        EXPECT_THROW(XmlDsigDocument("<a>&#xFFFE;</a>", XmlDsigConfig()), std::runtime_error);
+        EXPECT_THROW(XmlDsigDocument("<a>&#x110000;</a>", XmlDsigConfig()), std::runtime_error);
+        EXPECT_THROW(XmlDsigDocument("<a b=\"&#0;\"/>", XmlDsigConfig()), std::runtime_error);
+    }
+
+    TEST(XmlDsigDocumentTest, DoctypeLiteralMayContainBrackets) {
+        EXPECT_NO_THROW(XmlDsigDocument("<!DOCTYPE a SYSTEM \"files[1]/a.dtd\"><a/>", XmlDsigConfig()));
+        EXPECT_NO_THROW(XmlDsigDocument("<!DOCTYPE a PUBLIC '-//x//y>' 'a[0].dtd'><a/>", XmlDsigConfig()));
+        // Internal subset vẫn bị từ chối, kể cả sau một literal.
+        EXPECT_THROW(XmlDsigDocument("<!DOCTYPE a SYSTEM \"a.dtd\" [<!ENTITY e \"x\">]><a/>", XmlDsigConfig()),
+                     std::runtime_error);
+        EXPECT_THROW(XmlDsigDocument("<!DOCTYPE a SYSTEM \"a.dtd><a/>", XmlDsigConfig()), std::runtime_error);
+    }
+
+    TEST(XmlDsigBatchTest, CallbackReceivesResultsInOrderWithoutRetainingThem) {
+        XmlDsigBatch batch({ "<a>1</a>", "<a>", "<b>3</b>" }, XmlDsigConfig(), 2);
+        XmlDsigKeyInfo keyInfo = XmlDsigKeyInfo::Create(CardKey().GetCertificate());
+
+        std::vector<size_t> order;
+        std::vector<XmlDsigBatchResult> delivered;
+        auto retained = batch.SignAll(keyInfo, SignWithCardKey(), [&](size_t index, const XmlDsigBatchResult& result) {
+            order.push_back(index);
+            delivered.push_back(result);
+        });
+
+        EXPECT_TRUE(retained.empty());
+        EXPECT_EQ(order, (std::vector<size_t>{ 0, 1, 2 }));
+        EXPECT_TRUE(delivered[0].error.empty());
+        EXPECT_NE(delivered[0].signedXml.find("SignatureValue"), std::string::npos);
+        EXPECT_FALSE(delivered[1].error.empty());
+        EXPECT_TRUE(delivered[1].signedXml.empty());
+        EXPECT_TRUE(delivered[2].error.empty());
+    }
+
+    TEST(XmlDsigBatchTest, WithoutCallbackReturnsEveryResult) {
+        XmlDsigBatch batch({ "<a>1</a>", "<b>2</b>" }, XmlDsigConfig(), 1);
+        auto results = batch.SignAll(XmlDsigKeyInfo::Create(CardKey().GetCertificate()), SignWithCardKey());
+
+        ASSERT_EQ(results.size(), 2u);
+        EXPECT_TRUE(results[0].error.empty());
+        EXPECT_TRUE(results[1].error.empty());
+    }
+
+}  // namespace
+}  // namespace nfcsigner
@@ -0,0 +1,119 @@
+#include "warm_up.h"
+
+#include "card_apdu.h"
+#include "card_scheduler.h"
+#include "cms_template.h"
+#include "pcsc_card.h"
+#include "signing_metrics.h"
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+
+namespace nfcsigner {
+
+    namespace {
+
+        // Mỗi lúc chỉ một lần warm-up: lần sau thấy các bước đã nóng.
+        std::mutex warm_up_mutex;
+
+        bool IsSuccess(const std::vector<uint8_t>& response) {
+            return response.size() >= 2 && response[response.size() - 2] == 0x90 && response.back() == 0x00;
+        }
+
+        // Chạy [step], cộng thời gian vào [elapsedUs]; lỗi được ghi lại thay vì ném.
+        void RunStep(const char* name, int64_t& elapsedUs, WarmUpReport& report, const std::function<void()>& step) {
+            PhaseTimer timer;
+            try {
+                step();
+            } catch (const std::exception& e) {
+                report.errors.push_back(std::string(name) + ": " + e.what());
+            }
+            elapsedUs += timer.ElapsedUs();
+        }
+
+        void WarmUpCrypto() {
+            OPENSSL_init_crypto(OPENSSL_INIT_ADD_ALL_CIPHERS | OPENSSL_INIT_ADD_ALL_DIGESTS |
+                                OPENSSL_INIT_LOAD_CONFIG, nullptr);
+            // Lần dùng SHA-256 và DRBG đầu tiên nạp provider/seed.
+            unsigned char digest[EVP_MAX_MD_SIZE];
+            unsigned int digestLength = 0;
+            const unsigned char probe[] = "nfcsigner";
+            if (EVP_Digest(probe, sizeof(probe), digest, &digestLength, EVP_sha256(), nullptr) != 1) {
+                throw std::runtime_error("EVP_Digest failed.");
+            }
+            unsigned char random[16];
+            if (RAND_bytes(random, sizeof(random)) != 1) throw std::runtime_error("RAND_bytes failed.");
+        }
+
+        std::vector<uint8_t> ReadCertificate(SCARDHANDLE hCard, const std::string& appletID) {
+            if (!IsSuccess(TransmitAndGetResponse(hCard, CreateSelectAppletCommand(appletID)))) {
+                throw std::runtime_error("Select Applet failed.");
+            }
+            if (!IsSuccess(TransmitAndGetResponse(hCard, CreateSelectCertificateCommand()))) {
+                throw std::runtime_error("Select Certificate data object failed.");
+            }
+            auto cert_resp = TransmitAndGetResponse(hCard, CreateGetCertificateCommand());
+            if (!IsSuccess(cert_resp) || cert_resp.size() < 3) throw std::runtime_error("Get Certificate failed.");
+            return std::vector<uint8_t>(cert_resp.begin(), cert_resp.end() - 2);
+        }
+
+    }  // namespace
+
+    WarmUpReport WarmUp(const WarmUpOptions& options) {
+        std::lock_guard<std::mutex> lock(warm_up_mutex);
+        PhaseTimer totalTimer;
+        WarmUpReport report;
+
+        RunStep("crypto", report.cryptoUs, report, WarmUpCrypto);
+
+        // Kết nối dùng chung của WithCardConnection được giữ lại cho request
+        // sau; certificate đọc trong cùng lượt giữ thẻ.
+        PhaseTimer pcscTimer;
+        try {
+            WithCardConnection([&](SCARDHANDLE hCard) {
+                report.pcscUs = pcscTimer.ElapsedUs();
+                report.cardConnected = true;
+                if (options.appletID.empty()) return;
+                RunStep("certificate", report.certificateUs, report, [&]() {
+                    CmsTemplateCache::Instance().GetOrCreate(ReadCertificate(hCard, options.appletID));
+                    report.certificateCached = true;
+                });
+            }, CardPriority::Background);
+        } catch (const std::exception& e) {
+            if (!report.cardConnected) report.pcscUs = pcscTimer.ElapsedUs();
+            report.errors.push_back(std::string("pcsc: ") + e.what());
+        }
+
+#ifdef HAVE_PODOFO
+        RunStep("fonts", report.fontsUs, report, []() {
+            if (!WarmUpAppearanceFonts()) throw std::runtime_error("No font available for signature appearance.");
+        });
+        RunStep("image", report.imageUs, report, WarmUpImageCodecs);
+        if (options.appearance) {
+            RunStep("appearance", report.appearanceUs, report, [&]() {
+                SignatureAppearanceCache::Instance().GetOrCreate(*options.appearance);
+                report.appearanceCached = true;
+            });
+        }
+#endif
+
+        report.totalUs = totalTimer.ElapsedUs();
+        for (const auto& error : report.errors) std::cerr << "Warm-up: " << error << std::endl;
+        std::cout << "Warm-up finished in " << report.totalUs << " us." << std::endl;
+        return report;
+    }
+
+    bool IsAutoWarmUpEnabled() {
+        const char* value = std::getenv("NFCSIGNER_WARM_UP");
+        return value && std::string(value) == "1";
+    }
+
+}  // namespace nfcsigner
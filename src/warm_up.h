@@ -0,0 +1,49 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_WARM_UP_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_WARM_UP_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "signature_appearance.h"
+
+namespace nfcsigner {
+
+    // Những gì cần chuẩn bị trước ngoài phần luôn làm (PC/SC, OpenSSL, font,
+    // bộ giải mã ảnh).
+    struct WarmUpOptions {
+        // Khác rỗng: đọc certificate của applet và dựng sẵn CMS template.
+        std::string appletID;
+        // Khác nullptr: render sẵn appearance vào SignatureAppearanceCache.
+        std::shared_ptr<const SignatureAppearanceConfig> appearance;
+    };
+
+    // Thời gian từng bước, tính bằng micro giây. Một bước lỗi (không có
+    // reader, thẻ chưa cắm...) không chặn các bước sau; lỗi được ghi vào errors.
+    struct WarmUpReport {
+        int64_t pcscUs = 0;           // context, liệt kê reader, kết nối dùng chung
+        int64_t cryptoUs = 0;         // nạp thuật toán/provider và DRBG của OpenSSL
+        int64_t fontsUs = 0;          // quét font hệ thống của PoDoFo
+        int64_t imageUs = 0;          // bộ giải mã ảnh
+        int64_t certificateUs = 0;    // đọc certificate + CMS template
+        int64_t appearanceUs = 0;     // render appearance
+        int64_t totalUs = 0;
+        bool cardConnected = false;
+        bool certificateCached = false;
+        bool appearanceCached = false;
+        std::vector<std::string> errors;
+    };
+
+    // Khởi tạo trước các hệ thống con mà lần ký đầu tiên phải trả trên đường
+    // găng, để lần đầu nhanh như các lần sau. Các lần gọi đồng thời chạy lần
+    // lượt; bước đã nóng thì gần như không tốn gì.
+    WarmUpReport WarmUp(const WarmUpOptions& options);
+
+    // Plugin chỉ tự warm-up khi đăng ký nếu biến môi trường NFCSIGNER_WARM_UP=1;
+    // lần chạy đó nằm trên worker riêng của plugin, không chặn đăng ký.
+    bool IsAutoWarmUpEnabled();
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_WARM_UP_H_
@@ -0,0 +1,69 @@
+#include "worker_pool.h"
+
+#include <exception>
+#include <iostream>
+#include <utility>
+
+namespace nfcsigner {
+
+    WorkerPool::WorkerPool(size_t threadCount, size_t queueCapacity) : queue_capacity_(queueCapacity) {
+        if (threadCount == 0) threadCount = 1;
+        threads_.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; ++i) {
+            threads_.emplace_back([this]() { Run(); });
+        }
+    }
+
+    WorkerPool::~WorkerPool() {
+        Shutdown();
+    }
+
+    bool WorkerPool::Submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) return false;
+            if (queue_capacity_ != 0 && tasks_.size() >= queue_capacity_) return false;
+            tasks_.push_back(std::move(task));
+        }
+        available_.notify_one();
+        return true;
+    }
+
+    void WorkerPool::Shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        available_.notify_all();
+        for (auto& thread : threads_) {
+            if (thread.joinable()) thread.join();
+        }
+    }
+
+    size_t WorkerPool::GetPendingCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return tasks_.size();
+    }
+
+    void WorkerPool::Run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                available_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+                if (tasks_.empty()) return;  // đang dừng và đã hết việc
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            // Một việc lỗi không được làm chết luồng của pool.
+            try {
+                task();
+            } catch (const std::exception& e) {
+                std::cerr << "WorkerPool task failed: " << e.what() << std::endl;
+            } catch (...) {
+                std::cerr << "WorkerPool task failed" << std::endl;
+            }
+        }
+    }
+
+}  // namespace nfcsigner
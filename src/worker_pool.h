@@ -0,0 +1,49 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_WORKER_POOL_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_WORKER_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nfcsigner {
+
+    // Nhóm luồng cố định với hàng đợi có giới hạn. Plugin dùng để chạy các
+    // thao tác thẻ/file ngoài platform thread; daemon và đường dart:ffi dùng
+    // thay cho một thread detach mỗi request.
+    class WorkerPool {
+    public:
+        // [queueCapacity] = 0: không giới hạn số việc chờ.
+        WorkerPool(size_t threadCount, size_t queueCapacity);
+        ~WorkerPool();
+
+        WorkerPool(const WorkerPool&) = delete;
+        WorkerPool& operator=(const WorkerPool&) = delete;
+
+        // false nếu hàng đợi đầy hoặc pool đã dừng; [task] không chạy.
+        bool Submit(std::function<void()> task);
+
+        // Ngừng nhận việc, chạy hết việc đang chờ rồi join các luồng. Gọi
+        // nhiều lần được; không gọi từ một luồng của chính pool.
+        void Shutdown();
+
+        size_t GetPendingCount() const;
+        size_t GetThreadCount() const { return threads_.size(); }
+
+    private:
+        void Run();
+
+        const size_t queue_capacity_;
+        mutable std::mutex mutex_;
+        std::condition_variable available_;
+        std::deque<std::function<void()>> tasks_;
+        bool stopping_ = false;
+        std::vector<std::thread> threads_;
+    };
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_WORKER_POOL_H_
@@ -0,0 +1,1059 @@
+#include "xml_dsig.h"
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+
+namespace nfcsigner {
+
+    namespace {
+
+        constexpr const char* kDsNamespace = "http://www.w3.org/2000/09/xmldsig#";
+        constexpr const char* kXmlNamespace = "http://www.w3.org/XML/1998/namespace";
+        constexpr const char* kEnvelopedTransform = "http://www.w3.org/2000/09/xmldsig#enveloped-signature";
+
+        struct HashAlgorithm {
+            const char* digestUri;
+            const char* signatureUri;
+            const EVP_MD* (*md)();
+            std::vector<uint8_t> digestInfoPrefix;
+        };
+
+        const std::vector<HashAlgorithm>& HashAlgorithms() {
+            static const std::vector<HashAlgorithm> algorithms = {
+                { "http://www.w3.org/2000/09/xmldsig#sha1", "http://www.w3.org/2000/09/xmldsig#rsa-sha1", &EVP_sha1,
+                  { 0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2B, 0x0E, 0x03, 0x02, 0x1A, 0x05, 0x00, 0x04, 0x14 } },
+                { "http://www.w3.org/2001/04/xmlenc#sha256", "http://www.w3.org/2001/04/xmldsig-more#rsa-sha256", &EVP_sha256,
+                  { 0x30, 0x31, 0x30, 0x0D, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20 } },
+                { "http://www.w3.org/2001/04/xmldsig-more#sha384", "http://www.w3.org/2001/04/xmldsig-more#rsa-sha384", &EVP_sha384,
+                  { 0x30, 0x41, 0x30, 0x0D, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x02, 0x05, 0x00, 0x04, 0x30 } },
+                { "http://www.w3.org/2001/04/xmlenc#sha512", "http://www.w3.org/2001/04/xmldsig-more#rsa-sha512", &EVP_sha512,
+                  { 0x30, 0x51, 0x30, 0x0D, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x03, 0x05, 0x00, 0x04, 0x40 } },
+            };
+            return algorithms;
+        }
+
+        const HashAlgorithm& FindDigestMethod(const std::string& uri) {
+            for (const auto& algorithm : HashAlgorithms()) {
+                if (uri == algorithm.digestUri) return algorithm;
+            }
+            throw std::runtime_error("DigestMethod không được hỗ trợ: " + uri);
+        }
+
+        const HashAlgorithm& FindSignatureMethod(const std::string& uri) {
+            for (const auto& algorithm : HashAlgorithms()) {
+                if (uri == algorithm.signatureUri) return algorithm;
+            }
+            throw std::runtime_error("SignatureMethod không được hỗ trợ: " + uri);
+        }
+
+        bool IsExclusive(const std::string& method) {
+            if (method == kXmlExcC14n || method == kXmlExcC14nWithComments) return true;
+            if (method == kXmlC14n || method == kXmlC14nWithComments) return false;
+            throw std::runtime_error("CanonicalizationMethod không được hỗ trợ: " + method);
+        }
+
+        std::vector<uint8_t> Digest(const HashAlgorithm& algorithm, const std::string& data) {
+            std::vector<uint8_t> digest(EVP_MAX_MD_SIZE);
+            unsigned int length = 0;
+            if (EVP_Digest(data.data(), data.size(), digest.data(), &length, algorithm.md(), nullptr) != 1) {
+                throw std::runtime_error("EVP_Digest failed.");
+            }
+            digest.resize(length);
+            return digest;
+        }
+
+        // Phần chuẩn hóa được băm theo từng khối thay vì gom thành một chuỗi.
+        class DigestSink {
+        public:
+            explicit DigestSink(const EVP_MD* md) : ctx_(EVP_MD_CTX_new()) {
+                if (!ctx_ || EVP_DigestInit_ex(ctx_, md, nullptr) != 1) {
+                    EVP_MD_CTX_free(ctx_);
+                    throw std::runtime_error("EVP_DigestInit_ex failed.");
+                }
+                buffer_.reserve(kChunkSize);
+            }
+            ~DigestSink() { EVP_MD_CTX_free(ctx_); }
+
+            DigestSink(const DigestSink&) = delete;
+            DigestSink& operator=(const DigestSink&) = delete;
+
+            void Append(const char* data, size_t size) {
+                if (buffer_.size() + size > kChunkSize) {
+                    Flush();
+                    if (size >= kChunkSize) {
+                        Update(data, size);
+                        return;
+                    }
+                }
+                buffer_.append(data, size);
+            }
+            void Append(std::string_view data) { Append(data.data(), data.size()); }
+            void Append(char c) {
+                if (buffer_.size() == kChunkSize) Flush();
+                buffer_.push_back(c);
+            }
+
+            std::vector<uint8_t> Finish() {
+                Flush();
+                std::vector<uint8_t> digest(EVP_MAX_MD_SIZE);
+                unsigned int length = 0;
+                if (EVP_DigestFinal_ex(ctx_, digest.data(), &length) != 1) {
+                    throw std::runtime_error("EVP_DigestFinal_ex failed.");
+                }
+                digest.resize(length);
+                return digest;
+            }
+
+        private:
+            static constexpr size_t kChunkSize = 64 * 1024;
+
+            void Flush() {
+                if (!buffer_.empty()) Update(buffer_.data(), buffer_.size());
+                buffer_.clear();
+            }
+            void Update(const char* data, size_t size) {
+                if (EVP_DigestUpdate(ctx_, data, size) != 1) {
+                    throw std::runtime_error("EVP_DigestUpdate failed.");
+                }
+            }
+
+            EVP_MD_CTX* ctx_;
+            std::string buffer_;
+        };
+
+        void AppendUtf8(std::string& out, unsigned long codePoint) {
+            if (codePoint < 0x80) {
+                out += static_cast<char>(codePoint);
+            } else if (codePoint < 0x800) {
+                out += static_cast<char>(0xC0 | (codePoint >> 6));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else if (codePoint < 0x10000) {
+                out += static_cast<char>(0xE0 | (codePoint >> 12));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else if (codePoint < 0x110000) {
+                out += static_cast<char>(0xF0 | (codePoint >> 18));
+                out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else {
+                throw std::runtime_error("Tham chiếu ký tự không hợp lệ.");
+            }
+        }
+
+        // Thoát ký tự cho giá trị thuộc tính theo C14N.
+        void EscapeAttribute(std::string& out, std::string_view value) {
+            for (char c : value) {
+                switch (c) {
+                    case '&': out += "&amp;"; break;
+                    case '<': out += "&lt;"; break;
+                    case '"': out += "&quot;"; break;
+                    case '\t': out += "&#x9;"; break;
+                    case '\n': out += "&#xA;"; break;
+                    case '\r': out += "&#xD;"; break;
+                    default: out += c; break;
+                }
+            }
+        }
+
+        std::string_view PrefixOf(std::string_view qualifiedName) {
+            size_t colon = qualifiedName.find(':');
+            return colon == std::string_view::npos ? std::string_view() : qualifiedName.substr(0, colon);
+        }
+
+        std::string_view LocalNameOf(std::string_view qualifiedName) {
+            size_t colon = qualifiedName.find(':');
+            return colon == std::string_view::npos ? qualifiedName : qualifiedName.substr(colon + 1);
+        }
+
+        struct NamespaceNode {
+            std::string_view prefix;
+            std::string uri;
+        };
+
+        struct AttributeNode {
+            std::string_view qualifiedName;
+            std::string value;
+            std::string_view namespaceUri;
+        };
+
+        struct XmlAttributeNode {
+            std::string_view localName;
+            std::string value;
+        };
+
+        // Kết quả lượt đọc.
+        struct ParseResult {
+            std::vector<uint8_t> referenceDigest;
+            size_t insertionOffset = 0;
+            bool insertionSelfClosing = false;
+            std::string insertionName;
+            bool insertionInsideReference = false;
+            std::vector<std::pair<std::string, std::string>> namespaces;
+            std::vector<std::pair<std::string, std::string>> xmlAttributes;
+        };
+
+        // Trình đọc XML tuần tự kết hợp chuẩn hóa. Chỉ giữ ngăn xếp phần tử đang
+        // mở và các namespace khai báo trên đó; phần được tham chiếu đi thẳng vào
+        // DigestSink. Tham chiếu cùng tài liệu ("" hoặc "#id") loại comment nên
+        // comment không bao giờ được đưa vào digest.
+        class C14nParser {
+        public:
+            C14nParser(const std::string& xml, const XmlDsigConfig& config, DigestSink& sink)
+                : data_(xml.data()), end_(xml.data() + xml.size()), sink_(sink),
+                  exclusive_(IsExclusive(config.canonicalizationMethod)) {
+                if (config.referenceUri.empty()) {
+                    whole_document_ = true;
+                } else if (config.referenceUri[0] == '#' && config.referenceUri.size() > 1 &&
+                           config.referenceUri.find('(') == std::string::npos) {
+                    reference_id_ = config.referenceUri.substr(1);
+                } else {
+                    throw std::runtime_error("Reference URI không được hỗ trợ: " + config.referenceUri);
+                }
+                ParseTargetPath(config.xpath);
+            }
+
+            ParseResult Parse() {
+                pos_ = data_;
+                if (end_ - pos_ >= 3 && std::memcmp(pos_, "\xEF\xBB\xBF", 3) == 0) pos_ += 3;
+
+                ParseMisc(true);
+                if (pos_ >= end_ || *pos_ != '<') throw Error("Không tìm thấy phần tử gốc");
+                ParseContent();
+                ParseMisc(false);
+                if (pos_ < end_) throw Error("Nội dung thừa sau phần tử gốc");
+
+                if (!whole_document_ && !reference_found_) {
+                    throw std::runtime_error("Không tìm thấy phần tử có Id '" + reference_id_ + "'.");
+                }
+                if (!insertion_found_) {
+                    throw std::runtime_error("Không tìm thấy phần tử chứa chữ ký.");
+                }
+                result_.referenceDigest = sink_.Finish();
+                return std::move(result_);
+            }
+
+        private:
+            struct Frame {
+                std::string_view qualifiedName;
+                size_t namespaceMark;
+                size_t renderedMark;
+                size_t xmlAttributeMark;
+                bool output;
+                bool target;
+            };
+
+            std::runtime_error Error(const char* message) const {
+                return std::runtime_error(std::string("XML không hợp lệ: ") + message +
+                                          " (vị trí " + std::to_string(pos_ - data_) + ").");
+            }
+
+            bool StartsWith(const char* text) const {
+                size_t length = std::strlen(text);
+                return static_cast<size_t>(end_ - pos_) >= length && std::memcmp(pos_, text, length) == 0;
+            }
+
+            const char* Find(const char* text) const {
+                size_t length = std::strlen(text);
+                for (const char* p = pos_; end_ - p >= static_cast<ptrdiff_t>(length); ++p) {
+                    p = static_cast<const char*>(std::memchr(p, text[0], static_cast<size_t>(end_ - p)));
+                    if (!p || end_ - p < static_cast<ptrdiff_t>(length)) break;
+                    if (std::memcmp(p, text, length) == 0) return p;
+                }
+                throw Error("Thiếu dấu kết thúc");
+            }
+
+            static bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+            void SkipSpaces() {
+                while (pos_ < end_ && IsSpace(*pos_)) ++pos_;
+            }
+
+            std::string_view ParseName() {
+                const char* start = pos_;
+                while (pos_ < end_ && !IsSpace(*pos_) && *pos_ != '/' && *pos_ != '>' && *pos_ != '=' &&
+                       *pos_ != '?' && *pos_ != '<') {
+                    ++pos_;
+                }
+                if (pos_ == start) throw Error("Thiếu tên");
+                return std::string_view(start, static_cast<size_t>(pos_ - start));
+            }
+
+            void ParseTargetPath(const std::string& xpath) {
+                if (xpath.empty()) return;
+                if (xpath[0] != '/' || xpath.find("//") != std::string::npos ||
+                    xpath.find_first_of("[]@*()") != std::string::npos) {
+                    throw std::runtime_error("xpath không được hỗ trợ (chỉ dạng /a/b/c): " + xpath);
+                }
+                size_t start = 1;
+                while (start <= xpath.size()) {
+                    size_t slash = xpath.find('/', start);
+                    if (slash == std::string::npos) slash = xpath.size();
+                    if (slash == start) throw std::runtime_error("xpath không hợp lệ: " + xpath);
+                    target_path_.push_back(xpath.substr(start, slash - start));
+                    start = slash + 1;
+                }
+            }
+
+            bool MatchesTargetPath() const {
+                if (target_path_.empty()) return stack_.size() == 1;
+                if (stack_.size() != target_path_.size()) return false;
+                for (size_t i = 0; i < stack_.size(); ++i) {
+                    const std::string& step = target_path_[i];
+                    std::string_view name = stack_[i].qualifiedName;
+                    if (name != step && (step.find(':') != std::string::npos || LocalNameOf(name) != step)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            // Comment, PI và khoảng trắng ngoài phần tử gốc.
+            void ParseMisc(bool prolog) {
+                bool first = true;
+                while (true) {
+                    SkipSpaces();
+                    if (pos_ >= end_) return;
+                    if (StartsWith("<?xml") && first && prolog && pos_ + 5 < end_ && IsSpace(pos_[5])) {
+                        const char* close = Find("?>");
+                        std::string_view declaration(pos_, static_cast<size_t>(close - pos_));
+                        size_t encoding = declaration.find("encoding");
+                        if (encoding != std::string_view::npos) {
+                            size_t quote = declaration.find_first_of("\"'", encoding);
+                            if (quote != std::string_view::npos) {
+                                size_t closeQuote = declaration.find(declaration[quote], quote + 1);
+                                std::string value(declaration.substr(quote + 1, closeQuote - quote - 1));
+                                std::transform(value.begin(), value.end(), value.begin(),
+                                               [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                                if (value != "utf-8") {
+                                    throw std::runtime_error("Chỉ hỗ trợ XML mã hóa UTF-8 (encoding=" + value + ").");
+                                }
+                            }
+                        }
+                        pos_ = close + 2;
+                    } else if (StartsWith("<!--")) {
+                        pos_ = Find("-->") + 3;
+                    } else if (StartsWith("<?")) {
+                        std::string pi = ParseProcessingInstruction();
+                        if (whole_document_) {
+                            if (prolog) {
+                                sink_.Append(pi);
+                                sink_.Append('\n');
+                            } else {
+                                sink_.Append('\n');
+                                sink_.Append(pi);
+                            }
+                        }
+                    } else if (prolog && StartsWith("<!DOCTYPE")) {
+                        const char* p = pos_;
+                        while (p < end_ && *p != '>' && *p != '[') {
+                            // '[' hay '>' trong system/public literal không kết thúc khai báo.
+                            if (*p == '"' || *p == '\'') {
+                                const char* close = static_cast<const char*>(
+                                        std::memchr(p + 1, *p, static_cast<size_t>(end_ - p - 1)));
+                                if (!close) throw Error("DOCTYPE không kết thúc");
+                                p = close;
+                            }
+                            ++p;
+                        }
+                        if (p >= end_) throw Error("DOCTYPE không kết thúc");
+                        if (*p == '[') {
+                            // Internal subset có thể khai báo entity và giá trị thuộc tính mặc định.
+                            throw std::runtime_error("XML có DTD internal subset không được hỗ trợ.");
+                        }
+                        pos_ = p + 1;
+                    } else {
+                        return;
+                    }
+                    first = false;
+                }
+            }
+
+            // Trả về PI ở dạng chuẩn hóa.
+            std::string ParseProcessingInstruction() {
+                pos_ += 2;
+                std::string_view target = ParseName();
+                const char* close = Find("?>");
+                SkipSpaces();
+                std::string out = "<?";
+                out.append(target.data(), target.size());
+                if (pos_ < close) {
+                    out += ' ';
+                    AppendNormalizedLines(out, pos_, close);
+                }
+                out += "?>";
+                pos_ = close + 2;
+                return out;
+            }
+
+            static void AppendNormalizedLines(std::string& out, const char* begin, const char* end) {
+                for (const char* p = begin; p < end; ++p) {
+                    if (*p == '\r') {
+                        out += '\n';
+                        if (p + 1 < end && p[1] == '\n') ++p;
+                    } else {
+                        out += *p;
+                    }
+                }
+            }
+
+            // Giải mã tham chiếu tại pos_ (ngay sau '&') vào [out].
+            void DecodeReference(std::string& out) {
+                const char* semicolon = static_cast<const char*>(std::memchr(pos_, ';', static_cast<size_t>(end_ - pos_)));
+                if (!semicolon || semicolon - pos_ > 10) throw Error("Tham chiếu không kết thúc");
+                std::string_view name(pos_, static_cast<size_t>(semicolon - pos_));
+                if (name == "lt") out += '<';
+                else if (name == "gt") out += '>';
+                else if (name == "amp") out += '&';
+                else if (name == "quot") out += '"';
+                else if (name == "apos") out += '\'';
+                else if (name.size() > 1 && name[0] == '#') {
+                    bool hex = name[1] == 'x';
+                    std::string digits(name.substr(hex ? 2 : 1));
+                    if (digits.empty() || digits.find_first_not_of(hex ? "0123456789abcdefABCDEF" : "0123456789") != std::string::npos) {
+                        throw Error("Tham chiếu ký tự không hợp lệ");
+                    }
+                    // Chỉ nhận ký tự thuộc production Char của XML 1.0: không
+                    // có &#0;, ký tự điều khiển C0 khác tab/xuống dòng, nửa
+                    // surrogate hay U+FFFE/U+FFFF.
+                    digits.erase(0, std::min(digits.find_first_not_of('0'), digits.size() - 1));
+                    unsigned long codePoint = digits.size() > 8 ? 0x110000 : std::stoul(digits, nullptr, hex ? 16 : 10);
+                    bool isChar = codePoint == 0x9 || codePoint == 0xA || codePoint == 0xD ||
+                                  (codePoint >= 0x20 && codePoint <= 0xD7FF) ||
+                                  (codePoint >= 0xE000 && codePoint <= 0xFFFD) ||
+                                  (codePoint >= 0x10000 && codePoint <= 0x10FFFF);
+                    if (!isChar) throw Error("Tham chiếu ký tự không hợp lệ");
+                    AppendUtf8(out, codePoint);
+                } else {
+                    throw std::runtime_error("Entity '" + std::string(name) + "' không được hỗ trợ.");
+                }
+                pos_ = semicolon + 1;
+            }
+
+            std::string ParseAttributeValue() {
+                if (pos_ >= end_ || (*pos_ != '"' && *pos_ != '\'')) throw Error("Thiếu dấu nháy");
+                char quote = *pos_++;
+                std::string value;
+                while (true) {
+                    if (pos_ >= end_) throw Error("Giá trị thuộc tính không kết thúc");
+                    char c = *pos_;
+                    if (c == quote) {
+                        ++pos_;
+                        return value;
+                    }
+                    if (c == '<') throw Error("Ký tự '<' trong giá trị thuộc tính");
+                    if (c == '&') {
+                        ++pos_;
+                        DecodeReference(value);
+                        continue;
+                    }
+                    // Chuẩn hóa giá trị thuộc tính: khoảng trắng thật thành dấu cách.
+                    if (c == '\r' && pos_ + 1 < end_ && pos_[1] == '\n') ++pos_;
+                    value += (c == '\t' || c == '\n' || c == '\r') ? ' ' : c;
+                    ++pos_;
+                }
+            }
+
+            const std::string* LookupNamespace(std::string_view prefix) const {
+                for (auto it = namespaces_.rbegin(); it != namespaces_.rend(); ++it) {
+                    if (it->prefix == prefix) return &it->uri;
+                }
+                return nullptr;
+            }
+
+            const std::string* LookupRendered(std::string_view prefix) const {
+                for (auto it = rendered_.rbegin(); it != rendered_.rend(); ++it) {
+                    if (it->prefix == prefix) return &it->uri;
+                }
+                return nullptr;
+            }
+
+            std::string_view NamespaceUriOf(std::string_view prefix) const {
+                if (prefix.empty()) return std::string_view();
+                if (prefix == "xml") return kXmlNamespace;
+                const std::string* uri = LookupNamespace(prefix);
+                if (!uri) throw std::runtime_error("Prefix '" + std::string(prefix) + "' chưa được khai báo.");
+                return *uri;
+            }
+
+            // Tất cả namespace đang có hiệu lực (khai báo gần nhất thắng).
+            std::vector<NamespaceNode> InScopeNamespaces() const {
+                std::vector<NamespaceNode> nodes;
+                for (auto it = namespaces_.rbegin(); it != namespaces_.rend(); ++it) {
+                    bool shadowed = std::any_of(nodes.begin(), nodes.end(),
+                                                [&](const NamespaceNode& node) { return node.prefix == it->prefix; });
+                    if (!shadowed) nodes.push_back(*it);
+                }
+                return nodes;
+            }
+
+            // Namespace cần ghi ra trên phần tử có [prefix] so với phần tử cha đã ghi.
+            void RenderNamespace(std::vector<NamespaceNode>& out, std::string_view prefix, const std::string& uri) const {
+                if (prefix == "xml") return;
+                if (std::any_of(out.begin(), out.end(), [&](const NamespaceNode& node) { return node.prefix == prefix; })) {
+                    return;
+                }
+                const std::string* rendered = LookupRendered(prefix);
+                if (prefix.empty() && uri.empty()) {
+                    // xmlns="" chỉ cần khi phần tử cha đã ghi namespace mặc định khác rỗng.
+                    if (rendered && !rendered->empty()) out.push_back({ prefix, uri });
+                    return;
+                }
+                if (!rendered || *rendered != uri) out.push_back({ prefix, uri });
+            }
+
+            void RenderStartTag(const Frame& frame, const std::vector<NamespaceNode>& declared, bool apex) {
+                namespace_output_.clear();
+                if (exclusive_) {
+                    // Exclusive C14N: chỉ các prefix được phần tử hoặc thuộc tính dùng tới.
+                    std::string_view prefix = PrefixOf(frame.qualifiedName);
+                    const std::string* uri = LookupNamespace(prefix);
+                    RenderNamespace(namespace_output_, prefix, uri ? *uri : std::string());
+                    for (const auto& attribute : attributes_) {
+                        std::string_view attributePrefix = PrefixOf(attribute.qualifiedName);
+                        if (attributePrefix.empty() || attributePrefix == "xml") continue;
+                        RenderNamespace(namespace_output_, attributePrefix, std::string(attribute.namespaceUri));
+                    }
+                } else if (apex) {
+                    for (const auto& node : InScopeNamespaces()) RenderNamespace(namespace_output_, node.prefix, node.uri);
+                } else {
+                    for (const auto& node : declared) RenderNamespace(namespace_output_, node.prefix, node.uri);
+                }
+                std::sort(namespace_output_.begin(), namespace_output_.end(),
+                          [](const NamespaceNode& a, const NamespaceNode& b) { return a.prefix < b.prefix; });
+
+                // C14N (không exclusive) kế thừa xml:* của các phần tử tổ tiên nằm ngoài tập con.
+                if (apex && !exclusive_ && !whole_document_) {
+                    // attributes_ giữ string_view vào inherited_names_ nên không được cấp phát lại.
+                    inherited_names_.reserve(xml_attributes_.size());
+                    for (auto it = xml_attributes_.rbegin(); it != xml_attributes_.rend(); ++it) {
+                        bool present = std::any_of(attributes_.begin(), attributes_.end(), [&](const AttributeNode& a) {
+                            return a.namespaceUri == kXmlNamespace && LocalNameOf(a.qualifiedName) == it->localName;
+                        });
+                        if (present) continue;
+                        inherited_names_.push_back("xml:" + std::string(it->localName));
+                        attributes_.push_back({ inherited_names_.back(), it->value, kXmlNamespace });
+                    }
+                }
+                std::sort(attributes_.begin(), attributes_.end(), [](const AttributeNode& a, const AttributeNode& b) {
+                    if (a.namespaceUri != b.namespaceUri) return a.namespaceUri < b.namespaceUri;
+                    return LocalNameOf(a.qualifiedName) < LocalNameOf(b.qualifiedName);
+                });
+
+                scratch_.clear();
+                scratch_ += '<';
+                scratch_.append(frame.qualifiedName.data(), frame.qualifiedName.size());
+                for (const auto& node : namespace_output_) {
+                    scratch_ += node.prefix.empty() ? " xmlns" : " xmlns:";
+                    scratch_.append(node.prefix.data(), node.prefix.size());
+                    scratch_ += "=\"";
+                    EscapeAttribute(scratch_, node.uri);
+                    scratch_ += '"';
+                    rendered_.push_back(node);
+                }
+                for (const auto& attribute : attributes_) {
+                    scratch_ += ' ';
+                    scratch_.append(attribute.qualifiedName.data(), attribute.qualifiedName.size());
+                    scratch_ += "=\"";
+                    EscapeAttribute(scratch_, attribute.value);
+                    scratch_ += '"';
+                }
+                scratch_ += '>';
+                sink_.Append(scratch_);
+            }
+
+            void ParseStartTag() {
+                ++pos_;
+                Frame frame{};
+                frame.qualifiedName = ParseName();
+                frame.namespaceMark = namespaces_.size();
+                frame.renderedMark = rendered_.size();
+                frame.xmlAttributeMark = xml_attributes_.size();
+
+                attributes_.clear();
+                inherited_names_.clear();
+                declared_.clear();
+                bool selfClosing = false;
+                const char* slash = nullptr;
+                while (true) {
+                    bool hadSpace = pos_ < end_ && IsSpace(*pos_);
+                    SkipSpaces();
+                    if (pos_ >= end_) throw Error("Thẻ không kết thúc");
+                    if (*pos_ == '>') {
+                        ++pos_;
+                        break;
+                    }
+                    if (*pos_ == '/') {
+                        slash = pos_;
+                        if (pos_ + 1 >= end_ || pos_[1] != '>') throw Error("Thẻ không hợp lệ");
+                        pos_ += 2;
+                        selfClosing = true;
+                        break;
+                    }
+                    if (!hadSpace) throw Error("Thiếu khoảng trắng giữa các thuộc tính");
+                    std::string_view name = ParseName();
+                    SkipSpaces();
+                    if (pos_ >= end_ || *pos_ != '=') throw Error("Thiếu '='");
+                    ++pos_;
+                    SkipSpaces();
+                    std::string value = ParseAttributeValue();
+
+                    if (name == "xmlns" || (name.size() > 6 && name.compare(0, 6, "xmlns:") == 0)) {
+                        std::string_view prefix = name.size() > 6 ? name.substr(6) : std::string_view();
+                        if (std::any_of(declared_.begin(), declared_.end(),
+                                        [&](const NamespaceNode& n) { return n.prefix == prefix; })) {
+                            throw Error("Khai báo namespace trùng lặp");
+                        }
+                        declared_.push_back({ prefix, std::move(value) });
+                    } else {
+                        if (std::any_of(attributes_.begin(), attributes_.end(),
+                                        [&](const AttributeNode& a) { return a.qualifiedName == name; })) {
+                            throw Error("Thuộc tính trùng lặp");
+                        }
+                        attributes_.push_back({ name, std::move(value), std::string_view() });
+                    }
+                }
+
+                for (const auto& node : declared_) namespaces_.push_back(node);
+                for (auto& attribute : attributes_) {
+                    attribute.namespaceUri = NamespaceUriOf(PrefixOf(attribute.qualifiedName));
+                    if (attribute.namespaceUri == kXmlNamespace) {
+                        xml_attributes_.push_back({ LocalNameOf(attribute.qualifiedName), attribute.value });
+                    }
+                }
+                NamespaceUriOf(PrefixOf(frame.qualifiedName));
+
+                bool apex = false;
+                if (!whole_document_) {
+                    for (const auto& attribute : attributes_) {
+                        if ((attribute.qualifiedName == "Id" || attribute.qualifiedName == "ID" ||
+                             attribute.qualifiedName == "id") && attribute.value == reference_id_) {
+                            if (reference_found_) {
+                                throw std::runtime_error("Id '" + reference_id_ + "' xuất hiện nhiều lần.");
+                            }
+                            reference_found_ = true;
+                            reference_depth_ = stack_.size() + 1;
+                            apex = true;
+                        }
+                    }
+                } else {
+                    apex = stack_.empty();
+                }
+                frame.output = whole_document_ || (reference_depth_ > 0 && stack_.size() + 1 >= reference_depth_);
+
+                stack_.push_back(frame);
+                if (frame.output) RenderStartTag(frame, declared_, apex);
+
+                if (!insertion_found_ && MatchesTargetPath()) {
+                    insertion_found_ = true;
+                    stack_.back().target = true;
+                    result_.insertionName = std::string(frame.qualifiedName);
+                    result_.insertionInsideReference = frame.output;
+                    for (const auto& node : InScopeNamespaces()) {
+                        if ((node.prefix.empty() && node.uri.empty()) || node.prefix == "xml") continue;
+                        result_.namespaces.emplace_back(std::string(node.prefix), node.uri);
+                    }
+                    std::sort(result_.namespaces.begin(), result_.namespaces.end());
+                    for (auto it = xml_attributes_.rbegin(); it != xml_attributes_.rend(); ++it) {
+                        std::string name(it->localName);
+                        bool present = std::any_of(result_.xmlAttributes.begin(), result_.xmlAttributes.end(),
+                                                   [&](const auto& a) { return a.first == name; });
+                        if (!present) result_.xmlAttributes.emplace_back(name, it->value);
+                    }
+                    std::sort(result_.xmlAttributes.begin(), result_.xmlAttributes.end());
+                    if (selfClosing) {
+                        result_.insertionOffset = static_cast<size_t>(slash - data_);
+                        result_.insertionSelfClosing = true;
+                    }
+                }
+
+                if (selfClosing) CloseElement();
+            }
+
+            void ParseEndTag() {
+                const char* tagStart = pos_;
+                pos_ += 2;
+                std::string_view name = ParseName();
+                SkipSpaces();
+                if (pos_ >= end_ || *pos_ != '>') throw Error("Thẻ đóng không hợp lệ");
+                ++pos_;
+                if (stack_.empty() || stack_.back().qualifiedName != name) throw Error("Thẻ đóng không khớp");
+                if (stack_.back().target) result_.insertionOffset = static_cast<size_t>(tagStart - data_);
+                CloseElement();
+            }
+
+            void CloseElement() {
+                const Frame& frame = stack_.back();
+                if (frame.output) {
+                    sink_.Append("</", 2);
+                    sink_.Append(frame.qualifiedName);
+                    sink_.Append('>');
+                }
+                if (reference_depth_ == stack_.size()) reference_depth_ = 0;
+                namespaces_.resize(frame.namespaceMark);
+                rendered_.resize(frame.renderedMark);
+                xml_attributes_.resize(frame.xmlAttributeMark);
+                stack_.pop_back();
+            }
+
+            bool Output() const { return !stack_.empty() && stack_.back().output; }
+
+            // Nội dung văn bản tới dấu '<' tiếp theo.
+            void ParseText() {
+                const char* next = static_cast<const char*>(std::memchr(pos_, '<', static_cast<size_t>(end_ - pos_)));
+                if (!next) next = end_;
+                if (!Output()) {
+                    pos_ = next;
+                    return;
+                }
+                while (pos_ < next) {
+                    const char* run = pos_;
+                    while (pos_ < next && *pos_ != '&' && *pos_ != '>' && *pos_ != '\r') ++pos_;
+                    sink_.Append(run, static_cast<size_t>(pos_ - run));
+                    if (pos_ >= next) break;
+                    char c = *pos_;
+                    if (c == '>') {
+                        sink_.Append("&gt;", 4);
+                        ++pos_;
+                    } else if (c == '\r') {
+                        sink_.Append('\n');
+                        ++pos_;
+                        if (pos_ < next && *pos_ == '\n') ++pos_;
+                    } else {
+                        ++pos_;
+                        scratch_.clear();
+                        DecodeReference(scratch_);
+                        AppendEscapedText(scratch_.data(), scratch_.data() + scratch_.size());
+                    }
+                }
+            }
+
+            void AppendEscapedText(const char* begin, const char* end) {
+                for (const char* p = begin; p < end; ++p) {
+                    switch (*p) {
+                        case '&': sink_.Append("&amp;", 5); break;
+                        case '<': sink_.Append("&lt;", 4); break;
+                        case '>': sink_.Append("&gt;", 4); break;
+                        case '\r': sink_.Append("&#xD;", 5); break;
+                        default: sink_.Append(*p); break;
+                    }
+                }
+            }
+
+            void ParseContent() {
+                do {
+                    if (pos_ >= end_) throw Error("Tài liệu kết thúc khi phần tử chưa đóng");
+                    if (*pos_ != '<') {
+                        ParseText();
+                    } else if (StartsWith("</")) {
+                        ParseEndTag();
+                    } else if (StartsWith("<!--")) {
+                        pos_ = Find("-->") + 3;
+                    } else if (StartsWith("<![CDATA[")) {
+                        pos_ += 9;
+                        const char* close = Find("]]>");
+                        if (Output()) {
+                            scratch_.clear();
+                            AppendNormalizedLines(scratch_, pos_, close);
+                            AppendEscapedText(scratch_.data(), scratch_.data() + scratch_.size());
+                        }
+                        pos_ = close + 3;
+                    } else if (StartsWith("<?")) {
+                        std::string pi = ParseProcessingInstruction();
+                        if (Output()) sink_.Append(pi);
+                    } else if (StartsWith("<!")) {
+                        throw Error("Khai báo không hợp lệ trong phần tử");
+                    } else {
+                        ParseStartTag();
+                    }
+                } while (!stack_.empty());
+            }
+
+            const char* data_;
+            const char* end_;
+            const char* pos_ = nullptr;
+            DigestSink& sink_;
+            bool exclusive_;
+            bool whole_document_ = false;
+            std::string reference_id_;
+            bool reference_found_ = false;
+            size_t reference_depth_ = 0;
+            std::vector<std::string> target_path_;
+            bool insertion_found_ = false;
+
+            std::vector<Frame> stack_;
+            std::vector<NamespaceNode> namespaces_;
+            std::vector<NamespaceNode> rendered_;
+            std::vector<XmlAttributeNode> xml_attributes_;
+
+            // Dùng lại giữa các phần tử để tránh cấp phát.
+            std::vector<AttributeNode> attributes_;
+            std::vector<NamespaceNode> declared_;
+            std::vector<NamespaceNode> namespace_output_;
+            std::vector<std::string> inherited_names_;
+            std::string scratch_;
+
+            ParseResult result_;
+        };
+
+    }  // namespace
+
+    XmlDsigDocument::XmlDsigDocument(std::string xml, XmlDsigConfig config)
+        : xml_(std::move(xml)), config_(std::move(config)) {
+        Process();
+    }
+
+    void XmlDsigDocument::Process() {
+        FindSignatureMethod(config_.signatureMethod);
+        const HashAlgorithm& digest = FindDigestMethod(config_.digestMethod);
+
+        DigestSink sink(digest.md());
+        ParseResult parsed = C14nParser(xml_, config_, sink).Parse();
+        if (parsed.insertionInsideReference && !config_.enveloped) {
+            throw std::runtime_error("Chữ ký nằm trong phần được tham chiếu nên cần transform enveloped.");
+        }
+
+        reference_digest_ = std::move(parsed.referenceDigest);
+        insertion_.offset = parsed.insertionOffset;
+        insertion_.selfClosing = parsed.insertionSelfClosing;
+        insertion_.qualifiedName = std::move(parsed.insertionName);
+        insertion_.insideReference = parsed.insertionInsideReference;
+        inherited_namespaces_ = std::move(parsed.namespaces);
+        inherited_xml_attributes_ = std::move(parsed.xmlAttributes);
+    }
+
+    std::string XmlDsigDocument::BuildSignedInfo(bool canonical) const {
+        std::string out = "<ds:SignedInfo";
+        if (canonical) {
+            // SignedInfo là gốc của tập con được chuẩn hóa: ghi mọi namespace có
+            // hiệu lực (C14N) hoặc chỉ "ds" (Exclusive C14N).
+            std::vector<std::pair<std::string, std::string>> namespaces;
+            if (!IsExclusive(config_.canonicalizationMethod)) {
+                for (const auto& node : inherited_namespaces_) {
+                    if (node.first != "ds") namespaces.push_back(node);
+                }
+            }
+            namespaces.emplace_back("ds", kDsNamespace);
+            std::sort(namespaces.begin(), namespaces.end());
+            for (const auto& node : namespaces) {
+                out += node.first.empty() ? " xmlns" : " xmlns:";
+                out += node.first;
+                out += "=\"";
+                EscapeAttribute(out, node.second);
+                out += '"';
+            }
+            if (!IsExclusive(config_.canonicalizationMethod)) {
+                for (const auto& attribute : inherited_xml_attributes_) {
+                    out += " xml:" + attribute.first + "=\"";
+                    EscapeAttribute(out, attribute.second);
+                    out += '"';
+                }
+            }
+        }
+        out += "><ds:CanonicalizationMethod Algorithm=\"";
+        EscapeAttribute(out, config_.canonicalizationMethod);
+        out += "\"></ds:CanonicalizationMethod><ds:SignatureMethod Algorithm=\"";
+        EscapeAttribute(out, config_.signatureMethod);
+        out += "\"></ds:SignatureMethod><ds:Reference URI=\"";
+        EscapeAttribute(out, config_.referenceUri);
+        out += "\"><ds:Transforms>";
+        if (config_.enveloped) {
+            out += "<ds:Transform Algorithm=\"";
+            out += kEnvelopedTransform;
+            out += "\"></ds:Transform>";
+        }
+        out += "<ds:Transform Algorithm=\"";
+        EscapeAttribute(out, config_.canonicalizationMethod);
+        out += "\"></ds:Transform></ds:Transforms><ds:DigestMethod Algorithm=\"";
+        EscapeAttribute(out, config_.digestMethod);
+        out += "\"></ds:DigestMethod><ds:DigestValue>";
+        out += EncodeBase64(reference_digest_);
+        out += "</ds:DigestValue></ds:Reference></ds:SignedInfo>";
+        return out;
+    }
+
+    XmlDsigKeyInfo XmlDsigKeyInfo::Create(const std::vector<uint8_t>& certificate) {
+        const unsigned char* p = certificate.data();
+        std::unique_ptr<X509, decltype(&X509_free)> x509(
+                d2i_X509(nullptr, &p, static_cast<long>(certificate.size())), &X509_free);
+        if (!x509) {
+            throw std::runtime_error("Cannot parse certificate from card.");
+        }
+        std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(X509_get_pubkey(x509.get()), &EVP_PKEY_free);
+
+        XmlDsigKeyInfo keyInfo;
+        keyInfo.signatureSize = key ? static_cast<size_t>(EVP_PKEY_size(key.get())) : 0;
+        // Một số thẻ trả về certificate kèm byte đệm phía sau - chỉ giữ phần DER thật.
+        std::vector<uint8_t> der(certificate.data(), p);
+        keyInfo.element = "<ds:KeyInfo><ds:X509Data><ds:X509Certificate>";
+        keyInfo.element += EncodeBase64(der);
+        keyInfo.element += "</ds:X509Certificate></ds:X509Data></ds:KeyInfo>";
+        return keyInfo;
+    }
+
+    std::vector<uint8_t> XmlDsigDocument::CreateSignedInfoDigestInfo() const {
+        const HashAlgorithm& algorithm = FindSignatureMethod(config_.signatureMethod);
+        std::vector<uint8_t> digestInfo = algorithm.digestInfoPrefix;
+        std::vector<uint8_t> signedInfoDigest = Digest(algorithm, BuildSignedInfo(true));
+        digestInfo.insert(digestInfo.end(), signedInfoDigest.begin(), signedInfoDigest.end());
+        return digestInfo;
+    }
+
+    std::string XmlDsigDocument::Embed(std::vector<uint8_t> signature, const XmlDsigKeyInfo& keyInfo) const {
+        if (signature.empty() || (keyInfo.signatureSize > 0 && signature.size() > keyInfo.signatureSize)) {
+            throw std::runtime_error("Card returned a signature of unexpected length: " +
+                                     std::to_string(signature.size()));
+        }
+        // Chữ ký RSA có độ dài cố định; bổ sung byte 0 phía trước nếu thẻ cắt bớt.
+        if (signature.size() < keyInfo.signatureSize) {
+            signature.insert(signature.begin(), keyInfo.signatureSize - signature.size(), 0);
+        }
+
+        std::string signatureId = config_.signatureId;
+        if (signatureId.empty()) {
+            auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+            signatureId = "signature-" + std::to_string(now);
+        }
+
+        std::string element = "<ds:Signature xmlns:ds=\"";
+        element += kDsNamespace;
+        element += "\" Id=\"";
+        EscapeAttribute(element, signatureId);
+        element += "\">";
+        element += BuildSignedInfo(false);
+        element += "<ds:SignatureValue>";
+        element += EncodeBase64(signature);
+        element += "</ds:SignatureValue>";
+        if (config_.includeCertificate) element += keyInfo.element;
+        element += "</ds:Signature>";
+
+        std::string out;
+        out.reserve(xml_.size() + element.size() + insertion_.qualifiedName.size() + 3);
+        out.append(xml_, 0, insertion_.offset);
+        if (insertion_.selfClosing) {
+            out += '>';
+            out += element;
+            out += "</" + insertion_.qualifiedName + ">";
+            out.append(xml_, insertion_.offset + 2, std::string::npos);
+        } else {
+            out += element;
+            out.append(xml_, insertion_.offset, std::string::npos);
+        }
+        return out;
+    }
+
+    std::string XmlDsigDocument::Sign(const std::vector<uint8_t>& certificate, const CardSignFunction& sign) const {
+        XmlDsigKeyInfo keyInfo;
+        if (!certificate.empty()) {
+            keyInfo = XmlDsigKeyInfo::Create(certificate);
+        } else if (config_.includeCertificate) {
+            throw std::runtime_error("Certificate from card is empty.");
+        }
+        return Embed(sign(CreateSignedInfoDigestInfo()), keyInfo);
+    }
+
+    XmlDsigBatch::XmlDsigBatch(std::vector<std::string> documents, XmlDsigConfig config, size_t threads)
+        : config_(std::move(config)), documents_(std::move(documents)), slots_(documents_.size()) {
+        // Kiểm tra thuật toán một lần thay vì báo lỗi giống nhau cho từng tài liệu.
+        IsExclusive(config_.canonicalizationMethod);
+        FindSignatureMethod(config_.signatureMethod);
+        FindDigestMethod(config_.digestMethod);
+
+        if (threads == 0) threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        threads = std::min(threads, documents_.size());
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) workers_.emplace_back([this]() { Work(); });
+    }
+
+    XmlDsigBatch::~XmlDsigBatch() {
+        stop_ = true;
+        for (auto& worker : workers_) worker.join();
+    }
+
+    void XmlDsigBatch::Work() {
+        while (!stop_) {
+            size_t index = next_++;
+            if (index >= documents_.size()) return;
+            Slot prepared;
+            try {
+                prepared.document = std::make_unique<XmlDsigDocument>(std::move(documents_[index]), config_);
+                prepared.digestInfo = prepared.document->CreateSignedInfoDigestInfo();
+            } catch (const std::exception& e) {
+                prepared.document.reset();
+                prepared.error = e.what();
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                slots_[index] = std::move(prepared);
+                slots_[index].ready = true;
+            }
+            ready_.notify_all();
+        }
+    }
+
+    void XmlDsigBatch::Deliver(size_t index, XmlDsigBatchResult result, const ResultCallback& onResult,
+                               std::vector<XmlDsigBatchResult>& results) {
+        // Có callback thì XML đã ký được giải phóng ngay sau khi giao.
+        if (onResult) {
+            onResult(index, result);
+        } else {
+            results.push_back(std::move(result));
+        }
+    }
+
+    std::vector<XmlDsigBatchResult> XmlDsigBatch::SignAll(const XmlDsigKeyInfo& keyInfo, const CardSignFunction& sign,
+                                                          const ResultCallback& onResult) {
+        std::vector<XmlDsigBatchResult> results;
+        if (!onResult) results.reserve(slots_.size());
+        std::string cardError;
+        for (size_t index = 0; index < slots_.size(); ++index) {
+            XmlDsigBatchResult result;
+            if (!cardError.empty()) {
+                // Các luồng đã dừng nên không chờ tài liệu còn lại.
+                result.error = cardError;
+                Deliver(index, std::move(result), onResult, results);
+                continue;
+            }
+
+            Slot slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [&]() { return slots_[index].ready; });
+                slot = std::move(slots_[index]);
+            }
+
+            if (!slot.document) {
+                result.error = slot.error;
+            } else {
+                std::vector<uint8_t> signature;
+                try {
+                    signature = sign(slot.digestInfo);
+                } catch (const std::exception& e) {
+                    // Thẻ lỗi thì các tài liệu sau cũng sẽ lỗi - dừng lô.
+                    cardError = e.what();
+                    stop_ = true;
+                    result.error = cardError;
+                }
+                if (cardError.empty()) {
+                    try {
+                        result.signedXml = slot.document->Embed(std::move(signature), keyInfo);
+                    } catch (const std::exception& e) {
+                        result.error = e.what();
+                    }
+                }
+            }
+            Deliver(index, std::move(result), onResult, results);
+        }
+        return results;
+    }
+
+}  // namespace nfcsigner
@@ -0,0 +1,157 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_XML_DSIG_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_XML_DSIG_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "byte_codec.h"
+#include "cms_template.h"
+
+namespace nfcsigner {
+
+    constexpr const char* kXmlC14n = "http://www.w3.org/TR/2001/REC-xml-c14n-20010315";
+    constexpr const char* kXmlC14nWithComments = "http://www.w3.org/TR/2001/REC-xml-c14n-20010315#WithComments";
+    constexpr const char* kXmlExcC14n = "http://www.w3.org/2001/10/xml-exc-c14n#";
+    constexpr const char* kXmlExcC14nWithComments = "http://www.w3.org/2001/10/xml-exc-c14n#WithComments";
+
+    // Cấu hình chữ ký, tương ứng XmlSignatureConfig phía Dart.
+    struct XmlDsigConfig {
+        std::string signatureId;    // rỗng: tự sinh "signature-<ms>"
+        std::string canonicalizationMethod = kXmlC14n;
+        std::string signatureMethod = "http://www.w3.org/2001/04/xmldsig-more#rsa-sha256";
+        std::string digestMethod = "http://www.w3.org/2001/04/xmlenc#sha256";
+        // "" là toàn bộ tài liệu, "#abc" là phần tử có Id/ID/id = "abc".
+        std::string referenceUri;
+        bool includeCertificate = true;
+        bool enveloped = true;
+        // Phần tử chứa chữ ký dạng "/HDon/DSCKS/NBan" (chỉ gồm tên phần tử).
+        // Rỗng: phần tử gốc.
+        std::string xpath;
+    };
+
+    // Phần của chữ ký phụ thuộc certificate, dựng một lần cho cả lô.
+    struct XmlDsigKeyInfo {
+        std::string element;        // <ds:KeyInfo><ds:X509Data>...</ds:KeyInfo>
+        size_t signatureSize = 0;   // độ dài modulus RSA
+
+        // Ném std::runtime_error nếu certificate không hợp lệ.
+        static XmlDsigKeyInfo Create(const std::vector<uint8_t>& certificate);
+    };
+
+    // Tài liệu XML đã được đọc một lượt để chuẩn bị ký.
+    //
+    // Lượt đọc duy nhất vừa kiểm tra cú pháp, vừa chuẩn hóa (C14N hoặc
+    // Exclusive C14N) phần được tham chiếu và đưa thẳng vào digest EVP theo
+    // từng khối - không dựng cây DOM hay chép lại tài liệu. Đồng thời ghi lại
+    // vị trí chèn chữ ký và các namespace đang có hiệu lực tại đó để chuẩn hóa
+    // SignedInfo đúng như khi nó nằm trong tài liệu.
+    //
+    // Không cần certificate nên chạy được song song với thao tác trên thẻ.
+    // Ném std::runtime_error nếu XML không hợp lệ hoặc cấu hình không được hỗ
+    // trợ (DTD có internal subset, encoding khác UTF-8...).
+    class XmlDsigDocument {
+    public:
+        XmlDsigDocument(std::string xml, XmlDsigConfig config);
+
+        const XmlDsigConfig& GetConfig() const { return config_; }
+        // Digest của phần được tham chiếu (sau transform enveloped + C14N).
+        const std::vector<uint8_t>& GetReferenceDigest() const { return reference_digest_; }
+
+        // DigestInfo của SignedInfo đã chuẩn hóa - dữ liệu gửi cho thẻ. Không
+        // phụ thuộc certificate nên tính trước được.
+        std::vector<uint8_t> CreateSignedInfoDigestInfo() const;
+
+        // Chèn phần tử Signature với chữ ký [signature] của SignedInfo.
+        std::string Embed(std::vector<uint8_t> signature, const XmlDsigKeyInfo& keyInfo) const;
+
+        // Dựng SignedInfo, gọi [sign] đúng một lần với DigestInfo của nó và
+        // trả về tài liệu đã chèn phần tử Signature.
+        std::string Sign(const std::vector<uint8_t>& certificate, const CardSignFunction& sign) const;
+
+    private:
+        struct InsertionPoint {
+            size_t offset = 0;          // vị trí thẻ đóng (hoặc "/>") của phần tử chứa
+            bool selfClosing = false;
+            std::string qualifiedName;
+            bool insideReference = false;
+        };
+
+        void Process();
+        // SignedInfo ở dạng chuẩn hóa (để băm) hoặc dạng chèn vào tài liệu.
+        std::string BuildSignedInfo(bool canonical) const;
+
+        std::string xml_;
+        XmlDsigConfig config_;
+        std::vector<uint8_t> reference_digest_;
+        InsertionPoint insertion_;
+        // Namespace (prefix -> URI, "" là mặc định) và thuộc tính xml:* có hiệu
+        // lực tại vị trí chèn, đã sắp xếp theo thứ tự C14N.
+        std::vector<std::pair<std::string, std::string>> inherited_namespaces_;
+        std::vector<std::pair<std::string, std::string>> inherited_xml_attributes_;
+    };
+
+    struct XmlDsigBatchResult {
+        std::string signedXml;
+        std::string error;          // rỗng nếu ký thành công
+    };
+
+    // Lô tài liệu XML ký bằng một phiên thẻ.
+    //
+    // Constructor khởi động một nhóm luồng CPU đọc, chuẩn hóa, băm reference
+    // và SignedInfo cho từng tài liệu - không cần certificate, nên chạy trong
+    // lúc thẻ SELECT/VERIFY. SignAll lấy kết quả theo thứ tự và gửi DigestInfo
+    // liên tiếp cho thẻ; thẻ là điểm nghẽn duy nhất.
+    class XmlDsigBatch {
+    public:
+        using ResultCallback = std::function<void(size_t index, const XmlDsigBatchResult& result)>;
+
+        // [threads] = 0: theo số lõi CPU.
+        XmlDsigBatch(std::vector<std::string> documents, XmlDsigConfig config, size_t threads = 0);
+        ~XmlDsigBatch();
+
+        XmlDsigBatch(const XmlDsigBatch&) = delete;
+        XmlDsigBatch& operator=(const XmlDsigBatch&) = delete;
+
+        size_t GetSize() const { return slots_.size(); }
+
+        // Ký lần lượt mọi tài liệu. Tài liệu hỏng chỉ làm hỏng kết quả của nó;
+        // lỗi từ [sign] (thẻ) dừng cả lô và được ghi cho các tài liệu còn lại.
+        // [onResult] (nếu có) được gọi ngay khi từng tài liệu xong và kết quả
+        // không được giữ lại: vector trả về khi đó rỗng.
+        std::vector<XmlDsigBatchResult> SignAll(const XmlDsigKeyInfo& keyInfo, const CardSignFunction& sign,
+                                                const ResultCallback& onResult = nullptr);
+
+    private:
+        struct Slot {
+            std::unique_ptr<XmlDsigDocument> document;
+            std::vector<uint8_t> digestInfo;
+            std::string error;
+            bool ready = false;
+        };
+
+        void Work();
+        static void Deliver(size_t index, XmlDsigBatchResult result, const ResultCallback& onResult,
+                            std::vector<XmlDsigBatchResult>& results);
+
+        XmlDsigConfig config_;
+        std::vector<std::string> documents_;
+        std::vector<Slot> slots_;
+        std::atomic<size_t> next_{0};
+        std::atomic<bool> stop_{false};
+        std::mutex mutex_;
+        std::condition_variable ready_;
+        std::vector<std::thread> workers_;
+    };
+
+}  // namespace nfcsigner
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_XML_DSIG_H_
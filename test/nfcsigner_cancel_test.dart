@@ -0,0 +1,91 @@
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  final List<MethodCall> calls = [];
+  // Request đang chạy phía "native", theo requestId.
+  final Map<String, Completer<Object?>> inFlight = {};
+
+  setUp(() {
+    calls.clear();
+    inFlight.clear();
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        calls.add(methodCall);
+        final args = methodCall.arguments as Map<Object?, Object?>;
+        switch (methodCall.method) {
+          case 'signPdf':
+            final completer = Completer<Object?>();
+            inFlight[args['requestId'] as String] = completer;
+            return completer.future;
+          case 'cancel':
+            final completer = inFlight.remove(args['requestId']);
+            if (completer == null) return false;
+            completer.completeError(PlatformException(code: 'CANCELLED', message: 'Operation cancelled'));
+            return true;
+        }
+        return null;
+      },
+    );
+  });
+
+  tearDown(() {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+  });
+
+  test('cancel stops an in-flight request', () async {
+    final pending = Nfcsigner.signPdf(
+      pdfBytes: Uint8List.fromList([1, 2, 3]),
+      appletID: 'A000000001',
+      pin: '1234',
+      pdfHashBytes: Uint8List(32),
+      requestId: 'req-1',
+      timeout: const Duration(seconds: 30),
+    );
+    await Future<void>.delayed(Duration.zero);
+    expect(inFlight.keys, ['req-1']);
+
+    final cancelled = await Nfcsigner.cancel('req-1');
+    expect(cancelled.isSuccess, isTrue);
+    expect(cancelled.data, isTrue);
+
+    final result = await pending;
+    expect(result.status, CardStatus.cancelled);
+
+    final signCall = calls.firstWhere((call) => call.method == 'signPdf');
+    expect(signCall.arguments['requestId'], 'req-1');
+    expect(signCall.arguments['deadlineMs'], 30000);
+  });
+
+  test('cancel of an unknown request returns false', () async {
+    final cancelled = await Nfcsigner.cancel('missing');
+    expect(cancelled.isSuccess, isTrue);
+    expect(cancelled.data, isFalse);
+    expect(calls.single.arguments, {'requestId': 'missing'});
+  });
+
+  test('deadline exceeded maps to cancelled', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        throw PlatformException(code: 'DEADLINE_EXCEEDED', message: 'Deadline exceeded');
+      },
+    );
+    final result = await Nfcsigner.signPdf(
+      pdfBytes: Uint8List.fromList([1]),
+      appletID: 'A000000001',
+      pin: '1234',
+      pdfHashBytes: Uint8List(32),
+      timeout: const Duration(milliseconds: 1),
+    );
+    expect(result.status, CardStatus.cancelled);
+  });
+}
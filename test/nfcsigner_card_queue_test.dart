@@ -0,0 +1,66 @@
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  final List<MethodCall> calls = [];
+
+  Map<String, Object?> queue(int capacity, int rejected) => {
+        'capacity': capacity,
+        'depth': 0,
+        'maxDepth': capacity,
+        'granted': 12,
+        'rejected': rejected,
+        'lastWaitUs': 150,
+        'maxWaitUs': 420000,
+        'totalWaitUs': 900000,
+      };
+
+  setUp(() {
+    calls.clear();
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        calls.add(methodCall);
+        switch (methodCall.method) {
+          case 'getCardQueueMetrics':
+            return {
+              'interactive': queue(4, 0),
+              'bulk': queue(16, 2),
+              'background': queue(8, 0),
+            };
+          case 'getCertificate':
+            // Hàng đợi bulk đầy.
+            throw PlatformException(code: 'CARD_BUSY', message: 'Too many pending requests');
+        }
+        return null;
+      },
+    );
+  });
+
+  tearDown(() {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+  });
+
+  test('getCardQueueMetrics returns one entry per priority class', () async {
+    final result = await Nfcsigner.getCardQueueMetrics();
+
+    expect(result.isSuccess, isTrue);
+    expect(result.data!.keys, containsAll(['interactive', 'bulk', 'background']));
+    expect(result.data!['bulk']['rejected'], 2);
+    expect(result.data!['interactive']['capacity'], 4);
+    expect(calls.single.method, 'getCardQueueMetrics');
+    expect(calls.single.arguments, isNull);
+  });
+
+  test('rejected requests map to busy', () async {
+    final result = await Nfcsigner.getCertificate(appletID: 'A000000001', keyRole: KeyRole.sig);
+
+    expect(result.isSuccess, isFalse);
+    expect(result.status, CardStatus.busy);
+    expect(result.message, 'Too many pending requests');
+  });
+}
@@ -0,0 +1,60 @@
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  final List<MethodCall> calls = [];
+
+  setUp(() {
+    calls.clear();
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        calls.add(methodCall);
+        if (methodCall.method != 'setCardRecoveryPolicy') return null;
+        final int? maxAttempts = methodCall.arguments['maxAttempts'] as int?;
+        if (maxAttempts != null && maxAttempts < 0) {
+          throw PlatformException(
+            code: 'STD_EXCEPTION',
+            message: 'Standard Exception: maxAttempts must not be negative',
+          );
+        }
+        return true;
+      },
+    );
+  });
+
+  tearDown(() {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+  });
+
+  test('setCardRecoveryPolicy sends both settings', () async {
+    final result = await Nfcsigner.setCardRecoveryPolicy(maxAttempts: 3, allowPinReplay: false);
+
+    expect(result.isSuccess, isTrue);
+    expect(result.data, isTrue);
+    expect(calls.single.arguments, {'maxAttempts': 3, 'allowPinReplay': false});
+  });
+
+  test('setCardRecoveryPolicy leaves omitted settings unchanged', () async {
+    await Nfcsigner.setCardRecoveryPolicy(maxAttempts: 0);
+    await Nfcsigner.setCardRecoveryPolicy(allowPinReplay: true);
+    await Nfcsigner.setCardRecoveryPolicy();
+
+    expect(calls.map((c) => c.arguments), [
+      {'maxAttempts': 0},
+      {'allowPinReplay': true},
+      <String, Object?>{},
+    ]);
+  });
+
+  test('setCardRecoveryPolicy reports rejected values', () async {
+    final result = await Nfcsigner.setCardRecoveryPolicy(maxAttempts: -1);
+
+    expect(result.isSuccess, isFalse);
+    expect(result.message, contains('maxAttempts must not be negative'));
+  });
+}
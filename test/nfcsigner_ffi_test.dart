@@ -0,0 +1,103 @@
+import 'dart:async';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+import 'package:nfcsigner/src/nfcsigner_ffi.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  // Mã kết quả trong nfcsigner_ffi.h.
+  const int resultBytes = 0;
+  const int resultValue = 1;
+  const int resultError = 2;
+  const int resultNotImplemented = 3;
+  const StandardMessageCodec codec = StandardMessageCodec();
+
+  Uint8List encode(Object? value) {
+    final data = codec.encodeMessage(value)!;
+    return data.buffer.asUint8List(data.offsetInBytes, data.lengthInBytes);
+  }
+
+  Future<Object?> complete(int status, Uint8List? data) {
+    final completer = Completer<Object?>();
+    NfcsignerFfi.completeResult(completer, status, data);
+    return completer.future;
+  }
+
+  group('completeResult', () {
+    test('passes bytes through unchanged', () async {
+      final pdf = Uint8List.fromList([0x25, 0x50, 0x44, 0x46]);
+      expect(await complete(resultBytes, pdf), pdf);
+      expect(await complete(resultBytes, null), isEmpty);
+    });
+
+    test('decodes StandardMessageCodec values', () async {
+      final value = await complete(resultValue, encode({'valid': true, 'hashUs': 120}));
+      expect(value, {'valid': true, 'hashUs': 120});
+      expect(await complete(resultValue, encode(null)), isNull);
+    });
+
+    test('maps native errors to PlatformException', () async {
+      await expectLater(
+        complete(resultError, encode(['CARD_BUSY', 'Too many pending requests'])),
+        throwsA(isA<PlatformException>()
+            .having((e) => e.code, 'code', 'CARD_BUSY')
+            .having((e) => e.message, 'message', 'Too many pending requests')),
+      );
+    });
+
+    test('reports unknown methods and statuses', () async {
+      await expectLater(complete(resultNotImplemented, null), throwsA(isA<MissingPluginException>()));
+      await expectLater(complete(42, null), throwsA(isA<StateError>()));
+    });
+  });
+
+  group('without the native library', () {
+    const MethodChannel channel = MethodChannel('nfcsigner');
+    final List<MethodCall> calls = [];
+    final skip = NfcsignerFfi.instance != null ? 'native library is loaded' : false;
+
+    setUp(() {
+      calls.clear();
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+        channel,
+        (MethodCall methodCall) async {
+          calls.add(methodCall);
+          switch (methodCall.method) {
+            case 'verifyCms':
+              return {'valid': true, 'digestAlgorithm': 'sha256'};
+            case 'cancel':
+              return true;
+          }
+          return null;
+        },
+      );
+    });
+
+    tearDown(() {
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+    });
+
+    test('bulk methods fall back to the method channel with the payload', () async {
+      final cms = Uint8List.fromList([0x30, 0x80]);
+      final content = Uint8List.fromList([1, 2, 3]);
+      final result = await Nfcsigner.verifyCms(cms: cms, content: content);
+
+      expect(result.isSuccess, isTrue);
+      expect(calls.single.method, 'verifyCms');
+      expect(calls.single.arguments['cms'], cms);
+      expect(calls.single.arguments['content'], content);
+    }, skip: skip);
+
+    test('cancel falls back to the method channel', () async {
+      final result = await Nfcsigner.cancel('sign-1');
+
+      expect(result.data, isTrue);
+      expect(calls.single.method, 'cancel');
+      expect(calls.single.arguments, {'requestId': 'sign-1'});
+    }, skip: skip);
+  });
+}
@@ -0,0 +1,64 @@
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  final List<MethodCall> calls = [];
+  final digest = Uint8List.fromList(List<int>.generate(32, (i) => i));
+
+  setUp(() {
+    calls.clear();
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        calls.add(methodCall);
+        return [
+          {'path': '/data/tài liệu/a.pdf', 'digest': digest},
+          {'path': '/data/missing.pdf', 'error': 'Không mở được file: /data/missing.pdf'},
+        ];
+      },
+    );
+  });
+
+  tearDown(() {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+  });
+
+  test('hashFiles sends paths and decodes per-file results', () async {
+    final result = await Nfcsigner.hashFiles(paths: ['/data/tài liệu', '/data/missing.pdf'], recursive: false);
+
+    expect(calls.single.method, 'hashFiles');
+    expect(calls.single.arguments, {
+      'paths': ['/data/tài liệu', '/data/missing.pdf'],
+      'recursive': false,
+    });
+    expect(result.isSuccess, isTrue);
+    expect(result.data, hasLength(2));
+    expect(result.data![0].path, '/data/tài liệu/a.pdf');
+    expect(result.data![0].isSuccess, isTrue);
+    expect(result.data![0].digest, digest);
+    expect(result.data![1].isSuccess, isFalse);
+    expect(result.data![1].error, contains('missing.pdf'));
+  });
+
+  test('hashFiles defaults to recursive', () async {
+    await Nfcsigner.hashFiles(paths: ['/data']);
+    expect(calls.single.arguments['recursive'], isTrue);
+  });
+
+  test('hashFiles maps a full worker queue to busy', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        throw PlatformException(code: 'CARD_BUSY', message: 'Too many pending requests');
+      },
+    );
+    final result = await Nfcsigner.hashFiles(paths: ['/data']);
+    expect(result.status, CardStatus.busy);
+  });
+}
@@ -0,0 +1,94 @@
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  final List<MethodCall> calls = [];
+  bool tracking = false;
+
+  Map<String, Object?> phase(int allocatedBytes) => {
+        'allocations': 4,
+        'allocatedBytes': allocatedBytes,
+        'freedBytes': allocatedBytes,
+        'peakLiveBytes': allocatedBytes,
+        'rssBeforeBytes': 50 << 20,
+        'rssAfterBytes': 51 << 20,
+      };
+
+  setUp(() {
+    calls.clear();
+    tracking = false;
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        calls.add(methodCall);
+        switch (methodCall.method) {
+          case 'setMemoryTracking':
+            tracking = methodCall.arguments['enabled'] as bool;
+            return {'enabled': tracking, 'allocationHooks': false};
+          case 'getSigningMetrics':
+            return {
+              'totalUs': 600000,
+              'memory': {
+                'enabled': tracking,
+                'allocationHooks': false,
+                'requests': 1,
+                'lastOperation': 'signPdf',
+                'lastPeakRssBytes': 52 << 20,
+                'lastPhases': {'parse': phase(1 << 20), 'copy': phase(2 << 20)},
+                'maxPhases': {'parse': phase(1 << 20), 'copy': phase(2 << 20)},
+                'currentRssBytes': 51 << 20,
+                'peakRssBytes': 52 << 20,
+              },
+            };
+        }
+        return null;
+      },
+    );
+  });
+
+  tearDown(() {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+  });
+
+  test('setMemoryTracking sends the flag and returns the tracking state', () async {
+    final result = await Nfcsigner.setMemoryTracking(enabled: true);
+
+    expect(result.isSuccess, isTrue);
+    expect(result.data, {'enabled': true, 'allocationHooks': false});
+    expect(calls.single.method, 'setMemoryTracking');
+    expect(calls.single.arguments, {'enabled': true});
+  });
+
+  test('getSigningMetrics reports the memory phases', () async {
+    final off = await Nfcsigner.getSigningMetrics();
+    expect(off.data!['memory']['enabled'], isFalse);
+
+    await Nfcsigner.setMemoryTracking(enabled: true);
+    final on = await Nfcsigner.getSigningMetrics();
+    final memory = on.data!['memory'] as Map<dynamic, dynamic>;
+    expect(memory['enabled'], isTrue);
+    expect(memory['lastOperation'], 'signPdf');
+    expect(memory['lastPhases']['copy']['allocatedBytes'], 2 << 20);
+    expect(memory['peakRssBytes'], 52 << 20);
+  });
+
+  test('setMemoryTracking maps native errors', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async => throw PlatformException(
+        code: 'STD_EXCEPTION',
+        message: 'Standard Exception: Arguments are null',
+      ),
+    );
+
+    final result = await Nfcsigner.setMemoryTracking(enabled: false);
+
+    expect(result.isSuccess, isFalse);
+    expect(result.status, CardStatus.unknownError);
+    expect(result.data, isNull);
+  });
+}
@@ -0,0 +1,83 @@
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  final List<MethodCall> calls = [];
+  bool selfCheck = false;
+
+  setUp(() {
+    calls.clear();
+    selfCheck = false;
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        calls.add(methodCall);
+        switch (methodCall.method) {
+          case 'setSignatureSelfCheck':
+            selfCheck = methodCall.arguments['enabled'] as bool;
+            return selfCheck;
+          case 'generateSignature':
+          case 'signFile':
+            // Thẻ ký bằng khóa khác certificate (sai keyIndex).
+            if (selfCheck) {
+              throw PlatformException(
+                code: 'SIGNATURE_MISMATCH',
+                message: 'Card signature does not match the certificate public key (wrong keyIndex?).',
+              );
+            }
+            return Uint8List.fromList([1, 2, 3]);
+        }
+        return null;
+      },
+    );
+  });
+
+  tearDown(() {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+  });
+
+  test('setSignatureSelfCheck sends the flag', () async {
+    final result = await Nfcsigner.setSignatureSelfCheck(enabled: true);
+
+    expect(result.isSuccess, isTrue);
+    expect(result.data, isTrue);
+    expect(calls.single.arguments, {'enabled': true});
+  });
+
+  test('mismatching card signatures map to signatureMismatch', () async {
+    await Nfcsigner.setSignatureSelfCheck(enabled: true);
+
+    final raw = await Nfcsigner.generateSignature(
+      appletID: 'A000',
+      pin: '1234',
+      dataToSign: Uint8List.fromList([0x30, 0x31]),
+      keyIndex: 1,
+    );
+    expect(raw.isSuccess, isFalse);
+    expect(raw.status, CardStatus.signatureMismatch);
+    expect(calls.last.method, 'generateSignature');
+    expect(calls.last.arguments, {
+      'appletID': 'A000',
+      'pin': '1234',
+      'dataToSign': Uint8List.fromList([0x30, 0x31]),
+      'keyIndex': 1,
+    });
+
+    final file = await Nfcsigner.signFile(filePath: '/tmp/a.bin', appletID: 'A000', pin: '1234', keyIndex: 1);
+    expect(file.status, CardStatus.signatureMismatch);
+    expect(file.message, contains('wrong keyIndex'));
+  });
+
+  test('signatures pass through while the check is off', () async {
+    final result = await Nfcsigner.signFile(filePath: '/tmp/a.bin', appletID: 'A000', pin: '1234');
+
+    expect(result.isSuccess, isTrue);
+    expect(result.data, [1, 2, 3]);
+  });
+}
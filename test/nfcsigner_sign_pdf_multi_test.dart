@@ -0,0 +1,98 @@
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+import 'package:nfcsigner/src/nfcsigner_ffi.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  final List<MethodCall> calls = [];
+  // signPdfMulti đi qua dart:ffi khi thư viện native được nạp.
+  final skip = NfcsignerFfi.instance != null ? 'native library is loaded' : false;
+
+  setUp(() {
+    calls.clear();
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        calls.add(methodCall);
+        if (methodCall.method != 'signPdfMulti') return null;
+        final List<dynamic> signatures = methodCall.arguments['signatures'] as List<dynamic>;
+        if (signatures.isEmpty) {
+          throw PlatformException(code: 'INVALID_PARAMETERS', message: 'signatures must not be empty.');
+        }
+        // Mỗi chữ ký thêm một revision.
+        return Uint8List.fromList([
+          ...methodCall.arguments['pdfBytes'] as Uint8List,
+          for (var i = 0; i < signatures.length; i++) 0xEE,
+        ]);
+      },
+    );
+  });
+
+  tearDown(() {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+  });
+
+  test('signPdfMulti sends every signature in order', () async {
+    final pdf = Uint8List.fromList([0x25, 0x50, 0x44, 0x46]);
+    final result = await Nfcsigner.signPdfMulti(
+      pdfBytes: pdf,
+      appletID: 'A000000001',
+      pin: '123456',
+      signatures: [
+        const PdfSignatureSpec(fieldName: 'Approver', keyIndex: 1),
+        const PdfSignatureSpec(
+          keyIndex: 1,
+          reason: 'Đối chiếu',
+          location: 'Da Nang',
+          signatureConfig: PdfSignatureConfig(pageNumber: 2, signerName: 'B'),
+        ),
+      ],
+      requestId: 'multi-1',
+      timeout: const Duration(seconds: 30),
+    );
+
+    expect(result.isSuccess, isTrue);
+    expect(result.data, [0x25, 0x50, 0x44, 0x46, 0xEE, 0xEE]);
+
+    final arguments = calls.single.arguments;
+    expect(arguments['pdfBytes'], pdf);
+    expect(arguments['appletID'], 'A000000001');
+    expect(arguments['pin'], '123456');
+    expect(arguments['requestId'], 'multi-1');
+    expect(arguments['deadlineMs'], 30000);
+
+    final List<dynamic> signatures = arguments['signatures'] as List<dynamic>;
+    expect(signatures, hasLength(2));
+    expect(signatures[0], {
+      'fieldName': 'Approver',
+      'keyIndex': 1,
+      'reason': 'Ký duyệt!',
+      'location': 'Hanoi',
+      'signatureConfig': null,
+    });
+    expect(signatures[1]['fieldName'], isNull);
+    expect(signatures[1]['reason'], 'Đối chiếu');
+    expect(signatures[1]['signatureConfig']['pageNumber'], 2);
+    expect(signatures[1]['signatureConfig']['signerName'], 'B');
+  }, skip: skip);
+
+  test('signPdfMulti maps native errors', () async {
+    final result = await Nfcsigner.signPdfMulti(
+      pdfBytes: Uint8List.fromList([0x25]),
+      appletID: 'A000000001',
+      pin: '123456',
+      signatures: const [],
+    );
+
+    expect(result.isSuccess, isFalse);
+    expect(result.status, CardStatus.invalidParameters);
+    expect(result.message, 'signatures must not be empty.');
+    expect(calls.single.arguments.containsKey('requestId'), isFalse);
+    expect(calls.single.arguments.containsKey('deadlineMs'), isFalse);
+  }, skip: skip);
+}
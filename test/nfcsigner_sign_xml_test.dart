@@ -0,0 +1,80 @@
+import 'dart:io';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  final List<MethodCall> calls = [];
+  // Chỉ Windows/Linux ký XML ở native; nền tảng khác ký trên Dart.
+  final skip = Platform.isWindows || Platform.isLinux ? false : 'native XML signing is desktop-only';
+
+  setUp(() {
+    calls.clear();
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        calls.add(methodCall);
+        if (methodCall.method != 'signXml') return null;
+        final String xml = methodCall.arguments['xmlContent'] as String;
+        if (!xml.endsWith('>')) {
+          throw PlatformException(code: 'INVALID_PARAMETERS', message: 'XML không hợp lệ');
+        }
+        return xml.replaceFirst('</HDon>', '<ds:Signature/></HDon>');
+      },
+    );
+  });
+
+  tearDown(() {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+  });
+
+  test('signXml signs in a single native call', () async {
+    final result = await Nfcsigner.signXml(
+      xmlContent: '<HDon><DLHDon Id="data"/></HDon>',
+      appletID: 'A000000001',
+      pin: '123456',
+      keyIndex: 1,
+      signatureConfig: const XmlSignatureConfig(
+        signatureId: 'seller',
+        canonicalizationMethod: 'http://www.w3.org/2001/10/xml-exc-c14n#',
+        referenceUri: '#data',
+        xpath: '/HDon',
+      ),
+    );
+
+    expect(result.isSuccess, isTrue);
+    expect(result.data, '<HDon><DLHDon Id="data"/><ds:Signature/></HDon>');
+    expect(calls.single.method, 'signXml');
+
+    final arguments = calls.single.arguments;
+    expect(arguments['appletID'], 'A000000001');
+    expect(arguments['pin'], '123456');
+    expect(arguments['keyIndex'], 1);
+    expect(arguments['signatureConfig']['signatureId'], 'seller');
+    expect(arguments['signatureConfig']['canonicalizationMethod'], 'http://www.w3.org/2001/10/xml-exc-c14n#');
+    expect(arguments['signatureConfig']['referenceUri'], '#data');
+    expect(arguments['signatureConfig']['xpath'], '/HDon');
+  }, skip: skip);
+
+  test('signXml sends the default configuration', () async {
+    await Nfcsigner.signXml(xmlContent: '<HDon/>', appletID: 'A000000001', pin: '123456');
+
+    final Map<dynamic, dynamic> config = calls.single.arguments['signatureConfig'] as Map<dynamic, dynamic>;
+    expect(config['canonicalizationMethod'], 'http://www.w3.org/TR/2001/REC-xml-c14n-20010315');
+    expect(config['includeCertificate'], isTrue);
+    expect(config['enveloped'], isTrue);
+    expect(calls.single.arguments['keyIndex'], 0);
+  }, skip: skip);
+
+  test('signXml maps native errors', () async {
+    final result = await Nfcsigner.signXml(xmlContent: '<HDon', appletID: 'A000000001', pin: '123456');
+
+    expect(result.isSuccess, isFalse);
+    expect(result.status, CardStatus.invalidParameters);
+    expect(result.message, 'XML không hợp lệ');
+  }, skip: skip);
+}
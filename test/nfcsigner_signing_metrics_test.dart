@@ -0,0 +1,63 @@
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  final List<MethodCall> calls = [];
+
+  setUp(() {
+    calls.clear();
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        calls.add(methodCall);
+        if (methodCall.method != 'getSigningMetrics') return null;
+        return {
+          'cardPreambleUs': 180000,
+          'verifyPinUs': 95000,
+          'pdfParseUs': 40000,
+          'pdfPrepareUs': 60000,
+          'joinWaitUs': 80000,
+          'parallelUs': 185000,
+          'signUs': 410000,
+          'totalUs': 600000,
+          'overlapSavedUs': 100000,
+          'incremental': true,
+          'count': 3,
+          'totalOverlapSavedUs': 250000,
+        };
+      },
+    );
+  });
+
+  tearDown(() {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+  });
+
+  test('getSigningMetrics returns the phase timings', () async {
+    final result = await Nfcsigner.getSigningMetrics();
+
+    expect(result.isSuccess, isTrue);
+    expect(result.data, isA<Map<String, dynamic>>());
+    expect(result.data!['overlapSavedUs'], 100000);
+    expect(result.data!['incremental'], isTrue);
+    expect(result.data!['count'], 3);
+    expect(calls.single.method, 'getSigningMetrics');
+    expect(calls.single.arguments, isNull);
+  });
+
+  test('getSigningMetrics maps unsupported platforms', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async => throw PlatformException(code: 'OPERATION_NOT_SUPPORTED'),
+    );
+
+    final result = await Nfcsigner.getSigningMetrics();
+
+    expect(result.isSuccess, isFalse);
+    expect(result.status, CardStatus.operationNotSupported);
+  });
+}
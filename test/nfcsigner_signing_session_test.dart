@@ -0,0 +1,116 @@
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+import 'package:nfcsigner/src/nfcsigner_ffi.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  final List<MethodCall> calls = [];
+  final Set<int> open = {};
+  // signPdfWithSession đi qua dart:ffi khi thư viện native được nạp.
+  final skip = NfcsignerFfi.instance != null ? 'native library is loaded' : false;
+
+  setUp(() {
+    calls.clear();
+    open.clear();
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        calls.add(methodCall);
+        switch (methodCall.method) {
+          case 'openSigningSession':
+            if (methodCall.arguments['pin'] != '123456') {
+              throw PlatformException(
+                code: 'AUTH_ERROR',
+                message: 'Verify PIN failed.',
+                details: {'sw1': 0x63, 'sw2': 0xC2},
+              );
+            }
+            open.add(7);
+            return 7;
+          case 'signPdfWithSession':
+            if (!open.contains(methodCall.arguments['session'])) {
+              throw PlatformException(code: 'INVALID_PARAMETERS', message: 'Unknown signing session.');
+            }
+            return Uint8List.fromList([...methodCall.arguments['pdfBytes'] as Uint8List, 0xEE]);
+          case 'closeSigningSession':
+            return open.remove(methodCall.arguments['session']);
+        }
+        return null;
+      },
+    );
+  });
+
+  tearDown(() {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+  });
+
+  test('openSigningSession sends the session configuration', () async {
+    final result = await Nfcsigner.openSigningSession(
+      appletID: 'A000000001',
+      pin: '123456',
+      keyIndex: 2,
+      signatureConfig: const PdfSignatureConfig(pageNumber: 3),
+    );
+
+    expect(result.isSuccess, isTrue);
+    expect(result.data!.handle, 7);
+    final arguments = calls.single.arguments;
+    expect(arguments['appletID'], 'A000000001');
+    expect(arguments['pin'], '123456');
+    expect(arguments['keyIndex'], 2);
+    expect(arguments['reason'], 'Ký duyệt!');
+    expect(arguments['location'], 'Hanoi');
+    expect(arguments['signatureConfig']['pageNumber'], 3);
+  });
+
+  test('openSigningSession maps a wrong PIN', () async {
+    final result = await Nfcsigner.openSigningSession(appletID: 'A000000001', pin: '000000');
+
+    expect(result.isSuccess, isFalse);
+    expect(result.status, CardStatus.authError);
+    expect(result.sw2, 0xC2);
+    expect(result.data, isNull);
+    expect(calls.single.arguments['signatureConfig'], isNull);
+  });
+
+  test('signPdfWithSession sends only the handle and the document', () async {
+    final session = (await Nfcsigner.openSigningSession(appletID: 'A000000001', pin: '123456')).data!;
+    final pdf = Uint8List.fromList([0x25, 0x50]);
+    final result = await Nfcsigner.signPdfWithSession(
+      session: session,
+      pdfBytes: pdf,
+      signDate: '2026-01-02T03:04:05',
+      requestId: 'session-1',
+      timeout: const Duration(seconds: 5),
+    );
+
+    expect(result.isSuccess, isTrue);
+    expect(result.data, [0x25, 0x50, 0xEE]);
+    expect(calls.last.method, 'signPdfWithSession');
+    expect(calls.last.arguments, {
+      'session': 7,
+      'pdfBytes': pdf,
+      'signDate': '2026-01-02T03:04:05',
+      'requestId': 'session-1',
+      'deadlineMs': 5000,
+    });
+  }, skip: skip);
+
+  test('closed sessions cannot sign and close only once', () async {
+    final session = (await Nfcsigner.openSigningSession(appletID: 'A000000001', pin: '123456')).data!;
+
+    final closed = await Nfcsigner.closeSigningSession(session);
+    expect(closed.data, isTrue);
+    expect(calls.last.arguments, {'session': 7});
+    expect((await Nfcsigner.closeSigningSession(session)).data, isFalse);
+
+    final result = await Nfcsigner.signPdfWithSession(session: session, pdfBytes: Uint8List.fromList([0x25]));
+    expect(result.isSuccess, isFalse);
+    expect(result.status, CardStatus.invalidParameters);
+  }, skip: skip);
+}
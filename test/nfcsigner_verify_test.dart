@@ -0,0 +1,132 @@
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  final List<MethodCall> calls = [];
+  final certificate = Uint8List.fromList([0x30, 0x82, 0x01, 0x0a]);
+
+  Map<String, Object?> verification({String? fieldName, bool valid = true}) => {
+        if (fieldName != null) 'fieldName': fieldName,
+        'subFilter': 'adbe.pkcs7.detached',
+        'valid': valid,
+        'digestValid': valid,
+        'signatureValid': true,
+        'coversWholeDocument': true,
+        'digestAlgorithm': 'sha256',
+        'signer': 'CN=Nguyễn Văn A',
+        'certificate': certificate,
+        'signingTime': 1700000000,
+        if (!valid) 'error': 'Digest nội dung không khớp messageDigest.',
+        'hashUs': 120,
+        'verifyUs': 80,
+      };
+
+  setUp(() {
+    calls.clear();
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        calls.add(methodCall);
+        final args = methodCall.arguments as Map<Object?, Object?>;
+        switch (methodCall.method) {
+          case 'verifyPdf':
+            if (args.containsKey('pdfList')) {
+              return [
+                {
+                  'signatures': [verification(fieldName: 'Signature1')],
+                  'parseUs': 15,
+                },
+                {'signatures': <Object?>[], 'error': 'Không đọc được tài liệu.'},
+              ];
+            }
+            return [verification(fieldName: 'Signature1'), verification(fieldName: 'Signature2', valid: false)];
+          case 'verifyCms':
+            return verification();
+          case 'verifySignature':
+            return args['digestAlgorithm'] == 'sha256';
+        }
+        return null;
+      },
+    );
+  });
+
+  tearDown(() {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+  });
+
+  test('verifyPdf decodes every signature in field order', () async {
+    final pdf = Uint8List.fromList([0x25, 0x50, 0x44, 0x46]);
+    final result = await Nfcsigner.verifyPdf(pdfBytes: pdf);
+
+    expect(calls.single.method, 'verifyPdf');
+    expect(calls.single.arguments['pdfBytes'], pdf);
+    expect(result.isSuccess, isTrue);
+    expect(result.data!.map((s) => s.fieldName), ['Signature1', 'Signature2']);
+    final first = result.data![0];
+    expect(first.valid, isTrue);
+    expect(first.signer, 'CN=Nguyễn Văn A');
+    expect(first.certificate, certificate);
+    expect(first.signingTime, DateTime.utc(2023, 11, 14, 22, 13, 20));
+    expect(result.data![1].valid, isFalse);
+    expect(result.data![1].error, isNotNull);
+  });
+
+  test('verifyPdfBatch keeps per-document errors', () async {
+    final result = await Nfcsigner.verifyPdfBatch(pdfList: [Uint8List(1), Uint8List(2)]);
+
+    expect(calls.single.arguments['pdfList'], hasLength(2));
+    expect(result.data, hasLength(2));
+    expect(result.data![0].isValid, isTrue);
+    expect(result.data![0].parseUs, 15);
+    expect(result.data![1].isValid, isFalse);
+    expect(result.data![1].error, isNotNull);
+  });
+
+  test('verifyCms sends detached content or a file path', () async {
+    final cms = Uint8List.fromList([0x30, 0x80]);
+    final result = await Nfcsigner.verifyCms(cms: cms, filePath: '/data/hợp đồng.pdf');
+
+    expect(calls.single.method, 'verifyCms');
+    expect(calls.single.arguments, {'cms': cms, 'content': null, 'filePath': '/data/hợp đồng.pdf'});
+    expect(result.isSuccess, isTrue);
+    expect(result.data!.valid, isTrue);
+    expect(result.data!.digestAlgorithm, 'sha256');
+  });
+
+  test('verifySignature forwards the digest algorithm', () async {
+    final valid = await Nfcsigner.verifySignature(
+      certificate: certificate,
+      data: Uint8List.fromList([1, 2, 3]),
+      signature: Uint8List(256),
+      digestAlgorithm: 'sha256',
+    );
+    final raw = await Nfcsigner.verifySignature(
+      certificate: certificate,
+      data: Uint8List.fromList([1, 2, 3]),
+      signature: Uint8List(256),
+    );
+
+    expect(valid.data, isTrue);
+    expect(raw.data, isFalse);
+    expect(calls.last.arguments['digestAlgorithm'], isNull);
+  });
+
+  test('verification errors surface as failures', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        throw PlatformException(code: 'STD_EXCEPTION', message: 'Standard Exception: CMS không hợp lệ.');
+      },
+    );
+    final result = await Nfcsigner.verifyCms(cms: Uint8List(2));
+    expect(result.isSuccess, isFalse);
+    expect(result.status, CardStatus.unknownError);
+    expect(result.message, contains('CMS'));
+  });
+}
@@ -0,0 +1,86 @@
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  final List<MethodCall> calls = [];
+  bool running = false;
+
+  setUp(() {
+    calls.clear();
+    running = false;
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        calls.add(methodCall);
+        if (methodCall.method != 'warmUp') return null;
+        // Native trả về ngay: lần đầu bắt đầu chạy nền, lần sau thấy báo cáo cũ.
+        final started = !running;
+        running = true;
+        return {
+          'started': started,
+          if (!started)
+            'last': {
+              'pcscUs': 1200,
+              'cryptoUs': 300,
+              'fontsUs': 45000,
+              'imageUs': 800,
+              'certificateUs': 0,
+              'appearanceUs': 0,
+              'totalUs': 47300,
+              'cardConnected': true,
+              'certificateCached': false,
+              'appearanceCached': false,
+              'errors': <Object?>[],
+            },
+        };
+      },
+    );
+  });
+
+  tearDown(() {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(channel, null);
+  });
+
+  test('warmUp sends only the options that are set', () async {
+    await Nfcsigner.warmUp();
+    await Nfcsigner.warmUp(
+      appletID: 'A000000001',
+      signatureConfig: const PdfSignatureConfig(signerName: 'Nguyễn Văn A'),
+    );
+
+    expect(calls.map((c) => c.method), ['warmUp', 'warmUp']);
+    expect(calls[0].arguments, isEmpty);
+    expect(calls[1].arguments['appletID'], 'A000000001');
+    expect(calls[1].arguments['signatureConfig']['signerName'], 'Nguyễn Văn A');
+  });
+
+  test('warmUp returns immediately and reports the last finished run', () async {
+    final first = await Nfcsigner.warmUp();
+    expect(first.isSuccess, isTrue);
+    expect(first.data!['started'], isTrue);
+    expect(first.data!.containsKey('last'), isFalse);
+
+    final second = await Nfcsigner.warmUp();
+    expect(second.data!['started'], isFalse);
+    final last = second.data!['last'] as Map;
+    expect(last['totalUs'], 47300);
+    expect(last['cardConnected'], isTrue);
+    expect(last['errors'], isEmpty);
+  });
+
+  test('warmUp errors surface as failures', () async {
+    TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger.setMockMethodCallHandler(
+      channel,
+      (MethodCall methodCall) async {
+        throw PlatformException(code: 'STD_EXCEPTION', message: 'Standard Exception: bad signatureConfig');
+      },
+    );
+    final result = await Nfcsigner.warmUp(signatureConfig: const PdfSignatureConfig());
+    expect(result.isSuccess, isFalse);
+    expect(result.status, CardStatus.unknownError);
+  });
+}
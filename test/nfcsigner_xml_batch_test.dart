@@ -0,0 +1,100 @@
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nfcsigner/nfcsigner.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const MethodChannel channel = MethodChannel('nfcsigner');
+  const EventChannel events = EventChannel('nfcsigner/xml_batch');
+  final messenger = TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+  final List<MethodCall> calls = [];
+  MockStreamHandlerEventSink? sink;
+
+  setUp(() {
+    calls.clear();
+    sink = null;
+    messenger.setMockStreamHandler(
+      events,
+      MockStreamHandler.inline(
+        onListen: (arguments, eventSink) => sink = eventSink,
+        onCancel: (arguments) => sink = null,
+      ),
+    );
+    messenger.setMockMethodCallHandler(channel, (MethodCall methodCall) async {
+      calls.add(methodCall);
+      if (methodCall.method != 'signXmlBatch') return null;
+      final List<dynamic> documents = methodCall.arguments['xmlContents'] as List<dynamic>;
+      final int? streamId = methodCall.arguments['streamId'] as int?;
+      final results = [
+        for (var i = 0; i < documents.length; i++)
+          documents[i] == '<bad'
+              ? {'index': i, 'error': 'XML không hợp lệ'}
+              : {'index': i, 'signedXml': '${documents[i]}<!--signed-->'},
+      ];
+      if (streamId == null) return results;
+      // Sự kiện của lô khác trên cùng stream phải bị bỏ qua.
+      sink!.success({'streamId': streamId + 1000, 'index': 0, 'signedXml': '<other/>'});
+      for (final result in results) {
+        sink!.success({...result, 'streamId': streamId});
+      }
+      return {'count': results.length, 'failed': results.where((r) => r.containsKey('error')).length};
+    });
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(channel, null);
+    messenger.setMockStreamHandler(events, null);
+  });
+
+  test('signXmlBatch returns every result at once', () async {
+    final result = await Nfcsigner.signXmlBatch(
+      xmlContents: ['<a/>', '<bad'],
+      appletID: 'A000000001',
+      pin: '123456',
+    );
+
+    expect(result.isSuccess, isTrue);
+    expect(result.data!.map((r) => r.index), [0, 1]);
+    expect(result.data![0].signedXml, '<a/><!--signed-->');
+    expect(result.data![1].isSuccess, isFalse);
+    expect(calls.single.arguments.containsKey('streamId'), isFalse);
+  });
+
+  test('signXmlBatchStreaming delivers each document of its own batch', () async {
+    final delivered = <XmlBatchResult>[];
+    final result = await Nfcsigner.signXmlBatchStreaming(
+      xmlContents: ['<a/>', '<bad', '<c/>'],
+      appletID: 'A000000001',
+      pin: '123456',
+      keyIndex: 1,
+      onResult: delivered.add,
+    );
+
+    expect(result.isSuccess, isTrue);
+    expect(result.data, 1);
+    expect(delivered.map((r) => r.index), [0, 1, 2]);
+    expect(delivered[0].signedXml, '<a/><!--signed-->');
+    expect(delivered[1].error, 'XML không hợp lệ');
+    expect(calls.single.arguments['streamId'], isA<int>());
+    expect(calls.single.arguments['keyIndex'], 1);
+  });
+
+  test('signXmlBatchStreaming maps batch failures', () async {
+    messenger.setMockMethodCallHandler(channel, (MethodCall methodCall) async {
+      throw PlatformException(code: 'PC/SC_ERROR', message: 'Verify PIN failed.');
+    });
+
+    final delivered = <XmlBatchResult>[];
+    final result = await Nfcsigner.signXmlBatchStreaming(
+      xmlContents: ['<a/>'],
+      appletID: 'A000000001',
+      pin: '000000',
+      onResult: delivered.add,
+    );
+
+    expect(result.isSuccess, isFalse);
+    expect(result.message, 'Verify PIN failed.');
+    expect(delivered, isEmpty);
+  });
+}
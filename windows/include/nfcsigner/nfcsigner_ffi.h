@@ -0,0 +1,82 @@
+#ifndef FLUTTER_PLUGIN_NFCSIGNER_FFI_H_
+#define FLUTTER_PLUGIN_NFCSIGNER_FFI_H_
+
+#include <stdint.h>
+
+#ifndef FLUTTER_PLUGIN_EXPORT
+#ifdef FLUTTER_PLUGIN_IMPL
+#define FLUTTER_PLUGIN_EXPORT __declspec(dllexport)
+#else
+#define FLUTTER_PLUGIN_EXPORT __declspec(dllimport)
+#endif
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// C ABI cho dart:ffi. Cùng các method như MethodChannel "nfcsigner", nhưng
+// dữ liệu lớn (PDF, nội dung cần ký/kiểm tra) và kết quả dạng bytes đi qua
+// NfcsignerFfiBuffer mà không chép, không qua StandardMethodCodec và không
+// chuyển sang platform thread.
+
+// Tăng khi ABI thay đổi không tương thích.
+#define NFCSIGNER_FFI_VERSION 3
+
+// Loại dữ liệu trong callback.
+#define NFCSIGNER_FFI_RESULT_BYTES 0            // kết quả là Uint8List, [data] là nội dung
+#define NFCSIGNER_FFI_RESULT_VALUE 1            // [data]: kết quả mã hóa StandardMessageCodec
+#define NFCSIGNER_FFI_RESULT_ERROR 2            // [data]: [code, message] mã hóa StandardMessageCodec
+#define NFCSIGNER_FFI_RESULT_NOT_IMPLEMENTED 3  // [data] là NULL
+
+// Bộ đệm bytes do native cấp: [data] trỏ vào vùng nhớ [length] byte mà
+// plugin dùng trực tiếp (tham số) hoặc đã tạo ra (kết quả). Trả lại bằng
+// NfcsignerFfiBufferRelease.
+typedef struct NfcsignerFfiBuffer {
+    uint8_t* data;
+    int64_t length;
+} NfcsignerFfiBuffer;
+
+// Gọi đúng một lần cho mỗi request được chấp nhận, từ một luồng native. Dart
+// sở hữu [result] (NULL nếu không có dữ liệu) và trả lại bằng
+// NfcsignerFfiBufferRelease.
+typedef void (*NfcsignerFfiCallback)(int64_t request_id, int32_t status, NfcsignerFfiBuffer* result);
+
+FLUTTER_PLUGIN_EXPORT int32_t NfcsignerFfiGetVersion(void);
+
+// Bộ đệm native cho caller (NULL nếu hết bộ nhớ) và hàm giải phóng tương ứng,
+// dùng được làm NativeFinalizer.
+FLUTTER_PLUGIN_EXPORT uint8_t* NfcsignerFfiAllocate(int64_t size);
+FLUTTER_PLUGIN_EXPORT void NfcsignerFfiFree(void* data);
+
+// Bộ đệm [size] byte cho payload của NfcsignerFfiInvoke (NULL nếu [size] âm
+// hoặc hết bộ nhớ) và hàm trả lại, dùng được làm NativeFinalizer với token là
+// chính bộ đệm.
+FLUTTER_PLUGIN_EXPORT NfcsignerFfiBuffer* NfcsignerFfiBufferCreate(int64_t size);
+FLUTTER_PLUGIN_EXPORT void NfcsignerFfiBufferRelease(void* buffer);
+
+// Gọi [method] với [arguments] (map mã hóa StandardMessageCodec, có thể rỗng)
+// cộng thêm [payload] dưới khóa [payload_key] (nếu khác NULL). [method],
+// [arguments] và [payload_key] chỉ được đọc trong lúc gọi hàm này. [payload]
+// (từ NfcsignerFfiBufferCreate, có thể NULL) luôn thuộc về native sau lời gọi,
+// kể cả khi trả về -1: method đọc thẳng bộ đệm đó, caller không trả lại.
+// Method chạy trên worker có giới hạn của plugin; kết quả đến qua [callback]
+// (lỗi CARD_BUSY nếu hàng đợi đầy). Token hủy theo "requestId" được đăng ký
+// trước khi hàm trả về, nên NfcsignerFfiCancel hủy được cả request còn chờ.
+// Trả về 0 nếu đã nhận request, -1 nếu tham số không hợp lệ (không có callback).
+FLUTTER_PLUGIN_EXPORT int32_t NfcsignerFfiInvoke(int64_t request_id, const char* method,
+                                                 const uint8_t* arguments, int64_t arguments_length,
+                                                 const char* payload_key, NfcsignerFfiBuffer* payload,
+                                                 NfcsignerFfiCallback callback);
+
+// Hủy request đang chạy có "requestId" == [request_id] (tham số của method),
+// kể cả request đi qua MethodChannel: gọi trực tiếp từ luồng của Dart nên
+// không phải chờ platform thread đang bận với chính request đó.
+// Trả về 1 nếu đã hủy, 0 nếu không có request đó, -1 nếu [request_id] là NULL.
+FLUTTER_PLUGIN_EXPORT int32_t NfcsignerFfiCancel(const char* request_id);
+
+#if defined(__cplusplus)
+}  // extern "C"
+#endif
+
+#endif  // FLUTTER_PLUGIN_NFCSIGNER_FFI_H_
@@ -1,15 +1,44 @@
 #define NOMINMAX  // Ngăn chặn định nghĩa min và max từ windows.h
 
 #include "nfcsigner_plugin.h"
+#include "card_apdu.h"
+#include "cms_template.h"
+#include "signature_appearance.h"
+#include "lazy_pdf.h"
+#include "signing_metrics.h"
+#include "file_digest.h"
+#include "signature_verify.h"
+#include "card_scheduler.h"
+#include "single_flight.h"
+#include "pcsc_card.h"
+#include "pdf_signer.h"
+#include "signing_session.h"
+#include "cancellation.h"
+#include "xml_dsig.h"
+#include "warm_up.h"
+#include "request_arena.h"
+#include "memory_accounting.h"
+#include "worker_pool.h"
 
 #include <windows.h>
 // For getPlatformVersion; remove unless needed for your plugin implementation.
 #include <VersionHelpers.h>
+#include <flutter/event_channel.h>
+#include <flutter/event_stream_handler_functions.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
 #include <winscard.h>
+#include <algorithm>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
 #include <sstream>
 #include <iostream>
 #include <string>
@@ -30,88 +59,194 @@ using namespace PoDoFo;
 
 namespace nfcsigner {
 
-    // Helper function to convert hex string to byte vector
-    std::vector<uint8_t> HexToBytes(const std::string& hex) {
-        std::vector<uint8_t> bytes;
-        if (hex.length() % 2 != 0) {
-            throw std::runtime_error("Hex string must have even length");
+    // Request đã bị hủy/hết hạn: lỗi của bước đang chạy dở (PC/SC, PoDoFo...)
+    // được báo bằng mã CANCELLED/DEADLINE_EXCEEDED để Dart phân biệt được.
+    class CancellableMethodResult : public flutter::MethodResult<flutter::EncodableValue> {
+    public:
+        CancellableMethodResult(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> inner,
+                                std::shared_ptr<CancellationToken> token)
+                : inner_(std::move(inner)), token_(std::move(token)) {}
+
+    protected:
+        void SuccessInternal(const flutter::EncodableValue* result) override {
+            if (result) {
+                inner_->Success(*result);
+            } else {
+                inner_->Success();
+            }
         }
 
-        for (size_t i = 0; i < hex.length(); i += 2) {
-            std::string byteString = hex.substr(i, 2);
-            char* end;
-            uint8_t byte = static_cast<uint8_t>(strtol(byteString.c_str(), &end, 16));
-            if (*end != '\0') {
-                throw std::runtime_error("Invalid hex character");
+        void ErrorInternal(const std::string& errorCode, const std::string& errorMessage,
+                           const flutter::EncodableValue* errorDetails) override {
+            if (token_->IsCancelled()) {
+                inner_->Error(token_->IsDeadlineExceeded() ? "DEADLINE_EXCEEDED" : "CANCELLED", errorMessage);
+            } else if (errorDetails) {
+                inner_->Error(errorCode, errorMessage, *errorDetails);
+            } else {
+                inner_->Error(errorCode, errorMessage);
             }
-            bytes.push_back(byte);
         }
-        return bytes;
-    }
-    template<typename T>
-    std::string ToHexString(const T& data) {
-        const char hex_chars[] = "0123456789abcdef";
-        std::string hex_str;
-        hex_str.reserve(data.size() * 2); // Cấp phát sẵn bộ nhớ để tăng hiệu quả
 
-        for (unsigned char byte : data) {
-            hex_str += hex_chars[(byte >> 4) & 0x0F]; // Ký tự cho 4 bit cao
-            hex_str += hex_chars[byte & 0x0F];        // Ký tự cho 4 bit thấp
+        void NotImplementedInternal() override {
+            inner_->NotImplemented();
         }
 
-        return hex_str;
-    }
-    std::vector<uint8_t> CreateSelectAppletCommand(const std::string& appletID) {
-        auto appletID_bytes = HexToBytes(appletID);
-        std::vector<uint8_t> cmd = { 0x00, 0xA4, 0x04, 0x00, (uint8_t)appletID_bytes.size() };
-        cmd.insert(cmd.end(), appletID_bytes.begin(), appletID_bytes.end());
-        cmd.push_back(0x00);
-        return cmd;
-    }
+    private:
+        std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> inner_;
+        std::shared_ptr<CancellationToken> token_;
+    };
+
+    // Flutter chỉ nhận kết quả MethodChannel trên platform thread. Việc từ
+    // worker được xếp hàng, rồi cửa sổ gốc được đánh thức bằng một message
+    // riêng để chạy chúng trong window proc.
+    class PlatformTaskRunner {
+    public:
+        explicit PlatformTaskRunner(flutter::PluginRegistrarWindows* registrar)
+                : registrar_(registrar),
+                  message_(RegisterWindowMessage(L"NfcsignerPlatformTask")),
+                  window_(GetAncestor(registrar->GetView()->GetNativeWindow(), GA_ROOT)) {
+            window_proc_id_ = registrar_->RegisterTopLevelWindowProcDelegate(
+                    [this](HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) {
+                        return HandleWindowProc(hwnd, message, wparam, lparam);
+                    });
+        }
 
-    std::vector<uint8_t> CreateVerifyPinCommand(const std::string& pin) {
-        std::vector<uint8_t> pin_bytes(pin.begin(), pin.end());
-        std::vector<uint8_t> cmd = { 0x00, 0x20, 0x00, 0x81, (uint8_t)pin_bytes.size() };
-        cmd.insert(cmd.end(), pin_bytes.begin(), pin_bytes.end());
-        return cmd;
-    }
+        // Gọi trên platform thread khi plugin bị hủy; việc còn chờ bị bỏ.
+        void Stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stopped_) return;
+                stopped_ = true;
+                tasks_.clear();
+            }
+            registrar_->UnregisterTopLevelWindowProcDelegate(window_proc_id_);
+        }
 
-    std::vector<uint8_t> CreateComputeSignatureCommand(const std::vector<uint8_t>& data, int keyIndex) {
-        uint8_t p1 = 0x9E;
-        uint8_t p2;
-        switch (keyIndex) {
-            case 1: p2 = 0x9B; break;
-            case 2: p2 = 0x9C; break;
-            default: p2 = 0x9A; break;
+        void Post(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stopped_) return;
+                tasks_.push_back(std::move(task));
+            }
+            PostMessage(window_, message_, 0, 0);
+        }
+
+    private:
+        std::optional<LRESULT> HandleWindowProc(HWND, UINT message, WPARAM, LPARAM) {
+            if (message != message_) return std::nullopt;
+            std::deque<std::function<void()>> tasks;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                tasks.swap(tasks_);
+            }
+            for (auto& task : tasks) task();
+            return 0;
+        }
+
+        flutter::PluginRegistrarWindows* registrar_;
+        UINT message_;
+        HWND window_;
+        int window_proc_id_ = -1;
+        std::mutex mutex_;
+        std::deque<std::function<void()>> tasks_;
+        bool stopped_ = false;
+    };
+
+    // Handler chạy trên worker; Success/Error được chuyển về platform thread.
+    class PlatformThreadMethodResult : public flutter::MethodResult<flutter::EncodableValue> {
+    public:
+        PlatformThreadMethodResult(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> inner,
+                                   std::shared_ptr<PlatformTaskRunner> runner)
+                : inner_(std::move(inner)), runner_(std::move(runner)) {}
+
+    protected:
+        void SuccessInternal(const flutter::EncodableValue* result) override {
+            auto inner = inner_;
+            if (result) {
+                Post([inner, value = *result]() { inner->Success(value); });
+            } else {
+                Post([inner]() { inner->Success(); });
+            }
         }
-        std::vector<uint8_t> cmd = { 0x00, 0x2A, p1, p2, (uint8_t)data.size() };
-        cmd.insert(cmd.end(), data.begin(), data.end());
-        cmd.push_back(0x00);
-        return cmd;
-    }
 
-    std::vector<uint8_t> CreateSelectCertificateCommand() {
-        std::vector<uint8_t> data = { 0x60, 0x04, 0x5C, 0x02, 0x7F, 0x21 };
-        std::vector<uint8_t> cmd = { 0x00, 0xA5, 0x02, 0x04, (uint8_t)data.size() };
-        cmd.insert(cmd.end(), data.begin(), data.end());
-        cmd.push_back(0x00);
-        return cmd;
+        void ErrorInternal(const std::string& errorCode, const std::string& errorMessage,
+                           const flutter::EncodableValue* errorDetails) override {
+            auto inner = inner_;
+            if (errorDetails) {
+                Post([inner, errorCode, errorMessage, details = *errorDetails]() {
+                    inner->Error(errorCode, errorMessage, details);
+                });
+            } else {
+                Post([inner, errorCode, errorMessage]() { inner->Error(errorCode, errorMessage); });
+            }
+        }
+
+        void NotImplementedInternal() override {
+            auto inner = inner_;
+            Post([inner]() { inner->NotImplemented(); });
+        }
+
+    private:
+        // Plugin tạo không qua registrar (đường dart:ffi) thì trả lời tại chỗ.
+        void Post(std::function<void()> task) {
+            if (runner_) {
+                runner_->Post(std::move(task));
+            } else {
+                task();
+            }
+        }
+
+        std::shared_ptr<flutter::MethodResult<flutter::EncodableValue>> inner_;
+        std::shared_ptr<PlatformTaskRunner> runner_;
+    };
+
+    // Sink của EventChannel "nfcsigner/xml_batch": signXmlBatch có streamId
+    // gửi từng tài liệu ngay khi ký xong thay vì gom cả lô vào một kết quả.
+    // Chỉ được chạm trên platform thread.
+    struct XmlBatchEventSink {
+        std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> sink;
+    };
+
+    // Worker cho thao tác thẻ/file. Thao tác thẻ vẫn xếp hàng theo ưu tiên ở
+    // CardScheduler; hàng đợi ở đây chỉ chặn số request treo quá nhiều.
+    constexpr size_t kMethodWorkerThreads = 4;
+    constexpr size_t kMethodQueueCapacity = 32;
+    // Băm và kiểm tra chữ ký có nhóm riêng: không xếp sau thao tác thẻ đang
+    // chờ reader, và mỗi request đã tự chạy song song theo số lõi.
+    constexpr size_t kFileWorkerThreads = 2;
+    constexpr size_t kFileQueueCapacity = 16;
+
+    bool IsFileMethod(const std::string& method) {
+        static const std::set<std::string> kFileMethods = { "hashFiles", "verifyPdf", "verifyCms", "verifySignature" };
+        return kFileMethods.count(method) != 0;
     }
-    std::vector<uint8_t> CreateGetRsaPublicKeyCommand(const std::string& keyRole) {
-        std::vector<uint8_t> data;
-        if (keyRole == "sig") data = { 0xB6, 0x00 };
-        else if (keyRole == "dec") data = { 0xB8, 0x00 };
-        else if (keyRole == "aut") data = { 0xA4, 0x00 };
-        else if (keyRole == "sm") data = { 0xA6, 0x00 };
-        else throw std::runtime_error("Invalid key role.");
 
-        std::vector<uint8_t> cmd = { 0x00, 0x47, 0x81, 0x00, (uint8_t)data.size() };
-        cmd.insert(cmd.end(), data.begin(), data.end());
-        cmd.push_back(0x00);
-        return cmd;
+    // Không chạm thẻ hay file, trả lời ngay trên platform thread. cancel phải
+    // chạy ở đây để hủy được request đang chạy trên worker.
+    bool IsImmediateMethod(const std::string& method) {
+        static const std::set<std::string> kImmediateMethods = {
+                "cancel", "getSigningMetrics", "getCardQueueMetrics", "setSignatureSelfCheck",
+                "setCardRecoveryPolicy", "setMemoryTracking", "warmUp",
+        };
+        return kImmediateMethods.count(method) != 0;
     }
-    std::vector<uint8_t> CreateGetCertificateCommand() {
-        return { 0x00, 0xCA, 0x7F, 0x21, 0x00 };
+
+    // Token hủy theo requestId/deadlineMs trong tham số. Đăng ký lúc nhận
+    // request, trước khi vào hàng đợi worker, để cancel(requestId) hủy được cả
+    // request chưa bắt đầu.
+    std::shared_ptr<CancellationToken> RegisterRequest(const flutter::EncodableValue* arguments) {
+        std::string requestId;
+        int64_t deadlineMs = 0;
+        const auto* args = arguments ? std::get_if<flutter::EncodableMap>(arguments) : nullptr;
+        if (args) {
+            auto requestIdIt = args->find(flutter::EncodableValue("requestId"));
+            if (requestIdIt != args->end()) {
+                if (const auto* value = std::get_if<std::string>(&requestIdIt->second)) requestId = *value;
+            }
+            auto deadlineIt = args->find(flutter::EncodableValue("deadlineMs"));
+            if (deadlineIt != args->end() && !deadlineIt->second.IsNull()) deadlineMs = deadlineIt->second.LongValue();
+        }
+        return CancellationRegistry::Instance().Register(requestId, deadlineMs);
     }
 
 // static
@@ -122,25 +257,148 @@ void NfcsignerPlugin::RegisterWithRegistrar(
           registrar->messenger(), "nfcsigner",
           &flutter::StandardMethodCodec::GetInstance());
 
-  auto plugin = std::make_unique<NfcsignerPlugin>();
+  auto plugin = std::make_unique<NfcsignerPlugin>(registrar);
+  // Bật bằng NFCSIGNER_WARM_UP=1: lần signPdf đầu tiên không phải trả chi phí
+  // khởi tạo PC/SC, OpenSSL, font.
+  if (IsAutoWarmUpEnabled()) plugin->StartWarmUp(WarmUpOptions());
 
   channel->SetMethodCallHandler(
       [plugin_pointer = plugin.get()](const auto &call, auto result) {
         plugin_pointer->HandleMethodCall(call, std::move(result));
       });
 
+  auto xml_batch_channel =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          registrar->messenger(), "nfcsigner/xml_batch",
+          &flutter::StandardMethodCodec::GetInstance());
+  xml_batch_channel->SetStreamHandler(
+      std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [events = plugin->xml_batch_events_](
+              const flutter::EncodableValue *,
+              std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> &&sink)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            events->sink = std::move(sink);
+            return nullptr;
+          },
+          [events = plugin->xml_batch_events_](const flutter::EncodableValue *)
+              -> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+            events->sink.reset();
+            return nullptr;
+          }));
+
   registrar->AddPlugin(std::move(plugin));
+
 }
 
-NfcsignerPlugin::NfcsignerPlugin() {}
+NfcsignerPlugin::NfcsignerPlugin()
+    : xml_batch_events_(std::make_shared<XmlBatchEventSink>()) {}
 
-NfcsignerPlugin::~NfcsignerPlugin() {}
+NfcsignerPlugin::NfcsignerPlugin(flutter::PluginRegistrarWindows *registrar)
+    : platform_runner_(std::make_shared<PlatformTaskRunner>(registrar)),
+      xml_batch_events_(std::make_shared<XmlBatchEventSink>()) {}
+
+NfcsignerPlugin::~NfcsignerPlugin() {
+    // Request còn chờ hoặc đang chạy dừng ở điểm kiểm tra kế tiếp thay vì
+    // giữ tiến trình lại tới khi thẻ trả lời.
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        for (const auto& token : accepted_requests_) token->Cancel();
+    }
+    // Worker xong việc trước, rồi mới gỡ window proc nhận kết quả của chúng.
+    if (workers_) workers_->Shutdown();
+    if (file_workers_) file_workers_->Shutdown();
+    if (warm_up_worker_) warm_up_worker_->Shutdown();
+    if (platform_runner_) platform_runner_->Stop();
+}
 
 void NfcsignerPlugin::HandleMethodCall(
     const flutter::MethodCall<flutter::EncodableValue> &method_call,
     std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+    if (IsImmediateMethod(method_call.method_name())) {
+        RunMethodCall(method_call, std::move(result));
+        return;
+    }
+
+    // method_call chỉ sống trong lời gọi này: worker nhận bản sao tham số.
+    const auto* arguments = method_call.arguments();
+    SubmitMethodCall(
+        std::make_shared<flutter::MethodCall<flutter::EncodableValue>>(
+            method_call.method_name(),
+            arguments ? std::make_unique<flutter::EncodableValue>(*arguments) : nullptr),
+        std::make_unique<PlatformThreadMethodResult>(std::move(result), platform_runner_));
+}
+
+void NfcsignerPlugin::SubmitMethodCall(
+    std::shared_ptr<const flutter::MethodCall<flutter::EncodableValue>> call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+    if (IsImmediateMethod(call->method_name())) {
+        RunMethodCall(*call, std::move(result));
+        return;
+    }
+
+    auto pending = std::make_shared<std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>>(std::move(result));
+    auto token = RegisterRequest(call->arguments());
+    bool fileWork = IsFileMethod(call->method_name());
+    WorkerPool* workers = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        accepted_requests_.insert(token);
+        // Tạo khi có method đầu tiên; đường dart:ffi gọi từ nhiều isolate.
+        std::unique_ptr<WorkerPool>& pool = fileWork ? file_workers_ : workers_;
+        if (!pool) {
+            pool = fileWork ? std::make_unique<WorkerPool>(kFileWorkerThreads, kFileQueueCapacity)
+                            : std::make_unique<WorkerPool>(kMethodWorkerThreads, kMethodQueueCapacity);
+        }
+        workers = pool.get();
+    }
+    auto finish = [this, token]() {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        accepted_requests_.erase(token);
+    };
+
+    bool accepted = workers->Submit([this, call, pending, token, finish]() {
+        RunAcceptedCall(*call, std::move(*pending), token);
+        finish();
+    });
+    if (!accepted) {
+        finish();
+        CancellationRegistry::Instance().Unregister(token);
+        (*pending)->Error("CARD_BUSY", "Too many pending requests");
+    }
+}
+
+void NfcsignerPlugin::RunMethodCall(
+    const flutter::MethodCall<flutter::EncodableValue> &method_call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+    const auto* args = std::get_if<flutter::EncodableMap>(method_call.arguments());
+
+    // cancel chạy ngay, không tạo token cho chính nó.
+    if (method_call.method_name().compare("cancel") == 0) {
+        HandleCancel(args, std::move(result));
+        return;
+    }
+
+    RunAcceptedCall(method_call, std::move(result), RegisterRequest(method_call.arguments()));
+}
+
+void NfcsignerPlugin::RunAcceptedCall(
+    const flutter::MethodCall<flutter::EncodableValue> &method_call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result,
+    std::shared_ptr<CancellationToken> token) {
     const auto* args = std::get_if<flutter::EncodableMap>(method_call.arguments());
 
+    // Request có requestId/deadlineMs hủy được: cancel(requestId) hoặc hết hạn
+    // thì thao tác dừng ở điểm kiểm tra kế tiếp (giữa các APDU, giữa các bước PDF).
+    RequestCancellation cancellation(std::move(token));
+    if (cancellation.IsCancellable()) {
+        result = std::make_unique<CancellableMethodResult>(std::move(result), cancellation.GetToken());
+    }
+    // Bị hủy khi còn chờ worker (hoặc plugin đang bị hủy).
+    if (cancellation.GetToken()->IsCancelled()) {
+        result->Error("CANCELLED", "Request cancelled before it started");
+        return;
+    }
+
     if (method_call.method_name().compare("generateSignature") == 0) {
         HandleSign(args, std::move(result));
     } else if (method_call.method_name().compare("getRsaPublicKey") == 0) {
@@ -149,96 +407,68 @@ void NfcsignerPlugin::HandleMethodCall(
         HandleGetCertificate(args, std::move(result));
     } else if (method_call.method_name().compare("signPdf") == 0) {
         HandleSignPdf(args, std::move(result));
+    } else if (method_call.method_name().compare("signPdfMulti") == 0) {
+        HandleSignPdfMulti(args, std::move(result));
+    } else if (method_call.method_name().compare("getSigningMetrics") == 0) {
+        HandleGetSigningMetrics(std::move(result));
+    } else if (method_call.method_name().compare("generateXMLSignature") == 0) {
+        HandleGenerateXmlSignature(args, std::move(result));
+    } else if (method_call.method_name().compare("signXml") == 0) {
+        HandleSignXml(args, std::move(result));
+    } else if (method_call.method_name().compare("signXmlBatch") == 0) {
+        HandleSignXmlBatch(args, std::move(result));
+    } else if (method_call.method_name().compare("signFile") == 0) {
+        HandleSignFile(args, std::move(result));
+    } else if (method_call.method_name().compare("hashFiles") == 0) {
+        HandleHashFiles(args, std::move(result));
+    } else if (method_call.method_name().compare("verifyPdf") == 0) {
+        HandleVerifyPdf(args, std::move(result));
+    } else if (method_call.method_name().compare("verifyCms") == 0) {
+        HandleVerifyCms(args, std::move(result));
+    } else if (method_call.method_name().compare("verifySignature") == 0) {
+        HandleVerifySignature(args, std::move(result));
+    } else if (method_call.method_name().compare("setSignatureSelfCheck") == 0) {
+        HandleSetSignatureSelfCheck(args, std::move(result));
+    } else if (method_call.method_name().compare("warmUp") == 0) {
+        HandleWarmUp(args, std::move(result));
+    } else if (method_call.method_name().compare("setCardRecoveryPolicy") == 0) {
+        HandleSetCardRecoveryPolicy(args, std::move(result));
+    } else if (method_call.method_name().compare("setMemoryTracking") == 0) {
+        HandleSetMemoryTracking(args, std::move(result));
+    } else if (method_call.method_name().compare("openSigningSession") == 0) {
+        HandleOpenSigningSession(args, std::move(result));
+    } else if (method_call.method_name().compare("signPdfWithSession") == 0) {
+        HandleSignPdfWithSession(args, std::move(result));
+    } else if (method_call.method_name().compare("closeSigningSession") == 0) {
+        HandleCloseSigningSession(args, std::move(result));
+    } else if (method_call.method_name().compare("getCardQueueMetrics") == 0) {
+        HandleGetCardQueueMetrics(std::move(result));
     } else {
     result->NotImplemented();
   }
 }
 // Wrapper for an entire card operation
     template<typename Func>
-    void CardOperation(Func&& operation, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
-        SCARDCONTEXT hContext = 0;
-        SCARDHANDLE hCard = 0;
-        DWORD dwActiveProtocol = 0;
-
+    void CardOperation(Func&& operation, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result,
+                       CardPriority priority) {
         try {
-            LONG lReturn = SCardEstablishContext(SCARD_SCOPE_USER, NULL, NULL, &hContext);
-            if (lReturn != SCARD_S_SUCCESS) throw std::runtime_error("SCardEstablishContext failed.");
-
-            DWORD dwReaders = SCARD_AUTOALLOCATE;
-            LPTSTR mszReaders = NULL;
-            lReturn = SCardListReaders(hContext, NULL, (LPTSTR)&mszReaders, &dwReaders);
-            if (lReturn != SCARD_S_SUCCESS || mszReaders == NULL || mszReaders[0] == '\0') {
-                if (mszReaders) SCardFreeMemory(hContext, mszReaders);
-                throw std::runtime_error("No card reader found.");
-            }
-
-            lReturn = SCardConnect(hContext, mszReaders, SCARD_SHARE_SHARED, SCARD_PROTOCOL_T0 | SCARD_PROTOCOL_T1, &hCard, &dwActiveProtocol);
-            SCardFreeMemory(hContext, mszReaders);
-            if (lReturn != SCARD_S_SUCCESS) throw std::runtime_error("SCardConnect failed. Is a card inserted?");
-
-            operation(hCard);
-
+            WithCardConnection(std::forward<Func>(operation), priority);
+        } catch (const CardBusyError& e) {
+            result->Error("CARD_BUSY", e.what());
+        } catch (const CardSignatureMismatch& e) {
+            result->Error("SIGNATURE_MISMATCH", e.what());
         } catch (const std::runtime_error& e) {
             result->Error("PC/SC_ERROR", e.what());
         }
-
-        if (hCard) SCardDisconnect(hCard, SCARD_LEAVE_CARD);
-        if (hContext) SCardReleaseContext(hContext);
     }
 
-// APDU Transmit function with GET RESPONSE handling
-    std::vector<uint8_t> NfcsignerPlugin::TransmitAndGetResponse(SCARDHANDLE hCard, const std::vector<uint8_t>& command) {
-
-        //const SCARD_IO_REQUEST* pci;
-
-        std::vector<uint8_t> response_buffer(260, 0); // 256 data + 2 status words
-        DWORD response_len = 260;
-
-        // Sử dụng SCARD_PCI_T1 nếu protocol là T1, ngược lại là T0
-        // Trong ví dụ này, ta giả định T0 hoặc để Windows tự chọn. Dùng SCARD_PCI_T0 là phổ biến.
-        LONG lReturn = SCardTransmit(hCard, SCARD_PCI_T1, command.data(), (DWORD)command.size(), NULL, response_buffer.data(), &response_len);
-        if (lReturn != SCARD_S_SUCCESS) {
-            throw std::runtime_error("Lỗi SCardTransmit.");
-        }
-        response_buffer.resize(response_len);
-
-        if (response_len >= 2 && response_buffer[response_len - 2] == 0x61) {
-            std::vector<uint8_t> full_response_data;
-            if (response_len > 2) {
-                full_response_data.insert(full_response_data.end(), response_buffer.begin(), response_buffer.end() - 2);
-            }
-
-            while (response_buffer[response_len - 2] == 0x61) {
-                uint8_t le = response_buffer[response_len - 1];
-                std::vector<uint8_t> get_response_cmd = { 0x00, 0xC0, 0x00, 0x00, le };
-
-                response_len = 260;
-                response_buffer.assign(260, 0);
-
-                lReturn = SCardTransmit(hCard, SCARD_PCI_T1, get_response_cmd.data(), (DWORD)get_response_cmd.size(), NULL, response_buffer.data(), &response_len);
-                if (lReturn != SCARD_S_SUCCESS) {
-                    throw std::runtime_error("Lỗi SCardTransmit khi GET RESPONSE.");
-                }
-                response_buffer.resize(response_len);
-
-                if (response_len > 2) {
-                    full_response_data.insert(full_response_data.end(), response_buffer.begin(), response_buffer.end() - 2);
-                }
-            }
-            full_response_data.push_back(response_buffer[response_len - 2]);
-            full_response_data.push_back(response_buffer[response_len - 1]);
-            return full_response_data;
-        }
-
-        return response_buffer;
-    }
     void NfcsignerPlugin::HandleSign(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
         auto p_result = result.release();
         CardOperation([this, args, p_result](SCARDHANDLE hCard) {
             // Lấy tham số
             auto appletID = std::get<std::string>(args->at(flutter::EncodableValue("appletID")));
             auto pin = std::get<std::string>(args->at(flutter::EncodableValue("pin")));
-            auto dataToSign = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("dataToSign")));
+            const auto& dataToSign = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("dataToSign")));
             auto keyIndex = std::get<int>(args->at(flutter::EncodableValue("keyIndex")));
 
             // Chuỗi lệnh APDU
@@ -247,151 +477,559 @@ void NfcsignerPlugin::HandleMethodCall(
                 throw std::runtime_error("Chọn Applet thất bại.");
             }
 
+            // Tự kiểm tra cần khóa công khai: đọc certificate (template được cache).
+            std::shared_ptr<const CmsTemplate> cmsTemplate;
+            if (IsCardSignatureSelfCheckEnabled()) {
+                auto select_cert_resp = TransmitAndGetResponse(hCard, CreateSelectCertificateCommand());
+                if (select_cert_resp.size() < 2 || select_cert_resp[select_cert_resp.size() - 2] != 0x90) {
+                    throw std::runtime_error("Chọn dữ liệu Certificate thất bại.");
+                }
+                auto cert_resp = TransmitAndGetResponse(hCard, CreateGetCertificateCommand());
+                if (cert_resp.size() < 3 || cert_resp[cert_resp.size() - 2] != 0x90) {
+                    throw std::runtime_error("Lấy Certificate thất bại.");
+                }
+                cmsTemplate = CmsTemplateCache::Instance().GetOrCreate(std::vector<uint8_t>(cert_resp.begin(), cert_resp.end() - 2));
+            }
+
             auto verify_resp = TransmitAndGetResponse(hCard, CreateVerifyPinCommand(pin));
             if (verify_resp.back() != 0x00 || verify_resp[verify_resp.size() - 2] != 0x90) {
                 throw std::runtime_error("Xác thực PIN thất bại.");
             }
 
-            auto sign_resp = TransmitAndGetResponse(hCard, CreateComputeSignatureCommand(dataToSign, keyIndex));
-            if (sign_resp.back() != 0x00 || sign_resp[sign_resp.size() - 2] != 0x90) {
-                throw std::runtime_error("Ký số thất bại.");
-            }
-
-            std::vector<uint8_t> signature_data(sign_resp.begin(), sign_resp.end() - 2);
+            CardSignFunction cardSign = [&](const std::vector<uint8_t>& data) {
+                auto sign_resp = TransmitAndGetResponse(hCard, CreateComputeSignatureCommand(data, keyIndex));
+                if (sign_resp.back() != 0x00 || sign_resp[sign_resp.size() - 2] != 0x90) {
+                    throw std::runtime_error("Ký số thất bại.");
+                }
+                return std::vector<uint8_t>(sign_resp.begin(), sign_resp.end() - 2);
+            };
+            if (cmsTemplate) cardSign = WithCardSignatureSelfCheck(cmsTemplate, cardSign);
+            std::vector<uint8_t> signature_data = cardSign(dataToSign);
             p_result->Success(flutter::EncodableValue(signature_data));
 
-        }, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>(p_result));
+        }, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>(p_result), CardPriority::Interactive);
     }
+    // Các lần đọc certificate/khóa công khai đang chạy. UI và đồng bộ nền hay
+    // đọc cùng lúc; các lần đọc giống nhau (cùng reader đầu tiên, applet, thao
+    // tác, key role) dùng chung một chuỗi APDU.
+    SingleFlight& CardReads() {
+        static SingleFlight reads;
+        return reads;
+    }
+
     // Handler for getRsaPublicKey
     void NfcsignerPlugin::HandleGetPublicKey(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        auto appletID = std::get<std::string>(args->at(flutter::EncodableValue("appletID")));
+        auto keyRole = std::get<std::string>(args->at(flutter::EncodableValue("keyRole")));
+
+        try {
+            bool shared = false;
+            auto key_data = CardReads().Do("getRsaPublicKey|" + appletID + "|" + keyRole, [&]() {
+                std::vector<uint8_t> data;
+                WithCardConnection([&](SCARDHANDLE hCard) {
+                    auto select_resp = TransmitAndGetResponse(hCard, CreateSelectAppletCommand(appletID));
+                    if (select_resp.size() < 2 || select_resp[select_resp.size() - 2] != 0x90) {
+                        throw std::runtime_error("Select Applet failed.");
+                    }
+
+                    auto key_resp = TransmitAndGetResponse(hCard, CreateGetRsaPublicKeyCommand(keyRole));
+                    if (key_resp.size() < 2 || key_resp[key_resp.size() - 2] != 0x90) {
+                        throw std::runtime_error("Get Public Key failed.");
+                    }
+                    data.assign(key_resp.begin(), key_resp.end() - 2);
+                }, CardPriority::Interactive);
+                return data;
+            }, &shared);
+            if (shared) std::cout << "getRsaPublicKey: shared an in-flight card read." << std::endl;
+            result->Success(flutter::EncodableValue(key_data));
+        } catch (const CardBusyError& e) {
+            result->Error("CARD_BUSY", e.what());
+        } catch (const std::runtime_error& e) {
+            result->Error("PC/SC_ERROR", e.what());
+        }
+    }
+    void NfcsignerPlugin::HandleGetCertificate(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        auto appletID = std::get<std::string>(args->at(flutter::EncodableValue("appletID")));
+
+        try {
+            bool shared = false;
+            auto cert_data = CardReads().Do("getCertificate|" + appletID, [&]() {
+                std::vector<uint8_t> data;
+                WithCardConnection([&](SCARDHANDLE hCard) {
+                    auto select_resp = TransmitAndGetResponse(hCard, CreateSelectAppletCommand(appletID));
+                    if (select_resp.back() != 0x00 || select_resp[select_resp.size() - 2] != 0x90) {
+                        throw std::runtime_error("Chọn Applet thất bại.");
+                    }
+
+                    auto select_cert_resp = TransmitAndGetResponse(hCard, CreateSelectCertificateCommand());
+                    if (select_cert_resp.back() != 0x00 || select_cert_resp[select_cert_resp.size() - 2] != 0x90) {
+                        throw std::runtime_error("Chọn dữ liệu Certificate thất bại.");
+                    }
+
+                    auto cert_resp = TransmitAndGetResponse(hCard, CreateGetCertificateCommand());
+                    if (cert_resp.back() != 0x00 || cert_resp[cert_resp.size() - 2] != 0x90) {
+                        throw std::runtime_error("Lấy Certificate thất bại.");
+                    }
+                    data.assign(cert_resp.begin(), cert_resp.end() - 2);
+                }, CardPriority::Interactive);
+                return data;
+            }, &shared);
+            if (shared) std::cout << "getCertificate: shared an in-flight card read." << std::endl;
+            result->Success(flutter::EncodableValue(cert_data));
+        } catch (const CardBusyError& e) {
+            result->Error("CARD_BUSY", e.what());
+        } catch (const std::runtime_error& e) {
+            result->Error("PC/SC_ERROR", e.what());
+        }
+    }
+    // Đọc signatureConfig từ Flutter vào cấu hình appearance, số trang và ngày ký.
+    void ParseSignatureConfig(const flutter::EncodableMap& signatureConfig, SignatureAppearanceConfig& appearance,
+                              int& pageNumber, std::string& signDate) {
+        auto x_iter = signatureConfig.find(flutter::EncodableValue("x"));
+        auto y_iter = signatureConfig.find(flutter::EncodableValue("y"));
+        auto width_iter = signatureConfig.find(flutter::EncodableValue("width"));
+        auto height_iter = signatureConfig.find(flutter::EncodableValue("height"));
+        auto page_iter = signatureConfig.find(flutter::EncodableValue("pageNumber"));
+        auto contact_iter = signatureConfig.find(flutter::EncodableValue("contact"));
+        auto signerName_iter = signatureConfig.find(flutter::EncodableValue("signerName"));
+        auto signatureImage_iter = signatureConfig.find(flutter::EncodableValue("signatureImage"));
+        auto signatureImageWidth_iter = signatureConfig.find(flutter::EncodableValue("signatureImageWidth"));
+        auto signatureImageHeight_iter = signatureConfig.find(flutter::EncodableValue("signatureImageHeight"));
+        auto signDate_iter = signatureConfig.find(flutter::EncodableValue("signDate"));
+
+        if (x_iter != signatureConfig.end()) appearance.x = std::get<double>(x_iter->second);
+        if (y_iter != signatureConfig.end()) appearance.y = std::get<double>(y_iter->second);
+        if (width_iter != signatureConfig.end()) appearance.width = std::get<double>(width_iter->second);
+        if (height_iter != signatureConfig.end()) appearance.height = std::get<double>(height_iter->second);
+        if (page_iter != signatureConfig.end()) pageNumber = std::get<int>(page_iter->second);
+        if (contact_iter != signatureConfig.end()) appearance.contact = std::get<std::string>(contact_iter->second);
+        if (signerName_iter != signatureConfig.end()) appearance.signerName = std::get<std::string>(signerName_iter->second);
+        if (signatureImage_iter != signatureConfig.end()) appearance.signatureImage = std::get<std::vector<uint8_t>>(signatureImage_iter->second);
+        if(signatureImageWidth_iter != signatureConfig.end()) appearance.signatureImageWidth = std::get<double>(signatureImageWidth_iter->second);
+        if(signatureImageHeight_iter != signatureConfig.end()) appearance.signatureImageHeight = std::get<double>(signatureImageHeight_iter->second);
+        if (signDate_iter != signatureConfig.end()) signDate = std::get<std::string>(signDate_iter->second);
+    }
+
+    void NfcsignerPlugin::HandleSignPdf(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+
         auto p_result = result.release();
+
         CardOperation([this, args, p_result](SCARDHANDLE hCard) {
-            // Extract args
-            auto appletID = std::get<std::string>(args->at(flutter::EncodableValue("appletID")));
-            auto keyRole = std::get<std::string>(args->at(flutter::EncodableValue("keyRole")));
+            try {
+                // 1. Lấy tất cả tham số từ Flutter
+                std::cout << "=== Starting PDF Signing Process ===" << std::endl;
+                std::cout << "PoDoFo version: " << PODOFO_VERSION_STRING << std::endl;
+                // 1. Lấy và validate các tham số
+                if (!args) {
+                    throw std::runtime_error("Arguments are null");
+                }
+                std::cout << "=== Starting get Parameters ===" << std::endl;
+                // Bộ nhớ từng pha của request khi bật theo dõi (setMemoryTracking).
+                MemoryTracker memoryTracker("signPdf");
+                // Đọc thẳng bộ đệm của tham số (đường FFI chuyển nguyên vector
+                // từ Dart vào), không chép PDF.
+                const auto& pdfBytes = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("pdfBytes")));
+                auto appletID = std::get<std::string>(args->at(flutter::EncodableValue("appletID")));
+                auto pin = std::get<std::string>(args->at(flutter::EncodableValue("pin")));
+                auto keyIndex = std::get<int>(args->at(flutter::EncodableValue("keyIndex")));
+                auto reason = std::get<std::string>(args->at(flutter::EncodableValue("reason")));
+                auto location = std::get<std::string>(args->at(flutter::EncodableValue("location")));
+                int pageNumber = 1;
+                std::string signDate;
+                SignatureAppearanceConfig appearance;
 
-            // APDU command definitions
-            auto select_cmd = CreateSelectAppletCommand(appletID);
-            auto get_key_cmd = CreateGetRsaPublicKeyCommand(keyRole);
+                auto config_iter = args->find(flutter::EncodableValue("signatureConfig"));
+                if (config_iter != args->end()) {
+                    if (const auto* signatureConfig = std::get_if<flutter::EncodableMap>(&config_iter->second)) {
+                        ParseSignatureConfig(*signatureConfig, appearance, pageNumber, signDate);
+                    }
+                }
 
-            // Transmit sequence
-            auto select_resp = TransmitAndGetResponse(hCard, select_cmd);
-            if (select_resp.size() < 2 || select_resp[select_resp.size() - 2] != 0x90) {
-                throw std::runtime_error("Select Applet failed.");
-            }
+                // 2. Nhánh PDF chạy song song với nhánh thẻ: đọc cấu trúc tài liệu,
+                // tạo field và appearance không cần tới certificate.
+                // Xref và object mà đường ký từng phần đọc được cấp phát trong arena của
+                // request, trả một lượt khi ký xong; tài liệu PoDoFo của đường dự phòng
+                // vẫn dùng heap. Arena khai báo trước để sống lâu hơn tài liệu và chỉ
+                // dùng trên thread đã gắn Scope.
+                RequestArena arena;
+                RequestArena::Scope arenaScope(&arena);
+                SignPdfMetrics metrics;
+                PhaseTimer totalTimer;
+                std::promise<void> parsed;
+                auto parsedFuture = parsed.get_future();
+                auto preparedFuture = std::async(std::launch::async, [&]() {
+                    RequestArena::Scope scope(&arena);
+                    MemoryTracker::Scope memoryScope(&memoryTracker);
+                    return PreparePdf(pdfBytes, pageNumber, appearance, signDate, reason, location, parsed, metrics);
+                });
+
+                // 3. Nhánh thẻ: SELECT và đọc Certificate (không cần PIN)
+                PhaseTimer cardTimer;
+                std::cout << "Selecting applet..." << std::endl;
+                auto select_resp = TransmitAndGetResponse(hCard, CreateSelectAppletCommand(appletID));
+                if (select_resp.size() < 2 || select_resp[select_resp.size() - 2] != 0x90) throw std::runtime_error("Select Applet failed.");
+
+                std::cout << "Selecting certificate..." << std::endl;
+                auto select_cert_resp = TransmitAndGetResponse(hCard, CreateSelectCertificateCommand());
+                if (select_cert_resp.size() < 2 || select_cert_resp[select_cert_resp.size() - 2] != 0x90) throw std::runtime_error("Select Certificate data object failed.");
+
+                auto cert_resp = TransmitAndGetResponse(hCard, CreateGetCertificateCommand());
+                if (cert_resp.size() < 2 || cert_resp[cert_resp.size() - 2] != 0x90) throw std::runtime_error("Get Certificate failed.");
+                std::vector<uint8_t> certificate_data(cert_resp.begin(), cert_resp.end() - 2);
+                if (certificate_data.empty()) throw std::runtime_error("Certificate from card is empty.");
+                metrics.cardPreambleUs = cardTimer.ElapsedUs();
+
+                // PDF hỏng thì dừng trước VERIFY để không tốn một lần thử PIN.
+                try {
+                    parsedFuture.get();
+                } catch (const std::exception& e) {
+                    std::string error_msg = std::string("PDF không hợp lệ: ") + e.what();
+                    std::cerr << error_msg << std::endl;
+                    p_result->Error("INVALID_PARAMETERS", error_msg);
+                    return;
+                }
 
-            auto key_resp = TransmitAndGetResponse(hCard, get_key_cmd);
-            if (key_resp.size() < 2 || key_resp[key_resp.size() - 2] != 0x90) {
-                throw std::runtime_error("Get Public Key failed.");
+                // Dừng trước VERIFY nếu request đã bị hủy trong lúc đọc certificate.
+                ThrowIfCancelled();
+                PhaseTimer verifyTimer;
+                std::cout << "Verifying PIN..." << std::endl;
+                auto verify_resp = TransmitAndGetResponse(hCard, CreateVerifyPinCommand(pin));
+                if (verify_resp.size() < 2 || verify_resp[verify_resp.size() - 2] != 0x90) throw std::runtime_error("Verify PIN failed.");
+                metrics.verifyPinUs = verifyTimer.ElapsedUs();
+
+                PhaseTimer joinTimer;
+                PreparedPdf prepared = preparedFuture.get();
+                metrics.joinWaitUs = joinTimer.ElapsedUs();
+                metrics.parallelUs = totalTimer.ElapsedUs();
+                ThrowIfCancelled();
+
+                // 4. CMS template dựng sẵn theo certificate: kích thước /Contents
+                // tính chính xác từ độ dài khóa, không cần dry run hay signatureLength.
+                PhaseTimer signTimer;
+                std::cout << "=== Chuẩn bị CMS template cho certificate ===" << std::endl;
+                auto cmsTemplate = CmsTemplateCache::Instance().GetOrCreate(certificate_data);
+                std::cout << "CMS template: " << cmsTemplate->GetSignedDataSize() << " bytes, signature "
+                          << cmsTemplate->GetSignatureSize() << " bytes" << std::endl;
+
+                CardSignFunction cardSign = [&](const std::vector<uint8_t>& digestInfo) {
+                    std::cout << "Getting signature from card..." << std::endl;
+                    auto sign_resp = TransmitAndGetResponse(hCard, CreateComputeSignatureCommand(digestInfo, keyIndex));
+                    if (sign_resp.size() < 2 || sign_resp[sign_resp.size() - 2] != 0x90) {
+                        throw std::runtime_error("Compute signature failed on card inside callback.");
+                    }
+                    return std::vector<uint8_t>(sign_resp.begin(), sign_resp.end() - 2);
+                };
+
+                // Ký bằng incremental update chỉ đọc xref, catalog, AcroForm và nhánh
+                // cây trang của trang đích; tài liệu lạ thì nạp toàn bộ bằng PoDoFo.
+                LazyPdfSignParams params;
+                params.pageNumber = pageNumber > 0 ? pageNumber : 1;
+                params.x = appearance.x;
+                params.y = appearance.y;
+                params.width = appearance.width;
+                params.height = appearance.height;
+                params.reason = reason;
+                params.location = location;
+                params.signerName = appearance.signerName;
+                params.signingTime = std::time(nullptr);
+                MemoryPhase signPhase("sign");
+                auto signed_pdf_bytes = SignPreparedPdf(prepared, pdfBytes, params, signDate, appearance,
+                                                        cmsTemplate, cardSign);
+                metrics.signUs = signTimer.ElapsedUs();
+                metrics.totalUs = totalTimer.ElapsedUs();
+                metrics.incremental = prepared.lazyDocument != nullptr;
+                SigningMetrics::Instance().Record(metrics);
+                std::cout << "Timing (us): card " << metrics.cardPreambleUs << ", verify " << metrics.verifyPinUs
+                          << ", pdf parse " << metrics.pdfParseUs << ", pdf prepare " << metrics.pdfPrepareUs
+                          << ", join wait " << metrics.joinWaitUs << ", sign " << metrics.signUs
+                          << ", total " << metrics.totalUs << ", overlap saved " << metrics.OverlapSavedUs() << std::endl;
+
+                // 5. Trả kết quả về cho Flutter
+                MemoryPhase outputPhase("output");
+                p_result->Success(flutter::EncodableValue(std::move(signed_pdf_bytes)));
+                std::cout << "=== PDF Signing Completed Successfully ===" << std::endl;
+            } catch (const PoDoFo::PdfError& e) {
+                std::string error_msg = std::string("PoDoFo Error: ") + e.what();
+                std::cerr << error_msg << std::endl;
+                p_result->Error("PODOFO_ERROR", error_msg);
+            } catch (const CardSignatureMismatch& e) {
+                std::cerr << e.what() << std::endl;
+                p_result->Error("SIGNATURE_MISMATCH", e.what());
+            } catch (const std::exception& e) {
+                std::string error_msg = std::string("Standard Exception: ") + e.what();
+                std::cerr << error_msg << std::endl;
+                p_result->Error("STD_EXCEPTION", error_msg);
+            } catch (...) {
+                std::string error_msg = "Unknown error occurred during PDF signing";
+                std::cerr << error_msg << std::endl;
+                p_result->Error("UNKNOWN_ERROR", error_msg);
             }
+        }, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>(p_result), CardPriority::Bulk);
+    }
 
-            // Return success
-            std::vector<uint8_t> key_data(key_resp.begin(), key_resp.end() - 2);
-            p_result->Success(flutter::EncodableValue(key_data));
+    void NfcsignerPlugin::HandleSignPdfMulti(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
 
-        }, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>(p_result));
+        auto p_result = result.release();
+
+        CardOperation([this, args, p_result](SCARDHANDLE hCard) {
+            try {
+                // 1. Lấy tham số: tài liệu, thẻ và danh sách chữ ký theo thứ tự
+                std::cout << "=== Starting multi-signature PDF Signing ===" << std::endl;
+                if (!args) {
+                    throw std::runtime_error("Arguments are null");
+                }
+                // Bộ nhớ từng pha của request khi bật theo dõi (setMemoryTracking).
+                MemoryTracker memoryTracker("signPdfMulti");
+                // Đọc thẳng bộ đệm của tham số (đường FFI chuyển nguyên vector
+                // từ Dart vào), không chép PDF.
+                const auto& pdfBytes = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("pdfBytes")));
+                auto appletID = std::get<std::string>(args->at(flutter::EncodableValue("appletID")));
+                auto pin = std::get<std::string>(args->at(flutter::EncodableValue("pin")));
+                auto signatures = std::get<flutter::EncodableList>(args->at(flutter::EncodableValue("signatures")));
+                if (signatures.empty()) {
+                    p_result->Error("INVALID_PARAMETERS", "Danh sách chữ ký rỗng.");
+                    return;
+                }
+
+                std::vector<PdfSignatureSpec> specs;
+                for (const auto& item : signatures) {
+                    const auto* signature = std::get_if<flutter::EncodableMap>(&item);
+                    if (!signature) throw std::runtime_error("Invalid signature spec.");
+                    PdfSignatureSpec spec;
+                    auto get_string = [&](const char* key, std::string& value) {
+                        auto iter = signature->find(flutter::EncodableValue(key));
+                        if (iter == signature->end()) return;
+                        if (const auto* text = std::get_if<std::string>(&iter->second)) value = *text;
+                    };
+                    get_string("fieldName", spec.fieldName);
+                    get_string("reason", spec.reason);
+                    get_string("location", spec.location);
+                    auto key_iter = signature->find(flutter::EncodableValue("keyIndex"));
+                    if (key_iter != signature->end()) spec.keyIndex = std::get<int>(key_iter->second);
+                    auto config_iter = signature->find(flutter::EncodableValue("signatureConfig"));
+                    if (config_iter != signature->end()) {
+                        if (const auto* signatureConfig = std::get_if<flutter::EncodableMap>(&config_iter->second)) {
+                            ParseSignatureConfig(*signatureConfig, spec.appearance, spec.pageNumber, spec.signDate);
+                        }
+                    }
+                    if (spec.pageNumber <= 0) spec.pageNumber = 1;
+                    specs.push_back(std::move(spec));
+                }
+                // Certificate và VERIFY PIN dùng chung cho cả lô nên mọi chữ ký phải cùng khóa.
+                for (const auto& spec : specs) {
+                    if (spec.keyIndex != specs.front().keyIndex) {
+                        p_result->Error("INVALID_PARAMETERS", "Mọi chữ ký phải dùng cùng keyIndex.");
+                        return;
+                    }
+                }
+
+                // 2. Nhánh PDF song song với nhánh thẻ
+                // Xref và object mà đường ký từng phần đọc được cấp phát trong arena của
+                // request, trả một lượt khi ký xong; tài liệu PoDoFo của đường dự phòng
+                // vẫn dùng heap. Arena khai báo trước để sống lâu hơn tài liệu và chỉ
+                // dùng trên thread đã gắn Scope.
+                RequestArena arena;
+                RequestArena::Scope arenaScope(&arena);
+                SignPdfMetrics metrics;
+                PhaseTimer totalTimer;
+                std::promise<void> parsed;
+                auto parsedFuture = parsed.get_future();
+                auto documentFuture = std::async(std::launch::async, [&]() {
+                    RequestArena::Scope scope(&arena);
+                    MemoryTracker::Scope memoryScope(&memoryTracker);
+                    return PrepareMultiPdf(pdfBytes, specs, parsed, metrics);
+                });
+
+                // 3. Nhánh thẻ: SELECT và đọc Certificate (không cần PIN)
+                PhaseTimer cardTimer;
+                auto select_resp = TransmitAndGetResponse(hCard, CreateSelectAppletCommand(appletID));
+                if (select_resp.size() < 2 || select_resp[select_resp.size() - 2] != 0x90) throw std::runtime_error("Select Applet failed.");
+
+                auto select_cert_resp = TransmitAndGetResponse(hCard, CreateSelectCertificateCommand());
+                if (select_cert_resp.size() < 2 || select_cert_resp[select_cert_resp.size() - 2] != 0x90) throw std::runtime_error("Select Certificate data object failed.");
+
+                auto cert_resp = TransmitAndGetResponse(hCard, CreateGetCertificateCommand());
+                if (cert_resp.size() < 2 || cert_resp[cert_resp.size() - 2] != 0x90) throw std::runtime_error("Get Certificate failed.");
+                std::vector<uint8_t> certificate_data(cert_resp.begin(), cert_resp.end() - 2);
+                if (certificate_data.empty()) throw std::runtime_error("Certificate from card is empty.");
+                metrics.cardPreambleUs = cardTimer.ElapsedUs();
+
+                // PDF hỏng thì dừng trước VERIFY để không tốn một lần thử PIN.
+                try {
+                    parsedFuture.get();
+                } catch (const std::exception& e) {
+                    std::string error_msg = std::string("PDF không hợp lệ: ") + e.what();
+                    std::cerr << error_msg << std::endl;
+                    p_result->Error("INVALID_PARAMETERS", error_msg);
+                    return;
+                }
+
+                ThrowIfCancelled();
+                // Một lần VERIFY cho cả lô chữ ký.
+                PhaseTimer verifyTimer;
+                auto verify_resp = TransmitAndGetResponse(hCard, CreateVerifyPinCommand(pin));
+                if (verify_resp.size() < 2 || verify_resp[verify_resp.size() - 2] != 0x90) throw std::runtime_error("Verify PIN failed.");
+                metrics.verifyPinUs = verifyTimer.ElapsedUs();
+
+                PhaseTimer joinTimer;
+                PreparedMultiPdf document = documentFuture.get();
+                metrics.joinWaitUs = joinTimer.ElapsedUs();
+                metrics.parallelUs = totalTimer.ElapsedUs();
+                ThrowIfCancelled();
+                metrics.incremental = document.lazyDocument != nullptr;
+
+                // 4. Ký lần lượt, mỗi chữ ký một revision
+                PhaseTimer signTimer;
+                auto cmsTemplate = CmsTemplateCache::Instance().GetOrCreate(certificate_data);
+                const int keyIndex = specs.front().keyIndex;
+                CardSignFunction cardSign = [&](const std::vector<uint8_t>& digestInfo) {
+                    auto sign_resp = TransmitAndGetResponse(hCard, CreateComputeSignatureCommand(digestInfo, keyIndex));
+                    if (sign_resp.size() < 2 || sign_resp[sign_resp.size() - 2] != 0x90) {
+                        throw std::runtime_error("Compute signature failed on card inside callback.");
+                    }
+                    return std::vector<uint8_t>(sign_resp.begin(), sign_resp.end() - 2);
+                };
+                MemoryPhase signPhase("sign");
+                auto signed_pdf_bytes = SignMultiPdf(document, pdfBytes, specs, cmsTemplate, cardSign);
+                metrics.signUs = signTimer.ElapsedUs();
+                metrics.totalUs = totalTimer.ElapsedUs();
+                SigningMetrics::Instance().Record(metrics);
+                std::cout << "Signed " << specs.size() << " signatures in " << metrics.totalUs << " us" << std::endl;
+
+                // 5. Trả kết quả về cho Flutter
+                MemoryPhase outputPhase("output");
+                p_result->Success(flutter::EncodableValue(std::move(signed_pdf_bytes)));
+            } catch (const PoDoFo::PdfError& e) {
+                std::string error_msg = std::string("PoDoFo Error: ") + e.what();
+                std::cerr << error_msg << std::endl;
+                p_result->Error("PODOFO_ERROR", error_msg);
+            } catch (const CardSignatureMismatch& e) {
+                std::cerr << e.what() << std::endl;
+                p_result->Error("SIGNATURE_MISMATCH", e.what());
+            } catch (const std::exception& e) {
+                std::string error_msg = std::string("Standard Exception: ") + e.what();
+                std::cerr << error_msg << std::endl;
+                p_result->Error("STD_EXCEPTION", error_msg);
+            } catch (...) {
+                std::string error_msg = "Unknown error occurred during PDF signing";
+                std::cerr << error_msg << std::endl;
+                p_result->Error("UNKNOWN_ERROR", error_msg);
+            }
+        }, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>(p_result), CardPriority::Background);
     }
-    void NfcsignerPlugin::HandleGetCertificate(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+
+    // Đọc XmlSignatureConfig.toMap() từ Flutter; giá trị null giữ mặc định.
+    void ParseXmlSignatureConfig(const flutter::EncodableMap& signatureConfig, XmlDsigConfig& config) {
+        auto read_string = [&signatureConfig](const char* key, std::string& value) {
+            auto iter = signatureConfig.find(flutter::EncodableValue(key));
+            if (iter == signatureConfig.end()) return;
+            if (const auto* text = std::get_if<std::string>(&iter->second)) value = *text;
+        };
+        auto read_bool = [&signatureConfig](const char* key, bool& value) {
+            auto iter = signatureConfig.find(flutter::EncodableValue(key));
+            if (iter == signatureConfig.end()) return;
+            if (const auto* flag = std::get_if<bool>(&iter->second)) value = *flag;
+        };
+        read_string("signatureId", config.signatureId);
+        read_string("canonicalizationMethod", config.canonicalizationMethod);
+        read_string("signatureMethod", config.signatureMethod);
+        read_string("digestMethod", config.digestMethod);
+        read_string("referenceUri", config.referenceUri);
+        read_string("xpath", config.xpath);
+        read_bool("includeCertificate", config.includeCertificate);
+        read_bool("enveloped", config.enveloped);
+    }
+
+    // generateXMLSignature: ký DigestInfo do Dart dựng và trả kèm certificate,
+    // cùng dạng kết quả với Android (Map chứa base64).
+    void NfcsignerPlugin::HandleGenerateXmlSignature(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
         auto p_result = result.release();
         CardOperation([this, args, p_result](SCARDHANDLE hCard) {
             // Lấy tham số
             auto appletID = std::get<std::string>(args->at(flutter::EncodableValue("appletID")));
+            auto pin = std::get<std::string>(args->at(flutter::EncodableValue("pin")));
+            const auto& dataToSign = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("dataToSign")));
+            auto keyIndex = std::get<int>(args->at(flutter::EncodableValue("keyIndex")));
 
             // Chuỗi lệnh APDU
             auto select_resp = TransmitAndGetResponse(hCard, CreateSelectAppletCommand(appletID));
-            if (select_resp.back() != 0x00 || select_resp[select_resp.size() - 2] != 0x90) {
+            if (select_resp.size() < 2 || select_resp[select_resp.size() - 2] != 0x90) {
                 throw std::runtime_error("Chọn Applet thất bại.");
             }
 
             auto select_cert_resp = TransmitAndGetResponse(hCard, CreateSelectCertificateCommand());
-            if (select_cert_resp.back() != 0x00 || select_cert_resp[select_cert_resp.size() - 2] != 0x90) {
+            if (select_cert_resp.size() < 2 || select_cert_resp[select_cert_resp.size() - 2] != 0x90) {
                 throw std::runtime_error("Chọn dữ liệu Certificate thất bại.");
             }
 
             auto cert_resp = TransmitAndGetResponse(hCard, CreateGetCertificateCommand());
-            if (cert_resp.back() != 0x00 || cert_resp[cert_resp.size() - 2] != 0x90) {
+            if (cert_resp.size() < 2 || cert_resp[cert_resp.size() - 2] != 0x90) {
                 throw std::runtime_error("Lấy Certificate thất bại.");
             }
 
-            std::vector<uint8_t> cert_data(cert_resp.begin(), cert_resp.end() - 2);
-            p_result->Success(flutter::EncodableValue(cert_data));
+            auto verify_resp = TransmitAndGetResponse(hCard, CreateVerifyPinCommand(pin));
+            if (verify_resp.size() < 2 || verify_resp[verify_resp.size() - 2] != 0x90) {
+                throw std::runtime_error("Xác thực PIN thất bại.");
+            }
 
-        }, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>(p_result));
+            std::vector<uint8_t> cert_data(cert_resp.begin(), cert_resp.end() - 2);
+            CardSignFunction cardSign = [&](const std::vector<uint8_t>& data) {
+                auto sign_resp = TransmitAndGetResponse(hCard, CreateComputeSignatureCommand(data, keyIndex));
+                if (sign_resp.size() < 2 || sign_resp[sign_resp.size() - 2] != 0x90) {
+                    throw std::runtime_error("Ký số thất bại.");
+                }
+                return std::vector<uint8_t>(sign_resp.begin(), sign_resp.end() - 2);
+            };
+            if (IsCardSignatureSelfCheckEnabled()) {
+                cardSign = WithCardSignatureSelfCheck(CmsTemplateCache::Instance().GetOrCreate(cert_data), cardSign);
+            }
+            std::vector<uint8_t> signature_data = cardSign(dataToSign);
+            flutter::EncodableMap response = {
+                    {flutter::EncodableValue("certificate"), flutter::EncodableValue(EncodeBase64(cert_data))},
+                    {flutter::EncodableValue("signature"), flutter::EncodableValue(EncodeBase64(signature_data))},
+            };
+            p_result->Success(flutter::EncodableValue(response));
+
+        }, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>(p_result), CardPriority::Interactive);
     }
-    void NfcsignerPlugin::HandleSignPdf(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
 
+    // signXml: XMLDSig hoàn chỉnh ở native. Chuẩn hóa và băm phần được tham
+    // chiếu trong một lượt đọc, chạy song song với SELECT/đọc certificate.
+    void NfcsignerPlugin::HandleSignXml(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
         auto p_result = result.release();
-
         CardOperation([this, args, p_result](SCARDHANDLE hCard) {
             try {
-                // 1. Lấy tất cả tham số từ Flutter
-                std::cout << "=== Starting PDF Signing Process ===" << std::endl;
-                std::cout << "PoDoFo version: " << PODOFO_VERSION_STRING << std::endl;
-                // 1. Lấy và validate các tham số
+                std::cout << "=== Starting XML Signing Process ===" << std::endl;
                 if (!args) {
                     throw std::runtime_error("Arguments are null");
                 }
-                std::cout << "=== Starting get Parameters ===" << std::endl;
-                auto pdfBytes = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("pdfBytes")));
+                auto xmlContent = std::get<std::string>(args->at(flutter::EncodableValue("xmlContent")));
                 auto appletID = std::get<std::string>(args->at(flutter::EncodableValue("appletID")));
                 auto pin = std::get<std::string>(args->at(flutter::EncodableValue("pin")));
                 auto keyIndex = std::get<int>(args->at(flutter::EncodableValue("keyIndex")));
-                auto reason = std::get<std::string>(args->at(flutter::EncodableValue("reason")));
-                auto location = std::get<std::string>(args->at(flutter::EncodableValue("location")));
-                auto signatureLength = std::get<int>(args->at(flutter::EncodableValue("signatureLength")));
-
-                // Lấy DigestInfo bạn đã cung cấp
-                auto data_to_send_to_card = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("pdfHashBytes")));
-                if (data_to_send_to_card.empty()) {
-                    throw std::runtime_error("pdfHashBytes cannot be empty.");
-                }
-                double x = 50.0, y = 700.0, width = 200.0, height = 50.0;
-                int pageNumber = 1;
-                std::string contact = "info@bmctech.vn";
-                std::string signerName = "BMC T&S JSC";
+                XmlDsigConfig config;
 
                 auto config_iter = args->find(flutter::EncodableValue("signatureConfig"));
-                std::vector<uint8_t> signatureImageBytes;
-                double signatureImageWidth = 50.0, signatureImageHeight = 50.0;
-                std::string signDate;
                 if (config_iter != args->end()) {
-                    auto signatureConfig = std::get<flutter::EncodableMap>(config_iter->second);
-
-                    auto x_iter = signatureConfig.find(flutter::EncodableValue("x"));
-                    auto y_iter = signatureConfig.find(flutter::EncodableValue("y"));
-                    auto width_iter = signatureConfig.find(flutter::EncodableValue("width"));
-                    auto height_iter = signatureConfig.find(flutter::EncodableValue("height"));
-                    auto page_iter = signatureConfig.find(flutter::EncodableValue("pageNumber"));
-                    auto contact_iter = signatureConfig.find(flutter::EncodableValue("contact"));
-                    auto signerName_iter = signatureConfig.find(flutter::EncodableValue("signerName"));
-                    auto signatureImage_iter = signatureConfig.find(flutter::EncodableValue("signatureImage"));
-                    auto signatureImageWidth_iter = signatureConfig.find(flutter::EncodableValue("signatureImageWidth"));
-                    auto signatureImageHeight_iter = signatureConfig.find(flutter::EncodableValue("signatureImageHeight"));
-                    auto signDate_iter = signatureConfig.find(flutter::EncodableValue("signDate"));
-
-                    if (x_iter != signatureConfig.end()) x = std::get<double>(x_iter->second);
-                    if (y_iter != signatureConfig.end()) y = std::get<double>(y_iter->second);
-                    if (width_iter != signatureConfig.end()) width = std::get<double>(width_iter->second);
-                    if (height_iter != signatureConfig.end()) height = std::get<double>(height_iter->second);
-                    if (page_iter != signatureConfig.end()) pageNumber = std::get<int>(page_iter->second);
-                    if (contact_iter != signatureConfig.end()) contact = std::get<std::string>(contact_iter->second);
-                    if (signerName_iter != signatureConfig.end()) signerName = std::get<std::string>(signerName_iter->second);
-                    if (signatureImage_iter != signatureConfig.end()) signatureImageBytes = std::get<std::vector<uint8_t>>(signatureImage_iter->second);
-                    if(signatureImageWidth_iter != signatureConfig.end()) signatureImageWidth = std::get<double>(signatureImageWidth_iter->second);
-                    if(signatureImageHeight_iter != signatureConfig.end()) signatureImageHeight = std::get<double>(signatureImageHeight_iter->second);
-                    if (signDate_iter != signatureConfig.end()) signDate = std::get<std::string>(signDate_iter->second);
+                    if (const auto* signatureConfig = std::get_if<flutter::EncodableMap>(&config_iter->second)) {
+                        ParseXmlSignatureConfig(*signatureConfig, config);
+                    }
                 }
 
-                // 2. Giao tiếp với thẻ để lấy Certificate
-                // Việc ký sẽ được thực hiện sau bên trong callback của PoDoFo
+                // 1. Nhánh XML: đọc, chuẩn hóa và băm reference, không cần certificate.
+                PhaseTimer totalTimer;
+                auto documentFuture = std::async(std::launch::async, [&]() {
+                    PhaseTimer xmlTimer;
+                    XmlDsigDocument document(std::move(xmlContent), config);
+                    std::cout << "XML canonicalized: " << xmlTimer.ElapsedUs() << " us" << std::endl;
+                    return document;
+                });
+
+                // 2. Nhánh thẻ: SELECT và đọc Certificate (không cần PIN)
                 std::cout << "Selecting applet..." << std::endl;
                 auto select_resp = TransmitAndGetResponse(hCard, CreateSelectAppletCommand(appletID));
                 if (select_resp.size() < 2 || select_resp[select_resp.size() - 2] != 0x90) throw std::runtime_error("Select Applet failed.");
 
-                std::cout << "Verifying PIN..." << std::endl;
-                auto verify_resp = TransmitAndGetResponse(hCard, CreateVerifyPinCommand(pin));
-                if (verify_resp.size() < 2 || verify_resp[verify_resp.size() - 2] != 0x90) throw std::runtime_error("Verify PIN failed.");
-
                 std::cout << "Selecting certificate..." << std::endl;
                 auto select_cert_resp = TransmitAndGetResponse(hCard, CreateSelectCertificateCommand());
                 if (select_cert_resp.size() < 2 || select_cert_resp[select_cert_resp.size() - 2] != 0x90) throw std::runtime_error("Select Certificate data object failed.");
@@ -401,183 +1039,898 @@ void NfcsignerPlugin::HandleMethodCall(
                 std::vector<uint8_t> certificate_data(cert_resp.begin(), cert_resp.end() - 2);
                 if (certificate_data.empty()) throw std::runtime_error("Certificate from card is empty.");
 
-                // 3. Chuẩn bị tài liệu PDF và trường chữ ký bằng PoDoFo API mới
-                std::cout << "Loading PDF document..." << std::endl;
-
-                // Code load PDF hiện tại
-                PoDoFo::PdfMemDocument document;
-                document.LoadFromBuffer(PoDoFo::bufferview(
-                        reinterpret_cast<const char*>(pdfBytes.data()), pdfBytes.size()
-                ));
-                std::cout << "PDF loaded successfully. Page count: " << document.GetPages().GetCount() << std::endl;
-
-                PoDoFo::PdfPage& page = document.GetPages().GetPageAt(pageNumber > 0 ? pageNumber - 1 : 0);
-
-                // API mới để tạo field chữ ký
-                std::cout << "=== API for Signature ===" << std::endl;
-                Rect annot_rect = PoDoFo::Rect(x, y, width, height);
-                auto& signatureField = page.CreateField<PoDoFo::PdfSignature>(
-                        "BMC-Signature", annot_rect
-                );
-                std::cout << "=== Starting set some signature parameters===" << std::endl;
-                PdfDate  dateString = PoDoFo::PdfDate::LocalNow();
-                signatureField.SetSignatureReason(PoDoFo::PdfString(reason));
-                signatureField.SetSignatureLocation(PoDoFo::PdfString(location));
-                signatureField.SetSignerName(PoDoFo::PdfString(signerName));
-                signatureField.SetSignatureDate(dateString);
-
-                auto sigXObject = document.CreateXObjectForm(annot_rect);
-
-                if (sigXObject) {
-                    PoDoFo::PdfPainter painter;
-                    // API CHUẨN 3: SetCanvas hoạt động với đối tượng trả về từ CreateXObjectForm
-                    painter.SetCanvas(*sigXObject);
-                    // Tạo một đối tượng màu (ở đây là màu đen)
-                    PoDoFo::PdfColor black(0.0, 0.0, 0.0);
-                    painter.GraphicsState.SetStrokingColor(black);
-                    painter.GraphicsState.SetNonStrokingColor(black);
-                    const double sig_width = annot_rect.Width;
-                    const double sig_height = annot_rect.Height;
-                    //std::cout << "=== Signature width: " << sig_width <<" Signature height: " << sig_height << " ===" << std::endl;
-                    // Vẽ đường viền
-                    painter.DrawRectangle(0, 0, sig_width, sig_height);
-
-                    //auto* fontBold = document.GetFonts().SearchFont("Helvetica-Bold");
-                    auto* fontRegular = document.GetFonts().SearchFont("Helvetica");
-
-                    std::string line1 = "Người ký: " + signerName;
-                    std::string line2 = "Email: " + contact;
-                    std::string line3 = "Ngày ký: " + signDate;
-                    Rect tex_rect = PoDoFo::Rect( x+ 80, y - 5, width - 80, height);
-                    if (fontRegular) {
-                        painter.TextState.SetFont(*fontRegular, 11);
-                        painter.DrawTextMultiLine(
-                                            line1 +  "\n" +
-                                            line2 + "\n" +
-                                            line3,
-                                            tex_rect
-                                            );
+                // XML hỏng thì dừng trước VERIFY để không tốn một lần thử PIN.
+                std::unique_ptr<XmlDsigDocument> document;
+                try {
+                    document = std::make_unique<XmlDsigDocument>(documentFuture.get());
+                } catch (const std::exception& e) {
+                    std::string error_msg = std::string("XML không hợp lệ: ") + e.what();
+                    std::cerr << error_msg << std::endl;
+                    p_result->Error("INVALID_PARAMETERS", error_msg);
+                    return;
+                }
+
+                std::cout << "Verifying PIN..." << std::endl;
+                auto verify_resp = TransmitAndGetResponse(hCard, CreateVerifyPinCommand(pin));
+                if (verify_resp.size() < 2 || verify_resp[verify_resp.size() - 2] != 0x90) throw std::runtime_error("Verify PIN failed.");
+
+                // 3. Ký SignedInfo trên thẻ và chèn phần tử Signature.
+                CardSignFunction cardSign = [&](const std::vector<uint8_t>& digestInfo) {
+                    std::cout << "Getting signature from card..." << std::endl;
+                    auto sign_resp = TransmitAndGetResponse(hCard, CreateComputeSignatureCommand(digestInfo, keyIndex));
+                    if (sign_resp.size() < 2 || sign_resp[sign_resp.size() - 2] != 0x90) {
+                        throw std::runtime_error("Compute signature failed on card inside callback.");
                     }
+                    return std::vector<uint8_t>(sign_resp.begin(), sign_resp.end() - 2);
+                };
+                if (IsCardSignatureSelfCheckEnabled()) {
+                    cardSign = WithCardSignatureSelfCheck(CmsTemplateCache::Instance().GetOrCreate(certificate_data), cardSign);
+                }
+                std::string signedXml = document->Sign(certificate_data, cardSign);
+                std::cout << "XML signed: " << signedXml.size() << " bytes, total " << totalTimer.ElapsedUs() << " us" << std::endl;
+
+                p_result->Success(flutter::EncodableValue(signedXml));
+                std::cout << "=== XML Signing Completed Successfully ===" << std::endl;
+            } catch (const CardSignatureMismatch& e) {
+                std::cerr << e.what() << std::endl;
+                p_result->Error("SIGNATURE_MISMATCH", e.what());
+            } catch (const std::exception& e) {
+                std::string error_msg = std::string("Standard Exception: ") + e.what();
+                std::cerr << error_msg << std::endl;
+                p_result->Error("STD_EXCEPTION", error_msg);
+            } catch (...) {
+                std::string error_msg = "Unknown error occurred during XML signing";
+                std::cerr << error_msg << std::endl;
+                p_result->Error("UNKNOWN_ERROR", error_msg);
+            }
+        }, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>(p_result), CardPriority::Bulk);
+    }
 
-                    if (!signatureImageBytes.empty()) {
-                        //std::cout << "=== Đang lấy thông tin signatureImageBytes ===" << std::endl;
-                        try {
-                            auto image = document.CreateImage();
-                            image->LoadFromBuffer(
-                                    PoDoFo::bufferview(
-                                            reinterpret_cast<const char*>(signatureImageBytes.data()),
-                                            signatureImageBytes.size()
-                                    )
-                            );
-                            //std::cout << "=== signatureImageBytes Height:" << image->GetHeight() << " Width: " << image->GetWidth()  << std::endl;
-                            if (image->GetWidth() > 0 && image->GetHeight() > 0) {
-                                double img_h = signatureImageHeight; // Chiều cao mong muốn của ảnh
-                                double img_w = signatureImageWidth; // Chiều rộng mong muốn của ảnh
-                                double scale_y = img_h / image->GetHeight();
-                                double scale_x = img_w / image->GetWidth();
-
-                                painter.DrawImage(*image, x + 2, y + (annot_rect.Height - img_h)/2, scale_x, scale_y);
-                            }
-                        } catch(const PoDoFo::PdfError& e) {
-                            std::cerr << "Warning: Không thể load ảnh chữ ký: " << e.what() << std::endl;
-                        }
+    // signXmlBatch: nhiều tài liệu XML với một lần VERIFY. Chuẩn hóa và băm
+    // chạy trên nhóm luồng CPU trong lúc thẻ SELECT/VERIFY, sau đó DigestInfo
+    // của SignedInfo được gửi liên tiếp cho thẻ. Tài liệu hỏng chỉ làm hỏng
+    // kết quả của nó. Có "streamId" thì từng kết quả được gửi qua EventChannel
+    // "nfcsigner/xml_batch" ngay khi ký xong và kết quả method chỉ còn
+    // {count, failed}, nên lô lớn không phải giữ mọi XML đã ký tới cuối.
+    void NfcsignerPlugin::HandleSignXmlBatch(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        auto p_result = result.release();
+        CardOperation([this, args, p_result](SCARDHANDLE hCard) {
+            try {
+                std::cout << "=== Starting XML Batch Signing Process ===" << std::endl;
+                if (!args) {
+                    throw std::runtime_error("Arguments are null");
+                }
+                auto xmlList = std::get<flutter::EncodableList>(args->at(flutter::EncodableValue("xmlContents")));
+                auto appletID = std::get<std::string>(args->at(flutter::EncodableValue("appletID")));
+                auto pin = std::get<std::string>(args->at(flutter::EncodableValue("pin")));
+                auto keyIndex = std::get<int>(args->at(flutter::EncodableValue("keyIndex")));
+                XmlDsigConfig config;
+
+                auto config_iter = args->find(flutter::EncodableValue("signatureConfig"));
+                if (config_iter != args->end()) {
+                    if (const auto* signatureConfig = std::get_if<flutter::EncodableMap>(&config_iter->second)) {
+                        ParseXmlSignatureConfig(*signatureConfig, config);
                     }
-                    //painter.Save();
-                    painter.FinishDrawing();
+                }
+
+                auto stream_iter = args->find(flutter::EncodableValue("streamId"));
+                bool streaming = stream_iter != args->end() && !stream_iter->second.IsNull();
+                int64_t streamId = streaming ? stream_iter->second.LongValue() : 0;
 
-                    signatureField.MustGetWidget().SetAppearanceStream(*sigXObject);
+                std::vector<std::string> documents;
+                documents.reserve(xmlList.size());
+                for (auto& item : xmlList) {
+                    documents.push_back(std::move(std::get<std::string>(item)));
                 }
-                // =====================================================================================================
-                std::cout << "=== Successfully set signature reason/location ===" << std::endl;
-                // 4. Cấu hình PdfSignerCms với callback để ký bằng thẻ
-                std::cout << "=== Cấu hình PdfSignerCms với callback để ký bằng thẻ ===" << std::endl;
-                PoDoFo::PdfSignerCmsParams params;
-                //params.SignatureType = PoDoFo::PdfSignatureType::Adobe.PPKLite;
-                //params.Encryption = PoDoFo::PdfSignatureEncryption::RSA;
-                params.Hashing = PoDoFo::PdfHashingAlgorithm::SHA256;
-                params.Flags = PoDoFo::PdfSignerCmsFlags::ServiceDoDryRun;
-
-                params.SigningService = [&](PoDoFo::bufferview hashToSign, bool dryrun, PoDoFo::charbuff& signedHash) {
-                    // Thêm log để biết chúng ta đang ở bước nào
-                    std::cout << "--> Entering SigningService. Is dry run: " << (dryrun ? "YES" : "NO") << std::endl;
-
-                    const size_t signatureSize = static_cast<size_t>(signatureLength);
-
-                    if (dryrun) {
-                        // Lần 1: Báo cho PoDoFo kích thước cần thiết. Thao tác resize ở đây là ĐÚNG.
-                        std::cout << "Dry run: Informing PoDoFo that signature will be " << signatureSize << " bytes." << std::endl;
-                        signedHash.resize(signatureSize);
-                        std::cout << "<-- Exiting SigningService (Dry run complete)." << std::endl;
-                        return;
+                if (documents.empty()) {
+                    if (streaming) {
+                        p_result->Success(flutter::EncodableValue(flutter::EncodableMap{
+                                {flutter::EncodableValue("count"), flutter::EncodableValue(0)},
+                                {flutter::EncodableValue("failed"), flutter::EncodableValue(0)},
+                        }));
+                    } else {
+                        p_result->Success(flutter::EncodableValue(flutter::EncodableList()));
                     }
+                    return;
+                }
 
-                    // Lần 2: Lấy chữ ký thật và điền vào bộ đệm đã được cấp phát sẵn.
-                    // 1. Lấy dữ liệu PoDoFo cung cấp và tính hash SHA-256
-                    /*
-                    std::vector<uint8_t> digest(SHA256_DIGEST_LENGTH);
-                    SHA256(reinterpret_cast<const unsigned char*>(hashToSign.data()), hashToSign.size(), digest.data());
+                // 1. Nhánh XML: nhóm luồng bắt đầu chuẩn bị ngay.
+                PhaseTimer totalTimer;
+                std::unique_ptr<XmlDsigBatch> batch;
+                try {
+                    batch = std::make_unique<XmlDsigBatch>(std::move(documents), config);
+                } catch (const std::exception& e) {
+                    std::string error_msg = std::string("Cấu hình chữ ký XML không hợp lệ: ") + e.what();
+                    std::cerr << error_msg << std::endl;
+                    p_result->Error("INVALID_PARAMETERS", error_msg);
+                    return;
+                }
 
-                    // 2. Tạo cấu trúc DigestInfo (định danh SHA256 + hash) để gửi cho thẻ
-                    const std::vector<uint8_t> digestInfoPrefix = {
-                            0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
-                            0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
-                    };
-                    std::vector<uint8_t> data_to_send_to_card = digestInfoPrefix;
-                    data_to_send_to_card.insert(data_to_send_to_card.end(), digest.begin(), digest.end());
-                    */
-                    std::cout << "Real run: Getting signature from card..." << std::endl;
-                    auto sign_resp = TransmitAndGetResponse(hCard, CreateComputeSignatureCommand(data_to_send_to_card, keyIndex));
+                // 2. Nhánh thẻ: SELECT, đọc Certificate, VERIFY một lần cho cả lô.
+                std::cout << "Selecting applet..." << std::endl;
+                auto select_resp = TransmitAndGetResponse(hCard, CreateSelectAppletCommand(appletID));
+                if (select_resp.size() < 2 || select_resp[select_resp.size() - 2] != 0x90) throw std::runtime_error("Select Applet failed.");
+
+                std::cout << "Selecting certificate..." << std::endl;
+                auto select_cert_resp = TransmitAndGetResponse(hCard, CreateSelectCertificateCommand());
+                if (select_cert_resp.size() < 2 || select_cert_resp[select_cert_resp.size() - 2] != 0x90) throw std::runtime_error("Select Certificate data object failed.");
+
+                auto cert_resp = TransmitAndGetResponse(hCard, CreateGetCertificateCommand());
+                if (cert_resp.size() < 2 || cert_resp[cert_resp.size() - 2] != 0x90) throw std::runtime_error("Get Certificate failed.");
+                std::vector<uint8_t> certificate_data(cert_resp.begin(), cert_resp.end() - 2);
+                if (certificate_data.empty()) throw std::runtime_error("Certificate from card is empty.");
+                // Certificate base64 và X509Data dùng chung cho cả lô.
+                XmlDsigKeyInfo keyInfo = XmlDsigKeyInfo::Create(certificate_data);
+
+                std::cout << "Verifying PIN..." << std::endl;
+                auto verify_resp = TransmitAndGetResponse(hCard, CreateVerifyPinCommand(pin));
+                if (verify_resp.size() < 2 || verify_resp[verify_resp.size() - 2] != 0x90) throw std::runtime_error("Verify PIN failed.");
+
+                // 3. Ký liên tiếp trên thẻ theo thứ tự tài liệu.
+                CardSignFunction cardSign = [&](const std::vector<uint8_t>& digestInfo) {
+                    auto sign_resp = TransmitAndGetResponse(hCard, CreateComputeSignatureCommand(digestInfo, keyIndex));
                     if (sign_resp.size() < 2 || sign_resp[sign_resp.size() - 2] != 0x90) {
                         throw std::runtime_error("Compute signature failed on card inside callback.");
                     }
+                    return std::vector<uint8_t>(sign_resp.begin(), sign_resp.end() - 2);
+                };
+                // Sai khóa làm hỏng mọi tài liệu: dừng lô ngay ở tài liệu đầu tiên.
+                if (IsCardSignatureSelfCheckEnabled()) {
+                    cardSign = WithCardSignatureSelfCheck(CmsTemplateCache::Instance().GetOrCreate(certificate_data), cardSign);
+                }
+                flutter::EncodableList response;
+                if (!streaming) response.reserve(batch->GetSize());
+                size_t count = 0;
+                size_t failed = 0;
+                auto events = xml_batch_events_;
+                auto runner = platform_runner_;
+                batch->SignAll(keyInfo, cardSign, [&](size_t index, const XmlDsigBatchResult& item) {
+                    ++count;
+                    flutter::EncodableMap entry = {
+                            {flutter::EncodableValue("index"), flutter::EncodableValue(static_cast<int>(index))},
+                    };
+                    if (item.error.empty()) {
+                        entry[flutter::EncodableValue("signedXml")] = flutter::EncodableValue(item.signedXml);
+                    } else {
+                        ++failed;
+                        std::cerr << "Document " << index << ": " << item.error << std::endl;
+                        entry[flutter::EncodableValue("error")] = flutter::EncodableValue(item.error);
+                    }
+                    if (!streaming) {
+                        response.emplace_back(std::move(entry));
+                        return;
+                    }
+                    // Sự kiện được xếp trước kết quả method nên Dart nhận đủ trước khi lô kết thúc.
+                    // Plugin tạo không qua registrar (đường dart:ffi) không có sink.
+                    if (!runner) return;
+                    entry[flutter::EncodableValue("streamId")] = flutter::EncodableValue(streamId);
+                    runner->Post([events, event = flutter::EncodableValue(std::move(entry))]() {
+                        if (events->sink) events->sink->Success(event);
+                    });
+                });
+                std::cout << "XML batch: " << count << " documents, " << failed << " failed, total "
+                          << totalTimer.ElapsedUs() << " us" << std::endl;
+
+                if (streaming) {
+                    p_result->Success(flutter::EncodableValue(flutter::EncodableMap{
+                            {flutter::EncodableValue("count"), flutter::EncodableValue(static_cast<int>(count))},
+                            {flutter::EncodableValue("failed"), flutter::EncodableValue(static_cast<int>(failed))},
+                    }));
+                } else {
+                    p_result->Success(flutter::EncodableValue(response));
+                }
+                std::cout << "=== XML Batch Signing Completed ===" << std::endl;
+            } catch (const CardSignatureMismatch& e) {
+                std::cerr << e.what() << std::endl;
+                p_result->Error("SIGNATURE_MISMATCH", e.what());
+            } catch (const std::exception& e) {
+                std::string error_msg = std::string("Standard Exception: ") + e.what();
+                std::cerr << error_msg << std::endl;
+                p_result->Error("STD_EXCEPTION", error_msg);
+            } catch (...) {
+                std::string error_msg = "Unknown error occurred during XML batch signing";
+                std::cerr << error_msg << std::endl;
+                p_result->Error("UNKNOWN_ERROR", error_msg);
+            }
+        }, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>(p_result), CardPriority::Background);
+    }
+
+    // signFile: chữ ký CMS/CAdES tách rời (.p7s) cho một file bất kỳ. File
+    // được băm ở native theo từng khối, song song với SELECT/đọc certificate.
+    void NfcsignerPlugin::HandleSignFile(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        auto p_result = result.release();
+        CardOperation([this, args, p_result](SCARDHANDLE hCard) {
+            try {
+                std::cout << "=== Starting File Signing Process ===" << std::endl;
+                if (!args) {
+                    throw std::runtime_error("Arguments are null");
+                }
+                auto filePath = std::get<std::string>(args->at(flutter::EncodableValue("filePath")));
+                auto appletID = std::get<std::string>(args->at(flutter::EncodableValue("appletID")));
+                auto pin = std::get<std::string>(args->at(flutter::EncodableValue("pin")));
+                auto keyIndex = std::get<int>(args->at(flutter::EncodableValue("keyIndex")));
 
-                    std::vector<uint8_t> signature_raw(sign_resp.begin(), sign_resp.end() - 2);
+                // 1. Nhánh file: băm SHA-256, không cần thẻ. Hủy request hoặc
+                // nhánh thẻ lỗi thì dừng băm ở khối kế tiếp, không chờ đọc hết file.
+                PhaseTimer totalTimer;
+                CancellationToken hashCancellation;
+                CancelCallbackGuard forwardCancel(CurrentCancellation(), [&hashCancellation]() { hashCancellation.Cancel(); });
+                auto digestFuture = std::async(std::launch::async, [&filePath, &hashCancellation]() {
+                    PhaseTimer hashTimer;
+                    auto digest = Sha256File(filePath, &hashCancellation);
+                    std::cout << "File hashed: " << hashTimer.ElapsedUs() << " us" << std::endl;
+                    return digest;
+                });
+                // Chạy trước hàm hủy của digestFuture khi rời hàm.
+                struct StopHashing {
+                    CancellationToken& token;
+                    ~StopHashing() { token.Cancel(); }
+                } stopHashing{ hashCancellation };
+
+                // 2. Nhánh thẻ: SELECT và đọc Certificate (không cần PIN)
+                std::cout << "Selecting applet..." << std::endl;
+                auto select_resp = TransmitAndGetResponse(hCard, CreateSelectAppletCommand(appletID));
+                if (select_resp.size() < 2 || select_resp[select_resp.size() - 2] != 0x90) throw std::runtime_error("Select Applet failed.");
 
-                    std::cout << "Real run: PoDoFo provided a buffer of size " << signedHash.size() << " bytes." << std::endl;
-                    // Kiểm tra an toàn: đảm bảo bộ đệm PoDoFo cấp phát đủ lớn.
-                    if (signedHash.size() < signature_raw.size()) {
-                        throw std::runtime_error("PoDoFo allocated a buffer that is too small for the actual signature.");
-                    }
+                std::cout << "Selecting certificate..." << std::endl;
+                auto select_cert_resp = TransmitAndGetResponse(hCard, CreateSelectCertificateCommand());
+                if (select_cert_resp.size() < 2 || select_cert_resp[select_cert_resp.size() - 2] != 0x90) throw std::runtime_error("Select Certificate data object failed.");
+
+                auto cert_resp = TransmitAndGetResponse(hCard, CreateGetCertificateCommand());
+                if (cert_resp.size() < 2 || cert_resp[cert_resp.size() - 2] != 0x90) throw std::runtime_error("Get Certificate failed.");
+                std::vector<uint8_t> certificate_data(cert_resp.begin(), cert_resp.end() - 2);
+                if (certificate_data.empty()) throw std::runtime_error("Certificate from card is empty.");
+                auto cmsTemplate = CmsTemplateCache::Instance().GetOrCreate(certificate_data);
+
+                // File không đọc được thì dừng trước VERIFY để không tốn một lần thử PIN.
+                std::vector<uint8_t> digest;
+                try {
+                    digest = digestFuture.get();
+                } catch (const OperationCancelled&) {
+                    throw;
+                } catch (const std::exception& e) {
+                    std::string error_msg = std::string("File không hợp lệ: ") + e.what();
+                    std::cerr << error_msg << std::endl;
+                    p_result->Error("INVALID_PARAMETERS", error_msg);
+                    return;
+                }
+
+                std::cout << "Verifying PIN..." << std::endl;
+                auto verify_resp = TransmitAndGetResponse(hCard, CreateVerifyPinCommand(pin));
+                if (verify_resp.size() < 2 || verify_resp[verify_resp.size() - 2] != 0x90) throw std::runtime_error("Verify PIN failed.");
 
-                    std::cout << "Real run: Copying " << signature_raw.size() << " signature bytes into the buffer." << std::endl;
-                    if (!signature_raw.empty()) {
-                        //signedHash.resize(signature_raw.size());
-                        signedHash.assign(signature_raw.begin(), signature_raw.end());
-                        //memcpy(signedHash.data(), signature_raw.data(), signature_raw.size());
+                // 3. SignedData tách rời dựng từ template của certificate;
+                // BuildSignedData tự kiểm tra chữ ký thẻ khi setSignatureSelfCheck bật.
+                CardSignFunction cardSign = [&](const std::vector<uint8_t>& digestInfo) {
+                    std::cout << "Getting signature from card..." << std::endl;
+                    auto sign_resp = TransmitAndGetResponse(hCard, CreateComputeSignatureCommand(digestInfo, keyIndex));
+                    if (sign_resp.size() < 2 || sign_resp[sign_resp.size() - 2] != 0x90) {
+                        throw std::runtime_error("Compute signature failed on card inside callback.");
                     }
-                    std::cout << "<-- Exiting SigningService (Real run complete)." << std::endl;
+                    return std::vector<uint8_t>(sign_resp.begin(), sign_resp.end() - 2);
                 };
-                // Tạo đối tượng signer
-                PoDoFo::PdfSignerCms signer(
-                        PoDoFo::bufferview(reinterpret_cast<const char*>(certificate_data.data()), certificate_data.size()),
-                        params
-                );
-
-                std::cout << "=== Tạo đối tượng signer Successfully ===" << std::endl;
-                // 5. Thực hiện ký - SỬ DỤNG PoDoFo::VectorStreamDevice có sẵn
-                std::cout << "=== 5. Thực hiện ký - SỬ DỤNG PoDoFo::VectorStreamDevice có sẵn ===" << std::endl;
-                std::vector<char> buffer(pdfBytes.begin(), pdfBytes.end());
-                PoDoFo::VectorStreamDevice outputDevice(buffer);
-                PoDoFo::SignDocument(document, outputDevice, signer, signatureField);
-                std::cout << "=== 5. Thực hiện ký - SỬ DỤNG PoDoFo::VectorStreamDevice có sẵn END ===" << std::endl;
-
-                // 6. Lấy kết quả và trả về cho Flutter
-                std::vector<uint8_t> signed_pdf_bytes(buffer.data(), buffer.data() + buffer.size());
-                p_result->Success(flutter::EncodableValue(signed_pdf_bytes));
-                std::cout << "=== PDF Signing Completed Successfully ===" << std::endl;
-            } catch (const PoDoFo::PdfError& e) {
-                std::string error_msg = std::string("PoDoFo Error: ") + e.what();
-                std::cerr << error_msg << std::endl;
-                p_result->Error("PODOFO_ERROR", error_msg);
+                auto signedData = cmsTemplate->BuildSignedData(digest.data(), std::time(nullptr), cardSign);
+                std::cout << "CMS: " << signedData.size() << " bytes, total " << totalTimer.ElapsedUs() << " us" << std::endl;
+
+                p_result->Success(flutter::EncodableValue(signedData));
+                std::cout << "=== File Signing Completed Successfully ===" << std::endl;
+            } catch (const CardSignatureMismatch& e) {
+                std::cerr << e.what() << std::endl;
+                p_result->Error("SIGNATURE_MISMATCH", e.what());
             } catch (const std::exception& e) {
                 std::string error_msg = std::string("Standard Exception: ") + e.what();
                 std::cerr << error_msg << std::endl;
                 p_result->Error("STD_EXCEPTION", error_msg);
             } catch (...) {
-                std::string error_msg = "Unknown error occurred during PDF signing";
+                std::string error_msg = "Unknown error occurred during file signing";
                 std::cerr << error_msg << std::endl;
                 p_result->Error("UNKNOWN_ERROR", error_msg);
             }
-        }, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>(p_result));
+        }, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>(p_result), CardPriority::Bulk);
+    }
+
+    // hashFiles: SHA-256 của nhiều file/thư mục, băm song song trên các lõi CPU (không cần thẻ).
+    void NfcsignerPlugin::HandleHashFiles(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        try {
+            if (!args) {
+                throw std::runtime_error("Arguments are null");
+            }
+            const auto& pathList = std::get<flutter::EncodableList>(args->at(flutter::EncodableValue("paths")));
+            bool recursive = true;
+            auto recursive_iter = args->find(flutter::EncodableValue("recursive"));
+            if (recursive_iter != args->end()) {
+                if (const auto* flag = std::get_if<bool>(&recursive_iter->second)) recursive = *flag;
+            }
+
+            std::vector<std::string> paths;
+            paths.reserve(pathList.size());
+            for (const auto& item : pathList) paths.push_back(std::get<std::string>(item));
+
+            PhaseTimer hashTimer;
+            auto digests = Sha256Files(ExpandFilePaths(paths, recursive));
+            std::cout << "Hashed " << digests.size() << " files: " << hashTimer.ElapsedUs() << " us" << std::endl;
+
+            flutter::EncodableList response;
+            response.reserve(digests.size());
+            for (auto& item : digests) {
+                flutter::EncodableMap entry = {
+                        {flutter::EncodableValue("path"), flutter::EncodableValue(item.path)},
+                };
+                if (item.error.empty()) {
+                    entry[flutter::EncodableValue("digest")] = flutter::EncodableValue(std::move(item.digest));
+                } else {
+                    entry[flutter::EncodableValue("error")] = flutter::EncodableValue(item.error);
+                }
+                response.emplace_back(std::move(entry));
+            }
+            result->Success(flutter::EncodableValue(response));
+        } catch (const std::exception& e) {
+            std::string error_msg = std::string("Standard Exception: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("STD_EXCEPTION", error_msg);
+        }
+    }
+
+    // SignatureVerification sang map cho Flutter.
+    flutter::EncodableMap EncodeSignatureVerification(const SignatureVerification& verification) {
+        flutter::EncodableMap entry = {
+                {flutter::EncodableValue("valid"), flutter::EncodableValue(verification.valid)},
+                {flutter::EncodableValue("digestValid"), flutter::EncodableValue(verification.digestValid)},
+                {flutter::EncodableValue("signatureValid"), flutter::EncodableValue(verification.signatureValid)},
+                {flutter::EncodableValue("coversWholeDocument"), flutter::EncodableValue(verification.coversWholeDocument)},
+                {flutter::EncodableValue("digestAlgorithm"), flutter::EncodableValue(verification.digestAlgorithm)},
+                {flutter::EncodableValue("signer"), flutter::EncodableValue(verification.signer)},
+                {flutter::EncodableValue("certificate"), flutter::EncodableValue(verification.certificate)},
+                {flutter::EncodableValue("signingTime"), flutter::EncodableValue(static_cast<int64_t>(verification.signingTime))},
+                {flutter::EncodableValue("hashUs"), flutter::EncodableValue(verification.hashUs)},
+                {flutter::EncodableValue("verifyUs"), flutter::EncodableValue(verification.verifyUs)},
+        };
+        if (!verification.fieldName.empty()) entry[flutter::EncodableValue("fieldName")] = flutter::EncodableValue(verification.fieldName);
+        if (!verification.subFilter.empty()) entry[flutter::EncodableValue("subFilter")] = flutter::EncodableValue(verification.subFilter);
+        if (!verification.pdfSigningTime.empty()) entry[flutter::EncodableValue("pdfSigningTime")] = flutter::EncodableValue(verification.pdfSigningTime);
+        if (!verification.error.empty()) entry[flutter::EncodableValue("error")] = flutter::EncodableValue(verification.error);
+        return entry;
+    }
+
+    // verifyPdf: kiểm tra mọi chữ ký của một hoặc nhiều PDF (không cần thẻ).
+    // "pdfBytes" trả về danh sách chữ ký; "pdfList" trả về danh sách theo tài liệu.
+    void NfcsignerPlugin::HandleVerifyPdf(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        try {
+            if (!args) {
+                throw std::runtime_error("Arguments are null");
+            }
+            PhaseTimer verifyTimer;
+            auto list_iter = args->find(flutter::EncodableValue("pdfList"));
+            if (list_iter != args->end() && !list_iter->second.IsNull()) {
+                const auto& pdfList = std::get<flutter::EncodableList>(list_iter->second);
+                std::vector<std::vector<uint8_t>> pdfs;
+                pdfs.reserve(pdfList.size());
+                for (const auto& item : pdfList) pdfs.push_back(std::get<std::vector<uint8_t>>(item));
+
+                auto verifications = VerifyPdfBatch(pdfs);
+                std::cout << "Verified " << pdfs.size() << " PDFs: " << verifyTimer.ElapsedUs() << " us" << std::endl;
+
+                flutter::EncodableList response;
+                response.reserve(verifications.size());
+                for (const auto& document : verifications) {
+                    flutter::EncodableList signatures;
+                    for (const auto& verification : document.signatures) signatures.emplace_back(EncodeSignatureVerification(verification));
+                    flutter::EncodableMap entry = {
+                            {flutter::EncodableValue("signatures"), flutter::EncodableValue(signatures)},
+                            {flutter::EncodableValue("parseUs"), flutter::EncodableValue(document.parseUs)},
+                    };
+                    if (!document.error.empty()) entry[flutter::EncodableValue("error")] = flutter::EncodableValue(document.error);
+                    response.emplace_back(std::move(entry));
+                }
+                result->Success(flutter::EncodableValue(response));
+                return;
+            }
+
+            const auto& pdfBytes = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("pdfBytes")));
+            auto verifications = VerifyPdf(pdfBytes);
+            std::cout << "Verified " << verifications.size() << " signatures: " << verifyTimer.ElapsedUs() << " us" << std::endl;
+
+            flutter::EncodableList response;
+            response.reserve(verifications.size());
+            for (const auto& verification : verifications) response.emplace_back(EncodeSignatureVerification(verification));
+            result->Success(flutter::EncodableValue(response));
+        } catch (const std::exception& e) {
+            std::string error_msg = std::string("Standard Exception: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("STD_EXCEPTION", error_msg);
+        }
+    }
+
+    // verifyCms: SignedData tách rời trên "content" hoặc file "filePath"; không
+    // có cả hai thì dùng nội dung nhúng trong chữ ký.
+    void NfcsignerPlugin::HandleVerifyCms(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        try {
+            if (!args) {
+                throw std::runtime_error("Arguments are null");
+            }
+            const auto& cms = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("cms")));
+
+            SignatureVerification verification;
+            auto content_iter = args->find(flutter::EncodableValue("content"));
+            auto path_iter = args->find(flutter::EncodableValue("filePath"));
+            if (content_iter != args->end() && !content_iter->second.IsNull()) {
+                const auto& content = std::get<std::vector<uint8_t>>(content_iter->second);
+                verification = VerifyCms(cms, content.data(), content.size());
+            } else if (path_iter != args->end() && !path_iter->second.IsNull()) {
+                verification = VerifyCmsFile(cms, std::get<std::string>(path_iter->second));
+            } else {
+                verification = VerifyCms(cms, nullptr, 0);
+            }
+            result->Success(flutter::EncodableValue(EncodeSignatureVerification(verification)));
+        } catch (const std::exception& e) {
+            std::string error_msg = std::string("Standard Exception: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("STD_EXCEPTION", error_msg);
+        }
+    }
+
+    // verifySignature: chữ ký RSA thô (ví dụ từ generateSignature) theo certificate.
+    void NfcsignerPlugin::HandleVerifySignature(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        try {
+            if (!args) {
+                throw std::runtime_error("Arguments are null");
+            }
+            const auto& certificate = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("certificate")));
+            const auto& data = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("data")));
+            const auto& signature = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("signature")));
+            std::string digestAlgorithm;
+            auto algorithm_iter = args->find(flutter::EncodableValue("digestAlgorithm"));
+            if (algorithm_iter != args->end()) {
+                if (const auto* name = std::get_if<std::string>(&algorithm_iter->second)) digestAlgorithm = *name;
+            }
+
+            bool valid = VerifySignature(certificate, data, signature, digestAlgorithm);
+            result->Success(flutter::EncodableValue(valid));
+        } catch (const std::exception& e) {
+            std::string error_msg = std::string("Standard Exception: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("STD_EXCEPTION", error_msg);
+        }
+    }
+
+    // Bật/tắt tự kiểm tra chữ ký thẻ cho cả tiến trình (không cần thẻ).
+    void NfcsignerPlugin::HandleSetSignatureSelfCheck(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        try {
+            if (!args) {
+                throw std::runtime_error("Arguments are null");
+            }
+            bool enabled = std::get<bool>(args->at(flutter::EncodableValue("enabled")));
+            SetCardSignatureSelfCheck(enabled);
+            std::cout << "Card signature self-check: " << (enabled ? "on" : "off") << std::endl;
+            result->Success(flutter::EncodableValue(enabled));
+        } catch (const std::exception& e) {
+            std::string error_msg = std::string("Standard Exception: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("STD_EXCEPTION", error_msg);
+        }
+    }
+
+    flutter::EncodableMap WarmUpReportToMap(const WarmUpReport& report) {
+        flutter::EncodableList errors;
+        for (const auto& error : report.errors) errors.push_back(flutter::EncodableValue(error));
+        return flutter::EncodableMap{
+                {flutter::EncodableValue("pcscUs"), flutter::EncodableValue(report.pcscUs)},
+                {flutter::EncodableValue("cryptoUs"), flutter::EncodableValue(report.cryptoUs)},
+                {flutter::EncodableValue("fontsUs"), flutter::EncodableValue(report.fontsUs)},
+                {flutter::EncodableValue("imageUs"), flutter::EncodableValue(report.imageUs)},
+                {flutter::EncodableValue("certificateUs"), flutter::EncodableValue(report.certificateUs)},
+                {flutter::EncodableValue("appearanceUs"), flutter::EncodableValue(report.appearanceUs)},
+                {flutter::EncodableValue("totalUs"), flutter::EncodableValue(report.totalUs)},
+                {flutter::EncodableValue("cardConnected"), flutter::EncodableValue(report.cardConnected)},
+                {flutter::EncodableValue("certificateCached"), flutter::EncodableValue(report.certificateCached)},
+                {flutter::EncodableValue("appearanceCached"), flutter::EncodableValue(report.appearanceCached)},
+                {flutter::EncodableValue("errors"), flutter::EncodableValue(errors)},
+        };
+    }
+
+    // Chạy WarmUp trên worker riêng của plugin; false nếu một lần khác chưa xong.
+    bool NfcsignerPlugin::StartWarmUp(const WarmUpOptions& options) {
+        std::lock_guard<std::mutex> lock(warm_up_mutex_);
+        if (warm_up_running_) return false;
+        if (!warm_up_worker_) warm_up_worker_ = std::make_unique<WorkerPool>(1, 1);
+        warm_up_running_ = warm_up_worker_->Submit([this, options]() {
+            flutter::EncodableMap report;
+            try {
+                report = WarmUpReportToMap(WarmUp(options));
+            } catch (const std::exception& e) {
+                std::cerr << "Warm-up failed: " << e.what() << std::endl;
+            }
+            std::lock_guard<std::mutex> lock(warm_up_mutex_);
+            if (!report.empty()) last_warm_up_ = std::move(report);
+            warm_up_running_ = false;
+        });
+        return warm_up_running_;
+    }
+
+    // Khởi tạo trước PC/SC, OpenSSL, font, bộ giải mã ảnh; với appletID và
+    // signatureConfig thì đọc sẵn certificate và render sẵn appearance. Trả
+    // về ngay: started (false nếu lần trước chưa xong) và last, báo cáo của
+    // lần đã xong gần nhất.
+    void NfcsignerPlugin::HandleWarmUp(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        try {
+            WarmUpOptions options;
+            if (args) {
+                auto applet_it = args->find(flutter::EncodableValue("appletID"));
+                if (applet_it != args->end() && !applet_it->second.IsNull()) {
+                    options.appletID = std::get<std::string>(applet_it->second);
+                }
+                auto config_it = args->find(flutter::EncodableValue("signatureConfig"));
+                if (config_it != args->end()) {
+                    if (const auto* signatureConfig = std::get_if<flutter::EncodableMap>(&config_it->second)) {
+                        auto appearance = std::make_shared<SignatureAppearanceConfig>();
+                        int pageNumber = 1;
+                        std::string signDate;
+                        ParseSignatureConfig(*signatureConfig, *appearance, pageNumber, signDate);
+                        options.appearance = appearance;
+                    }
+                }
+            }
+
+            flutter::EncodableMap response;
+            response[flutter::EncodableValue("started")] = flutter::EncodableValue(StartWarmUp(options));
+            {
+                std::lock_guard<std::mutex> lock(warm_up_mutex_);
+                if (!last_warm_up_.empty()) {
+                    response[flutter::EncodableValue("last")] = flutter::EncodableValue(last_warm_up_);
+                }
+            }
+            result->Success(flutter::EncodableValue(response));
+        } catch (const std::exception& e) {
+            std::string error_msg = std::string("Standard Exception: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("STD_EXCEPTION", error_msg);
+        }
+    }
+
+    // Chính sách tự kết nối lại khi thẻ bị reset/rút ra hoặc reader lỗi tạm thời
+    // (không cần thẻ). Field thiếu giữ nguyên giá trị hiện tại.
+    void NfcsignerPlugin::HandleSetCardRecoveryPolicy(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        try {
+            if (!args) {
+                throw std::runtime_error("Arguments are null");
+            }
+            CardRecoveryPolicy policy = GetCardRecoveryPolicy();
+            auto attempts_it = args->find(flutter::EncodableValue("maxAttempts"));
+            if (attempts_it != args->end() && !attempts_it->second.IsNull()) {
+                int maxAttempts = std::get<int>(attempts_it->second);
+                if (maxAttempts < 0) throw std::runtime_error("maxAttempts must not be negative");
+                policy.maxAttempts = maxAttempts;
+            }
+            auto replay_it = args->find(flutter::EncodableValue("allowPinReplay"));
+            if (replay_it != args->end() && !replay_it->second.IsNull()) {
+                policy.allowPinReplay = std::get<bool>(replay_it->second);
+            }
+            SetCardRecoveryPolicy(policy);
+            std::cout << "Card recovery: " << policy.maxAttempts << " attempt(s), PIN replay "
+                      << (policy.allowPinReplay ? "on" : "off") << std::endl;
+            result->Success(flutter::EncodableValue(true));
+        } catch (const std::exception& e) {
+            std::string error_msg = std::string("Standard Exception: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("STD_EXCEPTION", error_msg);
+        }
+    }
+
+    // Bật/tắt theo dõi bộ nhớ từng pha của signPdf (không cần thẻ). Số liệu
+    // đọc qua getSigningMetrics.
+    void NfcsignerPlugin::HandleSetMemoryTracking(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        try {
+            if (!args) {
+                throw std::runtime_error("Arguments are null");
+            }
+            bool enabled = std::get<bool>(args->at(flutter::EncodableValue("enabled")));
+            SetMemoryTrackingEnabled(enabled);
+            std::cout << "Memory tracking " << (enabled ? "on" : "off")
+                      << (HasAllocationHooks() ? "" : " (RSS only, allocation hooks not built)") << std::endl;
+            result->Success(flutter::EncodableValue(flutter::EncodableMap{
+                    {flutter::EncodableValue("enabled"), flutter::EncodableValue(enabled)},
+                    {flutter::EncodableValue("allocationHooks"), flutter::EncodableValue(HasAllocationHooks())},
+            }));
+        } catch (const std::exception& e) {
+            std::string error_msg = std::string("Standard Exception: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("STD_EXCEPTION", error_msg);
+        }
+    }
+
+    // Mở phiên ký PDF: đọc cấu hình, kết nối thẻ, đọc certificate và VERIFY PIN
+    // một lần. Trả về handle cho signPdfWithSession/closeSigningSession.
+    void NfcsignerPlugin::HandleOpenSigningSession(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        try {
+            if (!args) {
+                throw std::runtime_error("Arguments are null");
+            }
+            // 1. Đọc cấu hình một lần cho cả phiên
+            auto session = std::make_shared<SigningSession>();
+            try {
+                auto appletID = std::get<std::string>(args->at(flutter::EncodableValue("appletID")));
+                session->selectAppletCommand = CreateSelectAppletCommand(appletID);
+                session->pin = std::get<std::string>(args->at(flutter::EncodableValue("pin")));
+                session->keyIndex = std::get<int>(args->at(flutter::EncodableValue("keyIndex")));
+                session->reason = std::get<std::string>(args->at(flutter::EncodableValue("reason")));
+                session->location = std::get<std::string>(args->at(flutter::EncodableValue("location")));
+                auto config_iter = args->find(flutter::EncodableValue("signatureConfig"));
+                if (config_iter != args->end()) {
+                    if (const auto* signatureConfig = std::get_if<flutter::EncodableMap>(&config_iter->second)) {
+                        ParseSignatureConfig(*signatureConfig, session->appearance, session->pageNumber, session->signDate);
+                    }
+                }
+            } catch (const std::exception& e) {
+                std::string error_msg = std::string("Tham số phiên ký không hợp lệ: ") + e.what();
+                std::cerr << error_msg << std::endl;
+                result->Error("INVALID_PARAMETERS", error_msg);
+                return;
+            }
+
+            // 2. Appearance dựng song song với phần thẻ
+            auto appearanceFuture = std::async(std::launch::async, [&session]() {
+                return SignatureAppearanceCache::Instance().GetOrCreate(session->appearance);
+            });
+
+            // 3. Kết nối thẻ, đọc certificate rồi VERIFY PIN; kết nối được giữ lại
+            CardScheduler::Ticket ticket = CardScheduler::Instance().Acquire(CardPriority::Interactive);
+            if (!ticket) {
+                result->Error("CARD_BUSY", CardBusyError(CardPriority::Interactive).what());
+                return;
+            }
+            ConnectSession(*session);
+            // SELECT, đọc certificate và VERIFY không bị tiến trình khác chen vào.
+            CardTransaction transaction(session->hCard);
+            session->certificate = ReadSessionCertificate(*session);
+            session->cmsTemplate = CmsTemplateCache::Instance().GetOrCreate(session->certificate);
+
+            auto verify_resp = TransmitAndGetResponse(session->hCard, CreateVerifyPinCommand(session->pin));
+            if (verify_resp.size() < 2 || verify_resp[verify_resp.size() - 2] != 0x90) throw std::runtime_error("Verify PIN failed.");
+
+            transaction.End(SCARD_LEAVE_CARD);
+
+            session->appearanceTemplate = appearanceFuture.get();
+            int64_t handle = SigningSessionRegistry::Instance().Add(session);
+            std::cout << "Signing session " << handle << " opened." << std::endl;
+            result->Success(flutter::EncodableValue(handle));
+        } catch (const std::exception& e) {
+            std::string error_msg = std::string("Standard Exception: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("STD_EXCEPTION", error_msg);
+        }
+    }
+
+    // Ký một PDF bằng phiên đã mở: chỉ cần handle và tài liệu.
+    void NfcsignerPlugin::HandleSignPdfWithSession(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        try {
+            if (!args) {
+                throw std::runtime_error("Arguments are null");
+            }
+            int64_t handle = args->at(flutter::EncodableValue("session")).LongValue();
+            auto session = SigningSessionRegistry::Instance().Get(handle);
+            if (!session) {
+                result->Error("INVALID_PARAMETERS", "Phiên ký không tồn tại hoặc đã đóng.");
+                return;
+            }
+            MemoryTracker memoryTracker("signPdfWithSession");
+            const auto& pdfBytes = std::get<std::vector<uint8_t>>(args->at(flutter::EncodableValue("pdfBytes")));
+            std::string signDate = session->signDate;
+            auto signDate_iter = args->find(flutter::EncodableValue("signDate"));
+            if (signDate_iter != args->end() && !signDate_iter->second.IsNull()) {
+                signDate = std::get<std::string>(signDate_iter->second);
+            }
+
+            // 1. Chuẩn bị tài liệu bằng appearance của phiên (không giữ thẻ)
+            RequestArena arena;
+            RequestArena::Scope arenaScope(&arena);
+            SignPdfMetrics metrics;
+            PhaseTimer totalTimer;
+            std::promise<void> parsed;
+            PreparedPdf prepared;
+            try {
+                prepared = PreparePdf(pdfBytes, session->pageNumber, session->appearance, signDate,
+                                      session->reason, session->location, parsed, metrics, session->appearanceTemplate);
+            } catch (const std::exception& e) {
+                std::string error_msg = std::string("PDF không hợp lệ: ") + e.what();
+                std::cerr << error_msg << std::endl;
+                result->Error("INVALID_PARAMETERS", error_msg);
+                return;
+            }
+            metrics.parallelUs = totalTimer.ElapsedUs();
+
+            // 2. Ký trên kết nối của phiên. Thẻ báo PIN mất hiệu lực (6982) hoặc
+            // đã bị reset thì kết nối lại, kiểm tra certificate, xác thực lại một lần.
+            PhaseTimer signTimer;
+            CardScheduler::Ticket ticket = CardScheduler::Instance().Acquire(CardPriority::Bulk);
+            if (!ticket) {
+                result->Error("CARD_BUSY", CardBusyError(CardPriority::Bulk).what());
+                return;
+            }
+            std::lock_guard<std::mutex> cardLock(session->cardMutex);
+            CardSignFunction cardSign = [&](const std::vector<uint8_t>& digestInfo) {
+                return SignWithSession(*session, digestInfo);
+            };
+
+            LazyPdfSignParams params;
+            params.pageNumber = session->pageNumber > 0 ? session->pageNumber : 1;
+            params.x = session->appearance.x;
+            params.y = session->appearance.y;
+            params.width = session->appearance.width;
+            params.height = session->appearance.height;
+            params.reason = session->reason;
+            params.location = session->location;
+            params.signerName = session->appearance.signerName;
+            params.signingTime = std::time(nullptr);
+            MemoryPhase signPhase("sign");
+            auto signed_pdf_bytes = SignPreparedPdf(prepared, pdfBytes, params, signDate, session->appearance,
+                                                    session->cmsTemplate, cardSign);
+            metrics.signUs = signTimer.ElapsedUs();
+            metrics.totalUs = totalTimer.ElapsedUs();
+            metrics.incremental = prepared.lazyDocument != nullptr;
+            SigningMetrics::Instance().Record(metrics);
+            std::cout << "Timing (us): session " << handle << ", pdf parse " << metrics.pdfParseUs
+                      << ", pdf prepare " << metrics.pdfPrepareUs << ", sign " << metrics.signUs
+                      << ", total " << metrics.totalUs << std::endl;
+
+            MemoryPhase outputPhase("output");
+            result->Success(flutter::EncodableValue(std::move(signed_pdf_bytes)));
+        } catch (const PoDoFo::PdfError& e) {
+            std::string error_msg = std::string("PoDoFo Error: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("PODOFO_ERROR", error_msg);
+        } catch (const CardSignatureMismatch& e) {
+            std::cerr << e.what() << std::endl;
+            result->Error("SIGNATURE_MISMATCH", e.what());
+        } catch (const std::exception& e) {
+            std::string error_msg = std::string("Standard Exception: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("STD_EXCEPTION", error_msg);
+        }
+    }
+
+    // Đóng phiên: ngắt kết nối (reset thẻ) và xóa PIN khỏi bộ nhớ.
+    void NfcsignerPlugin::HandleCloseSigningSession(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        try {
+            if (!args) {
+                throw std::runtime_error("Arguments are null");
+            }
+            int64_t handle = args->at(flutter::EncodableValue("session")).LongValue();
+            bool closed = SigningSessionRegistry::Instance().Remove(handle);
+            if (closed) std::cout << "Signing session " << handle << " closed." << std::endl;
+            result->Success(flutter::EncodableValue(closed));
+        } catch (const std::exception& e) {
+            std::string error_msg = std::string("Standard Exception: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("STD_EXCEPTION", error_msg);
+        }
+    }
+
+    // Độ sâu hàng đợi và thời gian chờ reader theo lớp ưu tiên, cùng thời gian
+    // chờ/giữ thẻ trong transaction PC/SC (không cần thẻ).
+    void NfcsignerPlugin::HandleGetCardQueueMetrics(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        auto queues = CardScheduler::Instance().GetMetrics();
+        flutter::EncodableMap metrics;
+        for (size_t i = 0; i < queues.size(); ++i) {
+            const CardQueueMetrics& queue = queues[i];
+            metrics[flutter::EncodableValue(CardPriorityName(static_cast<CardPriority>(i)))] = flutter::EncodableValue(flutter::EncodableMap{
+                    {flutter::EncodableValue("capacity"), flutter::EncodableValue(static_cast<int64_t>(queue.capacity))},
+                    {flutter::EncodableValue("depth"), flutter::EncodableValue(static_cast<int64_t>(queue.depth))},
+                    {flutter::EncodableValue("maxDepth"), flutter::EncodableValue(static_cast<int64_t>(queue.maxDepth))},
+                    {flutter::EncodableValue("granted"), flutter::EncodableValue(static_cast<int64_t>(queue.granted))},
+                    {flutter::EncodableValue("rejected"), flutter::EncodableValue(static_cast<int64_t>(queue.rejected))},
+                    {flutter::EncodableValue("lastWaitUs"), flutter::EncodableValue(queue.lastWaitUs)},
+                    {flutter::EncodableValue("maxWaitUs"), flutter::EncodableValue(queue.maxWaitUs)},
+                    {flutter::EncodableValue("totalWaitUs"), flutter::EncodableValue(queue.totalWaitUs)},
+            });
+        }
+        // Tranh chấp thẻ với tiến trình khác (SCardBeginTransaction).
+        CardTransactionMetrics transactions = GetCardTransactionMetrics();
+        metrics[flutter::EncodableValue("transactions")] = flutter::EncodableValue(flutter::EncodableMap{
+                {flutter::EncodableValue("count"), flutter::EncodableValue(static_cast<int64_t>(transactions.transactions))},
+                {flutter::EncodableValue("contended"), flutter::EncodableValue(static_cast<int64_t>(transactions.contended))},
+                {flutter::EncodableValue("resets"), flutter::EncodableValue(static_cast<int64_t>(transactions.resets))},
+                {flutter::EncodableValue("lastWaitUs"), flutter::EncodableValue(transactions.lastWaitUs)},
+                {flutter::EncodableValue("maxWaitUs"), flutter::EncodableValue(transactions.maxWaitUs)},
+                {flutter::EncodableValue("totalWaitUs"), flutter::EncodableValue(transactions.totalWaitUs)},
+                {flutter::EncodableValue("lastHoldUs"), flutter::EncodableValue(transactions.lastHoldUs)},
+                {flutter::EncodableValue("maxHoldUs"), flutter::EncodableValue(transactions.maxHoldUs)},
+                {flutter::EncodableValue("totalHoldUs"), flutter::EncodableValue(transactions.totalHoldUs)},
+        });
+        // Phục hồi sau reset thẻ / lỗi reader tạm thời.
+        CardRecoveryMetrics recovery = GetCardRecoveryMetrics();
+        metrics[flutter::EncodableValue("recovery")] = flutter::EncodableValue(flutter::EncodableMap{
+                {flutter::EncodableValue("errors"), flutter::EncodableValue(static_cast<int64_t>(recovery.errors))},
+                {flutter::EncodableValue("recovered"), flutter::EncodableValue(static_cast<int64_t>(recovery.recovered))},
+                {flutter::EncodableValue("failed"), flutter::EncodableValue(static_cast<int64_t>(recovery.failed))},
+                {flutter::EncodableValue("lastRecoveryUs"), flutter::EncodableValue(recovery.lastRecoveryUs)},
+                {flutter::EncodableValue("maxRecoveryUs"), flutter::EncodableValue(recovery.maxRecoveryUs)},
+                {flutter::EncodableValue("totalRecoveryUs"), flutter::EncodableValue(recovery.totalRecoveryUs)},
+        });
+        result->Success(flutter::EncodableValue(metrics));
+    }
+
+    // Hủy request đang chạy theo requestId (không cần thẻ). Trả về false nếu
+    // request đã xong hoặc không tồn tại.
+    void NfcsignerPlugin::HandleCancel(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        try {
+            if (!args) {
+                throw std::runtime_error("Arguments are null");
+            }
+            std::string requestId = std::get<std::string>(args->at(flutter::EncodableValue("requestId")));
+            bool cancelled = CancellationRegistry::Instance().Cancel(requestId);
+            if (cancelled) std::cout << "Request " << requestId << " cancelled." << std::endl;
+            result->Success(flutter::EncodableValue(cancelled));
+        } catch (const std::exception& e) {
+            std::string error_msg = std::string("Standard Exception: ") + e.what();
+            std::cerr << error_msg << std::endl;
+            result->Error("STD_EXCEPTION", error_msg);
+        }
+    }
+
+    flutter::EncodableMap PhaseMemoryToMap(const PhaseMemory& phase) {
+        return flutter::EncodableMap{
+                {flutter::EncodableValue("allocations"), flutter::EncodableValue(static_cast<int64_t>(phase.allocations))},
+                {flutter::EncodableValue("allocatedBytes"), flutter::EncodableValue(static_cast<int64_t>(phase.allocatedBytes))},
+                {flutter::EncodableValue("freedBytes"), flutter::EncodableValue(static_cast<int64_t>(phase.freedBytes))},
+                {flutter::EncodableValue("peakLiveBytes"), flutter::EncodableValue(phase.peakLiveBytes)},
+                {flutter::EncodableValue("rssBeforeBytes"), flutter::EncodableValue(phase.rssBeforeBytes)},
+                {flutter::EncodableValue("rssAfterBytes"), flutter::EncodableValue(phase.rssAfterBytes)},
+        };
+    }
+
+    // Số liệu thời gian của lần signPdf gần nhất (không cần thẻ).
+    void NfcsignerPlugin::HandleGetSigningMetrics(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+        auto& signingMetrics = SigningMetrics::Instance();
+        SignPdfMetrics last = signingMetrics.GetLast();
+        flutter::EncodableMap metrics = {
+                {flutter::EncodableValue("count"), flutter::EncodableValue(static_cast<int64_t>(signingMetrics.GetCount()))},
+                {flutter::EncodableValue("totalOverlapSavedUs"), flutter::EncodableValue(signingMetrics.GetTotalOverlapSavedUs())},
+                {flutter::EncodableValue("cardPreambleUs"), flutter::EncodableValue(last.cardPreambleUs)},
+                {flutter::EncodableValue("verifyPinUs"), flutter::EncodableValue(last.verifyPinUs)},
+                {flutter::EncodableValue("pdfParseUs"), flutter::EncodableValue(last.pdfParseUs)},
+                {flutter::EncodableValue("pdfPrepareUs"), flutter::EncodableValue(last.pdfPrepareUs)},
+                {flutter::EncodableValue("joinWaitUs"), flutter::EncodableValue(last.joinWaitUs)},
+                {flutter::EncodableValue("parallelUs"), flutter::EncodableValue(last.parallelUs)},
+                {flutter::EncodableValue("signUs"), flutter::EncodableValue(last.signUs)},
+                {flutter::EncodableValue("totalUs"), flutter::EncodableValue(last.totalUs)},
+                {flutter::EncodableValue("overlapSavedUs"), flutter::EncodableValue(last.OverlapSavedUs())},
+                {flutter::EncodableValue("incremental"), flutter::EncodableValue(last.incremental)},
+        };
+        // Arena cấp phát theo request của đường ký PDF.
+        RequestArenaMetrics arena = GetRequestArenaMetrics();
+        metrics[flutter::EncodableValue("arena")] = flutter::EncodableValue(flutter::EncodableMap{
+                {flutter::EncodableValue("requests"), flutter::EncodableValue(static_cast<int64_t>(arena.requests))},
+                {flutter::EncodableValue("lastAllocations"), flutter::EncodableValue(static_cast<int64_t>(arena.lastAllocations))},
+                {flutter::EncodableValue("maxAllocations"), flutter::EncodableValue(static_cast<int64_t>(arena.maxAllocations))},
+                {flutter::EncodableValue("lastPeakBytes"), flutter::EncodableValue(static_cast<int64_t>(arena.lastPeakBytes))},
+                {flutter::EncodableValue("maxPeakBytes"), flutter::EncodableValue(static_cast<int64_t>(arena.maxPeakBytes))},
+                {flutter::EncodableValue("blocksAllocated"), flutter::EncodableValue(static_cast<int64_t>(arena.blocksAllocated))},
+                {flutter::EncodableValue("blocksReused"), flutter::EncodableValue(static_cast<int64_t>(arena.blocksReused))},
+                {flutter::EncodableValue("pooledBytes"), flutter::EncodableValue(static_cast<int64_t>(arena.pooledBytes))},
+        });
+        // Bộ nhớ từng pha (setMemoryTracking): request gần nhất và mức cao nhất
+        // của mỗi pha qua mọi request.
+        MemoryMetrics& memoryMetrics = MemoryMetrics::Instance();
+        RequestMemoryReport lastMemory = memoryMetrics.GetLast();
+        flutter::EncodableMap lastPhases;
+        for (const auto& phase : lastMemory.phases) {
+            lastPhases[flutter::EncodableValue(phase.name)] = flutter::EncodableValue(PhaseMemoryToMap(phase));
+        }
+        flutter::EncodableMap maxPhases;
+        for (const auto& entry : memoryMetrics.GetMaxByPhase()) {
+            maxPhases[flutter::EncodableValue(entry.first)] = flutter::EncodableValue(PhaseMemoryToMap(entry.second));
+        }
+        metrics[flutter::EncodableValue("memory")] = flutter::EncodableValue(flutter::EncodableMap{
+                {flutter::EncodableValue("enabled"), flutter::EncodableValue(IsMemoryTrackingEnabled())},
+                {flutter::EncodableValue("allocationHooks"), flutter::EncodableValue(HasAllocationHooks())},
+                {flutter::EncodableValue("requests"), flutter::EncodableValue(static_cast<int64_t>(memoryMetrics.GetCount()))},
+                {flutter::EncodableValue("lastOperation"), flutter::EncodableValue(lastMemory.operation)},
+                {flutter::EncodableValue("lastPeakRssBytes"), flutter::EncodableValue(lastMemory.peakRssBytes)},
+                {flutter::EncodableValue("lastPhases"), flutter::EncodableValue(lastPhases)},
+                {flutter::EncodableValue("maxPhases"), flutter::EncodableValue(maxPhases)},
+                {flutter::EncodableValue("currentRssBytes"), flutter::EncodableValue(GetCurrentRssBytes())},
+                {flutter::EncodableValue("peakRssBytes"), flutter::EncodableValue(GetPeakRssBytes())},
+        });
+        result->Success(flutter::EncodableValue(metrics));
     }
 }  // namespace nfcsigner
@@ -4,36 +4,99 @@
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/encodable_value.h>
-#include <windows.h> // Cần cho SCARDHANDLE
 #include <vector>    // Cần cho std::vector
 #include <memory>
+#include <mutex>
+#include <set>
 
 namespace nfcsigner {
 
+class CancellationToken;
+class WorkerPool;
+class PlatformTaskRunner;
+struct WarmUpOptions;
+struct XmlBatchEventSink;
+
 class NfcsignerPlugin : public flutter::Plugin {
  public:
   static void RegisterWithRegistrar(flutter::PluginRegistrarWindows *registrar);
 
   NfcsignerPlugin();
+  explicit NfcsignerPlugin(flutter::PluginRegistrarWindows *registrar);
 
   virtual ~NfcsignerPlugin();
-    // Thêm các method public để NfcPdfSigner có thể gọi
-    std::vector<uint8_t> TransmitAndGetResponse(SCARDHANDLE hCard, const std::vector<uint8_t>& command);
   // Disallow copy and assign.
   NfcsignerPlugin(const NfcsignerPlugin&) = delete;
   NfcsignerPlugin& operator=(const NfcsignerPlugin&) = delete;
-  private:
-  // Called when a method is called on this plugin's channel from Dart.
+
+  // Called on the platform thread when a method is called on this plugin's
+  // channel from Dart. Card and file work runs on the plugin's workers with a
+  // copy of the arguments; the result is posted back to the platform thread.
   void HandleMethodCall(
       const flutter::MethodCall<flutter::EncodableValue> &method_call,
       std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Accepts a request: registers its cancellation token right away and queues
+  // it on the plugin's bounded workers; [result] completes from the worker
+  // (CARD_BUSY when the queue is full). Used directly by the dart:ffi entry
+  // points (nfcsigner_ffi.h).
+  void SubmitMethodCall(
+      std::shared_ptr<const flutter::MethodCall<flutter::EncodableValue>> call,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  private:
+    // Runs a quick, card-free method on the calling thread.
+    void RunMethodCall(
+        const flutter::MethodCall<flutter::EncodableValue> &method_call,
+        std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+    // Runs the method with the cancellation token registered when it was accepted.
+    void RunAcceptedCall(
+        const flutter::MethodCall<flutter::EncodableValue> &method_call,
+        std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result,
+        std::shared_ptr<CancellationToken> token);
+
+    // Runs warm-up on its own worker so it never occupies a card worker.
+    bool StartWarmUp(const WarmUpOptions& options);
+
     // --- Các hàm helper cho PC/SC ---
     void HandleSign(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
     void HandleGetPublicKey(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
     void HandleGetCertificate(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
     void HandleSignPdf(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleSignPdfMulti(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleGetSigningMetrics(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleGenerateXmlSignature(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleSignXml(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleSignXmlBatch(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleSignFile(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleHashFiles(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleVerifyPdf(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleVerifyCms(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleVerifySignature(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleSetSignatureSelfCheck(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleWarmUp(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleSetCardRecoveryPolicy(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleSetMemoryTracking(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleOpenSigningSession(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleSignPdfWithSession(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleCloseSigningSession(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleGetCardQueueMetrics(std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+    void HandleCancel(const flutter::EncodableMap* args, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+    // Accepted requests that have not finished; cancelled when the plugin is destroyed.
+    std::mutex requests_mutex_;
+    std::set<std::shared_ptr<CancellationToken>> accepted_requests_;
+    std::shared_ptr<PlatformTaskRunner> platform_runner_;
+    std::unique_ptr<WorkerPool> workers_;
+    std::unique_ptr<WorkerPool> file_workers_;
+    // One warm-up at a time; last_warm_up_ is the report of the latest finished run.
+    std::mutex warm_up_mutex_;
+    bool warm_up_running_ = false;
+    flutter::EncodableMap last_warm_up_;
+    std::unique_ptr<WorkerPool> warm_up_worker_;
+    // Sink shared with the stream handler of the "nfcsigner/xml_batch" EventChannel.
+    std::shared_ptr<XmlBatchEventSink> xml_batch_events_;
     };
-    std::vector<uint8_t> CreateComputeSignatureCommand(const std::vector<uint8_t>& data, int keyIndex);
 
 }  // namespace nfcsigner
 